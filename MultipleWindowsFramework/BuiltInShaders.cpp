@@ -0,0 +1,175 @@
+﻿//----------------------------------------------------------------------------------------------------
+// BuiltInShaders.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "BuiltInShaders.hpp"
+
+#include "ShaderRegistry.hpp"
+
+//----------------------------------------------------------------------------------------------------
+static char const* const s_fullscreenTextureVertexSource = R"(
+        struct VS_INPUT {
+            float3 pos : POSITION;
+            float2 tex : TEXCOORD0;
+        };
+
+        struct VS_OUTPUT {
+            float4 pos : SV_POSITION;
+            float2 tex : TEXCOORD0;
+        };
+
+        VS_OUTPUT main(VS_INPUT input) {
+            VS_OUTPUT output;
+            output.pos = float4(input.pos, 1.0f);
+            output.tex = input.tex;
+            return output;
+        }
+    )";
+
+static char const* const s_fullscreenTexturePixelSource = R"(
+        Texture2D tex : register(t0);
+        SamplerState sam : register(s0);
+
+        struct PS_INPUT {
+            float4 pos : SV_POSITION;
+            float2 tex : TEXCOORD0;
+        };
+
+        float4 main(PS_INPUT input) : SV_TARGET {
+            return tex.Sample(sam, input.tex);
+        }
+    )";
+
+//----------------------------------------------------------------------------------------------------
+static char const* const s_spriteVertexSource = R"(
+        cbuffer SpriteConstants : register(b0) {
+            float2 sceneSize;
+            float2 padding;
+        };
+
+        struct VS_INPUT {
+            float2 corner   : POSITION;
+            float2 center   : INSTANCE_POSITION;
+            float2 size     : INSTANCE_SIZE;
+            float4 uvRect   : INSTANCE_UVRECT;
+            float  rotation : INSTANCE_ROTATION;
+            float4 tint     : INSTANCE_COLOR;
+        };
+
+        struct VS_OUTPUT {
+            float4 pos  : SV_POSITION;
+            float2 tex  : TEXCOORD0;
+            float4 tint : COLOR0;
+        };
+
+        VS_OUTPUT main(VS_INPUT input) {
+            float s, c;
+            sincos(input.rotation, s, c);
+
+            float2 local = input.corner * input.size;
+            float2 world = input.center + float2(c * local.x - s * local.y, s * local.x + c * local.y);
+
+            VS_OUTPUT output;
+            output.pos  = float4(world.x / sceneSize.x * 2.0f - 1.0f, 1.0f - world.y / sceneSize.y * 2.0f, 0.0f, 1.0f);
+            output.tex  = lerp(input.uvRect.xy, input.uvRect.zw, input.corner + 0.5f);
+            output.tint = input.tint;
+            return output;
+        }
+    )";
+
+static char const* const s_spritePixelSource = R"(
+        Texture2D tex : register(t0);
+        SamplerState sam : register(s0);
+
+        struct PS_INPUT {
+            float4 pos  : SV_POSITION;
+            float2 tex  : TEXCOORD0;
+            float4 tint : COLOR0;
+        };
+
+        float4 main(PS_INPUT input) : SV_TARGET {
+            return tex.Sample(sam, input.tex) * input.tint;
+        }
+    )";
+
+//----------------------------------------------------------------------------------------------------
+// 以全螢幕四邊形畫在 (場景寬 / 64) x (場景高 / 64) 的目標上，每個像素計算一個 64x64 區塊
+// 結果必須與 ComputeTileChecksum (TileReadback.cpp) 逐位元相同：UNORM8 轉回整數後以相同的方式組合與雜湊
+static char const* const s_tileChecksumPixelSource = R"(
+        Texture2D sceneTexture : register(t0);
+
+        cbuffer TileChecksumConstants : register(b0) {
+            uint2 sceneSize;
+            uint2 padding;
+        };
+
+        struct PS_INPUT {
+            float4 pos : SV_POSITION;
+            float2 tex : TEXCOORD0;
+        };
+
+        uint MixTileHash(uint hash) {
+            hash ^= hash >> 16;
+            hash *= 0x85EBCA6Bu;
+            hash ^= hash >> 13;
+            hash *= 0xC2B2AE35u;
+            hash ^= hash >> 16;
+            return hash;
+        }
+
+        uint2 main(PS_INPUT input) : SV_TARGET {
+            uint2 origin = uint2(input.pos.xy) * 64;
+            uint2 end    = min(origin + 64, sceneSize);
+            uint  sum    = 0;
+            uint  bits   = 0;
+
+            [loop] for (uint y = origin.y; y < end.y; ++y) {
+                [loop] for (uint x = origin.x; x < end.x; ++x) {
+                    uint4 c     = uint4(round(sceneTexture.Load(int3(x, y, 0)) * 255.0f));
+                    uint  pixel = c.r | (c.g << 8) | (c.b << 16) | (c.a << 24);
+                    uint  hash  = MixTileHash(pixel ^ MixTileHash(x | (y << 16)));
+                    sum  += hash;
+                    bits ^= hash;
+                }
+            }
+            return uint2(sum, bits);
+        }
+    )";
+
+//----------------------------------------------------------------------------------------------------
+void RegisterBuiltInShaders(ShaderRegistry& registry)
+{
+    sShaderProgramDesc fullscreenTexture;
+    fullscreenTexture.name         = SHADER_FULLSCREEN_TEXTURE;
+    fullscreenTexture.vertexSource = s_fullscreenTextureVertexSource;
+    fullscreenTexture.pixelSource  = s_fullscreenTexturePixelSource;
+    fullscreenTexture.inputLayout  = {
+        {"POSITION", 0, eShaderInputFormat::R32G32B32_FLOAT, 0, 0, false},
+        {"TEXCOORD", 0, eShaderInputFormat::R32G32_FLOAT, 0, 12, false}
+    };
+    registry.Register(fullscreenTexture);
+
+    // slot 0 為共用的四個角點，slot 1 為每實例資料 (對應 sSpriteInstance)
+    sShaderProgramDesc sprite;
+    sprite.name         = SHADER_SPRITE;
+    sprite.vertexSource = s_spriteVertexSource;
+    sprite.pixelSource  = s_spritePixelSource;
+    sprite.inputLayout  = {
+        {"POSITION", 0, eShaderInputFormat::R32G32_FLOAT, 0, 0, false},
+        {"INSTANCE_POSITION", 0, eShaderInputFormat::R32G32_FLOAT, 1, 0, true},
+        {"INSTANCE_SIZE", 0, eShaderInputFormat::R32G32_FLOAT, 1, 8, true},
+        {"INSTANCE_UVRECT", 0, eShaderInputFormat::R32G32B32A32_FLOAT, 1, 16, true},
+        {"INSTANCE_ROTATION", 0, eShaderInputFormat::R32_FLOAT, 1, 32, true},
+        {"INSTANCE_COLOR", 0, eShaderInputFormat::R8G8B8A8_UNORM, 1, 36, true}
+    };
+    registry.Register(sprite);
+
+    // 頂點與 input layout 沿用全螢幕四邊形
+    sShaderProgramDesc tileChecksum;
+    tileChecksum.name         = SHADER_TILE_CHECKSUM;
+    tileChecksum.vertexSource = s_fullscreenTextureVertexSource;
+    tileChecksum.pixelSource  = s_tileChecksumPixelSource;
+    tileChecksum.inputLayout  = fullscreenTexture.inputLayout;
+    registry.Register(tileChecksum);
+}
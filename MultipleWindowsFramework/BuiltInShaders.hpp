@@ -0,0 +1,18 @@
+﻿//----------------------------------------------------------------------------------------------------
+// BuiltInShaders.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+
+//-Forward-Declaration--------------------------------------------------------------------------------
+class ShaderRegistry;
+
+//----------------------------------------------------------------------------------------------------
+char const* const SHADER_FULLSCREEN_TEXTURE = "FullscreenTexture";
+char const* const SHADER_SPRITE             = "Sprite";
+char const* const SHADER_TILE_CHECKSUM      = "TileChecksum";      // 輸出 R32G32_UINT，每個像素為一個回讀區塊
+
+//----------------------------------------------------------------------------------------------------
+// 註冊 Renderer 使用的所有 shader；建置時的 pack 與執行時的快取都以這份清單為準
+void RegisterBuiltInShaders(ShaderRegistry& registry);
@@ -0,0 +1,27 @@
+﻿//----------------------------------------------------------------------------------------------------
+// CheckMain.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// 各個 *CheckMain.cpp / *BenchmarkMain.cpp 共用的輔助函式 (不屬於 Windows 專案，只在 Linux 上單獨編譯時使用)
+// 每一項檢查輸出一行 check_<名稱> ok|FAILED，呼叫端以 isPassing &= Check(...) 累計結束碼
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <cstdint>
+#include <cstdio>
+
+//----------------------------------------------------------------------------------------------------
+inline bool Check(bool const condition, char const* description)
+{
+    printf("check_%s %s\n", description, condition ? "ok" : "FAILED");
+    return condition;
+}
+
+// xorshift32：固定的種子產生可重現的隨機資料，state 不可為 0
+inline uint32_t NextRandom(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
@@ -0,0 +1,163 @@
+﻿//----------------------------------------------------------------------------------------------------
+// DragInput.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "DragInput.hpp"
+
+//----------------------------------------------------------------------------------------------------
+void EstimateReleaseVelocity(sPointerSample const* samples,
+                             size_t const          count,
+                             long long const       releaseTimeNanoseconds,
+                             float&                velocityX,
+                             float&                velocityY)
+{
+    velocityX = 0;
+    velocityY = 0;
+    if (count < 2) return;
+    if (releaseTimeNanoseconds - samples[count - 1].timeNanoseconds > DRAG_VELOCITY_IDLE_NANOSECONDS) return;
+
+    size_t first = count;
+    while (first > 0 && releaseTimeNanoseconds - samples[first - 1].timeNanoseconds <= DRAG_VELOCITY_HORIZON_NANOSECONDS)
+    {
+        --first;
+    }
+    size_t const used = count - first;
+    if (used < 2) return;
+
+    // 時間以最後一個樣本為原點 (秒)，避免大數相減的誤差
+    long long const origin = samples[count - 1].timeNanoseconds;
+    double          meanT  = 0;
+    double          meanX  = 0;
+    double          meanY  = 0;
+    for (size_t i = first; i < count; ++i)
+    {
+        meanT += (double)(samples[i].timeNanoseconds - origin) * 1e-9;
+        meanX += samples[i].x;
+        meanY += samples[i].y;
+    }
+    meanT /= (double)used;
+    meanX /= (double)used;
+    meanY /= (double)used;
+
+    double varianceT   = 0;
+    double covarianceX = 0;
+    double covarianceY = 0;
+    for (size_t i = first; i < count; ++i)
+    {
+        double const t = (double)(samples[i].timeNanoseconds - origin) * 1e-9 - meanT;
+        varianceT   += t * t;
+        covarianceX += t * (samples[i].x - meanX);
+        covarianceY += t * (samples[i].y - meanY);
+    }
+    if (varianceT <= 0) return;
+
+    velocityX = (float)(covarianceX / varianceT);
+    velocityY = (float)(covarianceY / varianceT);
+}
+
+//----------------------------------------------------------------------------------------------------
+void DragInputCoalescer::AddSample(sTrack& track, int const x, int const y, long long const timeNanoseconds)
+{
+    sPointerSample& sample = track.history[track.head];
+    sample.timeNanoseconds = timeNanoseconds;
+    sample.x               = (float)x;
+    sample.y               = (float)y;
+
+    track.head  = (track.head + 1) % DRAG_HISTORY_SIZE;
+    track.count = track.count < DRAG_HISTORY_SIZE ? track.count + 1 : DRAG_HISTORY_SIZE;
+}
+
+//----------------------------------------------------------------------------------------------------
+void DragInputCoalescer::Press(uint32_t const windowId, int const x, int const y, long long const timeNanoseconds)
+{
+    ++m_stats.eventsReceived;
+
+    // 重複按下視為重新開始，之前的歷史不再相關
+    sTrack& track = m_tracks[windowId];
+    track         = sTrack();
+    AddSample(track, x, y, timeNanoseconds);
+
+    sDragOp op;
+    op.type     = eDragOpType::Press;
+    op.windowId = windowId;
+    op.x        = x;
+    op.y        = y;
+    m_ops.push_back(op);
+}
+
+//----------------------------------------------------------------------------------------------------
+void DragInputCoalescer::Move(uint32_t const windowId, int const x, int const y, long long const timeNanoseconds)
+{
+    ++m_stats.eventsReceived;
+
+    auto const found = m_tracks.find(windowId);
+    if (found == m_tracks.end())
+    {
+        ++m_stats.eventsIgnored;
+        return;
+    }
+
+    sTrack& track = found->second;
+    AddSample(track, x, y, timeNanoseconds);
+
+    // 之後沒有這個窗口的按下或放開，直接改寫上一個移動
+    if (track.pendingMove >= 0)
+    {
+        m_ops[track.pendingMove].x = x;
+        m_ops[track.pendingMove].y = y;
+        ++m_stats.movesCoalesced;
+        return;
+    }
+
+    sDragOp op;
+    op.type           = eDragOpType::Move;
+    op.windowId       = windowId;
+    op.x              = x;
+    op.y              = y;
+    track.pendingMove = (int)m_ops.size();
+    m_ops.push_back(op);
+}
+
+//----------------------------------------------------------------------------------------------------
+void DragInputCoalescer::Release(uint32_t const windowId, long long const timeNanoseconds)
+{
+    ++m_stats.eventsReceived;
+
+    auto const found = m_tracks.find(windowId);
+    if (found == m_tracks.end())
+    {
+        ++m_stats.eventsIgnored;
+        return;
+    }
+
+    // 環狀歷史依時間順序展開
+    sTrack const&  track = found->second;
+    sPointerSample ordered[DRAG_HISTORY_SIZE];
+    for (unsigned int i = 0; i < track.count; ++i)
+    {
+        ordered[i] = track.history[(track.head + DRAG_HISTORY_SIZE - track.count + i) % DRAG_HISTORY_SIZE];
+    }
+
+    sDragOp op;
+    op.type     = eDragOpType::Release;
+    op.windowId = windowId;
+    op.x        = (int)ordered[track.count - 1].x;
+    op.y        = (int)ordered[track.count - 1].y;
+    EstimateReleaseVelocity(ordered, track.count, timeNanoseconds, op.velocityX, op.velocityY);
+    m_ops.push_back(op);
+
+    m_tracks.erase(found);
+}
+
+//----------------------------------------------------------------------------------------------------
+void DragInputCoalescer::EndFrame()
+{
+    m_stats.opsEmitted += m_ops.size();
+    m_ops.clear();
+
+    for (auto& entry : m_tracks)
+    {
+        entry.second.pendingMove = -1;
+    }
+}
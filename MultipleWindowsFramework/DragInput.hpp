@@ -0,0 +1,95 @@
+﻿//----------------------------------------------------------------------------------------------------
+// DragInput.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+// 放開時的速度只看最近 HORIZON 內的移動；最後一次移動早於放開前 IDLE 以上表示已經停住，速度為 0
+long long const    DRAG_VELOCITY_HORIZON_NANOSECONDS = 100000000ll;    // 100ms
+long long const    DRAG_VELOCITY_IDLE_NANOSECONDS    = 50000000ll;     // 50ms
+unsigned int const DRAG_HISTORY_SIZE                 = 16;
+
+//----------------------------------------------------------------------------------------------------
+struct sPointerSample
+{
+    long long timeNanoseconds = 0;
+    float     x               = 0;
+    float     y               = 0;
+};
+
+// 對 samples (依時間遞增) 中 releaseTime 之前 HORIZON 內的樣本做最小平方直線擬合，回傳像素/秒
+// 樣本不足兩個或時間沒有間隔時為 0
+void EstimateReleaseVelocity(sPointerSample const* samples,
+                             size_t                count,
+                             long long             releaseTimeNanoseconds,
+                             float&                velocityX,
+                             float&                velocityY);
+
+//----------------------------------------------------------------------------------------------------
+enum class eDragOpType : uint8_t
+{
+    Press,
+    Move,                                   // x/y 為這一幀最後的位置
+    Release                                 // velocityX/Y 為放開時的速度
+};
+
+struct sDragOp
+{
+    eDragOpType type      = eDragOpType::Move;
+    uint32_t    windowId  = 0;
+    int         x         = 0;              // 螢幕座標
+    int         y         = 0;
+    float       velocityX = 0;
+    float       velocityY = 0;
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sDragInputStats
+{
+    unsigned long long eventsReceived = 0;
+    unsigned long long movesCoalesced = 0;  // 被同一幀之後的移動取代，不必套用
+    unsigned long long eventsIgnored  = 0;  // 沒有按下就移動或放開
+    unsigned long long opsEmitted     = 0;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 一幀內的拖拽輸入：同一窗口連續的移動合併成最後的位置 (不同窗口、按下與放開仍依到達順序)，
+// 每次移動都記在歷史中，放開時由歷史估算速度
+// 單一執行緒使用；事件由渲染執行緒取出命令佇列時依序送入
+class DragInputCoalescer
+{
+public:
+    void Press(uint32_t windowId, int x, int y, long long timeNanoseconds);
+    void Move(uint32_t windowId, int x, int y, long long timeNanoseconds);
+    void Release(uint32_t windowId, long long timeNanoseconds);
+
+    // 本幀合併後的操作，套用之後呼叫 EndFrame 清除
+    std::vector<sDragOp> const& GetOps() const { return m_ops; }
+    void                        EndFrame();
+
+    bool                   IsPressed(uint32_t windowId) const { return m_tracks.count(windowId) != 0; }
+    size_t                 GetPressedCount() const { return m_tracks.size(); }
+    sDragInputStats const& GetStats() const { return m_stats; }
+
+private:
+    // 只有按下中的窗口有軌跡，放開時移除
+    struct sTrack
+    {
+        int            pendingMove = -1;            // 本幀還能合併的移動在 m_ops 的索引
+        unsigned int   head        = 0;             // 下一個寫入的位置
+        unsigned int   count       = 0;
+        sPointerSample history[DRAG_HISTORY_SIZE];
+    };
+
+    static void AddSample(sTrack& track, int x, int y, long long timeNanoseconds);
+
+    std::unordered_map<uint32_t, sTrack> m_tracks;
+    std::vector<sDragOp>                 m_ops;
+    sDragInputStats                      m_stats;
+};
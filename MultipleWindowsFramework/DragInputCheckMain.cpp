@@ -0,0 +1,185 @@
+﻿//----------------------------------------------------------------------------------------------------
+// DragInputCheckMain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// 拖拽輸入合併與放開速度估算的自我檢查 (不屬於 Windows 專案，在 Linux 上單獨編譯)：
+//
+//   g++ -std=c++14 -O2 DragInputCheckMain.cpp DragInput.cpp -o drag_input_check
+//   ./drag_input_check
+//
+// 以合成的滑鼠事件序列 (1000Hz 的移動、多個窗口交錯、未按下的事件) 檢查每幀送出的操作與放開時的速度
+// 結束碼：0 = 全部通過，1 = 失敗
+//----------------------------------------------------------------------------------------------------
+#include <cmath>
+#include <cstdio>
+
+#include "CheckMain.hpp"
+#include "DragInput.hpp"
+
+//----------------------------------------------------------------------------------------------------
+static long long const MILLISECOND = 1000000ll;
+
+//----------------------------------------------------------------------------------------------------
+static bool IsNear(float const value, float const expected, float const tolerance)
+{
+    return std::fabs(value - expected) <= tolerance;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 一幀 (16ms) 內每 1ms 移動一次：只留下一個移動，位置為最後一個事件
+static bool CheckCoalescing()
+{
+    DragInputCoalescer input;
+    input.Press(0, 100, 100, 0);
+    for (int i = 1; i <= 16; ++i)
+    {
+        input.Move(0, 100 + i, 100 - i, i * MILLISECOND);
+    }
+
+    std::vector<sDragOp> const& ops = input.GetOps();
+    bool isPassing = true;
+    isPassing &= Check(ops.size() == 2 && ops[0].type == eDragOpType::Press && ops[1].type == eDragOpType::Move, "coalesce_ops");
+    isPassing &= Check(ops.size() == 2 && ops[1].x == 116 && ops[1].y == 84, "coalesce_latest_position");
+    isPassing &= Check(input.GetStats().movesCoalesced == 15, "coalesce_count");
+
+    // 下一幀的移動不能改寫已經送出的操作
+    input.EndFrame();
+    input.Move(0, 200, 200, 17 * MILLISECOND);
+    isPassing &= Check(input.GetOps().size() == 1 && input.GetOps()[0].x == 200, "coalesce_next_frame");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 多個窗口交錯，且同一幀內放開後又按下：按下與放開的順序保留，放開前後的移動不合併
+static bool CheckOrdering()
+{
+    DragInputCoalescer input;
+    input.Press(1, 10, 10, 0);
+    input.Press(2, 50, 50, 0);
+    input.Move(1, 11, 11, 1 * MILLISECOND);
+    input.Move(2, 51, 51, 1 * MILLISECOND);
+    input.Move(1, 12, 12, 2 * MILLISECOND);
+    input.Release(1, 3 * MILLISECOND);
+    input.Press(1, 20, 20, 4 * MILLISECOND);
+    input.Move(1, 21, 21, 5 * MILLISECOND);
+    input.Move(2, 52, 52, 5 * MILLISECOND);
+
+    struct sExpected
+    {
+        eDragOpType type;
+        uint32_t    windowId;
+        int         x;
+    };
+    sExpected const expected[] =
+    {
+        {eDragOpType::Press,   1, 10},
+        {eDragOpType::Press,   2, 50},
+        {eDragOpType::Move,    1, 12},
+        {eDragOpType::Move,    2, 52},
+        {eDragOpType::Release, 1, 12},
+        {eDragOpType::Press,   1, 20},
+        {eDragOpType::Move,    1, 21},
+    };
+    size_t const expectedCount = sizeof(expected) / sizeof(expected[0]);
+
+    std::vector<sDragOp> const& ops = input.GetOps();
+    bool isMatching = ops.size() == expectedCount;
+    for (size_t i = 0; isMatching && i < expectedCount; ++i)
+    {
+        isMatching = ops[i].type == expected[i].type && ops[i].windowId == expected[i].windowId && ops[i].x == expected[i].x;
+    }
+
+    bool isPassing = true;
+    isPassing &= Check(isMatching, "ordering");
+    isPassing &= Check(input.IsPressed(1) && input.IsPressed(2) && input.GetPressedCount() == 2, "ordering_pressed");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 等速移動 (每 1ms 移動 (2, -1) 像素 = (2000, -1000) 像素/秒) 後立即放開：速度與實際移動一致
+// 加上 ±1 像素的量化抖動仍在 5% 以內
+static bool CheckConstantVelocity()
+{
+    DragInputCoalescer input;
+    input.Press(0, 0, 500, 0);
+
+    long long time = 0;
+    for (int i = 1; i <= 200; ++i)
+    {
+        time = i * MILLISECOND;
+        int const jitter = (i % 3) - 1;
+        input.Move(0, 2 * i + jitter, 500 - i, time);
+        if (i % 16 == 0) input.EndFrame();
+    }
+    input.Release(0, time + MILLISECOND);
+
+    sDragOp const& release = input.GetOps().back();
+    bool isPassing = true;
+    isPassing &= Check(release.type == eDragOpType::Release, "velocity_release_op");
+    isPassing &= Check(IsNear(release.velocityX, 2000.f, 100.f) && IsNear(release.velocityY, -1000.f, 50.f), "velocity_constant");
+    isPassing &= Check(!input.IsPressed(0), "velocity_released");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 快速移動後停住超過 IDLE 才放開：視為放下，不拋出
+// 只有按下就放開 (沒有移動)：同樣為 0
+static bool CheckIdleRelease()
+{
+    DragInputCoalescer input;
+    input.Press(0, 0, 0, 0);
+    for (int i = 1; i <= 20; ++i)
+    {
+        input.Move(0, i * 10, 0, i * MILLISECOND);
+    }
+    input.Release(0, 20 * MILLISECOND + DRAG_VELOCITY_IDLE_NANOSECONDS + MILLISECOND);
+    sDragOp const idle = input.GetOps().back();
+
+    input.Press(1, 5, 5, 0);
+    input.Release(1, 10 * MILLISECOND);
+    sDragOp const click = input.GetOps().back();
+
+    // 只有很久以前的移動 (超出 HORIZON) 也不算
+    input.Press(2, 0, 0, 0);
+    input.Move(2, 100, 0, 10 * MILLISECOND);
+    input.Move(2, 100, 0, 10 * MILLISECOND + DRAG_VELOCITY_HORIZON_NANOSECONDS);
+    input.Release(2, 10 * MILLISECOND + DRAG_VELOCITY_HORIZON_NANOSECONDS + MILLISECOND);
+    sDragOp const stale = input.GetOps().back();
+
+    bool isPassing = true;
+    isPassing &= Check(idle.velocityX == 0 && idle.velocityY == 0, "idle_release");
+    isPassing &= Check(click.velocityX == 0 && click.velocityY == 0, "click_release");
+    isPassing &= Check(stale.velocityX == 0 && stale.velocityY == 0, "stale_history");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 沒有按下的移動與放開 (例如捕捉在別處結束後才送達) 直接忽略
+static bool CheckIgnoredEvents()
+{
+    DragInputCoalescer input;
+    input.Move(7, 1, 1, 0);
+    input.Release(7, MILLISECOND);
+    input.Press(8, 0, 0, 0);
+    input.Release(8, MILLISECOND);
+    input.Release(8, 2 * MILLISECOND);
+
+    bool isPassing = true;
+    isPassing &= Check(input.GetOps().size() == 2, "ignored_ops");
+    isPassing &= Check(input.GetStats().eventsIgnored == 3 && input.GetStats().eventsReceived == 5, "ignored_count");
+    isPassing &= Check(input.GetPressedCount() == 0, "ignored_pressed");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+int main()
+{
+    bool isPassing = true;
+    isPassing &= CheckCoalescing();
+    isPassing &= CheckOrdering();
+    isPassing &= CheckConstantVelocity();
+    isPassing &= CheckIdleRelease();
+    isPassing &= CheckIgnoredEvents();
+    return isPassing ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+﻿//----------------------------------------------------------------------------------------------------
+// DriftBenchmarkMain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// 漂移積分的無頭基準 (不屬於 Windows 專案，在 Linux 上單獨編譯)：
+//
+//   g++ -std=c++14 -O2 -ffp-contract=off DriftBenchmarkMain.cpp DriftSimulation.cpp -o drift_benchmark
+//   ./drift_benchmark [windows] [frames]
+//
+// 同一組窗口 (四種預設參數混合，其中少數在拖拽中) 分別以逐一呼叫 StepDrift 的通用版本與 DriftBuckets 的特化版本前進，
+// 比較每步的成本，並檢查兩者的狀態校驗碼完全相同
+// 結束碼：0 = 校驗碼一致，1 = 不一致
+//----------------------------------------------------------------------------------------------------
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "CheckMain.hpp"
+#include "DriftSimulation.hpp"
+
+//----------------------------------------------------------------------------------------------------
+static int const          BOUNDS_WIDTH    = 2560;
+static int const          BOUNDS_HEIGHT   = 1440;
+static unsigned int const STEPS_PER_FRAME = 4;              // 60 Hz 的一幀約為 240 Hz 的四步
+
+//----------------------------------------------------------------------------------------------------
+static void CreateBodies(std::vector<sDriftBody>& bodies, unsigned int const windowCount)
+{
+    sDriftParams const presets[] =
+    {
+        DRIFT_PRESET_DEFAULT,
+        DRIFT_PRESET_FLOATING,
+        DRIFT_PRESET_FALLING,
+        DRIFT_PRESET_BILLIARD,
+    };
+    unsigned int const presetCount = sizeof(presets) / sizeof(presets[0]);
+
+    bodies.clear();
+    bodies.resize(windowCount);
+    for (unsigned int i = 0; i < windowCount; ++i)
+    {
+        sDriftBody& body = bodies[i];
+        body.width       = 160 + (int)(i % 7) * 20;
+        body.height      = 120 + (int)(i % 5) * 20;
+        PlaceDriftBody(body, (int)((i * 97u) % (BOUNDS_WIDTH - body.width)), (int)((i * 61u) % (BOUNDS_HEIGHT - body.height)));
+
+        // 亂數種子在設定參數之後才決定初始速度
+        body.drift = presets[(i / 3) % presetCount];
+        SeedDriftBody(body, MixSeed(1, i));
+
+        sDriftDrag drag;
+        if (i % 50 == 0) BeginDrag(body, drag, (int)body.x + 10, (int)body.y + 10);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+static uint64_t GetChecksum(std::vector<sDriftBody> const& bodies)
+{
+    uint64_t hash = DRIFT_CHECKSUM_SEED;
+    for (sDriftBody const& body : bodies)
+    {
+        hash = HashDriftBody(body, hash);
+    }
+    return hash;
+}
+
+//----------------------------------------------------------------------------------------------------
+int main(int const argc, char** argv)
+{
+    using Clock = std::chrono::steady_clock;
+
+    unsigned int const windowCount = argc > 1 ? (unsigned int)strtoul(argv[1], nullptr, 0) : 10000u;
+    unsigned int const frameCount  = argc > 2 ? (unsigned int)strtoul(argv[2], nullptr, 0) : 600u;
+
+    // 通用版本：與改寫之前的 Renderer 相同，逐一窗口、逐步呼叫
+    std::vector<sDriftBody> genericBodies;
+    CreateBodies(genericBodies, windowCount);
+
+    Clock::time_point const genericStart = Clock::now();
+    for (unsigned int frame = 0; frame < frameCount; ++frame)
+    {
+        for (sDriftBody& body : genericBodies)
+        {
+            for (unsigned int step = 0; step < STEPS_PER_FRAME; ++step)
+            {
+                StepDrift(body, BOUNDS_WIDTH, BOUNDS_HEIGHT, DRIFT_SIMULATION_STEP);
+            }
+        }
+    }
+    double const genericMs = std::chrono::duration<double, std::milli>(Clock::now() - genericStart).count();
+
+    // 特化版本：與 Renderer 相同，每幀重新分組 (分組的成本也計入)
+    std::vector<sDriftBody> bucketedBodies;
+    CreateBodies(bucketedBodies, windowCount);
+
+    DriftBuckets            buckets;
+    Clock::time_point const bucketedStart = Clock::now();
+    for (unsigned int frame = 0; frame < frameCount; ++frame)
+    {
+        buckets.Clear();
+        for (sDriftBody& body : bucketedBodies)
+        {
+            buckets.Add(body);
+        }
+        buckets.Step(BOUNDS_WIDTH, BOUNDS_HEIGHT, DRIFT_SIMULATION_STEP, STEPS_PER_FRAME);
+    }
+    double const bucketedMs = std::chrono::duration<double, std::milli>(Clock::now() - bucketedStart).count();
+
+    double const   bodySteps        = (double)windowCount * frameCount * STEPS_PER_FRAME;
+    uint64_t const genericChecksum  = GetChecksum(genericBodies);
+    uint64_t const bucketedChecksum = GetChecksum(bucketedBodies);
+
+    printf("windows %u\n", windowCount);
+    printf("frames %u\n", frameCount);
+    printf("steps_per_frame %u\n", STEPS_PER_FRAME);
+    printf("body_bytes %zu\n", sizeof(sDriftBody));
+    for (unsigned int kernel = 0; kernel < DRIFT_KERNEL_COUNT; ++kernel)
+    {
+        printf("bucket_%u %zu\n", kernel, buckets.GetBucketSize(kernel));
+    }
+    printf("dragging %zu\n", buckets.GetDraggingCount());
+    printf("generic_ms %.3f\n", genericMs);
+    printf("bucketed_ms %.3f\n", bucketedMs);
+    printf("generic_ns_per_step %.2f\n", genericMs * 1e6 / bodySteps);
+    printf("bucketed_ns_per_step %.2f\n", bucketedMs * 1e6 / bodySteps);
+    printf("speedup %.2f\n", bucketedMs > 0.0 ? genericMs / bucketedMs : 0.0);
+    printf("generic_checksum %016llx\n", (unsigned long long)genericChecksum);
+    printf("bucketed_checksum %016llx\n", (unsigned long long)bucketedChecksum);
+
+    bool const isMatching = Check(genericChecksum == bucketedChecksum, "checksum");
+    return isMatching ? 0 : 1;
+}
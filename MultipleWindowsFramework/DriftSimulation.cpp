@@ -0,0 +1,498 @@
+﻿//----------------------------------------------------------------------------------------------------
+// DriftSimulation.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "DriftSimulation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+//----------------------------------------------------------------------------------------------------
+// murmur3 的 fmix32：雙射，輸入只差一個位元時輸出約一半的位元不同
+static uint32_t MixBits(uint32_t value)
+{
+    value ^= value >> 16;
+    value *= 0x85EBCA6Bu;
+    value ^= value >> 13;
+    value *= 0xC2B2AE35u;
+    value ^= value >> 16;
+    return value;
+}
+
+//----------------------------------------------------------------------------------------------------
+uint32_t sDriftRandom::Next()
+{
+    state += 0x9E3779B9u;
+    return MixBits(state);
+}
+
+//----------------------------------------------------------------------------------------------------
+float RandomRange(sDriftRandom& rng, float const minValue, float const maxValue)
+{
+    // 取高 24 位元轉成 [0, 1)
+    float const unit = (float)(rng.Next() >> 8) * (1.f / 16777216.f);
+    return minValue + (maxValue - minValue) * unit;
+}
+
+//----------------------------------------------------------------------------------------------------
+uint32_t MixSeed(uint32_t const seed, uint32_t const index)
+{
+    // 相鄰的 index 也要得到不相關的種子
+    return MixBits(seed ^ (index * 0x9E3779B9u));
+}
+
+//----------------------------------------------------------------------------------------------------
+void SeedDriftBody(sDriftBody& body, uint32_t const seed)
+{
+    body.rng.Seed(seed);
+
+    // 隨機初始速度
+    body.drift.velocityX = RandomRange(body.rng, -50.f, 50.f);
+    body.drift.velocityY = RandomRange(body.rng, -50.f, 50.f);
+}
+
+//----------------------------------------------------------------------------------------------------
+void PlaceDriftBody(sDriftBody& body, int const x, int const y)
+{
+    body.x         = (float)x;
+    body.y         = (float)y;
+    body.previousX = body.x;
+    body.previousY = body.y;
+}
+
+//----------------------------------------------------------------------------------------------------
+void StepDrift(sDriftBody& body, int const boundsWidth, int const boundsHeight, float const deltaTime)
+{
+    body.previousX = body.x;
+    body.previousY = body.y;
+
+    if (body.isDragging) return;            // 拖拽時不漂移
+
+    sDriftParams& drift = body.drift;
+
+    // 重力效果
+    if (drift.enableGravity)
+    {
+        drift.velocityY += drift.acceleration * deltaTime;
+    }
+
+    // 隨機漂移：隨機衝量的變異數與步長成正比，才不會因為步數變多而互相抵銷
+    if (drift.enableWander)
+    {
+        float const wanderScale = drift.wanderStrength * std::sqrt(deltaTime * (1.f / DRIFT_REFERENCE_RATE));
+        drift.velocityX += RandomRange(body.rng, -1.f, 1.f) * wanderScale;
+        drift.velocityY += RandomRange(body.rng, -1.f, 1.f) * wanderScale;
+    }
+
+    // 速度限制
+    float const currentSpeed = std::sqrt(drift.velocityX * drift.velocityX + drift.velocityY * drift.velocityY);
+    if (currentSpeed > drift.targetVelocity)
+    {
+        float const scale = drift.targetVelocity / currentSpeed;
+        drift.velocityX *= scale;
+        drift.velocityY *= scale;
+    }
+
+    // 阻力：drag 為 60 Hz 每幀保留的比例，線性換算到目前的步長 (不用 pow，各平台結果才會一致)
+    float const dragFactor = 1.f - (1.f - drift.drag) * deltaTime * DRIFT_REFERENCE_RATE;
+    drift.velocityX *= dragFactor;
+    drift.velocityY *= dragFactor;
+
+    // 計算新位置
+    float newX = body.x + drift.velocityX * deltaTime;
+    float newY = body.y + drift.velocityY * deltaTime;
+
+    bool bounced = false;
+
+    // 左右邊界
+    if (newX < 0.f)
+    {
+        newX            = 0.f;
+        drift.velocityX = -drift.velocityX * drift.bounceEnergy;
+        bounced         = true;
+    }
+    else if (newX + (float)body.width > (float)boundsWidth)
+    {
+        newX            = (float)(boundsWidth - body.width);
+        drift.velocityX = -drift.velocityX * drift.bounceEnergy;
+        bounced         = true;
+    }
+
+    // 上下邊界
+    if (newY < 0.f)
+    {
+        newY            = 0.f;
+        drift.velocityY = -drift.velocityY * drift.bounceEnergy;
+        bounced         = true;
+    }
+    else if (newY + (float)body.height > (float)boundsHeight)
+    {
+        newY            = (float)(boundsHeight - body.height);
+        drift.velocityY = -drift.velocityY * drift.bounceEnergy;
+        bounced         = true;
+    }
+
+    // 反彈時添加一些隨機性
+    if (bounced && drift.bounce == eDriftBounce::Jitter)
+    {
+        drift.velocityX += RandomRange(body.rng, -30.f, 30.f);
+        drift.velocityY += RandomRange(body.rng, -30.f, 30.f);
+    }
+
+    body.x = newX;
+    body.y = newY;
+}
+
+//----------------------------------------------------------------------------------------------------
+// StepDrift 的特化版本：參數分支在編譯期決定，只剩邊界判斷；每個 body 連續跑完 stepCount 步
+// 不隨步數改變的係數提到迴圈外，運算式與 StepDrift 相同，結果逐位元一致
+template <bool Gravity, bool Wander, eDriftBounce Bounce>
+static void StepDriftKernel(sDriftBody* const* const bodies,
+                            size_t const             bodyCount,
+                            int const                boundsWidth,
+                            int const                boundsHeight,
+                            float const              deltaTime,
+                            unsigned int const       stepCount)
+{
+    for (size_t i = 0; i < bodyCount; ++i)
+    {
+        sDriftBody&   body  = *bodies[i];
+        sDriftParams& drift = body.drift;
+
+        float const gravityStep = drift.acceleration * deltaTime;
+        float const wanderScale = drift.wanderStrength * std::sqrt(deltaTime * (1.f / DRIFT_REFERENCE_RATE));
+        float const dragFactor  = 1.f - (1.f - drift.drag) * deltaTime * DRIFT_REFERENCE_RATE;
+        float const maxX        = (float)(boundsWidth - body.width);
+        float const maxY        = (float)(boundsHeight - body.height);
+        float const rightLimit  = (float)boundsWidth;
+        float const bottomLimit = (float)boundsHeight;
+        float const width       = (float)body.width;
+        float const height      = (float)body.height;
+
+        float x         = body.x;
+        float y         = body.y;
+        float previousX = body.previousX;
+        float previousY = body.previousY;
+        float velocityX = drift.velocityX;
+        float velocityY = drift.velocityY;
+
+        for (unsigned int step = 0; step < stepCount; ++step)
+        {
+            previousX = x;
+            previousY = y;
+
+            if (Gravity)
+            {
+                velocityY += gravityStep;
+            }
+
+            if (Wander)
+            {
+                velocityX += RandomRange(body.rng, -1.f, 1.f) * wanderScale;
+                velocityY += RandomRange(body.rng, -1.f, 1.f) * wanderScale;
+            }
+
+            float const currentSpeed = std::sqrt(velocityX * velocityX + velocityY * velocityY);
+            if (currentSpeed > drift.targetVelocity)
+            {
+                float const scale = drift.targetVelocity / currentSpeed;
+                velocityX *= scale;
+                velocityY *= scale;
+            }
+
+            velocityX *= dragFactor;
+            velocityY *= dragFactor;
+
+            float newX = x + velocityX * deltaTime;
+            float newY = y + velocityY * deltaTime;
+
+            bool bounced = false;
+            if (newX < 0.f)
+            {
+                newX      = 0.f;
+                velocityX = -velocityX * drift.bounceEnergy;
+                bounced   = true;
+            }
+            else if (newX + width > rightLimit)
+            {
+                newX      = maxX;
+                velocityX = -velocityX * drift.bounceEnergy;
+                bounced   = true;
+            }
+
+            if (newY < 0.f)
+            {
+                newY      = 0.f;
+                velocityY = -velocityY * drift.bounceEnergy;
+                bounced   = true;
+            }
+            else if (newY + height > bottomLimit)
+            {
+                newY      = maxY;
+                velocityY = -velocityY * drift.bounceEnergy;
+                bounced   = true;
+            }
+
+            if (Bounce == eDriftBounce::Jitter && bounced)
+            {
+                velocityX += RandomRange(body.rng, -30.f, 30.f);
+                velocityY += RandomRange(body.rng, -30.f, 30.f);
+            }
+
+            x = newX;
+            y = newY;
+        }
+
+        body.x          = x;
+        body.y          = y;
+        body.previousX  = previousX;
+        body.previousY  = previousY;
+        drift.velocityX = velocityX;
+        drift.velocityY = velocityY;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+using DriftKernel = void (*)(sDriftBody* const*, size_t, int, int, float, unsigned int);
+
+// 索引見 DriftBuckets::GetKernelIndex
+static DriftKernel const DRIFT_KERNELS[DRIFT_KERNEL_COUNT] =
+{
+    StepDriftKernel<false, false, eDriftBounce::Jitter>,
+    StepDriftKernel<true, false, eDriftBounce::Jitter>,
+    StepDriftKernel<false, true, eDriftBounce::Jitter>,
+    StepDriftKernel<true, true, eDriftBounce::Jitter>,
+    StepDriftKernel<false, false, eDriftBounce::Elastic>,
+    StepDriftKernel<true, false, eDriftBounce::Elastic>,
+    StepDriftKernel<false, true, eDriftBounce::Elastic>,
+    StepDriftKernel<true, true, eDriftBounce::Elastic>,
+};
+
+//----------------------------------------------------------------------------------------------------
+void BeginDrag(sDriftBody& body, sDriftDrag& drag, int const mouseX, int const mouseY)
+{
+    body.isDragging = true;
+    drag.offsetX    = (float)mouseX - body.x;
+    drag.offsetY    = (float)mouseY - body.y;
+
+    // 拖拽時停止漂移
+    body.drift.velocityX = 0;
+    body.drift.velocityY = 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+void DragTo(sDriftBody& body, sDriftDrag const& drag, int const mouseX, int const mouseY)
+{
+    if (!body.isDragging) return;
+
+    // 直接跟著滑鼠，不內插
+    body.x         = (float)mouseX - drag.offsetX;
+    body.y         = (float)mouseY - drag.offsetY;
+    body.previousX = body.x;
+    body.previousY = body.y;
+}
+
+//----------------------------------------------------------------------------------------------------
+void EndDrag(sDriftBody& body, float const velocityX, float const velocityY)
+{
+    if (!body.isDragging) return;
+
+    // 延續滑鼠放開前的移動，超過 targetVelocity 的部分由下一步的速度限制處理
+    body.isDragging      = false;
+    body.drift.velocityX = velocityX;
+    body.drift.velocityY = velocityY;
+}
+
+//----------------------------------------------------------------------------------------------------
+void GetDrawPosition(sDriftBody const& body, float const alpha, int& x, int& y)
+{
+    float const drawX = body.previousX + (body.x - body.previousX) * alpha;
+    float const drawY = body.previousY + (body.y - body.previousY) * alpha;
+    x = (int)std::floor(drawX + 0.5f);
+    y = (int)std::floor(drawY + 0.5f);
+}
+
+//----------------------------------------------------------------------------------------------------
+static uint64_t HashWord(uint64_t hash, uint32_t const value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        hash ^= (value >> (i * 8)) & 0xFF;
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+//----------------------------------------------------------------------------------------------------
+static uint32_t FloatBits(float const value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+//----------------------------------------------------------------------------------------------------
+uint64_t HashDriftBody(sDriftBody const& body, uint64_t hash)
+{
+    hash = HashWord(hash, FloatBits(body.x));
+    hash = HashWord(hash, FloatBits(body.y));
+    hash = HashWord(hash, FloatBits(body.drift.velocityX));
+    hash = HashWord(hash, FloatBits(body.drift.velocityY));
+    hash = HashWord(hash, body.isDragging ? 1 : 0);
+    return hash;
+}
+
+//----------------------------------------------------------------------------------------------------
+unsigned int DriftBuckets::GetKernelIndex(sDriftParams const& params)
+{
+    return (params.enableGravity ? 1u : 0u) |
+           (params.enableWander ? 2u : 0u) |
+           (params.bounce == eDriftBounce::Elastic ? 4u : 0u);
+}
+
+//----------------------------------------------------------------------------------------------------
+void DriftBuckets::Clear()
+{
+    for (std::vector<sDriftBody*>& bucket : m_buckets)
+    {
+        bucket.clear();
+    }
+    m_dragging.clear();
+}
+
+//----------------------------------------------------------------------------------------------------
+void DriftBuckets::Add(sDriftBody& body)
+{
+    if (body.isDragging)
+    {
+        m_dragging.push_back(&body);
+        return;
+    }
+    m_buckets[GetKernelIndex(body.drift)].push_back(&body);
+}
+
+//----------------------------------------------------------------------------------------------------
+void DriftBuckets::Step(int const          boundsWidth,
+                        int const          boundsHeight,
+                        float const        deltaTime,
+                        unsigned int const stepCount)
+{
+    if (stepCount == 0) return;
+
+    for (unsigned int kernel = 0; kernel < DRIFT_KERNEL_COUNT; ++kernel)
+    {
+        std::vector<sDriftBody*> const& bucket = m_buckets[kernel];
+        if (bucket.empty()) continue;
+
+        DRIFT_KERNELS[kernel](bucket.data(), bucket.size(), boundsWidth, boundsHeight, deltaTime, stepCount);
+    }
+
+    // 與 StepDrift 相同：拖拽時不漂移
+    for (sDriftBody* const body : m_dragging)
+    {
+        body->previousX = body->x;
+        body->previousY = body->y;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+void DriftSimulation::Reset(int const boundsWidth, int const boundsHeight)
+{
+    m_bodies.clear();
+    m_drags.clear();
+    m_boundsWidth  = boundsWidth;
+    m_boundsHeight = boundsHeight;
+}
+
+//----------------------------------------------------------------------------------------------------
+unsigned int DriftSimulation::AddWindow(int const      x,
+                                        int const      y,
+                                        int const      width,
+                                        int const      height,
+                                        uint32_t const seed)
+{
+    sDriftBody body;
+    body.width  = width;
+    body.height = height;
+    PlaceDriftBody(body, x, y);
+    SeedDriftBody(body, seed);
+
+    m_bodies.push_back(body);
+    m_drags.emplace_back();
+    return (unsigned int)m_bodies.size() - 1;
+}
+
+//----------------------------------------------------------------------------------------------------
+sDriftBody* DriftSimulation::GetWindow(unsigned int const id)
+{
+    return id < m_bodies.size() ? &m_bodies[id] : nullptr;
+}
+
+//----------------------------------------------------------------------------------------------------
+sDriftDrag* DriftSimulation::GetDrag(unsigned int const id)
+{
+    return id < m_drags.size() ? &m_drags[id] : nullptr;
+}
+
+//----------------------------------------------------------------------------------------------------
+void DriftSimulation::Step(float const deltaTime, unsigned int const stepCount)
+{
+    m_buckets.Clear();
+    for (sDriftBody& body : m_bodies)
+    {
+        m_buckets.Add(body);
+    }
+    m_buckets.Step(m_boundsWidth, m_boundsHeight, deltaTime, stepCount);
+}
+
+//----------------------------------------------------------------------------------------------------
+uint64_t DriftSimulation::GetChecksum() const
+{
+    uint64_t hash = DRIFT_CHECKSUM_SEED;
+    for (sDriftBody const& body : m_bodies)
+    {
+        hash = HashDriftBody(body, hash);
+    }
+    return hash;
+}
+
+//----------------------------------------------------------------------------------------------------
+FixedTimestep::FixedTimestep(float const stepSeconds, unsigned int const maxStepsPerFrame)
+    : m_stepSeconds(stepSeconds)
+    , m_stepNanoseconds((std::max)(1ll, (long long)std::llround((double)stepSeconds * 1e9)))
+    , m_maxStepsPerFrame((std::max)(1u, maxStepsPerFrame))
+{
+}
+
+//----------------------------------------------------------------------------------------------------
+void FixedTimestep::Reset()
+{
+    m_accumulated  = 0;
+    m_stepCount    = 0;
+    m_droppedSteps = 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+unsigned int FixedTimestep::Advance(long long const elapsedNanoseconds)
+{
+    m_accumulated += (std::max)(0ll, elapsedNanoseconds);
+
+    long long steps = m_accumulated / m_stepNanoseconds;
+    m_accumulated  -= steps * m_stepNanoseconds;
+
+    if (steps > m_maxStepsPerFrame)
+    {
+        m_droppedSteps += (unsigned long long)(steps - m_maxStepsPerFrame);
+        steps           = m_maxStepsPerFrame;
+    }
+    m_stepCount += (unsigned long long)steps;
+    return (unsigned int)steps;
+}
+
+//----------------------------------------------------------------------------------------------------
+unsigned int FixedTimestep::AdvanceSeconds(float const elapsedSeconds)
+{
+    return Advance(std::llround((double)elapsedSeconds * 1e9));
+}
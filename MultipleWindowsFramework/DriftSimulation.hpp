@@ -0,0 +1,190 @@
+﻿//----------------------------------------------------------------------------------------------------
+// DriftSimulation.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+enum class eDriftBounce : uint8_t
+{
+    Jitter,                                 // 反彈後加上一點隨機速度
+    Elastic                                 // 只依 bounceEnergy 反向，不取亂數
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sDriftParams
+{
+    float velocityX      = 0;               // X方向速度 (像素/秒)
+    float velocityY      = 0;               // Y方向速度 (像素/秒)
+    float acceleration   = 50.f;            // 加速度係數
+    float drag           = 0.98f;           // 阻力係數 (0.95-0.99)
+    float bounceEnergy   = 0.8f;            // 反彈能量保留係數 (0.7-0.9)
+    float wanderStrength = 2000.f;          // 隨機漂移強度
+    float targetVelocity = 100.f;           // 目標速度
+    bool  enableGravity  = true;            // 是否啟用重力
+    bool  enableWander   = true;            // 是否啟用隨機漂移
+
+    eDriftBounce bounce = eDriftBounce::Jitter;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 編譯期的參數組合；其餘欄位維持預設值
+constexpr sDriftParams MakeDriftParams(bool const         enableGravity,
+                                       bool const         enableWander,
+                                       eDriftBounce const bounce,
+                                       float const        drag         = 0.98f,
+                                       float const        bounceEnergy = 0.8f)
+{
+    sDriftParams params;
+    params.enableGravity = enableGravity;
+    params.enableWander  = enableWander;
+    params.bounce        = bounce;
+    params.drag          = drag;
+    params.bounceEnergy  = bounceEnergy;
+    return params;
+}
+
+constexpr sDriftParams DRIFT_PRESET_DEFAULT  = MakeDriftParams(true, true, eDriftBounce::Jitter);
+constexpr sDriftParams DRIFT_PRESET_FLOATING = MakeDriftParams(false, true, eDriftBounce::Jitter);            // 無重力，只隨機漂移
+constexpr sDriftParams DRIFT_PRESET_FALLING  = MakeDriftParams(true, false, eDriftBounce::Elastic, 0.99f);    // 只受重力，落地反彈
+constexpr sDriftParams DRIFT_PRESET_BILLIARD = MakeDriftParams(false, false, eDriftBounce::Elastic, 1.f, 1.f); // 等速直線，完全反彈
+
+//----------------------------------------------------------------------------------------------------
+// 模擬以固定步長前進，與渲染頻率無關
+float const DRIFT_SIMULATION_STEP = 1.f / 240.f;
+float const DRIFT_REFERENCE_RATE  = 60.f;   // drag 與 wanderStrength 原本以 60 Hz 的每幀定義，換算到任意步長
+
+//----------------------------------------------------------------------------------------------------
+// 漂移用的亂數：32 位元的 Weyl 序列經過與 MixSeed 相同的混合，週期 2^32
+// 狀態只有 4 位元組 (std::mt19937 約 2.5KB)，輸出由本檔定義，各平台結果一致
+struct sDriftRandom
+{
+    uint32_t state = 0;
+
+    void     Seed(uint32_t seed) { state = seed; }
+    uint32_t Next();
+};
+
+//----------------------------------------------------------------------------------------------------
+// 一個窗口的漂移狀態，與 Win32 無關：即時執行與無頭回放使用同一份邏輯
+// 位置為窗口外框左上角 (保留小數，低速時也不會遺失移動)，大小為客戶區 (與原本的邊界判斷相同)
+// 每一步都會讀寫的欄位，剛好一條快取線；只在拖拽時使用的偏移另外放在 sDriftDrag
+struct sDriftBody
+{
+    sDriftParams drift;
+    sDriftRandom rng;
+    float        x          = 0;
+    float        y          = 0;
+    float        previousX  = 0;            // 上一步的位置，畫面在兩步之間內插
+    float        previousY  = 0;
+    int          width      = 0;
+    int          height     = 0;
+    bool         isDragging = false;        // 是否正在被拖拽
+};
+
+size_t const DRIFT_BODY_SIZE_BUDGET = 64;
+static_assert(sizeof(sDriftBody) <= DRIFT_BODY_SIZE_BUDGET, "sDriftBody must fit in one cache line");
+
+struct sDriftDrag
+{
+    float offsetX = 0;                      // 拖拽偏移 (滑鼠相對於窗口左上角)
+    float offsetY = 0;
+};
+
+//----------------------------------------------------------------------------------------------------
+// [minValue, maxValue) 的亂數；不使用 std::uniform_real_distribution，因為各標準函式庫的實作結果不同
+float    RandomRange(sDriftRandom& rng, float minValue, float maxValue);
+uint32_t MixSeed(uint32_t seed, uint32_t index);
+
+void SeedDriftBody(sDriftBody& body, uint32_t seed);    // 重設亂數並給予隨機初始速度
+void PlaceDriftBody(sDriftBody& body, int x, int y);    // 直接移到 (x, y)，不內插
+void StepDrift(sDriftBody& body, int boundsWidth, int boundsHeight, float deltaTime);     // 依參數分支的通用版本
+void BeginDrag(sDriftBody& body, sDriftDrag& drag, int mouseX, int mouseY);
+void DragTo(sDriftBody& body, sDriftDrag const& drag, int mouseX, int mouseY);
+void EndDrag(sDriftBody& body, float velocityX, float velocityY);    // 以放開時的速度 (像素/秒) 拋出
+
+// 畫面上的位置：上一步與目前位置之間依 alpha (0-1) 內插後取最接近的像素
+void GetDrawPosition(sDriftBody const& body, float alpha, int& x, int& y);
+
+// FNV-1a：位置、速度與拖拽狀態 (浮點數以位元比較)
+uint64_t const DRIFT_CHECKSUM_SEED = 0xCBF29CE484222325ull;
+uint64_t       HashDriftBody(sDriftBody const& body, uint64_t hash);
+
+//----------------------------------------------------------------------------------------------------
+// 固定步長的時間累加器：以整數奈秒累加，每幀的步數不會因為浮點誤差而忽多忽少
+// 一幀累積超過 maxStepsPerFrame 步時捨棄多出的時間，卡頓之後不會為了追趕而越來越慢
+class FixedTimestep
+{
+public:
+    explicit FixedTimestep(float stepSeconds = DRIFT_SIMULATION_STEP, unsigned int maxStepsPerFrame = 16);
+
+    void Reset();
+
+    // 加入經過的時間，回傳這一幀要執行的步數
+    unsigned int Advance(long long elapsedNanoseconds);
+    unsigned int AdvanceSeconds(float elapsedSeconds);
+
+    float GetStep() const { return m_stepSeconds; }
+    float GetAlpha() const { return (float)m_accumulated / (float)m_stepNanoseconds; }  // [0, 1)
+
+    unsigned long long GetStepCount() const { return m_stepCount; }
+    unsigned long long GetDroppedSteps() const { return m_droppedSteps; }
+
+private:
+    float              m_stepSeconds;
+    long long          m_stepNanoseconds;
+    unsigned int       m_maxStepsPerFrame;
+    long long          m_accumulated  = 0;
+    unsigned long long m_stepCount    = 0;
+    unsigned long long m_droppedSteps = 0;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 依 (enableGravity, enableWander, bounce) 分組，每組以編譯期特化、沒有參數分支的迴圈前進
+// 結果與逐一呼叫 StepDrift 完全相同 (浮點運算順序一致)；body 的位址在 Step 之前不可改變
+unsigned int const DRIFT_KERNEL_COUNT = 8;
+
+class DriftBuckets
+{
+public:
+    void Clear();
+    void Add(sDriftBody& body);
+    void Step(int boundsWidth, int boundsHeight, float deltaTime, unsigned int stepCount);
+
+    size_t GetBucketSize(unsigned int kernel) const { return m_buckets[kernel].size(); }
+    size_t GetDraggingCount() const { return m_dragging.size(); }
+
+    static unsigned int GetKernelIndex(sDriftParams const& params);
+
+private:
+    std::vector<sDriftBody*> m_buckets[DRIFT_KERNEL_COUNT];
+    std::vector<sDriftBody*> m_dragging;                    // 拖拽中的窗口只更新上一步的位置
+};
+
+//----------------------------------------------------------------------------------------------------
+// 無頭的漂移模擬：只有窗口狀態，沒有窗口，供回放使用
+class DriftSimulation
+{
+public:
+    void Reset(int boundsWidth, int boundsHeight);
+
+    // 回傳窗口編號 (加入順序)
+    unsigned int AddWindow(int x, int y, int width, int height, uint32_t seed);
+    sDriftBody*  GetWindow(unsigned int id);
+    sDriftDrag*  GetDrag(unsigned int id);
+    size_t       GetWindowCount() const { return m_bodies.size(); }
+
+    void     Step(float deltaTime, unsigned int stepCount = 1);
+    uint64_t GetChecksum() const;
+
+private:
+    std::vector<sDriftBody> m_bodies;
+    std::vector<sDriftDrag> m_drags;
+    DriftBuckets            m_buckets;
+    int                     m_boundsWidth  = 0;
+    int                     m_boundsHeight = 0;
+};
@@ -0,0 +1,162 @@
+﻿//----------------------------------------------------------------------------------------------------
+// FlightRecorder.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "FlightRecorder.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+//----------------------------------------------------------------------------------------------------
+static FILE* OpenFile(char const* path, char const* mode)
+{
+#if defined(_MSC_VER)
+    FILE* file = nullptr;
+    return fopen_s(&file, path, mode) == 0 ? file : nullptr;
+#else
+    return fopen(path, mode);
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------
+static double ToMilliseconds(uint32_t const microseconds)
+{
+    return microseconds / 1000.0;
+}
+
+//----------------------------------------------------------------------------------------------------
+char const* GetFrameStageName(eFrameStage const stage)
+{
+    switch (stage)
+    {
+        case eFrameStage::Messages:   return "messages";
+        case eFrameStage::Simulation: return "simulation";
+        case eFrameStage::Visibility: return "visibility";
+        case eFrameStage::Composite:  return "composite";
+        case eFrameStage::Readback:   return "readback";
+        case eFrameStage::Windows:    return "windows";
+        case eFrameStage::Scenes:     return "scenes";
+        default:                      return "unknown";
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+void FlightRecorder::Configure(sFlightRecorderDesc const& desc)
+{
+    m_desc          = desc;
+    m_desc.capacity = (std::max)(1u, desc.capacity);
+
+    // 突波之後的幀必須留在環中，最多只等到環的一半
+    m_desc.framesAfter = (std::min)(desc.framesAfter, m_desc.capacity / 2);
+
+    m_samples.assign(m_desc.capacity, sFrameSample());
+    m_next                  = 0;
+    m_count                 = 0;
+    m_thresholdMicroseconds = (uint32_t)(std::max)(0.f, desc.thresholdMilliseconds * 1000.f);
+    m_isDumpPending         = false;
+    m_framesUntilDump       = 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool FlightRecorder::Record(sFrameSample const& sample)
+{
+    sFrameSample& slot = m_samples[m_next];
+    slot               = sample;
+    slot.frameIndex    = m_stats.frames++;
+
+    m_next  = (m_next + 1) % m_samples.size();
+    m_count = (std::min)(m_count + 1, m_samples.size());
+
+    bool const isHitch = IsHitch(slot);
+    if (isHitch) ++m_stats.hitches;
+
+    // 等待期間的突波寫在同一個檔案，不延後寫出 (持續卡頓時仍在 framesAfter 幀後留下記錄)
+    if (m_isDumpPending)
+    {
+        if (m_framesUntilDump > 0) --m_framesUntilDump;
+    }
+    else if (isHitch)
+    {
+        m_isDumpPending   = true;
+        m_triggerFrame    = slot.frameIndex;
+        m_framesUntilDump = m_desc.framesAfter;
+    }
+
+    if (m_isDumpPending && m_framesUntilDump == 0)
+    {
+        Flush();
+    }
+    return isHitch;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool FlightRecorder::IsHitch(sFrameSample const& sample) const
+{
+    return m_thresholdMicroseconds > 0 && sample.frameIndex >= m_desc.warmupFrames && sample.frameMicroseconds >= m_thresholdMicroseconds;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool FlightRecorder::Flush()
+{
+    if (!m_isDumpPending) return true;
+
+    m_isDumpPending = false;
+    if (m_stats.dumps >= m_desc.maxDumps || !WriteDump())
+    {
+        ++m_stats.dumpsSkipped;
+        return false;
+    }
+
+    ++m_stats.dumps;
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool FlightRecorder::WriteDump()
+{
+    std::string const path = m_desc.pathPrefix + std::to_string(m_triggerFrame) + ".txt";
+
+    FILE* file = OpenFile(path.c_str(), "w");
+    if (!file) return false;
+
+    size_t const first = (m_next + m_samples.size() - m_count) % m_samples.size();
+
+    unsigned int hitchCount = 0;
+    for (size_t i = 0; i < m_count; ++i)
+    {
+        if (IsHitch(m_samples[(first + i) % m_samples.size()])) ++hitchCount;
+    }
+
+    fprintf(file, "hitch_frame %llu\n", (unsigned long long)m_triggerFrame);
+    fprintf(file, "threshold_ms %.3f\n", ToMilliseconds(m_thresholdMicroseconds));
+    fprintf(file, "frames %zu\n", m_count);
+    fprintf(file, "hitches %u\n", hitchCount);
+
+    // 每幀一行，欄位依 columns 的順序；hitch 為 1 的幀超過門檻
+    fprintf(file, "columns frame frame_ms interval_ms");
+    for (size_t stage = 0; stage < (size_t)eFrameStage::Count; ++stage)
+    {
+        fprintf(file, " %s_ms", GetFrameStageName((eFrameStage)stage));
+    }
+    fprintf(file, " windows readback_bytes hitch\n");
+
+    for (size_t i = 0; i < m_count; ++i)
+    {
+        sFrameSample const& sample = m_samples[(first + i) % m_samples.size()];
+
+        fprintf(file, "%llu %.3f %.3f", (unsigned long long)sample.frameIndex,
+                ToMilliseconds(sample.frameMicroseconds), ToMilliseconds(sample.intervalMicroseconds));
+        for (size_t stage = 0; stage < (size_t)eFrameStage::Count; ++stage)
+        {
+            fprintf(file, " %.3f", ToMilliseconds(sample.stageMicroseconds[stage]));
+        }
+        fprintf(file, " %u %u %d\n", sample.windowCount, sample.readbackBytes, IsHitch(sample) ? 1 : 0);
+    }
+
+    bool const isWritten = !ferror(file);
+    fclose(file);
+
+    if (isWritten) m_lastDumpPath = path;
+    return isWritten;
+}
@@ -0,0 +1,97 @@
+﻿//----------------------------------------------------------------------------------------------------
+// FlightRecorder.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+// 一幀依序經過的階段 (Messages 在 Render 之前，由主循環回報)
+enum class eFrameStage : uint8_t
+{
+    Messages,                               // 主循環的訊息處理
+    Simulation,                             // 命令、漂移與窗口移動
+    Visibility,                             // 遮擋、回讀區塊的覆蓋與背景串流
+    Composite,                              // 合成場景並送出回讀
+    Readback,                               // 等待 GPU 並複製回讀
+    Windows,                                // 主場景分發到窗口 (含匯出與錄影)
+    Scenes,                                 // 其他場景的窗口
+    Count
+};
+
+char const* GetFrameStageName(eFrameStage stage);
+
+//----------------------------------------------------------------------------------------------------
+// 環中的一幀：固定大小，記錄時只複製這個結構
+struct sFrameSample
+{
+    uint64_t frameIndex                                    = 0;    // 由 FlightRecorder 依記錄順序指定
+    uint32_t frameMicroseconds                             = 0;    // 訊息處理加上整個 Render (不含幀之間的等待)，超過門檻即為突波
+    uint32_t intervalMicroseconds                          = 0;    // 與上一幀開始的間隔 (第一幀為 0)
+    uint32_t stageMicroseconds[(size_t)eFrameStage::Count] = {};
+    uint32_t windowCount                                   = 0;
+    uint32_t readbackBytes                                 = 0;
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sFlightRecorderDesc
+{
+    std::string  pathPrefix            = "Hitch_";     // 檔名為 pathPrefix + 突波的幀編號 + ".txt"
+    float        thresholdMilliseconds = 50.f;         // 幀時間超過時寫出；0 為只記錄不寫出
+    unsigned int capacity              = 600;          // 環中保留的幀數 (60 FPS 約 10 秒)
+    unsigned int framesAfter           = 60;           // 突波後再記錄的幀數，檔案包含之後的恢復過程
+    unsigned int warmupFrames          = 30;           // 啟動後的幾幀 (建立資源、第一次上傳) 不視為突波
+    unsigned int maxDumps              = 16;           // 長時間執行也不會寫滿磁碟
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sFlightRecorderStats
+{
+    unsigned long long frames       = 0;
+    unsigned long long hitches      = 0;
+    unsigned long long dumps        = 0;
+    unsigned long long dumpsSkipped = 0;    // 已達 maxDumps，或寫檔失敗
+};
+
+//----------------------------------------------------------------------------------------------------
+// 常駐的飛行記錄器：最近幾秒每一幀的階段時間、窗口數與回讀量放在固定大小的環中 (啟動時配置一次)
+// 幀時間超過門檻時，再記錄 framesAfter 幀後把整個環寫到檔案；等待期間的其他突波一併寫在同一個檔案
+// Record 只複製一個 sFrameSample 並比較門檻，寫檔只發生在突波之後
+class FlightRecorder
+{
+public:
+    FlightRecorder() { Configure(sFlightRecorderDesc()); }
+    ~FlightRecorder() { Flush(); }
+
+    void Configure(sFlightRecorderDesc const& desc);      // 清除環與等待中的檔案，統計保留
+
+    // 回傳這一幀是否為突波
+    bool Record(sFrameSample const& sample);
+
+    // 立即寫出等待中的檔案 (結束前呼叫，突波後來不及記錄完 framesAfter 幀)
+    bool Flush();
+
+    sFlightRecorderDesc const&  GetDesc() const { return m_desc; }
+    sFlightRecorderStats const& GetStats() const { return m_stats; }
+    std::string const&          GetLastDumpPath() const { return m_lastDumpPath; }
+    size_t                      GetMemoryBytes() const { return m_samples.capacity() * sizeof(sFrameSample); }
+
+private:
+    bool IsHitch(sFrameSample const& sample) const;
+    bool WriteDump();
+
+    sFlightRecorderDesc       m_desc;
+    sFlightRecorderStats      m_stats;
+    std::vector<sFrameSample> m_samples;                       // 環 (m_desc.capacity 個)
+    size_t                    m_next                  = 0;     // 下一幀寫入的位置
+    size_t                    m_count                 = 0;     // 環中有效的幀數
+    uint32_t                  m_thresholdMicroseconds = 0;
+    bool                      m_isDumpPending         = false;
+    uint64_t                  m_triggerFrame          = 0;     // 等待中檔案的第一個突波
+    uint32_t                  m_framesUntilDump       = 0;
+    std::string               m_lastDumpPath;
+};
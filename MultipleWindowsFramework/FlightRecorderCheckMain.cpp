@@ -0,0 +1,336 @@
+﻿//----------------------------------------------------------------------------------------------------
+// FlightRecorderCheckMain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// 飛行記錄器的觸發、寫檔與記錄成本 (不屬於 Windows 專案，在 Linux 上單獨編譯)：
+//
+//   g++ -std=c++14 -O2 FlightRecorderCheckMain.cpp FlightRecorder.cpp -o flight_recorder_check
+//   ./flight_recorder_check [frames]
+//
+// 以合成的幀序列 (穩定的 16ms、單一突波、連續突波、持續卡頓、結束前的突波) 檢查何時寫出檔案與檔案內容，
+// 檔案寫在目前的目錄 (flight_check_*.txt)，檢查後刪除；最後量測每幀 Record 的成本
+// 結束碼：0 = 全部通過，1 = 失敗
+//----------------------------------------------------------------------------------------------------
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "CheckMain.hpp"
+#include "FlightRecorder.hpp"
+
+//----------------------------------------------------------------------------------------------------
+static char const* const PATH_PREFIX = "flight_check_";
+
+//----------------------------------------------------------------------------------------------------
+// 階段時間由幀編號決定，檔案中的每一行都可以驗證
+static sFrameSample MakeSample(unsigned int const frame, uint32_t const frameMicroseconds)
+{
+    sFrameSample sample;
+    sample.frameMicroseconds    = frameMicroseconds;
+    sample.intervalMicroseconds = frameMicroseconds + 16000;
+    for (size_t stage = 0; stage < (size_t)eFrameStage::Count; ++stage)
+    {
+        sample.stageMicroseconds[stage] = frame % 97 + (uint32_t)stage;
+    }
+    sample.windowCount   = 10 + frame % 5;
+    sample.readbackBytes = frame * 64;
+    return sample;
+}
+
+static sFlightRecorderDesc MakeDesc(unsigned int const capacity, unsigned int const framesAfter)
+{
+    sFlightRecorderDesc desc;
+    desc.pathPrefix            = PATH_PREFIX;
+    desc.thresholdMilliseconds = 50.f;
+    desc.capacity              = capacity;
+    desc.framesAfter           = framesAfter;
+    desc.warmupFrames          = 0;
+    return desc;
+}
+
+static std::string GetDumpPath(unsigned long long const frame)
+{
+    return PATH_PREFIX + std::to_string(frame) + ".txt";
+}
+
+static bool IsFileExisting(std::string const& path)
+{
+    FILE* file = fopen(path.c_str(), "r");
+    if (file) fclose(file);
+    return file != nullptr;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 解析寫出的檔案：標頭的 key value 與每幀一行的欄位
+struct sDump
+{
+    unsigned long long               hitchFrame = 0;
+    unsigned int                     frames     = 0;
+    unsigned int                     hitches    = 0;
+    std::vector<std::vector<double>> rows;
+};
+
+static bool ReadDump(std::string const& path, sDump& dump)
+{
+    FILE* file = fopen(path.c_str(), "r");
+    if (!file) return false;
+
+    char line[1024];
+    while (fgets(line, sizeof(line), file))
+    {
+        if (sscanf(line, "hitch_frame %llu", &dump.hitchFrame) == 1) continue;
+        if (sscanf(line, "frames %u", &dump.frames) == 1) continue;
+        if (sscanf(line, "hitches %u", &dump.hitches) == 1) continue;
+        if (line[0] < '0' || line[0] > '9') continue;
+
+        std::vector<double> row;
+        char*               cursor = line;
+        char*               end    = nullptr;
+        for (double value = strtod(cursor, &end); end != cursor; value = strtod(cursor, &end))
+        {
+            row.push_back(value);
+            cursor = end;
+        }
+        dump.rows.push_back(row);
+    }
+    fclose(file);
+    return true;
+}
+
+// 每一行的欄位與 MakeSample 的內容相同，幀編號連續且最後一行是 lastFrame
+static bool IsDumpMatching(sDump const& dump, unsigned int const lastFrame, uint32_t const hitchMicroseconds)
+{
+    size_t const columnCount = 3 + (size_t)eFrameStage::Count + 3;
+    if (dump.rows.size() != dump.frames || dump.rows.empty()) return false;
+
+    unsigned int const firstFrame = lastFrame + 1 - (unsigned int)dump.rows.size();
+    for (size_t i = 0; i < dump.rows.size(); ++i)
+    {
+        std::vector<double> const& row   = dump.rows[i];
+        unsigned int const         frame = firstFrame + (unsigned int)i;
+        if (row.size() != columnCount || row[0] != frame) return false;
+
+        bool const         isHitch  = row[columnCount - 1] != 0;
+        sFrameSample const expected = MakeSample(frame, isHitch ? hitchMicroseconds : 16000);
+        if ((uint32_t)(row[1] * 1000 + 0.5) != expected.frameMicroseconds) return false;
+        for (size_t stage = 0; stage < (size_t)eFrameStage::Count; ++stage)
+        {
+            if ((uint32_t)(row[3 + stage] * 1000 + 0.5) != expected.stageMicroseconds[stage]) return false;
+        }
+        if (row[3 + (size_t)eFrameStage::Count] != expected.windowCount) return false;
+        if (row[4 + (size_t)eFrameStage::Count] != expected.readbackBytes) return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 穩定的幀不寫任何檔案；門檻為 0 時、或啟動後的幾幀內的突波也不寫
+static bool CheckSteadyFrames()
+{
+    FlightRecorder recorder;
+    recorder.Configure(MakeDesc(120, 30));
+    for (unsigned int frame = 0; frame < 1000; ++frame)
+    {
+        recorder.Record(MakeSample(frame, 16000));
+    }
+
+    sFlightRecorderDesc disabledDesc   = MakeDesc(120, 30);
+    disabledDesc.thresholdMilliseconds = 0.f;
+    FlightRecorder disabled;
+    disabled.Configure(disabledDesc);
+    for (unsigned int frame = 0; frame < 100; ++frame)
+    {
+        disabled.Record(MakeSample(frame, frame == 50 ? 500000 : 16000));
+    }
+    disabled.Flush();
+
+    sFlightRecorderDesc warmupDesc = MakeDesc(120, 30);
+    warmupDesc.warmupFrames        = 30;
+    FlightRecorder warmup;
+    warmup.Configure(warmupDesc);
+    for (unsigned int frame = 0; frame < 100; ++frame)
+    {
+        warmup.Record(MakeSample(frame, frame < 30 ? 300000 : 16000));
+    }
+    warmup.Flush();
+
+    bool isPassing = true;
+    isPassing &= Check(recorder.GetStats().frames == 1000 && recorder.GetStats().hitches == 0, "steady_no_hitch");
+    isPassing &= Check(recorder.GetStats().dumps == 0 && recorder.GetLastDumpPath().empty(), "steady_no_dump");
+    isPassing &= Check(disabled.GetStats().hitches == 0 && disabled.GetStats().dumps == 0, "threshold_disabled");
+    isPassing &= Check(warmup.GetStats().hitches == 0 && warmup.GetStats().dumps == 0, "warmup_ignored");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 第 500 幀的突波：再記錄 30 幀後寫出整個環 (第 411 到 530 幀)，之前不寫
+static bool CheckSingleHitch()
+{
+    FlightRecorder recorder;
+    recorder.Configure(MakeDesc(120, 30));
+
+    bool isHitchReported = false;
+    bool isDumpEarly     = false;
+    for (unsigned int frame = 0; frame < 600; ++frame)
+    {
+        bool const isHitch = recorder.Record(MakeSample(frame, frame == 500 ? 120000 : 16000));
+        isHitchReported |= isHitch && frame == 500;
+        isDumpEarly     |= frame < 530 && recorder.GetStats().dumps > 0;
+    }
+
+    sDump dump;
+    bool const isRead = ReadDump(GetDumpPath(500), dump);
+    remove(GetDumpPath(500).c_str());
+
+    bool isPassing = true;
+    isPassing &= Check(isHitchReported && recorder.GetStats().hitches == 1, "single_hitch_detected");
+    isPassing &= Check(!isDumpEarly && recorder.GetStats().dumps == 1, "single_dump_after_window");
+    isPassing &= Check(isRead && dump.hitchFrame == 500 && dump.hitches == 1 && dump.frames == 120, "single_dump_header");
+    isPassing &= Check(isRead && IsDumpMatching(dump, 530, 120000), "single_dump_rows");
+    isPassing &= Check(isRead && dump.rows.size() == 120 && dump.rows[89][0] == 500 && dump.rows[89].back() == 1, "single_dump_spike_row");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 等待期間的第二個突波寫在同一個檔案；之後的突波另外寫一個；超過 maxDumps 的只計數
+static bool CheckRepeatedHitches()
+{
+    sFlightRecorderDesc desc = MakeDesc(120, 30);
+    desc.maxDumps            = 2;
+
+    FlightRecorder recorder;
+    recorder.Configure(desc);
+    for (unsigned int frame = 0; frame < 600; ++frame)
+    {
+        bool const isHitch = frame == 100 || frame == 110 || frame == 300 || frame == 450;
+        recorder.Record(MakeSample(frame, isHitch ? 80000 : 16000));
+    }
+
+    sDump first;
+    sDump second;
+    bool const isFirstRead  = ReadDump(GetDumpPath(100), first);
+    bool const isSecondRead = ReadDump(GetDumpPath(300), second);
+    bool const isThirdFound = IsFileExisting(GetDumpPath(450)) || IsFileExisting(GetDumpPath(110));
+    remove(GetDumpPath(100).c_str());
+    remove(GetDumpPath(300).c_str());
+
+    sFlightRecorderStats const& stats = recorder.GetStats();
+    bool isPassing = true;
+    isPassing &= Check(stats.hitches == 4 && stats.dumps == 2 && stats.dumpsSkipped == 1, "repeated_stats");
+    isPassing &= Check(isFirstRead && first.hitches == 2 && IsDumpMatching(first, 130, 80000), "repeated_shared_dump");
+    isPassing &= Check(isSecondRead && second.hitches == 1 && IsDumpMatching(second, 330, 80000), "repeated_second_dump");
+    isPassing &= Check(!isThirdFound, "repeated_max_dumps");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 持續卡頓 (每一幀都超過門檻) 仍在 framesAfter 幀後寫出；環還沒填滿時只寫出已記錄的幀
+// 寫出後仍在卡頓：下一個突波開始新的檔案 (結束時由解構寫出)
+static bool CheckSustainedFreeze()
+{
+    sFlightRecorderStats stats;
+    {
+        FlightRecorder recorder;
+        recorder.Configure(MakeDesc(120, 30));
+        for (unsigned int frame = 0; frame < 50; ++frame)
+        {
+            recorder.Record(MakeSample(frame, frame >= 10 ? 200000 : 16000));
+        }
+        stats = recorder.GetStats();
+    }
+
+    sDump dump;
+    sDump next;
+    bool const isRead     = ReadDump(GetDumpPath(10), dump);
+    bool const isNextRead = ReadDump(GetDumpPath(41), next);
+    remove(GetDumpPath(10).c_str());
+    remove(GetDumpPath(41).c_str());
+
+    bool isPassing = true;
+    isPassing &= Check(stats.dumps == 1 && stats.hitches == 40, "sustained_dump");
+    isPassing &= Check(isRead && dump.frames == 41 && dump.hitches == 31 && IsDumpMatching(dump, 40, 200000), "sustained_rows");
+    isPassing &= Check(isNextRead && next.frames == 50 && IsDumpMatching(next, 49, 200000), "sustained_next_dump");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 突波後來不及記錄完 framesAfter 幀就結束：Flush (或解構) 寫出已有的幀
+// 無法開啟的路徑不影響記錄，只計入 dumpsSkipped
+static bool CheckFlushAndFailure()
+{
+    sDump dump;
+    {
+        FlightRecorder recorder;
+        recorder.Configure(MakeDesc(120, 30));
+        for (unsigned int frame = 0; frame < 205; ++frame)
+        {
+            recorder.Record(MakeSample(frame, frame == 200 ? 90000 : 16000));
+        }
+    }
+    bool const isRead = ReadDump(GetDumpPath(200), dump);
+    remove(GetDumpPath(200).c_str());
+
+    sFlightRecorderDesc desc = MakeDesc(120, 0);
+    desc.pathPrefix          = "missing_directory/flight_check_";
+    FlightRecorder failing;
+    failing.Configure(desc);
+    bool const isHitch = failing.Record(MakeSample(0, 90000));
+    failing.Record(MakeSample(1, 16000));
+
+    bool isPassing = true;
+    isPassing &= Check(isRead && dump.hitchFrame == 200 && IsDumpMatching(dump, 204, 90000), "flush_on_exit");
+    isPassing &= Check(isHitch && failing.GetStats().dumps == 0 && failing.GetStats().dumpsSkipped == 1, "dump_failure");
+    isPassing &= Check(failing.GetStats().frames == 2, "dump_failure_keeps_recording");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+int main(int const argc, char** argv)
+{
+    using Clock = std::chrono::steady_clock;
+
+    unsigned int const frameCount = argc > 1 ? (unsigned int)strtoul(argv[1], nullptr, 0) : 10000000u;
+
+    bool isPassing = true;
+    isPassing &= CheckSteadyFrames();
+    isPassing &= CheckSingleHitch();
+    isPassing &= CheckRepeatedHitches();
+    isPassing &= CheckSustainedFreeze();
+    isPassing &= CheckFlushAndFailure();
+
+    // 記錄成本：預設大小的環，不觸發寫檔；樣本事先建立，只量測 Record
+    std::vector<sFrameSample> samples;
+    for (unsigned int i = 0; i < 64; ++i)
+    {
+        samples.push_back(MakeSample(i, 16000 + i));
+    }
+
+    FlightRecorder recorder;
+    recorder.Configure(MakeDesc(600, 60));
+
+    unsigned int            hitches = 0;
+    Clock::time_point const start   = Clock::now();
+    for (unsigned int frame = 0; frame < frameCount; ++frame)
+    {
+        hitches += recorder.Record(samples[frame & 63]) ? 1 : 0;
+    }
+    Clock::time_point const end = Clock::now();
+
+    double const recordNs        = std::chrono::duration<double, std::nano>(end - start).count() / (frameCount ? frameCount : 1);
+    double const overheadPercent = recordNs / (1e9 / 60.0) * 100.0;
+
+    printf("frames %u\n", frameCount);
+    printf("ring_bytes %zu\n", recorder.GetMemoryBytes());
+    printf("sample_bytes %zu\n", sizeof(sFrameSample));
+    printf("record_ns_per_frame %.2f\n", recordNs);
+    printf("record_overhead_percent_at_60fps %.6f\n", overheadPercent);
+
+    // 每幀的成本必須遠小於 QueryPerformanceCounter 的量測本身 (約數十奈秒)
+    isPassing &= Check(hitches == 0 && recorder.GetStats().frames == frameCount, "benchmark_no_hitch");
+    isPassing &= Check(recordNs < 100.0, "record_cost");
+    return isPassing ? 0 : 1;
+}
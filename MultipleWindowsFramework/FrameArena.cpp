@@ -0,0 +1,333 @@
+﻿//----------------------------------------------------------------------------------------------------
+// FrameArena.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "FrameArena.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+//----------------------------------------------------------------------------------------------------
+static size_t const FRAME_ARENA_MIN_BLOCK_SIZE = 64u << 10;
+static size_t const BUFFER_POOL_GRANULARITY    = 4u << 10;
+
+//----------------------------------------------------------------------------------------------------
+FrameArena::FrameArena(size_t const initialCapacity)
+{
+    if (initialCapacity > 0)
+    {
+        AddBlock(initialCapacity);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+FrameArena::~FrameArena()
+{
+    FreeBlocks();
+}
+
+//----------------------------------------------------------------------------------------------------
+void* FrameArena::Allocate(size_t const bytes, size_t const alignment)
+{
+    ++m_stats.allocationCount;
+
+    for (;;)
+    {
+        if (m_blockIndex == m_blocks.size())
+        {
+            AddBlock(bytes + alignment);
+        }
+
+        sBlock const&   block   = m_blocks[m_blockIndex];
+        uintptr_t const base    = (uintptr_t)block.memory;
+        size_t const    aligned = (size_t)(((base + m_offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base);
+
+        if (aligned + bytes <= block.size)
+        {
+            m_offset = aligned + bytes;
+
+            m_stats.bytesUsed     = m_usedBeforeBlock + m_offset;
+            m_stats.highWaterMark = (std::max)(m_stats.highWaterMark, m_stats.bytesUsed);
+            return block.memory + aligned;
+        }
+
+        // 剩餘空間不夠，改用下一個區塊 (沒有時新增)
+        m_usedBeforeBlock += block.size;
+        ++m_blockIndex;
+        m_offset = 0;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+void FrameArena::Rewind(sFrameArenaMarker const& marker)
+{
+    m_blockIndex      = marker.block;
+    m_offset          = marker.offset;
+    m_usedBeforeBlock = 0;
+    for (size_t i = 0; i < m_blockIndex && i < m_blocks.size(); ++i)
+    {
+        m_usedBeforeBlock += m_blocks[i].size;
+    }
+    m_stats.bytesUsed = m_usedBeforeBlock + m_offset;
+}
+
+//----------------------------------------------------------------------------------------------------
+void FrameArena::Reset()
+{
+    if (m_blocks.size() > 1)
+    {
+        size_t total = 0;
+        for (sBlock const& block : m_blocks)
+        {
+            total += block.size;
+        }
+        FreeBlocks();
+        AddBlock(total);
+    }
+
+    m_blockIndex      = 0;
+    m_offset          = 0;
+    m_usedBeforeBlock = 0;
+    m_stats.bytesUsed = 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+void FrameArena::AddBlock(size_t const minimumSize)
+{
+    // 每次至少加倍，單幀內需要的區塊數保持在對數級
+    size_t size = (std::max)(minimumSize, FRAME_ARENA_MIN_BLOCK_SIZE);
+    if (!m_blocks.empty())
+    {
+        size = (std::max)(size, m_blocks.back().size * 2);
+    }
+
+    sBlock block;
+    block.memory = new uint8_t[size];
+    block.size   = size;
+    m_blocks.push_back(block);
+
+    m_stats.capacity += size;
+    ++m_stats.heapAllocationCount;
+}
+
+//----------------------------------------------------------------------------------------------------
+void FrameArena::FreeBlocks()
+{
+    for (sBlock const& block : m_blocks)
+    {
+        delete[] block.memory;
+    }
+    m_blocks.clear();
+    m_stats.capacity = 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+BufferPool::Buffer::Buffer(Buffer&& other) noexcept
+    : m_pool(other.m_pool)
+    , m_data(other.m_data)
+    , m_size(other.m_size)
+    , m_capacity(other.m_capacity)
+{
+    other.m_pool     = nullptr;
+    other.m_data     = nullptr;
+    other.m_size     = 0;
+    other.m_capacity = 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+BufferPool::Buffer& BufferPool::Buffer::operator=(Buffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+        std::swap(m_pool, other.m_pool);
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        std::swap(m_capacity, other.m_capacity);
+    }
+    return *this;
+}
+
+//----------------------------------------------------------------------------------------------------
+void BufferPool::Buffer::Release()
+{
+    if (m_data)
+    {
+        m_pool->Return(m_data, m_capacity);
+    }
+    m_pool     = nullptr;
+    m_data     = nullptr;
+    m_size     = 0;
+    m_capacity = 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+BufferPool::BufferPool(size_t const maxCachedBytes)
+    : m_maxCachedBytes(maxCachedBytes)
+{
+    m_free.reserve(16);
+}
+
+//----------------------------------------------------------------------------------------------------
+BufferPool::~BufferPool()
+{
+    Trim();
+}
+
+//----------------------------------------------------------------------------------------------------
+BufferPool::Buffer BufferPool::Acquire(size_t const bytes)
+{
+    Buffer buffer;
+    if (bytes == 0) return buffer;
+
+    buffer.m_pool = this;
+    buffer.m_size = bytes;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.acquireCount;
+
+        // 最小的足夠大者；超過兩倍大的不拿來用，避免小需求佔住大緩衝區
+        size_t best = m_free.size();
+        for (size_t i = 0; i < m_free.size(); ++i)
+        {
+            size_t const capacity = m_free[i].capacity;
+            if (capacity < bytes || capacity / 2 > bytes) continue;
+            if (best == m_free.size() || capacity < m_free[best].capacity) best = i;
+        }
+
+        if (best != m_free.size())
+        {
+            buffer.m_data     = m_free[best].data;
+            buffer.m_capacity = m_free[best].capacity;
+            m_free[best]      = m_free.back();
+            m_free.pop_back();
+
+            m_stats.cachedBytes      -= buffer.m_capacity;
+            m_stats.outstandingBytes += buffer.m_capacity;
+            return buffer;
+        }
+
+        buffer.m_capacity = (bytes + BUFFER_POOL_GRANULARITY - 1) / BUFFER_POOL_GRANULARITY * BUFFER_POOL_GRANULARITY;
+        ++m_stats.heapAllocationCount;
+        m_stats.outstandingBytes += buffer.m_capacity;
+        m_stats.peakBytes         = (std::max)(m_stats.peakBytes, m_stats.outstandingBytes + m_stats.cachedBytes);
+    }
+
+    buffer.m_data = new uint8_t[buffer.m_capacity];
+    return buffer;
+}
+
+//----------------------------------------------------------------------------------------------------
+void BufferPool::Trim()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (sFreeBuffer const& buffer : m_free)
+    {
+        delete[] buffer.data;
+    }
+    m_free.clear();
+    m_stats.cachedBytes = 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+sBufferPoolStats BufferPool::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+//----------------------------------------------------------------------------------------------------
+void BufferPool::Return(uint8_t* const data, size_t const capacity)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.outstandingBytes -= capacity;
+
+        if (m_stats.cachedBytes + capacity <= m_maxCachedBytes)
+        {
+            m_free.push_back({data, capacity});
+            m_stats.cachedBytes += capacity;
+            return;
+        }
+    }
+    delete[] data;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 每個執行緒記住最後使用的 FrameMemory 與自己的 arena；編號不重複使用，已銷毀的物件不會誤判
+struct sThreadArenaCache
+{
+    uint64_t    ownerId = 0;
+    FrameArena* arena   = nullptr;
+};
+
+static std::atomic<uint64_t>         s_nextFrameMemoryId(1);
+static thread_local sThreadArenaCache s_threadArena;
+
+//----------------------------------------------------------------------------------------------------
+FrameMemory::FrameMemory()
+    : m_id(s_nextFrameMemoryId.fetch_add(1))
+{
+}
+
+//----------------------------------------------------------------------------------------------------
+FrameMemory::~FrameMemory() = default;
+
+//----------------------------------------------------------------------------------------------------
+FrameArena& FrameMemory::GetArena()
+{
+    if (s_threadArena.ownerId == m_id) return *s_threadArena.arena;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::thread::id const threadId = std::this_thread::get_id();
+    size_t                index    = 0;
+    while (index < m_arenaThreads.size() && m_arenaThreads[index] != threadId) ++index;
+
+    if (index == m_arenaThreads.size())
+    {
+        m_arenas.emplace_back(new FrameArena(FRAME_ARENA_MIN_BLOCK_SIZE));
+        m_arenaThreads.push_back(threadId);
+    }
+
+    s_threadArena.ownerId = m_id;
+    s_threadArena.arena   = m_arenas[index].get();
+    return *s_threadArena.arena;
+}
+
+//----------------------------------------------------------------------------------------------------
+void FrameMemory::EndFrame()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (std::unique_ptr<FrameArena> const& arena : m_arenas)
+    {
+        arena->Reset();
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+sFrameArenaStats FrameMemory::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    sFrameArenaStats total;
+    for (std::unique_ptr<FrameArena> const& arena : m_arenas)
+    {
+        sFrameArenaStats const& stats = arena->GetStats();
+        total.bytesUsed           += stats.bytesUsed;
+        total.highWaterMark       += stats.highWaterMark;
+        total.capacity            += stats.capacity;
+        total.allocationCount     += stats.allocationCount;
+        total.heapAllocationCount += stats.heapAllocationCount;
+    }
+    return total;
+}
+
+//----------------------------------------------------------------------------------------------------
+size_t FrameMemory::GetArenaCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_arenas.size();
+}
@@ -0,0 +1,189 @@
+﻿//----------------------------------------------------------------------------------------------------
+// FrameArena.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+struct sFrameArenaStats
+{
+    size_t             bytesUsed           = 0;     // 本幀目前使用量
+    size_t             highWaterMark       = 0;     // 單幀最大使用量
+    size_t             capacity            = 0;     // 已向系統取得的大小
+    unsigned long long allocationCount     = 0;     // 累計 Allocate 次數
+    unsigned long long heapAllocationCount = 0;     // 累計向系統要求區塊的次數，穩定後不再增加
+};
+
+struct sFrameArenaMarker
+{
+    size_t block  = 0;
+    size_t offset = 0;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 只往前推進的暫存配置器，整幀用完後 Reset 一次全部釋放；不呼叫解構子，只放 trivially destructible 的資料
+// 單一執行緒使用；工作執行緒請透過 FrameMemory::GetArena 取得自己的 arena
+class FrameArena
+{
+public:
+    explicit FrameArena(size_t initialCapacity = 0);
+    ~FrameArena();
+
+    FrameArena(FrameArena const&)            = delete;
+    FrameArena& operator=(FrameArena const&) = delete;
+
+    void* Allocate(size_t bytes, size_t alignment = 16);
+
+    template <typename T>
+    T* AllocateArray(size_t const count) { return static_cast<T*>(Allocate(count * sizeof(T), alignof(T))); }
+
+    // 退回到 marker 的位置，之後的配置全部失效 (迴圈內重複使用同一塊暫存)
+    sFrameArenaMarker GetMarker() const { return {m_blockIndex, m_offset}; }
+    void              Rewind(sFrameArenaMarker const& marker);
+
+    // 幀結束：曾經需要多個區塊時合併成一個足夠大的區塊，之後的幀不再向系統配置
+    void Reset();
+
+    sFrameArenaStats const& GetStats() const { return m_stats; }
+
+private:
+    struct sBlock
+    {
+        uint8_t* memory = nullptr;
+        size_t   size   = 0;
+    };
+
+    void AddBlock(size_t minimumSize);
+    void FreeBlocks();
+
+    std::vector<sBlock> m_blocks;
+    size_t              m_blockIndex      = 0;
+    size_t              m_offset          = 0;
+    size_t              m_usedBeforeBlock = 0;      // 目前區塊之前所有區塊的大小
+    sFrameArenaStats    m_stats;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 離開範圍時退回進入時的位置
+class FrameArenaScope
+{
+public:
+    explicit FrameArenaScope(FrameArena& arena) : m_arena(arena), m_marker(arena.GetMarker()) {}
+    ~FrameArenaScope() { m_arena.Rewind(m_marker); }
+
+    FrameArenaScope(FrameArenaScope const&)            = delete;
+    FrameArenaScope& operator=(FrameArenaScope const&) = delete;
+
+private:
+    FrameArena&       m_arena;
+    sFrameArenaMarker m_marker;
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sBufferPoolStats
+{
+    unsigned long long acquireCount        = 0;
+    unsigned long long heapAllocationCount = 0;     // 沒有可重用的緩衝區而向系統配置的次數
+    size_t             cachedBytes         = 0;     // 歸還後保留待用的大小
+    size_t             outstandingBytes    = 0;     // 借出中的大小
+    size_t             peakBytes           = 0;     // 借出 + 保留的最大值
+};
+
+//----------------------------------------------------------------------------------------------------
+// 重複出現的大型緩衝區 (解碼、上傳用)：歸還後保留，下次取用大小相近的緩衝區時直接重用
+// 執行緒安全；內容不會清除；所有緩衝區都要在池之前釋放
+class BufferPool
+{
+public:
+    class Buffer
+    {
+    public:
+        Buffer() = default;
+        Buffer(Buffer&& other) noexcept;
+        Buffer& operator=(Buffer&& other) noexcept;
+        ~Buffer() { Release(); }
+
+        void Release();
+
+        uint8_t* GetData() const { return m_data; }
+        size_t   GetSize() const { return m_size; }
+        bool     IsEmpty() const { return m_data == nullptr; }
+
+        template <typename T>
+        T* As() const { return reinterpret_cast<T*>(m_data); }
+
+    private:
+        friend class BufferPool;
+
+        BufferPool* m_pool     = nullptr;
+        uint8_t*    m_data     = nullptr;
+        size_t      m_size     = 0;
+        size_t      m_capacity = 0;
+    };
+
+    explicit BufferPool(size_t maxCachedBytes = 256u << 20);
+    ~BufferPool();
+
+    BufferPool(BufferPool const&)            = delete;
+    BufferPool& operator=(BufferPool const&) = delete;
+
+    // bytes 為 0 時回傳空的 Buffer
+    Buffer Acquire(size_t bytes);
+
+    // 釋放所有保留中的緩衝區
+    void Trim();
+
+    sBufferPoolStats GetStats() const;
+
+private:
+    struct sFreeBuffer
+    {
+        uint8_t* data;
+        size_t   capacity;
+    };
+
+    void Return(uint8_t* data, size_t capacity);
+
+    mutable std::mutex       m_mutex;
+    std::vector<sFreeBuffer> m_free;
+    size_t                   m_maxCachedBytes;
+    sBufferPoolStats         m_stats;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 每幀的暫存記憶體：每個執行緒各自一個 arena (第一次呼叫 GetArena 時建立，之後不需要鎖)，EndFrame 一起重設
+class FrameMemory
+{
+public:
+    FrameMemory();
+    ~FrameMemory();
+
+    FrameMemory(FrameMemory const&)            = delete;
+    FrameMemory& operator=(FrameMemory const&) = delete;
+
+    FrameArena& GetArena();
+
+    // 呼叫時其他執行緒不能正在使用自己的 arena (例如在 ParallelFor 之外)
+    void EndFrame();
+
+    // 所有 arena 的合計 (highWaterMark 為各自最大值的總和)
+    sFrameArenaStats GetStats() const;
+    size_t           GetArenaCount() const;
+
+    BufferPool&       GetBufferPool() { return m_bufferPool; }
+    BufferPool const& GetBufferPool() const { return m_bufferPool; }
+
+private:
+    mutable std::mutex                       m_mutex;
+    std::vector<std::unique_ptr<FrameArena>> m_arenas;
+    std::vector<std::thread::id>             m_arenaThreads;
+    uint64_t                                 m_id;
+    BufferPool                               m_bufferPool;
+};
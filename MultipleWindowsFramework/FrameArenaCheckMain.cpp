@@ -0,0 +1,379 @@
+﻿//----------------------------------------------------------------------------------------------------
+// FrameArenaCheckMain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// FrameArena / FrameMemory / BufferPool 的檢查 (不屬於 Windows 專案，在 Linux 上單獨編譯)：
+//
+//   g++ -std=c++14 -O2 -pthread FrameArenaCheckMain.cpp FrameArena.cpp -o frame_arena_check
+//   ./frame_arena_check [幀數]
+//
+// FrameArena：對齊、配置互不重疊、Rewind / FrameArenaScope 退回原位、跨多個區塊的一幀在 Reset 後合併成一塊
+// FrameMemory：每個執行緒各自一個 arena，不同的 FrameMemory 不共用
+// BufferPool：大小相近時重用、太小的需求不佔用大緩衝區、超過保留上限時釋放、Trim
+// 穩定狀態：主執行緒與三個工作執行緒每幀使用自己的 arena 並向 BufferPool 借還緩衝區，暖機後以替換的
+// operator new 計算所有執行緒向系統配置的次數，必須為 0。最後比較 arena 與 new / delete 的配置時間
+// 結束碼：0 = 全部通過，1 = 失敗
+//----------------------------------------------------------------------------------------------------
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "CheckMain.hpp"
+#include "FrameArena.hpp"
+
+//----------------------------------------------------------------------------------------------------
+// 所有執行緒的 operator new / new[] 都計算 (FrameArena 的區塊與 BufferPool 的緩衝區都經過 new[])
+static std::atomic<bool>               g_isCountingAllocations(false);
+static std::atomic<unsigned long long> g_allocationCount(0);
+
+static void* CountedAllocate(size_t const size)
+{
+    if (g_isCountingAllocations.load(std::memory_order_relaxed)) g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* const memory = malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t const size) { return CountedAllocate(size); }
+void* operator new[](size_t const size) { return CountedAllocate(size); }
+void  operator delete(void* const memory) noexcept { free(memory); }
+void  operator delete[](void* const memory) noexcept { free(memory); }
+void  operator delete(void* const memory, size_t) noexcept { free(memory); }
+void  operator delete[](void* const memory, size_t) noexcept { free(memory); }
+
+//----------------------------------------------------------------------------------------------------
+static bool CheckArena()
+{
+    uint32_t seed = 0xC0FFEEu;
+
+    // 隨機大小與對齊，每塊填入自己的編號，全部配置完後再檢查沒有互相覆蓋
+    FrameArena arena;
+    bool       isAligned  = true;
+    bool       isDisjoint = true;
+    for (int frame = 0; frame < 20; ++frame)
+    {
+        std::vector<std::pair<uint8_t*, size_t>> blocks;
+        for (int i = 0; i < 500; ++i)
+        {
+            size_t const   alignment = (size_t)1 << (NextRandom(seed) % 9);
+            size_t const   bytes     = NextRandom(seed) % (i % 50 == 0 ? 100000 : 2000);
+            uint8_t* const memory    = static_cast<uint8_t*>(arena.Allocate(bytes, alignment));
+
+            isAligned &= ((uintptr_t)memory & (alignment - 1)) == 0;
+            memset(memory, i & 0xFF, bytes);
+            blocks.push_back(std::make_pair(memory, bytes));
+        }
+        for (size_t i = 0; i < blocks.size(); ++i)
+        {
+            for (size_t j = 0; j < blocks[i].second; ++j)
+            {
+                isDisjoint &= blocks[i].first[j] == (uint8_t)(i & 0xFF);
+            }
+        }
+        arena.Reset();
+    }
+
+    // Rewind 之後同樣的配置拿到同一個位址；跨區塊後退回也一樣
+    FrameArena              rewound;
+    void* const             first  = rewound.Allocate(100);
+    sFrameArenaMarker const marker = rewound.GetMarker();
+    size_t const            used   = rewound.GetStats().bytesUsed;
+    void* const             second = rewound.Allocate(1000);
+    rewound.Allocate(1u << 20);
+    rewound.Allocate(3u << 20);
+    rewound.Rewind(marker);
+    bool         isRewound   = rewound.GetStats().bytesUsed == used && rewound.Allocate(1000) == second && first != second;
+    size_t const scopeMarker = rewound.GetStats().bytesUsed;
+    {
+        FrameArenaScope const scope(rewound);
+        rewound.Allocate(5u << 20);
+    }
+    isRewound &= rewound.GetStats().bytesUsed == scopeMarker;
+
+    // 這一幀用了多個區塊：Reset 合併成一塊，下一幀同樣的用量不再向系統配置
+    unsigned long long const blocksBefore = rewound.GetStats().heapAllocationCount;
+    size_t const             capacity     = rewound.GetStats().capacity;
+    rewound.Reset();
+    unsigned long long const blocksMerged = rewound.GetStats().heapAllocationCount;
+
+    rewound.Allocate(100);
+    rewound.Allocate(1000);
+    rewound.Allocate(1u << 20);
+    rewound.Allocate(3u << 20);
+    rewound.Allocate(5u << 20);
+    bool const isMerged = blocksBefore > 1 && blocksMerged == blocksBefore + 1 && rewound.GetStats().capacity == capacity &&
+                          rewound.GetStats().heapAllocationCount == blocksMerged && rewound.GetStats().bytesUsed <= capacity;
+
+    // 0 位元組也回傳對齊的有效位址
+    FrameArena  empty;
+    void* const zero        = empty.Allocate(0, 64);
+    bool const  isZeroValid = zero != nullptr && ((uintptr_t)zero & 63) == 0;
+
+    bool isPassing = true;
+    isPassing &= Check(isAligned, "arena_alignment");
+    isPassing &= Check(isDisjoint, "arena_disjoint");
+    isPassing &= Check(isRewound, "arena_rewind_and_scope");
+    isPassing &= Check(isMerged, "arena_reset_merges_blocks");
+    isPassing &= Check(isZeroValid, "arena_zero_size");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+static bool CheckFrameMemory()
+{
+    FrameMemory memory;
+    FrameMemory other;
+
+    FrameArena* mainArena   = &memory.GetArena();
+    FrameArena* otherArena  = &other.GetArena();
+    FrameArena* workerArena = nullptr;
+    FrameArena* workerAgain = nullptr;
+
+    std::thread worker([&] {
+        workerArena = &memory.GetArena();
+        other.GetArena();
+        workerAgain = &memory.GetArena();
+    });
+    worker.join();
+
+    bool const isPerThread = mainArena == &memory.GetArena() && workerArena == workerAgain && workerArena != mainArena &&
+                             otherArena != mainArena && memory.GetArenaCount() == 2 && other.GetArenaCount() == 2;
+
+    return Check(isPerThread, "memory_arena_per_thread");
+}
+
+//----------------------------------------------------------------------------------------------------
+static bool CheckBufferPool()
+{
+    BufferPool pool(1u << 20);
+
+    // 同樣大小歸還後重用；一半以上大小也重用
+    void* data = nullptr;
+    {
+        BufferPool::Buffer buffer = pool.Acquire(100000);
+        data                      = buffer.GetData();
+    }
+    BufferPool::Buffer reused  = pool.Acquire(60000);
+    bool               isReuse = reused.GetData() == data && reused.GetSize() == 60000 && pool.GetStats().heapAllocationCount == 1;
+    reused.Release();
+
+    // 小於一半的需求不佔用大緩衝區
+    BufferPool::Buffer small = pool.Acquire(1000);
+    isReuse &= small.GetData() != data && pool.GetStats().heapAllocationCount == 2;
+
+    // 移動後只歸還一次
+    BufferPool::Buffer moved = std::move(small);
+    isReuse &= small.IsEmpty() && !moved.IsEmpty();
+    moved.Release();
+    isReuse &= pool.GetStats().outstandingBytes == 0 && pool.Acquire(0).IsEmpty();
+
+    // 超過保留上限的緩衝區歸還時直接釋放
+    size_t const cachedBefore = pool.GetStats().cachedBytes;
+    {
+        BufferPool::Buffer large = pool.Acquire(2u << 20);
+    }
+    bool const isCapped = pool.GetStats().cachedBytes == cachedBefore;
+
+    pool.Trim();
+    bool const isTrimmed = pool.GetStats().cachedBytes == 0;
+
+    bool isPassing = true;
+    isPassing &= Check(isReuse, "pool_reuse");
+    isPassing &= Check(isCapped, "pool_cache_limit");
+    isPassing &= Check(isTrimmed, "pool_trim");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 一幀的工作量：數個場景大小的暫存、迴圈內重複使用的暫存，以及大小隨幀改變的小配置
+static void SimulateFrameWork(FrameArena& arena, BufferPool& pool, unsigned int const frame, unsigned int const threadIndex)
+{
+    // 前 30 幀用量逐漸增加，讓 arena 與緩衝池在暖機期間長到需要的大小
+    size_t const growth = frame < 30 ? 1 + frame / 6 : 6;
+
+    unsigned int const count = 20 + (frame * 7 + threadIndex) % 40;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        size_t const   bytes  = (1000 + ((frame * 31 + i * 17 + threadIndex) % 20) * 3000) * growth / 6;
+        uint8_t* const memory = arena.AllocateArray<uint8_t>(bytes);
+        memory[0]             = (uint8_t)i;
+        memory[bytes - 1]     = (uint8_t)i;
+
+        if (i % 5 == 0)
+        {
+            FrameArenaScope const scope(arena);
+            arena.Allocate(50000 * growth, 64);
+        }
+    }
+
+    // 解碼用的大型緩衝區，大小在一個範圍內變動
+    BufferPool::Buffer const buffer = pool.Acquire((size_t)(200 + (frame + threadIndex) % 50) * 1024 * growth / 6);
+    buffer.GetData()[0]             = 1;
+}
+
+static bool CheckSteadyState(unsigned int const frameCount)
+{
+    unsigned int const workerCount = 3;
+    unsigned int const warmupCount = (std::min)(frameCount / 2, 100u);
+
+    FrameMemory             memory;
+    std::mutex              mutex;
+    std::condition_variable frameChanged;
+    int                     frame     = -1;
+    unsigned int            doneCount = 0;
+    bool                    isQuit    = false;
+
+    // 工作執行緒每幀被喚醒一次，與 ParallelFor 的工作一樣只使用自己的 arena
+    std::vector<std::thread> workers;
+    for (unsigned int index = 1; index <= workerCount; ++index)
+    {
+        workers.emplace_back([&, index] {
+            int seen = -1;
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    frameChanged.wait(lock, [&] { return isQuit || frame != seen; });
+                    if (isQuit) return;
+                    seen = frame;
+                }
+
+                SimulateFrameWork(memory.GetArena(), memory.GetBufferPool(), (unsigned int)seen, index);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                ++doneCount;
+                frameChanged.notify_all();
+            }
+        });
+    }
+
+    sFrameArenaStats   warmStats;
+    unsigned long long warmPoolAllocations = 0;
+    for (unsigned int current = 0; current < frameCount; ++current)
+    {
+        if (current == warmupCount)
+        {
+            warmStats           = memory.GetStats();
+            warmPoolAllocations = memory.GetBufferPool().GetStats().heapAllocationCount;
+            g_isCountingAllocations.store(true);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            frame     = (int)current;
+            doneCount = 0;
+        }
+        frameChanged.notify_all();
+
+        SimulateFrameWork(memory.GetArena(), memory.GetBufferPool(), current, 0);
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            frameChanged.wait(lock, [&] { return doneCount == workerCount; });
+        }
+        memory.EndFrame();
+    }
+    g_isCountingAllocations.store(false);
+    unsigned long long const allocations = g_allocationCount.exchange(0);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isQuit = true;
+    }
+    frameChanged.notify_all();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    sFrameArenaStats const stats = memory.GetStats();
+    sBufferPoolStats const pool  = memory.GetBufferPool().GetStats();
+
+    printf("steady_frames %u\n", frameCount - warmupCount);
+    printf("steady_arenas %zu\n", memory.GetArenaCount());
+    printf("steady_arena_capacity %zu\n", stats.capacity);
+    printf("steady_arena_high_water %zu\n", stats.highWaterMark);
+    printf("steady_arena_allocations %llu\n", stats.allocationCount);
+    printf("steady_arena_heap_blocks %llu\n", stats.heapAllocationCount);
+    printf("steady_pool_acquires %llu\n", pool.acquireCount);
+    printf("steady_pool_heap_allocations %llu\n", pool.heapAllocationCount);
+    printf("steady_operator_new_calls %llu\n", allocations);
+
+    bool isPassing = true;
+    isPassing &= Check(memory.GetArenaCount() == workerCount + 1, "steady_arena_per_thread");
+    isPassing &= Check(stats.heapAllocationCount == warmStats.heapAllocationCount && pool.heapAllocationCount == warmPoolAllocations,
+                       "steady_stats_stable");
+    isPassing &= Check(allocations == 0, "steady_no_heap_allocations");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 基準：每幀數千個小配置，arena 與 new / delete 比較
+static void RunBenchmark()
+{
+    using Clock = std::chrono::steady_clock;
+
+    int const frameCount      = 200;
+    int const allocationCount = 5000;
+
+    FrameArena arena;
+    uint32_t   seed     = 42;
+    uint32_t   checksum = 0;
+
+    Clock::time_point start = Clock::now();
+    for (int frame = 0; frame < frameCount; ++frame)
+    {
+        for (int i = 0; i < allocationCount; ++i)
+        {
+            uint8_t* const memory = arena.AllocateArray<uint8_t>(16 + NextRandom(seed) % 240);
+            memory[0]             = (uint8_t)i;
+            checksum             += memory[0];
+        }
+        arena.Reset();
+    }
+    double const arenaNanoseconds = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ((double)frameCount * allocationCount);
+
+    std::vector<uint8_t*> pointers(allocationCount);
+    start = Clock::now();
+    for (int frame = 0; frame < frameCount; ++frame)
+    {
+        for (int i = 0; i < allocationCount; ++i)
+        {
+            pointers[i]     = new uint8_t[16 + NextRandom(seed) % 240];
+            pointers[i][0]  = (uint8_t)i;
+            checksum       += pointers[i][0];
+        }
+        for (uint8_t* const pointer : pointers)
+        {
+            delete[] pointer;
+        }
+    }
+    double const heapNanoseconds = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ((double)frameCount * allocationCount);
+
+    printf("benchmark_arena_ns_per_allocation %.2f\n", arenaNanoseconds);
+    printf("benchmark_new_delete_ns_per_allocation %.2f\n", heapNanoseconds);
+    printf("benchmark_speedup %.2f\n", heapNanoseconds / arenaNanoseconds);
+    printf("benchmark_checksum %u\n", checksum);
+}
+
+//----------------------------------------------------------------------------------------------------
+int main(int const argc, char** argv)
+{
+    unsigned int const frameCount = argc > 1 ? (std::max)(2u, (unsigned int)strtoul(argv[1], nullptr, 0)) : 2000u;
+
+    bool isPassing = true;
+    isPassing &= CheckArena();
+    isPassing &= CheckFrameMemory();
+    isPassing &= CheckBufferPool();
+    isPassing &= CheckSteadyState(frameCount);
+    RunBenchmark();
+    return isPassing ? 0 : 1;
+}
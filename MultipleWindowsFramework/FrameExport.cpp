@@ -0,0 +1,284 @@
+﻿//----------------------------------------------------------------------------------------------------
+// FrameExport.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "FrameExport.hpp"
+
+#include <cstring>
+#include <new>
+
+//----------------------------------------------------------------------------------------------------
+static size_t AlignUp(size_t const value, size_t const alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+//----------------------------------------------------------------------------------------------------
+static void CopyRows(uint8_t*       target,
+                     size_t const   targetPitch,
+                     uint8_t const* source,
+                     size_t const   sourcePitch,
+                     sRect const&   rect)
+{
+    size_t const offset   = (size_t)rect.left * 4;
+    size_t const rowBytes = (size_t)rect.GetWidth() * 4;
+
+    for (int y = rect.top; y < rect.bottom; ++y)
+    {
+        memcpy(target + (size_t)y * targetPitch + offset, source + (size_t)y * sourcePitch + offset, rowBytes);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+bool FrameExporter::Create(char const*        name,
+                           unsigned int const slotCount,
+                           unsigned int const maxWidth,
+                           unsigned int const maxHeight)
+{
+    Close();
+    if (slotCount == 0 || maxWidth == 0 || maxHeight == 0) return false;
+
+    size_t const pixelOffset = AlignUp(sizeof(sFrameExportSlot), 64);
+    size_t const slotSize    = AlignUp(pixelOffset + (size_t)maxWidth * maxHeight * 4, 64);
+    if (slotSize > 0xFFFFFFFF) return false;
+
+    if (!m_memory.Create(name, sizeof(sFrameExportHeader) + slotSize * slotCount)) return false;
+
+    m_header              = new (m_memory.GetData()) sFrameExportHeader();
+    m_header->version     = FRAME_EXPORT_VERSION;
+    m_header->slotCount   = slotCount;
+    m_header->maxWidth    = maxWidth;
+    m_header->maxHeight   = maxHeight;
+    m_header->slotSize    = (uint32_t)slotSize;
+    m_header->pixelOffset = (uint32_t)pixelOffset;
+    m_header->latestSlot.store(FRAME_EXPORT_NO_SLOT, std::memory_order_relaxed);
+
+    for (unsigned int slot = 0; slot < slotCount; ++slot)
+    {
+        sFrameExportSlot* const current = new (GetSlot(slot)) sFrameExportSlot();
+        current->sequence.store(0, std::memory_order_relaxed);
+    }
+
+    // magic 最後寫入，讀取端以此判斷初始化已完成
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->magic = FRAME_EXPORT_MAGIC;
+
+    m_frameNumber = 0;
+    m_slotHistory.assign(slotCount, sSlotHistory());
+    m_dirtyHistory.assign(slotCount, sFrameDirty());
+    m_stats = sFrameExporterStats();
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+void FrameExporter::Close()
+{
+    m_memory.Close();
+    m_header = nullptr;
+    m_slotHistory.clear();
+    m_dirtyHistory.clear();
+}
+
+//----------------------------------------------------------------------------------------------------
+unsigned long long FrameExporter::Publish(uint8_t const*     pixels,
+                                          unsigned int const width,
+                                          unsigned int const height,
+                                          unsigned int const pitch,
+                                          sRect const*       dirtyRects,
+                                          unsigned int const dirtyRectCount)
+{
+    if (!m_header || !pixels || width == 0 || height == 0) return 0;
+    if (width > m_header->maxWidth || height > m_header->maxHeight) return 0;
+
+    unsigned int const       slotCount   = m_header->slotCount;
+    unsigned long long const frameNumber = ++m_frameNumber;
+    unsigned int const       slotIndex   = (unsigned int)(frameNumber % slotCount);
+
+    // 記錄這一幀的改變區域；尺寸改變時整張都算改變
+    sFrameDirty&        dirty    = m_dirtyHistory[slotIndex];
+    sSlotHistory const& previous = m_slotHistory[(slotIndex + slotCount - 1) % slotCount];
+
+    dirty.isFullFrame = !dirtyRects || dirtyRectCount > FRAME_EXPORT_MAX_DIRTY_RECTS ||
+                        previous.width != width || previous.height != height;
+    dirty.rects.clear();
+    if (!dirty.isFullFrame)
+    {
+        sRect const bounds = {0, 0, (int)width, (int)height};
+        for (unsigned int i = 0; i < dirtyRectCount; ++i)
+        {
+            sRect const clipped = dirtyRects[i].Intersect(bounds);
+            if (!clipped.IsEmpty()) dirty.rects.push_back(clipped);
+        }
+    }
+
+    // 這個槽位上次寫入是 slotCount 幀之前，期間每一幀的改變都要補寫
+    sSlotHistory& history    = m_slotHistory[slotIndex];
+    bool          isFullCopy = history.frameNumber == 0 || history.width != width || history.height != height;
+    for (sFrameDirty const& recent : m_dirtyHistory)
+    {
+        isFullCopy = isFullCopy || recent.isFullFrame;
+    }
+
+    sFrameExportSlot* const slot       = GetSlot(slotIndex);
+    uint8_t* const          slotPixels = reinterpret_cast<uint8_t*>(slot) + m_header->pixelOffset;
+    size_t const            slotPitch  = (size_t)m_header->maxWidth * 4;
+
+    // seqlock：奇數表示寫入中，讀取端會放棄或重試
+    uint32_t const sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (isFullCopy)
+    {
+        CopyRows(slotPixels, slotPitch, pixels, pitch, {0, 0, (int)width, (int)height});
+        m_stats.bytesCopied += (unsigned long long)width * height * 4;
+        ++m_stats.fullCopies;
+    }
+    else
+    {
+        for (sFrameDirty const& recent : m_dirtyHistory)
+        {
+            for (sRect const& rect : recent.rects)
+            {
+                CopyRows(slotPixels, slotPitch, pixels, pitch, rect);
+                m_stats.bytesCopied += (unsigned long long)rect.GetArea() * 4;
+            }
+        }
+    }
+
+    slot->width          = width;
+    slot->height         = height;
+    slot->pitch          = (uint32_t)slotPitch;
+    slot->frameNumber    = frameNumber;
+    slot->isFullFrame    = dirty.isFullFrame ? 1 : 0;
+    slot->dirtyRectCount = (uint32_t)dirty.rects.size();
+    for (size_t i = 0; i < dirty.rects.size(); ++i)
+    {
+        sRect const& rect   = dirty.rects[i];
+        slot->dirtyRects[i] = {rect.left, rect.top, rect.right, rect.bottom};
+    }
+
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+    m_header->latestSlot.store(slotIndex, std::memory_order_release);
+
+    history.frameNumber = frameNumber;
+    history.width       = width;
+    history.height      = height;
+    ++m_stats.framesPublished;
+    return frameNumber;
+}
+
+//----------------------------------------------------------------------------------------------------
+sFrameExportSlot* FrameExporter::GetSlot(unsigned int const slot) const
+{
+    uint8_t* const slots = m_memory.GetData() + sizeof(sFrameExportHeader);
+    return reinterpret_cast<sFrameExportSlot*>(slots + (size_t)slot * m_header->slotSize);
+}
+
+//----------------------------------------------------------------------------------------------------
+bool FrameExportReader::Open(char const* name)
+{
+    Close();
+    if (!m_memory.Open(name, true)) return false;
+    if (m_memory.GetSize() < sizeof(sFrameExportHeader))
+    {
+        Close();
+        return false;
+    }
+
+    // 佈局由其他行程寫入，先確認所有大小都落在對應範圍內
+    sFrameExportHeader const* header = reinterpret_cast<sFrameExportHeader const*>(m_memory.GetData());
+    if (header->magic != FRAME_EXPORT_MAGIC || header->version != FRAME_EXPORT_VERSION)
+    {
+        Close();
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    size_t const pixelBytes = (size_t)header->maxWidth * header->maxHeight * 4;
+    bool const   isValid    = header->slotCount > 0 && header->maxWidth > 0 && header->maxHeight > 0 &&
+                              header->pixelOffset >= sizeof(sFrameExportSlot) &&
+                              header->slotSize >= header->pixelOffset + pixelBytes &&
+                              sizeof(sFrameExportHeader) + (size_t)header->slotSize * header->slotCount <= m_memory.GetSize();
+    if (!isValid)
+    {
+        Close();
+        return false;
+    }
+
+    m_header = header;
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+void FrameExportReader::Close()
+{
+    m_memory.Close();
+    m_header = nullptr;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool FrameExportReader::AcquireLatest(sFrameView& view) const
+{
+    if (!m_header) return false;
+
+    uint32_t const slotIndex = m_header->latestSlot.load(std::memory_order_acquire);
+    if (slotIndex >= m_header->slotCount) return false;
+
+    sFrameExportSlot const* const slot     = GetSlot(slotIndex);
+    uint32_t const                sequence = slot->sequence.load(std::memory_order_acquire);
+    if (sequence & 1) return false;         // 寫入端已經繞回這個槽位
+
+    view.width          = slot->width;
+    view.height         = slot->height;
+    view.pitch          = slot->pitch;
+    view.frameNumber    = slot->frameNumber;
+    view.isFullFrame    = slot->isFullFrame != 0;
+    view.dirtyRectCount = slot->dirtyRectCount;
+    view.dirtyRects     = slot->dirtyRects;
+    view.pixels         = reinterpret_cast<uint8_t const*>(slot) + m_header->pixelOffset;
+    view.slot           = slotIndex;
+    view.sequence       = sequence;
+
+    if (!Validate(view)) return false;
+
+    // 標頭一致之後才能相信尺寸
+    return view.width <= m_header->maxWidth && view.height <= m_header->maxHeight &&
+           view.pitch == m_header->maxWidth * 4 && view.dirtyRectCount <= FRAME_EXPORT_MAX_DIRTY_RECTS;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool FrameExportReader::Validate(sFrameView const& view) const
+{
+    if (!m_header || view.slot >= m_header->slotCount) return false;
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return GetSlot(view.slot)->sequence.load(std::memory_order_relaxed) == view.sequence;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool FrameExportReader::CopyLatest(std::vector<uint8_t>& pixels, sFrameView& view, int const maxAttempts) const
+{
+    for (int attempt = 0; attempt < maxAttempts; ++attempt)
+    {
+        if (!AcquireLatest(view)) continue;
+
+        size_t const rowBytes = (size_t)view.width * 4;
+        pixels.resize(rowBytes * view.height);
+        for (unsigned int y = 0; y < view.height; ++y)
+        {
+            memcpy(pixels.data() + y * rowBytes, view.pixels + (size_t)y * view.pitch, rowBytes);
+        }
+
+        if (Validate(view)) return true;
+    }
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------
+sFrameExportSlot const* FrameExportReader::GetSlot(unsigned int const slot) const
+{
+    uint8_t const* const slots = m_memory.GetData() + sizeof(sFrameExportHeader);
+    return reinterpret_cast<sFrameExportSlot const*>(slots + (size_t)slot * m_header->slotSize);
+}
@@ -0,0 +1,156 @@
+﻿//----------------------------------------------------------------------------------------------------
+// FrameExport.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "Region.hpp"
+#include "SharedMemory.hpp"
+
+//----------------------------------------------------------------------------------------------------
+// 共享記憶體中的佈局 (所有欄位為固定大小，讀取端可以是不同的行程)：
+//
+//   sFrameExportHeader | slot 0 | slot 1 | ... | slot N-1
+//   slot = sFrameExportSlot | 像素 (maxHeight 列，每列 maxWidth * 4 位元組)
+//
+// 每個槽位以 seqlock 保護：寫入前 sequence 變為奇數、寫完變為偶數
+// 讀取端在讀取前後比對 sequence，不同即表示讀到一半被覆寫，寫入端永遠不等待讀取端
+uint32_t const     FRAME_EXPORT_MAGIC           = 0x5246574D;   // "MWFR"
+uint32_t const     FRAME_EXPORT_VERSION         = 1;
+uint32_t const     FRAME_EXPORT_NO_SLOT         = 0xFFFFFFFF;
+unsigned int const FRAME_EXPORT_MAX_DIRTY_RECTS = 64;
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "跨行程的 seqlock 需要 lock-free 的 32 位元原子操作");
+
+//----------------------------------------------------------------------------------------------------
+struct sFrameExportRect
+{
+    int32_t left;
+    int32_t top;
+    int32_t right;
+    int32_t bottom;
+};
+
+//----------------------------------------------------------------------------------------------------
+struct alignas(64) sFrameExportHeader
+{
+    uint32_t              magic;
+    uint32_t              version;
+    uint32_t              slotCount;
+    uint32_t              maxWidth;
+    uint32_t              maxHeight;
+    uint32_t              slotSize;         // 每個槽位 (標頭 + 像素) 的位元組數
+    uint32_t              pixelOffset;      // 像素相對於槽位開頭的位移
+    std::atomic<uint32_t> latestSlot;       // 最新完成的槽位，尚未發布時為 FRAME_EXPORT_NO_SLOT
+};
+
+//----------------------------------------------------------------------------------------------------
+struct alignas(64) sFrameExportSlot
+{
+    std::atomic<uint32_t> sequence;         // seqlock：奇數 = 寫入中
+    uint32_t              width;
+    uint32_t              height;
+    uint32_t              pitch;            // 每列位元組數 (= maxWidth * 4)
+    uint64_t              frameNumber;      // 從 1 開始遞增
+    uint32_t              isFullFrame;      // 1 = 整張都可能改變，dirtyRects 無意義
+    uint32_t              dirtyRectCount;   // 與上一幀相比改變的區域
+    sFrameExportRect      dirtyRects[FRAME_EXPORT_MAX_DIRTY_RECTS];
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sFrameExporterStats
+{
+    unsigned long long framesPublished = 0;
+    unsigned long long fullCopies      = 0;
+    unsigned long long bytesCopied     = 0;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 寫入端：每幀寫入下一個槽位 (環狀)，不檢查也不等待讀取端
+// 只發布部分區域時，槽位上次寫入之後所有幀的改變區域都會補寫，所以每個槽位都是完整的畫面
+class FrameExporter
+{
+public:
+    bool Create(char const* name, unsigned int slotCount, unsigned int maxWidth, unsigned int maxHeight);
+    void Close();
+    bool IsOpen() const { return m_memory.IsOpen(); }
+
+    // dirtyRects 為 nullptr 表示整張更新；回傳這一幀的編號，失敗時回傳 0
+    unsigned long long Publish(uint8_t const* pixels,
+                               unsigned int   width,
+                               unsigned int   height,
+                               unsigned int   pitch,
+                               sRect const*   dirtyRects     = nullptr,
+                               unsigned int   dirtyRectCount = 0);
+
+    sFrameExporterStats const& GetStats() const { return m_stats; }
+
+private:
+    // 寫入端自己記錄的槽位狀態，不放在共享記憶體
+    struct sSlotHistory
+    {
+        unsigned long long frameNumber = 0; // 0 = 從未寫入
+        unsigned int       width       = 0;
+        unsigned int       height      = 0;
+    };
+
+    // 最近幾幀的改變區域，用來補寫較舊的槽位
+    struct sFrameDirty
+    {
+        bool               isFullFrame = true;
+        std::vector<sRect> rects;
+    };
+
+    sFrameExportSlot* GetSlot(unsigned int slot) const;
+
+    SharedMemory              m_memory;
+    sFrameExportHeader*       m_header      = nullptr;
+    unsigned long long        m_frameNumber = 0;
+    std::vector<sSlotHistory> m_slotHistory;
+    std::vector<sFrameDirty>  m_dirtyHistory;           // 以幀編號 % slotCount 索引
+    sFrameExporterStats       m_stats;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 讀取端看到的一幀；pixels 直接指向共享記憶體
+struct sFrameView
+{
+    uint8_t const*          pixels         = nullptr;
+    unsigned int            width          = 0;
+    unsigned int            height         = 0;
+    unsigned int            pitch          = 0;
+    unsigned long long      frameNumber    = 0;
+    bool                    isFullFrame    = true;
+    sFrameExportRect const* dirtyRects     = nullptr;
+    unsigned int            dirtyRectCount = 0;
+
+    unsigned int slot     = FRAME_EXPORT_NO_SLOT;
+    uint32_t     sequence = 0;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 讀取端：不取得任何鎖，也不寫入共享記憶體
+class FrameExportReader
+{
+public:
+    bool Open(char const* name);
+    void Close();
+    bool IsOpen() const { return m_header != nullptr; }
+
+    // 取得最新完成的一幀但不複製；寫入端隨時可能覆寫該槽位，使用完內容後需以 Validate 確認
+    bool AcquireLatest(sFrameView& view) const;
+    bool Validate(sFrameView const& view) const;
+
+    // 複製最新的一幀；讀取途中被覆寫時重試
+    bool CopyLatest(std::vector<uint8_t>& pixels, sFrameView& view, int maxAttempts = 4) const;
+
+private:
+    sFrameExportSlot const* GetSlot(unsigned int slot) const;
+
+    SharedMemory              m_memory;
+    sFrameExportHeader const* m_header = nullptr;
+};
@@ -0,0 +1,285 @@
+﻿//----------------------------------------------------------------------------------------------------
+// FrameExportCheckMain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// 共享記憶體幀匯出的多行程 seqlock 壓力測試 (不屬於 Windows 專案，在 Linux 上單獨編譯)：
+//
+//   g++ -std=c++14 -O2 FrameExportCheckMain.cpp FrameExport.cpp SharedMemory.cpp Region.cpp -lrt -o frame_export_check
+//   ./frame_export_check [每種模式的秒數]
+//
+// 寫入端 (本行程) 不停發布，三個 fork 出來的讀取行程同時讀取：
+//   - 讀取行程 0 以 AcquireLatest 直接讀共享記憶體，讀到不一致的內容時 Validate 必須回傳 false
+//   - 讀取行程 1、2 以 CopyLatest 複製，每一份被接受的複本都必須與該幀的內容逐像素相同
+//   - 每個讀取行程看到的幀編號不會倒退
+// 整張模式每幀的像素都是幀編號，寬高也隨幀編號改變；部分更新模式每幀只改一個由幀編號決定的矩形，
+// 讀取端抽樣檢查每個像素是最後一次覆蓋它的幀編號 (補寫舊槽位的正確性)
+// 結束碼：0 = 全部通過，1 = 失敗
+//----------------------------------------------------------------------------------------------------
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "CheckMain.hpp"
+#include "FrameExport.hpp"
+
+//----------------------------------------------------------------------------------------------------
+static char const* const  EXPORT_NAME  = "mwf_frame_export_check";
+static unsigned int const MAX_WIDTH    = 320;
+static unsigned int const MAX_HEIGHT   = 200;
+static unsigned int const SLOT_COUNT   = 3;
+static int const          READER_COUNT = 3;
+
+// 讀取行程的結束碼
+enum eReaderResult
+{
+    READER_OK            = 0,
+    READER_WENT_BACK     = 2,
+    READER_BAD_PIXELS    = 3,
+    READER_TORN_ACCEPTED = 4,
+    READER_NO_FRAMES     = 5,
+    READER_OPEN_FAILED   = 6
+};
+
+//----------------------------------------------------------------------------------------------------
+// 整張模式：寬高隨幀編號改變 (不超過最大值)
+static unsigned int GetFullWidth(unsigned long long const frame) { return MAX_WIDTH - (unsigned int)(frame % 16); }
+static unsigned int GetFullHeight(unsigned long long const frame) { return MAX_HEIGHT - (unsigned int)(frame % 8); }
+
+// 部分更新模式：第 1 幀為整張，之後每幀改變一個由幀編號決定的矩形
+static sRect GetDirtyRect(unsigned long long const frame)
+{
+    if (frame == 1) return {0, 0, (int)MAX_WIDTH, (int)MAX_HEIGHT};
+
+    uint32_t const hash = (uint32_t)(frame * 2654435761u);
+    int const      x    = (int)(hash % MAX_WIDTH);
+    int const      y    = (int)((hash >> 9) % MAX_HEIGHT);
+    return {x, y, (std::min)((int)MAX_WIDTH, x + 1 + (int)((hash >> 17) % 80)), (std::min)((int)MAX_HEIGHT, y + 1 + (int)((hash >> 24) % 60))};
+}
+
+// 第 frame 幀時 (x, y) 的值：最後一個覆蓋它的幀編號
+static uint32_t GetDirtyPixel(unsigned long long const frame, int const x, int const y)
+{
+    for (unsigned long long k = frame; k > 1; --k)
+    {
+        sRect const rect = GetDirtyRect(k);
+        if (x >= rect.left && x < rect.right && y >= rect.top && y < rect.bottom) return (uint32_t)k;
+    }
+    return 1;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 讀取行程 0：不複製，讀完整個畫面後才 Validate；內容不一致卻通過驗證即為 seqlock 失效
+static int RunZeroCopyReader(FrameExportReader const& reader, bool const isDirtyMode, double const seconds, unsigned long long counts[4])
+{
+    using Clock = std::chrono::steady_clock;
+
+    unsigned long long      lastFrame = 0;
+    sFrameView              view;
+    Clock::time_point const start     = Clock::now();
+    while (std::chrono::duration<double>(Clock::now() - start).count() < seconds)
+    {
+        if (!reader.AcquireLatest(view))
+        {
+            ++counts[1];
+            continue;
+        }
+
+        // 整張模式：所有像素都必須等於幀編號；部分更新模式：抽樣
+        bool isConsistent = true;
+        for (unsigned int y = 0; y < view.height; ++y)
+        {
+            uint32_t const* row = reinterpret_cast<uint32_t const*>(view.pixels + (size_t)y * view.pitch);
+            for (unsigned int x = 0; x < view.width; ++x)
+            {
+                if (isDirtyMode)
+                {
+                    if ((x * 7 + y * 13) % 97 != 0) continue;
+                    isConsistent &= row[x] == GetDirtyPixel(view.frameNumber, (int)x, (int)y);
+                }
+                else
+                {
+                    isConsistent &= row[x] == (uint32_t)view.frameNumber;
+                }
+            }
+        }
+
+        if (!reader.Validate(view))
+        {
+            ++counts[1];
+            if (!isConsistent) ++counts[3];
+            continue;
+        }
+        if (!isConsistent) return READER_TORN_ACCEPTED;
+        if (view.frameNumber < lastFrame) return READER_WENT_BACK;
+        if (!isDirtyMode && (view.width != GetFullWidth(view.frameNumber) || view.height != GetFullHeight(view.frameNumber))) return READER_BAD_PIXELS;
+
+        lastFrame = view.frameNumber;
+        ++counts[0];
+    }
+    counts[2] = lastFrame;
+    return counts[0] > 0 ? READER_OK : READER_NO_FRAMES;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 讀取行程 1、2：每份被接受的複本都逐像素檢查 (部分更新模式抽樣)
+static int RunCopyReader(FrameExportReader const& reader, bool const isDirtyMode, double const seconds, unsigned long long counts[4])
+{
+    using Clock = std::chrono::steady_clock;
+
+    unsigned long long      lastFrame = 0;
+    std::vector<uint8_t>    pixels;
+    sFrameView              view;
+    Clock::time_point const start     = Clock::now();
+    while (std::chrono::duration<double>(Clock::now() - start).count() < seconds)
+    {
+        if (!reader.CopyLatest(pixels, view))
+        {
+            ++counts[1];
+            continue;
+        }
+        if (view.frameNumber < lastFrame) return READER_WENT_BACK;
+
+        uint32_t const* copy = reinterpret_cast<uint32_t const*>(pixels.data());
+        if (isDirtyMode)
+        {
+            if (view.width != MAX_WIDTH || view.height != MAX_HEIGHT) return READER_BAD_PIXELS;
+            for (int sample = 0; sample < 64; ++sample)
+            {
+                int const x = (int)((sample * 37 + view.frameNumber) % MAX_WIDTH);
+                int const y = (int)((sample * 53 + view.frameNumber * 3) % MAX_HEIGHT);
+                if (copy[(size_t)y * MAX_WIDTH + x] != GetDirtyPixel(view.frameNumber, x, y)) return READER_BAD_PIXELS;
+            }
+            if (!view.isFullFrame && view.dirtyRectCount != 1) return READER_BAD_PIXELS;
+        }
+        else
+        {
+            if (view.width != GetFullWidth(view.frameNumber) || view.height != GetFullHeight(view.frameNumber)) return READER_BAD_PIXELS;
+            for (size_t i = 0; i < (size_t)view.width * view.height; ++i)
+            {
+                if (copy[i] != (uint32_t)view.frameNumber) return READER_BAD_PIXELS;
+            }
+        }
+
+        lastFrame = view.frameNumber;
+        ++counts[0];
+    }
+    counts[2] = lastFrame;
+    return counts[0] > 0 ? READER_OK : READER_NO_FRAMES;
+}
+
+//----------------------------------------------------------------------------------------------------
+static bool RunMode(bool const isDirtyMode, double const seconds)
+{
+    using Clock = std::chrono::steady_clock;
+
+    char const* const mode = isDirtyMode ? "dirty" : "full";
+
+    FrameExporter exporter;
+    FrameExporter duplicate;
+    bool const    isCreated   = exporter.Create(EXPORT_NAME, SLOT_COUNT, MAX_WIDTH, MAX_HEIGHT);
+    bool const    isExclusive = !duplicate.Create(EXPORT_NAME, SLOT_COUNT, MAX_WIDTH, MAX_HEIGHT);
+    if (!isCreated) return Check(false, isDirtyMode ? "dirty_create" : "full_create");
+
+    // 還沒有任何一幀時讀取失敗
+    FrameExportReader emptyReader;
+    sFrameView        emptyView;
+    bool const        isEmpty = emptyReader.Open(EXPORT_NAME) && !emptyReader.AcquireLatest(emptyView);
+    emptyReader.Close();
+
+    fflush(stdout);
+    std::vector<pid_t> readers;
+    for (int index = 0; index < READER_COUNT; ++index)
+    {
+        pid_t const pid = fork();
+        if (pid == 0)
+        {
+            FrameExportReader reader;
+            if (!reader.Open(EXPORT_NAME)) _exit(READER_OPEN_FAILED);
+
+            unsigned long long counts[4] = {0, 0, 0, 0};    // 接受的幀、重試、最後的幀編號、被 Validate 擋下的不一致內容
+            int const          result    = index == 0 ? RunZeroCopyReader(reader, isDirtyMode, seconds, counts)
+                                                      : RunCopyReader(reader, isDirtyMode, seconds, counts);
+
+            printf("%s_reader%d_frames %llu\n", mode, index, counts[0]);
+            printf("%s_reader%d_retries %llu\n", mode, index, counts[1]);
+            printf("%s_reader%d_last_frame %llu\n", mode, index, counts[2]);
+            if (index == 0) printf("%s_reader%d_torn_rejected %llu\n", mode, index, counts[3]);
+            fflush(stdout);
+            _exit(result);
+        }
+        readers.push_back(pid);
+    }
+
+    // 寫入端比讀取端多跑一點時間，讀取端結束前一直有新的幀
+    std::vector<uint32_t>   scene((size_t)MAX_WIDTH * MAX_HEIGHT, 0);
+    unsigned long long      frame       = 0;
+    bool                    isPublished = true;
+    Clock::time_point const start       = Clock::now();
+    while (std::chrono::duration<double>(Clock::now() - start).count() < seconds + 0.2)
+    {
+        ++frame;
+        uint8_t const* const pixels = reinterpret_cast<uint8_t const*>(scene.data());
+        if (isDirtyMode)
+        {
+            sRect const rect = GetDirtyRect(frame);
+            for (int y = rect.top; y < rect.bottom; ++y)
+            {
+                std::fill(scene.begin() + (size_t)y * MAX_WIDTH + rect.left, scene.begin() + (size_t)y * MAX_WIDTH + rect.right, (uint32_t)frame);
+            }
+            isPublished &= exporter.Publish(pixels, MAX_WIDTH, MAX_HEIGHT, MAX_WIDTH * 4, frame == 1 ? nullptr : &rect, frame == 1 ? 0 : 1) == frame;
+        }
+        else
+        {
+            std::fill(scene.begin(), scene.end(), (uint32_t)frame);
+            isPublished &= exporter.Publish(pixels, GetFullWidth(frame), GetFullHeight(frame), MAX_WIDTH * 4) == frame;
+        }
+    }
+
+    bool isReadersPassing = true;
+    for (pid_t const pid : readers)
+    {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        bool const isOk = WIFEXITED(status) && WEXITSTATUS(status) == READER_OK;
+        if (!isOk) printf("%s_reader_status %d\n", mode, WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+        isReadersPassing &= isOk;
+    }
+
+    sFrameExporterStats const& stats = exporter.GetStats();
+    printf("%s_frames_published %llu\n", mode, stats.framesPublished);
+    printf("%s_full_copies %llu\n", mode, stats.fullCopies);
+    printf("%s_megabytes_copied %.1f\n", mode, stats.bytesCopied / 1048576.0);
+
+    std::string const prefix = mode;
+
+    bool isPassing = true;
+    isPassing &= Check(isExclusive, (prefix + "_create_exclusive").c_str());
+    isPassing &= Check(isEmpty, (prefix + "_empty_before_publish").c_str());
+    isPassing &= Check(isPublished && stats.framesPublished == frame, (prefix + "_publish").c_str());
+    isPassing &= Check(isReadersPassing, (prefix + "_readers").c_str());
+    if (isDirtyMode)
+    {
+        // 部分更新只有第一幀與補寫時需要整張複製
+        isPassing &= Check(stats.fullCopies <= SLOT_COUNT && stats.bytesCopied < stats.framesPublished * MAX_WIDTH * MAX_HEIGHT * 4 / 4,
+                           "dirty_copies_reduced");
+    }
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+int main(int const argc, char** argv)
+{
+    double const seconds = argc > 1 ? atof(argv[1]) : 2.0;
+
+    bool isPassing = true;
+    isPassing &= RunMode(false, seconds);
+    isPassing &= RunMode(true, seconds);
+    return isPassing ? 0 : 1;
+}
@@ -0,0 +1,423 @@
+﻿//----------------------------------------------------------------------------------------------------
+// FrameRecorder.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "FrameRecorder.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+//----------------------------------------------------------------------------------------------------
+static size_t const   RLE_MIN_RUN   = 3;    // 更短的重複以原始字組存放較省空間
+static uint32_t const RLE_RUN_FLAG  = 0x80000000;
+static uint32_t const RLE_MAX_COUNT = 0x7FFFFFFF;
+
+//----------------------------------------------------------------------------------------------------
+static FILE* OpenFile(char const* path, char const* mode)
+{
+#if defined(_MSC_VER)
+    FILE* file = nullptr;
+    return fopen_s(&file, path, mode) == 0 ? file : nullptr;
+#else
+    return fopen(path, mode);
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------
+static inline uint8_t ClampToByte(int const value)
+{
+    return (uint8_t)(std::max)(0, (std::min)(255, value));
+}
+
+//----------------------------------------------------------------------------------------------------
+static inline uint32_t GetDeltaWord(uint32_t const* current, uint32_t const* previous, size_t const index)
+{
+    return previous ? (current[index] ^ previous[index]) : current[index];
+}
+
+//----------------------------------------------------------------------------------------------------
+void EncodeDeltaRle(uint32_t const*        current,
+                    uint32_t const*        previous,
+                    size_t const           count,
+                    std::vector<uint32_t>& encoded)
+{
+    encoded.clear();
+
+    size_t literalStart = 0;
+    size_t index        = 0;
+
+    auto const flushLiterals = [&](size_t const end)
+    {
+        while (literalStart < end)
+        {
+            size_t const length = (std::min)(end - literalStart, (size_t)RLE_MAX_COUNT);
+            encoded.push_back((uint32_t)length);
+            for (size_t i = literalStart; i < literalStart + length; ++i)
+            {
+                encoded.push_back(GetDeltaWord(current, previous, i));
+            }
+            literalStart += length;
+        }
+    };
+
+    while (index < count)
+    {
+        uint32_t const value = GetDeltaWord(current, previous, index);
+        size_t         end   = index + 1;
+        while (end < count && end - index < RLE_MAX_COUNT && GetDeltaWord(current, previous, end) == value)
+        {
+            ++end;
+        }
+
+        if (end - index >= RLE_MIN_RUN)
+        {
+            flushLiterals(index);
+            encoded.push_back(RLE_RUN_FLAG | (uint32_t)(end - index));
+            encoded.push_back(value);
+            literalStart = end;
+        }
+        index = end;
+    }
+    flushLiterals(count);
+}
+
+//----------------------------------------------------------------------------------------------------
+bool DecodeDeltaRle(uint32_t const* encoded,
+                    size_t const    encodedCount,
+                    uint32_t const* previous,
+                    uint32_t*       output,
+                    size_t const    count)
+{
+    size_t read    = 0;
+    size_t written = 0;
+
+    while (read < encodedCount)
+    {
+        uint32_t const control = encoded[read++];
+        size_t const   length  = control & RLE_MAX_COUNT;
+        if (length == 0 || length > count - written) return false;
+
+        if (control & RLE_RUN_FLAG)
+        {
+            if (read >= encodedCount) return false;
+            uint32_t const value = encoded[read++];
+            std::fill(output + written, output + written + length, value);
+        }
+        else
+        {
+            if (length > encodedCount - read) return false;
+            memcpy(output + written, encoded + read, length * 4);
+            read += length;
+        }
+        written += length;
+    }
+    if (written != count) return false;
+
+    if (previous)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            output[i] ^= previous[i];
+        }
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+FrameRecorder::~FrameRecorder()
+{
+    Stop();
+}
+
+//----------------------------------------------------------------------------------------------------
+bool FrameRecorder::Start(sFrameRecorderDesc const& desc)
+{
+    Stop();
+
+    m_file = OpenFile(desc.path.c_str(), "wb");
+    if (!m_file) return false;
+
+    m_desc             = desc;
+    m_desc.bufferCount = (std::max)(1u, m_desc.bufferCount);
+    m_startTime        = std::chrono::steady_clock::now();
+
+    m_frames.resize(m_desc.bufferCount);
+    m_freeFrames.clear();
+    for (unsigned int i = 0; i < m_desc.bufferCount; ++i)
+    {
+        m_frames[i].pixels.resize(m_desc.frameBytes);
+        m_frames[i].windowRects.clear();
+        m_freeFrames.push_back(i);
+    }
+    m_queue.assign(m_desc.bufferCount, 0);
+    m_queueHead   = 0;
+    m_queueCount  = 0;
+    m_frameNumber = 0;
+    m_isStopping  = false;
+    m_stats       = sFrameRecorderStats();
+
+    m_previousPixels.clear();
+    m_previousWidth  = 0;
+    m_previousHeight = 0;
+    m_framesSinceKey = 0;
+    m_y4mWidth       = 0;
+    m_y4mHeight      = 0;
+    m_frameBytes     = 0;
+
+    if (m_desc.format == eRecordFormat::Raw)
+    {
+        sRecordFileHeader const header = {RECORD_FILE_MAGIC, RECORD_FILE_VERSION};
+        if (!Write(&header, sizeof(header)))
+        {
+            fclose(m_file);
+            m_file = nullptr;
+            return false;
+        }
+        m_stats.bytesWritten = m_frameBytes;
+    }
+
+    m_worker = std::thread(&FrameRecorder::WorkerMain, this);
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+void FrameRecorder::Stop()
+{
+    if (!m_file) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopping = true;
+    }
+    m_frameAvailable.notify_all();
+    m_worker.join();
+
+    fclose(m_file);
+    m_file = nullptr;
+
+    m_frames.clear();
+    m_freeFrames.clear();
+    m_queue.clear();
+    m_previousPixels = std::vector<uint8_t>();
+}
+
+//----------------------------------------------------------------------------------------------------
+bool FrameRecorder::SubmitFrame(std::vector<uint8_t>& pixels,
+                                unsigned int const    width,
+                                unsigned int const    height,
+                                sRect const*          windowRects,
+                                unsigned int const    windowRectCount)
+{
+    if (!m_file || width == 0 || height == 0 || pixels.size() < (size_t)width * height * 4) return false;
+
+    unsigned long long const timestamp = (unsigned long long)std::chrono::duration_cast<std::chrono::microseconds>(
+                                             std::chrono::steady_clock::now() - m_startTime).count();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    ++m_stats.framesSubmitted;
+    unsigned long long const frameNumber = ++m_frameNumber;
+
+    if (m_freeFrames.empty())
+    {
+        // 背景執行緒還沒寫完，依策略丟幀，不等待
+        if (m_desc.dropPolicy == eRecordDropPolicy::DropNewest || m_queueCount == 0)
+        {
+            ++m_stats.framesDropped;
+            return false;
+        }
+        m_freeFrames.push_back(m_queue[m_queueHead]);
+        m_queueHead = (m_queueHead + 1) % m_desc.bufferCount;
+        --m_queueCount;
+        ++m_stats.framesDropped;
+    }
+
+    unsigned int const frameIndex = m_freeFrames.back();
+    m_freeFrames.pop_back();
+    sQueuedFrame& frame = m_frames[frameIndex];
+
+    // 沒有預先配置時，空閒緩衝區第一次使用才配置；之後只在幀的大小改變時調整
+    frame.pixels.resize(pixels.size());
+    frame.pixels.swap(pixels);
+
+    frame.width                 = width;
+    frame.height                = height;
+    frame.frameNumber           = frameNumber;
+    frame.timestampMicroseconds = timestamp;
+
+    // 窗口區域沿用這一幀上次的容量，窗口數不增加時不配置
+    frame.windowRects.clear();
+    for (unsigned int i = 0; i < windowRectCount; ++i)
+    {
+        sRect const& rect = windowRects[i];
+        frame.windowRects.push_back({rect.left, rect.top, rect.right, rect.bottom});
+    }
+
+    m_queue[(m_queueHead + m_queueCount) % m_desc.bufferCount] = frameIndex;
+    ++m_queueCount;
+    m_stats.queueHighWater = (std::max)(m_stats.queueHighWater, m_queueCount);
+    lock.unlock();
+
+    m_frameAvailable.notify_one();
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+sFrameRecorderStats FrameRecorder::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+//----------------------------------------------------------------------------------------------------
+void FrameRecorder::WorkerMain()
+{
+    for (;;)
+    {
+        unsigned int frameIndex = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_frameAvailable.wait(lock, [this] { return m_isStopping || m_queueCount > 0; });
+
+            // 停止時仍寫完已排隊的幀
+            if (m_queueCount == 0) return;
+
+            frameIndex  = m_queue[m_queueHead];
+            m_queueHead = (m_queueHead + 1) % m_desc.bufferCount;
+            --m_queueCount;
+        }
+
+        // 取出的幀不在空閒堆疊也不在佇列中，Render 不會碰它
+        sQueuedFrame& frame = m_frames[frameIndex];
+
+        m_frameBytes         = 0;
+        bool const isWritten = WriteFrame(frame);
+
+        // 寫完的幀成為下一幀 DeltaRle 的參考，換下來的舊參考幀回到空閒池
+        if (isWritten && m_desc.format == eRecordFormat::Raw && m_desc.compression == eRecordCompression::DeltaRle)
+        {
+            m_previousPixels.swap(frame.pixels);
+            m_previousWidth  = frame.width;
+            m_previousHeight = frame.height;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_freeFrames.push_back(frameIndex);
+        if (isWritten)
+        {
+            ++m_stats.framesWritten;
+            m_stats.bytesWritten += m_frameBytes;
+        }
+        else
+        {
+            m_stats.hasWriteError = true;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+bool FrameRecorder::WriteFrame(sQueuedFrame const& frame)
+{
+    if (m_desc.format == eRecordFormat::Y4M) return WriteY4MFrame(frame);
+    return WriteRawFrame(frame);
+}
+
+//----------------------------------------------------------------------------------------------------
+bool FrameRecorder::WriteRawFrame(sQueuedFrame const& frame)
+{
+    size_t const          pixelCount = (size_t)frame.width * frame.height;
+    uint32_t const* const pixels     = reinterpret_cast<uint32_t const*>(frame.pixels.data());
+
+    sRecordFrameHeader header    = {};
+    header.frameNumber           = frame.frameNumber;
+    header.timestampMicroseconds = frame.timestampMicroseconds;
+    header.width                 = frame.width;
+    header.height                = frame.height;
+    header.windowCount           = (uint32_t)frame.windowRects.size();
+
+    void const* payload = pixels;
+    header.encoding     = RECORD_ENCODING_RAW;
+    header.payloadBytes = (uint32_t)(pixelCount * 4);
+
+    if (m_desc.compression == eRecordCompression::DeltaRle)
+    {
+        // 尺寸改變或到了關鍵幀間隔時不參考上一幀
+        bool const isKeyframe = m_previousWidth != frame.width || m_previousHeight != frame.height ||
+                                m_framesSinceKey + 1 >= m_desc.keyframeInterval;
+        uint32_t const* const previous = isKeyframe ? nullptr : reinterpret_cast<uint32_t const*>(m_previousPixels.data());
+
+        EncodeDeltaRle(pixels, previous, pixelCount, m_encoded);
+        m_framesSinceKey = isKeyframe ? 0 : m_framesSinceKey + 1;
+
+        // 壓縮後反而變大時直接寫原始像素
+        if (m_encoded.size() < pixelCount)
+        {
+            payload             = m_encoded.data();
+            header.encoding     = isKeyframe ? RECORD_ENCODING_RLE : RECORD_ENCODING_DELTA_RLE;
+            header.payloadBytes = (uint32_t)(m_encoded.size() * 4);
+        }
+    }
+
+    return Write(&header, sizeof(header)) &&
+           Write(frame.windowRects.data(), frame.windowRects.size() * sizeof(sRecordRect)) &&
+           Write(payload, header.payloadBytes);
+}
+
+//----------------------------------------------------------------------------------------------------
+// BT.601 full range，場景緩衝區為 RGBA8 (R 在最低位元組)
+bool FrameRecorder::WriteY4MFrame(sQueuedFrame const& frame)
+{
+    if (m_y4mWidth == 0)
+    {
+        m_y4mWidth  = frame.width;
+        m_y4mHeight = frame.height;
+
+        char header[128];
+        int const length = snprintf(header, sizeof(header), "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C444\n",
+                                    m_y4mWidth, m_y4mHeight, (std::max)(1u, m_desc.frameRate));
+        if (length <= 0 || !Write(header, (size_t)length)) return false;
+    }
+
+    // Y4M 的尺寸固定，動態解析度改變後的幀裁切或補黑
+    size_t const planeSize = (size_t)m_y4mWidth * m_y4mHeight;
+    m_y4mPlanes.resize(planeSize * 3);
+    uint8_t* const planeY = m_y4mPlanes.data();
+    uint8_t* const planeU = planeY + planeSize;
+    uint8_t* const planeV = planeU + planeSize;
+
+    unsigned int const copyWidth  = (std::min)(frame.width, m_y4mWidth);
+    unsigned int const copyHeight = (std::min)(frame.height, m_y4mHeight);
+
+    memset(planeY, 0, planeSize);
+    memset(planeU, 128, planeSize * 2);
+
+    for (unsigned int y = 0; y < copyHeight; ++y)
+    {
+        size_t const         rowOffset = (size_t)y * m_y4mWidth;
+        uint8_t const* const source    = frame.pixels.data() + (size_t)y * frame.width * 4;
+
+        for (unsigned int x = 0; x < copyWidth; ++x)
+        {
+            int const r = source[x * 4 + 0];
+            int const g = source[x * 4 + 1];
+            int const b = source[x * 4 + 2];
+
+            planeY[rowOffset + x] = ClampToByte((77 * r + 150 * g + 29 * b + 128) >> 8);
+            planeU[rowOffset + x] = ClampToByte(((-43 * r - 85 * g + 128 * b + 128) >> 8) + 128);
+            planeV[rowOffset + x] = ClampToByte(((128 * r - 107 * g - 21 * b + 128) >> 8) + 128);
+        }
+    }
+
+    static char const frameMarker[] = "FRAME\n";
+    return Write(frameMarker, sizeof(frameMarker) - 1) && Write(m_y4mPlanes.data(), m_y4mPlanes.size());
+}
+
+//----------------------------------------------------------------------------------------------------
+bool FrameRecorder::Write(void const* data, size_t const size)
+{
+    if (size == 0) return true;
+    if (fwrite(data, 1, size, m_file) != size) return false;
+
+    m_frameBytes += size;
+    return true;
+}
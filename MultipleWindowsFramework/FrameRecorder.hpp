@@ -0,0 +1,175 @@
+﻿//----------------------------------------------------------------------------------------------------
+// FrameRecorder.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Region.hpp"
+
+//----------------------------------------------------------------------------------------------------
+enum class eRecordFormat
+{
+    Raw,                                    // 本專案的容器：每幀附帶窗口區域，可選壓縮
+    Y4M                                     // YUV4MPEG2 (4:4:4)，可直接交給 ffmpeg；尺寸固定為第一幀
+};
+
+enum class eRecordCompression
+{
+    None,
+    DeltaRle                                // 與上一個寫出的幀 XOR 後以 32 位元字組做 RLE，只用於 Raw
+};
+
+// 緩衝區用完 (磁碟跟不上) 時的處理方式，Render 永遠不等待
+enum class eRecordDropPolicy
+{
+    DropNewest,                             // 丟棄剛送來的幀，保留已排隊的連續畫面
+    DropOldest                              // 丟棄排隊最久的幀，錄到的總是最新畫面
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sFrameRecorderDesc
+{
+    std::string        path;
+    eRecordFormat      format           = eRecordFormat::Raw;
+    eRecordCompression compression      = eRecordCompression::DeltaRle;
+    eRecordDropPolicy  dropPolicy       = eRecordDropPolicy::DropOldest;
+    unsigned int       bufferCount      = 8;    // 排隊中的幀上限
+    unsigned int       keyframeInterval = 60;   // DeltaRle 每隔幾幀寫一次不依賴前一幀的幀
+    unsigned int       frameRate        = 60;   // 只寫入 Y4M 標頭
+    size_t             frameBytes       = 0;    // 非 0 時在 Start 預先配置所有緩衝區，錄影中不再配置記憶體
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sFrameRecorderStats
+{
+    unsigned long long framesSubmitted = 0;
+    unsigned long long framesWritten   = 0;
+    unsigned long long framesDropped   = 0;
+    unsigned long long bytesWritten    = 0;
+    unsigned int       queueHighWater  = 0;
+    bool               hasWriteError   = false;
+};
+
+//----------------------------------------------------------------------------------------------------
+// Raw 格式：sRecordFileHeader，之後每幀為 sRecordFrameHeader | windowCount 個 sRecordRect | payload
+uint32_t const RECORD_FILE_MAGIC   = 0x4352574D;    // "MWRC"
+uint32_t const RECORD_FILE_VERSION = 1;
+
+enum eRecordFrameEncoding : uint32_t
+{
+    RECORD_ENCODING_RAW       = 0,          // width * height * 4 位元組
+    RECORD_ENCODING_RLE       = 1,          // 自身的 RLE (關鍵幀)
+    RECORD_ENCODING_DELTA_RLE = 2           // 與上一個寫出的幀 XOR 後的 RLE
+};
+
+struct sRecordFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+};
+
+struct sRecordFrameHeader
+{
+    uint64_t frameNumber;                   // 送入錄影器的順序，從 1 開始；中間缺號即為丟幀
+    uint64_t timestampMicroseconds;         // 相對於 Start
+    uint32_t width;
+    uint32_t height;
+    uint32_t encoding;
+    uint32_t windowCount;
+    uint32_t payloadBytes;
+    uint32_t reserved;
+};
+
+struct sRecordRect
+{
+    int32_t left;
+    int32_t top;
+    int32_t right;
+    int32_t bottom;
+};
+
+//----------------------------------------------------------------------------------------------------
+// RLE 字組流：控制字組最高位元為 1 時為 (count & 0x7FFFFFFF) 個相同字組，後面接一個值；否則為 count 個原始字組
+// previous 為 nullptr 時不做 XOR
+void EncodeDeltaRle(uint32_t const* current, uint32_t const* previous, size_t count, std::vector<uint32_t>& encoded);
+bool DecodeDeltaRle(uint32_t const* encoded, size_t encodedCount, uint32_t const* previous, uint32_t* output, size_t count);
+
+//----------------------------------------------------------------------------------------------------
+// 非同步錄影：Render 只交換緩衝區的所有權，編碼與寫檔都在背景執行緒
+class FrameRecorder
+{
+public:
+    FrameRecorder() = default;
+    ~FrameRecorder();
+
+    FrameRecorder(FrameRecorder const&)            = delete;
+    FrameRecorder& operator=(FrameRecorder const&) = delete;
+
+    bool Start(sFrameRecorderDesc const& desc);
+    void Stop();                            // 寫完已排隊的幀後關閉檔案
+    bool IsRecording() const { return m_file != nullptr; }
+
+    // 交出一整幀 (RGBA8，每列 width * 4 位元組)：成功時 pixels 換成一塊同樣大小、內容未定義的空閒緩衝區
+    // 依丟幀策略放棄這一幀時 pixels 保持不變並回傳 false
+    bool SubmitFrame(std::vector<uint8_t>& pixels,
+                     unsigned int          width,
+                     unsigned int          height,
+                     sRect const*          windowRects     = nullptr,
+                     unsigned int          windowRectCount = 0);
+
+    sFrameRecorderStats GetStats() const;
+
+private:
+    struct sQueuedFrame
+    {
+        std::vector<uint8_t>     pixels;
+        unsigned int             width                 = 0;
+        unsigned int             height                = 0;
+        unsigned long long       frameNumber           = 0;
+        unsigned long long       timestampMicroseconds = 0;
+        std::vector<sRecordRect> windowRects;
+    };
+
+    void WorkerMain();
+    bool WriteFrame(sQueuedFrame const& frame);
+    bool WriteRawFrame(sQueuedFrame const& frame);
+    bool WriteY4MFrame(sQueuedFrame const& frame);
+    bool Write(void const* data, size_t size);
+
+    sFrameRecorderDesc                    m_desc;
+    FILE*                                 m_file = nullptr;
+    std::thread                           m_worker;
+    std::chrono::steady_clock::time_point m_startTime;
+
+    // 所有幀 (像素與窗口區域) 在 Start 配置一次，之後只在空閒堆疊、佇列與背景執行緒之間傳遞索引
+    mutable std::mutex        m_mutex;
+    std::condition_variable   m_frameAvailable;
+    std::vector<sQueuedFrame> m_frames;
+    std::vector<unsigned int> m_freeFrames;
+    std::vector<unsigned int> m_queue;              // 環狀佇列，容量為 bufferCount
+    unsigned int              m_queueHead   = 0;
+    unsigned int              m_queueCount  = 0;
+    unsigned long long        m_frameNumber = 0;
+    bool                      m_isStopping  = false;
+    sFrameRecorderStats       m_stats;
+
+    // 只有背景執行緒使用 (Start 寫檔頭時背景執行緒尚未啟動)
+    std::vector<uint8_t>  m_previousPixels;     // DeltaRle 的參考幀
+    unsigned int          m_previousWidth  = 0;
+    unsigned int          m_previousHeight = 0;
+    unsigned int          m_framesSinceKey = 0;
+    std::vector<uint32_t> m_encoded;
+    std::vector<uint8_t>  m_y4mPlanes;
+    unsigned int          m_y4mWidth       = 0;
+    unsigned int          m_y4mHeight      = 0;
+    unsigned long long    m_frameBytes     = 0;
+};
@@ -0,0 +1,464 @@
+﻿//----------------------------------------------------------------------------------------------------
+// FrameRecorderCheckMain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// 非同步錄影的檢查與基準 (不屬於 Windows 專案，在 Linux 上單獨編譯)：
+//
+//   g++ -std=c++14 -O2 -pthread FrameRecorderCheckMain.cpp FrameRecorder.cpp Region.cpp -o frame_recorder_check
+//   ./frame_recorder_check [基準的幀數]
+//
+// RLE：隨機資料 (有無參考幀) 逐字組還原，截斷或損壞的字組流不會寫出界並且被拒絕
+// 背壓：寫入端塞在沒有人讀的 FIFO 上，兩種丟幀策略留下的幀編號必須完全符合預期，之後讀完 FIFO 逐幀驗證
+// 吞吐量：1280x720 不限速送幀，量測 SubmitFrame 的延遲與寫檔速度，解碼整個檔案逐像素、逐窗口區域比對；
+// 另外計算送幀執行緒上 operator new 的次數，只能在每個緩衝區第一次使用時配置，不能每幀配置
+// 結束碼：0 = 全部通過，1 = 失敗
+//----------------------------------------------------------------------------------------------------
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CheckMain.hpp"
+#include "FrameRecorder.hpp"
+
+//----------------------------------------------------------------------------------------------------
+// 只計算打開開關的執行緒 (送幀的主執行緒)，背景執行緒的編碼緩衝區不算
+static thread_local bool                t_isCountingAllocations = false;
+static std::atomic<unsigned long long> g_allocationCount(0);
+
+static void* CountedAllocate(size_t const size)
+{
+    if (t_isCountingAllocations) g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* const memory = malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t const size) { return CountedAllocate(size); }
+void* operator new[](size_t const size) { return CountedAllocate(size); }
+void  operator delete(void* const memory) noexcept { free(memory); }
+void  operator delete[](void* const memory) noexcept { free(memory); }
+void  operator delete(void* const memory, size_t) noexcept { free(memory); }
+void  operator delete[](void* const memory, size_t) noexcept { free(memory); }
+
+//----------------------------------------------------------------------------------------------------
+// 幀的內容只由幀編號決定：每 7 幀移動一格的棋盤格，加上一個顏色為幀編號的移動方塊
+// (每幀都不同，但大部分字組與上一幀相同，DeltaRle 有效)
+static void FillFrame(std::vector<uint8_t>& pixels, unsigned int const width, unsigned int const height, unsigned long long const frameNumber)
+{
+    uint32_t* const    words   = reinterpret_cast<uint32_t*>(pixels.data());
+    unsigned int const squareX = (unsigned int)(frameNumber * 5 % width);
+    unsigned int const squareY = (unsigned int)(frameNumber * 3 % height);
+
+    for (unsigned int y = 0; y < height; ++y)
+    {
+        for (unsigned int x = 0; x < width; ++x)
+        {
+            bool const isSquare = x - squareX < 32 && y - squareY < 32;
+            bool const isDark   = ((x / 64 + y / 64 + frameNumber / 7) & 1) != 0;
+
+            uint32_t& word = words[(size_t)y * width + x];
+            if (isSquare)    word = (uint32_t)(0xFF000000u | frameNumber);
+            else if (isDark) word = 0xFF202020u;
+            else             word = 0xFF000000u | (x * 3 + y);
+        }
+    }
+}
+
+// 窗口數隨幀編號在 0 到 3 之間變化
+static unsigned int FillWindowRects(sRect* rects, unsigned long long const frameNumber)
+{
+    unsigned int const count = (unsigned int)(frameNumber % 4);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        rects[i].left   = (int)i * 100;
+        rects[i].top    = (int)(frameNumber % 500);
+        rects[i].right  = rects[i].left + 64;
+        rects[i].bottom = rects[i].top + 48;
+    }
+    return count;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 依序解碼 Raw 錄影，每一幀呼叫 onFrame(header, rects, pixels)；格式錯誤時回傳 false
+template <typename Function>
+static bool ParseRecording(std::vector<uint8_t> const& bytes, Function onFrame)
+{
+    size_t            offset = sizeof(sRecordFileHeader);
+    sRecordFileHeader fileHeader;
+    if (bytes.size() < offset) return false;
+    memcpy(&fileHeader, bytes.data(), sizeof(fileHeader));
+    if (fileHeader.magic != RECORD_FILE_MAGIC || fileHeader.version != RECORD_FILE_VERSION) return false;
+
+    std::vector<uint32_t>    previous, current, payload;
+    std::vector<sRecordRect> rects;
+    while (offset < bytes.size())
+    {
+        sRecordFrameHeader header;
+        if (bytes.size() - offset < sizeof(header)) return false;
+        memcpy(&header, bytes.data() + offset, sizeof(header));
+        offset += sizeof(header);
+
+        size_t const rectBytes = (size_t)header.windowCount * sizeof(sRecordRect);
+        if (bytes.size() - offset < rectBytes + header.payloadBytes || header.payloadBytes % 4 != 0) return false;
+
+        rects.resize(header.windowCount);
+        if (rectBytes) memcpy(rects.data(), bytes.data() + offset, rectBytes);
+        offset += rectBytes;
+
+        payload.resize(header.payloadBytes / 4);
+        if (header.payloadBytes) memcpy(payload.data(), bytes.data() + offset, header.payloadBytes);
+        offset += header.payloadBytes;
+
+        size_t const pixelCount = (size_t)header.width * header.height;
+        current.resize(pixelCount);
+        switch (header.encoding)
+        {
+        case RECORD_ENCODING_RAW:
+            if (payload.size() != pixelCount) return false;
+            current = payload;
+            break;
+        case RECORD_ENCODING_RLE:
+            if (!DecodeDeltaRle(payload.data(), payload.size(), nullptr, current.data(), pixelCount)) return false;
+            break;
+        case RECORD_ENCODING_DELTA_RLE:
+            if (previous.size() != pixelCount) return false;
+            if (!DecodeDeltaRle(payload.data(), payload.size(), previous.data(), current.data(), pixelCount)) return false;
+            break;
+        default:
+            return false;
+        }
+
+        if (!onFrame(header, rects, current)) return false;
+        previous.swap(current);
+    }
+    return true;
+}
+
+static bool ReadFile(char const* path, std::vector<uint8_t>& bytes)
+{
+    FILE* const file = fopen(path, "rb");
+    if (!file) return false;
+
+    bytes.clear();
+    uint8_t buffer[65536];
+    size_t  size;
+    while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        bytes.insert(bytes.end(), buffer, buffer + size);
+    }
+    fclose(file);
+    return true;
+}
+
+// 比對一幀的像素與窗口區域是否等於 FillFrame / FillWindowRects 的結果
+static bool IsFrameExpected(sRecordFrameHeader const& header, std::vector<sRecordRect> const& rects, std::vector<uint32_t> const& pixels)
+{
+    std::vector<uint8_t> expected((size_t)header.width * header.height * 4);
+    FillFrame(expected, header.width, header.height, header.frameNumber);
+    if (memcmp(expected.data(), pixels.data(), expected.size()) != 0) return false;
+
+    sRect              expectedRects[4];
+    unsigned int const expectedCount = FillWindowRects(expectedRects, header.frameNumber);
+    if (rects.size() != expectedCount) return false;
+
+    for (unsigned int i = 0; i < expectedCount; ++i)
+    {
+        if (rects[i].left != expectedRects[i].left || rects[i].top != expectedRects[i].top ||
+            rects[i].right != expectedRects[i].right || rects[i].bottom != expectedRects[i].bottom) return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+static bool CheckRle()
+{
+    uint32_t seed           = 0x9E3779B9u;
+    bool     isRoundTrip    = true;
+    bool     isDeltaRound   = true;
+    bool     isTruncRejects = true;
+
+    std::vector<uint32_t> current, previous, output, encoded;
+    for (int iteration = 0; iteration < 3000; ++iteration)
+    {
+        // 大部分字組重複 (形成連續段)，夾雜隨機字組；參考幀大部分相同
+        size_t const count = NextRandom(seed) % 400;
+        current.resize(count);
+        previous.resize(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            current[i]  = NextRandom(seed) % 3 == 0 ? NextRandom(seed) : 5u;
+            previous[i] = NextRandom(seed) % 4 != 0 ? current[i] : NextRandom(seed);
+        }
+
+        // 輸出多一個守衛字組，解碼不得寫到 count 之後
+        output.assign(count + 1, 0xA5A5A5A5u);
+        EncodeDeltaRle(current.data(), nullptr, count, encoded);
+        isRoundTrip &= DecodeDeltaRle(encoded.data(), encoded.size(), nullptr, output.data(), count) &&
+                       std::equal(current.begin(), current.end(), output.begin()) && output[count] == 0xA5A5A5A5u;
+
+        EncodeDeltaRle(current.data(), previous.data(), count, encoded);
+        isDeltaRound &= DecodeDeltaRle(encoded.data(), encoded.size(), previous.data(), output.data(), count) &&
+                        std::equal(current.begin(), current.end(), output.begin()) && output[count] == 0xA5A5A5A5u;
+
+        if (encoded.empty()) continue;
+
+        // 截斷：少了任何一段都湊不滿 count 個字組
+        std::vector<uint32_t> truncated(encoded.begin(), encoded.begin() + NextRandom(seed) % encoded.size());
+        isTruncRejects &= !DecodeDeltaRle(truncated.data(), truncated.size(), previous.data(), output.data(), count);
+        isTruncRejects &= output[count] == 0xA5A5A5A5u;
+
+        // 損壞：結果不定，但不能寫出界 (配合 -fsanitize=address 檢查讀取)
+        encoded[NextRandom(seed) % encoded.size()] ^= NextRandom(seed);
+        DecodeDeltaRle(encoded.data(), encoded.size(), previous.data(), output.data(), count);
+        isTruncRejects &= output[count] == 0xA5A5A5A5u;
+    }
+
+    // 整張同色的幀只需要一個連續段
+    std::vector<uint32_t> const constant(1280 * 720, 0xFF336699u);
+    EncodeDeltaRle(constant.data(), nullptr, constant.size(), encoded);
+    bool const isCompact = encoded.size() == 2;
+
+    bool isPassing = true;
+    isPassing &= Check(isRoundTrip, "rle_round_trip");
+    isPassing &= Check(isDeltaRound, "rle_delta_round_trip");
+    isPassing &= Check(isTruncRejects, "rle_truncated_rejected");
+    isPassing &= Check(isCompact, "rle_constant_compact");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 寫入端塞住時的丟幀：第一幀被背景執行緒取走後卡在 FIFO 上，其餘 bufferCount - 1 個緩衝區排滿後開始丟幀
+static bool CheckBackpressure(eRecordDropPolicy const dropPolicy, char const* name)
+{
+    unsigned int const       width       = 256;            // 一幀 256 KB，遠大於 FIFO 的緩衝
+    unsigned int const       height      = 256;
+    unsigned int const       bufferCount = 4;
+    unsigned long long const frameCount  = 20;
+    std::string const        path        = "/tmp/mwf_frame_recorder_check_" + std::to_string((long long)getpid());
+
+    unlink(path.c_str());
+    if (mkfifo(path.c_str(), 0600) != 0) return Check(false, "backpressure_fifo");
+
+    // 先以非阻塞方式打開讀取端，錄影器的 fopen 才不會卡住；之後不讀，讓寫入端塞住
+    int const readFile = open(path.c_str(), O_RDONLY | O_NONBLOCK);
+
+    sFrameRecorderDesc desc;
+    desc.path        = path;
+    desc.compression = eRecordCompression::None;
+    desc.dropPolicy  = dropPolicy;
+    desc.bufferCount = bufferCount;
+    desc.frameBytes  = (size_t)width * height * 4;
+
+    FrameRecorder recorder;
+    bool const    isStarted = readFile >= 0 && recorder.Start(desc);
+
+    std::vector<uint8_t> pixels(desc.frameBytes);
+    sRect                rects[4];
+    bool                 isSubmitResultExpected = true;
+    for (unsigned long long frameNumber = 1; isStarted && frameNumber <= frameCount; ++frameNumber)
+    {
+        FillFrame(pixels, width, height, frameNumber);
+        unsigned int const rectCount = FillWindowRects(rects, frameNumber);
+        bool const         isQueued  = recorder.SubmitFrame(pixels, width, height, rects, rectCount);
+
+        // DropNewest 只接受前 bufferCount 幀；DropOldest 永遠接受新幀
+        isSubmitResultExpected &= isQueued == (dropPolicy == eRecordDropPolicy::DropOldest || frameNumber <= bufferCount);
+
+        // 確定背景執行緒已取走第一幀並卡在寫檔上
+        if (frameNumber == 1) std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    }
+    sFrameRecorderStats const blockedStats = recorder.GetStats();
+
+    // 讀完 FIFO，Stop 寫完排隊的幀後關閉檔案，讀取端讀到 EOF
+    std::vector<uint8_t> bytes;
+    std::thread          drain([&] {
+        if (readFile < 0) return;
+        fcntl(readFile, F_SETFL, fcntl(readFile, F_GETFL) & ~O_NONBLOCK);
+
+        uint8_t buffer[65536];
+        ssize_t size;
+        while ((size = read(readFile, buffer, sizeof(buffer))) > 0)
+        {
+            bytes.insert(bytes.end(), buffer, buffer + size);
+        }
+    });
+    recorder.Stop();
+    drain.join();
+    if (readFile >= 0) close(readFile);
+    unlink(path.c_str());
+
+    sFrameRecorderStats const stats = recorder.GetStats();
+
+    std::vector<unsigned long long> frameNumbers;
+    bool const isParsed = ParseRecording(bytes, [&](sRecordFrameHeader const& header, std::vector<sRecordRect> const& rects,
+                                                     std::vector<uint32_t> const& pixels) {
+        frameNumbers.push_back(header.frameNumber);
+        return IsFrameExpected(header, rects, pixels);
+    });
+
+    // DropNewest 保留連續的開頭；DropOldest 保留卡住的第一幀與最新的 bufferCount - 1 幀
+    std::vector<unsigned long long> expectedNumbers = {1};
+    for (unsigned int i = 1; i < bufferCount; ++i)
+    {
+        expectedNumbers.push_back(dropPolicy == eRecordDropPolicy::DropNewest ? 1 + i : frameCount - bufferCount + 1 + i);
+    }
+    unsigned long long const expectedDropped = frameCount - bufferCount;
+
+    printf("backpressure_%s_written %llu\n", name, stats.framesWritten);
+    printf("backpressure_%s_dropped %llu\n", name, stats.framesDropped);
+    printf("backpressure_%s_high_water %u\n", name, stats.queueHighWater);
+
+    std::string const prefix = std::string("backpressure_") + name;
+
+    bool isPassing = true;
+    isPassing &= Check(isStarted, (prefix + "_start").c_str());
+    isPassing &= Check(isSubmitResultExpected && blockedStats.framesDropped == expectedDropped &&
+                       blockedStats.framesWritten == 0 && blockedStats.queueHighWater == bufferCount - 1, (prefix + "_blocked_stats").c_str());
+    isPassing &= Check(stats.framesSubmitted == frameCount && stats.framesWritten == bufferCount &&
+                       stats.framesDropped == expectedDropped && !stats.hasWriteError, (prefix + "_final_stats").c_str());
+    isPassing &= Check(isParsed && frameNumbers == expectedNumbers, (prefix + "_kept_frames").c_str());
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 不限速送幀：量測送幀延遲與寫檔速度，之後解碼整個檔案比對
+static bool CheckThroughput(eRecordDropPolicy const dropPolicy, char const* name, unsigned int const frameCount)
+{
+    using Clock = std::chrono::steady_clock;
+
+    unsigned int const width  = 1280;
+    unsigned int const height = 720;
+    std::string const  path   = "/tmp/mwf_frame_recorder_check_" + std::to_string((long long)getpid()) + ".bin";
+
+    sFrameRecorderDesc desc;
+    desc.path             = path;
+    desc.dropPolicy       = dropPolicy;
+    desc.keyframeInterval = 30;
+    desc.frameBytes       = (size_t)width * height * 4;
+
+    FrameRecorder recorder;
+    bool const    isStarted = recorder.Start(desc);
+
+    std::vector<uint8_t> pixels(desc.frameBytes);
+    sRect                rects[4];
+    double               totalMicroseconds = 0.0;
+    double               worstMicroseconds = 0.0;
+    bool                 isSizeKept        = true;
+
+    Clock::time_point const start = Clock::now();
+    for (unsigned long long frameNumber = 1; isStarted && frameNumber <= frameCount; ++frameNumber)
+    {
+        FillFrame(pixels, width, height, frameNumber);
+        unsigned int const rectCount = FillWindowRects(rects, frameNumber);
+
+        Clock::time_point const submitStart = Clock::now();
+        t_isCountingAllocations             = true;
+        recorder.SubmitFrame(pixels, width, height, rects, rectCount);
+        t_isCountingAllocations             = false;
+        double const microseconds           = std::chrono::duration<double, std::micro>(Clock::now() - submitStart).count();
+
+        totalMicroseconds += microseconds;
+        worstMicroseconds  = (std::max)(worstMicroseconds, microseconds);
+        isSizeKept        &= pixels.size() == desc.frameBytes;
+    }
+    recorder.Stop();
+    double const seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    sFrameRecorderStats const stats        = recorder.GetStats();
+    unsigned long long const  allocations  = g_allocationCount.exchange(0);
+    unsigned long long        parsedFrames = 0;
+    unsigned long long        lastNumber   = 0;
+
+    std::vector<uint8_t> bytes;
+    bool const           isRead   = ReadFile(path.c_str(), bytes);
+    bool const           isParsed = isRead && ParseRecording(bytes, [&](sRecordFrameHeader const& header, std::vector<sRecordRect> const& rects,
+                                                                           std::vector<uint32_t> const& pixels) {
+        bool const isOrdered = header.frameNumber > lastNumber;
+        lastNumber           = header.frameNumber;
+        ++parsedFrames;
+        return isOrdered && IsFrameExpected(header, rects, pixels);
+    });
+    unlink(path.c_str());
+
+    double const rawBytes = (double)stats.framesWritten * desc.frameBytes;
+
+    printf("throughput_%s_frames %u\n", name, frameCount);
+    printf("throughput_%s_written %llu\n", name, stats.framesWritten);
+    printf("throughput_%s_dropped %llu\n", name, stats.framesDropped);
+    printf("throughput_%s_high_water %u\n", name, stats.queueHighWater);
+    printf("throughput_%s_submit_avg_us %.1f\n", name, totalMicroseconds / (std::max)(1u, frameCount));
+    printf("throughput_%s_submit_worst_us %.1f\n", name, worstMicroseconds);
+    printf("throughput_%s_written_fps %.1f\n", name, stats.framesWritten / seconds);
+    printf("throughput_%s_compression_ratio %.1f\n", name, rawBytes / (std::max)(1ull, stats.bytesWritten));
+    printf("throughput_%s_submit_allocations %llu\n", name, allocations);
+
+    std::string const prefix = std::string("throughput_") + name;
+
+    bool isPassing = true;
+    isPassing &= Check(isStarted && isSizeKept, (prefix + "_start").c_str());
+    isPassing &= Check(stats.framesSubmitted == frameCount && stats.framesWritten + stats.framesDropped == frameCount &&
+                       stats.framesWritten > 0 && stats.queueHighWater <= desc.bufferCount && !stats.hasWriteError,
+                       (prefix + "_accounting").c_str());
+    isPassing &= Check(isParsed && parsedFrames == stats.framesWritten && stats.bytesWritten == bytes.size(), (prefix + "_file_matches").c_str());
+
+    // 每個緩衝區的窗口區域最多成長到 4 個元素 (1、2、4)，DeltaRle 換回的參考幀第一次使用時再配置一次
+    isPassing &= Check(allocations <= desc.bufferCount * 3ull + 1, (prefix + "_submit_allocations_bounded").c_str());
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// Y4M：尺寸固定為第一幀，之後較小的幀補黑，每幀大小相同
+static bool CheckY4M()
+{
+    std::string const path = "/tmp/mwf_frame_recorder_check_" + std::to_string((long long)getpid()) + ".y4m";
+
+    sFrameRecorderDesc desc;
+    desc.path      = path;
+    desc.format    = eRecordFormat::Y4M;
+    desc.frameRate = 30;
+
+    FrameRecorder        recorder;
+    bool const           isStarted = recorder.Start(desc);
+    std::vector<uint8_t> pixels(64 * 48 * 4, 0xFF);
+    for (int i = 0; i < 5; ++i)
+    {
+        recorder.SubmitFrame(pixels, i < 3 ? 64 : 32, i < 3 ? 48 : 40);
+    }
+    recorder.Stop();
+
+    std::vector<uint8_t> bytes;
+    ReadFile(path.c_str(), bytes);
+    unlink(path.c_str());
+
+    static char const header[] = "YUV4MPEG2 W64 H48 F30:1 Ip A1:1 C444\n";
+    size_t const      expected = sizeof(header) - 1 + recorder.GetStats().framesWritten * (6 + 64 * 48 * 3);
+
+    return Check(isStarted && recorder.GetStats().framesWritten == 5 && bytes.size() == expected &&
+                 memcmp(bytes.data(), header, sizeof(header) - 1) == 0, "y4m_fixed_size");
+}
+
+//----------------------------------------------------------------------------------------------------
+int main(int const argc, char** argv)
+{
+    unsigned int const frameCount = argc > 1 ? (unsigned int)strtoul(argv[1], nullptr, 0) : 300u;
+
+    bool isPassing = true;
+    isPassing &= CheckRle();
+    isPassing &= CheckBackpressure(eRecordDropPolicy::DropNewest, "drop_newest");
+    isPassing &= CheckBackpressure(eRecordDropPolicy::DropOldest, "drop_oldest");
+    isPassing &= CheckThroughput(eRecordDropPolicy::DropNewest, "drop_newest", frameCount);
+    isPassing &= CheckThroughput(eRecordDropPolicy::DropOldest, "drop_oldest", frameCount);
+    isPassing &= CheckY4M();
+    return isPassing ? 0 : 1;
+}
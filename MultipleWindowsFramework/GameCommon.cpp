@@ -5,8 +5,15 @@
 //----------------------------------------------------------------------------------------------------
 #include "GameCommon.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
 #include <string>
+#include <thread>
 
+#include "PhaseTimer.hpp"
 #include "Renderer.hpp"
 #include "Window.hpp"
 
@@ -14,28 +21,152 @@
 Renderer* g_renderer = nullptr;
 
 //----------------------------------------------------------------------------------------------------
-void CreateAndRegisterMultipleWindows(HINSTANCE const hInstance,
-                                      int const       windowCount)
+// 送給 UI 執行緒 (沒有 hwnd 的執行緒訊息)：顯示自己負責的窗口
+static UINT const WM_REVEAL_GAME_WINDOWS = WM_APP + 1;
+
+//----------------------------------------------------------------------------------------------------
+struct sUiThreadGroup
+{
+    std::mutex              mutex;
+    std::condition_variable changed;
+    unsigned int            createdCount    = 0;
+    unsigned int            revealedCount   = 0;
+    std::vector<DWORD>      threadIds;
+    std::vector<double>     createMilliseconds;
+    DWORD                   mainThreadId    = 0;
+    bool                    isRevealBatched = true;
+};
+
+//----------------------------------------------------------------------------------------------------
+static HWND CreateHiddenGameWindow(HINSTANCE const hInstance, int const index, sWindowPlacement const& placement)
+{
+    std::wstring const title = L"ChildWindow " + std::to_wstring(index + 1);
+
+    return CreateWindowEx(
+        0,
+        L"GameWindow",
+        title.c_str(),
+        WS_OVERLAPPEDWINDOW,
+        placement.x, placement.y, placement.width, placement.height,
+        nullptr,
+        nullptr,
+        hInstance,
+        nullptr
+    );
+}
+
+//----------------------------------------------------------------------------------------------------
+// 只能顯示呼叫端執行緒擁有的窗口
+static void RevealWindows(HWND const* windows, size_t const count, bool const isBatched)
 {
-    int const width   = 400;
-    int const height  = 300;
-    int const startX  = 100;
-    int const startY  = 100;
-    int const offsetX = 450;
-    int const offsetY = 350;
-
-    for (int i = 0; i < windowCount; ++i)
+    if (isBatched)
     {
-        std::wstring title = L"ChildWindow " + std::to_wstring(i + 1);
-        int          x     = startX + (i % 5) * offsetX;       // 每列最多5個視窗
-        int          y     = startY + (i / 5) * offsetY;       // 每滿5個換行
+        // 一次 EndDeferWindowPos 完成全部，不會每個窗口各自觸發一輪重排與繪製
+        HDWP positions = BeginDeferWindowPos((int)count);
+        for (size_t i = 0; i < count && positions; ++i)
+        {
+            if (!windows[i]) continue;
+            positions = DeferWindowPos(positions, windows[i], nullptr, 0, 0, 0, 0,
+                                       SWP_SHOWWINDOW | SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE);
+        }
+        if (positions && EndDeferWindowPos(positions)) return;
+    }
 
-        HWND hwnd = CreateGameWindow(hInstance, title.c_str(), x, y, width, height);
-        if (hwnd)
+    // 逐一顯示；批次失敗時也走這裡 (已顯示的窗口不受影響)
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (windows[i]) ShowWindow(windows[i], isBatched ? SW_SHOWNA : SW_SHOW);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+// 等待 UI 執行緒時仍處理送到本執行緒的訊息 (例如啟用其他窗口時送給隱藏主窗口的通知)，否則可能互相等待
+template <typename Predicate>
+static void WaitForUiThreads(sUiThreadGroup& group, Predicate const& isDone)
+{
+    std::unique_lock<std::mutex> lock(group.mutex);
+    while (!isDone())
+    {
+        group.changed.wait_for(lock, std::chrono::milliseconds(1));
+
+        lock.unlock();
+        MSG msg;
+        PeekMessage(&msg, nullptr, 0, 0, PM_NOREMOVE | PM_QS_SENDMESSAGE);
+        lock.lock();
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+static void UiThreadMain(std::shared_ptr<sUiThreadGroup> const group,
+                         HINSTANCE const                       hInstance,
+                         unsigned int const                    threadIndex,
+                         int const                             firstIndex,
+                         std::vector<sWindowPlacement> const   placements,
+                         HWND* const                           slots)
+{
+    // 先建立訊息佇列，主執行緒之後送來的執行緒訊息才不會遺失
+    MSG msg;
+    PeekMessage(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE);
+
+    auto const start = std::chrono::steady_clock::now();
+
+    std::vector<HWND> windows(placements.size(), nullptr);
+    for (size_t i = 0; i < placements.size(); ++i)
+    {
+        windows[i] = CreateHiddenGameWindow(hInstance, firstIndex + (int)i, placements[i]);
+        slots[i]   = windows[i];
+    }
+
+    double const milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    {
+        std::lock_guard<std::mutex> lock(group->mutex);
+        group->threadIds[threadIndex]          = GetCurrentThreadId();
+        group->createMilliseconds[threadIndex] = milliseconds;
+        ++group->createdCount;
+    }
+    group->changed.notify_all();
+
+    while (GetMessage(&msg, nullptr, 0, 0) > 0)
+    {
+        if (!msg.hwnd && msg.message == WM_REVEAL_GAME_WINDOWS)
         {
-            g_renderer->AddWindow(hwnd);
+            RevealWindows(windows.data(), windows.size(), group->isRevealBatched);
+            {
+                std::lock_guard<std::mutex> lock(group->mutex);
+                ++group->revealedCount;
+            }
+            group->changed.notify_all();
+            continue;
         }
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
     }
+
+    // 任何一個窗口關閉 (WM_DESTROY -> PostQuitMessage) 都與單執行緒時相同，結束整個程式
+    PostThreadMessage(group->mainThreadId, WM_QUIT, 0, 0);
+}
+
+//----------------------------------------------------------------------------------------------------
+void CreateAndRegisterMultipleWindows(HINSTANCE const    hInstance,
+                                      int const          windowCount,
+                                      unsigned int const uiThreadCount,
+                                      PhaseTimer* const  timer)
+{
+    // 預設排列與原本相同 (每列 5 個)，超出螢幕高度的部分錯開後從頭排起
+    sBulkWindowDesc desc;
+    desc.layout.windowCount  = windowCount;
+    desc.layout.boundsWidth  = GetSystemMetrics(SM_CXSCREEN);
+    desc.layout.boundsHeight = GetSystemMetrics(SM_CYSCREEN);
+    desc.uiThreadCount       = uiThreadCount;
+
+    sBulkWindows bulk;
+    if (!CreateWindowsInBulk(hInstance, desc, bulk, timer)) return;
+
+    g_renderer->AddWindows(bulk.windows.data(), bulk.windows.size());
+    if (timer) timer->Mark("add_windows");
+
+    RevealWindowsInBulk(bulk);
+    if (timer) timer->Mark("reveal");
 }
 
 //----------------------------------------------------------------------------------------------------
@@ -46,14 +177,7 @@ HWND CreateGameWindow(HINSTANCE const hInstance,
                       int const       width,
                       int const       height)
 {
-    WNDCLASS wc      = {};
-    wc.lpfnWndProc   = WindowsMessageHandlingProcedure;
-    wc.hInstance     = hInstance;
-    wc.lpszClassName = L"GameWindow";
-    wc.hbrBackground = (HBRUSH)(COLOR_WINDOW + 1);
-    wc.hCursor       = LoadCursor(nullptr, IDC_ARROW);
-
-    RegisterClass(&wc);
+    RegisterGameWindowClass(hInstance);
 
     HWND hwnd = CreateWindowEx(
         0,
@@ -74,3 +198,109 @@ HWND CreateGameWindow(HINSTANCE const hInstance,
 
     return hwnd;
 }
+
+//----------------------------------------------------------------------------------------------------
+bool RegisterGameWindowClass(HINSTANCE const hInstance)
+{
+    // 區域靜態變數的初始化是執行緒安全的，多個 UI 執行緒同時呼叫也只註冊一次
+    static bool const isRegistered = [hInstance]()
+    {
+        WNDCLASS wc      = {};
+        wc.style         = CS_OWNDC;
+        wc.lpfnWndProc   = WindowsMessageHandlingProcedure;
+        wc.hInstance     = hInstance;
+        wc.lpszClassName = L"GameWindow";
+        wc.hbrBackground = (HBRUSH)(COLOR_WINDOW + 1);
+        wc.hCursor       = LoadCursor(nullptr, IDC_ARROW);
+
+        return RegisterClass(&wc) != 0 || GetLastError() == ERROR_CLASS_ALREADY_EXISTS;
+    }();
+
+    return isRegistered;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool CreateWindowsInBulk(HINSTANCE const        hInstance,
+                         sBulkWindowDesc const& desc,
+                         sBulkWindows&          result,
+                         PhaseTimer* const      timer)
+{
+    result                 = sBulkWindows();
+    result.isRevealBatched = desc.isRevealBatched;
+
+    if (!RegisterGameWindowClass(hInstance)) return false;
+    if (timer) timer->Mark("register_class");
+
+    std::vector<sWindowPlacement> placements;
+    ComputeWindowLayout(desc.layout, placements);
+    result.windows.assign(placements.size(), nullptr);
+
+    int const          count       = (int)placements.size();
+    unsigned int const threadCount = (std::min)(desc.uiThreadCount, (unsigned int)count);
+
+    if (threadCount <= 1)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            result.windows[i] = CreateHiddenGameWindow(hInstance, i, placements[i]);
+        }
+        if (timer) timer->Mark("create_windows");
+    }
+    else
+    {
+        std::shared_ptr<sUiThreadGroup> const group = std::make_shared<sUiThreadGroup>();
+        group->threadIds.assign(threadCount, 0);
+        group->createMilliseconds.assign(threadCount, 0.0);
+        group->mainThreadId    = GetCurrentThreadId();
+        group->isRevealBatched = desc.isRevealBatched;
+
+        // 連續的一段交給同一個執行緒，窗口編號與單執行緒時相同
+        for (unsigned int t = 0; t < threadCount; ++t)
+        {
+            int const first = (int)((long long)count * t / threadCount);
+            int const last  = (int)((long long)count * (t + 1) / threadCount);
+
+            std::vector<sWindowPlacement> slice(placements.begin() + first, placements.begin() + last);
+            std::thread(UiThreadMain, group, hInstance, t, first, std::move(slice), result.windows.data() + first).detach();
+        }
+
+        WaitForUiThreads(*group, [&group, threadCount]() { return group->createdCount == threadCount; });
+        result.uiThreads = group;
+
+        if (timer)
+        {
+            timer->Mark("create_windows");
+            for (unsigned int t = 0; t < threadCount; ++t)
+            {
+                char name[32];
+                snprintf(name, sizeof(name), "create_thread%u", t);
+                timer->AddPhase(name, group->createMilliseconds[t]);
+            }
+        }
+    }
+
+    for (HWND const hwnd : result.windows)
+    {
+        if (hwnd) return true;
+    }
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------
+void RevealWindowsInBulk(sBulkWindows const& windows)
+{
+    if (!windows.uiThreads)
+    {
+        RevealWindows(windows.windows.data(), windows.windows.size(), windows.isRevealBatched);
+        return;
+    }
+
+    sUiThreadGroup& group = *windows.uiThreads;
+    for (DWORD const threadId : group.threadIds)
+    {
+        PostThreadMessage(threadId, WM_REVEAL_GAME_WINDOWS, 0, 0);
+    }
+
+    size_t const threadCount = group.threadIds.size();
+    WaitForUiThreads(group, [&group, threadCount]() { return group.revealedCount == threadCount; });
+}
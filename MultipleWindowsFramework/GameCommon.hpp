@@ -6,11 +6,43 @@
 #pragma once
 #include <windows.h>
 
+#include <memory>
+#include <vector>
+
+#include "WindowLayout.hpp"
+
 //-Forward-Declaration--------------------------------------------------------------------------------
+class PhaseTimer;
 class Renderer;
+struct sUiThreadGroup;
 
 //----------------------------------------------------------------------------------------------------
 extern Renderer* g_renderer;
 
-void CreateAndRegisterMultipleWindows(HINSTANCE hInstance, int windowCount);
+//----------------------------------------------------------------------------------------------------
+struct sBulkWindowDesc
+{
+    sWindowLayoutDesc layout;
+    unsigned int      uiThreadCount   = 1;       // 1 = 在呼叫端執行緒建立；更多時每個 UI 執行緒負責一段並執行自己的訊息循環
+    bool              isRevealBatched = true;    // false = 逐一 ShowWindow (舊流程，比較用)
+};
+
+// 依排列順序，建立失敗的位置為 nullptr
+struct sBulkWindows
+{
+    std::vector<HWND>               windows;
+    std::shared_ptr<sUiThreadGroup> uiThreads;        // nullptr = 全部屬於呼叫端執行緒
+    bool                            isRevealBatched = true;
+};
+
+//----------------------------------------------------------------------------------------------------
+void CreateAndRegisterMultipleWindows(HINSTANCE hInstance, int windowCount, unsigned int uiThreadCount = 1, PhaseTimer* timer = nullptr);
 HWND CreateGameWindow(HINSTANCE hInstance,  wchar_t const* title, int x, int y, int width, int height);
+
+// 窗口類別只註冊一次；CS_OWNDC 讓 Renderer 保留的 GetDC 一直有效，不佔用共用 DC 快取
+bool RegisterGameWindowClass(HINSTANCE hInstance);
+
+// 先建立隱藏的窗口，交給 Renderer 之後再以 RevealWindowsInBulk 一次顯示
+// timer 不為 nullptr 時記錄 register_class、create_windows 與每個 UI 執行緒的建立時間
+bool CreateWindowsInBulk(HINSTANCE hInstance, sBulkWindowDesc const& desc, sBulkWindows& result, PhaseTimer* timer = nullptr);
+void RevealWindowsInBulk(sBulkWindows const& windows);
@@ -0,0 +1,252 @@
+﻿//----------------------------------------------------------------------------------------------------
+// ImageDecoder.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "ImageDecoder.hpp"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define IMAGE_DECODER_USE_SSE2 1
+#include <emmintrin.h>
+#else
+#define IMAGE_DECODER_USE_SSE2 0
+#endif
+
+//----------------------------------------------------------------------------------------------------
+static uint8_t const QOI_OP_INDEX     = 0x00;   // 00xxxxxx
+static uint8_t const QOI_OP_DIFF      = 0x40;   // 01xxxxxx
+static uint8_t const QOI_OP_LUMA      = 0x80;   // 10xxxxxx
+static uint8_t const QOI_OP_RUN       = 0xC0;   // 11xxxxxx
+static uint8_t const QOI_OP_RGB       = 0xFE;
+static uint8_t const QOI_OP_RGBA      = 0xFF;
+static uint8_t const QOI_MASK_2       = 0xC0;
+static size_t const  QOI_HEADER_SIZE  = 14;
+static size_t const  QOI_PADDING_SIZE = 8;      // 7 個 0x00 加上 0x01，op 不能延伸到這裡
+static size_t const  QOI_MAX_RUN      = 62;
+
+//----------------------------------------------------------------------------------------------------
+static uint32_t ReadBigEndian32(uint8_t const* data)
+{
+    return (uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 | (uint32_t)data[2] << 8 | data[3];
+}
+
+//----------------------------------------------------------------------------------------------------
+// 把通道以 16 位元間隔排成 r、b、g、a，一次乘法讓 r * 3 + g * 5 + b * 7 + a * 11 累加在最高位元組
+static inline unsigned int HashQoiPixel(uint32_t const pixel)
+{
+    uint64_t const lanes = (uint64_t)(pixel & 0xFF00FF00) << 24 | (pixel & 0x00FF00FF);
+    return (unsigned int)((lanes * (3ull << 56 | 5ull << 24 | 7ull << 40 | 11ull << 8)) >> 56) & 63;
+}
+
+//----------------------------------------------------------------------------------------------------
+static inline uint32_t PackChannelDeltas(int const dr, int const dg, int const db)
+{
+    return (uint32_t)(dr & 0xFF) | (uint32_t)(dg & 0xFF) << 8 | (uint32_t)(db & 0xFF) << 16;
+}
+
+//----------------------------------------------------------------------------------------------------
+// RGB 三個通道各自加上差值 (各自以 256 取餘，不進位到下一個通道)，alpha 不變
+static inline uint32_t AddChannelDeltas(uint32_t const pixel, uint32_t const delta)
+{
+    uint32_t const redBlue = ((pixel & 0x00FF00FF) + (delta & 0x00FF00FF)) & 0x00FF00FF;
+    uint32_t const green   = ((pixel & 0x0000FF00) + (delta & 0x0000FF00)) & 0x0000FF00;
+    return redBlue | green | (pixel & 0xFF000000);
+}
+
+//----------------------------------------------------------------------------------------------------
+static inline void FillRun(uint32_t* pixels, uint32_t const pixel, size_t count)
+{
+#if IMAGE_DECODER_USE_SSE2
+    __m128i const pixel4 = _mm_set1_epi32((int)pixel);
+    for (; count >= 4; count -= 4, pixels += 4)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels), pixel4);
+    }
+#endif
+    for (; count > 0; --count)
+    {
+        *pixels++ = pixel;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+eImageFormat DetectImageFormat(uint8_t const* data, size_t const size)
+{
+    if (size >= 4 && memcmp(data, "qoif", 4) == 0) return eImageFormat::Qoi;
+    return eImageFormat::Unknown;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool ReadQoiInfo(uint8_t const* data, size_t const size, sImageInfo& info)
+{
+    if (size < QOI_HEADER_SIZE + QOI_PADDING_SIZE || DetectImageFormat(data, size) != eImageFormat::Qoi) return false;
+
+    info.width    = ReadBigEndian32(data + 4);
+    info.height   = ReadBigEndian32(data + 8);
+    info.channels = data[12];
+
+    uint8_t const  colorSpace = data[13];
+    uint64_t const pixelCount = (uint64_t)info.width * info.height;
+    if (info.width == 0 || info.height == 0 || pixelCount > QOI_MAX_PIXELS) return false;
+    if ((info.channels != 3 && info.channels != 4) || colorSpace > 1) return false;
+
+    // 損壞的檔頭不能讓呼叫端配置與尺寸相稱的巨大緩衝區
+    uint64_t const opBytes = size - QOI_HEADER_SIZE - QOI_PADDING_SIZE;
+    return pixelCount <= opBytes * QOI_MAX_RUN;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 像素以 uint32_t 整個處理：差值以分通道的整數運算套用，連續重複以 SIMD 填滿
+// 離兩端都還遠時 (剩下至少一個最長的 op) 省去每個 op 的長度檢查，只在接近結尾時逐一檢查
+bool DecodeQoi(uint8_t const* data, size_t const size, uint32_t* pixels)
+{
+    sImageInfo info;
+    if (!ReadQoiInfo(data, size, info)) return false;
+
+    uint8_t const*       input     = data + QOI_HEADER_SIZE;
+    uint8_t const* const inputEnd  = data + size - QOI_PADDING_SIZE;
+    uint32_t* const      outputEnd = pixels + (size_t)info.width * info.height;
+    uint32_t             index[64] = {};
+    uint32_t             pixel     = 0xFF000000;
+
+    while (pixels < outputEnd)
+    {
+        bool const isChecked = inputEnd - input < 5 || (size_t)(outputEnd - pixels) < QOI_MAX_RUN;
+        if (isChecked && input >= inputEnd) return false;
+
+        uint8_t const op = *input++;
+        if (op < QOI_OP_RUN)
+        {
+            // 照片多半在 INDEX、DIFF、LUMA 之間交替，三種結果都算出來再以遮罩選擇，不做難以預測的分支
+            // (第二個位元組無條件讀取；inputEnd 之後還有填充，不會越界)
+            // INDEX 取出的像素再寫回它雜湊值的格子，與規格相同 (從未寫入的格子是 0，寫回第 0 格)
+            uint32_t const isLuma = op >> 7;
+            if (isChecked && isLuma && input >= inputEnd) return false;
+
+            int const      dg        = (op & 0x3F) - 32;
+            uint8_t const  second    = *input;
+            uint32_t const lumaMask  = 0u - isLuma;
+            uint32_t const indexMask = 0u - (uint32_t)(op < QOI_OP_DIFF);
+            uint32_t const diff      = PackChannelDeltas(((op >> 4) & 3) - 2, ((op >> 2) & 3) - 2, (op & 3) - 2);
+            uint32_t const luma      = PackChannelDeltas(dg - 8 + (second >> 4), dg, dg - 8 + (second & 0x0F));
+            uint32_t const moved     = AddChannelDeltas(pixel, (luma & lumaMask) | (diff & ~lumaMask));
+
+            pixel  = (index[op & 0x3F] & indexMask) | (moved & ~indexMask);
+            input += isLuma;
+        }
+        else if (op == QOI_OP_RGB)
+        {
+            if (isChecked && inputEnd - input < 3) return false;
+            pixel  = (pixel & 0xFF000000) | input[0] | (uint32_t)input[1] << 8 | (uint32_t)input[2] << 16;
+            input += 3;
+        }
+        else if (op == QOI_OP_RGBA)
+        {
+            if (isChecked && inputEnd - input < 4) return false;
+            pixel  = input[0] | (uint32_t)input[1] << 8 | (uint32_t)input[2] << 16 | (uint32_t)input[3] << 24;
+            input += 4;
+        }
+        else
+        {
+            // 第一個像素之前的重複使用初始像素，它也要寫入索引表
+            size_t const run = (size_t)(op & 0x3F) + 1;
+            if (isChecked && run > (size_t)(outputEnd - pixels)) return false;
+            index[HashQoiPixel(pixel)] = pixel;
+            FillRun(pixels, pixel, run);
+            pixels += run;
+            continue;
+        }
+
+        index[HashQoiPixel(pixel)] = pixel;
+        *pixels++ = pixel;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool DecodeQoiReference(uint8_t const* data, size_t const size, uint32_t* pixels)
+{
+    struct sColor
+    {
+        uint8_t r = 0;
+        uint8_t g = 0;
+        uint8_t b = 0;
+        uint8_t a = 0;
+    };
+
+    sImageInfo info;
+    if (!ReadQoiInfo(data, size, info)) return false;
+
+    size_t const pixelCount = (size_t)info.width * info.height;
+    size_t const inputEnd   = size - QOI_PADDING_SIZE;
+    size_t       position   = QOI_HEADER_SIZE;
+    sColor       index[64];
+    sColor       pixel;
+    pixel.a = 255;
+
+    size_t run = 0;
+    for (size_t i = 0; i < pixelCount; ++i)
+    {
+        if (run > 0)
+        {
+            --run;
+        }
+        else
+        {
+            if (position >= inputEnd) return false;
+
+            uint8_t const op = data[position++];
+            if (op == QOI_OP_RGB)
+            {
+                if (position + 3 > inputEnd) return false;
+                pixel.r = data[position++];
+                pixel.g = data[position++];
+                pixel.b = data[position++];
+            }
+            else if (op == QOI_OP_RGBA)
+            {
+                if (position + 4 > inputEnd) return false;
+                pixel.r = data[position++];
+                pixel.g = data[position++];
+                pixel.b = data[position++];
+                pixel.a = data[position++];
+            }
+            else if ((op & QOI_MASK_2) == QOI_OP_INDEX)
+            {
+                pixel = index[op];
+            }
+            else if ((op & QOI_MASK_2) == QOI_OP_DIFF)
+            {
+                pixel.r += ((op >> 4) & 3) - 2;
+                pixel.g += ((op >> 2) & 3) - 2;
+                pixel.b += (op & 3) - 2;
+            }
+            else if ((op & QOI_MASK_2) == QOI_OP_LUMA)
+            {
+                if (position >= inputEnd) return false;
+                uint8_t const second = data[position++];
+                int const     dg     = (op & 0x3F) - 32;
+                pixel.r += dg - 8 + ((second >> 4) & 0x0F);
+                pixel.g += dg;
+                pixel.b += dg - 8 + (second & 0x0F);
+            }
+            else
+            {
+                run = op & 0x3F;
+            }
+
+            index[(pixel.r * 3 + pixel.g * 5 + pixel.b * 7 + pixel.a * 11) % 64] = pixel;
+        }
+
+        uint8_t* const output = reinterpret_cast<uint8_t*>(pixels + i);
+        output[0]             = pixel.r;
+        output[1]             = pixel.g;
+        output[2]             = pixel.b;
+        output[3]             = pixel.a;
+    }
+
+    // 最後一個重複超出影像
+    return run == 0;
+}
@@ -0,0 +1,40 @@
+﻿//----------------------------------------------------------------------------------------------------
+// ImageDecoder.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+//----------------------------------------------------------------------------------------------------
+// 內建解碼器支援的格式；其他格式 (PNG、JPEG...) 由 WIC 解碼
+enum class eImageFormat : uint8_t
+{
+    Unknown,
+    Qoi,
+};
+
+struct sImageInfo
+{
+    unsigned int width    = 0;
+    unsigned int height   = 0;
+    unsigned int channels = 0;              // 檔案記錄的通道數 (3 或 4)，只供參考；解碼結果一律為 RGBA8
+};
+
+//----------------------------------------------------------------------------------------------------
+unsigned int const QOI_MAX_PIXELS = 400000000;      // 與參考實作 (qoi.h) 相同的上限
+
+// 依檔頭判斷格式 (至少需要 4 位元組)
+eImageFormat DetectImageFormat(uint8_t const* data, size_t size);
+
+// 檢查檔頭；尺寸為 0、超過上限，或資料長度不可能容納這麼多像素 (每個 op 最多 62 個) 時回傳 false
+bool ReadQoiInfo(uint8_t const* data, size_t size, sImageInfo& info);
+
+// 解碼到 pixels (RGBA8，R 在最低位元組，width * height 個像素緊密排列)，即 R8G8B8A8 紋理的上傳格式
+// 資料被截斷、op 超出影像或在結尾的 8 位元組填充之後時回傳 false，pixels 的內容未定義
+// QOI 的每個 op 依賴前一個像素與 64 格的索引表，同一張圖無法分段平行解碼
+bool DecodeQoi(uint8_t const* data, size_t size, uint32_t* pixels);
+
+// 依規格逐位元組的純量版本，作為 DecodeQoi 的比對基準 (結果與成功與否都必須相同)
+bool DecodeQoiReference(uint8_t const* data, size_t size, uint32_t* pixels);
@@ -0,0 +1,449 @@
+﻿//----------------------------------------------------------------------------------------------------
+// ImageDecoderCheckMain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// 內建 QOI 解碼器的檢查、模糊測試與基準 (不屬於 Windows 專案，在 Linux 上單獨編譯)：
+//
+//   g++ -std=c++14 -O2 ImageDecoderCheckMain.cpp ImageDecoder.cpp -o image_decoder_check
+//   ./image_decoder_check [fuzz iterations]
+//
+// 以依規格實作的編碼器產生各種合成圖 (漸層、雜訊、半透明、大片純色、少量顏色)，確認兩個解碼器都還原原圖；
+// 再對編碼結果隨機改寫、截斷、竄改檔頭，兩者的成功與否與像素必須相同，且不能寫出緩衝區；
+// 最後以 2048x2048 的圖比較 DecodeQoi 與 DecodeQoiReference 的速度
+// 結束碼：0 = 全部通過，1 = 失敗
+//----------------------------------------------------------------------------------------------------
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "CheckMain.hpp"
+#include "ImageDecoder.hpp"
+
+//----------------------------------------------------------------------------------------------------
+static uint32_t const GUARD_PIXEL = 0xDEADBEEF;
+static size_t const   GUARD_COUNT = 64;
+
+//----------------------------------------------------------------------------------------------------
+static uint32_t PackPixel(int const r, int const g, int const b, int const a)
+{
+    return (uint32_t)(r & 0xFF) | (uint32_t)(g & 0xFF) << 8 | (uint32_t)(b & 0xFF) << 16 | (uint32_t)(a & 0xFF) << 24;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 依規格的編碼器 (與 qoi.h 相同的選擇順序)；channels 為 3 時 alpha 視為 255
+static std::vector<uint8_t> EncodeQoi(std::vector<uint32_t> const& pixels,
+                                      unsigned int const           width,
+                                      unsigned int const           height,
+                                      unsigned int const           channels)
+{
+    std::vector<uint8_t> output = {'q', 'o', 'i', 'f'};
+    for (unsigned int const value : {width, height})
+    {
+        output.push_back((uint8_t)(value >> 24));
+        output.push_back((uint8_t)(value >> 16));
+        output.push_back((uint8_t)(value >> 8));
+        output.push_back((uint8_t)value);
+    }
+    output.push_back((uint8_t)channels);
+    output.push_back(0);
+
+    uint32_t     index[64] = {};
+    uint32_t     previous  = PackPixel(0, 0, 0, 255);
+    unsigned int run       = 0;
+    for (size_t i = 0; i < pixels.size(); ++i)
+    {
+        uint32_t const pixel = channels == 3 ? (pixels[i] | 0xFF000000) : pixels[i];
+        int const      r     = pixel & 0xFF;
+        int const      g     = pixel >> 8 & 0xFF;
+        int const      b     = pixel >> 16 & 0xFF;
+        int const      a     = pixel >> 24;
+
+        if (pixel == previous)
+        {
+            ++run;
+            if (run == 62 || i + 1 == pixels.size())
+            {
+                output.push_back((uint8_t)(0xC0 | (run - 1)));
+                run = 0;
+            }
+            continue;
+        }
+
+        if (run > 0)
+        {
+            output.push_back((uint8_t)(0xC0 | (run - 1)));
+            run = 0;
+        }
+
+        unsigned int const hash = (r * 3 + g * 5 + b * 7 + a * 11) % 64;
+        if (index[hash] == pixel)
+        {
+            output.push_back((uint8_t)hash);
+        }
+        else
+        {
+            index[hash] = pixel;
+
+            int const previousR = previous & 0xFF;
+            int const previousG = previous >> 8 & 0xFF;
+            int const previousB = previous >> 16 & 0xFF;
+            int const previousA = previous >> 24;
+            if (a == previousA)
+            {
+                int const dr  = (int8_t)(uint8_t)(r - previousR);
+                int const dg  = (int8_t)(uint8_t)(g - previousG);
+                int const db  = (int8_t)(uint8_t)(b - previousB);
+                int const dgr = dr - dg;
+                int const dgb = db - dg;
+
+                if (dr > -3 && dr < 2 && dg > -3 && dg < 2 && db > -3 && db < 2)
+                {
+                    output.push_back((uint8_t)(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+                }
+                else if (dgr > -9 && dgr < 8 && dg > -33 && dg < 32 && dgb > -9 && dgb < 8)
+                {
+                    output.push_back((uint8_t)(0x80 | (dg + 32)));
+                    output.push_back((uint8_t)((dgr + 8) << 4 | (dgb + 8)));
+                }
+                else
+                {
+                    output.insert(output.end(), {0xFE, (uint8_t)r, (uint8_t)g, (uint8_t)b});
+                }
+            }
+            else
+            {
+                output.insert(output.end(), {0xFF, (uint8_t)r, (uint8_t)g, (uint8_t)b, (uint8_t)a});
+            }
+        }
+        previous = pixel;
+    }
+
+    output.insert(output.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+    return output;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 合成圖：每一種都偏重不同的 op
+enum class eImageKind
+{
+    Gradient,                               // 緩慢變化 (DIFF / LUMA)
+    Noise,                                  // 不透明雜訊 (RGB)
+    AlphaNoise,                             // 半透明雜訊 (RGBA)
+    Blocks,                                 // 大片純色 (超過 62 個像素的 RUN)
+    Palette,                                // 少量顏色 (INDEX)
+    Photo,                                  // 漸層加上小幅雜訊，接近照片
+    Count
+};
+
+static std::vector<uint32_t> MakeImage(eImageKind const kind, unsigned int const width, unsigned int const height, uint32_t seed)
+{
+    uint32_t palette[6];
+    for (uint32_t& color : palette)
+    {
+        color = NextRandom(seed) | 0xFF000000;
+    }
+
+    std::vector<uint32_t> pixels((size_t)width * height);
+    for (unsigned int y = 0; y < height; ++y)
+    {
+        for (unsigned int x = 0; x < width; ++x)
+        {
+            uint32_t const random = NextRandom(seed);
+            uint32_t&      pixel  = pixels[(size_t)y * width + x];
+            switch (kind)
+            {
+                case eImageKind::Gradient:   pixel = PackPixel(x, y, x + y, 255); break;
+                case eImageKind::Noise:      pixel = random | 0xFF000000; break;
+                case eImageKind::AlphaNoise: pixel = random % 3 == 0 ? pixels[(size_t)y * width + (x > 0 ? x - 1 : 0)] : random; break;
+                case eImageKind::Blocks:     pixel = palette[(x / 97 + y / 31) % 6]; break;
+                case eImageKind::Palette:    pixel = palette[random % 6]; break;
+                default:
+                {
+                    // 平滑的漸層，亮度小幅抖動 (三個通道一起)，偶爾有較大的跳動
+                    int const noise = (int)(random & 3) - 1 + ((random >> 8 & 31) == 0 ? (int)(random >> 16 & 63) : 0);
+                    pixel = PackPixel(x / 8 + noise, y / 8 + noise, (x + y) / 16 + noise, 255);
+                    break;
+                }
+            }
+        }
+    }
+    return pixels;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 兩個解碼器解碼同一份資料：成功與否與像素相同，且沒有寫到 width * height 之後
+struct sDecodeResult
+{
+    bool isAgreeing  = false;
+    bool isDecoded   = false;
+    bool isGuardSafe = false;
+};
+
+static sDecodeResult DecodeBoth(std::vector<uint8_t> const& data, std::vector<uint32_t>* decoded = nullptr)
+{
+    sDecodeResult result;
+
+    sImageInfo info;
+    size_t const pixelCount = ReadQoiInfo(data.data(), data.size(), info) ? (size_t)info.width * info.height : 0;
+
+    std::vector<uint32_t> fast(pixelCount + GUARD_COUNT, GUARD_PIXEL);
+    std::vector<uint32_t> reference(pixelCount + GUARD_COUNT, GUARD_PIXEL);
+    bool const            isFastDecoded      = DecodeQoi(data.data(), data.size(), fast.data());
+    bool const            isReferenceDecoded = DecodeQoiReference(data.data(), data.size(), reference.data());
+
+    result.isDecoded   = isFastDecoded;
+    result.isAgreeing  = isFastDecoded == isReferenceDecoded &&
+                         (!isFastDecoded || memcmp(fast.data(), reference.data(), pixelCount * sizeof(uint32_t)) == 0);
+    result.isGuardSafe = true;
+    for (size_t i = pixelCount; i < fast.size(); ++i)
+    {
+        result.isGuardSafe &= fast[i] == GUARD_PIXEL && reference[i] == GUARD_PIXEL;
+    }
+
+    if (decoded)
+    {
+        fast.resize(pixelCount);
+        *decoded = fast;
+    }
+    return result;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 各種合成圖與尺寸 (含 1x1 與奇數尺寸)，3 與 4 通道：兩個解碼器都還原原圖，且用到所有的 op
+static bool CheckRoundTrip()
+{
+    unsigned int const sizes[][2] = {{1, 1}, {7, 3}, {64, 64}, {333, 17}, {250, 250}};
+
+    bool isRestored = true;
+    bool isAgreeing = true;
+    bool isOpSeen[6] = {};
+    for (size_t kind = 0; kind < (size_t)eImageKind::Count; ++kind)
+    {
+        for (auto const& size : sizes)
+        {
+            for (unsigned int const channels : {3u, 4u})
+            {
+                std::vector<uint32_t> pixels = MakeImage((eImageKind)kind, size[0], size[1], (uint32_t)(kind * 977 + size[0] + 1));
+                std::vector<uint8_t> const encoded = EncodeQoi(pixels, size[0], size[1], channels);
+                if (channels == 3)
+                {
+                    for (uint32_t& pixel : pixels) pixel |= 0xFF000000;
+                }
+
+                std::vector<uint32_t> decoded;
+                sDecodeResult const   result = DecodeBoth(encoded, &decoded);
+                isRestored &= result.isDecoded && decoded == pixels;
+                isAgreeing &= result.isAgreeing && result.isGuardSafe;
+
+                // 依規格逐一走過 op，記錄出現過的種類
+                for (size_t i = 14; i + 8 < encoded.size();)
+                {
+                    uint8_t const op = encoded[i];
+                    size_t const  type = op == 0xFE ? 4 : op == 0xFF ? 5 : (size_t)(op >> 6);
+                    isOpSeen[type]     = true;
+                    i += op == 0xFE ? 4 : op == 0xFF ? 5 : (op >> 6) == 2 ? 2 : 1;
+                }
+            }
+        }
+    }
+
+    bool isEveryOpSeen = true;
+    for (bool const isSeen : isOpSeen)
+    {
+        isEveryOpSeen &= isSeen;
+    }
+
+    bool isPassing = true;
+    isPassing &= Check(isRestored, "round_trip");
+    isPassing &= Check(isAgreeing, "round_trip_reference");
+    isPassing &= Check(isEveryOpSeen, "round_trip_all_ops");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 手寫的串流：從未寫入的索引格 (值為 0) 要覆寫第 0 格；第一個像素之前的 RUN；不合法的檔頭與結尾
+static bool CheckEdgeCases()
+{
+    std::vector<uint8_t> const header3x1 = {'q', 'o', 'i', 'f', 0, 0, 0, 3, 0, 0, 0, 1, 4, 0};
+    std::vector<uint8_t> const padding   = {0, 0, 0, 0, 0, 0, 0, 1};
+
+    // (0, 0, 29, 255) 的雜湊值為 0：放進第 0 格後，讀取未寫入的第 5 格 (0) 會把第 0 格改成 0
+    std::vector<uint8_t> unsetIndex = header3x1;
+    unsetIndex.insert(unsetIndex.end(), {0xFE, 0, 0, 29, 0x05, 0x00});
+    unsetIndex.insert(unsetIndex.end(), padding.begin(), padding.end());
+
+    std::vector<uint32_t> decoded;
+    sDecodeResult const   unsetResult = DecodeBoth(unsetIndex, &decoded);
+    bool const            isUnsetOk   = unsetResult.isDecoded && unsetResult.isAgreeing &&
+                                        decoded == std::vector<uint32_t>({PackPixel(0, 0, 29, 255), 0, 0});
+
+    // 開頭的 RUN 重複初始像素 (0, 0, 0, 255)，之後的 INDEX 讀到它
+    std::vector<uint8_t> leadingRun = header3x1;
+    unsigned int const   initialHash = (255 * 11) % 64;
+    leadingRun.insert(leadingRun.end(), {0xC1, (uint8_t)initialHash});
+    leadingRun.insert(leadingRun.end(), padding.begin(), padding.end());
+
+    sDecodeResult const runResult = DecodeBoth(leadingRun, &decoded);
+    bool const          isRunOk   = runResult.isDecoded && runResult.isAgreeing && decoded == std::vector<uint32_t>(3, PackPixel(0, 0, 0, 255));
+
+    // RUN 超出影像、op 延伸到結尾的填充、像素不足
+    std::vector<uint8_t> overrun = header3x1;
+    overrun.insert(overrun.end(), {0xC3});
+    overrun.insert(overrun.end(), padding.begin(), padding.end());
+
+    std::vector<uint8_t> intoPadding = header3x1;
+    intoPadding.insert(intoPadding.end(), {0xC1, 0xFF, 1, 2});
+    intoPadding.insert(intoPadding.end(), padding.begin(), padding.end());
+
+    std::vector<uint8_t> shortData = header3x1;
+    shortData.insert(shortData.end(), {0xC0});
+    shortData.insert(shortData.end(), padding.begin(), padding.end());
+
+    bool isRejected = true;
+    for (std::vector<uint8_t> const* data : {&overrun, &intoPadding, &shortData})
+    {
+        sDecodeResult const result = DecodeBoth(*data);
+        isRejected &= !result.isDecoded && result.isAgreeing && result.isGuardSafe;
+    }
+
+    // 檔頭：錯誤的標記、通道數、色彩空間、0 尺寸，以及資料長度不可能容納的尺寸
+    sImageInfo                       info;
+    std::vector<std::vector<uint8_t>> headers(5, unsetIndex);
+    headers[0][0]  = 'Q';
+    headers[1][12] = 2;
+    headers[2][13] = 2;
+    headers[3][11] = 0;
+    headers[4][4]  = 0x7F;
+
+    bool isHeaderRejected = true;
+    for (std::vector<uint8_t> const& data : headers)
+    {
+        isHeaderRejected &= !ReadQoiInfo(data.data(), data.size(), info) && !DecodeQoi(data.data(), data.size(), nullptr);
+    }
+
+    bool isPassing = true;
+    isPassing &= Check(isUnsetOk, "unset_index");
+    isPassing &= Check(isRunOk, "leading_run");
+    isPassing &= Check(isRejected, "corrupt_streams");
+    isPassing &= Check(isHeaderRejected, "corrupt_headers");
+    isPassing &= Check(DetectImageFormat(unsetIndex.data(), unsetIndex.size()) == eImageFormat::Qoi &&
+                       DetectImageFormat(headers[0].data(), headers[0].size()) == eImageFormat::Unknown, "detect_format");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 隨機改寫編碼結果：兩個解碼器的結果永遠相同，且不會寫出 width * height 之外
+static bool CheckFuzz(unsigned int const iterations)
+{
+    std::vector<std::vector<uint8_t>> bases;
+    for (size_t kind = 0; kind < (size_t)eImageKind::Count; ++kind)
+    {
+        bases.push_back(EncodeQoi(MakeImage((eImageKind)kind, 37, 23, (uint32_t)kind + 11), 37, 23, 4));
+    }
+
+    uint32_t     seed        = 0x2545F491;
+    unsigned int decodedRuns = 0;
+    bool         isAgreeing  = true;
+    bool         isSafe      = true;
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        std::vector<uint8_t> data = bases[NextRandom(seed) % bases.size()];
+        size_t const         size = data.size();
+        switch (NextRandom(seed) % 5)
+        {
+            case 0:
+                // 改寫幾個 op 位元組
+                for (uint32_t k = NextRandom(seed) % 4 + 1; k > 0; --k)
+                {
+                    data[14 + NextRandom(seed) % (size - 14)] ^= (uint8_t)(1 << (NextRandom(seed) % 8));
+                }
+                break;
+            case 1:
+                data.resize(NextRandom(seed) % size);
+                break;
+            case 2:
+                // 一段隨機位元組
+                for (size_t k = 14 + NextRandom(seed) % (size - 14), end = (std::min)(size, k + NextRandom(seed) % 32); k < end; ++k)
+                {
+                    data[k] = (uint8_t)NextRandom(seed);
+                }
+                break;
+            case 3:
+                // 尺寸改成其他值 (通常與資料不符)
+                data[7]  = (uint8_t)(NextRandom(seed) % 64 + 1);
+                data[11] = (uint8_t)(NextRandom(seed) % 64 + 1);
+                break;
+            default:
+                // 只保留檔頭，其餘全部隨機
+                for (size_t k = 14; k < size; ++k)
+                {
+                    data[k] = (uint8_t)NextRandom(seed);
+                }
+                break;
+        }
+
+        sDecodeResult const result = DecodeBoth(data);
+        isAgreeing &= result.isAgreeing;
+        isSafe     &= result.isGuardSafe;
+        decodedRuns += result.isDecoded ? 1 : 0;
+    }
+
+    printf("fuzz_iterations %u\n", iterations);
+    printf("fuzz_decoded %u\n", decodedRuns);
+
+    bool isPassing = true;
+    isPassing &= Check(isAgreeing, "fuzz_reference");
+    isPassing &= Check(isSafe, "fuzz_bounds");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+int main(int const argc, char** argv)
+{
+    using Clock = std::chrono::steady_clock;
+
+    unsigned int const iterations = argc > 1 ? (unsigned int)strtoul(argv[1], nullptr, 0) : 200000u;
+
+    bool isPassing = true;
+    isPassing &= CheckRoundTrip();
+    isPassing &= CheckEdgeCases();
+    isPassing &= CheckFuzz(iterations);
+
+    // 基準：接近照片的 2048x2048 圖，各解碼數次取最短時間
+    unsigned int const          size    = 2048;
+    std::vector<uint32_t> const image   = MakeImage(eImageKind::Photo, size, size, 7);
+    std::vector<uint8_t> const  encoded = EncodeQoi(image, size, size, 4);
+    std::vector<uint32_t>       fast(image.size());
+    std::vector<uint32_t>       reference(image.size());
+
+    double fastMs      = 1e30;
+    double referenceMs = 1e30;
+    bool   isDecoded   = true;
+    for (int repeat = 0; repeat < 5; ++repeat)
+    {
+        Clock::time_point const start = Clock::now();
+        isDecoded &= DecodeQoi(encoded.data(), encoded.size(), fast.data());
+        Clock::time_point const middle = Clock::now();
+        isDecoded &= DecodeQoiReference(encoded.data(), encoded.size(), reference.data());
+        Clock::time_point const end = Clock::now();
+
+        fastMs      = (std::min)(fastMs, std::chrono::duration<double, std::milli>(middle - start).count());
+        referenceMs = (std::min)(referenceMs, std::chrono::duration<double, std::milli>(end - middle).count());
+    }
+
+    double const megapixels = (double)image.size() / 1e6;
+    printf("benchmark_pixels %zu\n", image.size());
+    printf("benchmark_encoded_bytes %zu\n", encoded.size());
+    printf("decode_ms %.3f\n", fastMs);
+    printf("decode_mpixels_per_second %.1f\n", megapixels / (fastMs / 1000.0));
+    printf("reference_decode_ms %.3f\n", referenceMs);
+    printf("reference_mpixels_per_second %.1f\n", megapixels / (referenceMs / 1000.0));
+    printf("speedup %.2f\n", referenceMs / fastMs);
+
+    isPassing &= Check(isDecoded && fast == image && reference == image, "benchmark_decode");
+    return isPassing ? 0 : 1;
+}
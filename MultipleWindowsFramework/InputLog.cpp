@@ -0,0 +1,290 @@
+﻿//----------------------------------------------------------------------------------------------------
+// InputLog.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "InputLog.hpp"
+
+#include <cstring>
+
+//----------------------------------------------------------------------------------------------------
+size_t const INPUT_LOG_FLUSH_BYTES = 64 * 1024;
+
+//----------------------------------------------------------------------------------------------------
+static FILE* OpenFile(char const* path, char const* mode)
+{
+#if defined(_MSC_VER)
+    FILE* file = nullptr;
+    return fopen_s(&file, path, mode) == 0 ? file : nullptr;
+#else
+    return fopen(path, mode);
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------
+static void PutU32(std::vector<uint8_t>& buffer, uint32_t const value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        buffer.push_back((uint8_t)(value >> (i * 8)));
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+static void PutFloat(std::vector<uint8_t>& buffer, float const value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    PutU32(buffer, bits);
+}
+
+//----------------------------------------------------------------------------------------------------
+static void PutVarint(std::vector<uint8_t>& buffer, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        buffer.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back((uint8_t)value);
+}
+
+//----------------------------------------------------------------------------------------------------
+static void PutSigned(std::vector<uint8_t>& buffer, int32_t const value)
+{
+    // zigzag：絕對值小的負數也只佔 1 位元組
+    uint32_t const zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    PutVarint(buffer, zigzag);
+}
+
+//----------------------------------------------------------------------------------------------------
+InputLogWriter::~InputLogWriter()
+{
+    Close();
+}
+
+//----------------------------------------------------------------------------------------------------
+bool InputLogWriter::Open(char const* path, sInputLogHeader const& header)
+{
+    Close();
+
+    m_file = OpenFile(path, "wb");
+    if (!m_file) return false;
+
+    m_buffer.clear();
+    m_buffer.reserve(INPUT_LOG_FLUSH_BYTES + 256);
+    m_bytesWritten = 0;
+
+    PutU32(m_buffer, INPUT_LOG_MAGIC);
+    PutU32(m_buffer, INPUT_LOG_VERSION);
+    PutU32(m_buffer, header.seed);
+    PutFloat(m_buffer, header.frameTime);
+    PutFloat(m_buffer, header.simulationStep);
+    PutU32(m_buffer, (uint32_t)header.boundsWidth);
+    PutU32(m_buffer, (uint32_t)header.boundsHeight);
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+void InputLogWriter::Close()
+{
+    if (!m_file) return;
+
+    Flush();
+    fclose(m_file);
+    m_file = nullptr;
+}
+
+//----------------------------------------------------------------------------------------------------
+void InputLogWriter::Write(sInputEvent const& event)
+{
+    if (!m_file) return;
+
+    m_buffer.push_back((uint8_t)event.type);
+    switch (event.type)
+    {
+    case eInputEventType::AddWindow:
+        PutVarint(m_buffer, event.windowId);
+        PutSigned(m_buffer, event.x);
+        PutSigned(m_buffer, event.y);
+        PutSigned(m_buffer, event.width);
+        PutSigned(m_buffer, event.height);
+        break;
+    case eInputEventType::SetDriftParams:
+        {
+            sDriftParams const& params = event.params;
+            PutVarint(m_buffer, event.windowId);
+            PutFloat(m_buffer, params.velocityX);
+            PutFloat(m_buffer, params.velocityY);
+            PutFloat(m_buffer, params.acceleration);
+            PutFloat(m_buffer, params.drag);
+            PutFloat(m_buffer, params.bounceEnergy);
+            PutFloat(m_buffer, params.wanderStrength);
+            PutFloat(m_buffer, params.targetVelocity);
+            m_buffer.push_back((uint8_t)((params.enableGravity ? 1 : 0) | (params.enableWander ? 2 : 0) |
+                                         (params.bounce == eDriftBounce::Elastic ? 4 : 0)));
+            break;
+        }
+    case eInputEventType::StartDrag:
+    case eInputEventType::UpdateDrag:
+        PutVarint(m_buffer, event.windowId);
+        PutSigned(m_buffer, event.x);
+        PutSigned(m_buffer, event.y);
+        break;
+    case eInputEventType::StopDrag:
+        PutVarint(m_buffer, event.windowId);
+        PutFloat(m_buffer, event.velocityX);
+        PutFloat(m_buffer, event.velocityY);
+        break;
+    case eInputEventType::FrameEnd:
+        PutU32(m_buffer, (uint32_t)event.checksum);
+        PutU32(m_buffer, (uint32_t)(event.checksum >> 32));
+        break;
+    }
+
+    if (m_buffer.size() >= INPUT_LOG_FLUSH_BYTES)
+    {
+        Flush();
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+void InputLogWriter::Flush()
+{
+    if (m_buffer.empty()) return;
+
+    m_bytesWritten += fwrite(m_buffer.data(), 1, m_buffer.size(), m_file);
+    m_buffer.clear();
+}
+
+//----------------------------------------------------------------------------------------------------
+bool InputLogReader::Open(char const* path)
+{
+    FILE* const file = OpenFile(path, "rb");
+    if (!file) return false;
+
+    std::vector<uint8_t> data;
+    uint8_t              chunk[64 * 1024];
+    size_t               read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        data.insert(data.end(), chunk, chunk + read);
+    }
+    fclose(file);
+
+    return Open(data.data(), data.size());
+}
+
+//----------------------------------------------------------------------------------------------------
+bool InputLogReader::Open(uint8_t const* data, size_t const size)
+{
+    m_data.assign(data, data + size);
+    m_position = 0;
+    m_hasError = false;
+    m_header   = sInputLogHeader();
+
+    uint32_t magic   = 0;
+    uint32_t version = 0;
+    uint32_t width   = 0;
+    uint32_t height  = 0;
+    if (!ReadBytes(&magic, 4) || !ReadBytes(&version, 4) || !ReadBytes(&m_header.seed, 4) ||
+        !ReadBytes(&m_header.frameTime, 4) || !ReadBytes(&m_header.simulationStep, 4) ||
+        !ReadBytes(&width, 4) || !ReadBytes(&height, 4))
+    {
+        return false;
+    }
+    m_header.boundsWidth  = (int32_t)width;
+    m_header.boundsHeight = (int32_t)height;
+
+    // 時間欄位來自檔案，超出合理範圍 (包含 NaN) 視為損壞
+    bool const isTimeValid = m_header.frameTime > 0.f && m_header.frameTime < 60.f &&
+                             m_header.simulationStep > 0.f && m_header.simulationStep < 60.f;
+    return magic == INPUT_LOG_MAGIC && version == INPUT_LOG_VERSION && isTimeValid;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool InputLogReader::Next(sInputEvent& event)
+{
+    if (m_hasError || m_position >= m_data.size()) return false;
+
+    event      = sInputEvent();
+    event.type = (eInputEventType)m_data[m_position++];
+
+    uint64_t id     = 0;
+    bool     isRead = false;
+    switch (event.type)
+    {
+    case eInputEventType::AddWindow:
+        isRead = ReadVarint(id) && ReadSigned(event.x) && ReadSigned(event.y) &&
+                 ReadSigned(event.width) && ReadSigned(event.height);
+        break;
+    case eInputEventType::SetDriftParams:
+        {
+            sDriftParams& params = event.params;
+            uint8_t       flags  = 0;
+            isRead = ReadVarint(id) &&
+                     ReadBytes(&params.velocityX, 4) && ReadBytes(&params.velocityY, 4) &&
+                     ReadBytes(&params.acceleration, 4) && ReadBytes(&params.drag, 4) &&
+                     ReadBytes(&params.bounceEnergy, 4) && ReadBytes(&params.wanderStrength, 4) &&
+                     ReadBytes(&params.targetVelocity, 4) && ReadBytes(&flags, 1);
+            params.enableGravity = (flags & 1) != 0;
+            params.enableWander  = (flags & 2) != 0;
+            params.bounce        = (flags & 4) != 0 ? eDriftBounce::Elastic : eDriftBounce::Jitter;
+            break;
+        }
+    case eInputEventType::StartDrag:
+    case eInputEventType::UpdateDrag:
+        isRead = ReadVarint(id) && ReadSigned(event.x) && ReadSigned(event.y);
+        break;
+    case eInputEventType::StopDrag:
+        isRead = ReadVarint(id) && ReadBytes(&event.velocityX, 4) && ReadBytes(&event.velocityY, 4);
+        break;
+    case eInputEventType::FrameEnd:
+        isRead = ReadBytes(&event.checksum, 8);
+        break;
+    }
+
+    if (!isRead || id > 0xFFFFFFFF)
+    {
+        m_hasError = true;
+        return false;
+    }
+    event.windowId = (uint32_t)id;
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool InputLogReader::ReadVarint(uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (m_position >= m_data.size()) return false;
+
+        uint8_t const byte = m_data[m_position++];
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool InputLogReader::ReadSigned(int32_t& value)
+{
+    uint64_t zigzag = 0;
+    if (!ReadVarint(zigzag) || zigzag > 0xFFFFFFFF) return false;
+
+    value = (int32_t)((uint32_t)(zigzag >> 1) ^ (0u - (uint32_t)(zigzag & 1)));
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool InputLogReader::ReadBytes(void* data, size_t const size)
+{
+    // 寫入端固定為 little-endian，與本專案支援的平台相同
+    if (m_data.size() - m_position < size) return false;
+
+    memcpy(data, m_data.data() + m_position, size);
+    m_position += size;
+    return true;
+}
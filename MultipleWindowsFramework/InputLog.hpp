@@ -0,0 +1,105 @@
+﻿//----------------------------------------------------------------------------------------------------
+// InputLog.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "DriftSimulation.hpp"
+
+//----------------------------------------------------------------------------------------------------
+// 檔案格式：sInputLogHeader 的欄位 (little-endian) 之後是事件流
+// 每個事件以 1 位元組的類型開頭，整數欄位為 varint (座標以 zigzag 編碼)
+// 幀之間沒有時間戳記：每幀的事件之後接一個 FrameEnd，回放時依序套用事件再前進一步
+uint32_t const INPUT_LOG_MAGIC   = 0x4C49574D;  // "MWIL"
+uint32_t const INPUT_LOG_VERSION = 4;      // 3：漂移亂數改為 sDriftRandom；4：StopDrag 帶有放開時的速度
+
+enum class eInputEventType : uint8_t
+{
+    AddWindow      = 1,                     // windowId 依加入順序，x/y/width/height 為初始位置與客戶區大小
+    SetDriftParams = 2,
+    StartDrag      = 3,                     // x/y 為滑鼠位置
+    UpdateDrag     = 4,
+    StopDrag       = 5,                     // velocityX/Y 為放開時的速度 (像素/秒)
+    FrameEnd       = 6                      // checksum 為這一幀模擬完成後的狀態
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sInputLogHeader
+{
+    uint32_t seed           = 0;                        // 每個窗口的種子為 MixSeed(seed, windowId)
+    float    frameTime      = 1.f / 60.f;               // 每幀經過的秒數
+    float    simulationStep = DRIFT_SIMULATION_STEP;    // 模擬的固定步長，每幀執行 FixedTimestep 決定的步數
+    int32_t  boundsWidth    = 0;                        // 虛擬螢幕大小
+    int32_t  boundsHeight   = 0;
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sInputEvent
+{
+    eInputEventType type      = eInputEventType::FrameEnd;
+    uint32_t        windowId  = 0;
+    int32_t         x         = 0;
+    int32_t         y         = 0;
+    int32_t         width     = 0;
+    int32_t         height    = 0;
+    uint64_t        checksum  = 0;
+    float           velocityX = 0;
+    float           velocityY = 0;
+    sDriftParams    params;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 事件先編碼到記憶體，累積一定大小才寫入檔案，記錄本身不會讓幀時間出現尖峰
+class InputLogWriter
+{
+public:
+    InputLogWriter() = default;
+    ~InputLogWriter();
+
+    InputLogWriter(InputLogWriter const&)            = delete;
+    InputLogWriter& operator=(InputLogWriter const&) = delete;
+
+    bool Open(char const* path, sInputLogHeader const& header);
+    void Close();
+    bool IsOpen() const { return m_file != nullptr; }
+
+    void Write(sInputEvent const& event);
+
+    unsigned long long GetBytesWritten() const { return m_bytesWritten + m_buffer.size(); }
+
+private:
+    void Flush();
+
+    FILE*                m_file         = nullptr;
+    std::vector<uint8_t> m_buffer;
+    unsigned long long   m_bytesWritten = 0;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 整個檔案讀入記憶體後逐一解碼
+class InputLogReader
+{
+public:
+    bool Open(char const* path);
+    bool Open(uint8_t const* data, size_t size);
+
+    sInputLogHeader const& GetHeader() const { return m_header; }
+
+    // 到達結尾或資料損壞時回傳 false；HasError 區分兩者
+    bool Next(sInputEvent& event);
+    bool HasError() const { return m_hasError; }
+
+private:
+    bool ReadVarint(uint64_t& value);
+    bool ReadSigned(int32_t& value);
+    bool ReadBytes(void* data, size_t size);
+
+    std::vector<uint8_t> m_data;
+    size_t               m_position = 0;
+    sInputLogHeader      m_header;
+    bool                 m_hasError = false;
+};
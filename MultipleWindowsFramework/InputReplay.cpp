@@ -0,0 +1,149 @@
+﻿//----------------------------------------------------------------------------------------------------
+// InputReplay.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "InputReplay.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "DriftSimulation.hpp"
+#include "InputLog.hpp"
+
+//----------------------------------------------------------------------------------------------------
+static void ApplyEvent(DriftSimulation& simulation, sInputLogHeader const& header, sInputEvent const& event)
+{
+    if (event.type == eInputEventType::AddWindow)
+    {
+        // 編號必須與加入順序一致，否則種子會對不上
+        if (event.windowId == simulation.GetWindowCount())
+        {
+            simulation.AddWindow(event.x, event.y, event.width, event.height, MixSeed(header.seed, event.windowId));
+        }
+        return;
+    }
+
+    sDriftBody* const body = simulation.GetWindow(event.windowId);
+    sDriftDrag* const drag = simulation.GetDrag(event.windowId);
+    if (!body) return;
+
+    switch (event.type)
+    {
+    case eInputEventType::SetDriftParams:
+        body->drift = event.params;
+        break;
+    case eInputEventType::StartDrag:
+        BeginDrag(*body, *drag, event.x, event.y);
+        break;
+    case eInputEventType::UpdateDrag:
+        DragTo(*body, *drag, event.x, event.y);
+        break;
+    case eInputEventType::StopDrag:
+        EndDrag(*body, event.velocityX, event.velocityY);
+        break;
+    default:
+        break;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+bool ReplayInputLog(char const* path, sReplayResult& result)
+{
+    result = sReplayResult();
+
+    InputLogReader reader;
+    if (!reader.Open(path)) return false;
+
+    sInputLogHeader const& header = reader.GetHeader();
+
+    DriftSimulation simulation;
+    simulation.Reset(header.boundsWidth, header.boundsHeight);
+
+    // 與錄製端相同的累加器，每幀的步數才會一致
+    FixedTimestep timestep(header.simulationStep);
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point const replayStart = Clock::now();
+    Clock::time_point       frameStart  = replayStart;
+
+    sInputEvent event;
+    while (reader.Next(event))
+    {
+        if (event.type != eInputEventType::FrameEnd)
+        {
+            ApplyEvent(simulation, header, event);
+            ++result.eventCount;
+            continue;
+        }
+
+        unsigned int const steps = timestep.AdvanceSeconds(header.frameTime);
+        simulation.Step(timestep.GetStep(), steps);
+        result.stepCount += steps;
+        uint64_t const checksum = simulation.GetChecksum();
+
+        Clock::time_point const frameEnd = Clock::now();
+        result.frameMicroseconds.push_back(std::chrono::duration<float, std::micro>(frameEnd - frameStart).count());
+        frameStart = frameEnd;
+
+        if (checksum != event.checksum)
+        {
+            if (result.mismatchCount == 0) result.firstMismatchFrame = result.frameCount;
+            ++result.mismatchCount;
+        }
+        result.checksums.push_back(checksum);
+        ++result.frameCount;
+    }
+
+    result.totalMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - replayStart).count();
+    result.windowCount       = (unsigned int)simulation.GetWindowCount();
+    result.isLogCorrupt      = reader.HasError();
+
+    if (!result.frameMicroseconds.empty())
+    {
+        std::vector<float> sorted = result.frameMicroseconds;
+        std::sort(sorted.begin(), sorted.end());
+
+        double sum = 0;
+        for (float const value : sorted) sum += value;
+
+        result.minMicroseconds  = sorted.front();
+        result.maxMicroseconds  = sorted.back();
+        result.meanMicroseconds = sum / sorted.size();
+        result.p50Microseconds  = sorted[sorted.size() / 2];
+        result.p99Microseconds  = sorted[(std::min)(sorted.size() - 1, sorted.size() * 99 / 100)];
+        result.stepNanoseconds  = result.stepCount ? sum * 1000.0 / result.stepCount : 0.0;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+void WriteReplayReport(FILE* file, sReplayResult const& result, bool const includeFrames)
+{
+    fprintf(file, "frames %u\n", result.frameCount);
+    fprintf(file, "events %u\n", result.eventCount);
+    fprintf(file, "windows %u\n", result.windowCount);
+    fprintf(file, "steps %u\n", result.stepCount);
+    fprintf(file, "mismatches %u\n", result.mismatchCount);
+    if (result.firstMismatchFrame != REPLAY_NO_MISMATCH)
+    {
+        fprintf(file, "first_mismatch_frame %u\n", result.firstMismatchFrame);
+    }
+    if (result.isLogCorrupt)
+    {
+        fprintf(file, "log_corrupt 1\n");
+    }
+    fprintf(file, "total_ms %.3f\n", result.totalMilliseconds);
+    fprintf(file, "frame_us min %.3f mean %.3f p50 %.3f p99 %.3f max %.3f\n",
+            result.minMicroseconds, result.meanMicroseconds, result.p50Microseconds,
+            result.p99Microseconds, result.maxMicroseconds);
+    fprintf(file, "step_ns %.1f\n", result.stepNanoseconds);
+
+    if (!includeFrames) return;
+
+    fprintf(file, "frame,us,checksum\n");
+    for (size_t i = 0; i < result.checksums.size(); ++i)
+    {
+        fprintf(file, "%zu,%.3f,%016llx\n", i, result.frameMicroseconds[i], (unsigned long long)result.checksums[i]);
+    }
+}
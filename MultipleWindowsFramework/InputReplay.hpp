@@ -0,0 +1,44 @@
+﻿//----------------------------------------------------------------------------------------------------
+// InputReplay.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+unsigned int const REPLAY_NO_MISMATCH = 0xFFFFFFFF;
+
+//----------------------------------------------------------------------------------------------------
+struct sReplayResult
+{
+    unsigned int frameCount         = 0;
+    unsigned int eventCount         = 0;
+    unsigned int windowCount        = 0;
+    unsigned int stepCount          = 0;    // 模擬總步數 (每幀的步數由固定步長累加器決定)
+    unsigned int mismatchCount      = 0;    // 校驗碼與錄製時不同的幀數
+    unsigned int firstMismatchFrame = REPLAY_NO_MISMATCH;
+    bool         isLogCorrupt       = false;
+
+    // 每幀的時間 (套用事件 + 這一幀的所有模擬步)
+    double totalMilliseconds = 0;
+    double minMicroseconds   = 0;
+    double meanMicroseconds  = 0;
+    double p50Microseconds   = 0;
+    double p99Microseconds   = 0;
+    double maxMicroseconds   = 0;
+    double stepNanoseconds   = 0;           // 平均每步 (所有窗口) 的時間
+
+    std::vector<uint64_t> checksums;        // 每幀回放後的狀態
+    std::vector<float>    frameMicroseconds;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 以最快速度無頭回放：不建立窗口也不等待，逐幀比對錄製時的校驗碼
+// 無法開啟檔案時回傳 false；校驗碼不符不算失敗，見 mismatchCount
+bool ReplayInputLog(char const* path, sReplayResult& result);
+
+// 摘要一行一個數值；includeFrames 為 true 時接著列出每幀的時間與校驗碼
+void WriteReplayReport(FILE* file, sReplayResult const& result, bool includeFrames);
@@ -0,0 +1,152 @@
+﻿//----------------------------------------------------------------------------------------------------
+// LayerCompositor.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "LayerCompositor.hpp"
+
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------
+static bool IsSameComposition(std::vector<sLayerStep> const& a, std::vector<sLayerStep> const& b)
+{
+    if (a.size() != b.size()) return false;
+
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if (a[i].layerId != b[i].layerId || a[i].isDirect != b[i].isDirect) return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+unsigned int LayerCompositor::AddLayer(sLayerDesc const& desc)
+{
+    sLayer layer;
+    layer.desc                 = desc;
+    layer.desc.refreshInterval = (std::max)(1u, desc.refreshInterval);
+    m_layers.push_back(layer);
+
+    unsigned int const layerId = (unsigned int)m_layers.size() - 1;
+
+    // 插在第一個 order 比較大的圖層之前，相同 order 維持加入順序
+    auto const position = std::upper_bound(m_drawOrder.begin(), m_drawOrder.end(), layerId,
+                                           [this](unsigned int const lhs, unsigned int const rhs)
+                                           {
+                                               return m_layers[lhs].desc.order < m_layers[rhs].desc.order;
+                                           });
+    m_drawOrder.insert(position, layerId);
+
+    m_plan.redraw.reserve(m_layers.size());
+    m_plan.composite.reserve(m_layers.size());
+    m_lastComposite.reserve(m_layers.size());
+    return layerId;
+}
+
+//----------------------------------------------------------------------------------------------------
+void LayerCompositor::Invalidate(unsigned int const layerId)
+{
+    if (layerId < m_layers.size())
+    {
+        m_layers[layerId].isDirty = true;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+void LayerCompositor::InvalidateAll()
+{
+    for (sLayer& layer : m_layers)
+    {
+        layer.isDirty = true;
+    }
+    m_isCompositionDirty = true;
+}
+
+//----------------------------------------------------------------------------------------------------
+void LayerCompositor::SetVisible(unsigned int const layerId, bool const isVisible)
+{
+    if (layerId < m_layers.size())
+    {
+        m_layers[layerId].isVisible = isVisible;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+sLayerPlan const& LayerCompositor::PlanFrame()
+{
+    m_plan.redraw.clear();
+    m_plan.composite.clear();
+    ++m_stats.frames;
+
+    for (sLayer& layer : m_layers)
+    {
+        ++layer.framesSinceRedraw;
+    }
+
+    // 由上往下找第一個可見的不透明圖層，它底下的圖層完全被蓋住
+    size_t firstDrawn = 0;
+    for (size_t i = m_drawOrder.size(); i-- > 0;)
+    {
+        sLayer const& layer = m_layers[m_drawOrder[i]];
+        if (layer.isVisible && layer.desc.isOpaque)
+        {
+            firstDrawn = i;
+            break;
+        }
+    }
+
+    bool hasDirectDraw = false;
+    for (size_t i = 0; i < m_drawOrder.size(); ++i)
+    {
+        unsigned int const layerId = m_drawOrder[i];
+        sLayer&            layer   = m_layers[layerId];
+        if (!layer.isVisible) continue;
+
+        if (i < firstDrawn)
+        {
+            ++m_stats.layersOccluded;
+            continue;
+        }
+
+        sLayerStep step;
+        step.layerId = layerId;
+
+        if (layer.desc.update == eLayerUpdate::Dynamic)
+        {
+            step.isDirect = true;
+            hasDirectDraw = true;
+            ++m_stats.directDraws;
+        }
+        else if (layer.isDirty ||
+                 (layer.desc.update == eLayerUpdate::Periodic && layer.framesSinceRedraw >= layer.desc.refreshInterval))
+        {
+            m_plan.redraw.push_back(layerId);
+            layer.isDirty           = false;
+            layer.framesSinceRedraw = 0;
+            ++m_stats.layerRedraws;
+        }
+        else
+        {
+            ++m_stats.redrawsAvoided;
+        }
+
+        m_plan.composite.push_back(step);
+    }
+
+    m_plan.needsClear     = m_plan.composite.empty() || !m_layers[m_plan.composite.front().layerId].desc.isOpaque;
+    m_plan.isSceneChanged = m_isCompositionDirty || hasDirectDraw || !m_plan.redraw.empty() ||
+                            !IsSameComposition(m_plan.composite, m_lastComposite);
+
+    if (m_plan.isSceneChanged)
+    {
+        m_lastComposite      = m_plan.composite;
+        m_isCompositionDirty = false;
+        ++m_stats.compositions;
+    }
+    else
+    {
+        ++m_stats.compositionsAvoided;
+    }
+
+    return m_plan;
+}
@@ -0,0 +1,101 @@
+﻿//----------------------------------------------------------------------------------------------------
+// LayerCompositor.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+enum class eLayerUpdate : uint8_t
+{
+    Static,         // 只在 Invalidate 之後重繪
+    Periodic,       // 每 refreshInterval 幀重繪一次 (也可以 Invalidate)
+    Dynamic,        // 每幀都會改變：不快取，合成時直接畫進場景
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sLayerDesc
+{
+    int          order           = 0;                       // 由小到大疊加，相同時依加入順序
+    eLayerUpdate update          = eLayerUpdate::Static;
+    unsigned int refreshInterval = 1;                       // Periodic 用
+    bool         isOpaque        = false;                   // 覆蓋整個場景且不透明，底下的圖層不需要合成
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sLayerStep
+{
+    unsigned int layerId  = 0;
+    bool         isDirect = false;                          // true = Dynamic 圖層，直接繪製；false = 合成快取
+};
+
+//----------------------------------------------------------------------------------------------------
+// PlanFrame 的結果：先把 redraw 內的圖層重繪到各自的快取，再依 composite 的順序由下而上合成
+struct sLayerPlan
+{
+    std::vector<unsigned int> redraw;
+    std::vector<sLayerStep>   composite;
+    bool                      isSceneChanged = true;        // false = 與上一幀的場景完全相同，可整幀略過
+    bool                      needsClear     = true;        // 最底下的圖層不是不透明時要先清除場景
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sLayerCompositorStats
+{
+    long long frames              = 0;
+    long long layerRedraws        = 0;                      // 重繪到快取的次數
+    long long redrawsAvoided      = 0;                      // 內容未變、直接沿用快取的次數
+    long long directDraws         = 0;                      // Dynamic 圖層的繪製次數
+    long long compositions        = 0;                      // 重新合成場景的幀數
+    long long compositionsAvoided = 0;                      // 沿用上一幀場景的幀數
+    long long layersOccluded      = 0;                      // 被不透明圖層蓋住而略過的次數
+
+    void Reset() { *this = sLayerCompositorStats(); }
+};
+
+//----------------------------------------------------------------------------------------------------
+// 場景的圖層順序與失效追蹤，不涉及實際繪製：呼叫端依 PlanFrame 的結果呼叫 RenderBackend 的圖層函式
+// 隱藏或被蓋住的圖層保留失效狀態，重新出現時才重繪
+class LayerCompositor
+{
+public:
+    unsigned int      AddLayer(sLayerDesc const& desc);
+    size_t            GetLayerCount() const { return m_layers.size(); }
+    sLayerDesc const& GetLayerDesc(unsigned int layerId) const { return m_layers[layerId].desc; }
+
+    // 圖層內容改變，下一次 PlanFrame 重繪
+    void Invalidate(unsigned int layerId);
+
+    // 所有快取失效 (解析度改變、裝置重建)
+    void InvalidateAll();
+
+    // 快取仍然有效，但上一幀的場景輸出已不可用 (例如緩衝區被交換出去)，下一幀必須重新合成
+    void InvalidateComposition() { m_isCompositionDirty = true; }
+
+    void SetVisible(unsigned int layerId, bool isVisible);
+    bool IsVisible(unsigned int layerId) const { return m_layers[layerId].isVisible; }
+
+    // 決定本幀的繪製工作；回傳的計畫視為一定會執行，圖層的失效狀態在此清除
+    sLayerPlan const& PlanFrame();
+
+    sLayerCompositorStats const& GetStats() const { return m_stats; }
+
+private:
+    struct sLayer
+    {
+        sLayerDesc   desc;
+        bool         isVisible         = true;
+        bool         isDirty           = true;
+        unsigned int framesSinceRedraw = 0;
+    };
+
+    std::vector<sLayer>       m_layers;
+    std::vector<unsigned int> m_drawOrder;                  // 依 order 排序的圖層編號 (由下而上)
+    std::vector<sLayerStep>   m_lastComposite;
+    bool                      m_isCompositionDirty = true;
+    sLayerPlan                m_plan;
+    sLayerCompositorStats     m_stats;
+};
@@ -0,0 +1,687 @@
+﻿//----------------------------------------------------------------------------------------------------
+// LayerCompositorCheckMain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// 圖層合成的無頭檢查 (不屬於 Windows 專案，在 Linux 上單獨編譯)：
+//
+//   g++ -std=c++14 -O2 -pthread LayerCompositorCheckMain.cpp LayerCompositor.cpp SoftwareRenderBackend.cpp SpriteBatch.cpp ThreadPool.cpp Region.cpp -o layer_compositor_check
+//   ./layer_compositor_check [幀數，至少 200]
+//
+// PlanFrame：依 order (相同時依加入順序) 由下而上、第一幀重繪所有快取、沒有變化時略過整幀、Invalidate 只重繪該圖層、
+// Periodic 的重繪間隔、Dynamic 每幀直接繪製、不透明圖層蓋住底下的圖層 (被蓋住時保留失效狀態)、可見性改變時重新合成
+// 像素：以 SoftwareRenderBackend 跑一段圖層會失效、隱藏、被蓋住的場景，依 PlanFrame 快取與略過的結果必須與
+// 每幀重繪所有圖層的結果逐像素相同；精靈不透明時也必須與不經過圖層、直接畫進場景的結果相同
+// 省記憶體模式：場景紋理與圖層屬於後端、沒有 CPU 鏡像 (與 Renderer 的 D3D11 路徑相同)，精靈移動後舊位置必須回到背景
+// 最後以 1280x720 比較快取與每幀重繪的時間
+// 結束碼：0 = 全部通過，1 = 失敗
+//----------------------------------------------------------------------------------------------------
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "CheckMain.hpp"
+#include "LayerCompositor.hpp"
+#include "SoftwareRenderBackend.hpp"
+#include "SpriteBatch.hpp"
+#include "ThreadPool.hpp"
+
+//----------------------------------------------------------------------------------------------------
+static bool IsRedrawn(sLayerPlan const& plan, unsigned int const layerId)
+{
+    return std::find(plan.redraw.begin(), plan.redraw.end(), layerId) != plan.redraw.end();
+}
+
+static std::vector<unsigned int> GetCompositeOrder(sLayerPlan const& plan)
+{
+    std::vector<unsigned int> order;
+    for (sLayerStep const& step : plan.composite)
+    {
+        order.push_back(step.layerId);
+    }
+    return order;
+}
+
+//----------------------------------------------------------------------------------------------------
+static bool CheckPlan()
+{
+    // 順序：order 由小到大，相同 order 依加入順序
+    LayerCompositor ordered;
+    int const       orders[] = {5, 0, 5, -3, 10, 0};
+    for (int const order : orders)
+    {
+        sLayerDesc desc;
+        desc.order = order;
+        ordered.AddLayer(desc);
+    }
+    sLayerPlan const& orderedPlan = ordered.PlanFrame();
+    bool const        isOrdered   = GetCompositeOrder(orderedPlan) == std::vector<unsigned int>({3, 1, 5, 0, 2, 4});
+
+    // 第一幀重繪所有快取；第二幀沒有變化，整幀略過
+    bool isSkipped = orderedPlan.redraw.size() == 6 && orderedPlan.isSceneChanged && orderedPlan.needsClear;
+    {
+        sLayerPlan const& plan = ordered.PlanFrame();
+        isSkipped &= plan.redraw.empty() && !plan.isSceneChanged && ordered.GetStats().compositionsAvoided == 1 &&
+                     ordered.GetStats().redrawsAvoided == 6;
+    }
+
+    // Invalidate 只重繪該圖層；InvalidateComposition 只重新合成；InvalidateAll 全部重繪
+    ordered.Invalidate(2);
+    bool isInvalidated = ordered.PlanFrame().redraw == std::vector<unsigned int>({2});
+    isInvalidated     &= ordered.PlanFrame().redraw.empty();
+
+    ordered.InvalidateComposition();
+    {
+        sLayerPlan const& plan = ordered.PlanFrame();
+        isInvalidated &= plan.redraw.empty() && plan.isSceneChanged;
+    }
+
+    // 全部重繪之後的下一幀又回到沒有變化
+    ordered.InvalidateAll();
+    isInvalidated &= ordered.PlanFrame().redraw.size() == 6;
+    isInvalidated &= !ordered.PlanFrame().isSceneChanged;
+
+    // Periodic：第一幀 (失效) 之後每 refreshInterval 幀重繪一次；Static 只在第一幀
+    LayerCompositor periodic;
+    sLayerDesc      periodicDesc;
+    periodicDesc.update          = eLayerUpdate::Periodic;
+    periodicDesc.refreshInterval = 4;
+    unsigned int const periodicLayer = periodic.AddLayer(periodicDesc);
+    unsigned int const staticLayer   = periodic.AddLayer(sLayerDesc());
+
+    bool isPeriodic = true;
+    for (int frame = 0; frame < 40; ++frame)
+    {
+        sLayerPlan const& plan = periodic.PlanFrame();
+        isPeriodic &= IsRedrawn(plan, periodicLayer) == (frame % 4 == 0);
+        isPeriodic &= IsRedrawn(plan, staticLayer) == (frame == 0);
+        isPeriodic &= plan.isSceneChanged == (frame % 4 == 0);
+    }
+
+    // Dynamic：不進入 redraw，每幀直接繪製並視為場景改變
+    LayerCompositor dynamic;
+    sLayerDesc      dynamicDesc;
+    dynamicDesc.update = eLayerUpdate::Dynamic;
+
+    unsigned int const dynamicLayer = dynamic.AddLayer(dynamicDesc);
+    bool               isDynamic    = true;
+    for (int frame = 0; frame < 5; ++frame)
+    {
+        sLayerPlan const& plan = dynamic.PlanFrame();
+        isDynamic &= plan.redraw.empty() && plan.isSceneChanged && plan.composite.size() == 1 &&
+                     plan.composite[0].layerId == dynamicLayer && plan.composite[0].isDirect;
+    }
+    isDynamic &= dynamic.GetStats().directDraws == 5;
+
+    // 遮蔽：可見的不透明圖層蓋住底下的圖層，最底下是不透明圖層時不需要清除
+    sLayerDesc bottomDesc, middleDesc, coverDesc, topDesc;
+    bottomDesc.order    = 0;
+    bottomDesc.isOpaque = true;
+    middleDesc.order    = 10;
+    coverDesc.order     = 20;
+    coverDesc.isOpaque  = true;
+    topDesc.order       = 30;
+
+    LayerCompositor    occlusion;
+    unsigned int const bottomLayer = occlusion.AddLayer(bottomDesc);
+    unsigned int const middleLayer = occlusion.AddLayer(middleDesc);
+    unsigned int const coverLayer  = occlusion.AddLayer(coverDesc);
+    unsigned int const topLayer    = occlusion.AddLayer(topDesc);
+
+    bool isOccluded = true;
+    {
+        sLayerPlan const& plan = occlusion.PlanFrame();
+        isOccluded &= GetCompositeOrder(plan) == std::vector<unsigned int>({coverLayer, topLayer}) && !plan.needsClear &&
+                      !IsRedrawn(plan, bottomLayer) && !IsRedrawn(plan, middleLayer) && occlusion.GetStats().layersOccluded == 2;
+    }
+
+    // 被蓋住的圖層保留失效狀態，蓋住它的圖層隱藏時才重繪；可見性改變本身就需要重新合成
+    occlusion.Invalidate(middleLayer);
+    isOccluded &= !occlusion.PlanFrame().isSceneChanged;
+    occlusion.SetVisible(coverLayer, false);
+    {
+        sLayerPlan const& plan = occlusion.PlanFrame();
+        isOccluded &= GetCompositeOrder(plan) == std::vector<unsigned int>({bottomLayer, middleLayer, topLayer}) &&
+                      plan.redraw == std::vector<unsigned int>({bottomLayer, middleLayer}) && plan.isSceneChanged && !plan.needsClear;
+    }
+    occlusion.SetVisible(bottomLayer, false);
+    {
+        sLayerPlan const& plan = occlusion.PlanFrame();
+        isOccluded &= GetCompositeOrder(plan) == std::vector<unsigned int>({middleLayer, topLayer}) && plan.redraw.empty() &&
+                      plan.isSceneChanged && plan.needsClear;
+    }
+    occlusion.SetVisible(topLayer, false);
+    occlusion.SetVisible(middleLayer, false);
+    {
+        sLayerPlan const& plan = occlusion.PlanFrame();
+        isOccluded &= plan.composite.empty() && plan.isSceneChanged && plan.needsClear;
+    }
+
+    bool isPassing = true;
+    isPassing &= Check(isOrdered, "plan_order");
+    isPassing &= Check(isSkipped, "plan_unchanged_skipped");
+    isPassing &= Check(isInvalidated, "plan_invalidate");
+    isPassing &= Check(isPeriodic, "plan_periodic_refresh");
+    isPassing &= Check(isDynamic, "plan_dynamic_direct");
+    isPassing &= Check(isOccluded, "plan_occlusion");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 像素比對用的場景：背景 (不透明，定期換紋理)、定期重繪的精靈、每幀改變的精靈 (有時隱藏)、
+// 有時出現的不透明遮擋圖層、有時隱藏且會換內容的前景精靈
+enum eSceneLayer
+{
+    SCENE_LAYER_BACKGROUND,
+    SCENE_LAYER_PERIODIC,
+    SCENE_LAYER_DYNAMIC,
+    SCENE_LAYER_COVER,
+    SCENE_LAYER_OVERLAY,
+    SCENE_LAYER_COUNT
+};
+
+// 三種繪製方式：依 PlanFrame 快取、每幀重繪所有圖層再合成、完全不經過圖層直接畫進場景
+enum class eCompositeMode
+{
+    Cached,
+    Uncached,
+    Direct
+};
+
+struct sSceneState
+{
+    unsigned int frame           = 0;
+    unsigned int backgroundImage = 0;
+    unsigned int periodicVersion = 0;       // 定期圖層最後一次重繪時的幀
+    unsigned int overlayVersion  = 0;
+    bool         isVisible[SCENE_LAYER_COUNT];
+};
+
+class LayerScene
+{
+public:
+    LayerScene(ThreadPool& threadPool, unsigned int const width, unsigned int const height, uint32_t const spriteAlpha)
+        : m_backend(threadPool)
+        , m_width(width)
+        , m_height(height)
+        , m_spriteAlpha(spriteAlpha)
+        , m_pixels((size_t)width * height)
+    {
+        // 三張不透明紋理與一張精靈紋理，兩個後端以相同順序建立所以編號相同
+        uint32_t seed = 0x51ED270Bu;
+        for (unsigned int image = 0; image < 3; ++image)
+        {
+            std::vector<uint32_t> pixels(64 * 48);
+            for (uint32_t& pixel : pixels)
+            {
+                pixel = NextRandom(seed) | 0xFF000000u;
+            }
+            m_textures[image] = m_backend.CreateSceneTexture(pixels.data(), 64, 48);
+        }
+
+        std::vector<uint32_t> sprite(16 * 16);
+        for (unsigned int i = 0; i < sprite.size(); ++i)
+        {
+            sprite[i] = ((i / 16 + i % 16) & 2) ? 0xFF30C0F0u : 0xFFF0A040u;
+        }
+        m_textures[3] = m_backend.CreateSceneTexture(sprite.data(), 16, 16);
+
+        for (unsigned int layer = 0; layer < SCENE_LAYER_COUNT; ++layer)
+        {
+            m_layers[layer] = m_backend.CreateLayer();
+        }
+    }
+
+    std::vector<uint32_t> const& GetPixels() const { return m_pixels; }
+
+    // 與 Renderer::Render 相同的流程：先重繪計畫中的快取，再依序合成；沒有變化時保留上一幀
+    void RenderCached(sLayerPlan const& plan, sSceneState const& state, LayerCompositor const& compositor)
+    {
+        if (!plan.isSceneChanged) return;
+
+        m_backend.BeginScene(GetTarget(), plan.needsClear ? CLEAR_COLOR : nullptr);
+        for (unsigned int const layerId : plan.redraw)
+        {
+            m_backend.BeginLayer(m_layers[layerId], compositor.GetLayerDesc(layerId).isOpaque ? nullptr : TRANSPARENT_COLOR);
+            DrawLayer(layerId, state);
+            m_backend.EndLayer();
+        }
+        for (sLayerStep const& step : plan.composite)
+        {
+            if (step.isDirect)
+            {
+                DrawLayer(step.layerId, state);
+            }
+            else
+            {
+                m_backend.CompositeLayer(m_layers[step.layerId], compositor.GetLayerDesc(step.layerId).isOpaque);
+            }
+        }
+        m_backend.EndScene();
+    }
+
+    // 參考：所有可見圖層依序繪製，不略過、不沿用任何快取
+    void RenderReference(eCompositeMode const mode, sSceneState const& state, LayerCompositor const& compositor)
+    {
+        m_backend.BeginScene(GetTarget(), CLEAR_COLOR);
+        for (unsigned int layerId = 0; layerId < SCENE_LAYER_COUNT; ++layerId)
+        {
+            if (!state.isVisible[layerId]) continue;
+
+            sLayerDesc const& desc = compositor.GetLayerDesc(layerId);
+            if (mode == eCompositeMode::Direct || desc.update == eLayerUpdate::Dynamic)
+            {
+                DrawLayer(layerId, state);
+                continue;
+            }
+
+            m_backend.BeginLayer(m_layers[layerId], desc.isOpaque ? nullptr : TRANSPARENT_COLOR);
+            DrawLayer(layerId, state);
+            m_backend.EndLayer();
+            m_backend.CompositeLayer(m_layers[layerId], desc.isOpaque);
+        }
+        m_backend.EndScene();
+    }
+
+private:
+    static float const CLEAR_COLOR[4];
+    static float const TRANSPARENT_COLOR[4];
+
+    sSceneTarget GetTarget()
+    {
+        sSceneTarget target;
+        target.pixels = reinterpret_cast<uint8_t*>(m_pixels.data());
+        target.width  = m_width;
+        target.height = m_height;
+        target.pitch  = m_width * 4;
+        return target;
+    }
+
+    // 每個圖層的內容只由 state 中對應的版本決定
+    void DrawLayer(unsigned int const layerId, sSceneState const& state)
+    {
+        if (layerId == SCENE_LAYER_BACKGROUND)
+        {
+            m_backend.DrawFullscreenTexture(m_textures[state.backgroundImage]);
+            return;
+        }
+        if (layerId == SCENE_LAYER_COVER)
+        {
+            m_backend.DrawFullscreenTexture(m_textures[2]);
+            return;
+        }
+
+        unsigned int const version = layerId == SCENE_LAYER_PERIODIC ? state.periodicVersion :
+                                     layerId == SCENE_LAYER_DYNAMIC  ? state.frame :
+                                                                       state.overlayVersion;
+        uint32_t seed = 0x9E3779B9u ^ (version * 2654435761u) ^ (layerId << 24);
+
+        m_batcher.Begin();
+        for (int i = 0; i < 12; ++i)
+        {
+            sSprite sprite;
+            sprite.x         = (float)(NextRandom(seed) % m_width);
+            sprite.y         = (float)(NextRandom(seed) % m_height);
+            sprite.width     = 8.f + (float)(NextRandom(seed) % 40);
+            sprite.height    = 8.f + (float)(NextRandom(seed) % 40);
+            sprite.rotation  = (float)(NextRandom(seed) % 628) * 0.01f;
+            sprite.tint      = (m_spriteAlpha << 24) | (NextRandom(seed) & 0x00FFFFFFu);
+            sprite.textureId = m_textures[3];
+            sprite.layer     = i % 3;
+            m_batcher.Draw(sprite);
+        }
+        m_batcher.End();
+        m_backend.DrawSprites(m_batcher);
+    }
+
+    SoftwareRenderBackend m_backend;
+    SpriteBatcher         m_batcher;
+    unsigned int          m_width;
+    unsigned int          m_height;
+    uint32_t              m_spriteAlpha;
+    std::vector<uint32_t> m_pixels;
+    unsigned int          m_textures[4];
+    unsigned int          m_layers[SCENE_LAYER_COUNT];
+};
+
+float const LayerScene::CLEAR_COLOR[4]       = {0.1f, 0.1f, 0.2f, 1.f};
+float const LayerScene::TRANSPARENT_COLOR[4] = {0.f, 0.f, 0.f, 0.f};
+
+//----------------------------------------------------------------------------------------------------
+static void AddSceneLayers(LayerCompositor& compositor)
+{
+    sLayerDesc background;
+    background.order    = 0;
+    background.isOpaque = true;
+    compositor.AddLayer(background);
+
+    sLayerDesc periodic;
+    periodic.order           = 10;
+    periodic.update          = eLayerUpdate::Periodic;
+    periodic.refreshInterval = 5;
+    compositor.AddLayer(periodic);
+
+    sLayerDesc dynamic;
+    dynamic.order  = 20;
+    dynamic.update = eLayerUpdate::Dynamic;
+    compositor.AddLayer(dynamic);
+
+    sLayerDesc cover;
+    cover.order    = 25;
+    cover.isOpaque = true;
+    compositor.AddLayer(cover);
+
+    sLayerDesc overlay;
+    overlay.order = 30;
+    compositor.AddLayer(overlay);
+}
+
+// 第 frame 幀的可見性與內容變化；會失效的圖層呼叫 Invalidate
+static void AdvanceScene(LayerCompositor& compositor, sSceneState& state, unsigned int const frame)
+{
+    state.frame                             = frame;
+    state.isVisible[SCENE_LAYER_BACKGROUND] = true;
+    state.isVisible[SCENE_LAYER_PERIODIC]   = (frame / 70) % 4 != 3;
+    state.isVisible[SCENE_LAYER_DYNAMIC]    = (frame / 30) % 3 == 0;
+    state.isVisible[SCENE_LAYER_COVER]      = (frame / 40) % 5 == 4;
+    state.isVisible[SCENE_LAYER_OVERLAY]    = (frame / 23) % 2 == 0;
+
+    if (frame > 0 && frame % 50 == 0)
+    {
+        state.backgroundImage = 1 - state.backgroundImage;
+        compositor.Invalidate(SCENE_LAYER_BACKGROUND);
+    }
+    if (frame > 0 && frame % 60 == 0)
+    {
+        state.overlayVersion = frame;
+        compositor.Invalidate(SCENE_LAYER_OVERLAY);
+    }
+
+    for (unsigned int layerId = 0; layerId < SCENE_LAYER_COUNT; ++layerId)
+    {
+        compositor.SetVisible(layerId, state.isVisible[layerId]);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+struct sPixelResult
+{
+    unsigned int          mismatchedFrames = 0;
+    sLayerCompositorStats stats;
+    double                cachedMs         = 0.0;
+    double                referenceMs      = 0.0;
+};
+
+static sPixelResult RunScene(ThreadPool& threadPool, unsigned int const width, unsigned int const height, uint32_t const spriteAlpha,
+                             eCompositeMode const referenceMode, unsigned int const frameCount)
+{
+    using Clock = std::chrono::steady_clock;
+
+    LayerCompositor compositor;
+    AddSceneLayers(compositor);
+
+    LayerScene  cached(threadPool, width, height, spriteAlpha);
+    LayerScene  reference(threadPool, width, height, spriteAlpha);
+    sSceneState state;
+
+    sPixelResult result;
+    for (unsigned int frame = 0; frame < frameCount; ++frame)
+    {
+        AdvanceScene(compositor, state, frame);
+
+        Clock::time_point const cachedStart = Clock::now();
+        sLayerPlan const&       plan        = compositor.PlanFrame();
+        if (IsRedrawn(plan, SCENE_LAYER_PERIODIC)) state.periodicVersion = frame;
+        cached.RenderCached(plan, state, compositor);
+        Clock::time_point const referenceStart = Clock::now();
+        reference.RenderReference(referenceMode, state, compositor);
+        Clock::time_point const referenceEnd = Clock::now();
+
+        result.cachedMs    += std::chrono::duration<double, std::milli>(referenceStart - cachedStart).count();
+        result.referenceMs += std::chrono::duration<double, std::milli>(referenceEnd - referenceStart).count();
+        if (cached.GetPixels() != reference.GetPixels()) ++result.mismatchedFrames;
+    }
+    result.stats        = compositor.GetStats();
+    result.cachedMs    /= (std::max)(1u, frameCount);
+    result.referenceMs /= (std::max)(1u, frameCount);
+    return result;
+}
+
+static bool CheckPixels(ThreadPool& threadPool, unsigned int const frameCount)
+{
+    // 不透明精靈：直接畫進場景與經過透明圖層再合成的結果相同
+    sPixelResult const opaqueUncached = RunScene(threadPool, 192, 128, 0xFF, eCompositeMode::Uncached, frameCount);
+    sPixelResult const opaqueDirect   = RunScene(threadPool, 192, 128, 0xFF, eCompositeMode::Direct, frameCount);
+
+    // 半透明精靈：經過圖層時 premultiplied 合成，只與每幀重繪的圖層比較
+    sPixelResult const translucent = RunScene(threadPool, 192, 128, 0x80, eCompositeMode::Uncached, frameCount);
+
+    sLayerCompositorStats const& stats = translucent.stats;
+    printf("pixels_frames %u\n", frameCount);
+    printf("pixels_compositions %lld\n", stats.compositions);
+    printf("pixels_compositions_avoided %lld\n", stats.compositionsAvoided);
+    printf("pixels_layer_redraws %lld\n", stats.layerRedraws);
+    printf("pixels_redraws_avoided %lld\n", stats.redrawsAvoided);
+    printf("pixels_layers_occluded %lld\n", stats.layersOccluded);
+
+    bool isPassing = true;
+    isPassing &= Check(stats.compositionsAvoided > 0 && stats.redrawsAvoided > 0 && stats.layersOccluded > 0, "pixels_scenario_coverage");
+    isPassing &= Check(opaqueUncached.mismatchedFrames == 0, "pixels_opaque_cached_match_uncached");
+    isPassing &= Check(opaqueDirect.mismatchedFrames == 0, "pixels_opaque_cached_match_direct");
+    isPassing &= Check(translucent.mismatchedFrames == 0, "pixels_translucent_cached_match_uncached");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 與 Renderer (D3D11) 相同的資源歸屬：場景紋理與圖層目標都屬於後端，sSceneTarget.pixels 只是回讀的目的地。
+// 省記憶體模式 (-compactMemory) 傳入 nullptr，結果留在 staging；圖層是否可用不能取決於 pixels
+class StagingRenderBackend : public RenderBackend
+{
+public:
+    explicit StagingRenderBackend(ThreadPool& threadPool)
+        : m_raster(threadPool)
+    {
+    }
+
+    std::vector<uint32_t> const& GetStaging() const { return m_staging; }
+
+    unsigned int CreateSceneTexture(uint32_t const* pixels, unsigned int const width, unsigned int const height) override
+    {
+        return m_raster.CreateSceneTexture(pixels, width, height);
+    }
+    unsigned int CreateDynamicSceneTexture(unsigned int const width, unsigned int const height) override
+    {
+        return m_raster.CreateDynamicSceneTexture(width, height);
+    }
+    void UpdateSceneTexture(unsigned int const textureId, sRect const& rect, uint32_t const* pixels, unsigned int const pitch) override
+    {
+        m_raster.UpdateSceneTexture(textureId, rect, pixels, pitch);
+    }
+
+    void BeginScene(sSceneTarget const& target, float const clearColor[4]) override
+    {
+        m_sceneTarget = target;
+        m_sceneTexture.resize((size_t)target.width * target.height);
+        m_raster.BeginScene(GetSceneTexture(), clearColor);
+    }
+    void DrawFullscreenTexture(unsigned int const textureId) override { m_raster.DrawFullscreenTexture(textureId); }
+    void DrawSprites(SpriteBatcher const& batcher) override { m_raster.DrawSprites(batcher); }
+
+    // 場景紋理複製到 staging；有 CPU 目的時再複製過去
+    bool EndScene() override
+    {
+        m_raster.EndScene();
+        m_staging = m_sceneTexture;
+        if (m_sceneTarget.pixels)
+        {
+            for (unsigned int y = 0; y < m_sceneTarget.height; ++y)
+            {
+                memcpy(m_sceneTarget.pixels + (size_t)y * m_sceneTarget.pitch, &m_staging[(size_t)y * m_sceneTarget.width],
+                       (size_t)m_sceneTarget.width * 4);
+            }
+        }
+        m_sceneTarget = sSceneTarget();
+        return true;
+    }
+
+    unsigned int CreateLayer() override { return m_raster.CreateLayer(); }
+
+    // 與 Renderer::BeginLayer 相同，只檢查圖層編號
+    void BeginLayer(unsigned int const layerId, float const clearColor[4]) override { m_raster.BeginLayer(layerId, clearColor); }
+    void EndLayer() override { m_raster.EndLayer(); }
+    void CompositeLayer(unsigned int const layerId, bool const isOpaque) override { m_raster.CompositeLayer(layerId, isOpaque); }
+
+private:
+    sSceneTarget GetSceneTexture()
+    {
+        sSceneTarget texture;
+        texture.pixels = reinterpret_cast<uint8_t*>(m_sceneTexture.data());
+        texture.width  = m_sceneTarget.width;
+        texture.height = m_sceneTarget.height;
+        texture.pitch  = m_sceneTarget.width * 4;
+        return texture;
+    }
+
+    SoftwareRenderBackend m_raster;             // 只用來光柵化，目標永遠是後端自己的紋理
+    sSceneTarget          m_sceneTarget;
+    std::vector<uint32_t> m_sceneTexture;
+    std::vector<uint32_t> m_staging;
+};
+
+// Renderer 的兩個圖層 (快取的不透明背景與每幀直接繪製的精靈)，精靈在兩幀之間移動；
+// 第二幀舊位置必須回到背景，與每幀直接繪製的參考相同
+static bool CheckCompactMemory(ThreadPool& threadPool)
+{
+    unsigned int const width                 = 192;
+    unsigned int const height                = 128;
+    float const        clearColor[4]         = {0.1f, 0.1f, 0.2f, 1.f};
+    float const        spritePositions[2][2] = {{40.f, 40.f}, {140.f, 80.f}};
+
+    std::vector<uint32_t> backgroundPixels(64 * 48);
+    uint32_t              seed = 0xBAC6u;
+    for (uint32_t& pixel : backgroundPixels)
+    {
+        pixel = NextRandom(seed) | 0xFF000000u;
+    }
+    std::vector<uint32_t> const spritePixels(16 * 16, 0xFF2040F0u);
+
+    bool isCompactMatching = true;
+    bool isMirrorMatching  = true;
+    bool isOldCleared      = true;
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        bool const isCompact = pass == 0;
+
+        sLayerDesc backgroundDesc, spriteDesc;
+        backgroundDesc.isOpaque = true;
+        spriteDesc.order        = 100;
+        spriteDesc.update       = eLayerUpdate::Dynamic;
+
+        LayerCompositor    compositor;
+        unsigned int const backgroundLayer = compositor.AddLayer(backgroundDesc);
+        compositor.AddLayer(spriteDesc);
+
+        // 兩個後端以相同順序建立紋理，編號相同；只有快取的背景需要後端圖層
+        StagingRenderBackend  backend(threadPool);
+        SoftwareRenderBackend reference(threadPool);
+        unsigned int const    backgroundTexture = backend.CreateSceneTexture(backgroundPixels.data(), 64, 48);
+        unsigned int const    spriteTexture     = backend.CreateSceneTexture(spritePixels.data(), 16, 16);
+        unsigned int const    backendLayer      = backend.CreateLayer();
+        reference.CreateSceneTexture(backgroundPixels.data(), 64, 48);
+        reference.CreateSceneTexture(spritePixels.data(), 16, 16);
+
+        std::vector<uint32_t> mirror((size_t)width * height);
+        std::vector<uint32_t> expected((size_t)width * height);
+        for (int frame = 0; frame < 2; ++frame)
+        {
+            SpriteBatcher batcher;
+            sSprite       sprite;
+            sprite.x         = spritePositions[frame][0];
+            sprite.y         = spritePositions[frame][1];
+            sprite.width     = 24.f;
+            sprite.height    = 24.f;
+            sprite.textureId = spriteTexture;
+            batcher.Begin();
+            batcher.Draw(sprite);
+            batcher.End();
+
+            sSceneTarget target;
+            target.pixels = isCompact ? nullptr : reinterpret_cast<uint8_t*>(mirror.data());
+            target.width  = width;
+            target.height = height;
+            target.pitch  = width * 4;
+
+            // 與 Renderer::Render 相同的流程；精靈圖層每幀都會改變場景
+            sLayerPlan const& plan = compositor.PlanFrame();
+            if (plan.isSceneChanged)
+            {
+                backend.BeginScene(target, plan.needsClear ? clearColor : nullptr);
+                for (unsigned int const layerId : plan.redraw)
+                {
+                    if (layerId != backgroundLayer) continue;
+
+                    backend.BeginLayer(backendLayer, nullptr);
+                    backend.DrawFullscreenTexture(backgroundTexture);
+                    backend.EndLayer();
+                }
+                for (sLayerStep const& step : plan.composite)
+                {
+                    if (step.isDirect)
+                    {
+                        backend.DrawSprites(batcher);
+                    }
+                    else
+                    {
+                        backend.CompositeLayer(backendLayer, true);
+                    }
+                }
+                backend.EndScene();
+            }
+
+            target.pixels = reinterpret_cast<uint8_t*>(expected.data());
+            reference.BeginScene(target, clearColor);
+            reference.DrawFullscreenTexture(backgroundTexture);
+            reference.DrawSprites(batcher);
+            reference.EndScene();
+
+            bool& isMatching = isCompact ? isCompactMatching : isMirrorMatching;
+            isMatching &= backend.GetStaging() == expected && (isCompact || mirror == expected);
+        }
+
+        // 第二幀時第一幀精靈中心的像素
+        size_t const   oldCenter = (size_t)spritePositions[0][1] * width + (size_t)spritePositions[0][0];
+        uint32_t const oldPixel  = backend.GetStaging()[oldCenter];
+        isOldCleared &= oldPixel != spritePixels[0] && oldPixel == expected[oldCenter];
+    }
+
+    bool isPassing = true;
+    isPassing &= Check(isCompactMatching, "compact_memory_matches_direct");
+    isPassing &= Check(isMirrorMatching, "mirror_matches_direct");
+    isPassing &= Check(isOldCleared, "compact_memory_old_sprite_cleared");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+int main(int const argc, char** argv)
+{
+    // 至少跑到遮蓋圖層第一次出現 (第 160 幀) 之後，場景才涵蓋所有情況
+    unsigned int const frameCount = argc > 1 ? (std::max)(200u, (unsigned int)strtoul(argv[1], nullptr, 0)) : 600u;
+
+    ThreadPool threadPool;
+
+    bool isPassing = true;
+    isPassing &= CheckPlan();
+    isPassing &= CheckPixels(threadPool, frameCount);
+    isPassing &= CheckCompactMemory(threadPool);
+
+    // 基準：1280x720，快取 + 略過與每幀重繪所有圖層
+    sPixelResult const benchmark = RunScene(threadPool, 1280, 720, 0x80, eCompositeMode::Uncached, 300);
+    printf("benchmark_workers %u\n", threadPool.GetWorkerCount());
+    printf("benchmark_cached_ms %.3f\n", benchmark.cachedMs);
+    printf("benchmark_uncached_ms %.3f\n", benchmark.referenceMs);
+    printf("benchmark_speedup %.2f\n", benchmark.referenceMs / benchmark.cachedMs);
+    return isPassing ? 0 : 1;
+}
@@ -0,0 +1,48 @@
+﻿//----------------------------------------------------------------------------------------------------
+// MemoryReport.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "MemoryReport.hpp"
+
+//----------------------------------------------------------------------------------------------------
+char const* GetMemoryCategoryName(eMemoryCategory const category)
+{
+    switch (category)
+    {
+    case eMemoryCategory::Windows:          return "windows";
+    case eMemoryCategory::CpuMirrors:       return "cpu_mirrors";
+    case eMemoryCategory::GpuTextures:      return "gpu_textures";
+    case eMemoryCategory::TransientBuffers: return "transient_buffers";
+    case eMemoryCategory::Count:            break;
+    }
+    return "unknown";
+}
+
+//----------------------------------------------------------------------------------------------------
+size_t sMemoryReport::GetTotal() const
+{
+    size_t total = 0;
+    for (size_t const size : bytes)
+    {
+        total += size;
+    }
+    return total;
+}
+
+//----------------------------------------------------------------------------------------------------
+size_t sMemoryReport::GetBytesPerWindow() const
+{
+    return windowCount > 0 ? Get(eMemoryCategory::Windows) / windowCount : 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+void sMemoryReport::WriteReport(FILE* file) const
+{
+    for (size_t i = 0; i < (size_t)eMemoryCategory::Count; ++i)
+    {
+        fprintf(file, "memory_%s_bytes %zu\n", GetMemoryCategoryName((eMemoryCategory)i), bytes[i]);
+    }
+    fprintf(file, "memory_total_bytes %zu\n", GetTotal());
+    fprintf(file, "memory_bytes_per_window %zu\n", GetBytesPerWindow());
+}
@@ -0,0 +1,40 @@
+﻿//----------------------------------------------------------------------------------------------------
+// MemoryReport.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+//----------------------------------------------------------------------------------------------------
+enum class eMemoryCategory : uint8_t
+{
+    Windows,                                // 窗口狀態、可見區域與查詢表
+    CpuMirrors,                             // 場景與圖片在 CPU 上的副本 (含軟體渲染的目標與紋理)
+    GpuTextures,                            // 紋理與回讀用的 staging (依格式與 mip 估算，實際配置由驅動決定)
+    TransientBuffers,                       // 每幀的 arena 與緩衝池
+    Count
+};
+
+char const* GetMemoryCategoryName(eMemoryCategory category);
+
+// 同一台機器上會同時執行很多個實例，每個窗口的額外記憶體 (Windows 類別平均到每個窗口) 不能超過預算
+size_t const WINDOW_MEMORY_BUDGET_BYTES = 1024;
+
+//----------------------------------------------------------------------------------------------------
+// 某一時刻各子系統持有的記憶體 (位元組)；以容量計，不是使用量
+struct sMemoryReport
+{
+    size_t bytes[(size_t)eMemoryCategory::Count] = {};
+    size_t windowCount                           = 0;
+
+    void   Add(eMemoryCategory const category, size_t const size) { bytes[(size_t)category] += size; }
+    size_t Get(eMemoryCategory const category) const { return bytes[(size_t)category]; }
+    size_t GetTotal() const;
+    size_t GetBytesPerWindow() const;       // Windows 類別平均到每個窗口
+
+    // 一行一個類別：memory_<name>_bytes <value>
+    void WriteReport(FILE* file) const;
+};
@@ -0,0 +1,176 @@
+﻿//----------------------------------------------------------------------------------------------------
+// MemoryReportCheckMain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// 每個窗口的記憶體預算 (不屬於 Windows 專案，在 Linux 上單獨編譯)：
+//
+//   g++ -std=c++14 -O2 MemoryReportCheckMain.cpp MemoryReport.cpp DriftSimulation.cpp Region.cpp -o memory_report_check
+//   ./memory_report_check [窗口數量]
+//
+// sizeof(Window) 與 sDriftBody 不超過各自的預算；依 Renderer 加入窗口的方式 (預先保留清單與查詢表、可見區域被上方的
+// 窗口切開) 建立 1 到指定數量的窗口，以 GetWindowMemoryBytes 算出的 Windows 類別平均到每個窗口不超過
+// WINDOW_MEMORY_BUDGET_BYTES；WriteReport 的格式與數值
+// 結束碼：0 = 全部通過，1 = 失敗
+//----------------------------------------------------------------------------------------------------
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// Window.hpp 使用的 Win32 型別；替身與 x64 的 windows.h 佈局相同 (LONG 為 32 位元)
+typedef void*    HWND;
+typedef uint32_t UINT;
+typedef uint64_t WPARAM;
+typedef int64_t  LPARAM;
+typedef int64_t  LRESULT;
+#define CALLBACK
+
+struct RECT
+{
+    int32_t left;
+    int32_t top;
+    int32_t right;
+    int32_t bottom;
+};
+
+#include "CheckMain.hpp"
+#include "MemoryReport.hpp"
+#include "Window.hpp"
+
+// Window.cpp 依賴 Win32，這裡只需要建構子
+Window::Window()
+{
+    SeedDriftBody(body, 1);
+}
+
+//----------------------------------------------------------------------------------------------------
+// 與 Renderer 相同的窗口狀態：AddWindows 預先保留清單與查詢表，每個窗口的可見區域被上方的幾個窗口切開
+struct sWindowState
+{
+    std::vector<Window>                    windowList;
+    std::unordered_map<HWND, unsigned int> windowIndices;
+    std::vector<sUpdateState*>             updateStates;
+    std::vector<sRect>                     occluders;
+    std::vector<size_t>                    occludersAbove;
+};
+
+static void CreateWindows(sWindowState& state, unsigned int const windowCount, uint32_t seed)
+{
+    state.windowList.reserve(windowCount);
+    state.windowIndices.reserve(windowCount);
+    for (unsigned int i = 0; i < windowCount; ++i)
+    {
+        state.windowList.emplace_back();
+        Window& window = state.windowList.back();
+        window.x       = (int)(NextRandom(seed) % 2200);
+        window.y       = (int)(NextRandom(seed) % 1200);
+        window.width   = 200 + (int)(NextRandom(seed) % 300);
+        window.height  = 150 + (int)(NextRandom(seed) % 200);
+
+        HWND const hwnd           = (HWND)(uintptr_t)(0x10000 + i * 4);
+        window.m_windowHandle     = hwnd;
+        state.windowIndices[hwnd] = i;
+    }
+
+    // 遮擋：清單依 Z 順序由上到下，每個窗口減去上方最近的三個窗口
+    state.occluders.reserve(windowCount);
+    state.occludersAbove.resize(windowCount);
+    for (unsigned int i = 0; i < windowCount; ++i)
+    {
+        Window& window          = state.windowList[i];
+        window.clientScreenRect = {window.x, window.y, window.x + window.width, window.y + window.height};
+        state.occluders.push_back(window.clientScreenRect);
+
+        window.visibleRegion.Assign(window.clientScreenRect);
+        for (unsigned int above = i > 3 ? i - 3 : 0; above < i; ++above)
+        {
+            window.visibleRegion.Subtract(state.occluders[above]);
+        }
+        state.occludersAbove[i] = i;
+        state.updateStates.push_back(&window.updateState);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+static bool CheckWindowMemory(unsigned int const maxWindowCount)
+{
+    bool   isWithinBudget = true;
+    size_t largest        = 0;
+    for (unsigned int windowCount = 1; windowCount <= maxWindowCount; windowCount *= 10)
+    {
+        sWindowState state;
+        CreateWindows(state, windowCount, 0x1234567u + windowCount);
+
+        sMemoryReport report;
+        report.windowCount = state.windowList.size();
+        report.Add(eMemoryCategory::Windows, GetWindowMemoryBytes(state.windowList, state.windowIndices, state.updateStates,
+                                                                  state.occluders, state.occludersAbove));
+
+        size_t const bytesPerWindow = report.GetBytesPerWindow();
+        printf("windows_%u_bytes_per_window %zu\n", windowCount, bytesPerWindow);
+
+        isWithinBudget &= report.windowCount == windowCount && bytesPerWindow >= sizeof(Window) &&
+                          bytesPerWindow <= WINDOW_MEMORY_BUDGET_BYTES;
+        largest = (std::max)(largest, bytesPerWindow);
+    }
+    printf("window_memory_budget_bytes %zu\n", WINDOW_MEMORY_BUDGET_BYTES);
+    printf("window_memory_largest_bytes %zu\n", largest);
+
+    return Check(isWithinBudget, "window_memory_budget");
+}
+
+//----------------------------------------------------------------------------------------------------
+// 一行一個類別，之後是總數與每個窗口的平均
+static bool CheckReportFormat()
+{
+    sMemoryReport report;
+    report.windowCount = 4;
+    report.Add(eMemoryCategory::Windows, 4000);
+    report.Add(eMemoryCategory::CpuMirrors, 300);
+    report.Add(eMemoryCategory::GpuTextures, 20);
+    report.Add(eMemoryCategory::TransientBuffers, 1);
+    report.Add(eMemoryCategory::Windows, 96);
+
+    FILE* const file          = tmpfile();
+    bool        isFormatValid = file != nullptr && report.GetTotal() == 4417 && report.GetBytesPerWindow() == 1024;
+    if (file)
+    {
+        report.WriteReport(file);
+        rewind(file);
+
+        char const* const expectedNames[]  = {"memory_windows_bytes", "memory_cpu_mirrors_bytes", "memory_gpu_textures_bytes",
+                                              "memory_transient_buffers_bytes", "memory_total_bytes", "memory_bytes_per_window"};
+        size_t const      expectedValues[] = {4096, 300, 20, 1, 4417, 1024};
+        char              name[64];
+        size_t            value;
+        int               line = 0;
+        while (fscanf(file, "%63s %zu", name, &value) == 2)
+        {
+            isFormatValid &= line < 6 && strcmp(name, expectedNames[line]) == 0 && value == expectedValues[line];
+            ++line;
+        }
+        isFormatValid &= line == 6;
+        fclose(file);
+    }
+    return Check(isFormatValid, "report_format");
+}
+
+//----------------------------------------------------------------------------------------------------
+int main(int const argc, char** argv)
+{
+    unsigned int const windowCount = argc > 1 ? (unsigned int)strtoul(argv[1], nullptr, 0) : 10000u;
+
+    printf("window_bytes %zu\n", sizeof(Window));
+    printf("drift_body_bytes %zu\n", sizeof(sDriftBody));
+
+    bool isPassing = true;
+    isPassing &= Check(sizeof(Window) <= WINDOW_SIZE_BUDGET, "window_size_budget");
+    isPassing &= Check(sizeof(sDriftBody) <= DRIFT_BODY_SIZE_BUDGET, "drift_body_size_budget");
+    isPassing &= CheckWindowMemory(windowCount);
+    isPassing &= CheckReportFormat();
+    return isPassing ? 0 : 1;
+}
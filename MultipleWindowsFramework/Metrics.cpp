@@ -0,0 +1,233 @@
+﻿//----------------------------------------------------------------------------------------------------
+// Metrics.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "Metrics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+//----------------------------------------------------------------------------------------------------
+static uint64_t DoubleToBits(double const value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+//----------------------------------------------------------------------------------------------------
+static double BitsToDouble(uint64_t const bits)
+{
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+//----------------------------------------------------------------------------------------------------
+static void AppendFormat(std::string& text, char const* format, ...)
+{
+    char line[256];
+
+    va_list arguments;
+    va_start(arguments, format);
+    int const length = vsnprintf(line, sizeof(line), format, arguments);
+    va_end(arguments);
+
+    if (length > 0) text.append(line, (size_t)(std::min)(length, (int)sizeof(line) - 1));
+}
+
+//----------------------------------------------------------------------------------------------------
+static void AppendHeader(std::string& text, std::string const& name, std::string const& help, char const* type)
+{
+    text += "# HELP ";
+    text += name;
+    text += ' ';
+    text += help;
+    text += "\n# TYPE ";
+    text += name;
+    text += ' ';
+    text += type;
+    text += '\n';
+}
+
+//----------------------------------------------------------------------------------------------------
+void MetricGauge::Set(double const value)
+{
+    m_bits.store(DoubleToBits(value), std::memory_order_relaxed);
+}
+
+//----------------------------------------------------------------------------------------------------
+void MetricGauge::Add(double const amount)
+{
+    uint64_t expected = m_bits.load(std::memory_order_relaxed);
+    while (!m_bits.compare_exchange_weak(expected, DoubleToBits(BitsToDouble(expected) + amount), std::memory_order_relaxed))
+    {
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+double MetricGauge::Get() const
+{
+    return BitsToDouble(m_bits.load(std::memory_order_relaxed));
+}
+
+//----------------------------------------------------------------------------------------------------
+uint64_t sMetricHistogramSnapshot::GetValueAtPercentile(double const percentile) const
+{
+    if (count == 0) return 0;
+
+    double const   clamped = (std::min)(100.0, (std::max)(0.0, percentile));
+    uint64_t const target  = (std::max)((uint64_t)1, (uint64_t)std::ceil(clamped / 100.0 * (double)count));
+
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < buckets.size(); ++i)
+    {
+        cumulative += buckets[i];
+        if (cumulative >= target) return MetricHistogram::GetBucketUpperBound((int)i);
+    }
+    return MetricHistogram::GetBucketUpperBound((int)buckets.size() - 1);
+}
+
+//----------------------------------------------------------------------------------------------------
+MetricHistogram::MetricHistogram()
+{
+    for (std::atomic<uint64_t>& bucket : m_buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+void MetricHistogram::GetSnapshot(sMetricHistogramSnapshot& snapshot) const
+{
+    // count 取各桶的總和，與輸出的 +Inf 桶一致
+    snapshot.buckets.resize(METRIC_HISTOGRAM_BUCKET_COUNT);
+    snapshot.count = 0;
+    for (int i = 0; i < METRIC_HISTOGRAM_BUCKET_COUNT; ++i)
+    {
+        snapshot.buckets[i]  = m_buckets[i].load(std::memory_order_relaxed);
+        snapshot.count      += snapshot.buckets[i];
+    }
+    snapshot.sum = m_sum.load(std::memory_order_relaxed);
+}
+
+//----------------------------------------------------------------------------------------------------
+uint64_t MetricHistogram::GetBucketUpperBound(int const bucketIndex)
+{
+    int const subBucketCount = 1 << METRIC_HISTOGRAM_SUB_BUCKET_BITS;
+    if (bucketIndex < subBucketCount) return (uint64_t)bucketIndex;
+
+    // GetBucketIndex 的反向：桶的寬度為 2^shift
+    int const      shift     = (bucketIndex >> METRIC_HISTOGRAM_SUB_BUCKET_BITS) - 1;
+    uint64_t const subBucket = (uint64_t)(bucketIndex & (subBucketCount - 1)) + subBucketCount;
+    return ((subBucket + 1) << shift) - 1;
+}
+
+//----------------------------------------------------------------------------------------------------
+MetricCounter& MetricsRegistry::AddCounter(char const* name, char const* help)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    sMetricEntry entry;
+    entry.name  = name;
+    entry.help  = help;
+    entry.type  = eMetricType::Counter;
+    entry.index = m_counters.size();
+    m_entries.push_back(entry);
+
+    m_counters.emplace_back();
+    return m_counters.back();
+}
+
+//----------------------------------------------------------------------------------------------------
+MetricGauge& MetricsRegistry::AddGauge(char const* name, char const* help)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    sMetricEntry entry;
+    entry.name  = name;
+    entry.help  = help;
+    entry.type  = eMetricType::Gauge;
+    entry.index = m_gauges.size();
+    m_entries.push_back(entry);
+
+    m_gauges.emplace_back();
+    return m_gauges.back();
+}
+
+//----------------------------------------------------------------------------------------------------
+MetricHistogram& MetricsRegistry::AddHistogram(char const* name, char const* help, double const unitScale)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    sMetricEntry entry;
+    entry.name      = name;
+    entry.help      = help;
+    entry.type      = eMetricType::Histogram;
+    entry.index     = m_histograms.size();
+    entry.unitScale = unitScale;
+    m_entries.push_back(entry);
+
+    m_histograms.emplace_back();
+    return m_histograms.back();
+}
+
+//----------------------------------------------------------------------------------------------------
+void MetricsRegistry::WriteText(std::string& text) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    sMetricHistogramSnapshot snapshot;
+    for (sMetricEntry const& entry : m_entries)
+    {
+        char const* const name = entry.name.c_str();
+
+        if (entry.type == eMetricType::Counter)
+        {
+            AppendHeader(text, entry.name, entry.help, "counter");
+            AppendFormat(text, "%s %llu\n", name, (unsigned long long)m_counters[entry.index].Get());
+            continue;
+        }
+
+        if (entry.type == eMetricType::Gauge)
+        {
+            AppendHeader(text, entry.name, entry.help, "gauge");
+            AppendFormat(text, "%s %.17g\n", name, m_gauges[entry.index].Get());
+            continue;
+        }
+
+        AppendHeader(text, entry.name, entry.help, "histogram");
+        m_histograms[entry.index].GetSnapshot(snapshot);
+
+        // 每個 2 的冪次的上界為一行累計桶，精細的分桶只用在 GetValueAtPercentile
+        int const subBucketCount = 1 << METRIC_HISTOGRAM_SUB_BUCKET_BITS;
+        uint64_t  cumulative     = 0;
+        int       bucket         = 0;
+        for (int exponent = METRIC_HISTOGRAM_SUB_BUCKET_BITS; exponent < METRIC_HISTOGRAM_MAX_EXPONENT; ++exponent)
+        {
+            int const bucketEnd = (exponent - METRIC_HISTOGRAM_SUB_BUCKET_BITS + 1) * subBucketCount;
+            for (; bucket < bucketEnd; ++bucket)
+            {
+                cumulative += snapshot.buckets[bucket];
+            }
+
+            AppendFormat(text, "%s_bucket{le=\"%.9g\"} %llu\n", name,
+                         (double)((1ull << exponent) - 1) * entry.unitScale, (unsigned long long)cumulative);
+        }
+
+        AppendFormat(text, "%s_bucket{le=\"+Inf\"} %llu\n", name, (unsigned long long)snapshot.count);
+        AppendFormat(text, "%s_count %llu\n", name, (unsigned long long)snapshot.count);
+        AppendFormat(text, "%s_sum %.17g\n", name, (double)snapshot.sum * entry.unitScale);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+size_t MetricsRegistry::GetMetricCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
@@ -0,0 +1,147 @@
+﻿//----------------------------------------------------------------------------------------------------
+// Metrics.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//----------------------------------------------------------------------------------------------------
+// 直方圖分桶：小於 2^SUB_BUCKET_BITS 的值各自一桶，之後每個 2 的冪次再平分成 2^SUB_BUCKET_BITS 桶 (相對誤差 < 12.5%)
+// 超過 2^MAX_EXPONENT 的值歸入最後一桶；以奈秒記錄時約可涵蓋 18 分鐘
+int constexpr METRIC_HISTOGRAM_SUB_BUCKET_BITS = 3;
+int constexpr METRIC_HISTOGRAM_MAX_EXPONENT    = 40;
+int constexpr METRIC_HISTOGRAM_BUCKET_COUNT    = (METRIC_HISTOGRAM_MAX_EXPONENT - METRIC_HISTOGRAM_SUB_BUCKET_BITS + 1) << METRIC_HISTOGRAM_SUB_BUCKET_BITS;
+
+//----------------------------------------------------------------------------------------------------
+enum class eMetricType : uint8_t
+{
+    Counter,
+    Gauge,
+    Histogram
+};
+
+//----------------------------------------------------------------------------------------------------
+// 以下三種指標的寫入都是單一 relaxed 原子操作 (直方圖為兩個，總數由各桶加總)，任何執行緒都可以呼叫，不會阻塞
+// 只保證各欄位自身正確，讀取時不同欄位之間可能相差正在進行中的幾筆
+class MetricCounter
+{
+public:
+    void     Add(uint64_t const amount = 1) { m_value.fetch_add(amount, std::memory_order_relaxed); }
+    uint64_t Get() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_value{0};
+};
+
+//----------------------------------------------------------------------------------------------------
+class MetricGauge
+{
+public:
+    void   Set(double value);
+    void   Add(double amount);
+    double Get() const;
+
+private:
+    std::atomic<uint64_t> m_bits{0};        // double 的位元 (0 = 0.0)
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sMetricHistogramSnapshot
+{
+    uint64_t              count = 0;
+    uint64_t              sum   = 0;
+    std::vector<uint64_t> buckets;
+
+    // percentile 為 0-100；回傳所在桶的上界，沒有資料時為 0
+    uint64_t GetValueAtPercentile(double percentile) const;
+};
+
+//----------------------------------------------------------------------------------------------------
+class MetricHistogram
+{
+public:
+    MetricHistogram();
+
+    void Record(uint64_t const value)
+    {
+        m_buckets[GetBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    void GetSnapshot(sMetricHistogramSnapshot& snapshot) const;
+
+    static int      GetBucketIndex(uint64_t value);
+    static uint64_t GetBucketUpperBound(int bucketIndex);       // 桶內最大的值 (含)
+
+private:
+    std::atomic<uint64_t> m_buckets[METRIC_HISTOGRAM_BUCKET_COUNT];
+    std::atomic<uint64_t> m_sum{0};
+};
+
+//----------------------------------------------------------------------------------------------------
+inline int MetricHistogram::GetBucketIndex(uint64_t value)
+{
+    uint64_t const subBucketCount = 1ull << METRIC_HISTOGRAM_SUB_BUCKET_BITS;
+    if (value < subBucketCount) return (int)value;
+
+    uint64_t const maxValue = (1ull << METRIC_HISTOGRAM_MAX_EXPONENT) - 1;
+    if (value > maxValue) value = maxValue;
+
+    // 最高位元的位置決定冪次，其下的 SUB_BUCKET_BITS 位元決定桶
+    int exponent = 0;
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long highestBit = 0;
+    _BitScanReverse64(&highestBit, value);
+    exponent = (int)highestBit;
+#elif defined(__GNUC__)
+    exponent = 63 - __builtin_clzll(value);
+#else
+    while ((value >> (exponent + 1)) != 0) ++exponent;
+#endif
+
+    int const shift = exponent - METRIC_HISTOGRAM_SUB_BUCKET_BITS;
+    return ((shift + 1) << METRIC_HISTOGRAM_SUB_BUCKET_BITS) + (int)((value >> shift) - subBucketCount);
+}
+
+//----------------------------------------------------------------------------------------------------
+// 啟動時註冊指標 (之後位址不變，熱路徑直接持有參考)，WriteText 可以在任何執行緒呼叫
+// 名稱需符合 Prometheus 的規則且不重複；直方圖以整數記錄，輸出時乘上 unitScale (例如奈秒 -> 秒為 1e-9)
+class MetricsRegistry
+{
+public:
+    MetricCounter&   AddCounter(char const* name, char const* help);
+    MetricGauge&     AddGauge(char const* name, char const* help);
+    MetricHistogram& AddHistogram(char const* name, char const* help, double unitScale = 1.0);
+
+    // Prometheus text exposition format 0.0.4；直方圖只輸出 2 的冪次的上界
+    void WriteText(std::string& text) const;
+
+    size_t GetMetricCount() const;
+
+private:
+    struct sMetricEntry
+    {
+        std::string name;
+        std::string help;
+        eMetricType type      = eMetricType::Counter;
+        size_t      index     = 0;                  // 對應型別的 deque 索引
+        double      unitScale = 1.0;
+    };
+
+    mutable std::mutex          m_mutex;
+    std::vector<sMetricEntry>   m_entries;
+    std::deque<MetricCounter>   m_counters;
+    std::deque<MetricGauge>     m_gauges;
+    std::deque<MetricHistogram> m_histograms;
+};
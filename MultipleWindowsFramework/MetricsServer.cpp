@@ -0,0 +1,208 @@
+﻿//----------------------------------------------------------------------------------------------------
+// MetricsServer.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#include "MetricsServer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "Metrics.hpp"
+
+//----------------------------------------------------------------------------------------------------
+#if defined(_WIN32)
+using SocketHandle = SOCKET;
+static SocketHandle const INVALID_SOCKET_HANDLE = INVALID_SOCKET;
+static int const          SEND_FLAGS            = 0;
+
+static void CloseSocket(SocketHandle const handle) { closesocket(handle); }
+#else
+using SocketHandle = int;
+static SocketHandle const INVALID_SOCKET_HANDLE = -1;
+static int const          SEND_FLAGS            = MSG_NOSIGNAL;    // 對方先關閉時不要收到 SIGPIPE
+
+static void CloseSocket(SocketHandle const handle) { close(handle); }
+#endif
+
+static size_t const MAX_REQUEST_SIZE = 4096;
+
+//----------------------------------------------------------------------------------------------------
+static bool SendAll(SocketHandle const handle, char const* data, size_t size)
+{
+    while (size > 0)
+    {
+        int const sent = send(handle, data, (int)(std::min)(size, (size_t)1 << 20), SEND_FLAGS);
+        if (sent <= 0) return false;
+
+        data += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+MetricsServer::~MetricsServer()
+{
+    Stop();
+}
+
+//----------------------------------------------------------------------------------------------------
+bool MetricsServer::Start(MetricsRegistry const& registry, uint16_t const port)
+{
+    Stop();
+
+#if defined(_WIN32)
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) return false;
+#endif
+
+    SocketHandle const listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener == INVALID_SOCKET_HANDLE)
+    {
+#if defined(_WIN32)
+        WSACleanup();
+#endif
+        return false;
+    }
+
+#if !defined(_WIN32)
+    // 重新啟動時不必等上一次的連線離開 TIME_WAIT
+    int const reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#endif
+
+    // 只接受本機連線
+    sockaddr_in address     = {};
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    socklen_t addressLength = sizeof(address);
+    if (bind(listener, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) != 0 ||
+        listen(listener, 4) != 0 ||
+        getsockname(listener, reinterpret_cast<sockaddr*>(&address), &addressLength) != 0)
+    {
+        CloseSocket(listener);
+#if defined(_WIN32)
+        WSACleanup();
+#endif
+        return false;
+    }
+
+    m_registry = &registry;
+    m_socket   = (uintptr_t)listener;
+    m_port     = ntohs(address.sin_port);
+    m_isStopping.store(false);
+    m_thread = std::thread(&MetricsServer::Run, this);
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+void MetricsServer::Stop()
+{
+    if (!m_thread.joinable()) return;
+
+    // 執行緒最多在一個 select 逾時 (100ms) 內結束
+    m_isStopping.store(true);
+    m_thread.join();
+
+    CloseSocket((SocketHandle)m_socket);
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+
+    m_registry = nullptr;
+    m_socket   = 0;
+    m_port     = 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+void MetricsServer::Run()
+{
+    SocketHandle const listener = (SocketHandle)m_socket;
+
+    while (!m_isStopping.load())
+    {
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        FD_SET(listener, &readSet);
+
+        timeval timeout = {0, 100 * 1000};
+        if (select((int)listener + 1, &readSet, nullptr, nullptr, &timeout) <= 0) continue;
+
+        SocketHandle const client = accept(listener, nullptr, nullptr);
+        if (client == INVALID_SOCKET_HANDLE) continue;
+
+        Serve((uintptr_t)client);
+        CloseSocket(client);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+void MetricsServer::Serve(uintptr_t const clientSocket)
+{
+    SocketHandle const client = (SocketHandle)clientSocket;
+
+    // 不完整的請求最多等一秒，避免卡住之後的讀取
+#if defined(_WIN32)
+    DWORD const receiveTimeout = 1000;
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<char const*>(&receiveTimeout), sizeof(receiveTimeout));
+#else
+    timeval const receiveTimeout = {1, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &receiveTimeout, sizeof(receiveTimeout));
+#endif
+
+    // 只需要請求列，讀到標頭結束為止
+    char   request[MAX_REQUEST_SIZE + 1];
+    size_t requestSize = 0;
+    while (requestSize < MAX_REQUEST_SIZE)
+    {
+        int const received = recv(client, request + requestSize, (int)(MAX_REQUEST_SIZE - requestSize), 0);
+        if (received <= 0) break;
+
+        requestSize          += (size_t)received;
+        request[requestSize]  = '\0';
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n")) break;
+    }
+    request[requestSize] = '\0';
+
+    bool const isMetricsRequest = strncmp(request, "GET /metrics ", 13) == 0 || strncmp(request, "GET / ", 6) == 0;
+    if (!isMetricsRequest)
+    {
+        char const notFound[] = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        SendAll(client, notFound, sizeof(notFound) - 1);
+        return;
+    }
+
+    std::string body;
+    m_registry->WriteText(body);
+
+    char header[256];
+    int const headerSize = snprintf(header, sizeof(header),
+                                    "HTTP/1.0 200 OK\r\n"
+                                    "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                                    "Content-Length: %zu\r\n"
+                                    "Connection: close\r\n\r\n",
+                                    body.size());
+
+    if (SendAll(client, header, (size_t)headerSize) && SendAll(client, body.data(), body.size()))
+    {
+        m_scrapeCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,44 @@
+﻿//----------------------------------------------------------------------------------------------------
+// MetricsServer.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+//-Forward-Declaration--------------------------------------------------------------------------------
+class MetricsRegistry;
+
+//----------------------------------------------------------------------------------------------------
+// 讓 Prometheus 或 curl 讀取指標的最小 HTTP 端點：只綁定 127.0.0.1，背景執行緒一次處理一個連線
+//   curl http://127.0.0.1:<port>/metrics
+class MetricsServer
+{
+public:
+    MetricsServer() = default;
+    ~MetricsServer();
+
+    MetricsServer(MetricsServer const&)            = delete;
+    MetricsServer& operator=(MetricsServer const&) = delete;
+
+    // port 為 0 時由系統分配 (以 GetPort 取得)；registry 必須比伺服器晚銷毀
+    bool Start(MetricsRegistry const& registry, uint16_t port);
+    void Stop();
+
+    bool               IsRunning() const { return m_thread.joinable(); }
+    uint16_t           GetPort() const { return m_port; }
+    unsigned long long GetScrapeCount() const { return m_scrapeCount.load(std::memory_order_relaxed); }
+
+private:
+    void Run();
+    void Serve(uintptr_t client);
+
+    MetricsRegistry const*          m_registry = nullptr;
+    std::thread                     m_thread;
+    std::atomic<bool>               m_isStopping{false};
+    std::atomic<unsigned long long> m_scrapeCount{0};
+    uintptr_t                       m_socket = 0;           // SOCKET / 檔案描述子
+    uint16_t                        m_port   = 0;
+};
@@ -0,0 +1,419 @@
+﻿//----------------------------------------------------------------------------------------------------
+// MipChain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "MipChain.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "ThreadPool.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define MIP_CHAIN_USE_SSE2 1
+#include <emmintrin.h>
+#else
+#define MIP_CHAIN_USE_SSE2 0
+#endif
+
+//----------------------------------------------------------------------------------------------------
+static int const   KAISER_TAP_COUNT = 6;        // 目的像素中心兩側各 3 個來源像素
+static float const KAISER_ALPHA     = 4.f;
+static int const   MIP_ROWS_PER_JOB = 16;
+
+//----------------------------------------------------------------------------------------------------
+// 第一類零階修正貝索函數 (級數展開)
+static double BesselI0(double const x)
+{
+    double sum  = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; ++k)
+    {
+        double const factor = x / (2.0 * k);
+        term *= factor * factor;
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 2:1 縮小時來源像素相對目的像素中心的距離為 ±0.5、±1.5、±2.5
+struct sKaiserKernel
+{
+    float weights[KAISER_TAP_COUNT];
+
+    sKaiserKernel()
+    {
+        double const pi     = 3.14159265358979323846;
+        double const radius = KAISER_TAP_COUNT / 2.0;
+        double       sum    = 0.0;
+        double       raw[KAISER_TAP_COUNT];
+
+        for (int k = 0; k < KAISER_TAP_COUNT; ++k)
+        {
+            double const distance = (double)k - radius + 0.5;
+            double const t        = distance * 0.5;    // 以目的像素為單位
+            double const sinc     = std::sin(pi * t) / (pi * t);
+            double const ratio    = distance / radius;
+            double const window   = BesselI0(KAISER_ALPHA * std::sqrt((std::max)(0.0, 1.0 - ratio * ratio))) / BesselI0(KAISER_ALPHA);
+
+            raw[k] = sinc * window;
+            sum += raw[k];
+        }
+
+        for (int k = 0; k < KAISER_TAP_COUNT; ++k)
+        {
+            weights[k] = (float)(raw[k] / sum);
+        }
+    }
+};
+
+static sKaiserKernel const s_kaiserKernel;
+
+//----------------------------------------------------------------------------------------------------
+unsigned int GetMipLevelCount(unsigned int width, unsigned int height)
+{
+    if (width == 0 || height == 0) return 0;
+
+    unsigned int count = 1;
+    while (width > 1 || height > 1)
+    {
+        width  = (std::max)(1u, width / 2);
+        height = (std::max)(1u, height / 2);
+        ++count;
+    }
+    return count;
+}
+
+//----------------------------------------------------------------------------------------------------
+static void AllocateMipChain(unsigned int width, unsigned int height, sMipChain& chain)
+{
+    chain.levels.clear();
+
+    size_t       total = 0;
+    unsigned int count = GetMipLevelCount(width, height);
+    for (unsigned int level = 0; level < count; ++level)
+    {
+        sMipLevel mip;
+        mip.width  = width;
+        mip.height = height;
+        mip.offset = total;
+        chain.levels.push_back(mip);
+
+        total += (size_t)width * height;
+        width  = (std::max)(1u, width / 2);
+        height = (std::max)(1u, height / 2);
+    }
+
+    chain.pixels.resize(total);
+}
+
+//----------------------------------------------------------------------------------------------------
+static inline int ClampIndex(int const index, int const size)
+{
+    return index < 0 ? 0 : (index >= size ? size - 1 : index);
+}
+
+//----------------------------------------------------------------------------------------------------
+static inline uint32_t BoxPixel(uint32_t const* source, int const sourceWidth, int const sourceHeight, int const x, int const y)
+{
+    int const x0 = ClampIndex(x * 2, sourceWidth);
+    int const x1 = ClampIndex(x * 2 + 1, sourceWidth);
+    int const y0 = ClampIndex(y * 2, sourceHeight);
+    int const y1 = ClampIndex(y * 2 + 1, sourceHeight);
+
+    uint32_t const c00 = source[y0 * sourceWidth + x0];
+    uint32_t const c10 = source[y0 * sourceWidth + x1];
+    uint32_t const c01 = source[y1 * sourceWidth + x0];
+    uint32_t const c11 = source[y1 * sourceWidth + x1];
+
+    uint32_t result = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        uint32_t const sum = ((c00 >> shift) & 0xFF) + ((c10 >> shift) & 0xFF) +
+                             ((c01 >> shift) & 0xFF) + ((c11 >> shift) & 0xFF);
+        result |= ((sum + 2) >> 2) << shift;
+    }
+    return result;
+}
+
+//----------------------------------------------------------------------------------------------------
+static void DownsampleBoxRows(sMipLevel const& sourceLevel, uint32_t const* source,
+                              sMipLevel const& targetLevel, uint32_t* target,
+                              int const rowBegin, int const rowEnd, bool const useSimd)
+{
+    int const sourceWidth  = (int)sourceLevel.width;
+    int const sourceHeight = (int)sourceLevel.height;
+    int const targetWidth  = (int)targetLevel.width;
+
+    for (int y = rowBegin; y < rowEnd; ++y)
+    {
+        uint32_t* row = target + (size_t)y * targetWidth;
+        int       x   = 0;
+
+#if MIP_CHAIN_USE_SSE2
+        // 兩列都存在時，一次讀 4 個來源像素產生 2 個目的像素
+        if (useSimd && y * 2 + 1 < sourceHeight)
+        {
+            uint32_t const* row0  = source + (size_t)(y * 2) * sourceWidth;
+            uint32_t const* row1  = row0 + sourceWidth;
+            __m128i const   zero  = _mm_setzero_si128();
+            __m128i const   round = _mm_set1_epi16(2);
+
+            for (; x * 2 + 3 < sourceWidth && x + 2 <= targetWidth; x += 2)
+            {
+                __m128i const top    = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row0 + x * 2));
+                __m128i const bottom = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row1 + x * 2));
+
+                __m128i const sumLow  = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+                __m128i const sumHigh = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+
+                // 每個 64 位元的一半各是一個來源像素，高低相加即為 2x2 總和
+                __m128i const pixel0 = _mm_add_epi16(sumLow, _mm_srli_si128(sumLow, 8));
+                __m128i const pixel1 = _mm_add_epi16(sumHigh, _mm_srli_si128(sumHigh, 8));
+                __m128i const sums   = _mm_unpacklo_epi64(pixel0, pixel1);
+                __m128i const result = _mm_srli_epi16(_mm_add_epi16(sums, round), 2);
+
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(row + x), _mm_packus_epi16(result, zero));
+            }
+        }
+#else
+        (void)useSimd;
+#endif
+
+        for (; x < targetWidth; ++x)
+        {
+            row[x] = BoxPixel(source, sourceWidth, sourceHeight, x, y);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+static inline void AccumulateScalar(float accumulator[4], uint32_t const color, float const weight)
+{
+    for (int c = 0; c < 4; ++c)
+    {
+        accumulator[c] = accumulator[c] + weight * (float)((color >> (c * 8)) & 0xFF);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+static inline uint32_t ResolveScalar(float const accumulator[4])
+{
+    uint32_t result = 0;
+    for (int c = 0; c < 4; ++c)
+    {
+        float const value = (std::min)(255.f, (std::max)(0.f, accumulator[c] + 0.5f));
+        result |= (uint32_t)(int)value << (c * 8);
+    }
+    return result;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 水平方向：每個來源列縮成 targetWidth 個 float4，存入 intermediate
+static void KaiserHorizontalRows(sMipLevel const& sourceLevel, uint32_t const* source,
+                                 int const targetWidth, float* intermediate,
+                                 int const rowBegin, int const rowEnd, bool const useSimd)
+{
+    int const sourceWidth = (int)sourceLevel.width;
+
+    for (int y = rowBegin; y < rowEnd; ++y)
+    {
+        uint32_t const* sourceRow = source + (size_t)y * sourceWidth;
+        float*          outRow    = intermediate + (size_t)y * targetWidth * 4;
+
+        for (int x = 0; x < targetWidth; ++x)
+        {
+            int const first = x * 2 - KAISER_TAP_COUNT / 2 + 1;
+
+            // 寬度沒有縮小 (寬為 1) 時直接複製
+            if (sourceWidth == 1)
+            {
+                float accumulator[4] = {0.f, 0.f, 0.f, 0.f};
+                AccumulateScalar(accumulator, sourceRow[0], 1.f);
+                memcpy(outRow + x * 4, accumulator, sizeof(accumulator));
+                continue;
+            }
+
+#if MIP_CHAIN_USE_SSE2
+            if (useSimd)
+            {
+                __m128i const zero        = _mm_setzero_si128();
+                __m128        accumulator = _mm_setzero_ps();
+                for (int k = 0; k < KAISER_TAP_COUNT; ++k)
+                {
+                    uint32_t const color = sourceRow[ClampIndex(first + k, sourceWidth)];
+                    __m128i const  wide  = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)color), zero), zero);
+                    accumulator          = _mm_add_ps(accumulator, _mm_mul_ps(_mm_set1_ps(s_kaiserKernel.weights[k]), _mm_cvtepi32_ps(wide)));
+                }
+                _mm_storeu_ps(outRow + x * 4, accumulator);
+                continue;
+            }
+#else
+            (void)useSimd;
+#endif
+
+            float accumulator[4] = {0.f, 0.f, 0.f, 0.f};
+            for (int k = 0; k < KAISER_TAP_COUNT; ++k)
+            {
+                AccumulateScalar(accumulator, sourceRow[ClampIndex(first + k, sourceWidth)], s_kaiserKernel.weights[k]);
+            }
+            memcpy(outRow + x * 4, accumulator, sizeof(accumulator));
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+// 垂直方向：合併 intermediate 的列並轉回 RGBA8
+static void KaiserVerticalRows(int const sourceHeight, float const* intermediate,
+                               sMipLevel const& targetLevel, uint32_t* target,
+                               int const rowBegin, int const rowEnd, bool const useSimd)
+{
+    int const targetWidth = (int)targetLevel.width;
+
+    for (int y = rowBegin; y < rowEnd; ++y)
+    {
+        int const first = y * 2 - KAISER_TAP_COUNT / 2 + 1;
+        uint32_t* row   = target + (size_t)y * targetWidth;
+
+        for (int x = 0; x < targetWidth; ++x)
+        {
+#if MIP_CHAIN_USE_SSE2
+            if (useSimd)
+            {
+                __m128 accumulator = _mm_setzero_ps();
+                if (sourceHeight == 1)
+                {
+                    accumulator = _mm_loadu_ps(intermediate + (size_t)x * 4);
+                }
+                else
+                {
+                    for (int k = 0; k < KAISER_TAP_COUNT; ++k)
+                    {
+                        float const* tap = intermediate + ((size_t)ClampIndex(first + k, sourceHeight) * targetWidth + x) * 4;
+                        accumulator      = _mm_add_ps(accumulator, _mm_mul_ps(_mm_set1_ps(s_kaiserKernel.weights[k]), _mm_loadu_ps(tap)));
+                    }
+                }
+
+                __m128 const  clamped = _mm_min_ps(_mm_set1_ps(255.f), _mm_max_ps(_mm_setzero_ps(), _mm_add_ps(accumulator, _mm_set1_ps(0.5f))));
+                __m128i const values  = _mm_cvttps_epi32(clamped);
+                __m128i const packed  = _mm_packs_epi32(values, values);
+                row[x]                = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(packed, packed));
+                continue;
+            }
+#else
+            (void)useSimd;
+#endif
+
+            float accumulator[4] = {0.f, 0.f, 0.f, 0.f};
+            if (sourceHeight == 1)
+            {
+                memcpy(accumulator, intermediate + (size_t)x * 4, sizeof(accumulator));
+            }
+            else
+            {
+                for (int k = 0; k < KAISER_TAP_COUNT; ++k)
+                {
+                    float const* tap = intermediate + ((size_t)ClampIndex(first + k, sourceHeight) * targetWidth + x) * 4;
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        accumulator[c] = accumulator[c] + s_kaiserKernel.weights[k] * tap[c];
+                    }
+                }
+            }
+            row[x] = ResolveScalar(accumulator);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+// 以固定列數切分工作，threadPool 為 nullptr 時依序執行
+static void ForEachRowBlock(ThreadPool* threadPool, int const rowCount, std::function<void(int rowBegin, int rowEnd)> const& body)
+{
+    int const blockCount = (rowCount + MIP_ROWS_PER_JOB - 1) / MIP_ROWS_PER_JOB;
+    auto const runBlock  = [&](int const block)
+    {
+        int const rowBegin = block * MIP_ROWS_PER_JOB;
+        body(rowBegin, (std::min)(rowCount, rowBegin + MIP_ROWS_PER_JOB));
+    };
+
+    if (threadPool)
+    {
+        threadPool->ParallelFor(blockCount, runBlock);
+        return;
+    }
+    for (int block = 0; block < blockCount; ++block)
+    {
+        runBlock(block);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+static void BuildMipChainInternal(uint32_t const* pixels,
+                                  unsigned int const width,
+                                  unsigned int const height,
+                                  eMipFilter const filter,
+                                  sMipChain& chain,
+                                  ThreadPool* threadPool,
+                                  bool const useSimd)
+{
+    AllocateMipChain(width, height, chain);
+    if (chain.levels.empty() || !pixels) return;
+
+    memcpy(chain.pixels.data(), pixels, (size_t)width * height * sizeof(uint32_t));
+
+    std::vector<float> intermediate;
+
+    for (size_t level = 1; level < chain.levels.size(); ++level)
+    {
+        sMipLevel const& sourceLevel = chain.levels[level - 1];
+        sMipLevel const& targetLevel = chain.levels[level];
+        uint32_t const*  source      = chain.pixels.data() + sourceLevel.offset;
+        uint32_t*        target      = chain.pixels.data() + targetLevel.offset;
+
+        if (filter == eMipFilter::Box)
+        {
+            ForEachRowBlock(threadPool, (int)targetLevel.height, [&](int const rowBegin, int const rowEnd)
+            {
+                DownsampleBoxRows(sourceLevel, source, targetLevel, target, rowBegin, rowEnd, useSimd);
+            });
+            continue;
+        }
+
+        // 可分離濾波：先水平縮小所有來源列，再垂直合併
+        intermediate.resize((size_t)targetLevel.width * sourceLevel.height * 4);
+
+        ForEachRowBlock(threadPool, (int)sourceLevel.height, [&](int const rowBegin, int const rowEnd)
+        {
+            KaiserHorizontalRows(sourceLevel, source, (int)targetLevel.width, intermediate.data(), rowBegin, rowEnd, useSimd);
+        });
+        ForEachRowBlock(threadPool, (int)targetLevel.height, [&](int const rowBegin, int const rowEnd)
+        {
+            KaiserVerticalRows((int)sourceLevel.height, intermediate.data(), targetLevel, target, rowBegin, rowEnd, useSimd);
+        });
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+void BuildMipChain(uint32_t const* pixels,
+                   unsigned int const width,
+                   unsigned int const height,
+                   eMipFilter const filter,
+                   sMipChain& chain,
+                   ThreadPool* threadPool)
+{
+    BuildMipChainInternal(pixels, width, height, filter, chain, threadPool, true);
+}
+
+//----------------------------------------------------------------------------------------------------
+void BuildMipChainReference(uint32_t const* pixels,
+                            unsigned int const width,
+                            unsigned int const height,
+                            eMipFilter const filter,
+                            sMipChain& chain)
+{
+    BuildMipChainInternal(pixels, width, height, filter, chain, nullptr, false);
+}
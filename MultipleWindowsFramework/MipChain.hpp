@@ -0,0 +1,55 @@
+﻿//----------------------------------------------------------------------------------------------------
+// MipChain.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//-Forward-Declaration--------------------------------------------------------------------------------
+class ThreadPool;
+
+//----------------------------------------------------------------------------------------------------
+enum class eMipFilter
+{
+    Box,                                    // 2x2 平均，最快
+    Kaiser                                  // 6-tap Kaiser 窗 sinc，縮小時較不模糊也較少鋸齒
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sMipLevel
+{
+    unsigned int width  = 0;
+    unsigned int height = 0;
+    size_t       offset = 0;                // 在 sMipChain::pixels 中的起始位置 (像素)
+};
+
+//----------------------------------------------------------------------------------------------------
+// 所有層級緊密排列在同一個緩衝區，level 0 為原圖
+struct sMipChain
+{
+    std::vector<uint32_t>  pixels;
+    std::vector<sMipLevel> levels;
+
+    uint32_t const* GetLevelPixels(size_t const level) const { return pixels.data() + levels[level].offset; }
+};
+
+//----------------------------------------------------------------------------------------------------
+unsigned int GetMipLevelCount(unsigned int width, unsigned int height);
+
+// RGBA8 (每通道獨立過濾)；每一層依列分給執行緒池，threadPool 為 nullptr 時在呼叫端執行
+void BuildMipChain(uint32_t const* pixels,
+                   unsigned int    width,
+                   unsigned int    height,
+                   eMipFilter      filter,
+                   sMipChain&      chain,
+                   ThreadPool*     threadPool = nullptr);
+
+// 純量版本，作為 SIMD 版本的比對基準
+void BuildMipChainReference(uint32_t const* pixels,
+                            unsigned int    width,
+                            unsigned int    height,
+                            eMipFilter      filter,
+                            sMipChain&      chain);
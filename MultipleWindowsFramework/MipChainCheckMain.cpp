@@ -0,0 +1,199 @@
+﻿//----------------------------------------------------------------------------------------------------
+// MipChainCheckMain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// 測試圖樣與 mip chain 的 SIMD 版本檢查 (不屬於 Windows 專案，在 Linux 上單獨編譯)：
+//
+//   g++ -std=c++14 -O2 -pthread MipChainCheckMain.cpp MipChain.cpp TextureGenerator.cpp ThreadPool.cpp -o mip_chain_check
+//   ./mip_chain_check [iterations]
+//
+// GenerateTestPattern 與 BuildMipChain (單執行緒與執行緒池) 必須與純量的 GenerateTestPatternReference、
+// BuildMipChainReference 逐位元相同，涵蓋奇數、1 像素寬高與不是 4 的倍數的尺寸；另外檢查各層的大小與排列，
+// 以及常數圖在兩種濾波下保持不變。最後量測 512x512 測試圖樣與 2048x2048 mip chain 各版本的時間
+// 結束碼：0 = 全部通過，1 = 失敗
+//----------------------------------------------------------------------------------------------------
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "CheckMain.hpp"
+#include "MipChain.hpp"
+#include "TextureGenerator.hpp"
+#include "ThreadPool.hpp"
+
+//----------------------------------------------------------------------------------------------------
+static std::vector<uint32_t> MakeNoise(unsigned int const width, unsigned int const height, uint32_t& seed)
+{
+    std::vector<uint32_t> pixels((size_t)width * height);
+    for (uint32_t& pixel : pixels)
+    {
+        pixel = NextRandom(seed);
+    }
+    return pixels;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 每層寬高減半 (至少 1)，緊密排列，最後一層為 1x1
+static bool IsLayoutValid(sMipChain const& chain, unsigned int width, unsigned int height)
+{
+    if (chain.levels.size() != GetMipLevelCount(width, height)) return false;
+
+    size_t offset = 0;
+    for (sMipLevel const& level : chain.levels)
+    {
+        if (level.width != width || level.height != height || level.offset != offset) return false;
+
+        offset += (size_t)width * height;
+        width   = (std::max)(1u, width / 2);
+        height  = (std::max)(1u, height / 2);
+    }
+    return chain.pixels.size() == offset && chain.levels.back().width == 1 && chain.levels.back().height == 1;
+}
+
+//----------------------------------------------------------------------------------------------------
+static bool CheckTestPattern(ThreadPool& threadPool)
+{
+    unsigned int const sizes[][2] = {{512, 512}, {1, 1}, {3, 7}, {513, 97}, {64, 64}, {1000, 333}, {5, 1}, {2048, 2048}};
+
+    bool isSingleMatched = true;
+    bool isPoolMatched   = true;
+    for (auto const& size : sizes)
+    {
+        size_t const          count = (size_t)size[0] * size[1];
+        std::vector<uint32_t> reference(count), single(count, 0xDEADBEEF), pooled(count, 0xDEADBEEF);
+
+        GenerateTestPatternReference(reference.data(), size[0], size[1]);
+        GenerateTestPattern(single.data(), size[0], size[1]);
+        GenerateTestPattern(pooled.data(), size[0], size[1], &threadPool);
+
+        isSingleMatched &= single == reference;
+        isPoolMatched   &= pooled == reference;
+    }
+
+    bool isPassing = true;
+    isPassing &= Check(isSingleMatched, "pattern_matches_reference");
+    isPassing &= Check(isPoolMatched, "pattern_pool_matches_reference");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+static bool CheckMipChain(ThreadPool& threadPool, unsigned int const iterations)
+{
+    uint32_t seed             = 0x2545F491u;
+    bool     isLayoutValid    = true;
+    bool     isSingleMatched  = true;
+    bool     isPoolMatched    = true;
+    bool     isLevelZeroExact = true;
+
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        // 多數是小尺寸 (邊界處理佔大部分)，偶爾較大
+        unsigned int const limit  = i % 16 == 0 ? 300 : 70;
+        unsigned int const width  = 1 + NextRandom(seed) % limit;
+        unsigned int const height = 1 + NextRandom(seed) % limit;
+
+        std::vector<uint32_t> const pixels = MakeNoise(width, height, seed);
+        for (eMipFilter const filter : {eMipFilter::Box, eMipFilter::Kaiser})
+        {
+            sMipChain reference, single, pooled;
+            BuildMipChainReference(pixels.data(), width, height, filter, reference);
+            BuildMipChain(pixels.data(), width, height, filter, single);
+            BuildMipChain(pixels.data(), width, height, filter, pooled, &threadPool);
+
+            isLayoutValid    &= IsLayoutValid(reference, width, height) && IsLayoutValid(single, width, height);
+            isSingleMatched  &= single.pixels == reference.pixels;
+            isPoolMatched    &= pooled.pixels == reference.pixels;
+            isLevelZeroExact &= std::equal(pixels.begin(), pixels.end(), single.GetLevelPixels(0));
+        }
+    }
+
+    // 常數圖：所有層級都是同一個顏色 (Kaiser 的權重總和為 1，不會有偏差)
+    bool                        isConstant = true;
+    std::vector<uint32_t> const constant((size_t)37 * 19, 0x80402010);
+    for (eMipFilter const filter : {eMipFilter::Box, eMipFilter::Kaiser})
+    {
+        sMipChain chain;
+        BuildMipChain(constant.data(), 37, 19, filter, chain, &threadPool);
+        isConstant &= std::all_of(chain.pixels.begin(), chain.pixels.end(), [](uint32_t const pixel) { return pixel == 0x80402010; });
+    }
+
+    // 同一個 sMipChain 重複使用時不殘留上一次的層級
+    sMipChain reused;
+    BuildMipChain(constant.data(), 37, 19, eMipFilter::Box, reused);
+    BuildMipChain(constant.data(), 4, 2, eMipFilter::Box, reused);
+    bool const isReused = IsLayoutValid(reused, 4, 2);
+
+    printf("mip_iterations %u\n", iterations);
+
+    bool isPassing = true;
+    isPassing &= Check(isLayoutValid && isReused, "mip_layout");
+    isPassing &= Check(isLevelZeroExact, "mip_level_zero_copied");
+    isPassing &= Check(isSingleMatched, "mip_matches_reference");
+    isPassing &= Check(isPoolMatched, "mip_pool_matches_reference");
+    isPassing &= Check(isConstant, "mip_constant_preserved");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+template <typename Function>
+static double MeasureMilliseconds(int const repeats, Function function)
+{
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point const start = Clock::now();
+    for (int i = 0; i < repeats; ++i)
+    {
+        function();
+    }
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / repeats;
+}
+
+//----------------------------------------------------------------------------------------------------
+int main(int const argc, char** argv)
+{
+    unsigned int const iterations = argc > 1 ? (unsigned int)strtoul(argv[1], nullptr, 0) : 300u;
+
+    ThreadPool threadPool;
+
+    bool isPassing = true;
+    isPassing &= CheckTestPattern(threadPool);
+    isPassing &= CheckMipChain(threadPool, iterations);
+
+    // 基準：測試圖樣 512x512 (Renderer 找不到圖片時的大小)
+    unsigned int const    patternSize = 512;
+    std::vector<uint32_t> pattern((size_t)patternSize * patternSize);
+
+    double const patternReferenceMs = MeasureMilliseconds(20, [&] { GenerateTestPatternReference(pattern.data(), patternSize, patternSize); });
+    double const patternSingleMs    = MeasureMilliseconds(20, [&] { GenerateTestPattern(pattern.data(), patternSize, patternSize); });
+    double const patternPoolMs      = MeasureMilliseconds(20, [&] { GenerateTestPattern(pattern.data(), patternSize, patternSize, &threadPool); });
+
+    printf("benchmark_workers %u\n", threadPool.GetWorkerCount());
+    printf("benchmark_pattern_reference_ms %.3f\n", patternReferenceMs);
+    printf("benchmark_pattern_simd_ms %.3f\n", patternSingleMs);
+    printf("benchmark_pattern_pool_ms %.3f\n", patternPoolMs);
+    printf("benchmark_pattern_simd_speedup %.2f\n", patternReferenceMs / patternSingleMs);
+
+    // 基準：2048x2048 的完整 mip chain
+    unsigned int const          imageSize = 2048;
+    uint32_t                    seed      = 12345;
+    std::vector<uint32_t> const image     = MakeNoise(imageSize, imageSize, seed);
+    sMipChain                   chain;
+
+    for (eMipFilter const filter : {eMipFilter::Box, eMipFilter::Kaiser})
+    {
+        char const* const name = filter == eMipFilter::Box ? "box" : "kaiser";
+
+        double const referenceMs = MeasureMilliseconds(3, [&] { BuildMipChainReference(image.data(), imageSize, imageSize, filter, chain); });
+        double const singleMs    = MeasureMilliseconds(3, [&] { BuildMipChain(image.data(), imageSize, imageSize, filter, chain); });
+        double const poolMs      = MeasureMilliseconds(3, [&] { BuildMipChain(image.data(), imageSize, imageSize, filter, chain, &threadPool); });
+
+        printf("benchmark_mip_%s_reference_ms %.2f\n", name, referenceMs);
+        printf("benchmark_mip_%s_simd_ms %.2f\n", name, singleMs);
+        printf("benchmark_mip_%s_pool_ms %.2f\n", name, poolMs);
+        printf("benchmark_mip_%s_simd_speedup %.2f\n", name, referenceMs / singleMs);
+    }
+    return isPassing ? 0 : 1;
+}
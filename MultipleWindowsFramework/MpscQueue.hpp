@@ -0,0 +1,121 @@
+﻿//----------------------------------------------------------------------------------------------------
+// MpscQueue.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+//----------------------------------------------------------------------------------------------------
+// 有界的多生產者、單一消費者佇列 (環狀緩衝區，每個格子有自己的序號)
+// Push 可在任何執行緒呼叫，只用一次 CAS 搶位置，不配置記憶體也不取得鎖；佇列滿時立即回傳 false
+// Pop / Drain 只能由同一個消費者執行緒呼叫
+//
+// 格子的序號：等於 position 表示可寫入，等於 position + 1 表示已寫入可讀取，
+// 讀取後設為 position + capacity 留給下一輪。生產者搶到位置後被搶佔時，消費者會停在該格子，下次再繼續
+template <typename T>
+class MpscQueue
+{
+public:
+    explicit MpscQueue(size_t capacity = 1024)
+    {
+        // 容量取 2 的次方，以遮罩取代除法
+        size_t rounded = 2;
+        while (rounded < capacity) rounded <<= 1;
+
+        m_mask  = rounded - 1;
+        m_cells.reset(new sCell[rounded]);
+        for (size_t i = 0; i < rounded; ++i)
+        {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        m_enqueuePosition.store(0, std::memory_order_relaxed);
+        m_fullCount.store(0, std::memory_order_relaxed);
+    }
+
+    MpscQueue(MpscQueue const&)            = delete;
+    MpscQueue& operator=(MpscQueue const&) = delete;
+
+    size_t GetCapacity() const { return m_mask + 1; }
+
+    // 佇列滿而被拒絕的次數 (任何執行緒都可讀取)
+    unsigned long long GetFullCount() const { return m_fullCount.load(std::memory_order_relaxed); }
+
+    bool Push(T const& value)
+    {
+        size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+        sCell* cell;
+        for (;;)
+        {
+            cell = &m_cells[position & m_mask];
+
+            size_t const   sequence   = cell->sequence.load(std::memory_order_acquire);
+            intptr_t const difference = (intptr_t)sequence - (intptr_t)position;
+            if (difference == 0)
+            {
+                // 失敗時 position 會更新為目前值，直接重試
+                if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+            }
+            else if (difference < 0)
+            {
+                // 消費者還沒讀走上一輪的資料
+                m_fullCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                position = m_enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = value;
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(T& value)
+    {
+        sCell&       cell     = m_cells[m_dequeuePosition & m_mask];
+        size_t const sequence = cell.sequence.load(std::memory_order_acquire);
+        if ((intptr_t)sequence - (intptr_t)(m_dequeuePosition + 1) < 0) return false;    // 空的，或生產者尚未寫完
+
+        value = cell.value;
+        cell.sequence.store(m_dequeuePosition + m_mask + 1, std::memory_order_release);
+        ++m_dequeuePosition;
+        return true;
+    }
+
+    // 依序取出最多 maxCount 個並交給 function，回傳取出的數量
+    // 有上限才不會因為生產者持續寫入而一直無法返回
+    template <typename Function>
+    size_t Drain(Function&& function, size_t maxCount)
+    {
+        size_t count = 0;
+        T      value;
+        while (count < maxCount && Pop(value))
+        {
+            function(value);
+            ++count;
+        }
+        return count;
+    }
+
+private:
+    struct sCell
+    {
+        std::atomic<size_t> sequence;
+        T                   value;
+    };
+
+    // 生產者與消費者的位置分開放在不同的快取行，避免互相讓對方的快取失效
+    std::unique_ptr<sCell[]>        m_cells;
+    size_t                          m_mask = 0;
+    char                            m_producerPadding[64];
+    std::atomic<size_t>             m_enqueuePosition;
+    std::atomic<unsigned long long> m_fullCount;
+    char                            m_consumerPadding[64];
+    size_t                          m_dequeuePosition = 0;
+};
@@ -0,0 +1,282 @@
+﻿//----------------------------------------------------------------------------------------------------
+// MpscQueueCheckMain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// MpscQueue 的壓力測試與基準 (不屬於 Windows 專案，在 Linux 上單獨編譯)：
+//
+//   g++ -std=c++14 -O2 -pthread MpscQueueCheckMain.cpp -o mpsc_queue_check
+//   g++ -std=c++14 -O1 -g -fsanitize=thread -pthread MpscQueueCheckMain.cpp -o mpsc_queue_check_tsan
+//   ./mpsc_queue_check [生產者數量] [每個生產者的命令數]
+//
+// 單執行緒：容量取 2 的次方、滿了拒絕並計數、先進先出、跨過環狀緩衝區的尾端、Drain 的上限
+// 壓力：多個生產者同時 Push (滿了就讓出時間片重試)，單一消費者以 Drain 取出；每個生產者的命令必須依序
+// 全部收到、不重複，命令的每個欄位都由 (生產者, 序號) 決定，讀到寫了一半的格子就會被發現。
+// 大佇列與容量 8 的小佇列 (頻繁繞回、頻繁滿) 各跑一次；以 ThreadSanitizer 編譯時另外檢查記憶體順序
+// 基準：與 std::mutex + std::deque 的相同工作量比較每個命令的時間
+// 結束碼：0 = 全部通過，1 = 失敗
+//----------------------------------------------------------------------------------------------------
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CheckMain.hpp"
+#include "MpscQueue.hpp"
+
+//----------------------------------------------------------------------------------------------------
+// 大小接近 sWindowCommand
+struct sTestCommand
+{
+    uint32_t producer   = 0;
+    uint32_t sequence   = 0;
+    uint64_t checksum   = 0;
+    float    params[12] = {};
+};
+
+static sTestCommand MakeCommand(uint32_t const producer, uint32_t const sequence)
+{
+    sTestCommand command;
+    command.producer = producer;
+    command.sequence = sequence;
+    command.checksum = ((uint64_t)producer << 32 | sequence) * 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < 12; ++i)
+    {
+        command.params[i] = (float)(sequence % 1000 + i);
+    }
+    return command;
+}
+
+static bool IsCommandIntact(sTestCommand const& command)
+{
+    sTestCommand const expected = MakeCommand(command.producer, command.sequence);
+    if (command.checksum != expected.checksum) return false;
+
+    for (int i = 0; i < 12; ++i)
+    {
+        if (command.params[i] != expected.params[i]) return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+static bool CheckSingleThread()
+{
+    MpscQueue<int> rounded(1000);
+    MpscQueue<int> tiny(1);
+    bool const     isCapacityRounded = rounded.GetCapacity() == 1024 && tiny.GetCapacity() == 2;
+
+    // 填滿後拒絕並計數
+    MpscQueue<int> queue(8);
+    bool           isFullRejected = true;
+    for (int i = 0; i < 8; ++i)
+    {
+        isFullRejected &= queue.Push(i);
+    }
+    isFullRejected &= !queue.Push(8) && !queue.Push(9) && queue.GetFullCount() == 2;
+
+    // 先進先出；取出一個之後又可以放入，位置跨過環狀緩衝區的尾端
+    bool isFifo = true;
+    int  value  = -1;
+    for (int round = 0; round < 5; ++round)
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            isFifo &= queue.Pop(value) && value == round * 8 + i;
+            isFifo &= queue.Push((round + 1) * 8 + i);
+        }
+    }
+    while (queue.Pop(value)) {}
+    isFifo &= !queue.Pop(value);
+
+    // Drain 最多取出 maxCount 個，依序交給 function
+    std::vector<int> drained;
+    for (int i = 0; i < 6; ++i)
+    {
+        queue.Push(100 + i);
+    }
+    size_t const firstCount    = queue.Drain([&](int const item) { drained.push_back(item); }, 4);
+    size_t const secondCount   = queue.Drain([&](int const item) { drained.push_back(item); }, 4);
+    size_t const thirdCount    = queue.Drain([&](int const item) { drained.push_back(item); }, 4);
+    bool const   isDrainCapped = firstCount == 4 && secondCount == 2 && thirdCount == 0 &&
+                                 drained == std::vector<int>({100, 101, 102, 103, 104, 105});
+
+    bool isPassing = true;
+    isPassing &= Check(isCapacityRounded, "capacity_rounded");
+    isPassing &= Check(isFullRejected, "full_rejected_and_counted");
+    isPassing &= Check(isFifo, "fifo_wraparound");
+    isPassing &= Check(isDrainCapped, "drain_capped");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+struct sStressResult
+{
+    bool               isOrdered   = true;
+    bool               isIntact    = true;
+    bool               isComplete  = false;
+    unsigned long long received    = 0;
+    unsigned long long fullCount   = 0;
+    unsigned long long drainCalls  = 0;
+    double             nanoseconds = 0.0;      // 每個命令
+};
+
+static sStressResult RunStress(size_t const capacity, unsigned int const producerCount, uint32_t const commandCount)
+{
+    using Clock = std::chrono::steady_clock;
+
+    MpscQueue<sTestCommand>  queue(capacity);
+    std::atomic<bool>        isStarted(false);
+    std::vector<std::thread> producers;
+
+    for (unsigned int producer = 0; producer < producerCount; ++producer)
+    {
+        producers.emplace_back([&, producer] {
+            while (!isStarted.load(std::memory_order_acquire)) std::this_thread::yield();
+
+            for (uint32_t sequence = 0; sequence < commandCount; ++sequence)
+            {
+                sTestCommand const command = MakeCommand(producer, sequence);
+                while (!queue.Push(command)) std::this_thread::yield();
+            }
+        });
+    }
+
+    sStressResult            result;
+    std::vector<uint32_t>    nextSequence(producerCount, 0);
+    unsigned long long const expected = (unsigned long long)producerCount * commandCount;
+    Clock::time_point const  start    = Clock::now();
+    isStarted.store(true, std::memory_order_release);
+
+    // 每次最多取出一整圈，與渲染執行緒每幀 Drain 的方式相同
+    while (result.received < expected)
+    {
+        size_t const count = queue.Drain([&](sTestCommand const& command) {
+            if (command.producer >= producerCount)
+            {
+                result.isIntact = false;
+                return;
+            }
+            result.isOrdered &= command.sequence == nextSequence[command.producer];
+            result.isIntact  &= IsCommandIntact(command);
+            nextSequence[command.producer] = command.sequence + 1;
+        }, queue.GetCapacity());
+
+        result.received += count;
+        ++result.drainCalls;
+        if (count == 0) std::this_thread::yield();
+    }
+    result.nanoseconds = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (std::max)(1ull, expected);
+
+    for (std::thread& producer : producers)
+    {
+        producer.join();
+    }
+
+    // 全部收到之後不能再有多餘的命令
+    sTestCommand extra;
+    result.isComplete = result.received == expected && !queue.Pop(extra);
+    for (uint32_t const sequence : nextSequence)
+    {
+        result.isComplete &= sequence == commandCount;
+    }
+    result.fullCount = queue.GetFullCount();
+    return result;
+}
+
+// 相同的工作量改用 std::mutex + std::deque，消費者每次交換整個佇列
+static double RunMutexBaseline(unsigned int const producerCount, uint32_t const commandCount)
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::mutex               mutex;
+    std::deque<sTestCommand> shared;
+    std::atomic<bool>        isStarted(false);
+    std::vector<std::thread> producers;
+
+    for (unsigned int producer = 0; producer < producerCount; ++producer)
+    {
+        producers.emplace_back([&, producer] {
+            while (!isStarted.load(std::memory_order_acquire)) std::this_thread::yield();
+
+            for (uint32_t sequence = 0; sequence < commandCount; ++sequence)
+            {
+                sTestCommand const          command = MakeCommand(producer, sequence);
+                std::lock_guard<std::mutex> lock(mutex);
+                shared.push_back(command);
+            }
+        });
+    }
+
+    unsigned long long const expected = (unsigned long long)producerCount * commandCount;
+    unsigned long long       received = 0;
+    std::deque<sTestCommand> local;
+    Clock::time_point const  start = Clock::now();
+    isStarted.store(true, std::memory_order_release);
+
+    while (received < expected)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            local.swap(shared);
+        }
+        received += local.size();
+        if (local.empty()) std::this_thread::yield();
+        local.clear();
+    }
+    double const nanoseconds = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (std::max)(1ull, expected);
+
+    for (std::thread& producer : producers)
+    {
+        producer.join();
+    }
+    return nanoseconds;
+}
+
+//----------------------------------------------------------------------------------------------------
+static bool PrintStress(sStressResult const& result, char const* name)
+{
+    printf("stress_%s_received %llu\n", name, result.received);
+    printf("stress_%s_full_count %llu\n", name, result.fullCount);
+    printf("stress_%s_drain_calls %llu\n", name, result.drainCalls);
+    printf("stress_%s_ns_per_command %.1f\n", name, result.nanoseconds);
+
+    std::string const prefix = std::string("stress_") + name;
+
+    bool isPassing = true;
+    isPassing &= Check(result.isOrdered, (prefix + "_per_producer_order").c_str());
+    isPassing &= Check(result.isIntact, (prefix + "_commands_intact").c_str());
+    isPassing &= Check(result.isComplete, (prefix + "_complete").c_str());
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+int main(int const argc, char** argv)
+{
+    unsigned int const producerCount = argc > 1 ? (std::max)(1u, (unsigned int)strtoul(argv[1], nullptr, 0)) : 4u;
+    uint32_t const     commandCount  = argc > 2 ? (uint32_t)strtoul(argv[2], nullptr, 0) : 200000u;
+
+    printf("producers %u\n", producerCount);
+    printf("commands_per_producer %u\n", commandCount);
+
+    bool isPassing = true;
+    isPassing &= CheckSingleThread();
+
+    // 與 Renderer 的命令佇列相同的容量，以及容量 8 的小佇列
+    sStressResult const large = RunStress(4096, producerCount, commandCount);
+    sStressResult const small = RunStress(8, producerCount, commandCount / 4);
+    isPassing &= PrintStress(large, "capacity_4096");
+    isPassing &= PrintStress(small, "capacity_8");
+
+    double const mutexNanoseconds = RunMutexBaseline(producerCount, commandCount);
+    printf("benchmark_mpsc_ns_per_command %.1f\n", large.nanoseconds);
+    printf("benchmark_mutex_deque_ns_per_command %.1f\n", mutexNanoseconds);
+    printf("benchmark_speedup %.2f\n", mutexNanoseconds / large.nanoseconds);
+    return isPassing ? 0 : 1;
+}
@@ -0,0 +1,52 @@
+﻿//----------------------------------------------------------------------------------------------------
+// PhaseTimer.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "PhaseTimer.hpp"
+
+//----------------------------------------------------------------------------------------------------
+void PhaseTimer::Start()
+{
+    m_start      = Clock::now();
+    m_phaseStart = m_start;
+    m_phases.clear();
+}
+
+//----------------------------------------------------------------------------------------------------
+void PhaseTimer::Mark(char const* phaseName)
+{
+    Clock::time_point const now = Clock::now();
+
+    sPhaseTiming phase;
+    phase.name         = phaseName;
+    phase.milliseconds = std::chrono::duration<double, std::milli>(now - m_phaseStart).count();
+    m_phases.push_back(phase);
+
+    m_phaseStart = now;
+}
+
+//----------------------------------------------------------------------------------------------------
+void PhaseTimer::AddPhase(char const* phaseName, double const milliseconds)
+{
+    sPhaseTiming phase;
+    phase.name         = phaseName;
+    phase.milliseconds = milliseconds;
+    m_phases.push_back(phase);
+}
+
+//----------------------------------------------------------------------------------------------------
+double PhaseTimer::GetTotalMilliseconds() const
+{
+    return std::chrono::duration<double, std::milli>(m_phaseStart - m_start).count();
+}
+
+//----------------------------------------------------------------------------------------------------
+void PhaseTimer::WriteReport(FILE* file) const
+{
+    for (sPhaseTiming const& phase : m_phases)
+    {
+        fprintf(file, "%s_ms %.3f\n", phase.name.c_str(), phase.milliseconds);
+    }
+    fprintf(file, "total_ms %.3f\n", GetTotalMilliseconds());
+}
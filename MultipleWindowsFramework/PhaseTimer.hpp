@@ -0,0 +1,44 @@
+﻿//----------------------------------------------------------------------------------------------------
+// PhaseTimer.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+struct sPhaseTiming
+{
+    std::string name;
+    double      milliseconds = 0;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 依序量測啟動的各個階段：Mark 結束目前的階段並開始下一個
+class PhaseTimer
+{
+public:
+    PhaseTimer() { Start(); }
+
+    void Start();
+    void Mark(char const* phaseName);
+
+    // 在其他執行緒量到的時間 (例如每個 UI 執行緒建立窗口的時間)，不影響目前的階段
+    void AddPhase(char const* phaseName, double milliseconds);
+
+    std::vector<sPhaseTiming> const& GetPhases() const { return m_phases; }
+    double                           GetTotalMilliseconds() const;
+
+    // 一行一個階段，最後一行為總時間
+    void WriteReport(FILE* file) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point         m_start;
+    Clock::time_point         m_phaseStart;
+    std::vector<sPhaseTiming> m_phases;
+};
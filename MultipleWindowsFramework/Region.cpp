@@ -0,0 +1,222 @@
+﻿//----------------------------------------------------------------------------------------------------
+// Region.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "Region.hpp"
+
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------
+// 空的 (包含左右或上下顛倒的) 矩形不與任何矩形重疊
+bool sRect::Overlaps(sRect const& other) const
+{
+    return !IsEmpty() && !other.IsEmpty() &&
+        left < other.right && other.left < right &&
+        top < other.bottom && other.top < bottom;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool sRect::Contains(sRect const& other) const
+{
+    return other.left >= left && other.right <= right &&
+        other.top >= top && other.bottom <= bottom;
+}
+
+//----------------------------------------------------------------------------------------------------
+sRect sRect::Intersect(sRect const& other) const
+{
+    sRect result;
+    result.left   = (std::max)(left, other.left);
+    result.top    = (std::max)(top, other.top);
+    result.right  = (std::min)(right, other.right);
+    result.bottom = (std::min)(bottom, other.bottom);
+    return result.IsEmpty() ? sRect{} : result;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool sRect::operator==(sRect const& other) const
+{
+    return left == other.left && top == other.top && right == other.right && bottom == other.bottom;
+}
+
+//----------------------------------------------------------------------------------------------------
+int SubtractFromRect(sRect const& rect,
+                     sRect const& cut,
+                     std::vector<sRect>& out)
+{
+    sRect     parts[4];
+    int const count = SubtractFromRect(rect, cut, parts);
+    out.insert(out.end(), parts, parts + count);
+    return count;
+}
+
+//----------------------------------------------------------------------------------------------------
+int SubtractFromRect(sRect const& rect,
+                     sRect const& cut,
+                     sRect        out[4])
+{
+    if (rect.IsEmpty()) return 0;
+    if (!rect.Overlaps(cut))
+    {
+        out[0] = rect;
+        return 1;
+    }
+
+    int count = 0;
+
+    // 上方帶狀區域 (完整寬度)
+    if (cut.top > rect.top)
+    {
+        out[count++] = {rect.left, rect.top, rect.right, cut.top};
+    }
+
+    // 下方帶狀區域 (完整寬度)
+    if (cut.bottom < rect.bottom)
+    {
+        out[count++] = {rect.left, cut.bottom, rect.right, rect.bottom};
+    }
+
+    // 中間帶狀區域的左右兩側
+    int const midTop    = (std::max)(rect.top, cut.top);
+    int const midBottom = (std::min)(rect.bottom, cut.bottom);
+
+    if (cut.left > rect.left)
+    {
+        out[count++] = {rect.left, midTop, cut.left, midBottom};
+    }
+
+    if (cut.right < rect.right)
+    {
+        out[count++] = {cut.right, midTop, rect.right, midBottom};
+    }
+
+    return count;
+}
+
+//----------------------------------------------------------------------------------------------------
+Region::Region(sRect const& rect)
+{
+    if (!rect.IsEmpty())
+    {
+        m_rects.push_back(rect);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+void Region::Clear()
+{
+    m_rects.clear();
+}
+
+//----------------------------------------------------------------------------------------------------
+void Region::Assign(sRect const& rect)
+{
+    m_rects.clear();
+    if (!rect.IsEmpty())
+    {
+        m_rects.push_back(rect);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+void Region::Subtract(sRect const& rect)
+{
+    if (rect.IsEmpty() || m_rects.empty()) return;
+
+    m_scratch.clear();
+    for (sRect const& current : m_rects)
+    {
+        SubtractFromRect(current, rect, m_scratch);
+    }
+    m_rects.swap(m_scratch);
+}
+
+//----------------------------------------------------------------------------------------------------
+void Region::Intersect(sRect const& rect)
+{
+    m_scratch.clear();
+    for (sRect const& current : m_rects)
+    {
+        sRect const clipped = current.Intersect(rect);
+        if (!clipped.IsEmpty())
+        {
+            m_scratch.push_back(clipped);
+        }
+    }
+    m_rects.swap(m_scratch);
+}
+
+//----------------------------------------------------------------------------------------------------
+void Region::Coalesce()
+{
+    // 反覆合併共用整條邊的相鄰矩形，直到無法再合併
+    bool merged = true;
+    while (merged)
+    {
+        merged = false;
+        for (size_t i = 0; i < m_rects.size(); ++i)
+        {
+            for (size_t j = i + 1; j < m_rects.size(); ++j)
+            {
+                sRect&       a = m_rects[i];
+                sRect const& b = m_rects[j];
+
+                bool const sameColumn = a.left == b.left && a.right == b.right;
+                bool const sameRow    = a.top == b.top && a.bottom == b.bottom;
+
+                if (sameColumn && (a.bottom == b.top || b.bottom == a.top))
+                {
+                    a.top    = (std::min)(a.top, b.top);
+                    a.bottom = (std::max)(a.bottom, b.bottom);
+                }
+                else if (sameRow && (a.right == b.left || b.right == a.left))
+                {
+                    a.left  = (std::min)(a.left, b.left);
+                    a.right = (std::max)(a.right, b.right);
+                }
+                else
+                {
+                    continue;
+                }
+
+                m_rects.erase(m_rects.begin() + (std::ptrdiff_t)j);
+                merged = true;
+                --j;
+            }
+        }
+    }
+
+    // 固定輸出順序 (由上到下、由左到右)，讓相同區域的比較結果穩定
+    std::sort(m_rects.begin(), m_rects.end(), [](sRect const& a, sRect const& b)
+    {
+        return a.top != b.top ? a.top < b.top : a.left < b.left;
+    });
+}
+
+//----------------------------------------------------------------------------------------------------
+long long Region::GetArea() const
+{
+    long long area = 0;
+    for (sRect const& rect : m_rects)
+    {
+        area += rect.GetArea();
+    }
+    return area;
+}
+
+//----------------------------------------------------------------------------------------------------
+sRect Region::GetBounds() const
+{
+    if (m_rects.empty()) return {};
+
+    sRect bounds = m_rects.front();
+    for (sRect const& rect : m_rects)
+    {
+        bounds.left   = (std::min)(bounds.left, rect.left);
+        bounds.top    = (std::min)(bounds.top, rect.top);
+        bounds.right  = (std::max)(bounds.right, rect.right);
+        bounds.bottom = (std::max)(bounds.bottom, rect.bottom);
+    }
+    return bounds;
+}
@@ -0,0 +1,62 @@
+﻿//----------------------------------------------------------------------------------------------------
+// Region.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <cstddef>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+// 半開區間矩形 [left, right) x [top, bottom)，不依賴 windows.h
+struct sRect
+{
+    int left   = 0;
+    int top    = 0;
+    int right  = 0;
+    int bottom = 0;
+
+    int       GetWidth() const { return right - left; }
+    int       GetHeight() const { return bottom - top; }
+    long long GetArea() const { return IsEmpty() ? 0 : (long long)GetWidth() * GetHeight(); }
+    bool      IsEmpty() const { return right <= left || bottom <= top; }
+    bool      Overlaps(sRect const& other) const;
+    bool      Contains(sRect const& other) const;
+    sRect     Intersect(sRect const& other) const;
+
+    bool operator==(sRect const& other) const;
+    bool operator!=(sRect const& other) const { return !(*this == other); }
+};
+
+//----------------------------------------------------------------------------------------------------
+// 由互不重疊的矩形組成的區域，用於計算窗口的可見部分
+class Region
+{
+public:
+    Region() = default;
+    explicit Region(sRect const& rect);
+
+    void Clear();
+    void Assign(sRect const& rect);         // 重設為單一矩形，保留已配置的容量
+    void Subtract(sRect const& rect);
+    void Intersect(sRect const& rect);
+    void Coalesce();
+
+    bool                      IsEmpty() const { return m_rects.empty(); }
+    long long                 GetArea() const;
+    sRect                     GetBounds() const;
+    std::vector<sRect> const& GetRects() const { return m_rects; }
+    size_t                    GetMemoryBytes() const { return (m_rects.capacity() + m_scratch.capacity()) * sizeof(sRect); }
+
+    bool operator==(Region const& other) const { return m_rects == other.m_rects; }
+    bool operator!=(Region const& other) const { return !(*this == other); }
+
+private:
+    std::vector<sRect> m_rects;
+    std::vector<sRect> m_scratch;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 將 rect 減去 cut，結果 (最多 4 個互不重疊的矩形) 附加到 out，回傳附加數量
+int SubtractFromRect(sRect const& rect, sRect const& cut, std::vector<sRect>& out);
+int SubtractFromRect(sRect const& rect, sRect const& cut, sRect out[4]);
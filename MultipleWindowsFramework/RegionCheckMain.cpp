@@ -0,0 +1,304 @@
+﻿//----------------------------------------------------------------------------------------------------
+// RegionCheckMain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// 可見區域運算的模糊測試 (不屬於 Windows 專案，在 Linux 上單獨編譯)：
+//
+//   g++ -std=c++14 -O2 RegionCheckMain.cpp Region.cpp -o region_check
+//   ./region_check [iterations]
+//
+// 隨機的 Subtract / Intersect / Coalesce 序列與逐像素的參考點陣比較，每一步都確認覆蓋的像素相同、
+// 矩形互不重疊且不為空；Coalesce 不能增加矩形數量且輸出順序固定
+// 最後量測一個窗口依序檢查 1000 個遮擋者的時間 (與 Renderer::UpdateWindowVisibility 相同，接近 -startupBenchmark 的規模)
+// 結束碼：0 = 全部通過，1 = 失敗
+//----------------------------------------------------------------------------------------------------
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "CheckMain.hpp"
+#include "Region.hpp"
+
+//----------------------------------------------------------------------------------------------------
+// 參考點陣涵蓋 [GRID_MIN, GRID_MAX) 的正方形，隨機矩形都在其中
+static int const GRID_MIN  = -8;
+static int const GRID_MAX  = 72;
+static int const GRID_SIZE = GRID_MAX - GRID_MIN;
+
+//----------------------------------------------------------------------------------------------------
+// 偶爾產生空的或左右顛倒的矩形，Region 必須忽略它們
+static sRect MakeRandomRect(uint32_t& seed)
+{
+    sRect rect;
+    rect.left   = GRID_MIN + (int)(NextRandom(seed) % GRID_SIZE);
+    rect.top    = GRID_MIN + (int)(NextRandom(seed) % GRID_SIZE);
+    rect.right  = (std::min)(GRID_MAX, rect.left + (int)(NextRandom(seed) % 40) - (NextRandom(seed) % 16 == 0 ? 8 : 0));
+    rect.bottom = (std::min)(GRID_MAX, rect.top + (int)(NextRandom(seed) % 40) - (NextRandom(seed) % 16 == 0 ? 8 : 0));
+    return rect;
+}
+
+//----------------------------------------------------------------------------------------------------
+class ReferenceBitmap
+{
+public:
+    ReferenceBitmap() : m_pixels((size_t)GRID_SIZE * GRID_SIZE, 0) {}
+
+    void Assign(sRect const& rect)
+    {
+        std::fill(m_pixels.begin(), m_pixels.end(), (uint8_t)0);
+        Apply(rect, [](uint8_t& pixel) { pixel = 1; });
+    }
+
+    void Subtract(sRect const& rect)
+    {
+        Apply(rect, [](uint8_t& pixel) { pixel = 0; });
+    }
+
+    void Intersect(sRect const& rect)
+    {
+        for (int y = GRID_MIN; y < GRID_MAX; ++y)
+        {
+            for (int x = GRID_MIN; x < GRID_MAX; ++x)
+            {
+                if (!IsInside(rect, x, y)) At(x, y) = 0;
+            }
+        }
+    }
+
+    // region 的矩形必須互不重疊、不為空，且剛好覆蓋點陣中的像素
+    bool Matches(Region const& region) const
+    {
+        std::vector<uint8_t> coverage(m_pixels.size(), 0);
+        for (sRect const& rect : region.GetRects())
+        {
+            if (rect.IsEmpty() || rect.left < GRID_MIN || rect.top < GRID_MIN || rect.right > GRID_MAX || rect.bottom > GRID_MAX)
+            {
+                return false;
+            }
+            for (int y = rect.top; y < rect.bottom; ++y)
+            {
+                for (int x = rect.left; x < rect.right; ++x)
+                {
+                    uint8_t& covered = coverage[Offset(x, y)];
+                    if (covered) return false;
+                    covered = 1;
+                }
+            }
+        }
+        return coverage == m_pixels;
+    }
+
+private:
+    static bool IsInside(sRect const& rect, int const x, int const y)
+    {
+        return x >= rect.left && x < rect.right && y >= rect.top && y < rect.bottom;
+    }
+
+    static size_t Offset(int const x, int const y)
+    {
+        return (size_t)(y - GRID_MIN) * GRID_SIZE + (size_t)(x - GRID_MIN);
+    }
+
+    uint8_t& At(int const x, int const y) { return m_pixels[Offset(x, y)]; }
+
+    template <typename Function>
+    void Apply(sRect const& rect, Function function)
+    {
+        for (int y = (std::max)(rect.top, GRID_MIN); y < (std::min)(rect.bottom, GRID_MAX); ++y)
+        {
+            for (int x = (std::max)(rect.left, GRID_MIN); x < (std::min)(rect.right, GRID_MAX); ++x)
+            {
+                function(At(x, y));
+            }
+        }
+    }
+
+    std::vector<uint8_t> m_pixels;
+};
+
+//----------------------------------------------------------------------------------------------------
+static bool IsSorted(Region const& region)
+{
+    std::vector<sRect> const& rects = region.GetRects();
+    for (size_t i = 1; i < rects.size(); ++i)
+    {
+        sRect const& a = rects[i - 1];
+        sRect const& b = rects[i];
+        if (a.top > b.top || (a.top == b.top && a.left > b.left)) return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+// SubtractFromRect 的兩個多載結果相同，最多 4 個矩形
+static bool CheckSubtractFromRect(unsigned int const iterations)
+{
+    uint32_t seed      = 0x2545F491u;
+    bool     isMatched = true;
+    for (unsigned int i = 0; i < iterations && isMatched; ++i)
+    {
+        sRect const rect = MakeRandomRect(seed);
+        sRect const cut  = MakeRandomRect(seed);
+
+        sRect              parts[4];
+        std::vector<sRect> appended = {sRect{1, 2, 3, 4}};
+        int const          count    = SubtractFromRect(rect, cut, parts);
+        int const          added    = SubtractFromRect(rect, cut, appended);
+
+        ReferenceBitmap reference;
+        reference.Assign(rect);
+        reference.Subtract(cut);
+
+        isMatched &= count >= 0 && count <= 4 && count == added && appended.size() == (size_t)count + 1;
+        for (int part = 0; part < count && isMatched; ++part)
+        {
+            isMatched &= appended[(size_t)part + 1] == parts[part];
+        }
+
+        // 各部分與參考點陣覆蓋相同的像素，且彼此不重疊
+        Region pieces(rect);
+        pieces.Subtract(cut);
+        isMatched &= reference.Matches(pieces) && pieces.GetRects().size() == (size_t)count;
+    }
+    return Check(isMatched, "subtract_from_rect");
+}
+
+//----------------------------------------------------------------------------------------------------
+static bool CheckOperations(unsigned int const iterations)
+{
+    uint32_t     seed         = 0x9E3779B9u;
+    bool         isMatched    = true;
+    bool         isCoalesced  = true;
+    unsigned int coalesces    = 0;
+    unsigned int emptyRegions = 0;
+
+    Region          region;
+    ReferenceBitmap reference;
+    for (unsigned int i = 0; i < iterations && isMatched && isCoalesced; ++i)
+    {
+        sRect const start = MakeRandomRect(seed);
+        region.Assign(start);
+        reference.Assign(start);
+        isMatched &= reference.Matches(region);
+
+        unsigned int const steps = 1 + NextRandom(seed) % 12;
+        for (unsigned int step = 0; step < steps && isMatched && isCoalesced; ++step)
+        {
+            sRect const    rect      = MakeRandomRect(seed);
+            uint32_t const operation = NextRandom(seed) % 8;
+            if (operation < 5)
+            {
+                region.Subtract(rect);
+                reference.Subtract(rect);
+            }
+            else if (operation < 7)
+            {
+                region.Intersect(rect);
+                reference.Intersect(rect);
+            }
+            else
+            {
+                size_t const before = region.GetRects().size();
+                region.Coalesce();
+                isCoalesced &= region.GetRects().size() <= before && IsSorted(region);
+                ++coalesces;
+            }
+
+            isMatched &= reference.Matches(region);
+        }
+
+        // 合併後覆蓋的像素不變，再合併一次沒有作用
+        Region coalesced = region;
+        coalesced.Coalesce();
+        Region again = coalesced;
+        again.Coalesce();
+        isMatched &= reference.Matches(coalesced) && coalesced.GetArea() == region.GetArea();
+        isCoalesced &= again == coalesced;
+        if (region.IsEmpty()) ++emptyRegions;
+    }
+
+    printf("operation_iterations %u\n", iterations);
+    printf("operation_coalesces %u\n", coalesces);
+    printf("operation_empty_regions %u\n", emptyRegions);
+
+    bool isPassing = true;
+    isPassing &= Check(isMatched, "operations_match_reference");
+    isPassing &= Check(isCoalesced, "coalesce_stable");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 固定情況：上方窗口在四個方向各露出一條，合併後仍是 4 個矩形；完全蓋住後為空
+static bool CheckKnownCases()
+{
+    Region region({0, 0, 100, 100});
+    region.Subtract({10, 10, 90, 90});
+    region.Coalesce();
+
+    std::vector<sRect> const frame = {{0, 0, 100, 10}, {0, 10, 10, 90}, {90, 10, 100, 90}, {0, 90, 100, 100}};
+
+    Region covered({0, 0, 100, 100});
+    covered.Subtract({-5, -5, 105, 105});
+
+    Region clipped({-50, -50, 50, 50});
+    clipped.Intersect({0, 0, 1920, 1080});
+
+    bool isPassing = true;
+    isPassing &= Check(region.GetRects() == frame && region.GetArea() == 10000 - 6400, "known_frame");
+    isPassing &= Check(covered.IsEmpty() && covered.GetArea() == 0, "known_covered");
+    isPassing &= Check(clipped.GetRects().size() == 1 && clipped.GetBounds() == sRect{0, 0, 50, 50}, "known_clipped");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+int main(int const argc, char** argv)
+{
+    using Clock = std::chrono::steady_clock;
+
+    unsigned int const iterations = argc > 1 ? (unsigned int)strtoul(argv[1], nullptr, 0) : 100000u;
+
+    bool isPassing = true;
+    isPassing &= CheckKnownCases();
+    isPassing &= CheckSubtractFromRect(iterations);
+    isPassing &= CheckOperations(iterations);
+
+    // 基準：320x240 的窗口依序檢查 1000 個散布在 1920x1080 螢幕上的 160x120 遮擋者 (十分之一在它上方)，只扣除重疊的
+    sRect const        window = {800, 420, 1120, 660};
+    uint32_t           seed   = 12345;
+    std::vector<sRect> occluders;
+    for (int i = 0; i < 1000; ++i)
+    {
+        int const x = (int)(NextRandom(seed) % 1760);
+        int const y = (int)(NextRandom(seed) % 960);
+        occluders.push_back({x, y, x + 160, y + 120});
+    }
+
+    Region    region;
+    int const repeats     = 1000;
+    size_t    rects       = 0;
+    size_t    overlapping = 0;
+
+    Clock::time_point const start = Clock::now();
+    for (int repeat = 0; repeat < repeats; ++repeat)
+    {
+        region.Assign(window);
+        for (size_t i = 0; i < occluders.size() / 10 && !region.IsEmpty(); ++i)
+        {
+            if (!occluders[i].Overlaps(window)) continue;
+            region.Subtract(occluders[i]);
+            ++overlapping;
+        }
+        region.Coalesce();
+        rects += region.GetRects().size();
+    }
+    Clock::time_point const end = Clock::now();
+
+    printf("benchmark_occluders_above %zu\n", occluders.size() / 10);
+    printf("benchmark_overlapping %zu\n", overlapping / repeats);
+    printf("benchmark_rects %zu\n", rects / repeats);
+    printf("benchmark_us_per_window %.3f\n", std::chrono::duration<double, std::micro>(end - start).count() / repeats);
+    return isPassing ? 0 : 1;
+}
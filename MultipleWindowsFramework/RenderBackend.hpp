@@ -0,0 +1,66 @@
+﻿//----------------------------------------------------------------------------------------------------
+// RenderBackend.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <cstdint>
+
+#include "Region.hpp"
+
+//-Forward-Declaration--------------------------------------------------------------------------------
+class SpriteBatcher;
+
+//----------------------------------------------------------------------------------------------------
+unsigned int const INVALID_SCENE_TEXTURE_ID = 0xFFFFFFFF;
+unsigned int const INVALID_SCENE_LAYER_ID   = 0xFFFFFFFF;
+
+//----------------------------------------------------------------------------------------------------
+// 場景在 CPU 端的目的緩衝區 (RGBA8)
+struct sSceneTarget
+{
+    uint8_t*     pixels = nullptr;
+    unsigned int width  = 0;
+    unsigned int height = 0;
+    unsigned int pitch  = 0;                // 每列位元組數
+};
+
+//----------------------------------------------------------------------------------------------------
+// 場景渲染階段的共用介面：D3D11 (Renderer) 與純 CPU (SoftwareRenderBackend) 各自實作
+// 一幀的順序為 BeginScene -> Draw* -> EndScene，EndScene 返回後 target 內即為完成的場景
+// 圖層 (見 LayerCompositor) 是與場景同尺寸的快取目標：在 BeginScene 之後以 BeginLayer -> Draw* -> EndLayer 重繪，
+// 再以 CompositeLayer 疊到場景上；內容以 premultiplied alpha 保存，場景尺寸改變後需要重繪
+class RenderBackend
+{
+public:
+    virtual ~RenderBackend() = default;
+
+    // 像素為 RGBA8 緊密排列，回傳之後繪製時使用的紋理編號；失敗時回傳 INVALID_SCENE_TEXTURE_ID
+    virtual unsigned int CreateSceneTexture(uint32_t const* pixels, unsigned int width, unsigned int height) = 0;
+
+    // 內容會逐幀局部更新的紋理：只有一層 (不產生 mip)，初始為透明黑
+    virtual unsigned int CreateDynamicSceneTexture(unsigned int width, unsigned int height) = 0;
+
+    // pixels 為整張紋理大小 (每列 pitch 個像素)，只讀取並上傳 rect 內的部分
+    virtual void UpdateSceneTexture(unsigned int textureId, sRect const& rect, uint32_t const* pixels, unsigned int pitch) = 0;
+
+    // clearColor 為 nullptr 時不清除 (接下來會被不透明的內容整個覆蓋)
+    virtual void BeginScene(sSceneTarget const& target, float const clearColor[4]) = 0;
+    virtual void DrawFullscreenTexture(unsigned int textureId) = 0;
+    virtual void DrawSprites(SpriteBatcher const& batcher) = 0;
+    virtual bool EndScene() = 0;
+
+    // 多個場景共用一個後端時的延後回讀：QueueEndScene 只送出複製 (下一個 BeginScene 可以立即開始)，
+    // FlushSceneReadbacks 一次等待所有送出的場景並寫入各自的 target；失敗時所有送出的場景都視為沒有完成
+    // 直接寫入 target 的後端 (CPU 渲染) 不需要延後
+    virtual bool QueueEndScene() { return EndScene(); }
+    virtual bool FlushSceneReadbacks() { return true; }
+
+    // 失敗時回傳 INVALID_SCENE_LAYER_ID；實際的緩衝區在第一次 BeginLayer 時依場景尺寸配置
+    virtual unsigned int CreateLayer() = 0;
+    virtual void         BeginLayer(unsigned int layerId, float const clearColor[4]) = 0;
+    virtual void         EndLayer() = 0;
+
+    // isOpaque 為 true 時直接取代場景內容，否則以 premultiplied alpha 疊加
+    virtual void CompositeLayer(unsigned int layerId, bool isOpaque) = 0;
+};
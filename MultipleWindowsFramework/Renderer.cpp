@@ -8,9 +8,16 @@
 #include <d3d11.h>
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
+#include <dwmapi.h>
 #include <vector>
 #include <wincodec.h>
 
+#include "BuiltInShaders.hpp"
+#include "ImageDecoder.hpp"
+#include "MipChain.hpp"
+#include "SoftwareRenderBackend.hpp"
+#include "TextureGenerator.hpp"
+#include "WicTileSource.hpp"
 #include "Window.hpp"
 
 
@@ -18,6 +25,7 @@
 #pragma comment(lib, "dxgi.lib")
 #pragma comment(lib, "d3dcompiler.lib")
 #pragma comment(lib, "windowscodecs.lib")
+#pragma comment(lib, "dwmapi.lib")
 
 using namespace DirectX;
 
@@ -28,21 +36,292 @@ struct Vertex
     XMFLOAT2 m_texCoord;
 };
 
+//----------------------------------------------------------------------------------------------------
+struct SpriteCorner
+{
+    XMFLOAT2 m_corner;
+};
+
+//----------------------------------------------------------------------------------------------------
+struct SpriteConstants
+{
+    XMFLOAT2 m_sceneSize;
+    XMFLOAT2 m_padding;
+};
+
+//----------------------------------------------------------------------------------------------------
+struct TileChecksumConstants
+{
+    UINT m_sceneWidth;
+    UINT m_sceneHeight;
+    UINT m_padding[2];
+};
+
+//----------------------------------------------------------------------------------------------------
+// 相對於執行檔所在的目錄 (Run/，見 GetExecutableRelativePath)
+static char const* const SHADER_PACK_PATH       = "Data/Shaders/Shaders.pack";
+static char const* const SHADER_CACHE_DIRECTORY = "Data/ShaderCache";
+
+// 動態解析度的預設預算，只計場景的繪製與回讀 (窗口呈現與訊息處理不隨場景解析度改變)：
+// 60Hz 一幀 (16.7 毫秒) 的一半，其餘留給 UpdateWindows 的 StretchDIBits 與主循環
+static float const DEFAULT_SCENE_BUDGET_MS = 8.f;
+
+// 背景區塊尚未載入時的顏色，與場景清除色相同 (RGBA8)
+static uint32_t const BACKGROUND_FALLBACK_COLOR = 0xFF331A1A;
+
+// 記憶體報告走訪所有窗口的可見區域並對每個紋理呼叫 GetDesc，窗口多時不能每幀做；指標每秒更新一次就夠了
+static uint64_t const MEMORY_REPORT_INTERVAL_NANOSECONDS = 1000000000ull;
+
+//----------------------------------------------------------------------------------------------------
+static sRect ToRegionRect(RECT const& rect)
+{
+    return {static_cast<int>(rect.left), static_cast<int>(rect.top),
+            static_cast<int>(rect.right), static_cast<int>(rect.bottom)};
+}
+
+//----------------------------------------------------------------------------------------------------
+// 窗口實際畫出的範圍：GetWindowRect 含有 DWM 不可見的調整大小邊框 (Windows 10/11 約 7 像素)
+static sRect GetOccluderRect(HWND const hwnd)
+{
+    RECT rect;
+    if (FAILED(DwmGetWindowAttribute(hwnd, DWMWA_EXTENDED_FRAME_BOUNDS, &rect, sizeof(rect))))
+    {
+        GetWindowRect(hwnd, &rect);
+    }
+    return ToRegionRect(rect);
+}
+
+//----------------------------------------------------------------------------------------------------
+// 其他虛擬桌面上的窗口與隱藏中的 UWP 窗口仍通過 IsWindowVisible，但不會擋住任何東西
+static bool IsWindowCloaked(HWND const hwnd)
+{
+    DWORD cloaked = 0;
+    return SUCCEEDED(DwmGetWindowAttribute(hwnd, DWMWA_CLOAKED, &cloaked, sizeof(cloaked))) && cloaked != 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+static sRect OffsetRegionRect(sRect const& rect, int const dx, int const dy)
+{
+    return {rect.left + dx, rect.top + dy, rect.right + dx, rect.bottom + dy};
+}
+
+//----------------------------------------------------------------------------------------------------
+static uint64_t ElapsedNanoseconds(LARGE_INTEGER const& start, LARGE_INTEGER const& end, LARGE_INTEGER const& frequency)
+{
+    return (uint64_t)((double)(end.QuadPart - start.QuadPart) * 1e9 / (double)frequency.QuadPart);
+}
+
+//----------------------------------------------------------------------------------------------------
+// 命令送出的時間：只用來相減，從開機算起的奈秒以 double 換算仍遠小於一微秒的誤差
+static long long GetCommandTimeNanoseconds(LARGE_INTEGER const& frequency)
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (long long)((double)now.QuadPart * 1e9 / (double)frequency.QuadPart);
+}
+
+//----------------------------------------------------------------------------------------------------
+// 以每像素 4 位元組估算 (本專案只建立 R8G8B8A8 紋理)，包含所有 mip
+static size_t GetTextureBytes(ID3D11Texture2D* const texture)
+{
+    if (!texture) return 0;
+
+    D3D11_TEXTURE2D_DESC desc;
+    texture->GetDesc(&desc);
+
+    size_t bytes  = 0;
+    UINT   width  = desc.Width;
+    UINT   height = desc.Height;
+    for (UINT level = 0; level < max(1u, desc.MipLevels); ++level)
+    {
+        bytes  += (size_t)width * height * 4;
+        width   = max(1u, width / 2);
+        height  = max(1u, height / 2);
+    }
+    return bytes * desc.ArraySize;
+}
+
+//----------------------------------------------------------------------------------------------------
+static size_t GetTextureBytes(ID3D11ShaderResourceView* const shaderResourceView)
+{
+    if (!shaderResourceView) return 0;
+
+    ID3D11Resource* resource = nullptr;
+    shaderResourceView->GetResource(&resource);
+    if (!resource) return 0;
+
+    ID3D11Texture2D* texture = nullptr;
+    resource->QueryInterface(__uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&texture));
+    resource->Release();
+
+    size_t const bytes = GetTextureBytes(texture);
+    if (texture) texture->Release();
+    return bytes;
+}
+
+//----------------------------------------------------------------------------------------------------
+static bool CompileShaderWithD3D(sShaderSource const& source, std::vector<uint8_t>& bytecode, std::string& errors)
+{
+    ID3DBlob* blob      = nullptr;
+    ID3DBlob* errorBlob = nullptr;
+
+    HRESULT const hr = D3DCompile(source.source.data(), source.source.size(), source.name.c_str(), nullptr, nullptr,
+                                  source.entryPoint.c_str(), source.target.c_str(), source.flags, 0, &blob, &errorBlob);
+    if (errorBlob)
+    {
+        errors.assign(static_cast<char const*>(errorBlob->GetBufferPointer()), errorBlob->GetBufferSize());
+        errorBlob->Release();
+    }
+    if (FAILED(hr))
+    {
+        if (blob) blob->Release();
+        return false;
+    }
+
+    uint8_t const* data = static_cast<uint8_t const*>(blob->GetBufferPointer());
+    bytecode.assign(data, data + blob->GetBufferSize());
+    blob->Release();
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 逐層建立目錄，已存在的目錄忽略
+static void CreateDirectoryPath(std::string const& path)
+{
+    for (size_t i = 1; i <= path.size(); ++i)
+    {
+        if (i == path.size() || path[i] == '/' || path[i] == '\\')
+        {
+            CreateDirectoryA(path.substr(0, i).c_str(), nullptr);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+// 執行檔所在目錄下的路徑：Visual Studio 的偵錯工具以專案目錄為工作目錄，建置時寫到 $(OutDir) 的 pack 不能依賴工作目錄。
+// 之後的檔案操作都用 ANSI 版本 (fopen_s、CreateDirectoryA)，所以轉成目前的字碼頁；取不到時退回相對路徑
+static std::string GetExecutableRelativePath(char const* relativePath)
+{
+    wchar_t     modulePath[MAX_PATH];
+    DWORD const length = GetModuleFileNameW(nullptr, modulePath, MAX_PATH);
+    if (length == 0 || length >= MAX_PATH) return relativePath;
+
+    std::wstring const executablePath(modulePath, length);
+    std::wstring const directory = executablePath.substr(0, executablePath.find_last_of(L"\\/") + 1);
+
+    int const size = WideCharToMultiByte(CP_ACP, 0, directory.c_str(), (int)directory.size(), nullptr, 0, nullptr, nullptr);
+    if (size <= 0) return relativePath;
+
+    std::string path((size_t)size, '\0');
+    WideCharToMultiByte(CP_ACP, 0, directory.c_str(), (int)directory.size(), &path[0], size, nullptr, nullptr);
+    return path + relativePath;
+}
+
+//----------------------------------------------------------------------------------------------------
+static DXGI_FORMAT ToDxgiFormat(eShaderInputFormat const format)
+{
+    switch (format)
+    {
+    case eShaderInputFormat::R32_FLOAT:          return DXGI_FORMAT_R32_FLOAT;
+    case eShaderInputFormat::R32G32_FLOAT:       return DXGI_FORMAT_R32G32_FLOAT;
+    case eShaderInputFormat::R32G32B32_FLOAT:    return DXGI_FORMAT_R32G32B32_FLOAT;
+    case eShaderInputFormat::R32G32B32A32_FLOAT: return DXGI_FORMAT_R32G32B32A32_FLOAT;
+    case eShaderInputFormat::R8G8B8A8_UNORM:     return DXGI_FORMAT_R8G8B8A8_UNORM;
+    }
+    return DXGI_FORMAT_UNKNOWN;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 檔頭是內建解碼器支援的格式 (QOI) 時整個讀入，直接解碼成上傳格式 (RGBA8)；不是時回傳 S_FALSE 交給 WIC
+static HRESULT LoadBuiltInImage(wchar_t const* filename, BufferPool& bufferPool, BufferPool::Buffer& pixels, UINT& width, UINT& height)
+{
+    HANDLE const file = CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return S_FALSE;
+
+    LARGE_INTEGER fileSize{};
+    uint8_t       magic[4]  = {};
+    DWORD         bytesRead = 0;
+
+    bool const isBuiltIn = GetFileSizeEx(file, &fileSize) && fileSize.QuadPart <= MAXDWORD &&
+                           ReadFile(file, magic, sizeof(magic), &bytesRead, nullptr) &&
+                           DetectImageFormat(magic, bytesRead) != eImageFormat::Unknown;
+    if (!isBuiltIn)
+    {
+        CloseHandle(file);
+        return S_FALSE;
+    }
+
+    size_t const       dataSize  = (size_t)fileSize.QuadPart;
+    DWORD const        restBytes = (DWORD)(dataSize - sizeof(magic));
+    BufferPool::Buffer data      = bufferPool.Acquire(dataSize);
+    memcpy(data.GetData(), magic, sizeof(magic));
+
+    bool const isRead = ReadFile(file, data.GetData() + sizeof(magic), restBytes, &bytesRead, nullptr) && bytesRead == restBytes;
+    CloseHandle(file);
+    if (!isRead) return E_FAIL;
+
+    sImageInfo info;
+    if (!ReadQoiInfo(data.GetData(), dataSize, info)) return WINCODEC_ERR_BADHEADER;
+
+    pixels = bufferPool.Acquire((size_t)info.width * info.height * 4);
+    if (!DecodeQoi(data.GetData(), dataSize, pixels.As<uint32_t>()))
+    {
+        pixels = BufferPool::Buffer();
+        return WINCODEC_ERR_BADIMAGE;
+    }
+
+    width  = info.width;
+    height = info.height;
+    return S_OK;
+}
+
 //----------------------------------------------------------------------------------------------------
 Renderer::Renderer()
 {
     virtualScreenWidth  = GetSystemMetrics(SM_CXSCREEN);
     virtualScreenHeight = GetSystemMetrics(SM_CYSCREEN);
 
-    ZeroMemory(&bitmapInfo, sizeof(BITMAPINFO));
-    bitmapInfo.bmiHeader.biSize        = sizeof(BITMAPINFOHEADER);
-    bitmapInfo.bmiHeader.biWidth       = sceneWidth;
-    bitmapInfo.bmiHeader.biHeight      = -static_cast<LONG>(sceneHeight);
-    bitmapInfo.bmiHeader.biPlanes      = 1;
-    bitmapInfo.bmiHeader.biBitCount    = 32;
-    bitmapInfo.bmiHeader.biCompression = BI_RGB;
-
+    ZeroMemory(&bitmapInfo, sizeof(bitmapInfo));
+    bitmapInfo.header.biSize        = sizeof(BITMAPINFOHEADER);
+    bitmapInfo.header.biWidth       = sceneWidth;
+    bitmapInfo.header.biHeight      = -static_cast<LONG>(sceneHeight);
+    bitmapInfo.header.biPlanes      = 1;
+    bitmapInfo.header.biBitCount    = 32;
+    bitmapInfo.header.biCompression = BI_BITFIELDS;
+    bitmapInfo.masks[0]             = 0x000000FF;
+    bitmapInfo.masks[1]             = 0x0000FF00;
+    bitmapInfo.masks[2]             = 0x00FF0000;
+
+    // 預先配置最大解析度的容量，切換解析度時不需要重新配置
+    pixelData.reserve(maxSceneWidth * maxSceneHeight * 4);
     pixelData.resize(sceneWidth * sceneHeight * 4);
+
+    QueryPerformanceFrequency(&m_performanceFrequency);
+
+    sResolutionControllerConfig resolutionConfig;
+    resolutionConfig.targetFrameMs = DEFAULT_SCENE_BUDGET_MS;
+    m_resolutionController         = ResolutionController(resolutionConfig);
+
+    // 每幀最多繪製一個螢幕大小的像素量
+    sUpdateSchedulerConfig schedulerConfig;
+    schedulerConfig.pixelBudgetPerFrame = (long long)virtualScreenWidth * virtualScreenHeight;
+    m_updateScheduler.SetConfig(schedulerConfig);
+
+    m_shaderCache = ShaderCache(GetExecutableRelativePath(SHADER_CACHE_DIRECTORY), &CompileShaderWithD3D);
+    RegisterBuiltInShaders(m_shaderRegistry);
+    RegisterMetrics();
+
+    // 背景只在紋理內容改變時重繪；精靈每幀重新提交，不值得快取
+    sLayerDesc backgroundLayer;
+    backgroundLayer.order    = 0;
+    backgroundLayer.update   = eLayerUpdate::Static;
+    backgroundLayer.isOpaque = true;
+    m_backgroundLayer        = m_layerCompositor.AddLayer(backgroundLayer);
+
+    sLayerDesc spriteLayer;
+    spriteLayer.order  = 100;
+    spriteLayer.update = eLayerUpdate::Dynamic;
+    m_spriteLayer      = m_layerCompositor.AddLayer(spriteLayer);
 }
 
 Renderer::~Renderer()
@@ -50,7 +329,42 @@ Renderer::~Renderer()
     Cleanup();
 }
 
-HRESULT Renderer::Initialize(HWND const& hiddenMainWindow)
+void Renderer::RegisterMetrics()
+{
+    double const nanosecondsToSeconds = 1e-9;
+
+    sRendererMetrics& metrics = m_rendererMetrics;
+    metrics.frames             = &m_metrics.AddCounter("mwf_frames_total", "Frames rendered.");
+    metrics.framesDropped      = &m_metrics.AddCounter("mwf_frames_dropped_total", "Frames whose scene could not be read back and were not shown.");
+    metrics.compositionsReused = &m_metrics.AddCounter("mwf_scene_compositions_reused_total", "Frames that reused the previous scene because no layer changed.");
+    metrics.readbackBytes      = &m_metrics.AddCounter("mwf_readback_bytes_total", "Bytes copied from the GPU scene to the CPU mirror.");
+    metrics.readbackTiles      = &m_metrics.AddCounter("mwf_readback_tiles_total", "Scene tiles copied from the GPU because their checksum changed under a window.");
+    metrics.skippedTiles       = &m_metrics.AddCounter("mwf_readback_tiles_skipped_total", "Scene tiles not copied because they were unchanged or not under any window.");
+    metrics.windowBlits        = &m_metrics.AddCounter("mwf_window_blits_total", "Window viewport updates.");
+    metrics.windowBlitPixels   = &m_metrics.AddCounter("mwf_window_blit_pixels_total", "Visible pixels written to windows.");
+    metrics.windowMoves        = &m_metrics.AddCounter("mwf_window_moves_total", "Window moves committed to the system.");
+    metrics.dragMovesCoalesced = &m_metrics.AddCounter("mwf_drag_moves_coalesced_total", "Drag moves replaced by a later move of the same window in the same frame.");
+    metrics.hitches            = &m_metrics.AddCounter("mwf_hitches_total", "Frames whose message pump and render time exceeded the flight recorder threshold.");
+    metrics.frameTime          = &m_metrics.AddHistogram("mwf_frame_seconds", "Render time per frame.", nanosecondsToSeconds);
+    metrics.updateWindowsTime  = &m_metrics.AddHistogram("mwf_update_windows_seconds", "Time spent distributing the scene to windows per frame.", nanosecondsToSeconds);
+    metrics.windowBlitTime     = &m_metrics.AddHistogram("mwf_window_blit_seconds", "Latency of a single window viewport update.", nanosecondsToSeconds);
+    metrics.windows            = &m_metrics.AddGauge("mwf_windows", "Windows managed by the renderer.");
+    metrics.sceneWidth         = &m_metrics.AddGauge("mwf_scene_width_pixels", "Current scene resolution width.");
+    metrics.sceneHeight        = &m_metrics.AddGauge("mwf_scene_height_pixels", "Current scene resolution height.");
+
+    for (size_t i = 0; i < (size_t)eMemoryCategory::Count; ++i)
+    {
+        std::string const name = std::string("mwf_memory_") + GetMemoryCategoryName((eMemoryCategory)i) + "_bytes";
+        metrics.memoryBytes[i] = &m_metrics.AddGauge(name.c_str(), "Bytes held by the renderer in this category (see GetMemoryReport).");
+    }
+}
+
+bool Renderer::StartMetricsEndpoint(uint16_t const port)
+{
+    return m_metricsServer.Start(m_metrics, port);
+}
+
+HRESULT Renderer::Initialize(HWND const& hiddenMainWindow, bool useSoftwareRenderer)
 {
     mainWindow = hiddenMainWindow;
 
@@ -68,16 +382,49 @@ HRESULT Renderer::Initialize(HWND const& hiddenMainWindow)
         m_wicFactory = nullptr;
     }
 
-    hr = CreateDeviceAndSwapChain();
+    if (!useSoftwareRenderer)
+    {
+        hr = CreateDeviceResources();
+        if (FAILED(hr))
+        {
+            // 沒有可用的 D3D11 裝置 (遠端桌面、CI、驅動問題)，退回軟體渲染
+            ReleaseDeviceResources();
+            useSoftwareRenderer = true;
+        }
+    }
+
+    if (useSoftwareRenderer)
+    {
+        m_softwareBackend = std::make_unique<SoftwareRenderBackend>(m_threadPool);
+    }
+    m_sceneGroup = std::make_unique<SceneGroup>(GetSceneBackend(), m_threadPool);
+
+    // 需要快取的圖層在後端建立對應的目標
+    m_backendLayers.assign(m_layerCompositor.GetLayerCount(), INVALID_SCENE_LAYER_ID);
+    for (unsigned int layerId = 0; layerId < m_backendLayers.size(); ++layerId)
+    {
+        if (m_layerCompositor.GetLayerDesc(layerId).update == eLayerUpdate::Dynamic) continue;
+
+        m_backendLayers[layerId] = GetSceneBackend().CreateLayer();
+        if (m_backendLayers[layerId] == INVALID_SCENE_LAYER_ID) return E_FAIL;
+    }
+    m_layerCompositor.InvalidateAll();
+
+    hr = CreateTestTexture(L"C:/Github/MultipleWindowsFramework/Run/Data/Images/Windowkill.png");
     if (FAILED(hr)) return hr;
 
-    hr = CreateSceneRenderTexture();
+    return S_OK;
+}
+
+HRESULT Renderer::CreateDeviceResources()
+{
+    HRESULT hr = CreateDeviceAndSwapChain();
     if (FAILED(hr)) return hr;
 
-    hr = CreateStagingTexture();
+    hr = CreateSceneRenderTexture();
     if (FAILED(hr)) return hr;
 
-    hr = CreateTestTexture(L"C:/Github/MultipleWindowsFramework/Run/Data/Images/Windowkill.png");
+    hr = CreateStagingTexture();
     if (FAILED(hr)) return hr;
 
     hr = CreateShaders();
@@ -89,18 +436,33 @@ HRESULT Renderer::Initialize(HWND const& hiddenMainWindow)
     hr = CreateSampler();
     if (FAILED(hr)) return hr;
 
+    hr = CreateSpriteResources();
+    if (FAILED(hr)) return hr;
+
+    hr = CreateTileChecksumResources();
+    if (FAILED(hr)) return hr;
+
     return S_OK;
 }
 
-HRESULT Renderer::LoadImageFromFile(const wchar_t* filename, ID3D11Texture2D** texture, ID3D11ShaderResourceView** srv) const
+RenderBackend& Renderer::GetSceneBackend()
 {
+    if (m_softwareBackend) return *m_softwareBackend;
+    return *this;
+}
+
+HRESULT Renderer::LoadImageFromFile(const wchar_t* filename, BufferPool::Buffer& pixels, UINT& width, UINT& height)
+{
+    HRESULT hr = LoadBuiltInImage(filename, m_frameMemory.GetBufferPool(), pixels, width, height);
+    if (hr != S_FALSE) return hr;
+
     if (!m_wicFactory) return E_FAIL;
 
     IWICBitmapDecoder*     decoder   = nullptr;
     IWICBitmapFrameDecode* frame     = nullptr;
     IWICFormatConverter*   converter = nullptr;
 
-    HRESULT hr = m_wicFactory->CreateDecoderFromFilename(
+    hr = m_wicFactory->CreateDecoderFromFilename(
         filename, nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand, &decoder);
     if (FAILED(hr)) return hr;
 
@@ -119,7 +481,8 @@ HRESULT Renderer::LoadImageFromFile(const wchar_t* filename, ID3D11Texture2D** t
         return hr;
     }
 
-    hr = converter->Initialize(frame, GUID_WICPixelFormat32bppBGRA,
+    // 直接轉成 R8G8B8A8 紋理的通道順序
+    hr = converter->Initialize(frame, GUID_WICPixelFormat32bppRGBA,
                                WICBitmapDitherTypeNone, nullptr, 0.0,
                                WICBitmapPaletteTypeCustom);
     if (FAILED(hr))
@@ -130,36 +493,11 @@ HRESULT Renderer::LoadImageFromFile(const wchar_t* filename, ID3D11Texture2D** t
         return hr;
     }
 
-    UINT width, height;
     converter->GetSize(&width, &height);
 
-    // 創建像素數據緩衝區
-    std::vector<BYTE> pixels(width * height * 4);
-    hr = converter->CopyPixels(nullptr, width * 4, pixels.size(), pixels.data());
-
-    if (SUCCEEDED(hr))
-    {
-        // 創建 D3D11 紋理
-        D3D11_TEXTURE2D_DESC texDesc = {};
-        texDesc.Width                = width;
-        texDesc.Height               = height;
-        texDesc.MipLevels            = 1;
-        texDesc.ArraySize            = 1;
-        texDesc.Format               = DXGI_FORMAT_R8G8B8A8_UNORM;
-        texDesc.SampleDesc.Count     = 1;
-        texDesc.Usage                = D3D11_USAGE_DEFAULT;
-        texDesc.BindFlags            = D3D11_BIND_SHADER_RESOURCE;
-
-        D3D11_SUBRESOURCE_DATA initData = {};
-        initData.pSysMem                = pixels.data();
-        initData.SysMemPitch            = width * 4;
-
-        hr = m_device->CreateTexture2D(&texDesc, &initData, texture);
-        if (SUCCEEDED(hr))
-        {
-            hr = m_device->CreateShaderResourceView(*texture, nullptr, srv);
-        }
-    }
+    // 創建像素數據緩衝區 (紋理由目前的場景後端建立，D3D11 與軟體渲染共用)
+    pixels = m_frameMemory.GetBufferPool().Acquire((size_t)width * height * 4);
+    hr     = converter->CopyPixels(nullptr, width * 4, width * height * 4, pixels.GetData());
 
     converter->Release();
     frame->Release();
@@ -169,244 +507,654 @@ HRESULT Renderer::LoadImageFromFile(const wchar_t* filename, ID3D11Texture2D** t
 
 void Renderer::SetWindowDriftParams(HWND const hwnd, const sDriftParams& params)
 {
-    for (Window& window : m_windowList)
+    int const index = FindWindowIndex(hwnd);
+    if (index < 0) return;
+
+    m_windowList[index].body.drift = params;
+
+    if (m_inputLog.IsOpen())
     {
-        if ((HWND)window.m_windowHandle == hwnd)
-        {
-            window.drift = params;
-            break;
-        }
+        sInputEvent event;
+        event.type     = eInputEventType::SetDriftParams;
+        event.windowId = (uint32_t)index;
+        event.params   = params;
+        m_inputLog.Write(event);
     }
 }
 
 void Renderer::StartDragging(HWND const hwnd, POINT const& mousePos)
 {
-    for (Window& window : m_windowList)
+    int const index = FindWindowIndex(hwnd);
+    if (index < 0) return;
+
+    Window& window = m_windowList[index];
+    if (!m_isDeterministic)
     {
-        if ((HWND)window.m_windowHandle == hwnd)
-        {
-            window.isDragging = true;
-            RECT rect;
-            GetWindowRect(hwnd, &rect);
-            window.dragOffset.x = mousePos.x - rect.left;
-            window.dragOffset.y = mousePos.y - rect.top;
-            // 拖拽時停止漂移
-            window.drift.velocityX = 0;
-            window.drift.velocityY = 0;
-            break;
-        }
+        RECT rect;
+        GetWindowRect(hwnd, &rect);
+        PlaceDriftBody(window.body, rect.left, rect.top);
+        window.x = rect.left;
+        window.y = rect.top;
     }
-}
+    BeginDrag(window.body, window.drag, mousePos.x, mousePos.y);
 
-void Renderer::StopDragging(HWND hwnd)
-{
-    for (Window& window : m_windowList)
+    if (m_inputLog.IsOpen())
     {
-        if ((HWND)window.m_windowHandle == hwnd)
-        {
-            window.isDragging = false;
-            // 可以在這裡給一個初始速度來模擬拋擲效果
-            std::uniform_real_distribution<float> throwDist(-100.0f, 100.0f);
-            window.drift.velocityX = throwDist(window.rng);
-            window.drift.velocityY = throwDist(window.rng);
-            break;
-        }
+        sInputEvent event;
+        event.type     = eInputEventType::StartDrag;
+        event.windowId = (uint32_t)index;
+        event.x        = mousePos.x;
+        event.y        = mousePos.y;
+        m_inputLog.Write(event);
     }
 }
 
-void Renderer::UpdateDragging(HWND const hwnd, POINT const& mousePos) const
+void Renderer::StopDragging(HWND const hwnd, float const velocityX, float const velocityY)
 {
-    /// https://learn.microsoft.com/en-us/windows/win32/api/winuser/nf-winuser-setwindowpos
-    for (Window const& window : m_windowList)
+    int const index = FindWindowIndex(hwnd);
+    if (index < 0) return;
+
+    EndDrag(m_windowList[index].body, velocityX, velocityY);
+
+    if (m_inputLog.IsOpen())
     {
-        if ((HWND)window.m_windowHandle == hwnd && window.isDragging)
-        {
-            int newX = mousePos.x - window.dragOffset.x;
-            int newY = mousePos.y - window.dragOffset.y;
-            SetWindowPos(hwnd, nullptr, newX, newY, 0, 0,
-                         SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE);
-            break;
-        }
+        sInputEvent event;
+        event.type      = eInputEventType::StopDrag;
+        event.windowId  = (uint32_t)index;
+        event.velocityX = velocityX;
+        event.velocityY = velocityY;
+        m_inputLog.Write(event);
     }
 }
 
-void Renderer::UpdateWindowDrift(Window& window) const
+void Renderer::UpdateDragging(HWND const hwnd, POINT const& mousePos)
 {
-    if (window.isDragging) return; // 拖拽時不漂移
-
-    auto  currentTime     = std::chrono::steady_clock::now();
-    float deltaTime       = std::chrono::duration<float>(currentTime - window.lastUpdateTime).count();
-    window.lastUpdateTime = currentTime;
-
-    // if (deltaTime > 0.1f) deltaTime = 0.1f; // 限制最大 delta time
-    // 更嚴格的 delta time 控制
-    if (deltaTime > 0.016f) deltaTime = 0.016f; // 限制為 60fps
-    if (deltaTime < 0.001f) return; // 太小的變化直接忽略
+    int const index = FindWindowIndex(hwnd);
+    if (index < 0 || !m_windowList[index].body.isDragging) return;
 
-    RECT windowRect;
-    GetWindowRect((HWND)window.m_windowHandle, &windowRect);
+    // 拖拽時沒有上一步可內插，直接跟著滑鼠；窗口與漂移中的窗口一起在 CommitWindowMoves 移動
+    Window& window = m_windowList[index];
+    DragTo(window.body, window.drag, mousePos.x, mousePos.y);
 
-    int currentX = windowRect.left;
-    int currentY = windowRect.top;
-
-    // 重力效果
-    if (window.drift.enableGravity)
+    if (m_inputLog.IsOpen())
     {
-        window.drift.velocityY += window.drift.acceleration * deltaTime;
+        sInputEvent event;
+        event.type     = eInputEventType::UpdateDrag;
+        event.windowId = (uint32_t)index;
+        event.x        = mousePos.x;
+        event.y        = mousePos.y;
+        m_inputLog.Write(event);
     }
+}
 
-    // 隨機漂移
-    if (window.drift.enableWander)
-    {
-        window.drift.velocityX += window.wanderDist(window.rng) * window.drift.wanderStrength * deltaTime;
-        window.drift.velocityY += window.wanderDist(window.rng) * window.drift.wanderStrength * deltaTime;
-    }
+void Renderer::SyncWindowDrift(Window& window) const
+{
+    sDriftBody& body = window.body;
+    HWND const  hwnd = (HWND)window.m_windowHandle;
 
-    // 速度限制
-    float const currentSpeed = sqrt(window.drift.velocityX * window.drift.velocityX +
-        window.drift.velocityY * window.drift.velocityY);
-    if (currentSpeed > window.drift.targetVelocity)
+    // 決定性模式：位置完全由模擬決定
+    if (!m_isDeterministic)
     {
-        float const scale = window.drift.targetVelocity / currentSpeed;
-        window.drift.velocityX *= scale;
-        window.drift.velocityY *= scale;
-    }
-
-    // 阻力
-    window.drift.velocityX *= window.drift.drag;
-    window.drift.velocityY *= window.drift.drag;
-
-    // 計算新位置
-    int newX = currentX + static_cast<int>(window.drift.velocityX * deltaTime);
-    int newY = currentY + static_cast<int>(window.drift.velocityY * deltaTime);
+        // 與上次設定的位置不同表示被外部移動 (例如使用者拖動標題列)，以系統上的位置為準
+        RECT windowRect;
+        GetWindowRect(hwnd, &windowRect);
+        if (windowRect.left != window.x || windowRect.top != window.y)
+        {
+            PlaceDriftBody(body, windowRect.left, windowRect.top);
+            window.x = windowRect.left;
+            window.y = windowRect.top;
+        }
 
-    // 邊界碰撞檢測和反彈
-    RECT clientRect;
-    GetClientRect((HWND)window.m_windowHandle, &clientRect);
-    int const windowWidth  = clientRect.right - clientRect.left;
-    int const windowHeight = clientRect.bottom - clientRect.top;
+        RECT clientRect;
+        GetClientRect(hwnd, &clientRect);
+        body.width  = clientRect.right - clientRect.left;
+        body.height = clientRect.bottom - clientRect.top;
+    }
+}
 
-    bool bounced = false;
+bool Renderer::ApplyWindowDrift(Window& window, float const alpha) const
+{
+    // 只有畫面上的像素位置改變時才需要移動窗口
+    int drawX, drawY;
+    GetDrawPosition(window.body, alpha, drawX, drawY);
+    if (drawX == window.x && drawY == window.y) return false;
+
+    window.x = drawX;
+    window.y = drawY;
+    return true;
+}
 
-    // 左右邊界
-    if (newX < 0)
-    {
-        newX                   = 0;
-        window.drift.velocityX = -window.drift.velocityX * window.drift.bounceEnergy;
-        bounced                = true;
-    }
-    else if (newX + windowWidth > virtualScreenWidth)
-    {
-        newX                   = virtualScreenWidth - windowWidth;
-        window.drift.velocityX = -window.drift.velocityX * window.drift.bounceEnergy;
-        bounced                = true;
-    }
+void Renderer::CommitWindowMoves()
+{
+    /// https://learn.microsoft.com/en-us/windows/win32/api/winuser/nf-winuser-deferwindowpos
+    if (m_movedWindows.empty()) return;
 
-    // 上下邊界
-    if (newY < 0)
-    {
-        newY                   = 0;
-        window.drift.velocityY = -window.drift.velocityY * window.drift.bounceEnergy;
-        bounced                = true;
-    }
-    else if (newY + windowHeight > virtualScreenHeight)
-    {
-        newY                   = virtualScreenHeight - windowHeight;
-        window.drift.velocityY = -window.drift.velocityY * window.drift.bounceEnergy;
-        bounced                = true;
-    }
+    UINT const flags = SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE;
+    m_rendererMetrics.windowMoves->Add(m_movedWindows.size());
 
-    // 反彈時添加一些隨機性
-    if (bounced)
+    // 一次提交所有移動，系統只重新計算一次窗口排列；任何一步失敗時改為逐一移動
+    HDWP positions = BeginDeferWindowPos((int)m_movedWindows.size());
+    for (size_t i = 0; i < m_movedWindows.size() && positions; ++i)
     {
-        std::uniform_real_distribution<float> bounceDist(-30.0f, 30.0f);
-        window.drift.velocityX += bounceDist(window.rng);
-        window.drift.velocityY += bounceDist(window.rng);
+        Window const& window = m_windowList[m_movedWindows[i]];
+        positions = DeferWindowPos(positions, (HWND)window.m_windowHandle, nullptr, window.x, window.y, 0, 0, flags);
     }
 
-    // 移動窗口
-    if (newX != currentX || newY != currentY)
+    if (!positions || !EndDeferWindowPos(positions))
     {
-        SetWindowPos((HWND)window.m_windowHandle, nullptr, newX, newY, 0, 0,
-                     SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE);
+        for (unsigned int const index : m_movedWindows)
+        {
+            Window const& window = m_windowList[index];
+            SetWindowPos((HWND)window.m_windowHandle, nullptr, window.x, window.y, 0, 0, flags);
+        }
     }
+    m_movedWindows.clear();
 }
 
 HRESULT Renderer::AddWindow(HWND const& hwnd)
 {
-    Window window;
+    // 直接在清單中建構，Window 帶著亂數產生器狀態，複製的成本不低
+    unsigned int const index = (unsigned int)m_windowList.size();
+    m_windowList.emplace_back();
+
+    Window& window          = m_windowList.back();
     window.m_windowHandle   = hwnd;
     window.m_displayContext = GetDC(hwnd);
     window.needsUpdate      = true;
 
+    // 依加入順序錯開更新相位
+    window.updateState.phase = index;
+
+    if (m_isDeterministic)
+    {
+        // 初始位置與大小只在加入時讀取一次，之後完全由模擬決定
+        RECT windowRect;
+        GetWindowRect(hwnd, &windowRect);
+        RECT clientRect;
+        GetClientRect(hwnd, &clientRect);
+
+        window.x           = windowRect.left;
+        window.y           = windowRect.top;
+        window.body.width  = clientRect.right - clientRect.left;
+        window.body.height = clientRect.bottom - clientRect.top;
+        PlaceDriftBody(window.body, window.x, window.y);
+        SeedDriftBody(window.body, MixSeed(m_simulationSeed, index));
+
+        if (m_inputLog.IsOpen())
+        {
+            sInputEvent event;
+            event.type     = eInputEventType::AddWindow;
+            event.windowId = index;
+            event.x        = window.x;
+            event.y        = window.y;
+            event.width    = window.body.width;
+            event.height   = window.body.height;
+            m_inputLog.Write(event);
+        }
+    }
+
     // UpdateWindowPosition(window);
-    m_windowList.push_back(window);
+    m_windowIndices[hwnd] = index;
     return S_OK;
 }
 
-void Renderer::UpdateWindowPosition(Window& window) const
+HRESULT Renderer::AddWindows(HWND const* windows, size_t const count)
 {
-    RECT windowRect;
-    GetWindowRect((HWND)window.m_windowHandle, &windowRect);
+    size_t const total = m_windowList.size() + count;
+    m_windowList.reserve(total);
+    m_windowIndices.reserve(total);
+    m_updateStates.reserve(total);
 
-    if (memcmp(&windowRect, &window.lastRect, sizeof(RECT)) != 0)
+    for (size_t i = 0; i < count; ++i)
     {
-        window.lastRect    = windowRect;
-        window.needsUpdate = true;
-
-        RECT clientRect;
-        GetClientRect((HWND)window.m_windowHandle, &clientRect);
-        window.width  = clientRect.right - clientRect.left;
-        window.height = clientRect.bottom - clientRect.top;
-
-        window.viewportX      = (float)windowRect.left / (float)virtualScreenWidth;
-        window.viewportY      = (float)windowRect.top / (float)virtualScreenHeight;
-        window.viewportWidth  = (float)window.width / (float)virtualScreenWidth;
-        window.viewportHeight = (float)window.height / (float)virtualScreenHeight;
-
-        // 確保座標對齊到像素邊界
-        float pixelAlignX = 1.0f / (float)sceneWidth;
-        float pixelAlignY = 1.0f / (float)sceneHeight;
-
-        window.viewportX      = floor(window.viewportX / pixelAlignX) * pixelAlignX;
-        window.viewportY      = floor(window.viewportY / pixelAlignY) * pixelAlignY;
-        window.viewportWidth  = ceil(window.viewportWidth / pixelAlignX) * pixelAlignX;
-        window.viewportHeight = ceil(window.viewportHeight / pixelAlignY) * pixelAlignY;
+        if (!windows[i]) continue;
 
-        window.viewportX      = max(0.0f, min(1.0f, window.viewportX));
-        window.viewportY      = max(0.0f, min(1.0f, window.viewportY));
-        window.viewportWidth  = max(0.0f, min(1.0f - window.viewportX, window.viewportWidth));
-        window.viewportHeight = max(0.0f, min(1.0f - window.viewportY, window.viewportHeight));
+        HRESULT const hr = AddWindow(windows[i]);
+        if (FAILED(hr)) return hr;
     }
+    return S_OK;
 }
 
-void Renderer::Render()
+bool Renderer::PostSetWindowDriftParams(HWND const hwnd, sDriftParams const& params)
 {
-    if (!m_sceneRenderTargetView || !m_deviceContext) return;
+    sWindowCommand command;
+    command.type   = eWindowCommand::SetDriftParams;
+    command.hwnd   = hwnd;
+    command.params = params;
+    return PostCommand(command);
+}
 
-    // 更新窗口漂移
-    for (Window& window : m_windowList)
+bool Renderer::PostStartDragging(HWND const hwnd, POINT const& mousePos)
+{
+    sWindowCommand command;
+    command.type            = eWindowCommand::StartDragging;
+    command.hwnd            = hwnd;
+    command.timeNanoseconds = GetCommandTimeNanoseconds(m_performanceFrequency);
+    command.mousePos        = mousePos;
+    return PostCommand(command);
+}
+
+bool Renderer::PostStopDragging(HWND const hwnd)
+{
+    sWindowCommand command;
+    command.type            = eWindowCommand::StopDragging;
+    command.hwnd            = hwnd;
+    command.timeNanoseconds = GetCommandTimeNanoseconds(m_performanceFrequency);
+    return PostCommand(command);
+}
+
+bool Renderer::PostUpdateDragging(HWND const hwnd, POINT const& mousePos)
+{
+    sWindowCommand command;
+    command.type            = eWindowCommand::UpdateDragging;
+    command.hwnd            = hwnd;
+    command.timeNanoseconds = GetCommandTimeNanoseconds(m_performanceFrequency);
+    command.mousePos        = mousePos;
+    return PostCommand(command);
+}
+
+bool Renderer::PostAddWindow(HWND const hwnd)
+{
+    sWindowCommand command;
+    command.type = eWindowCommand::AddWindow;
+    command.hwnd = hwnd;
+    return PostCommand(command);
+}
+
+bool Renderer::PostCommand(sWindowCommand const& command)
+{
+    return m_commandQueue.Push(command);
+}
+
+void Renderer::ApplyCommands()
+{
+    // 最多取出一整個佇列的量，生產者持續送命令時這一幀仍然會結束
+    // 拖拽命令先交給 m_dragInput 合併，整個佇列取完後再一起套用
+    unsigned long long const coalescedBefore = m_dragInput.GetStats().movesCoalesced;
+    m_commandsApplied += m_commandQueue.Drain([this](sWindowCommand const& command)
+    {
+        int const index = FindWindowIndex(command.hwnd);
+        switch (command.type)
+        {
+        case eWindowCommand::SetDriftParams: SetWindowDriftParams(command.hwnd, command.params); break;
+        case eWindowCommand::AddWindow:      AddWindow(command.hwnd); break;
+        case eWindowCommand::StartDragging:
+            if (index >= 0) m_dragInput.Press((uint32_t)index, command.mousePos.x, command.mousePos.y, command.timeNanoseconds);
+            break;
+        case eWindowCommand::UpdateDragging:
+            if (index >= 0) m_dragInput.Move((uint32_t)index, command.mousePos.x, command.mousePos.y, command.timeNanoseconds);
+            break;
+        case eWindowCommand::StopDragging:
+            if (index >= 0) m_dragInput.Release((uint32_t)index, command.timeNanoseconds);
+            break;
+        }
+    }, m_commandQueue.GetCapacity());
+
+    m_rendererMetrics.dragMovesCoalesced->Add(m_dragInput.GetStats().movesCoalesced - coalescedBefore);
+    ApplyDragInput();
+}
+
+void Renderer::ApplyDragInput()
+{
+    for (sDragOp const& op : m_dragInput.GetOps())
+    {
+        HWND const  hwnd     = (HWND)m_windowList[op.windowId].m_windowHandle;
+        POINT const mousePos = {op.x, op.y};
+        switch (op.type)
+        {
+        case eDragOpType::Press:   StartDragging(hwnd, mousePos); break;
+        case eDragOpType::Move:    UpdateDragging(hwnd, mousePos); break;
+        case eDragOpType::Release: StopDragging(hwnd, op.velocityX, op.velocityY); break;
+        }
+    }
+    m_dragInput.EndFrame();
+}
+
+UINT Renderer::AdvanceSimulation(LARGE_INTEGER const& now)
+{
+    // 決定性模式每幀固定經過 m_deterministicFrameTime，與實際花費的時間無關
+    if (m_isDeterministic)
+    {
+        return m_simulationTimestep.AdvanceSeconds(m_deterministicFrameTime);
+    }
+
+    // 第一幀沒有上一幀可比較
+    long long elapsedNanoseconds = 0;
+    if (m_lastSimulationTime.QuadPart != 0)
+    {
+        elapsedNanoseconds = (long long)((double)(now.QuadPart - m_lastSimulationTime.QuadPart) * 1e9 /
+                                         (double)m_performanceFrequency.QuadPart);
+    }
+    m_lastSimulationTime = now;
+    return m_simulationTimestep.Advance(elapsedNanoseconds);
+}
+
+void Renderer::UpdateWindowPosition(Window& window) const
+{
+    RECT windowRect;
+    GetWindowRect((HWND)window.m_windowHandle, &windowRect);
+
+    if (memcmp(&windowRect, &window.lastRect, sizeof(RECT)) != 0)
+    {
+        window.lastRect    = windowRect;
+        window.needsUpdate = true;
+
+        RECT clientRect;
+        GetClientRect((HWND)window.m_windowHandle, &clientRect);
+        window.width  = clientRect.right - clientRect.left;
+        window.height = clientRect.bottom - clientRect.top;
+
+        window.viewportX      = (float)windowRect.left / (float)virtualScreenWidth;
+        window.viewportY      = (float)windowRect.top / (float)virtualScreenHeight;
+        window.viewportWidth  = (float)window.width / (float)virtualScreenWidth;
+        window.viewportHeight = (float)window.height / (float)virtualScreenHeight;
+
+        // 確保座標對齊到像素邊界
+        float pixelAlignX = 1.0f / (float)sceneWidth;
+        float pixelAlignY = 1.0f / (float)sceneHeight;
+
+        window.viewportX      = floor(window.viewportX / pixelAlignX) * pixelAlignX;
+        window.viewportY      = floor(window.viewportY / pixelAlignY) * pixelAlignY;
+        window.viewportWidth  = ceil(window.viewportWidth / pixelAlignX) * pixelAlignX;
+        window.viewportHeight = ceil(window.viewportHeight / pixelAlignY) * pixelAlignY;
+
+        window.viewportX      = max(0.0f, min(1.0f, window.viewportX));
+        window.viewportY      = max(0.0f, min(1.0f, window.viewportY));
+        window.viewportWidth  = max(0.0f, min(1.0f - window.viewportX, window.viewportWidth));
+        window.viewportHeight = max(0.0f, min(1.0f - window.viewportY, window.viewportHeight));
+    }
+}
+
+void Renderer::Render()
+{
+    if (!m_softwareBackend && (!m_sceneRenderTargetView || !m_deviceContext)) return;
+
+    LARGE_INTEGER frameStart;
+    QueryPerformanceCounter(&frameStart);
+
+    // 飛行記錄：主循環處理訊息的時間，之後每個階段結束時以 MarkFrameStage 記下
+    if (m_messagePumpStart.QuadPart != 0)
+    {
+        m_frameSample.stageMicroseconds[(size_t)eFrameStage::Messages] =
+            (uint32_t)(ElapsedNanoseconds(m_messagePumpStart, frameStart, m_performanceFrequency) / 1000);
+        m_messagePumpStart.QuadPart = 0;
+    }
+    LARGE_INTEGER  stageStart         = frameStart;
+    uint64_t const readbackBytesStart = m_rendererMetrics.readbackBytes->Get();
+
+    // 先套用其他執行緒送來的命令，之後這一幀都只在渲染執行緒上修改窗口
+    ApplyCommands();
+
+    // 更新窗口漂移：依經過的時間跑固定步長的模擬，畫面位置在最近兩步之間內插
+    // 同一組漂移參數的窗口在同一個特化迴圈裡前進 (見 DriftBuckets)
+    UINT const  simulationSteps = AdvanceSimulation(frameStart);
+    float const alpha           = m_simulationTimestep.GetAlpha();
+
+    m_driftBuckets.Clear();
+    for (Window& window : m_windowList)
+    {
+        SyncWindowDrift(window);
+        m_driftBuckets.Add(window.body);
+    }
+    m_driftBuckets.Step(virtualScreenWidth, virtualScreenHeight, m_simulationTimestep.GetStep(), simulationSteps);
+
+    // 漂移與拖拽的窗口一起移動，之後再讀回系統上的位置
+    for (unsigned int i = 0; i < (unsigned int)m_windowList.size(); ++i)
+    {
+        if (ApplyWindowDrift(m_windowList[i], alpha)) m_movedWindows.push_back(i);
+    }
+    CommitWindowMoves();
+
+    for (Window& window : m_windowList)
     {
-        UpdateWindowDrift(window);
         UpdateWindowPosition(window);
     }
 
-    // 設置渲染目標為場景紋理
-    m_deviceContext->OMSetRenderTargets(1, &m_sceneRenderTargetView, nullptr);
+    // 這一幀的輸入都已套用、模擬也已前進，記下狀態供回放比對
+    if (m_inputLog.IsOpen())
+    {
+        sInputEvent event;
+        event.type     = eInputEventType::FrameEnd;
+        event.checksum = GetSimulationChecksum();
+        m_inputLog.Write(event);
+    }
+    MarkFrameStage(eFrameStage::Simulation, stageStart);
 
-    D3D11_VIEWPORT viewport = {};
-    viewport.Width          = (FLOAT)sceneWidth;
-    viewport.Height         = (FLOAT)sceneHeight;
-    viewport.MinDepth       = 0.f;
-    viewport.MaxDepth       = 1.f;
-    m_deviceContext->RSSetViewports(1, &viewport);
+    // 所有窗口移動完成後再計算遮擋關係
+    CollectOccluders();
+    for (size_t i = 0; i < m_windowList.size(); ++i)
+    {
+        UpdateWindowVisibility(m_windowList[i], m_occludersAbove[i]);
+    }
+
+    // 局部回讀只讀回窗口看得到的區塊，必須在決定是否重新合成之前知道
+    bool const isTileReadback = IsTileReadbackActive();
+    if (isTileReadback)
+    {
+        UpdateTileCoverage();
+    }
+
+    if (m_background)
+    {
+        UpdateBackground();
+    }
+    MarkFrameStage(eFrameStage::Visibility, stageStart);
+
+    // 沒有精靈時隱藏精靈圖層，背景也沒變的話場景與上一幀相同
+    m_spriteBatcher.End();
+    m_spriteBatchStats = m_spriteBatcher.GetStats();
+    m_layerCompositor.SetVisible(m_spriteLayer, !m_spriteBatcher.GetInstances().empty());
+
+    sLayerPlan const& plan         = m_layerCompositor.PlanFrame();
+    bool              isSceneReady = true;
+
+    if (plan.isSceneChanged)
+    {
+        // 場景輸出到 CPU 鏡像，之後由 UpdateWindows 分發到各窗口
+        sSceneTarget sceneTarget;
+        sceneTarget.pixels = m_isCompactMemory ? nullptr : pixelData.data();
+        sceneTarget.width  = sceneWidth;
+        sceneTarget.height = sceneHeight;
+        sceneTarget.pitch  = sceneWidth * 4;
+
+        RenderBackend& backend = GetSceneBackend();
+
+        float const clearColor[4]       = {0.1f, 0.1f, 0.2f, 1.f};
+        float const transparentColor[4] = {0.f, 0.f, 0.f, 0.f};
+        backend.BeginScene(sceneTarget, plan.needsClear ? clearColor : nullptr);
+
+        // 先重繪失效的快取，再由下而上合成
+        for (unsigned int const layerId : plan.redraw)
+        {
+            backend.BeginLayer(m_backendLayers[layerId],
+                               m_layerCompositor.GetLayerDesc(layerId).isOpaque ? nullptr : transparentColor);
+            DrawSceneLayer(backend, layerId);
+            backend.EndLayer();
+        }
+        for (sLayerStep const& step : plan.composite)
+        {
+            if (step.isDirect)
+            {
+                DrawSceneLayer(backend, step.layerId);
+            }
+            else
+            {
+                backend.CompositeLayer(m_backendLayers[step.layerId], m_layerCompositor.GetLayerDesc(step.layerId).isOpaque);
+            }
+        }
+
+        if (isTileReadback)
+        {
+            isSceneReady = QueueTileReadback();
+        }
+        else
+        {
+            // 整幀回讀覆寫鏡像中所有的區塊，之前記錄的校驗碼不再對應
+            m_tileTracker.Reset();
+            isSceneReady = backend.QueueEndScene();
+        }
+    }
+    else
+    {
+        m_rendererMetrics.compositionsReused->Add();
+    }
+    m_spriteBatcher.Begin();
+
+    // 其他場景接在主場景之後繪製，所有送出的回讀在同一個同步點完成
+    UpdateSceneViews();
+    m_sceneGroup->QueueScenes();
+    MarkFrameStage(eFrameStage::Composite, stageStart);
+
+    bool const isFlushed = GetSceneBackend().FlushSceneReadbacks();
+    m_sceneGroup->CompleteReadbacks(isFlushed);
+
+    if (plan.isSceneChanged && (!isSceneReady || !isFlushed))
+    {
+        isSceneReady = false;
+        m_layerCompositor.InvalidateComposition();
+        m_rendererMetrics.framesDropped->Add();
+    }
+    MarkFrameStage(eFrameStage::Readback, stageStart);
+
+    // 場景沒有變化時 pixelData (或 staging 紋理) 仍是上一幀的結果，窗口照常依移動與排程更新
+    if (isSceneReady)
+    {
+        if (MapScenePixels())
+        {
+            if (m_frameExporter.IsOpen())
+            {
+                PublishFrame();
+            }
+            UpdateWindows();
+            UnmapScenePixels();
+        }
+        else
+        {
+            m_rendererMetrics.framesDropped->Add();
+        }
+
+        // 交出 pixelData 之後內容未定義，下一幀必須重新合成
+        if (m_frameRecorder.IsRecording())
+        {
+            RecordFrame();
+            m_layerCompositor.InvalidateComposition();
+        }
+    }
+    MarkFrameStage(eFrameStage::Windows, stageStart);
+
+    // 主場景的窗口在渲染執行緒上更新，其他場景的窗口分散到執行緒池
+    m_sceneGroup->PresentScenes([this](Scene const& scene, sSceneView const& view) { PresentSceneView(scene, view); });
+    MarkFrameStage(eFrameStage::Scenes, stageStart);
+
+    LARGE_INTEGER frameEnd;
+    QueryPerformanceCounter(&frameEnd);
+
+    m_rendererMetrics.frames->Add();
+    m_rendererMetrics.frameTime->Record(ElapsedNanoseconds(frameStart, frameEnd, m_performanceFrequency));
+    m_rendererMetrics.windows->Set((double)m_windowList.size());
+    m_rendererMetrics.sceneWidth->Set((double)sceneWidth);
+    m_rendererMetrics.sceneHeight->Set((double)sceneHeight);
+
+    if (m_lastMemoryReport.QuadPart == 0 ||
+        ElapsedNanoseconds(m_lastMemoryReport, frameEnd, m_performanceFrequency) >= MEMORY_REPORT_INTERVAL_NANOSECONDS)
+    {
+        sMemoryReport memoryReport;
+        GetMemoryReport(memoryReport);
+        for (size_t i = 0; i < (size_t)eMemoryCategory::Count; ++i)
+        {
+            m_rendererMetrics.memoryBytes[i]->Set((double)memoryReport.bytes[i]);
+        }
+        m_lastMemoryReport = frameEnd;
+    }
+
+    // 解析度只影響場景的繪製與回讀 (包含等待 GPU)；窗口呈現的 StretchDIBits 隨窗口數量增加，不能算進去
+    float const sceneMs = (m_frameSample.stageMicroseconds[(size_t)eFrameStage::Composite] +
+                           m_frameSample.stageMicroseconds[(size_t)eFrameStage::Readback]) / 1000.f;
+    if (m_dynamicResolutionEnabled && m_resolutionController.Update(sceneMs))
+    {
+        float const scale = m_resolutionController.GetScale();
+        SetSceneResolution((UINT)round(maxSceneWidth * scale), (UINT)round(maxSceneHeight * scale));
+    }
+
+    // 本幀的暫存配置全部失效
+    m_frameMemory.EndFrame();
 
-    float const clearColor[4] = {0.1f, 0.1f, 0.2f, 1.f};
-    m_deviceContext->ClearRenderTargetView(m_sceneRenderTargetView, clearColor);
+    // 幀時間包含上面的指標與解析度調整 (與各階段總和的差)；超過門檻時飛行記錄器寫出前後幾秒
+    LARGE_INTEGER recordTime;
+    QueryPerformanceCounter(&recordTime);
 
-    RenderTestTexture();
-    m_deviceContext->CopyResource(m_stagingTexture, m_sceneTexture);    // ID3D11DeviceContext::CopyResource(destination, source)
-    UpdateWindows();
+    sFrameSample& sample        = m_frameSample;
+    sample.frameMicroseconds    = sample.stageMicroseconds[(size_t)eFrameStage::Messages] +
+                                  (uint32_t)(ElapsedNanoseconds(frameStart, recordTime, m_performanceFrequency) / 1000);
+    sample.intervalMicroseconds = m_lastFrameStart.QuadPart != 0 ? (uint32_t)(ElapsedNanoseconds(m_lastFrameStart, frameStart, m_performanceFrequency) / 1000) : 0;
+    sample.windowCount          = (uint32_t)m_windowList.size();
+    sample.readbackBytes        = (uint32_t)(m_rendererMetrics.readbackBytes->Get() - readbackBytesStart);
+    if (m_flightRecorder.Record(sample))
+    {
+        m_rendererMetrics.hitches->Add();
+    }
+    m_frameSample    = sFrameSample();
+    m_lastFrameStart = frameStart;
+}
+
+void Renderer::BeginMessagePump()
+{
+    QueryPerformanceCounter(&m_messagePumpStart);
+}
+
+void Renderer::MarkFrameStage(eFrameStage const stage, LARGE_INTEGER& stageStart)
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    m_frameSample.stageMicroseconds[(size_t)stage] = (uint32_t)(ElapsedNanoseconds(stageStart, now, m_performanceFrequency) / 1000);
+    stageStart = now;
+}
+
+void Renderer::SetSceneResolution(UINT width, UINT height)
+{
+    width  = max(1u, min(width, maxSceneWidth));
+    height = max(1u, min(height, maxSceneHeight));
+
+    if (width == sceneWidth && height == sceneHeight) return;
+
+    sceneWidth  = width;
+    sceneHeight = height;
+
+    bitmapInfo.header.biWidth  = sceneWidth;
+    bitmapInfo.header.biHeight = -static_cast<LONG>(sceneHeight);
+
+    // 容量已在建構時預留，不會重新配置；省記憶體模式沒有鏡像
+    if (!m_isCompactMemory)
+    {
+        pixelData.resize(sceneWidth * sceneHeight * 4);
+    }
+
+    // 圖層快取以場景尺寸保存，全部重繪；區塊的劃分也隨之改變
+    m_layerCompositor.InvalidateAll();
+    m_tileTracker.Resize(sceneWidth, sceneHeight);
+
+    // 視口對齊依賴場景解析度，強制所有窗口在下一幀重新計算
+    for (Window& window : m_windowList)
+    {
+        ZeroMemory(&window.lastRect, sizeof(RECT));
+        window.needsUpdate = true;
+    }
+}
+
+void Renderer::SetDynamicResolutionEnabled(bool const enabled, float const sceneBudgetMs)
+{
+    m_dynamicResolutionEnabled = enabled;
+    if (sceneBudgetMs > 0.f)
+    {
+        sResolutionControllerConfig config = m_resolutionController.GetConfig();
+        config.targetFrameMs               = sceneBudgetMs;
+        m_resolutionController             = ResolutionController(config);
+    }
+    if (!enabled)
+    {
+        m_resolutionController.Reset();
+        SetSceneResolution(maxSceneWidth, maxSceneHeight);
+    }
 }
 
 HRESULT Renderer::CreateDeviceAndSwapChain()
@@ -451,8 +1199,8 @@ HRESULT Renderer::CreateDeviceAndSwapChain()
 HRESULT Renderer::CreateSceneRenderTexture()
 {
     D3D11_TEXTURE2D_DESC texDesc = {};
-    texDesc.Width                = sceneWidth;
-    texDesc.Height               = sceneHeight;
+    texDesc.Width                = maxSceneWidth;
+    texDesc.Height               = maxSceneHeight;
     texDesc.MipLevels            = 1;
     texDesc.ArraySize            = 1;
     texDesc.Format               = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -473,10 +1221,15 @@ HRESULT Renderer::CreateSceneRenderTexture()
 }
 
 HRESULT Renderer::CreateStagingTexture()
+{
+    return CreateReadbackTexture(&m_stagingTexture);
+}
+
+HRESULT Renderer::CreateReadbackTexture(ID3D11Texture2D** texture)
 {
     D3D11_TEXTURE2D_DESC texDesc = {};
-    texDesc.Width                = sceneWidth;
-    texDesc.Height               = sceneHeight;
+    texDesc.Width                = maxSceneWidth;
+    texDesc.Height               = maxSceneHeight;
     texDesc.MipLevels            = 1;
     texDesc.ArraySize            = 1;
     texDesc.Format               = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -484,225 +1237,1128 @@ HRESULT Renderer::CreateStagingTexture()
     texDesc.Usage                = D3D11_USAGE_STAGING;
     texDesc.CPUAccessFlags       = D3D11_CPU_ACCESS_READ;
 
-    return m_device->CreateTexture2D(&texDesc, nullptr, &m_stagingTexture);
+    return m_device->CreateTexture2D(&texDesc, nullptr, texture);
 }
 
 HRESULT Renderer::CreateTestTexture(const wchar_t* imageFile)
 {
+    // 沒有背景圖時背景圖層顯示測試紋理
+    m_layerCompositor.Invalidate(m_backgroundLayer);
+
     if (imageFile)
     {
         // 嘗試從檔案載入
-        HRESULT hr = LoadImageFromFile(imageFile, &m_testTexture, &m_testShaderResourceView);
+        BufferPool::Buffer pixels;
+        UINT               width  = 0;
+        UINT               height = 0;
+
+        HRESULT const hr = LoadImageFromFile(imageFile, pixels, width, height);
         if (SUCCEEDED(hr))
         {
-            return hr;
+            m_testTextureId = GetSceneBackend().CreateSceneTexture(pixels.As<uint32_t>(), width, height);
+            if (m_testTextureId != INVALID_SCENE_TEXTURE_ID) return S_OK;
         }
         // 如果載入失敗，回到程序生成紋理
     }
 
     const UINT texWidth  = 512;
     const UINT texHeight = 512;
-    //
-    std::vector<UINT> textureData(texWidth * texHeight);
 
-    for (UINT y = 0; y < texHeight; y++)
+    // 以區塊分給執行緒池，每列 SIMD 計算
+    BufferPool::Buffer const textureData = m_frameMemory.GetBufferPool().Acquire((size_t)texWidth * texHeight * 4);
+    GenerateTestPattern(textureData.As<uint32_t>(), texWidth, texHeight, &m_threadPool);
+
+    m_testTextureId = GetSceneBackend().CreateSceneTexture(textureData.As<uint32_t>(), texWidth, texHeight);
+    return m_testTextureId != INVALID_SCENE_TEXTURE_ID ? S_OK : E_FAIL;
+}
+
+HRESULT Renderer::CreateShaders()
+{
+    // 建置時的 pack 優先；原始碼改動過的 shader 才會讀磁碟快取或即時編譯
+    m_shaderCache.LoadPack(GetExecutableRelativePath(SHADER_PACK_PATH));
+    CreateDirectoryPath(GetExecutableRelativePath(SHADER_CACHE_DIRECTORY));
+
+    std::string errors;
+    if (!m_shaderRegistry.Compile(m_shaderCache, &errors))
     {
-        for (UINT x = 0; x < texWidth; x++)
-        {
-            UINT index = y * texWidth + x;
+        OutputDebugStringA(errors.c_str());
+        return E_FAIL;
+    }
 
-            float fx = (float)x / texWidth;
-            float fy = (float)y / texHeight;
+    return CreateShaderProgram(SHADER_FULLSCREEN_TEXTURE, &m_vertexShader, &m_pixelShader, &m_inputLayout);
+}
 
-            UINT r = (UINT)(fx * 255);
-            UINT g = (UINT)(fy * 255);
-            UINT b = (UINT)((1.0f - fx) * 255);
+HRESULT Renderer::CreateShaderProgram(char const*          name,
+                                      ID3D11VertexShader** vertexShader,
+                                      ID3D11PixelShader**  pixelShader,
+                                      ID3D11InputLayout**  inputLayout)
+{
+    sShaderProgram const* program = m_shaderRegistry.Find(name);
+    if (!program || !program->isCompiled) return E_FAIL;
 
-            if (((x / 32) + (y / 32)) % 2 == 0)
-            {
-                r = min(255, r + 50);
-                g = min(255, g + 50);
-                b = min(255, b + 50);
-            }
+    HRESULT hr = m_device->CreateVertexShader(program->vertexBytecode.data(), program->vertexBytecode.size(),
+                                              nullptr, vertexShader);
+    if (FAILED(hr)) return hr;
 
-            for (int i = 0; i < 5; i++)
-            {
-                float centerX  = (i % 3) * texWidth / 3.0f + texWidth / 6.0f;
-                float centerY  = (i / 3) * texHeight / 3.0f + texHeight / 6.0f;
-                float distance = sqrt((x - centerX) * (x - centerX) + (y - centerY) * (y - centerY));
-
-                if (distance < 30.0f)
-                {
-                    r = (i * 50) % 256;
-                    g = (i * 80) % 256;
-                    b = (i * 120) % 256;
-                }
-            }
+    std::vector<D3D11_INPUT_ELEMENT_DESC> layout;
+    for (sShaderInputElement const& element : program->desc.inputLayout)
+    {
+        D3D11_INPUT_ELEMENT_DESC desc = {};
+        desc.SemanticName             = element.semantic;
+        desc.SemanticIndex            = element.semanticIndex;
+        desc.Format                   = ToDxgiFormat(element.format);
+        desc.InputSlot                = element.slot;
+        desc.AlignedByteOffset        = element.offset;
+        desc.InputSlotClass           = element.isPerInstance ? D3D11_INPUT_PER_INSTANCE_DATA : D3D11_INPUT_PER_VERTEX_DATA;
+        desc.InstanceDataStepRate     = element.isPerInstance ? 1 : 0;
+        layout.push_back(desc);
+    }
 
-            textureData[index] = 0xFF000000 | (b << 16) | (g << 8) | r;
-        }
+    hr = m_device->CreateInputLayout(layout.data(), (UINT)layout.size(), program->vertexBytecode.data(),
+                                     program->vertexBytecode.size(), inputLayout);
+    if (FAILED(hr)) return hr;
+
+    return m_device->CreatePixelShader(program->pixelBytecode.data(), program->pixelBytecode.size(),
+                                       nullptr, pixelShader);
+}
+
+bool Renderer::BuildShaderPack(char const* path)
+{
+    ShaderRegistry registry;
+    RegisterBuiltInShaders(registry);
+
+    // 不使用磁碟快取，確保 pack 內容一定來自目前的原始碼
+    ShaderCache cache(std::string(), &CompileShaderWithD3D);
+
+    std::string errors;
+    if (!registry.Compile(cache, &errors))
+    {
+        OutputDebugStringA(errors.c_str());
+        return false;
     }
 
-    D3D11_TEXTURE2D_DESC texDesc = {};
-    texDesc.Width                = texWidth;
-    texDesc.Height               = texHeight;
-    texDesc.MipLevels            = 1;
-    texDesc.ArraySize            = 1;
-    texDesc.Format               = DXGI_FORMAT_R8G8B8A8_UNORM;
-    texDesc.SampleDesc.Count     = 1;
-    texDesc.Usage                = D3D11_USAGE_DEFAULT;
-    texDesc.BindFlags            = D3D11_BIND_SHADER_RESOURCE;
+    std::string const packPath = path ? std::string(path) : GetExecutableRelativePath(SHADER_PACK_PATH);
+    size_t const      slash    = packPath.find_last_of("/\\");
+    if (slash != std::string::npos)
+    {
+        CreateDirectoryPath(packPath.substr(0, slash));
+    }
+
+    return WriteShaderPack(packPath, registry.CollectPackEntries());
+}
+
+HRESULT Renderer::CreateVertexBuffer()
+{
+    Vertex vertices[] = {
+        {XMFLOAT3(-1.0f, -1.0f, 0.0f), XMFLOAT2(0.0f, 1.0f)},
+        {XMFLOAT3(-1.0f, 1.0f, 0.0f), XMFLOAT2(0.0f, 0.0f)},
+        {XMFLOAT3(1.0f, 1.0f, 0.0f), XMFLOAT2(1.0f, 0.0f)},
+        {XMFLOAT3(1.0f, -1.0f, 0.0f), XMFLOAT2(1.0f, 1.0f)}
+    };
+
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.Usage             = D3D11_USAGE_DEFAULT;
+    bufferDesc.ByteWidth         = sizeof(vertices);
+    bufferDesc.BindFlags         = D3D11_BIND_VERTEX_BUFFER;
 
     D3D11_SUBRESOURCE_DATA initData = {};
-    initData.pSysMem                = textureData.data();
-    initData.SysMemPitch            = texWidth * 4;
+    initData.pSysMem                = vertices;
+
+    HRESULT hr = m_device->CreateBuffer(&bufferDesc, &initData, &m_vertexBuffer);
+    if (FAILED(hr)) return hr;
+
+    UINT indices[] = {0, 1, 2, 0, 2, 3};
+
+    bufferDesc.ByteWidth = sizeof(indices);
+    bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+    initData.pSysMem     = indices;
+
+    return m_device->CreateBuffer(&bufferDesc, &initData, &m_indexBuffer);
+}
+
+HRESULT Renderer::CreateSampler()
+{
+    D3D11_SAMPLER_DESC samplerDesc = {};
+    samplerDesc.Filter             = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    samplerDesc.AddressU           = D3D11_TEXTURE_ADDRESS_WRAP;
+    samplerDesc.AddressV           = D3D11_TEXTURE_ADDRESS_WRAP;
+    samplerDesc.AddressW           = D3D11_TEXTURE_ADDRESS_WRAP;
+    samplerDesc.ComparisonFunc     = D3D11_COMPARISON_NEVER;
+    samplerDesc.MinLOD             = 0;
+    samplerDesc.MaxLOD             = D3D11_FLOAT32_MAX;
+
+    return m_device->CreateSamplerState(&samplerDesc, &m_sampler);
+}
+
+HRESULT Renderer::CreateSpriteResources()
+{
+    HRESULT hr = CreateShaderProgram(SHADER_SPRITE, &m_spriteVertexShader, &m_spritePixelShader, &m_spriteInputLayout);
+    if (FAILED(hr)) return hr;
+
+    // 角點以 y 向下的場景座標排列，與 m_indexBuffer 的順時針索引一致
+    SpriteCorner corners[] = {
+        {XMFLOAT2(-0.5f, 0.5f)},
+        {XMFLOAT2(-0.5f, -0.5f)},
+        {XMFLOAT2(0.5f, -0.5f)},
+        {XMFLOAT2(0.5f, 0.5f)}
+    };
+
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.Usage             = D3D11_USAGE_DEFAULT;
+    bufferDesc.ByteWidth         = sizeof(corners);
+    bufferDesc.BindFlags         = D3D11_BIND_VERTEX_BUFFER;
+
+    D3D11_SUBRESOURCE_DATA initData = {};
+    initData.pSysMem                = corners;
+
+    hr = m_device->CreateBuffer(&bufferDesc, &initData, &m_spriteCornerBuffer);
+    if (FAILED(hr)) return hr;
+
+    // 精靈座標以最大場景解析度為準，動態解析度切換時由視口自動縮放
+    SpriteConstants constants = {XMFLOAT2((float)maxSceneWidth, (float)maxSceneHeight), XMFLOAT2(0.f, 0.f)};
+
+    bufferDesc.ByteWidth = sizeof(SpriteConstants);
+    bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    initData.pSysMem     = &constants;
+
+    hr = m_device->CreateBuffer(&bufferDesc, &initData, &m_spriteConstantBuffer);
+    if (FAILED(hr)) return hr;
+
+    D3D11_BLEND_DESC blendDesc                      = {};
+    blendDesc.RenderTarget[0].BlendEnable           = TRUE;
+    blendDesc.RenderTarget[0].SrcBlend              = D3D11_BLEND_SRC_ALPHA;
+    blendDesc.RenderTarget[0].DestBlend             = D3D11_BLEND_INV_SRC_ALPHA;
+    blendDesc.RenderTarget[0].BlendOp               = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].SrcBlendAlpha         = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].DestBlendAlpha        = D3D11_BLEND_INV_SRC_ALPHA;
+    blendDesc.RenderTarget[0].BlendOpAlpha          = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+
+    hr = m_device->CreateBlendState(&blendDesc, &m_spriteBlendState);
+    if (FAILED(hr)) return hr;
+
+    // 圖層內容為 premultiplied alpha (透明底上以上面的狀態繪製的結果)，合成時顏色不再乘 alpha
+    blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_ONE;
+
+    hr = m_device->CreateBlendState(&blendDesc, &m_layerBlendState);
+    if (FAILED(hr)) return hr;
+
+    return EnsureSpriteInstanceCapacity(1024);
+}
+
+HRESULT Renderer::CreateTileChecksumResources()
+{
+    HRESULT hr = CreateShaderProgram(SHADER_TILE_CHECKSUM, &m_tileVertexShader, &m_tilePixelShader, &m_tileInputLayout);
+    if (FAILED(hr)) return hr;
+
+    // 主場景的快照，與場景紋理相同的配置
+    D3D11_TEXTURE2D_DESC texDesc = {};
+    texDesc.Width                = maxSceneWidth;
+    texDesc.Height               = maxSceneHeight;
+    texDesc.MipLevels            = 1;
+    texDesc.ArraySize            = 1;
+    texDesc.Format               = DXGI_FORMAT_R8G8B8A8_UNORM;
+    texDesc.SampleDesc.Count     = 1;
+    texDesc.Usage                = D3D11_USAGE_DEFAULT;
+    texDesc.BindFlags            = D3D11_BIND_SHADER_RESOURCE;
+
+    hr = m_device->CreateTexture2D(&texDesc, nullptr, &m_tileSourceTexture);
+    if (FAILED(hr)) return hr;
+
+    hr = m_device->CreateShaderResourceView(m_tileSourceTexture, nullptr, &m_tileSourceView);
+    if (FAILED(hr)) return hr;
+
+    // 每個區塊一個像素 (總和, XOR)，讀回的量與場景相比可以忽略
+    texDesc.Width     = (maxSceneWidth + READBACK_TILE_SIZE - 1) / READBACK_TILE_SIZE;
+    texDesc.Height    = (maxSceneHeight + READBACK_TILE_SIZE - 1) / READBACK_TILE_SIZE;
+    texDesc.Format    = DXGI_FORMAT_R32G32_UINT;
+    texDesc.BindFlags = D3D11_BIND_RENDER_TARGET;
+
+    hr = m_device->CreateTexture2D(&texDesc, nullptr, &m_tileChecksumTexture);
+    if (FAILED(hr)) return hr;
+
+    hr = m_device->CreateRenderTargetView(m_tileChecksumTexture, nullptr, &m_tileChecksumTargetView);
+    if (FAILED(hr)) return hr;
+
+    texDesc.Usage          = D3D11_USAGE_STAGING;
+    texDesc.BindFlags      = 0;
+    texDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+
+    hr = m_device->CreateTexture2D(&texDesc, nullptr, &m_tileChecksumStaging);
+    if (FAILED(hr)) return hr;
+
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.Usage             = D3D11_USAGE_DEFAULT;
+    bufferDesc.ByteWidth         = sizeof(TileChecksumConstants);
+    bufferDesc.BindFlags         = D3D11_BIND_CONSTANT_BUFFER;
+
+    hr = m_device->CreateBuffer(&bufferDesc, nullptr, &m_tileConstantBuffer);
+    if (FAILED(hr)) return hr;
+
+    m_tileTracker.Resize(sceneWidth, sceneHeight);
+    return S_OK;
+}
+
+unsigned int Renderer::CreateSceneTexture(uint32_t const* pixels, unsigned int const width, unsigned int const height)
+{
+    if (!m_device || !pixels || width == 0 || height == 0) return INVALID_SCENE_TEXTURE_ID;
+
+    // 完整的 mip chain，縮小取樣時不會在原圖上跳躍讀取
+    sMipChain mipChain;
+    BuildMipChain(pixels, width, height, eMipFilter::Kaiser, mipChain, &m_threadPool);
+
+    D3D11_TEXTURE2D_DESC texDesc = {};
+    texDesc.Width                = width;
+    texDesc.Height               = height;
+    texDesc.MipLevels            = (UINT)mipChain.levels.size();
+    texDesc.ArraySize            = 1;
+    texDesc.Format               = DXGI_FORMAT_R8G8B8A8_UNORM;
+    texDesc.SampleDesc.Count     = 1;
+    texDesc.Usage                = D3D11_USAGE_DEFAULT;
+    texDesc.BindFlags            = D3D11_BIND_SHADER_RESOURCE;
+
+    std::vector<D3D11_SUBRESOURCE_DATA> initData(mipChain.levels.size());
+    for (size_t level = 0; level < mipChain.levels.size(); ++level)
+    {
+        initData[level].pSysMem     = mipChain.GetLevelPixels(level);
+        initData[level].SysMemPitch = mipChain.levels[level].width * 4;
+    }
+
+    return CreateTextureView(texDesc, initData.data());
+}
+
+unsigned int Renderer::CreateDynamicSceneTexture(unsigned int const width, unsigned int const height)
+{
+    if (!m_device || width == 0 || height == 0) return INVALID_SCENE_TEXTURE_ID;
+
+    D3D11_TEXTURE2D_DESC texDesc = {};
+    texDesc.Width                = width;
+    texDesc.Height               = height;
+    texDesc.MipLevels            = 1;
+    texDesc.ArraySize            = 1;
+    texDesc.Format               = DXGI_FORMAT_R8G8B8A8_UNORM;
+    texDesc.SampleDesc.Count     = 1;
+    texDesc.Usage                = D3D11_USAGE_DEFAULT;
+    texDesc.BindFlags            = D3D11_BIND_SHADER_RESOURCE;
+
+    BufferPool::Buffer const pixels = m_frameMemory.GetBufferPool().Acquire((size_t)width * height * 4);
+    memset(pixels.GetData(), 0, pixels.GetSize());
+
+    D3D11_SUBRESOURCE_DATA initData = {};
+    initData.pSysMem                = pixels.GetData();
+    initData.SysMemPitch            = width * 4;
+
+    return CreateTextureView(texDesc, &initData);
+}
+
+void Renderer::UpdateSceneTexture(unsigned int const textureId, sRect const& rect, uint32_t const* pixels, unsigned int const pitch)
+{
+    if (textureId >= m_spriteTextures.size() || !m_spriteTextures[textureId] || !pixels || rect.IsEmpty()) return;
+
+    ID3D11Resource* resource = nullptr;
+    m_spriteTextures[textureId]->GetResource(&resource);
+    if (!resource) return;
+
+    // 只上傳變動的矩形
+    D3D11_BOX const box = {(UINT)rect.left, (UINT)rect.top, 0, (UINT)rect.right, (UINT)rect.bottom, 1};
+    m_deviceContext->UpdateSubresource(resource, 0, &box, pixels + (size_t)rect.top * pitch + rect.left, pitch * 4, 0);
+    resource->Release();
+}
+
+unsigned int Renderer::CreateTextureView(D3D11_TEXTURE2D_DESC const& texDesc, D3D11_SUBRESOURCE_DATA const* initData)
+{
+    ID3D11Texture2D* texture = nullptr;
+    HRESULT          hr      = m_device->CreateTexture2D(&texDesc, initData, &texture);
+    if (FAILED(hr)) return INVALID_SCENE_TEXTURE_ID;
+
+    ID3D11ShaderResourceView* shaderResourceView = nullptr;
+    hr = m_device->CreateShaderResourceView(texture, nullptr, &shaderResourceView);
+    texture->Release();     // SRV 持有紋理的參考
+    if (FAILED(hr)) return INVALID_SCENE_TEXTURE_ID;
+
+    // 場景紋理與精靈紋理共用編號
+    unsigned int const textureId = RegisterSpriteTexture(shaderResourceView);
+    shaderResourceView->Release();
+    return textureId;
+}
+
+void Renderer::BeginScene(sSceneTarget const& target, float const clearColor[4])
+{
+    m_sceneTarget = target;
+
+    // 設置渲染目標為場景紋理
+    BindSceneRenderTarget(m_sceneRenderTargetView);
+
+    if (clearColor)
+    {
+        m_deviceContext->ClearRenderTargetView(m_sceneRenderTargetView, clearColor);
+    }
+}
+
+void Renderer::BindSceneRenderTarget(ID3D11RenderTargetView* renderTargetView)
+{
+    // 即將寫入的圖層可能還綁在 slot 0 上 (上一次合成)，先解除
+    ID3D11ShaderResourceView* nullTexture = nullptr;
+    m_deviceContext->PSSetShaderResources(0, 1, &nullTexture);
+    m_deviceContext->OMSetRenderTargets(1, &renderTargetView, nullptr);
+
+    D3D11_VIEWPORT viewport = {};
+    viewport.Width          = (FLOAT)m_sceneTarget.width;
+    viewport.Height         = (FLOAT)m_sceneTarget.height;
+    viewport.MinDepth       = 0.f;
+    viewport.MaxDepth       = 1.f;
+    m_deviceContext->RSSetViewports(1, &viewport);
+
+    InvalidateBoundState();
+}
+
+unsigned int Renderer::CreateLayer()
+{
+    m_layerTargets.emplace_back();
+    return (unsigned int)m_layerTargets.size() - 1;
+}
+
+HRESULT Renderer::EnsureLayerTarget(sLayerTarget& layer, UINT const width, UINT const height)
+{
+    if (layer.texture && layer.width == width && layer.height == height) return S_OK;
+
+    // 與場景同尺寸：合成時整張取樣，不需要調整紋理座標
+    ReleaseLayerTarget(layer);
+
+    D3D11_TEXTURE2D_DESC texDesc = {};
+    texDesc.Width                = width;
+    texDesc.Height               = height;
+    texDesc.MipLevels            = 1;
+    texDesc.ArraySize            = 1;
+    texDesc.Format               = DXGI_FORMAT_R8G8B8A8_UNORM;
+    texDesc.SampleDesc.Count     = 1;
+    texDesc.Usage                = D3D11_USAGE_DEFAULT;
+    texDesc.BindFlags            = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+
+    HRESULT hr = m_device->CreateTexture2D(&texDesc, nullptr, &layer.texture);
+    if (FAILED(hr)) return hr;
+
+    hr = m_device->CreateRenderTargetView(layer.texture, nullptr, &layer.renderTargetView);
+    if (SUCCEEDED(hr))
+    {
+        hr = m_device->CreateShaderResourceView(layer.texture, nullptr, &layer.shaderResourceView);
+    }
+    if (FAILED(hr))
+    {
+        ReleaseLayerTarget(layer);
+        return hr;
+    }
+
+    layer.width  = width;
+    layer.height = height;
+    return S_OK;
+}
+
+void Renderer::ReleaseLayerTarget(sLayerTarget& layer)
+{
+    if (layer.shaderResourceView) layer.shaderResourceView->Release();
+    if (layer.renderTargetView) layer.renderTargetView->Release();
+    if (layer.texture) layer.texture->Release();
+    layer = sLayerTarget();
+}
+
+void Renderer::BeginLayer(unsigned int const layerId, float const clearColor[4])
+{
+    // 圖層目標只在 GPU 上，與 CPU 鏡像無關：省記憶體模式的 m_sceneTarget.pixels 為 nullptr 時也要建立
+    if (layerId >= m_layerTargets.size()) return;
+
+    sLayerTarget& layer = m_layerTargets[layerId];
+    if (FAILED(EnsureLayerTarget(layer, m_sceneTarget.width, m_sceneTarget.height))) return;
+
+    BindSceneRenderTarget(layer.renderTargetView);
+
+    if (clearColor)
+    {
+        m_deviceContext->ClearRenderTargetView(layer.renderTargetView, clearColor);
+    }
+}
+
+void Renderer::EndLayer()
+{
+    BindSceneRenderTarget(m_sceneRenderTargetView);
+}
+
+void Renderer::CompositeLayer(unsigned int const layerId, bool const isOpaque)
+{
+    if (layerId >= m_layerTargets.size()) return;
+
+    sLayerTarget const& layer = m_layerTargets[layerId];
+    if (!layer.texture || layer.width != m_sceneTarget.width || layer.height != m_sceneTarget.height) return;
+
+    // 不透明的圖層直接複製，不經過管線
+    if (isOpaque)
+    {
+        D3D11_BOX const layerBox = {0, 0, 0, layer.width, layer.height, 1};
+        m_deviceContext->CopySubresourceRegion(m_sceneTexture, 0, 0, 0, 0, layer.texture, 0, &layerBox);
+        return;
+    }
+
+    DrawFullscreenQuad(layer.shaderResourceView, m_layerBlendState);
+}
+
+bool Renderer::EndScene()
+{
+    if (!m_sceneTarget.pixels && !m_isCompactMemory) return false;
+
+    // 場景紋理以最大解析度配置，只複製目前使用的區域
+    D3D11_BOX const sceneBox = {0, 0, 0, m_sceneTarget.width, m_sceneTarget.height, 1};
+    m_deviceContext->CopySubresourceRegion(m_stagingTexture, 0, 0, 0, 0, m_sceneTexture, 0, &sceneBox);
+
+    // 省記憶體模式：場景留在 staging，分發到窗口時由 MapScenePixels 直接映射讀取
+    if (m_isCompactMemory)
+    {
+        m_sceneTarget = sSceneTarget();
+        return true;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    HRESULT const            hr = m_deviceContext->Map(m_stagingTexture, 0, D3D11_MAP_READ, 0, &mappedResource);
+    if (FAILED(hr)) return false;
+
+    BYTE const* sourceData = static_cast<BYTE*>(mappedResource.pData);
+    for (UINT y = 0; y < m_sceneTarget.height; y++)
+    {
+        memcpy(&m_sceneTarget.pixels[y * m_sceneTarget.pitch],
+               &sourceData[y * mappedResource.RowPitch],
+               m_sceneTarget.width * 4);
+    }
+
+    m_deviceContext->Unmap(m_stagingTexture, 0);
+    m_rendererMetrics.readbackBytes->Add((uint64_t)m_sceneTarget.height * m_sceneTarget.width * 4);
+    m_sceneTarget = sSceneTarget();
+    return true;
+}
+
+bool Renderer::QueueEndScene()
+{
+    // 沒有 CPU 目的 (省記憶體模式的主場景) 時照舊：只複製到 m_stagingTexture，之後由 MapScenePixels 映射
+    if (!m_sceneTarget.pixels) return EndScene();
+
+    // 省記憶體模式或主場景局部回讀時 m_stagingTexture 保留給主場景
+    size_t const     slot    = m_pendingReadbacks.size() + (m_isCompactMemory || m_isTileReadbackPending ? 1 : 0);
+    ID3D11Texture2D* staging = GetReadbackStaging(slot);
+    if (!staging)
+    {
+        m_sceneTarget = sSceneTarget();
+        return false;
+    }
+
+    // 所有場景共用同一張場景紋理：複製在下一個場景清除它之前送出，GPU 依序執行
+    D3D11_BOX const sceneBox = {0, 0, 0, m_sceneTarget.width, m_sceneTarget.height, 1};
+    m_deviceContext->CopySubresourceRegion(staging, 0, 0, 0, 0, m_sceneTexture, 0, &sceneBox);
+
+    sPendingReadback readback;
+    readback.staging = staging;
+    readback.target  = m_sceneTarget;
+    m_pendingReadbacks.push_back(readback);
+
+    m_sceneTarget = sSceneTarget();
+    return true;
+}
+
+bool Renderer::FlushSceneReadbacks()
+{
+    // 主場景的區塊校驗碼先讀回 (只等到主場景完成)，變化的區塊接在其他場景之後複製，最後一起映射
+    bool isSucceeded        = true;
+    bool isTileReadback     = m_isTileReadbackPending;
+    m_isTileReadbackPending = false;
+    if (isTileReadback && !QueueChangedTiles())
+    {
+        isTileReadback = false;
+        isSucceeded    = false;
+    }
+
+    // 所有複製都已送出：第一個 Map 等待 GPU 完成，之後的都已經就緒
+    for (sPendingReadback const& readback : m_pendingReadbacks)
+    {
+        D3D11_MAPPED_SUBRESOURCE mappedResource;
+        if (FAILED(m_deviceContext->Map(readback.staging, 0, D3D11_MAP_READ, 0, &mappedResource)))
+        {
+            isSucceeded = false;
+            continue;
+        }
+
+        sSceneTarget const& target     = readback.target;
+        BYTE const*         sourceData = static_cast<BYTE*>(mappedResource.pData);
+        for (UINT y = 0; y < target.height; y++)
+        {
+            memcpy(&target.pixels[y * target.pitch],
+                   &sourceData[y * mappedResource.RowPitch],
+                   target.width * 4);
+        }
+
+        m_deviceContext->Unmap(readback.staging, 0);
+        m_rendererMetrics.readbackBytes->Add((uint64_t)target.height * target.width * 4);
+    }
+
+    m_pendingReadbacks.clear();
+
+    if (isTileReadback && !CompleteTileReadback())
+    {
+        isSucceeded = false;
+    }
+    return isSucceeded;
+}
+
+bool Renderer::IsTileReadbackActive() const
+{
+    // 錄影交出整個鏡像 (交換緩衝區)，每幀都需要完整的場景
+    return m_isTileReadbackEnabled && !m_softwareBackend && m_tileChecksumTargetView && !m_frameRecorder.IsRecording();
+}
+
+void Renderer::SetTileReadbackEnabled(bool const enabled)
+{
+    m_isTileReadbackEnabled = enabled;
+}
+
+void Renderer::UpdateTileCoverage()
+{
+    // 整幀發布到共享記憶體時所有區塊都需要讀回
+    m_tileTracker.ClearCoverage();
+    if (m_frameExporter.IsOpen() && !m_exportDirtyRegionsOnly)
+    {
+        m_tileTracker.CoverAll();
+    }
+    else
+    {
+        for (Window const& window : m_windowList)
+        {
+            if (!window.visibleRegion.IsEmpty()) m_tileTracker.AddCoverage(GetWindowSceneRect(window));
+        }
+    }
+
+    // 窗口露出了鏡像中過期的區塊：GPU 上沒有保留上一次的場景，這一幀重新合成
+    if (m_tileTracker.HasStaleCoverage())
+    {
+        m_layerCompositor.InvalidateComposition();
+    }
+}
+
+bool Renderer::QueueTileReadback()
+{
+    // 場景紋理之後會被其他場景覆寫：先複製一份快照，校驗碼與之後的區塊複製都從快照讀取
+    D3D11_BOX const sceneBox = {0, 0, 0, m_sceneTarget.width, m_sceneTarget.height, 1};
+    m_deviceContext->CopySubresourceRegion(m_tileSourceTexture, 0, 0, 0, 0, m_sceneTexture, 0, &sceneBox);
+
+    TileChecksumConstants const constants = {m_sceneTarget.width, m_sceneTarget.height, {0, 0}};
+    m_deviceContext->UpdateSubresource(m_tileConstantBuffer, 0, nullptr, &constants, 0, 0);
+
+    // 每個區塊一個像素；場景目標的綁定由下一次 BeginScene 恢復
+    UINT const tileCountX = m_tileTracker.GetTileCountX();
+    UINT const tileCountY = m_tileTracker.GetTileCountY();
+    m_deviceContext->OMSetRenderTargets(1, &m_tileChecksumTargetView, nullptr);
+
+    D3D11_VIEWPORT viewport = {};
+    viewport.Width          = (FLOAT)tileCountX;
+    viewport.Height         = (FLOAT)tileCountY;
+    viewport.MinDepth       = 0.f;
+    viewport.MaxDepth       = 1.f;
+    m_deviceContext->RSSetViewports(1, &viewport);
+
+    InvalidateBoundState();
+    BindShaders(m_tileVertexShader, m_tilePixelShader, m_tileInputLayout);
+    BindTexture(m_tileSourceView);
+    BindBlendState(nullptr);
+    m_deviceContext->PSSetConstantBuffers(0, 1, &m_tileConstantBuffer);
+    m_isBoundStateValid = true;
+
+    UINT stride = sizeof(Vertex);
+    UINT offset = 0;
+    m_deviceContext->IASetVertexBuffers(0, 1, &m_vertexBuffer, &stride, &offset);
+    m_deviceContext->IASetIndexBuffer(m_indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+    m_deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    m_deviceContext->DrawIndexed(6, 0, 0);
+
+    D3D11_BOX const tileBox = {0, 0, 0, tileCountX, tileCountY, 1};
+    m_deviceContext->CopySubresourceRegion(m_tileChecksumStaging, 0, 0, 0, 0, m_tileChecksumTexture, 0, &tileBox);
+
+    m_tileReadbackTarget    = m_sceneTarget;
+    m_isTileReadbackPending = true;
+    m_sceneTarget           = sSceneTarget();
+    return true;
+}
+
+bool Renderer::QueueChangedTiles()
+{
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    if (FAILED(m_deviceContext->Map(m_tileChecksumStaging, 0, D3D11_MAP_READ, 0, &mappedResource))) return false;
+
+    // 每個像素的 (總和, XOR) 依位元組順序即為 ComputeTileChecksum 的 64 位元值
+    UINT const tileCountX = m_tileTracker.GetTileCountX();
+    UINT const tileCountY = m_tileTracker.GetTileCountY();
+    m_tileChecksums.resize(m_tileTracker.GetTileCount());
+
+    BYTE const* sourceData = static_cast<BYTE*>(mappedResource.pData);
+    for (UINT y = 0; y < tileCountY; y++)
+    {
+        memcpy(&m_tileChecksums[y * tileCountX], &sourceData[y * mappedResource.RowPitch], tileCountX * sizeof(uint64_t));
+    }
+    m_deviceContext->Unmap(m_tileChecksumStaging, 0);
+
+    // 只複製窗口下有變化的區塊，放在 staging 中與場景相同的位置
+    for (sRect const& tile : m_tileTracker.SetChecksums(m_tileChecksums.data()))
+    {
+        D3D11_BOX const tileBox = {(UINT)tile.left, (UINT)tile.top, 0, (UINT)tile.right, (UINT)tile.bottom, 1};
+        m_deviceContext->CopySubresourceRegion(m_stagingTexture, 0, tileBox.left, tileBox.top, 0, m_tileSourceTexture, 0, &tileBox);
+    }
+    return true;
+}
+
+bool Renderer::CompleteTileReadback()
+{
+    std::vector<sRect> const& tiles  = m_tileTracker.GetChangedTiles();
+    sSceneTarget const&       target = m_tileReadbackTarget;
+
+    // 省記憶體模式沒有 CPU 鏡像：staging 本身就是鏡像，MapScenePixels 時直接讀取
+    if (target.pixels && !tiles.empty())
+    {
+        D3D11_MAPPED_SUBRESOURCE mappedResource;
+        if (FAILED(m_deviceContext->Map(m_stagingTexture, 0, D3D11_MAP_READ, 0, &mappedResource))) return false;
+
+        PatchTiles(target.pixels, target.pitch, static_cast<uint8_t const*>(mappedResource.pData), mappedResource.RowPitch,
+                   tiles.data(), tiles.size());
+        m_deviceContext->Unmap(m_stagingTexture, 0);
+    }
+
+    // 區間的左邊界對齊區塊，寬度換算回區塊數
+    uint64_t copiedTiles = 0;
+    uint64_t copiedBytes = 0;
+    for (sRect const& tile : tiles)
+    {
+        copiedTiles += (tile.GetWidth() + READBACK_TILE_SIZE - 1) / READBACK_TILE_SIZE;
+        copiedBytes += (uint64_t)tile.GetArea() * 4;
+    }
+    m_rendererMetrics.readbackBytes->Add(copiedBytes);
+    m_rendererMetrics.readbackTiles->Add(copiedTiles);
+    m_rendererMetrics.skippedTiles->Add(m_tileTracker.GetTileCount() - copiedTiles);
+
+    m_tileTracker.CommitChangedTiles();
+    m_tileReadbackTarget = sSceneTarget();
+    return true;
+}
+
+ID3D11Texture2D* Renderer::GetReadbackStaging(size_t const slot)
+{
+    if (slot == 0) return m_stagingTexture;
+
+    // 同一幀送出的場景數決定需要幾張，之後的幀重複使用
+    while (m_stagingRing.size() < slot)
+    {
+        ID3D11Texture2D* texture = nullptr;
+        if (FAILED(CreateReadbackTexture(&texture))) return nullptr;
+
+        m_stagingRing.push_back(texture);
+    }
+    return m_stagingRing[slot - 1];
+}
+
+unsigned int Renderer::RegisterSpriteTexture(ID3D11ShaderResourceView* shaderResourceView)
+{
+    if (shaderResourceView) shaderResourceView->AddRef();
+    m_spriteTextures.push_back(shaderResourceView);
+    return (unsigned int)m_spriteTextures.size() - 1;
+}
+
+void Renderer::DrawSprite(sSprite const& sprite)
+{
+    m_spriteBatcher.Draw(sprite);
+}
+
+HRESULT Renderer::EnsureSpriteInstanceCapacity(UINT const instanceCount)
+{
+    if (instanceCount <= m_spriteInstanceCapacity) return S_OK;
+
+    // 以兩倍成長，避免每幀重建緩衝區
+    UINT newCapacity = max(m_spriteInstanceCapacity, 1024u);
+    while (newCapacity < instanceCount)
+    {
+        newCapacity *= 2;
+    }
+
+    if (m_spriteInstanceBuffer)
+    {
+        m_spriteInstanceBuffer->Release();
+        m_spriteInstanceBuffer = nullptr;
+    }
+    m_spriteInstanceCapacity = 0;
+
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.Usage             = D3D11_USAGE_DYNAMIC;
+    bufferDesc.ByteWidth         = newCapacity * sizeof(sSpriteInstance);
+    bufferDesc.BindFlags         = D3D11_BIND_VERTEX_BUFFER;
+    bufferDesc.CPUAccessFlags    = D3D11_CPU_ACCESS_WRITE;
+
+    HRESULT const hr = m_device->CreateBuffer(&bufferDesc, nullptr, &m_spriteInstanceBuffer);
+    if (SUCCEEDED(hr))
+    {
+        m_spriteInstanceCapacity = newCapacity;
+    }
+    return hr;
+}
+
+void Renderer::InvalidateBoundState()
+{
+    m_boundState        = sBoundState();
+    m_isBoundStateValid = false;
+}
+
+void Renderer::BindShaders(ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader, ID3D11InputLayout* inputLayout)
+{
+    if (!m_isBoundStateValid || m_boundState.vertexShader != vertexShader)
+    {
+        m_deviceContext->VSSetShader(vertexShader, nullptr, 0);
+        m_boundState.vertexShader = vertexShader;
+    }
+    if (!m_isBoundStateValid || m_boundState.pixelShader != pixelShader)
+    {
+        m_deviceContext->PSSetShader(pixelShader, nullptr, 0);
+        m_boundState.pixelShader = pixelShader;
+    }
+    if (!m_isBoundStateValid || m_boundState.inputLayout != inputLayout)
+    {
+        m_deviceContext->IASetInputLayout(inputLayout);
+        m_boundState.inputLayout = inputLayout;
+    }
+}
+
+void Renderer::BindTexture(ID3D11ShaderResourceView* texture)
+{
+    if (m_isBoundStateValid && m_boundState.texture == texture) return;
+
+    m_deviceContext->PSSetShaderResources(0, 1, &texture);
+    m_boundState.texture = texture;
+}
+
+void Renderer::BindBlendState(ID3D11BlendState* blendState)
+{
+    if (m_isBoundStateValid && m_boundState.blendState == blendState) return;
+
+    m_deviceContext->OMSetBlendState(blendState, nullptr, 0xFFFFFFFF);
+    m_boundState.blendState = blendState;
+}
+
+void Renderer::DrawFullscreenTexture(unsigned int const textureId)
+{
+    if (textureId >= m_spriteTextures.size()) return;
+
+    DrawFullscreenQuad(m_spriteTextures[textureId], nullptr);
+}
+
+void Renderer::DrawFullscreenQuad(ID3D11ShaderResourceView* texture, ID3D11BlendState* blendState)
+{
+    BindShaders(m_vertexShader, m_pixelShader, m_inputLayout);
+    BindTexture(texture);
+    BindBlendState(blendState);
+    m_deviceContext->PSSetSamplers(0, 1, &m_sampler);
+    m_isBoundStateValid = true;
+
+    UINT stride = sizeof(Vertex);
+    UINT offset = 0;
+    m_deviceContext->IASetVertexBuffers(0, 1, &m_vertexBuffer, &stride, &offset);
+    m_deviceContext->IASetIndexBuffer(m_indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+    m_deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+    m_deviceContext->DrawIndexed(6, 0, 0);
+}
+
+void Renderer::DrawSprites(SpriteBatcher const& batcher)
+{
+    std::vector<sSpriteInstance> const& instances = batcher.GetInstances();
+    if (instances.empty() || !m_spriteVertexShader) return;
+
+    if (FAILED(EnsureSpriteInstanceCapacity((UINT)instances.size()))) return;
+
+    // 每幀整塊重寫實例緩衝區
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    if (FAILED(m_deviceContext->Map(m_spriteInstanceBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource))) return;
+    memcpy(mappedResource.pData, instances.data(), instances.size() * sizeof(sSpriteInstance));
+    m_deviceContext->Unmap(m_spriteInstanceBuffer, 0);
+
+    // 所有批次共用的狀態只設定一次
+    BindShaders(m_spriteVertexShader, m_spritePixelShader, m_spriteInputLayout);
+    BindBlendState(m_spriteBlendState);
+    m_deviceContext->VSSetConstantBuffers(0, 1, &m_spriteConstantBuffer);
+
+    ID3D11Buffer* buffers[] = {m_spriteCornerBuffer, m_spriteInstanceBuffer};
+    UINT          strides[] = {sizeof(SpriteCorner), sizeof(sSpriteInstance)};
+    UINT          offsets[] = {0, 0};
+    m_deviceContext->IASetVertexBuffers(0, 2, buffers, strides, offsets);
+    m_deviceContext->IASetIndexBuffer(m_indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+    m_deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+    // 每個批次只在紋理改變時重新綁定
+    for (sSpriteDrawBatch const& batch : batcher.GetBatches())
+    {
+        if (batch.textureId >= m_spriteTextures.size()) continue;
+
+        BindTexture(m_spriteTextures[batch.textureId]);
+        m_deviceContext->DrawIndexedInstanced(6, batch.instanceCount, 0, 0, batch.firstInstance);
+    }
+
+    // 解除 slot 1，避免下一次繪製測試紋理時殘留實例緩衝區
+    ID3D11Buffer* nullBuffer = nullptr;
+    UINT          zero       = 0;
+    m_deviceContext->IASetVertexBuffers(1, 1, &nullBuffer, &zero, &zero);
+}
+
+HRESULT Renderer::SetBackgroundImage(wchar_t const* filename)
+{
+    m_background.reset();
+    m_layerCompositor.Invalidate(m_backgroundLayer);
+    if (!filename) return S_OK;
+
+    // 不把整張圖解碼到記憶體，只開啟檔案並取得尺寸
+    std::unique_ptr<WicTileSource> source = std::make_unique<WicTileSource>();
+    HRESULT const                  hr     = source->Open(m_wicFactory, filename);
+    if (FAILED(hr)) return hr;
+
+    if (m_backgroundTextureId == INVALID_SCENE_TEXTURE_ID)
+    {
+        m_backgroundTextureId = GetSceneBackend().CreateDynamicSceneTexture(virtualScreenWidth, virtualScreenHeight);
+        if (m_backgroundTextureId == INVALID_SCENE_TEXTURE_ID) return E_FAIL;
 
-    HRESULT hr = m_device->CreateTexture2D(&texDesc, &initData, &m_testTexture);
-    if (FAILED(hr)) return hr;
+        m_backgroundPixels.assign((size_t)virtualScreenWidth * virtualScreenHeight, BACKGROUND_FALLBACK_COLOR);
+    }
 
-    hr = m_device->CreateShaderResourceView(m_testTexture, nullptr, &m_testShaderResourceView);
-    return hr;
+    m_background        = std::make_unique<VirtualTexture>(std::move(source), sVirtualTextureDesc(), &m_threadPool);
+    m_isBackgroundDirty = true;
+    return S_OK;
 }
 
-HRESULT Renderer::CreateShaders()
+void Renderer::SetBackgroundOffset(int const x, int const y)
 {
-    const char* vsSource = R"(
-            struct VS_INPUT {
-                float3 pos : POSITION;
-                float2 tex : TEXCOORD0;
-            };
-
-            struct VS_OUTPUT {
-                float4 pos : SV_POSITION;
-                float2 tex : TEXCOORD0;
-            };
-
-            VS_OUTPUT main(VS_INPUT input) {
-                VS_OUTPUT output;
-                output.pos = float4(input.pos, 1.0f);
-                output.tex = input.tex;
-                return output;
-            }
-        )";
+    if (x == m_backgroundOffsetX && y == m_backgroundOffsetY) return;
 
-    const char* psSource = R"(
-            Texture2D tex : register(t0);
-            SamplerState sam : register(s0);
+    m_backgroundOffsetX = x;
+    m_backgroundOffsetY = y;
+    m_isBackgroundDirty = true;
+}
 
-            struct PS_INPUT {
-                float4 pos : SV_POSITION;
-                float2 tex : TEXCOORD0;
-            };
+void Renderer::UpdateBackground()
+{
+    // 請求所有窗口可見矩形底下的區塊，已完成的解碼在此放入快取
+    m_background->BeginFrame();
+    for (Window const& window : m_windowList)
+    {
+        for (sRect const& visibleRect : window.visibleRegion.GetRects())
+        {
+            sRect const imageRect = OffsetRegionRect(visibleRect, m_backgroundOffsetX, m_backgroundOffsetY);
+            m_background->RequestRegion(imageRect);
+        }
+    }
+    bool const hasNewTiles = m_background->Update() > 0;
 
-            float4 main(PS_INPUT input) : SV_TARGET {
-                return tex.Sample(sam, input.tex);
-            }
-        )";
+    // 只有移動過、可見區域改變或有新區塊時才重新複製並上傳
+    RenderBackend& backend = GetSceneBackend();
+    for (Window const& window : m_windowList)
+    {
+        if (!hasNewTiles && !m_isBackgroundDirty && !window.needsUpdate) continue;
 
-    ID3DBlob* vsBlob    = nullptr;
-    ID3DBlob* psBlob    = nullptr;
-    ID3DBlob* errorBlob = nullptr;
+        for (sRect const& visibleRect : window.visibleRegion.GetRects())
+        {
+            sRect const imageRect = OffsetRegionRect(visibleRect, m_backgroundOffsetX, m_backgroundOffsetY);
+            m_background->CopyRegion(imageRect,
+                                     &m_backgroundPixels[(size_t)visibleRect.top * virtualScreenWidth + visibleRect.left],
+                                     virtualScreenWidth, BACKGROUND_FALLBACK_COLOR);
+            backend.UpdateSceneTexture(m_backgroundTextureId, visibleRect, m_backgroundPixels.data(), virtualScreenWidth);
+            m_layerCompositor.Invalidate(m_backgroundLayer);
+        }
+    }
+    m_isBackgroundDirty = false;
+}
 
-    HRESULT hr = D3DCompile(vsSource, strlen(vsSource), nullptr, nullptr, nullptr,
-                            "main", "vs_4_0", 0, 0, &vsBlob, &errorBlob);
-    if (FAILED(hr))
+void Renderer::DrawSceneLayer(RenderBackend& backend, unsigned int const layerId)
+{
+    if (layerId == m_backgroundLayer)
     {
-        if (errorBlob) errorBlob->Release();
-        return hr;
+        backend.DrawFullscreenTexture(m_background ? m_backgroundTextureId : m_testTextureId);
+    }
+    else if (layerId == m_spriteLayer)
+    {
+        backend.DrawSprites(m_spriteBatcher);
     }
+}
 
-    hr = m_device->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(),
-                                      nullptr, &m_vertexShader);
-    if (FAILED(hr))
+bool Renderer::EnableFrameExport(char const* name, unsigned int const slotCount, bool const dirtyRegionsOnly)
+{
+    m_frameExporter.Close();
+    if (!name) return true;
+
+    // 以最大場景解析度配置，動態解析度改變時不需要重建
+    m_exportDirtyRegionsOnly = dirtyRegionsOnly;
+    return m_frameExporter.Create(name, slotCount, maxSceneWidth, maxSceneHeight);
+}
+
+bool Renderer::MapScenePixels()
+{
+    if (!m_isCompactMemory)
     {
-        vsBlob->Release();
-        return hr;
+        m_scenePixels = pixelData.data();
+        m_scenePitch  = sceneWidth * 4;
+        return true;
     }
 
-    D3D11_INPUT_ELEMENT_DESC layout[] = {
-        {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0}
-    };
+    // 等待 EndScene 送出的複製完成；場景沒有變化時 staging 保留上一幀的內容
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    if (FAILED(m_deviceContext->Map(m_stagingTexture, 0, D3D11_MAP_READ, 0, &mappedResource))) return false;
 
-    hr = m_device->CreateInputLayout(layout, 2, vsBlob->GetBufferPointer(),
-                                     vsBlob->GetBufferSize(), &m_inputLayout);
-    vsBlob->Release();
-    if (FAILED(hr)) return hr;
+    m_scenePixels = static_cast<BYTE const*>(mappedResource.pData);
+    m_scenePitch  = mappedResource.RowPitch;
+    return true;
+}
 
-    hr = D3DCompile(psSource, strlen(psSource), nullptr, nullptr, nullptr,
-                    "main", "ps_4_0", 0, 0, &psBlob, &errorBlob);
-    if (FAILED(hr))
+void Renderer::UnmapScenePixels()
+{
+    // 下一幀的 CopySubresourceRegion 之前必須解除映射
+    if (m_isCompactMemory && m_scenePixels)
     {
-        if (errorBlob) errorBlob->Release();
-        return hr;
+        m_deviceContext->Unmap(m_stagingTexture, 0);
     }
+    m_scenePixels = nullptr;
+    m_scenePitch  = 0;
+}
+
+bool Renderer::EnableCompactMemory()
+{
+    if (m_softwareBackend || !m_stagingTexture || m_frameRecorder.IsRecording()) return false;
 
-    hr = m_device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(),
-                                     nullptr, &m_pixelShader);
-    psBlob->Release();
+    m_isCompactMemory = true;
+    std::vector<BYTE>().swap(pixelData);
 
-    return hr;
+    // staging 還沒有內容 (或是舊解析度的內容，或只有局部回讀過的區塊)，下一幀重新合成
+    m_layerCompositor.InvalidateComposition();
+    m_tileTracker.Reset();
+    return true;
 }
 
-HRESULT Renderer::CreateVertexBuffer()
+void Renderer::GetMemoryReport(sMemoryReport& report) const
 {
-    Vertex vertices[] = {
-        {XMFLOAT3(-1.0f, -1.0f, 0.0f), XMFLOAT2(0.0f, 1.0f)},
-        {XMFLOAT3(-1.0f, 1.0f, 0.0f), XMFLOAT2(0.0f, 0.0f)},
-        {XMFLOAT3(1.0f, 1.0f, 0.0f), XMFLOAT2(1.0f, 0.0f)},
-        {XMFLOAT3(1.0f, -1.0f, 0.0f), XMFLOAT2(1.0f, 1.0f)}
-    };
+    report             = sMemoryReport();
+    report.windowCount = m_windowList.size();
+
+    // 窗口 (與 MemoryReportCheckMain 共用同一個估算)
+    report.Add(eMemoryCategory::Windows, GetWindowMemoryBytes(m_windowList, m_windowIndices, m_updateStates, m_occluders, m_occludersAbove));
+
+    // CPU 上的場景與圖片
+    report.Add(eMemoryCategory::CpuMirrors, pixelData.capacity());
+    report.Add(eMemoryCategory::CpuMirrors, m_backgroundPixels.capacity() * sizeof(uint32_t));
+    if (m_background) report.Add(eMemoryCategory::CpuMirrors, m_background->GetMemoryBytes());
+    if (m_softwareBackend) report.Add(eMemoryCategory::CpuMirrors, m_softwareBackend->GetMemoryBytes());
+    if (m_sceneGroup) report.Add(eMemoryCategory::CpuMirrors, m_sceneGroup->GetMemoryBytes());
+    report.Add(eMemoryCategory::CpuMirrors, m_tileTracker.GetMemoryBytes() + m_tileChecksums.capacity() * sizeof(uint64_t));
+
+    // GPU：場景、staging、圖層目標與場景/精靈紋理 (不含交換鏈)
+    report.Add(eMemoryCategory::GpuTextures, GetTextureBytes(m_sceneTexture));
+    report.Add(eMemoryCategory::GpuTextures, GetTextureBytes(m_stagingTexture));
+    report.Add(eMemoryCategory::GpuTextures, GetTextureBytes(m_tileSourceTexture));
+    for (ID3D11Texture2D* const texture : m_stagingRing)
+    {
+        report.Add(eMemoryCategory::GpuTextures, GetTextureBytes(texture));
+    }
+    for (sLayerTarget const& layer : m_layerTargets)
+    {
+        report.Add(eMemoryCategory::GpuTextures, GetTextureBytes(layer.texture));
+    }
+    for (ID3D11ShaderResourceView* const texture : m_spriteTextures)
+    {
+        report.Add(eMemoryCategory::GpuTextures, GetTextureBytes(texture));
+    }
 
-    D3D11_BUFFER_DESC bufferDesc = {};
-    bufferDesc.Usage             = D3D11_USAGE_DEFAULT;
-    bufferDesc.ByteWidth         = sizeof(vertices);
-    bufferDesc.BindFlags         = D3D11_BIND_VERTEX_BUFFER;
+    // 每幀暫存與飛行記錄器的環
+    sBufferPoolStats const bufferPool = m_frameMemory.GetBufferPool().GetStats();
+    report.Add(eMemoryCategory::TransientBuffers, m_frameMemory.GetStats().capacity);
+    report.Add(eMemoryCategory::TransientBuffers, bufferPool.cachedBytes + bufferPool.outstandingBytes);
+    report.Add(eMemoryCategory::TransientBuffers, m_flightRecorder.GetMemoryBytes());
+}
 
-    D3D11_SUBRESOURCE_DATA initData = {};
-    initData.pSysMem                = vertices;
+void Renderer::PublishFrame()
+{
+    if (!m_exportDirtyRegionsOnly)
+    {
+        m_frameExporter.Publish(m_scenePixels, sceneWidth, sceneHeight, m_scenePitch);
+        return;
+    }
 
-    HRESULT hr = m_device->CreateBuffer(&bufferDesc, &initData, &m_vertexBuffer);
-    if (FAILED(hr)) return hr;
+    // 只發布這一幀要更新到窗口的場景區域 (UpdateWindows 之後 needsUpdate 就會被清除)
+    m_exportDirtyRects.clear();
+    for (Window const& window : m_windowList)
+    {
+        if (!window.needsUpdate || window.visibleRegion.IsEmpty()) continue;
 
-    UINT indices[] = {0, 1, 2, 0, 2, 3};
+        sRect const sceneRect = GetWindowSceneRect(window);
+        if (!sceneRect.IsEmpty()) m_exportDirtyRects.push_back(sceneRect);
+    }
+    m_frameExporter.Publish(m_scenePixels, sceneWidth, sceneHeight, m_scenePitch,
+                            m_exportDirtyRects.data(), (unsigned int)m_exportDirtyRects.size());
+}
 
-    bufferDesc.ByteWidth = sizeof(indices);
-    bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-    initData.pSysMem     = indices;
+bool Renderer::EnableDeterministicMode(uint32_t const seed, float const frameTime, char const* inputLogPath)
+{
+    // 已加入的窗口用的是時間種子，無法重現
+    if (!m_windowList.empty()) return false;
+
+    m_isDeterministic        = true;
+    m_simulationSeed         = seed;
+    m_deterministicFrameTime = frameTime > 0.f ? frameTime : 1.f / 60.f;
+    m_simulationTimestep.Reset();
+
+    if (!inputLogPath) return true;
+
+    sInputLogHeader header;
+    header.seed           = m_simulationSeed;
+    header.frameTime      = m_deterministicFrameTime;
+    header.simulationStep = m_simulationTimestep.GetStep();
+    header.boundsWidth    = virtualScreenWidth;
+    header.boundsHeight   = virtualScreenHeight;
+    return m_inputLog.Open(inputLogPath, header);
+}
 
-    return m_device->CreateBuffer(&bufferDesc, &initData, &m_indexBuffer);
+uint64_t Renderer::GetSimulationChecksum() const
+{
+    uint64_t hash = DRIFT_CHECKSUM_SEED;
+    for (Window const& window : m_windowList)
+    {
+        hash = HashDriftBody(window.body, hash);
+    }
+    return hash;
 }
 
-HRESULT Renderer::CreateSampler()
+bool Renderer::StartRecording(sFrameRecorderDesc const& desc)
 {
-    D3D11_SAMPLER_DESC samplerDesc = {};
-    samplerDesc.Filter             = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
-    samplerDesc.AddressU           = D3D11_TEXTURE_ADDRESS_WRAP;
-    samplerDesc.AddressV           = D3D11_TEXTURE_ADDRESS_WRAP;
-    samplerDesc.AddressW           = D3D11_TEXTURE_ADDRESS_WRAP;
-    samplerDesc.ComparisonFunc     = D3D11_COMPARISON_NEVER;
-    samplerDesc.MinLOD             = 0;
-    samplerDesc.MaxLOD             = D3D11_FLOAT32_MAX;
+    // 錄影以交換 pixelData 的方式交出整幀，省記憶體模式沒有可交換的鏡像
+    if (m_isCompactMemory) return false;
 
-    return m_device->CreateSamplerState(&samplerDesc, &m_sampler);
+    // 以最大場景預先配置，動態解析度改變時交換回來的緩衝區也不必重新配置
+    sFrameRecorderDesc recorderDesc = desc;
+    recorderDesc.frameBytes         = (size_t)maxSceneWidth * maxSceneHeight * 4;
+    return m_frameRecorder.Start(recorderDesc);
 }
 
-void Renderer::RenderTestTexture() const
+void Renderer::StopRecording()
 {
-    m_deviceContext->VSSetShader(m_vertexShader, nullptr, 0);
-    m_deviceContext->PSSetShader(m_pixelShader, nullptr, 0);
-    m_deviceContext->IASetInputLayout(m_inputLayout);
+    m_frameRecorder.Stop();
+}
 
-    m_deviceContext->PSSetShaderResources(0, 1, &m_testShaderResourceView);
-    m_deviceContext->PSSetSamplers(0, 1, &m_sampler);
+void Renderer::RecordFrame()
+{
+    // 每個可見窗口在場景中看到的區域，與場景一起寫入
+    m_recordWindowRects.clear();
+    for (Window const& window : m_windowList)
+    {
+        if (window.visibleRegion.IsEmpty()) continue;
 
-    UINT stride = sizeof(Vertex);
-    UINT offset = 0;
-    m_deviceContext->IASetVertexBuffers(0, 1, &m_vertexBuffer, &stride, &offset);
-    m_deviceContext->IASetIndexBuffer(m_indexBuffer, DXGI_FORMAT_R32_UINT, 0);
-    m_deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        sRect const sceneRect = GetWindowSceneRect(window);
+        if (!sceneRect.IsEmpty()) m_recordWindowRects.push_back(sceneRect);
+    }
 
-    m_deviceContext->DrawIndexed(6, 0, 0);
+    // 緩衝區用完時依丟幀策略放棄這一幀，不等待寫檔
+    m_frameRecorder.SubmitFrame(pixelData, sceneWidth, sceneHeight,
+                                m_recordWindowRects.data(), (unsigned int)m_recordWindowRects.size());
 }
 
 void Renderer::UpdateWindows()
@@ -719,34 +2375,112 @@ void Renderer::UpdateWindows()
     //
     // if (!needsUpdate) return;
 
-    D3D11_MAPPED_SUBRESOURCE mappedResource;
-    HRESULT const            hr = m_deviceContext->Map(m_stagingTexture, 0, D3D11_MAP_READ, 0, &mappedResource);
-    if (FAILED(hr)) return;
+    LARGE_INTEGER updateStart;
+    QueryPerformanceCounter(&updateStart);
 
-    BYTE const* sourceData = static_cast<BYTE*>(mappedResource.pData);
-    for (UINT y = 0; y < sceneHeight; y++)
+    // 依面積、速度、焦點與可見性決定每個窗口本幀是否更新
+    HWND const foregroundWindow = GetForegroundWindow();
+    m_updateStates.clear();
+
+    for (Window& window : m_windowList)
     {
-        memcpy(&pixelData[y * sceneWidth * 4],
-               &sourceData[y * mappedResource.RowPitch],
-               sceneWidth * 4);
+        sUpdateState& state = window.updateState;
+        state.visibleArea   = window.visibleRegion.GetArea();
+        state.speed         = sqrt(window.body.drift.velocityX * window.body.drift.velocityX +
+                                   window.body.drift.velocityY * window.body.drift.velocityY);
+        state.isFocused     = (HWND)window.m_windowHandle == foregroundWindow || window.body.isDragging;
+        state.isDirty       = window.needsUpdate;
+        m_updateStates.push_back(&state);
     }
 
-    m_deviceContext->Unmap(m_stagingTexture, 0);
+    m_updateScheduler.Schedule(m_updateStates);
 
     for (Window& window : m_windowList)
     {
-        if (window.needsUpdate)
+        if (window.updateState.shouldUpdate)
         {
             RenderViewportToWindow(window);
             window.needsUpdate = false;
         }
     }
+
+    LARGE_INTEGER updateEnd;
+    QueryPerformanceCounter(&updateEnd);
+    m_rendererMetrics.updateWindowsTime->Record(ElapsedNanoseconds(updateStart, updateEnd, m_performanceFrequency));
 }
 
-void Renderer::RenderViewportToWindow(Window const& window) const
+int Renderer::FindWindowIndex(HWND const hwnd) const
 {
-    if (!window.m_displayContext) return;
+    auto const found = m_windowIndices.find(hwnd);
+    return found != m_windowIndices.end() ? (int)found->second : -1;
+}
+
+void Renderer::CollectOccluders()
+{
+    m_occluders.clear();
+    m_occludersAbove.assign(m_windowList.size(), 0);
+    EnumWindows(CollectOccluder, reinterpret_cast<LPARAM>(this));
+}
+
+// EnumWindows 依 Z 順序由上到下列舉頂層窗口；自己的窗口先記下上方有多少遮擋者，再加入清單
+BOOL CALLBACK Renderer::CollectOccluder(HWND const hwnd, LPARAM const param)
+{
+    Renderer& renderer = *reinterpret_cast<Renderer*>(param);
+
+    int const index = renderer.FindWindowIndex(hwnd);
+    if (index >= 0) renderer.m_occludersAbove[index] = renderer.m_occluders.size();
+
+    if (IsWindowVisible(hwnd) && !IsIconic(hwnd) && !IsWindowCloaked(hwnd))
+    {
+        renderer.m_occluders.push_back(GetOccluderRect(hwnd));
+    }
+    return TRUE;
+}
 
+void Renderer::UpdateWindowVisibility(Window& window, size_t const occludersAbove)
+{
+    HWND const hwnd = (HWND)window.m_windowHandle;
+
+    RECT clientRect;
+    GetClientRect(hwnd, &clientRect);
+    POINT clientOrigin = {0, 0};
+    ClientToScreen(hwnd, &clientOrigin);
+
+    OffsetRect(&clientRect, clientOrigin.x, clientOrigin.y);
+    window.clientScreenRect = ToRegionRect(clientRect);
+
+    // 超出螢幕的部分不需要繪製 (重複使用同一個 Region，每幀不配置記憶體)
+    Region& visible = m_visibleScratch;
+    visible.Assign(window.clientScreenRect);
+    visible.Intersect({0, 0, virtualScreenWidth, virtualScreenHeight});
+
+    // 最小化的窗口完全不可見
+    if (IsIconic(hwnd))
+    {
+        visible.Clear();
+    }
+
+    // 扣除所有蓋在此窗口上方的可見窗口 (清單每幀由 CollectOccluders 建立一次)
+    for (size_t i = 0; i < occludersAbove && !visible.IsEmpty(); ++i)
+    {
+        if (m_occluders[i].Overlaps(window.clientScreenRect)) visible.Subtract(m_occluders[i]);
+    }
+
+    visible.Coalesce();
+
+    // 被遮擋的部分重新露出時也需要重繪
+    if (visible != window.visibleRegion)
+    {
+        window.visibleRegion = visible;
+        if (!visible.IsEmpty())
+        {
+            window.needsUpdate = true;
+        }
+    }
+}
+
+sRect Renderer::GetWindowSceneRect(Window const& window) const
+{
     // 計算在場景紋理中的區域
     int srcX      = (int)round(window.viewportX * sceneWidth);
     int srcY      = (int)round(window.viewportY * sceneHeight);
@@ -759,38 +2493,192 @@ void Renderer::RenderViewportToWindow(Window const& window) const
     srcWidth  = min(srcWidth, (int)sceneWidth - srcX);
     srcHeight = min(srcHeight, (int)sceneHeight - srcY);
 
-    if (srcWidth <= 0 || srcHeight <= 0) return;
+    if (srcWidth <= 0 || srcHeight <= 0) return sRect();
+    return {srcX, srcY, srcX + srcWidth, srcY + srcHeight};
+}
 
-    // 創建臨時的 DIB 數據
-    std::vector<BYTE> windowPixels(srcWidth * srcHeight * 4);
+void Renderer::RenderViewportToWindow(Window const& window)
+{
+    if (!window.m_displayContext) return;
+    if (window.visibleRegion.IsEmpty()) return;     // 完全被遮擋或在螢幕外
+    if (window.width <= 0 || window.height <= 0) return;
 
-    for (int y = 0; y < srcHeight; y++)
+    sRect const sceneRect = GetWindowSceneRect(window);
+    if (sceneRect.IsEmpty()) return;
+
+    LARGE_INTEGER blitStart;
+    QueryPerformanceCounter(&blitStart);
+
+    int const srcX      = sceneRect.left;
+    int const srcY      = sceneRect.top;
+    int const srcWidth  = sceneRect.GetWidth();
+    int const srcHeight = sceneRect.GetHeight();
+
+    // 只繪製可見的矩形，每個矩形對應場景紋理中的一塊子區域
+    FrameArena& arena = m_frameMemory.GetArena();
+    for (sRect const& visibleRect : window.visibleRegion.GetRects())
+    {
+        // 轉換為客戶區座標
+        int const dstLeft   = visibleRect.left - window.clientScreenRect.left;
+        int const dstTop    = visibleRect.top - window.clientScreenRect.top;
+        int const dstRight  = visibleRect.right - window.clientScreenRect.left;
+        int const dstBottom = visibleRect.bottom - window.clientScreenRect.top;
+
+        // 依窗口到場景區域的縮放比例換算來源範圍 (起點向下、終點向上取整，避免接縫)
+        int const subLeft   = (int)floor((double)dstLeft * srcWidth / window.width);
+        int const subTop    = (int)floor((double)dstTop * srcHeight / window.height);
+        int const subRight  = min(srcWidth, (int)ceil((double)dstRight * srcWidth / window.width));
+        int const subBottom = min(srcHeight, (int)ceil((double)dstBottom * srcHeight / window.height));
+        int const subWidth  = subRight - subLeft;
+        int const subHeight = subBottom - subTop;
+
+        if (subWidth <= 0 || subHeight <= 0) continue;
+
+        // 臨時的 DIB 數據放在本幀的 arena，每個矩形用完即退回
+        FrameArenaScope const scope(arena);
+        BYTE* const           windowPixels = arena.AllocateArray<BYTE>((size_t)subWidth * subHeight * 4);
+
+        BYTE const* const source = m_scenePixels + (size_t)(srcY + subTop) * m_scenePitch + (size_t)(srcX + subLeft) * 4;
+        for (int y = 0; y < subHeight; y++)
+        {
+            memcpy(&windowPixels[(size_t)y * subWidth * 4],
+                   source + (size_t)y * m_scenePitch,
+                   subWidth * 4);
+        }
+
+        // 設置 DIB 信息
+        sSceneBitmapInfo localBitmapInfo = bitmapInfo;
+        localBitmapInfo.header.biWidth   = subWidth;
+        localBitmapInfo.header.biHeight  = -subHeight;
+
+        // 使用 StretchDIBits 來縮放顯示
+        StretchDIBits(
+            (HDC)window.m_displayContext,
+            dstLeft, dstTop,                                    // 目標位置
+            dstRight - dstLeft, dstBottom - dstTop,             // 目標大小
+            0, 0,                                               // 源起始位置
+            subWidth, subHeight,                                // 源大小
+            windowPixels,                                       // 像素數據
+            reinterpret_cast<BITMAPINFO const*>(&localBitmapInfo), // DIB 信息
+            DIB_RGB_COLORS,                                     // 顏色模式
+            SRCCOPY                                             // 複製模式
+        );
+    }
+
+    LARGE_INTEGER blitEnd;
+    QueryPerformanceCounter(&blitEnd);
+    m_rendererMetrics.windowBlitTime->Record(ElapsedNanoseconds(blitStart, blitEnd, m_performanceFrequency));
+    m_rendererMetrics.windowBlits->Add();
+    m_rendererMetrics.windowBlitPixels->Add((uint64_t)window.visibleRegion.GetArea());
+}
+
+unsigned int Renderer::CreateScene(sSceneDesc const& desc)
+{
+    // D3D11 的場景都畫在同一張場景紋理上，不能超過它的大小
+    sSceneDesc clampedDesc = desc;
+    clampedDesc.width      = max(1u, min(desc.width, maxSceneWidth));
+    clampedDesc.height     = max(1u, min(desc.height, maxSceneHeight));
+    return m_sceneGroup->CreateScene(clampedDesc).GetId();
+}
+
+unsigned int Renderer::CreateSceneContent(uint32_t const* pixels, unsigned int const width, unsigned int const height)
+{
+    return GetSceneBackend().CreateSceneTexture(pixels, width, height);
+}
+
+bool Renderer::AddSceneWindow(unsigned int const sceneId, HWND const hwnd)
+{
+    Scene* const scene = m_sceneGroup ? m_sceneGroup->FindScene(sceneId) : nullptr;
+    if (!scene || !hwnd) return false;
+
+    scene->AddView((uintptr_t)hwnd, (uintptr_t)GetDC(hwnd));
+    return true;
+}
+
+void Renderer::UpdateSceneViews()
+{
+    // 每個場景都覆蓋整個虛擬螢幕：窗口客戶區在螢幕上的位置依比例換算到場景座標 (可能超出場景，呈現時再裁切)
+    for (unsigned int sceneId = 0; sceneId < m_sceneGroup->GetSceneCount(); ++sceneId)
     {
-        int srcRowIndex = (srcY + y) * sceneWidth + srcX;
-        int dstRowIndex = y * srcWidth;
+        Scene&                         scene = *m_sceneGroup->FindScene(sceneId);
+        sSceneDesc const&              desc  = scene.GetDesc();
+        std::vector<sSceneView> const& views = scene.GetViews();
+
+        double const scaleX = (double)desc.width / virtualScreenWidth;
+        double const scaleY = (double)desc.height / virtualScreenHeight;
+        for (size_t i = 0; i < views.size(); ++i)
+        {
+            HWND const hwnd = (HWND)views[i].handle;
+            if (IsIconic(hwnd))
+            {
+                scene.SetViewRect(i, sRect(), 0, 0);
+                continue;
+            }
+
+            RECT clientRect;
+            GetClientRect(hwnd, &clientRect);
+            POINT clientOrigin = {0, 0};
+            ClientToScreen(hwnd, &clientOrigin);
+
+            int const width  = clientRect.right - clientRect.left;
+            int const height = clientRect.bottom - clientRect.top;
+
+            sRect source;
+            source.left   = (int)floor(clientOrigin.x * scaleX);
+            source.top    = (int)floor(clientOrigin.y * scaleY);
+            source.right  = (int)ceil((clientOrigin.x + width) * scaleX);
+            source.bottom = (int)ceil((clientOrigin.y + height) * scaleY);
+            scene.SetViewRect(i, source, width, height);
+        }
+    }
+}
 
-        memcpy(&windowPixels[dstRowIndex * 4],
-               &pixelData[srcRowIndex * 4],
+void Renderer::PresentSceneView(Scene const& scene, sSceneView const& view)
+{
+    // 在工作執行緒上執行：只讀取場景鏡像與 bitmapInfo，暫存放在這個執行緒自己的 arena
+    sSceneDesc const& desc   = scene.GetDesc();
+    sRect const       source = view.source.Intersect({0, 0, (int)desc.width, (int)desc.height});
+    if (source.IsEmpty()) return;
+
+    LARGE_INTEGER blitStart;
+    QueryPerformanceCounter(&blitStart);
+
+    // 超出場景 (螢幕) 的部分不畫，目的範圍依比例裁切
+    double const scaleX    = (double)view.width / view.source.GetWidth();
+    double const scaleY    = (double)view.height / view.source.GetHeight();
+    int const    dstLeft   = (int)floor((source.left - view.source.left) * scaleX);
+    int const    dstTop    = (int)floor((source.top - view.source.top) * scaleY);
+    int const    dstRight  = (int)ceil((source.right - view.source.left) * scaleX);
+    int const    dstBottom = (int)ceil((source.bottom - view.source.top) * scaleY);
+    int const    srcWidth  = source.GetWidth();
+    int const    srcHeight = source.GetHeight();
+
+    FrameArena&           arena = m_frameMemory.GetArena();
+    FrameArenaScope const scope(arena);
+    BYTE* const           viewPixels = arena.AllocateArray<BYTE>((size_t)srcWidth * srcHeight * 4);
+
+    BYTE const* const sceneSource = scene.GetPixels() + (size_t)source.top * scene.GetPitch() + (size_t)source.left * 4;
+    for (int y = 0; y < srcHeight; y++)
+    {
+        memcpy(&viewPixels[(size_t)y * srcWidth * 4],
+               sceneSource + (size_t)y * scene.GetPitch(),
                srcWidth * 4);
     }
 
-    // 設置 DIB 信息
-    BITMAPINFO localBitmapInfo         = bitmapInfo;
-    localBitmapInfo.bmiHeader.biWidth  = srcWidth;
-    localBitmapInfo.bmiHeader.biHeight = -srcHeight;
-
-    // 使用 StretchDIBits 來縮放顯示
-    StretchDIBits(
-        (HDC)window.m_displayContext,
-        0, 0,                          // 目標位置
-        window.width, window.height,   // 目標大小 (縮放到窗口大小)
-        0, 0,                          // 源起始位置
-        srcWidth, srcHeight,           // 源大小
-        windowPixels.data(),           // 像素數據
-        &localBitmapInfo,              // DIB 信息
-        DIB_RGB_COLORS,                // 顏色模式
-        SRCCOPY                        // 複製模式
-    );
+    sSceneBitmapInfo localBitmapInfo = bitmapInfo;
+    localBitmapInfo.header.biWidth   = srcWidth;
+    localBitmapInfo.header.biHeight  = -srcHeight;
+
+    StretchDIBits((HDC)view.context,
+                  dstLeft, dstTop, dstRight - dstLeft, dstBottom - dstTop,
+                  0, 0, srcWidth, srcHeight,
+                  viewPixels, reinterpret_cast<BITMAPINFO const*>(&localBitmapInfo), DIB_RGB_COLORS, SRCCOPY);
+
+    LARGE_INTEGER blitEnd;
+    QueryPerformanceCounter(&blitEnd);
+    m_rendererMetrics.windowBlitTime->Record(ElapsedNanoseconds(blitStart, blitEnd, m_performanceFrequency));
+    m_rendererMetrics.windowBlits->Add();
+    m_rendererMetrics.windowBlitPixels->Add((uint64_t)(dstRight - dstLeft) * (dstBottom - dstTop));
 }
 
 void Renderer::Cleanup()
@@ -799,8 +2687,88 @@ void Renderer::Cleanup()
     {
         if (window.m_displayContext) ReleaseDC((HWND)window.m_windowHandle, (HDC)window.m_displayContext);
     }
+    for (unsigned int sceneId = 0; m_sceneGroup && sceneId < m_sceneGroup->GetSceneCount(); ++sceneId)
+    {
+        for (sSceneView const& view : m_sceneGroup->FindScene(sceneId)->GetViews())
+        {
+            if (view.context) ReleaseDC((HWND)view.handle, (HDC)view.context);
+        }
+    }
+    m_sceneGroup.reset();
+
+    // 寫完排隊中的錄影幀、輸入記錄與突波後還在等待的飛行記錄；等待背景區塊解碼結束，WIC 物件要在工廠之前釋放
+    m_frameRecorder.Stop();
+    m_inputLog.Close();
+    m_flightRecorder.Flush();
+    m_background.reset();
+    m_softwareBackend.reset();
+    ReleaseDeviceResources();
+
+    // **這個是你缺少的：釋放 WIC 工廠**
+    if (m_wicFactory)
+    {
+        m_wicFactory->Release();
+        m_wicFactory = nullptr;
+    }
+}
 
+void Renderer::ReleaseDeviceResources()
+{
     // 釋放所有 D3D11 和相關對象
+    for (sLayerTarget& layer : m_layerTargets)
+    {
+        ReleaseLayerTarget(layer);
+    }
+    m_layerTargets.clear();
+
+    if (m_layerBlendState)
+    {
+        m_layerBlendState->Release();
+        m_layerBlendState = nullptr;
+    }
+
+    for (ID3D11ShaderResourceView* texture : m_spriteTextures)
+    {
+        if (texture) texture->Release();
+    }
+    m_spriteTextures.clear();
+
+    if (m_spriteBlendState)
+    {
+        m_spriteBlendState->Release();
+        m_spriteBlendState = nullptr;
+    }
+    if (m_spriteConstantBuffer)
+    {
+        m_spriteConstantBuffer->Release();
+        m_spriteConstantBuffer = nullptr;
+    }
+    if (m_spriteInstanceBuffer)
+    {
+        m_spriteInstanceBuffer->Release();
+        m_spriteInstanceBuffer = nullptr;
+    }
+    m_spriteInstanceCapacity = 0;
+    if (m_spriteCornerBuffer)
+    {
+        m_spriteCornerBuffer->Release();
+        m_spriteCornerBuffer = nullptr;
+    }
+    if (m_spriteInputLayout)
+    {
+        m_spriteInputLayout->Release();
+        m_spriteInputLayout = nullptr;
+    }
+    if (m_spritePixelShader)
+    {
+        m_spritePixelShader->Release();
+        m_spritePixelShader = nullptr;
+    }
+    if (m_spriteVertexShader)
+    {
+        m_spriteVertexShader->Release();
+        m_spriteVertexShader = nullptr;
+    }
     if (m_sampler)
     {
         m_sampler->Release();
@@ -831,21 +2799,63 @@ void Renderer::Cleanup()
         m_vertexShader->Release();
         m_vertexShader = nullptr;
     }
-    if (m_testShaderResourceView)
+    if (m_stagingTexture)
     {
-        m_testShaderResourceView->Release();
-        m_testShaderResourceView = nullptr;
+        m_stagingTexture->Release();
+        m_stagingTexture = nullptr;
     }
-    if (m_testTexture)
+    for (ID3D11Texture2D* texture : m_stagingRing)
     {
-        m_testTexture->Release();
-        m_testTexture = nullptr;
+        texture->Release();
     }
-    if (m_stagingTexture)
+    m_stagingRing.clear();
+    m_pendingReadbacks.clear();
+    if (m_tileConstantBuffer)
     {
-        m_stagingTexture->Release();
-        m_stagingTexture = nullptr;
+        m_tileConstantBuffer->Release();
+        m_tileConstantBuffer = nullptr;
+    }
+    if (m_tileChecksumStaging)
+    {
+        m_tileChecksumStaging->Release();
+        m_tileChecksumStaging = nullptr;
+    }
+    if (m_tileChecksumTargetView)
+    {
+        m_tileChecksumTargetView->Release();
+        m_tileChecksumTargetView = nullptr;
+    }
+    if (m_tileChecksumTexture)
+    {
+        m_tileChecksumTexture->Release();
+        m_tileChecksumTexture = nullptr;
+    }
+    if (m_tileSourceView)
+    {
+        m_tileSourceView->Release();
+        m_tileSourceView = nullptr;
+    }
+    if (m_tileSourceTexture)
+    {
+        m_tileSourceTexture->Release();
+        m_tileSourceTexture = nullptr;
+    }
+    if (m_tileInputLayout)
+    {
+        m_tileInputLayout->Release();
+        m_tileInputLayout = nullptr;
+    }
+    if (m_tilePixelShader)
+    {
+        m_tilePixelShader->Release();
+        m_tilePixelShader = nullptr;
+    }
+    if (m_tileVertexShader)
+    {
+        m_tileVertexShader->Release();
+        m_tileVertexShader = nullptr;
     }
+    m_isTileReadbackPending = false;
     if (m_sceneShaderResourceView)
     {
         m_sceneShaderResourceView->Release();
@@ -882,13 +2892,6 @@ void Renderer::Cleanup()
         m_mainSwapChain = nullptr;
     }
 
-    // **這個是你缺少的：釋放 WIC 工廠**
-    if (m_wicFactory)
-    {
-        m_wicFactory->Release();
-        m_wicFactory = nullptr;
-    }
-
     // 最後釋放 device
     if (m_device)
     {
@@ -4,12 +4,35 @@
 
 //----------------------------------------------------------------------------------------------------
 #pragma once
+#include <memory>
+#include <unordered_map>
 #include <vector>
 #include <windows.h>
 
+#include "DragInput.hpp"
+#include "FlightRecorder.hpp"
+#include "FrameArena.hpp"
+#include "FrameExport.hpp"
+#include "FrameRecorder.hpp"
+#include "InputLog.hpp"
+#include "LayerCompositor.hpp"
+#include "MemoryReport.hpp"
+#include "Metrics.hpp"
+#include "MetricsServer.hpp"
+#include "MpscQueue.hpp"
+#include "RenderBackend.hpp"
+#include "ResolutionController.hpp"
+#include "SceneGroup.hpp"
+#include "ShaderCache.hpp"
+#include "ShaderRegistry.hpp"
+#include "SpriteBatch.hpp"
+#include "ThreadPool.hpp"
+#include "TileReadback.hpp"
+#include "UpdateScheduler.hpp"
+#include "VirtualTexture.hpp"
+
 //-Forward-Declaration--------------------------------------------------------------------------------
 class Window;
-struct sDriftParams;
 struct ID3D11Texture2D;
 struct ID3D11Device;
 struct ID3D11DeviceContext;
@@ -21,22 +44,59 @@ struct ID3D11Buffer;
 struct ID3D11InputLayout;
 struct ID3D11SamplerState;
 struct ID3D11ShaderResourceView;
+struct ID3D11BlendState;
+struct D3D11_TEXTURE2D_DESC;
+struct D3D11_SUBRESOURCE_DATA;
 struct IWICImagingFactory;
+class SoftwareRenderBackend;
+
+//----------------------------------------------------------------------------------------------------
+enum class eWindowCommand : uint8_t
+{
+    SetDriftParams,
+    StartDragging,
+    StopDragging,
+    UpdateDragging,
+    AddWindow
+};
+
+// 由其他執行緒送到渲染執行緒的控制命令；未使用的欄位忽略
+// timeNanoseconds 為送出時的 QueryPerformanceCounter (換算為奈秒)，拖拽放開時用來估算速度
+struct sWindowCommand
+{
+    eWindowCommand type            = eWindowCommand::SetDriftParams;
+    HWND           hwnd            = nullptr;
+    long long      timeNanoseconds = 0;
+    POINT          mousePos{};
+    sDriftParams   params;
+};
 
-class Renderer
+// 場景鏡像是 RGBA8 (R 在最低位元組)，以 BI_BITFIELDS 的遮罩告訴 GDI 通道位置，不需要逐像素交換
+struct sSceneBitmapInfo
+{
+    BITMAPINFOHEADER header;
+    DWORD            masks[3];      // R、G、B
+};
+
+//----------------------------------------------------------------------------------------------------
+// 場景由 D3D11 (本類別實作的 RenderBackend) 或 SoftwareRenderBackend 產生，之後的窗口分發流程相同
+class Renderer : public RenderBackend
 {
 public:
     Renderer();
-    ~Renderer();
+    ~Renderer() override;
 
-    HRESULT Initialize(HWND const& hiddenMainWindow);
-    HRESULT LoadImageFromFile(wchar_t const* filename, ID3D11Texture2D** texture, ID3D11ShaderResourceView** srv) const;
+    // useSoftwareRenderer 為 true 或無法建立 D3D11 裝置時改用 CPU 渲染
+    HRESULT Initialize(HWND const& hiddenMainWindow, bool useSoftwareRenderer = false);
+    HRESULT LoadImageFromFile(wchar_t const* filename, BufferPool::Buffer& pixels, UINT& width, UINT& height);
     void    SetWindowDriftParams(HWND hwnd, const sDriftParams& params);
     void    StartDragging(HWND hwnd, POINT const& mousePos);
-    void    StopDragging(HWND hwnd);
-    void    UpdateDragging(HWND hwnd, POINT const& mousePos) const;
-    void    UpdateWindowDrift(Window& window) const;
+    void    StopDragging(HWND hwnd, float velocityX, float velocityY);     // 速度為放開時的滑鼠速度 (像素/秒)
+    void    UpdateDragging(HWND hwnd, POINT const& mousePos);               // 只更新模擬，窗口在這一幀的批次移動中移動
+    void    SyncWindowDrift(Window& window) const;                  // 漂移前：以系統上的位置與大小為準
+    bool    ApplyWindowDrift(Window& window, float alpha) const;    // 漂移後：記下內插的位置，回傳是否需要移動窗口
     HRESULT AddWindow(HWND const& hwnd);
+    HRESULT AddWindows(HWND const* windows, size_t count);     // 一次預留空間後依序加入，nullptr 略過
     void    UpdateWindowPosition(Window& window) const;
     void    Render();
     HRESULT CreateDeviceAndSwapChain();
@@ -46,12 +106,206 @@ public:
     HRESULT CreateShaders();
     HRESULT CreateVertexBuffer();
     HRESULT CreateSampler();
+    HRESULT CreateSpriteResources();
+    HRESULT CreateTileChecksumResources();
+
+    // 執行緒安全版本：任何執行緒都可呼叫，命令放入無鎖佇列，下一幀開始時由渲染執行緒依送出順序套用
+    // 同一窗口一幀內連續的拖拽移動只套用最後一個 (見 DragInputCoalescer)；佇列滿時立即回傳 false，不等待
+    bool PostSetWindowDriftParams(HWND hwnd, sDriftParams const& params);
+    bool PostStartDragging(HWND hwnd, POINT const& mousePos);
+    bool PostStopDragging(HWND hwnd);
+    bool PostUpdateDragging(HWND hwnd, POINT const& mousePos);
+    bool PostAddWindow(HWND hwnd);
+    bool PostCommand(sWindowCommand const& command);
+
+    // 超大背景圖：只串流窗口看得到的區塊，取代測試紋理；filename 為 nullptr 時關閉
+    // 圖片座標 = 螢幕座標 + offset
+    HRESULT SetBackgroundImage(wchar_t const* filename);
+    void    SetBackgroundOffset(int x, int y);
+
+    // 每幀將場景發布到具名共享記憶體，供其他行程讀取 (見 FrameExportReader)；name 為 nullptr 時關閉
+    // dirtyRegionsOnly 為 true 時只複製需要更新到窗口的場景區域
+    bool EnableFrameExport(char const* name, unsigned int slotCount = 3, bool dirtyRegionsOnly = false);
+
+    // 錄影：場景分發到窗口之後，CPU 鏡像整塊交給錄影器 (交換緩衝區，不複製)，編碼與寫檔在背景執行緒
+    bool StartRecording(sFrameRecorderDesc const& desc);
+    void StopRecording();
+
+    // 決定性模式 (跨版本比較效能用)：窗口的種子由 seed 決定、每幀視為經過 frameTime 秒，位置以模擬為準不讀回系統
+    // inputLogPath 不為 nullptr 時記錄所有輸入與每幀的狀態校驗碼，可由 ReplayInputLog 無頭重現；必須在 AddWindow 之前呼叫
+    bool     EnableDeterministicMode(uint32_t seed, float frameTime, char const* inputLogPath = nullptr);
+    uint64_t GetSimulationChecksum() const;
+
+    // 執行中的指標 (幀時間、窗口繪製延遲、回讀量...)：以 Prometheus 文字格式開放給本機讀取，port 為 0 時由系統分配
+    bool     StartMetricsEndpoint(uint16_t port);
+    void     StopMetricsEndpoint() { m_metricsServer.Stop(); }
+    uint16_t GetMetricsEndpointPort() const { return m_metricsServer.GetPort(); }
+
+    // 其他模組可以在啟動時加入自己的指標
+    MetricsRegistry& GetMetrics() { return m_metrics; }
+
+    // 各子系統目前持有的記憶體；每幀也會更新到 mwf_memory_<類別>_bytes 指標
+    void GetMemoryReport(sMemoryReport& report) const;
+
+    // 省記憶體模式：不保留場景的 CPU 鏡像，窗口直接讀取映射中的 staging 紋理 (1080p 省下約 8MB)
+    // 只適用於 D3D11 (軟體渲染直接畫在鏡像上)，啟用後不能錄影；必須在 Initialize 之後呼叫
+    bool EnableCompactMemory();
+    bool IsCompactMemory() const { return m_isCompactMemory; }
+
+    // 局部回讀 (預設開啟，只適用於 D3D11)：主場景先在 GPU 上計算每個 64x64 區塊的校驗碼並讀回，
+    // 只有校驗碼改變且在某個窗口下的區塊才複製到 CPU 鏡像 (省記憶體模式下為 staging 紋理)；錄影時每幀讀回整個場景
+    void SetTileReadbackEnabled(bool enabled);
+    bool IsTileReadbackEnabled() const { return m_isTileReadbackEnabled; }
+
+    // 常駐的飛行記錄器 (預設開啟)：每幀的階段時間、窗口數與回讀量放在固定的環中，幀時間超過門檻時把前後幾秒寫到檔案
+    // 訊息處理不在 Render 內：主循環在處理訊息之前呼叫 BeginMessagePump，到下一次 Render 開始的時間記為 messages 階段
+    void ConfigureFlightRecorder(sFlightRecorderDesc const& desc) { m_flightRecorder.Configure(desc); }
+    void BeginMessagePump();
+
+    // 主場景之外的獨立場景：各自的內容、解析度與窗口，與主場景共用裝置、shader、取樣器與 staging 紋理
+    // 回讀與主場景在同一個同步點完成，窗口的呈現分散到共用的執行緒池；必須在 Initialize 之後呼叫
+    unsigned int CreateScene(sSceneDesc const& desc);      // 回傳場景編號；解析度限制在最大場景解析度以內
+    unsigned int CreateSceneContent(uint32_t const* pixels, unsigned int width, unsigned int height);  // 多個場景可以共用
+    bool         AddSceneWindow(unsigned int sceneId, HWND hwnd);   // 窗口顯示場景中對應其螢幕位置的部分，不參與漂移
+
+    // 建置後步驟：編譯所有內建 shader 並寫成 pack，啟動時直接載入
+    static bool BuildShaderPack(char const* path = nullptr);
+
+    // RenderBackend (D3D11)
+    unsigned int CreateSceneTexture(uint32_t const* pixels, unsigned int width, unsigned int height) override;
+    unsigned int CreateDynamicSceneTexture(unsigned int width, unsigned int height) override;
+    void         UpdateSceneTexture(unsigned int textureId, sRect const& rect, uint32_t const* pixels, unsigned int pitch) override;
+    void         BeginScene(sSceneTarget const& target, float const clearColor[4]) override;
+    void         DrawFullscreenTexture(unsigned int textureId) override;
+    void         DrawSprites(SpriteBatcher const& batcher) override;
+    bool         EndScene() override;
+    bool         QueueEndScene() override;
+    bool         FlushSceneReadbacks() override;
+    unsigned int CreateLayer() override;
+    void         BeginLayer(unsigned int layerId, float const clearColor[4]) override;
+    void         EndLayer() override;
+    void         CompositeLayer(unsigned int layerId, bool isOpaque) override;
+
+    bool IsSoftwareRendering() const { return m_softwareBackend != nullptr; }
+
+    unsigned int RegisterSpriteTexture(ID3D11ShaderResourceView* shaderResourceView);
+    void         DrawSprite(sSprite const& sprite);
+
+    void SetSceneResolution(UINT width, UINT height);
+    void SetDynamicResolutionEnabled(bool enabled, float sceneBudgetMs = 0.f);  // sceneBudgetMs 為 0 時保留目前的預算
+
+    sUpdateSchedulerStats const&      GetUpdateSchedulerStats() const { return m_updateScheduler.GetTotalStats(); }
+    sResolutionControllerStats const& GetResolutionControllerStats() const { return m_resolutionController.GetStats(); }
+    sSpriteBatchStats const&          GetSpriteBatchStats() const { return m_spriteBatchStats; }
+    sShaderCacheStats const&          GetShaderCacheStats() const { return m_shaderCache.GetStats(); }
+    sFrameExporterStats const&        GetFrameExportStats() const { return m_frameExporter.GetStats(); }
+    sFrameRecorderStats               GetRecordingStats() const { return m_frameRecorder.GetStats(); }
+    FixedTimestep const&              GetSimulationTimestep() const { return m_simulationTimestep; }
+    unsigned long long                GetCommandsApplied() const { return m_commandsApplied; }
+    unsigned long long                GetCommandsRejected() const { return m_commandQueue.GetFullCount(); }
+    sVirtualTextureStats const*       GetBackgroundStats() const { return m_background ? &m_background->GetStats() : nullptr; }
+    sFrameArenaStats                  GetFrameMemoryStats() const { return m_frameMemory.GetStats(); }
+    sBufferPoolStats                  GetBufferPoolStats() const { return m_frameMemory.GetBufferPool().GetStats(); }
+    sLayerCompositorStats const&      GetLayerCompositorStats() const { return m_layerCompositor.GetStats(); }
+    sSceneGroupStats const*           GetSceneGroupStats() const { return m_sceneGroup ? &m_sceneGroup->GetStats() : nullptr; }
+    sTileReadbackStats const&         GetTileReadbackStats() const { return m_tileTracker.GetStats(); }
+    sFlightRecorderStats const&       GetFlightRecorderStats() const { return m_flightRecorder.GetStats(); }
 
 private:
-    void RenderTestTexture() const;
-    void UpdateWindows();
-    void RenderViewportToWindow(Window const& window) const;
-    void Cleanup();
+    // 目前綁定在管線上的狀態，用來略過重複的設定呼叫
+    struct sLayerTarget
+    {
+        ID3D11Texture2D*          texture            = nullptr;
+        ID3D11RenderTargetView*   renderTargetView   = nullptr;
+        ID3D11ShaderResourceView* shaderResourceView = nullptr;
+        UINT                      width              = 0;
+        UINT                      height             = 0;
+    };
+
+    // QueueEndScene 送出、等待 FlushSceneReadbacks 的回讀
+    struct sPendingReadback
+    {
+        ID3D11Texture2D* staging = nullptr;
+        sSceneTarget     target;
+    };
+
+    // 熱路徑上直接使用的指標 (註冊後位址不變)
+    struct sRendererMetrics
+    {
+        MetricCounter*   frames             = nullptr;
+        MetricCounter*   framesDropped      = nullptr;
+        MetricCounter*   compositionsReused = nullptr;
+        MetricCounter*   readbackBytes      = nullptr;
+        MetricCounter*   readbackTiles      = nullptr;
+        MetricCounter*   skippedTiles       = nullptr;
+        MetricCounter*   windowBlits        = nullptr;
+        MetricCounter*   windowBlitPixels   = nullptr;
+        MetricCounter*   windowMoves        = nullptr;
+        MetricCounter*   dragMovesCoalesced = nullptr;
+        MetricCounter*   hitches            = nullptr;
+        MetricHistogram* frameTime          = nullptr;
+        MetricHistogram* updateWindowsTime  = nullptr;
+        MetricHistogram* windowBlitTime     = nullptr;
+        MetricGauge*     windows            = nullptr;
+        MetricGauge*     sceneWidth         = nullptr;
+        MetricGauge*     sceneHeight        = nullptr;
+        MetricGauge*     memoryBytes[(size_t)eMemoryCategory::Count] = {};
+    };
+
+    struct sBoundState
+    {
+        ID3D11VertexShader*       vertexShader = nullptr;
+        ID3D11PixelShader*        pixelShader  = nullptr;
+        ID3D11InputLayout*        inputLayout  = nullptr;
+        ID3D11ShaderResourceView* texture      = nullptr;
+        ID3D11BlendState*         blendState   = nullptr;
+    };
+
+    void InvalidateBoundState();
+    void BindShaders(ID3D11VertexShader* vertexShader, ID3D11PixelShader* pixelShader, ID3D11InputLayout* inputLayout);
+    void BindTexture(ID3D11ShaderResourceView* texture);
+    void BindBlendState(ID3D11BlendState* blendState);
+    HRESULT EnsureSpriteInstanceCapacity(UINT instanceCount);
+    HRESULT EnsureLayerTarget(sLayerTarget& layer, UINT width, UINT height);
+    void    ReleaseLayerTarget(sLayerTarget& layer);
+    HRESULT CreateReadbackTexture(ID3D11Texture2D** texture);
+    void    BindSceneRenderTarget(ID3D11RenderTargetView* renderTargetView);
+    void    DrawFullscreenQuad(ID3D11ShaderResourceView* texture, ID3D11BlendState* blendState);
+    HRESULT CreateDeviceResources();
+    HRESULT CreateShaderProgram(char const* name, ID3D11VertexShader** vertexShader, ID3D11PixelShader** pixelShader, ID3D11InputLayout** inputLayout);
+    void    ReleaseDeviceResources();
+
+    unsigned int     CreateTextureView(D3D11_TEXTURE2D_DESC const& texDesc, D3D11_SUBRESOURCE_DATA const* initData);
+    RenderBackend&   GetSceneBackend();
+    ID3D11Texture2D* GetReadbackStaging(size_t slot);        // 不存在時建立，失敗時回傳 nullptr
+
+    void  RegisterMetrics();
+    void  ApplyCommands();
+    void  ApplyDragInput();
+    void  CommitWindowMoves();
+    UINT  AdvanceSimulation(LARGE_INTEGER const& now);
+    void  UpdateBackground();
+    void  DrawSceneLayer(RenderBackend& backend, unsigned int layerId);
+    bool  MapScenePixels();
+    void  UnmapScenePixels();
+    void  PublishFrame();
+    void  RecordFrame();
+    void  UpdateWindows();
+    void  CollectOccluders();
+    static BOOL CALLBACK CollectOccluder(HWND hwnd, LPARAM param);
+    void  UpdateWindowVisibility(Window& window, size_t occludersAbove);
+    sRect GetWindowSceneRect(Window const& window) const;
+    void  RenderViewportToWindow(Window const& window);
+    void  UpdateSceneViews();
+    void  PresentSceneView(Scene const& scene, sSceneView const& view);
+    bool  IsTileReadbackActive() const;
+    void  UpdateTileCoverage();
+    bool  QueueTileReadback();
+    bool  QueueChangedTiles();
+    bool  CompleteTileReadback();
+    void  MarkFrameStage(eFrameStage stage, LARGE_INTEGER& stageStart);
+    int   FindWindowIndex(HWND hwnd) const;
+    void  Cleanup();
 
     ID3D11Device*             m_device                         = nullptr;
     ID3D11DeviceContext*      m_deviceContext                  = nullptr;
@@ -61,8 +315,6 @@ private:
     ID3D11RenderTargetView*   m_sceneRenderTargetView          = nullptr;
     ID3D11ShaderResourceView* m_sceneShaderResourceView        = nullptr;
     ID3D11Texture2D*          m_stagingTexture                 = nullptr;
-    ID3D11Texture2D*          m_testTexture                    = nullptr;
-    ID3D11ShaderResourceView* m_testShaderResourceView         = nullptr;
     ID3D11VertexShader*       m_vertexShader                   = nullptr;
     ID3D11PixelShader*        m_pixelShader                    = nullptr;
     ID3D11Buffer*             m_vertexBuffer                   = nullptr;
@@ -70,13 +322,135 @@ private:
     ID3D11InputLayout*        m_inputLayout                    = nullptr;
     ID3D11SamplerState*       m_sampler                        = nullptr;
 
-    std::vector<Window> m_windowList;
-    UINT                sceneWidth = 1920, sceneHeight = 1080;
-    HWND                mainWindow = nullptr;
+    // Shader：名稱 -> bytecode 與 input layout
+    ShaderCache    m_shaderCache;
+    ShaderRegistry m_shaderRegistry;
+
+    // 精靈批次繪製
+    ID3D11VertexShader*                    m_spriteVertexShader     = nullptr;
+    ID3D11PixelShader*                     m_spritePixelShader      = nullptr;
+    ID3D11InputLayout*                     m_spriteInputLayout      = nullptr;
+    ID3D11Buffer*                          m_spriteCornerBuffer     = nullptr;
+    ID3D11Buffer*                          m_spriteInstanceBuffer   = nullptr;
+    ID3D11Buffer*                          m_spriteConstantBuffer   = nullptr;
+    ID3D11BlendState*                      m_spriteBlendState       = nullptr;
+    UINT                                   m_spriteInstanceCapacity = 0;
+    std::vector<ID3D11ShaderResourceView*> m_spriteTextures;
+    SpriteBatcher                          m_spriteBatcher;
+    sSpriteBatchStats                      m_spriteBatchStats;
+    sBoundState                            m_boundState;
+    bool                                   m_isBoundStateValid = false;
+    sSceneTarget                           m_sceneTarget;
+
+    // 分層合成：背景為快取的靜態圖層，精靈每幀直接繪製；沒有任何變化時整幀略過合成與回讀
+    LayerCompositor           m_layerCompositor;
+    std::vector<unsigned int> m_backendLayers;              // 圖層編號 -> 後端的圖層 (Dynamic 圖層沒有)
+    std::vector<sLayerTarget> m_layerTargets;               // D3D11 的圖層目標
+    ID3D11BlendState*         m_layerBlendState = nullptr;  // premultiplied over
+    unsigned int              m_backgroundLayer = 0;
+    unsigned int              m_spriteLayer     = 0;
+
+    // 每幀暫存記憶體 (Render 結束時重設) 與重複使用的大型緩衝區；工作執行緒也會使用，必須比執行緒池晚釋放
+    FrameMemory m_frameMemory;
+    Region      m_visibleScratch;
+
+    // 這一幀所有可見頂層窗口的範圍，依 Z 順序由上到下；m_occludersAbove 為每個窗口上方的遮擋者數量
+    std::vector<sRect>  m_occluders;
+    std::vector<size_t> m_occludersAbove;
 
-    BITMAPINFO        bitmapInfo;
+    // 軟體渲染 (無 GPU 模式)
+    ThreadPool                             m_threadPool;
+    std::unique_ptr<SoftwareRenderBackend> m_softwareBackend;
+    unsigned int                           m_testTextureId = INVALID_SCENE_TEXTURE_ID;
+
+    // 其他場景 (使用 GetSceneBackend 與 m_threadPool，必須比兩者早釋放)
+    // 延後的回讀依送出順序使用 staging：第一個為 m_stagingTexture (省記憶體模式下保留給主場景)，其餘在 m_stagingRing
+    std::unique_ptr<SceneGroup>   m_sceneGroup;
+    std::vector<sPendingReadback> m_pendingReadbacks;
+    std::vector<ID3D11Texture2D*> m_stagingRing;
+
+    // 局部回讀：主場景的快照 (之後的場景會覆寫場景紋理)、每個區塊的校驗碼與其 staging
+    // 變化的區塊從快照複製到 m_stagingTexture 的相同位置，再修補到 CPU 鏡像
+    ID3D11Texture2D*          m_tileSourceTexture      = nullptr;
+    ID3D11ShaderResourceView* m_tileSourceView         = nullptr;
+    ID3D11Texture2D*          m_tileChecksumTexture    = nullptr;
+    ID3D11RenderTargetView*   m_tileChecksumTargetView = nullptr;
+    ID3D11Texture2D*          m_tileChecksumStaging    = nullptr;
+    ID3D11Buffer*             m_tileConstantBuffer     = nullptr;
+    ID3D11VertexShader*       m_tileVertexShader       = nullptr;
+    ID3D11PixelShader*        m_tilePixelShader        = nullptr;
+    ID3D11InputLayout*        m_tileInputLayout        = nullptr;
+    TileChangeTracker         m_tileTracker;
+    std::vector<uint64_t>     m_tileChecksums;
+    sSceneTarget              m_tileReadbackTarget;
+    bool                      m_isTileReadbackPending  = false;
+    bool                      m_isTileReadbackEnabled  = true;
+
+    // 虛擬紋理背景：螢幕大小的動態紋理，只更新窗口可見的矩形
+    std::unique_ptr<VirtualTexture> m_background;
+    std::vector<uint32_t>           m_backgroundPixels;
+    unsigned int                    m_backgroundTextureId = INVALID_SCENE_TEXTURE_ID;
+    int                             m_backgroundOffsetX   = 0;
+    int                             m_backgroundOffsetY   = 0;
+    bool                            m_isBackgroundDirty   = false;
+
+    // 跨行程的場景輸出與錄影
+    FrameExporter      m_frameExporter;
+    FrameRecorder      m_frameRecorder;
+    std::vector<sRect> m_exportDirtyRects;
+    std::vector<sRect> m_recordWindowRects;
+    bool               m_exportDirtyRegionsOnly = false;
+
+    // 固定步長模擬 (與渲染頻率無關，畫面在最近兩步之間內插)；窗口每幀依漂移參數分組後批次前進
+    FixedTimestep m_simulationTimestep;
+    LARGE_INTEGER m_lastSimulationTime{};
+    DriftBuckets  m_driftBuckets;
+
+    // 決定性模式與輸入記錄
+    bool           m_isDeterministic        = false;
+    uint32_t       m_simulationSeed         = 0;
+    float          m_deterministicFrameTime = 0.f;
+    InputLogWriter m_inputLog;
+
+    // 飛行記錄器與 Render 中逐步填入的這一幀
+    FlightRecorder m_flightRecorder;
+    sFrameSample   m_frameSample;
+    LARGE_INTEGER  m_messagePumpStart{};
+    LARGE_INTEGER  m_lastFrameStart{};
+
+    // 指標與本機讀取端點 (端點必須先停止)
+    MetricsRegistry  m_metrics;
+    sRendererMetrics m_rendererMetrics;
+    MetricsServer    m_metricsServer;
+    LARGE_INTEGER    m_lastMemoryReport{};     // 記憶體指標上次更新的時間
+
+    // 其他執行緒送來的控制命令
+    MpscQueue<sWindowCommand>              m_commandQueue{4096};
+    unsigned long long                     m_commandsApplied = 0;
+    std::unordered_map<HWND, unsigned int> m_windowIndices;     // HWND -> m_windowList 索引，每個命令都要查詢
+    DragInputCoalescer                     m_dragInput;         // 以 m_windowList 索引區分窗口
+    std::vector<unsigned int>              m_movedWindows;      // 這一幀需要移動的窗口，一次提交
+
+    std::vector<Window>        m_windowList;
+    UpdateScheduler            m_updateScheduler;
+    std::vector<sUpdateState*> m_updateStates;
+    UINT                       maxSceneWidth = 1920, maxSceneHeight = 1080;  // 場景紋理與 CPU 鏡像的配置大小
+    UINT                       sceneWidth    = 1920, sceneHeight    = 1080;  // 目前實際渲染的區域
+    HWND                       mainWindow    = nullptr;
+
+    // 動態解析度
+    ResolutionController m_resolutionController;
+    bool                 m_dynamicResolutionEnabled = false;
+    LARGE_INTEGER        m_performanceFrequency{};
+
+    sSceneBitmapInfo  bitmapInfo;
     std::vector<BYTE> pixelData;
 
+    // 分發到窗口時讀取的場景 (MapScenePixels 到 UnmapScenePixels 之間有效)：CPU 鏡像，或省記憶體模式下映射中的 staging 紋理
+    BYTE const* m_scenePixels     = nullptr;
+    UINT        m_scenePitch      = 0;
+    bool        m_isCompactMemory = false;
+
     int virtualScreenWidth;
     int virtualScreenHeight;
 
@@ -0,0 +1,39 @@
+﻿//----------------------------------------------------------------------------------------------------
+// ReplayMain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// 無頭回放工具 (不屬於 Windows 專案，在 Linux 上單獨編譯)：
+//
+//   g++ -std=c++14 -O2 -ffp-contract=off ReplayMain.cpp InputReplay.cpp InputLog.cpp DriftSimulation.cpp -o replay
+//   ./replay session.mwil [--frames]
+//
+// 不可使用 -ffast-math 或會合併乘加 (FMA) 的選項，否則浮點結果會與錄製端不同
+// 結束碼：0 = 每幀校驗碼都相同，1 = 有不同，2 = 無法讀取
+//----------------------------------------------------------------------------------------------------
+#include <cstdio>
+#include <cstring>
+
+#include "InputReplay.hpp"
+
+//----------------------------------------------------------------------------------------------------
+int main(int const argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <input log> [--frames]\n", argv[0]);
+        return 2;
+    }
+
+    bool const includeFrames = argc > 2 && strcmp(argv[2], "--frames") == 0;
+
+    sReplayResult result;
+    if (!ReplayInputLog(argv[1], result))
+    {
+        fprintf(stderr, "cannot open input log %s\n", argv[1]);
+        return 2;
+    }
+
+    WriteReplayReport(stdout, result, includeFrames);
+    return result.mismatchCount == 0 && !result.isLogCorrupt ? 0 : 1;
+}
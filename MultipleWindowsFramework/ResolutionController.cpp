@@ -0,0 +1,108 @@
+﻿//----------------------------------------------------------------------------------------------------
+// ResolutionController.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "ResolutionController.hpp"
+
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------
+ResolutionController::ResolutionController(sResolutionControllerConfig const& config)
+    : m_config(config)
+{
+    if (m_config.scales.empty())
+    {
+        m_config.scales.push_back(1.f);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+void ResolutionController::Reset()
+{
+    m_stats           = sResolutionControllerStats();
+    m_level           = 0;
+    m_smoothedFrameMs = 0.f;
+    m_hasSample       = false;
+    m_overBudgetRun   = 0;
+    m_underBudgetRun  = 0;
+    m_cooldown        = 0;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool ResolutionController::Update(float const frameMs)
+{
+    ++m_stats.frames;
+
+    // 指數移動平均，過濾單幀的抖動
+    if (!m_hasSample)
+    {
+        m_smoothedFrameMs = frameMs;
+        m_hasSample       = true;
+    }
+    else
+    {
+        m_smoothedFrameMs += (frameMs - m_smoothedFrameMs) * m_config.smoothing;
+    }
+
+    float const target = m_config.targetFrameMs;
+    if (frameMs > target) ++m_stats.framesOverBudget;
+
+    if (m_smoothedFrameMs > target * m_config.downThreshold)
+    {
+        ++m_overBudgetRun;
+        m_underBudgetRun = 0;
+    }
+    else if (m_smoothedFrameMs < target * m_config.upThreshold)
+    {
+        ++m_underBudgetRun;
+        m_overBudgetRun = 0;
+    }
+    else
+    {
+        // 在遲滯區間內，維持目前等級
+        m_overBudgetRun  = 0;
+        m_underBudgetRun = 0;
+    }
+
+    if (m_cooldown > 0)
+    {
+        --m_cooldown;
+        return false;
+    }
+
+    int const previousLevel = m_level;
+
+    if (m_overBudgetRun >= m_config.framesBeforeDown)
+    {
+        int const step = m_smoothedFrameMs > target * m_config.severeThreshold ? 2 : 1;
+        SetLevel(m_level + step);
+    }
+    else if (m_underBudgetRun >= m_config.framesBeforeUp && m_level > 0)
+    {
+        // 成本約與像素數 (比例的平方) 成正比；相鄰等級的差距可能大於遲滯區間，
+        // 升級後預估會過載就留在目前等級，避免在兩級之間來回
+        float const ratio = m_config.scales[m_level - 1] / m_config.scales[m_level];
+        if (m_smoothedFrameMs * ratio * ratio < target * m_config.downThreshold)
+        {
+            SetLevel(m_level - 1);
+        }
+    }
+
+    if (m_level == previousLevel) return false;
+
+    if (m_level > previousLevel) ++m_stats.stepsDown;
+    else ++m_stats.stepsUp;
+
+    // 切換後重新累積，冷卻期間讓平均值收斂到新等級的幀時間
+    m_overBudgetRun  = 0;
+    m_underBudgetRun = 0;
+    m_cooldown       = m_config.cooldownFrames;
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+void ResolutionController::SetLevel(int const level)
+{
+    m_level = (std::max)(0, (std::min)(level, GetLevelCount() - 1));
+}
@@ -0,0 +1,61 @@
+﻿//----------------------------------------------------------------------------------------------------
+// ResolutionController.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+struct sResolutionControllerConfig
+{
+    float              targetFrameMs    = 16.f;     // 每幀的時間預算 (毫秒)
+    float              downThreshold    = 0.95f;    // 平滑後超過預算的此比例即視為過載
+    float              upThreshold      = 0.70f;    // 平滑後低於預算的此比例即視為有餘裕 (升級後預估仍低於 downThreshold 才升級)
+    float              severeThreshold  = 1.50f;    // 超過預算的此比例時一次降兩級
+    float              smoothing        = 0.2f;     // 指數移動平均係數 (0-1)
+    int                framesBeforeDown = 6;        // 連續過載多少幀後降低解析度
+    int                framesBeforeUp   = 45;       // 連續有餘裕多少幀後提高解析度
+    int                cooldownFrames   = 30;       // 每次切換後的冷卻幀數
+    std::vector<float> scales           = {1.f, 0.875f, 0.75f, 0.625f, 0.5f};  // 由高到低的解析度比例
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sResolutionControllerStats
+{
+    long long frames           = 0;
+    long long stepsDown        = 0;
+    long long stepsUp          = 0;
+    long long framesOverBudget = 0;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 根據量測到的幀時間調整場景解析度等級，帶有遲滯與冷卻避免來回跳動
+class ResolutionController
+{
+public:
+    explicit ResolutionController(sResolutionControllerConfig const& config = sResolutionControllerConfig());
+
+    void Reset();
+    bool Update(float frameMs);     // 回傳等級是否改變
+
+    int   GetLevel() const { return m_level; }
+    int   GetLevelCount() const { return (int)m_config.scales.size(); }
+    float GetScale() const { return m_config.scales[m_level]; }
+    float GetSmoothedFrameMs() const { return m_smoothedFrameMs; }
+
+    sResolutionControllerConfig const& GetConfig() const { return m_config; }
+    sResolutionControllerStats const&  GetStats() const { return m_stats; }
+
+private:
+    void SetLevel(int level);
+
+    sResolutionControllerConfig m_config;
+    sResolutionControllerStats  m_stats;
+    int                         m_level           = 0;
+    float                       m_smoothedFrameMs = 0.f;
+    bool                        m_hasSample       = false;
+    int                         m_overBudgetRun   = 0;
+    int                         m_underBudgetRun  = 0;
+    int                         m_cooldown        = 0;
+};
@@ -0,0 +1,214 @@
+﻿//----------------------------------------------------------------------------------------------------
+// ResolutionControllerCheckMain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// 動態解析度控制器的決定性檢查 (不屬於 Windows 專案，在 Linux 上單獨編譯)：
+//
+//   g++ -std=c++14 -O2 ResolutionControllerCheckMain.cpp ResolutionController.cpp -o resolution_controller_check
+//   ./resolution_controller_check
+//
+// 以合成的幀時間序列驅動 ResolutionController，檢查降級與嚴重過載時一次降兩級的時機、冷卻期間不切換、
+// 恢復後升級的時機、遲滯區間內維持等級、單幀突波被平滑掉，以及成本與像素數成正比的負載下收斂到
+// 預算內且不在相鄰兩級之間來回跳動
+// 結束碼：0 = 全部通過，1 = 失敗
+//----------------------------------------------------------------------------------------------------
+#include <cstdio>
+#include <vector>
+
+#include "CheckMain.hpp"
+#include "ResolutionController.hpp"
+
+//----------------------------------------------------------------------------------------------------
+// 不平滑的設定：每幀的量測直接決定計數，切換的幀可以精確預測
+static sResolutionControllerConfig MakeExactConfig()
+{
+    sResolutionControllerConfig config;
+    config.targetFrameMs = 10.f;
+    config.smoothing     = 1.f;
+    return config;
+}
+
+// 以固定的幀時間更新 frames 次，回傳等級改變的幀 (從 1 起算)，沒有改變時為空
+static std::vector<int> Feed(ResolutionController& controller, float const frameMs, int const frames)
+{
+    std::vector<int> changes;
+    for (int frame = 1; frame <= frames; ++frame)
+    {
+        if (controller.Update(frameMs)) changes.push_back(frame);
+    }
+    return changes;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 持續過載：第 framesBeforeDown 幀降一級，之後冷卻 cooldownFrames 幀，下一幀再降一級，直到最低等級
+static bool CheckStepDown()
+{
+    sResolutionControllerConfig const config = MakeExactConfig();
+    ResolutionController              controller(config);
+
+    int const        down    = config.framesBeforeDown;
+    int const        period  = config.cooldownFrames + 1;
+    int const        levels  = controller.GetLevelCount();
+    std::vector<int> changes = Feed(controller, config.targetFrameMs * 1.2f, down + period * levels);
+
+    std::vector<int> expected;
+    for (int level = 1; level < levels; ++level)
+    {
+        expected.push_back(down + period * (level - 1));
+    }
+
+    sResolutionControllerStats const& stats = controller.GetStats();
+    printf("step_down_frames");
+    for (int const frame : changes) printf(" %d", frame);
+    printf("\n");
+
+    bool isPassing = true;
+    isPassing &= Check(changes == expected, "step_down_timing");
+    isPassing &= Check(controller.GetLevel() == levels - 1 && controller.GetScale() == config.scales.back(), "step_down_clamped");
+    isPassing &= Check(stats.stepsDown == levels - 1 && stats.stepsUp == 0 && stats.framesOverBudget == stats.frames, "step_down_stats");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 超過 severeThreshold 時一次降兩級；剛好在門檻上仍只降一級
+static bool CheckSevereStep()
+{
+    sResolutionControllerConfig const config = MakeExactConfig();
+
+    ResolutionController severe(config);
+    std::vector<int>     severeChanges = Feed(severe, config.targetFrameMs * config.severeThreshold * 1.01f, config.framesBeforeDown);
+
+    ResolutionController boundary(config);
+    Feed(boundary, config.targetFrameMs * config.severeThreshold, config.framesBeforeDown);
+
+    bool isPassing = true;
+    isPassing &= Check(severeChanges == std::vector<int>{config.framesBeforeDown} && severe.GetLevel() == 2, "severe_double_step");
+    isPassing &= Check(boundary.GetLevel() == 1, "severe_boundary_single_step");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 降級後立即恢復：冷卻期間不升級，連續 framesBeforeUp 幀有餘裕才升一級，之後每次升級之間至少冷卻
+static bool CheckCooldownAndStepUp()
+{
+    sResolutionControllerConfig const config = MakeExactConfig();
+    ResolutionController              controller(config);
+
+    // 先降到第 2 級 (嚴重過載)
+    Feed(controller, config.targetFrameMs * 2.f, config.framesBeforeDown);
+
+    // 冷卻期間的過載不會再降級
+    std::vector<int> const cooldownChanges = Feed(controller, config.targetFrameMs * 2.f, config.cooldownFrames);
+    bool const             isCoolingDown   = cooldownChanges.empty() && controller.GetLevel() == 2;
+
+    // 回到有餘裕的負載：冷卻已結束，但需要連續 framesBeforeUp 幀
+    std::vector<int> const upChanges = Feed(controller, config.targetFrameMs * 0.5f, config.framesBeforeUp * 4);
+    int const              upPeriod  = (config.framesBeforeUp > config.cooldownFrames ? config.framesBeforeUp : config.cooldownFrames + 1);
+    std::vector<int> const expected  = {config.framesBeforeUp, config.framesBeforeUp + upPeriod};
+
+    printf("step_up_frames");
+    for (int const frame : upChanges) printf(" %d", frame);
+    printf("\n");
+
+    sResolutionControllerStats const& stats = controller.GetStats();
+
+    bool isPassing = true;
+    isPassing &= Check(isCoolingDown, "cooldown_blocks_steps");
+    isPassing &= Check(upChanges == expected && controller.GetLevel() == 0, "step_up_timing");
+    isPassing &= Check(stats.stepsDown == 1 && stats.stepsUp == 2, "step_up_stats");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 遲滯：介於 upThreshold 與 downThreshold 之間的負載在任何等級都不切換；預設的平滑係數下單幀突波不降級
+static bool CheckHysteresis()
+{
+    sResolutionControllerConfig const config = MakeExactConfig();
+    float const                       middle = config.targetFrameMs * (config.upThreshold + config.downThreshold) * 0.5f;
+
+    bool isStable = true;
+    for (int level = 0; level < (int)config.scales.size(); ++level)
+    {
+        ResolutionController controller(config);
+        while (controller.GetLevel() < level)
+        {
+            Feed(controller, config.targetFrameMs * 1.2f, 1);
+        }
+        Feed(controller, middle, config.cooldownFrames + 1);
+
+        isStable &= controller.GetLevel() == level && Feed(controller, middle, 1000).empty();
+    }
+
+    // 預設設定：穩定在 60% 預算的負載中每 20 幀出現一次 3 倍預算的突波 (第一幀不是突波，它決定平均的初始值)
+    sResolutionControllerConfig smoothed = config;
+    smoothed.smoothing                   = sResolutionControllerConfig().smoothing;
+
+    ResolutionController spiky(smoothed);
+    bool                 isSpikeFiltered = true;
+    for (int frame = 0; frame < 2000; ++frame)
+    {
+        isSpikeFiltered &= !spiky.Update(frame % 20 == 10 ? smoothed.targetFrameMs * 3.f : smoothed.targetFrameMs * 0.6f);
+    }
+
+    bool isPassing = true;
+    isPassing &= Check(isStable, "hysteresis_band_holds_level");
+    isPassing &= Check(isSpikeFiltered && spiky.GetLevel() == 0 && spiky.GetStats().framesOverBudget == 100, "spikes_filtered");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 成本與像素數成正比的負載：全解析度為預算的 2.5 倍，必須降到平方比例在預算內的等級並停在那裡
+static bool CheckBudgetTracking()
+{
+    sResolutionControllerConfig const config = sResolutionControllerConfig();
+    ResolutionController              controller(config);
+
+    float const fullResolutionMs = config.targetFrameMs * 2.5f;
+
+    int   changes       = 0;
+    int   lastChange    = 0;
+    float settledCostMs = 0.f;
+    for (int frame = 1; frame <= 3000; ++frame)
+    {
+        float const scale  = controller.GetScale();
+        float const costMs = fullResolutionMs * scale * scale;
+        if (controller.Update(costMs))
+        {
+            ++changes;
+            lastChange = frame;
+        }
+        settledCostMs = costMs;
+    }
+
+    // 預期的等級：第一個讓成本低於降級門檻的比例 (再高一級就會過載)
+    int expectedLevel = 0;
+    while (expectedLevel + 1 < controller.GetLevelCount() &&
+           fullResolutionMs * config.scales[expectedLevel] * config.scales[expectedLevel] > config.targetFrameMs * config.downThreshold)
+    {
+        ++expectedLevel;
+    }
+
+    printf("tracking_level %d\n", controller.GetLevel());
+    printf("tracking_scale %.3f\n", controller.GetScale());
+    printf("tracking_cost_ms %.2f\n", settledCostMs);
+    printf("tracking_changes %d\n", changes);
+    printf("tracking_last_change_frame %d\n", lastChange);
+
+    bool isPassing = true;
+    isPassing &= Check(controller.GetLevel() == expectedLevel && settledCostMs <= config.targetFrameMs, "tracking_within_budget");
+    isPassing &= Check(changes <= controller.GetLevelCount() && lastChange < 500, "tracking_no_oscillation");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+int main()
+{
+    bool isPassing = true;
+    isPassing &= CheckStepDown();
+    isPassing &= CheckSevereStep();
+    isPassing &= CheckCooldownAndStepUp();
+    isPassing &= CheckHysteresis();
+    isPassing &= CheckBudgetTracking();
+    return isPassing ? 0 : 1;
+}
@@ -0,0 +1,239 @@
+﻿//----------------------------------------------------------------------------------------------------
+// SceneGroup.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "SceneGroup.hpp"
+
+#include <algorithm>
+
+#include "ThreadPool.hpp"
+
+//----------------------------------------------------------------------------------------------------
+Scene::Scene(unsigned int const id, sSceneDesc const& desc)
+    : m_id(id)
+    , m_desc(desc)
+{
+    m_desc.width  = (std::max)(1u, m_desc.width);
+    m_desc.height = (std::max)(1u, m_desc.height);
+}
+
+//----------------------------------------------------------------------------------------------------
+void Scene::SetContent(unsigned int const textureId)
+{
+    if (textureId == m_desc.contentTexture) return;
+
+    m_desc.contentTexture = textureId;
+    m_isDirty             = true;
+}
+
+//----------------------------------------------------------------------------------------------------
+void Scene::SetClearColor(float const color[4])
+{
+    std::copy(color, color + 4, m_desc.clearColor);
+    m_isDirty = true;
+}
+
+//----------------------------------------------------------------------------------------------------
+void Scene::SetResolution(unsigned int width, unsigned int height)
+{
+    width  = (std::max)(1u, width);
+    height = (std::max)(1u, height);
+    if (width == m_desc.width && height == m_desc.height) return;
+
+    // 舊解析度的鏡像不能再呈現，等下一次回讀完成
+    m_desc.width  = width;
+    m_desc.height = height;
+    m_isDirty     = true;
+    m_isReady     = false;
+}
+
+//----------------------------------------------------------------------------------------------------
+size_t Scene::AddView(uintptr_t const handle, uintptr_t const context)
+{
+    sSceneView view;
+    view.handle  = handle;
+    view.context = context;
+    m_views.push_back(view);
+    return m_views.size() - 1;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool Scene::RemoveView(uintptr_t const handle)
+{
+    auto const found = std::find_if(m_views.begin(), m_views.end(), [handle](sSceneView const& view) { return view.handle == handle; });
+    if (found == m_views.end()) return false;
+
+    m_views.erase(found);
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+void Scene::SetViewRect(size_t const index, sRect const& source, int const width, int const height)
+{
+    sSceneView& view = m_views[index];
+    if (view.source == source && view.width == width && view.height == height) return;
+
+    view.source       = source;
+    view.width        = width;
+    view.height       = height;
+    view.needsPresent = true;
+}
+
+//----------------------------------------------------------------------------------------------------
+void Scene::InvalidateViews()
+{
+    for (sSceneView& view : m_views)
+    {
+        view.needsPresent = true;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+SceneGroup::SceneGroup(RenderBackend& backend, ThreadPool& threadPool)
+    : m_backend(backend)
+    , m_threadPool(threadPool)
+{
+}
+
+//----------------------------------------------------------------------------------------------------
+Scene& SceneGroup::CreateScene(sSceneDesc const& desc)
+{
+    m_scenes.emplace_back(new Scene((unsigned int)m_scenes.size(), desc));
+    return *m_scenes.back();
+}
+
+//----------------------------------------------------------------------------------------------------
+Scene* SceneGroup::FindScene(unsigned int const id)
+{
+    return id < m_scenes.size() ? m_scenes[id].get() : nullptr;
+}
+
+//----------------------------------------------------------------------------------------------------
+unsigned int SceneGroup::QueueScenes()
+{
+    ++m_stats.frames;
+
+    unsigned int queuedCount = 0;
+    for (std::unique_ptr<Scene> const& scene : m_scenes)
+    {
+        // 內容沒有變化時沿用鏡像，只有視圖移動才需要重新呈現
+        if (!scene->m_isDirty)
+        {
+            ++m_stats.scenesReused;
+            continue;
+        }
+
+        sSceneDesc const& desc = scene->m_desc;
+        scene->m_pixels.resize((size_t)desc.width * desc.height * 4);
+        scene->m_isReady = false;
+
+        sSceneTarget target;
+        target.pixels = scene->m_pixels.data();
+        target.width  = desc.width;
+        target.height = desc.height;
+        target.pitch  = desc.width * 4;
+
+        m_backend.BeginScene(target, desc.clearColor);
+        if (desc.contentTexture != INVALID_SCENE_TEXTURE_ID)
+        {
+            m_backend.DrawFullscreenTexture(desc.contentTexture);
+        }
+
+        // 送出失敗的場景保持失效，下一幀重試
+        if (m_backend.QueueEndScene())
+        {
+            scene->m_isQueued = true;
+            ++queuedCount;
+            ++m_stats.scenesDrawn;
+        }
+    }
+    return queuedCount;
+}
+
+//----------------------------------------------------------------------------------------------------
+void SceneGroup::CompleteReadbacks(bool const isSucceeded)
+{
+    bool hasQueued = false;
+    for (std::unique_ptr<Scene> const& scene : m_scenes)
+    {
+        if (!scene->m_isQueued) continue;
+
+        hasQueued         = true;
+        scene->m_isQueued = false;
+        scene->m_isReady  = isSucceeded;
+        scene->m_isDirty  = !isSucceeded;
+        if (isSucceeded)
+        {
+            scene->InvalidateViews();
+        }
+        else
+        {
+            ++m_stats.readbacksFailed;
+        }
+    }
+
+    if (hasQueued)
+    {
+        ++m_stats.readbackFlushes;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+unsigned int SceneGroup::PresentScenes(ScenePresentFunction const& present)
+{
+    m_presentJobs.clear();
+    for (std::unique_ptr<Scene> const& scene : m_scenes)
+    {
+        if (!scene->m_isReady) continue;
+
+        for (size_t i = 0; i < scene->m_views.size(); ++i)
+        {
+            sSceneView const& view = scene->m_views[i];
+            if (!view.needsPresent || view.source.IsEmpty() || view.width <= 0 || view.height <= 0) continue;
+
+            sPresentJob job;
+            job.scene = scene.get();
+            job.view  = i;
+            job.area  = (long long)view.width * view.height;
+            m_presentJobs.push_back(job);
+        }
+    }
+    if (m_presentJobs.empty()) return 0;
+
+    std::stable_sort(m_presentJobs.begin(), m_presentJobs.end(),
+                     [](sPresentJob const& a, sPresentJob const& b) { return a.area > b.area; });
+
+    m_threadPool.ParallelFor((int)m_presentJobs.size(), [this, &present](int const index)
+    {
+        sPresentJob const& job = m_presentJobs[index];
+        present(*job.scene, job.scene->m_views[job.view]);
+    });
+
+    for (sPresentJob const& job : m_presentJobs)
+    {
+        job.scene->m_views[job.view].needsPresent = false;
+    }
+
+    m_stats.viewsPresented += m_presentJobs.size();
+    return (unsigned int)m_presentJobs.size();
+}
+
+//----------------------------------------------------------------------------------------------------
+void SceneGroup::RenderFrame(ScenePresentFunction const& present)
+{
+    unsigned int const queuedCount = QueueScenes();
+    CompleteReadbacks(queuedCount == 0 || m_backend.FlushSceneReadbacks());
+    PresentScenes(present);
+}
+
+//----------------------------------------------------------------------------------------------------
+size_t SceneGroup::GetMemoryBytes() const
+{
+    size_t bytes = m_scenes.capacity() * sizeof(std::unique_ptr<Scene>) + m_presentJobs.capacity() * sizeof(sPresentJob);
+    for (std::unique_ptr<Scene> const& scene : m_scenes)
+    {
+        bytes += sizeof(Scene) + scene->GetMemoryBytes();
+    }
+    return bytes;
+}
@@ -0,0 +1,136 @@
+﻿//----------------------------------------------------------------------------------------------------
+// SceneGroup.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "Region.hpp"
+#include "RenderBackend.hpp"
+
+//-Forward-Declaration--------------------------------------------------------------------------------
+class ThreadPool;
+
+//----------------------------------------------------------------------------------------------------
+struct sSceneDesc
+{
+    unsigned int width          = 640;
+    unsigned int height         = 360;
+    unsigned int contentTexture = INVALID_SCENE_TEXTURE_ID;     // 共用後端上的紋理 (多個場景可以使用同一個)；沒有時只清除
+    float        clearColor[4]  = {0.f, 0.f, 0.f, 1.f};
+};
+
+// 場景呈現到的一個目標 (窗口)，source 為場景座標中的區域，縮放到 width x height
+struct sSceneView
+{
+    uintptr_t handle       = 0;             // 呈現端的識別 (Windows 上為 HWND)
+    uintptr_t context      = 0;             // 呈現端的繪製目標 (Windows 上為 HDC)
+    sRect     source;
+    int       width        = 0;
+    int       height       = 0;
+    bool      needsPresent = true;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 獨立的場景：自己的內容、解析度、CPU 鏡像與呈現目標；繪製與回讀由 SceneGroup 統一安排
+class Scene
+{
+public:
+    Scene(unsigned int id, sSceneDesc const& desc);
+
+    unsigned int      GetId() const { return m_id; }
+    sSceneDesc const& GetDesc() const { return m_desc; }
+
+    // 內容或解析度改變後，下一幀重新繪製；UpdateSceneTexture 更新了內容紋理時呼叫 Invalidate
+    void SetContent(unsigned int textureId);
+    void SetClearColor(float const color[4]);
+    void SetResolution(unsigned int width, unsigned int height);
+    void Invalidate() { m_isDirty = true; }
+
+    size_t AddView(uintptr_t handle, uintptr_t context);
+    bool   RemoveView(uintptr_t handle);
+    void   SetViewRect(size_t index, sRect const& source, int width, int height);  // 與目前不同時才需要重新呈現
+    void   InvalidateViews();
+
+    std::vector<sSceneView> const& GetViews() const { return m_views; }
+
+    // 最近一次完成的場景 (RGBA8)；IsReady 為 false 時還沒有可呈現的內容
+    uint8_t const* GetPixels() const { return m_pixels.data(); }
+    unsigned int   GetPitch() const { return m_desc.width * 4; }
+    bool           IsReady() const { return m_isReady; }
+
+    size_t GetMemoryBytes() const { return m_pixels.capacity() + m_views.capacity() * sizeof(sSceneView); }
+
+private:
+    friend class SceneGroup;
+
+    unsigned int            m_id;
+    sSceneDesc              m_desc;
+    std::vector<uint8_t>    m_pixels;
+    std::vector<sSceneView> m_views;
+    bool                    m_isDirty  = true;
+    bool                    m_isQueued = false;     // 本幀已送出，等待回讀
+    bool                    m_isReady  = false;
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sSceneGroupStats
+{
+    unsigned long long frames          = 0;
+    unsigned long long scenesDrawn     = 0;
+    unsigned long long scenesReused    = 0;     // 內容沒有變化，沿用上一次的結果
+    unsigned long long readbackFlushes = 0;     // 有場景送出的幀才計算，每幀最多一次
+    unsigned long long readbacksFailed = 0;
+    unsigned long long viewsPresented  = 0;
+};
+
+// 在工作執行緒上同時呼叫；scene 的像素在呼叫期間不會改變
+using ScenePresentFunction = std::function<void(Scene const& scene, sSceneView const& view)>;
+
+//----------------------------------------------------------------------------------------------------
+// 多個獨立場景共用同一個後端 (裝置、shader、取樣器、staging) 與執行緒池
+// 一幀分成三段，呼叫端可以把自己的場景放進同一次回讀：
+//   QueueScenes -> backend.FlushSceneReadbacks (呼叫端) -> CompleteReadbacks -> PresentScenes
+// 只在渲染執行緒上呼叫
+class SceneGroup
+{
+public:
+    SceneGroup(RenderBackend& backend, ThreadPool& threadPool);
+
+    Scene& CreateScene(sSceneDesc const& desc);     // 編號依建立順序，位址在 SceneGroup 存在期間不變
+    Scene* FindScene(unsigned int id);
+    size_t GetSceneCount() const { return m_scenes.size(); }
+
+    // 依序繪製需要更新的場景並送出回讀 (不等待)，回傳送出的場景數
+    unsigned int QueueScenes();
+    void         CompleteReadbacks(bool isSucceeded);
+
+    // 已完成的場景中需要呈現的視圖，依面積由大到小分給執行緒池 (大的先開始，各執行緒的結束時間較平均)
+    // 回傳呈現的視圖數
+    unsigned int PresentScenes(ScenePresentFunction const& present);
+
+    // 沒有其他場景要一起回讀時的完整一幀
+    void RenderFrame(ScenePresentFunction const& present);
+
+    size_t                  GetMemoryBytes() const;
+    sSceneGroupStats const& GetStats() const { return m_stats; }
+
+private:
+    struct sPresentJob
+    {
+        Scene*    scene = nullptr;
+        size_t    view  = 0;
+        long long area  = 0;
+    };
+
+    RenderBackend&                      m_backend;
+    ThreadPool&                         m_threadPool;
+    std::vector<std::unique_ptr<Scene>> m_scenes;
+    std::vector<sPresentJob>            m_presentJobs;
+    sSceneGroupStats                    m_stats;
+};
@@ -0,0 +1,281 @@
+﻿//----------------------------------------------------------------------------------------------------
+// SceneGroupCheckMain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// 多場景的無頭自我檢查 (不屬於 Windows 專案，在 Linux 上單獨編譯)：
+//
+//   g++ -std=c++14 -O2 -pthread SceneGroupCheckMain.cpp SceneGroup.cpp SoftwareRenderBackend.cpp SpriteBatch.cpp ThreadPool.cpp Region.cpp -o scene_group_check
+//   ./scene_group_check
+//
+// 三個場景共用同一個 CPU 後端與執行緒池；後端外面包一層模擬 GPU 的延後回讀 (場景先畫在 staging，Flush 時才寫回)，
+// 檢查共用的內容紋理只建立一次、每幀最多一次回讀同步、呈現只在回讀之後且每個視圖一次，以及沒有變化時的略過
+// 結束碼：0 = 全部通過，1 = 失敗
+//----------------------------------------------------------------------------------------------------
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "CheckMain.hpp"
+#include "SceneGroup.hpp"
+#include "SoftwareRenderBackend.hpp"
+#include "ThreadPool.hpp"
+
+//----------------------------------------------------------------------------------------------------
+static uint32_t const CONTENT_COLOR = 0xFF2040E0;               // RGBA8，R 在最低位元組
+static uint32_t const CLEAR_COLOR   = 0xFF00FF00;               // 綠色
+static size_t const   MAX_VIEWS     = 16;
+
+//----------------------------------------------------------------------------------------------------
+// 與 D3D11 相同的回讀時序：QueueEndScene 之後 target 還沒有內容，FlushSceneReadbacks 才一起寫回
+class DeferredReadbackBackend : public RenderBackend
+{
+public:
+    explicit DeferredReadbackBackend(RenderBackend& inner) : m_inner(inner) {}
+
+    unsigned int CreateSceneTexture(uint32_t const* pixels, unsigned int width, unsigned int height) override
+    {
+        ++textureCount;
+        return m_inner.CreateSceneTexture(pixels, width, height);
+    }
+    unsigned int CreateDynamicSceneTexture(unsigned int width, unsigned int height) override { return m_inner.CreateDynamicSceneTexture(width, height); }
+    void         UpdateSceneTexture(unsigned int textureId, sRect const& rect, uint32_t const* pixels, unsigned int pitch) override
+    {
+        m_inner.UpdateSceneTexture(textureId, rect, pixels, pitch);
+    }
+
+    void BeginScene(sSceneTarget const& target, float const clearColor[4]) override
+    {
+        // 每個送出的場景各自一塊 staging
+        sPending pending;
+        pending.target = target;
+        pending.staging.assign((size_t)target.pitch * target.height, 0);
+        m_pending.push_back(pending);
+
+        sSceneTarget staging = target;
+        staging.pixels       = m_pending.back().staging.data();
+        m_inner.BeginScene(staging, clearColor);
+    }
+    void DrawFullscreenTexture(unsigned int textureId) override { m_inner.DrawFullscreenTexture(textureId); }
+    void DrawSprites(SpriteBatcher const& batcher) override { m_inner.DrawSprites(batcher); }
+    bool EndScene() override { return QueueEndScene() && FlushSceneReadbacks(); }
+
+    bool QueueEndScene() override
+    {
+        ++queueCount;
+        return m_inner.EndScene();
+    }
+
+    bool FlushSceneReadbacks() override
+    {
+        ++flushCount;
+        bool const isSucceeded = !isFlushFailing;
+        for (sPending const& pending : m_pending)
+        {
+            if (isSucceeded) memcpy(pending.target.pixels, pending.staging.data(), pending.staging.size());
+        }
+        m_pending.clear();
+        return isSucceeded;
+    }
+
+    unsigned int CreateLayer() override { return m_inner.CreateLayer(); }
+    void         BeginLayer(unsigned int layerId, float const clearColor[4]) override { m_inner.BeginLayer(layerId, clearColor); }
+    void         EndLayer() override { m_inner.EndLayer(); }
+    void         CompositeLayer(unsigned int layerId, bool isOpaque) override { m_inner.CompositeLayer(layerId, isOpaque); }
+
+    size_t GetPendingCount() const { return m_pending.size(); }
+
+    unsigned int textureCount   = 0;
+    unsigned int queueCount     = 0;
+    unsigned int flushCount     = 0;
+    bool         isFlushFailing = false;
+
+private:
+    struct sPending
+    {
+        sSceneTarget         target;
+        std::vector<uint8_t> staging;
+    };
+
+    RenderBackend&        m_inner;
+    std::vector<sPending> m_pending;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 記錄每個視圖被呈現的次數與呈現時讀到的像素
+struct sPresentLog
+{
+    std::atomic<int> counts[MAX_VIEWS];
+    std::atomic<int> badPixels{0};
+
+    void Reset()
+    {
+        for (std::atomic<int>& count : counts) count.store(0);
+        badPixels.store(0);
+    }
+
+    int GetTotal() const
+    {
+        int total = 0;
+        for (std::atomic<int> const& count : counts) total += count.load();
+        return total;
+    }
+};
+
+//----------------------------------------------------------------------------------------------------
+static uint32_t PackColor(float const color[4])
+{
+    uint32_t packed = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        packed |= (uint32_t)(color[i] * 255.f + 0.5f) << (i * 8);
+    }
+    return packed;
+}
+
+static bool IsFilledWith(Scene const& scene, uint32_t const color)
+{
+    sSceneDesc const& desc = scene.GetDesc();
+    for (unsigned int y = 0; y < desc.height; ++y)
+    {
+        uint32_t const* row = reinterpret_cast<uint32_t const*>(scene.GetPixels() + (size_t)y * scene.GetPitch());
+        for (unsigned int x = 0; x < desc.width; ++x)
+        {
+            if (row[x] != color) return false;
+        }
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+int main()
+{
+    ThreadPool              threadPool(3);
+    SoftwareRenderBackend   software(threadPool);
+    DeferredReadbackBackend backend(software);
+    SceneGroup              group(backend, threadPool);
+
+    // 兩個場景共用同一張內容紋理 (解析度不同)，第三個只有清除色
+    std::vector<uint32_t> content(16 * 16, CONTENT_COLOR);
+    unsigned int const    contentTexture = backend.CreateSceneTexture(content.data(), 16, 16);
+
+    sSceneDesc desc;
+    desc.contentTexture = contentTexture;
+    desc.width          = 320;
+    desc.height         = 180;
+    Scene& sceneA       = group.CreateScene(desc);
+
+    desc.width  = 160;
+    desc.height = 90;
+    Scene& sceneB = group.CreateScene(desc);
+
+    float const clearColor[4] = {0.f, 1.f, 0.f, 1.f};
+    desc.contentTexture       = INVALID_SCENE_TEXTURE_ID;
+    desc.width                = 64;
+    desc.height               = 64;
+    std::copy(clearColor, clearColor + 4, desc.clearColor);
+    Scene& sceneC = group.CreateScene(desc);
+
+    // 視圖的 handle 為全域編號；大小刻意不同，最後一個為空 (最小化) 不應呈現
+    struct sViewSetup
+    {
+        Scene* scene;
+        sRect  source;
+        int    width;
+        int    height;
+    };
+    sViewSetup const setups[] =
+    {
+        {&sceneA, {0, 0, 160, 90},    640, 360},
+        {&sceneA, {100, 50, 320, 180}, 200, 100},
+        {&sceneB, {0, 0, 80, 45},     320, 180},
+        {&sceneB, {40, 20, 200, 120}, 800, 600},        // 部分超出場景
+        {&sceneC, {0, 0, 64, 64},     64,  64},
+        {&sceneC, {0, 0, 0, 0},       0,   0},
+    };
+    size_t const viewCount = sizeof(setups) / sizeof(setups[0]);
+
+    std::vector<size_t> viewIndices(viewCount);
+    for (size_t i = 0; i < viewCount; ++i)
+    {
+        viewIndices[i] = setups[i].scene->AddView((uintptr_t)i, 0);
+        setups[i].scene->SetViewRect(viewIndices[i], setups[i].source, setups[i].width, setups[i].height);
+    }
+
+    sPresentLog log;
+    log.Reset();
+    ScenePresentFunction const present = [&log](Scene const& scene, sSceneView const& view)
+    {
+        log.counts[view.handle].fetch_add(1);
+
+        uint32_t const expected = scene.GetDesc().contentTexture != INVALID_SCENE_TEXTURE_ID ? CONTENT_COLOR : CLEAR_COLOR;
+        sRect const    source   = view.source.Intersect({0, 0, (int)scene.GetDesc().width, (int)scene.GetDesc().height});
+        uint32_t const pixel    = *reinterpret_cast<uint32_t const*>(scene.GetPixels() + (size_t)source.top * scene.GetPitch() + (size_t)source.left * 4);
+        if (pixel != expected) log.badPixels.fetch_add(1);
+    };
+
+    bool isPassing = true;
+    isPassing &= Check(backend.textureCount == 1, "shared_content_uploaded_once");
+    isPassing &= Check(PackColor(clearColor) == CLEAR_COLOR, "clear_color_packing");
+
+    // 第一幀：三個場景依序送出，回讀之前都還沒有內容，也不能呈現
+    unsigned int const queued = group.QueueScenes();
+    isPassing &= Check(queued == 3 && backend.GetPendingCount() == 3 && backend.flushCount == 0, "queue_without_wait");
+    isPassing &= Check(!sceneA.IsReady() && !sceneB.IsReady() && !sceneC.IsReady(), "not_ready_before_flush");
+    isPassing &= Check(group.PresentScenes(present) == 0 && log.GetTotal() == 0, "no_present_before_flush");
+
+    group.CompleteReadbacks(backend.FlushSceneReadbacks());
+    isPassing &= Check(backend.flushCount == 1 && group.GetStats().readbackFlushes == 1, "single_flush");
+    isPassing &= Check(IsFilledWith(sceneA, CONTENT_COLOR) && IsFilledWith(sceneB, CONTENT_COLOR), "shared_content_pixels");
+    isPassing &= Check(IsFilledWith(sceneC, CLEAR_COLOR), "clear_only_pixels");
+
+    unsigned int const presented = group.PresentScenes(present);
+    bool               isOnce    = true;
+    for (size_t i = 0; i + 1 < viewCount; ++i)
+    {
+        isOnce &= log.counts[i].load() == 1;
+    }
+    isPassing &= Check(presented == viewCount - 1 && isOnce && log.counts[viewCount - 1].load() == 0, "present_each_view_once");
+    isPassing &= Check(log.badPixels.load() == 0, "present_pixels");
+
+    // 沒有任何變化：不繪製、不回讀、不呈現
+    log.Reset();
+    group.RenderFrame(present);
+    isPassing &= Check(backend.flushCount == 1 && group.GetStats().scenesReused == 3 && log.GetTotal() == 0, "unchanged_frame_skipped");
+
+    // 只移動一個視圖：只有它重新呈現，場景不重畫
+    log.Reset();
+    sceneA.SetViewRect(viewIndices[1], {90, 40, 310, 170}, 200, 100);
+    group.RenderFrame(present);
+    isPassing &= Check(backend.flushCount == 1 && log.GetTotal() == 1 && log.counts[1].load() == 1, "moved_view_only");
+
+    // 改變一個場景的解析度：只有它重畫 (一次回讀)，它的視圖重新呈現
+    log.Reset();
+    unsigned int const queuedBefore = backend.queueCount;
+    sceneB.SetResolution(200, 100);
+    group.RenderFrame(present);
+    isPassing &= Check(backend.queueCount == queuedBefore + 1 && backend.flushCount == 2, "resized_scene_redrawn");
+    isPassing &= Check(log.GetTotal() == 2 && log.counts[2].load() == 1 && log.counts[3].load() == 1, "resized_scene_views");
+    isPassing &= Check(IsFilledWith(sceneB, CONTENT_COLOR) && log.badPixels.load() == 0, "resized_scene_pixels");
+
+    // 回讀失敗：場景沒有內容、不呈現，下一幀重畫
+    log.Reset();
+    sceneC.Invalidate();
+    backend.isFlushFailing = true;
+    group.RenderFrame(present);
+    isPassing &= Check(!sceneC.IsReady() && log.GetTotal() == 0 && group.GetStats().readbacksFailed == 1, "failed_readback");
+
+    backend.isFlushFailing = false;
+    group.RenderFrame(present);
+    isPassing &= Check(sceneC.IsReady() && log.counts[4].load() == 1 && IsFilledWith(sceneC, CLEAR_COLOR), "failed_readback_retried");
+
+    sSceneGroupStats const& stats = group.GetStats();
+    printf("frames %llu\n", stats.frames);
+    printf("scenes_drawn %llu\n", stats.scenesDrawn);
+    printf("scenes_reused %llu\n", stats.scenesReused);
+    printf("readback_flushes %llu\n", stats.readbackFlushes);
+    printf("views_presented %llu\n", stats.viewsPresented);
+    printf("memory_bytes %zu\n", group.GetMemoryBytes());
+    return isPassing ? 0 : 1;
+}
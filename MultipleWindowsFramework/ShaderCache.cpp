@@ -0,0 +1,379 @@
+﻿//----------------------------------------------------------------------------------------------------
+// ShaderCache.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "ShaderCache.hpp"
+
+#include <cstdio>
+
+//----------------------------------------------------------------------------------------------------
+// 快取格式或雜湊規則改變時遞增，讓舊的快取檔與 pack 全部失效
+static uint32_t const SHADER_CACHE_VERSION = 1;
+
+static uint32_t const SHADER_PACK_MAGIC  = 0x5053574D;     // "MWSP"
+static uint32_t const SHADER_CACHE_MAGIC = 0x4353574D;     // "MWSC"
+
+static uint64_t const FNV_OFFSET_BASIS = 0xCBF29CE484222325ull;
+static uint64_t const FNV_PRIME        = 0x100000001B3ull;
+
+//----------------------------------------------------------------------------------------------------
+static uint64_t HashBytes(void const* data, size_t const size, uint64_t hash = FNV_OFFSET_BASIS)
+{
+    uint8_t const* bytes = static_cast<uint8_t const*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+//----------------------------------------------------------------------------------------------------
+static uint64_t HashUInt32(uint32_t const value, uint64_t const hash)
+{
+    uint8_t bytes[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        bytes[i] = (uint8_t)(value >> (i * 8));
+    }
+    return HashBytes(bytes, sizeof(bytes), hash);
+}
+
+//----------------------------------------------------------------------------------------------------
+// 以位元組為單位寫入小端序整數，檔案格式不依賴平台的位元組順序
+static void AppendUInt32(std::vector<uint8_t>& out, uint32_t const value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        out.push_back((uint8_t)(value >> (i * 8)));
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+static void AppendUInt64(std::vector<uint8_t>& out, uint64_t const value)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        out.push_back((uint8_t)(value >> (i * 8)));
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+// 依序讀取緩衝區，任何越界讀取都會讓 IsValid() 變成 false
+class ByteReader
+{
+public:
+    ByteReader(uint8_t const* data, size_t const size) : m_data(data), m_size(size) {}
+
+    uint32_t ReadUInt32()
+    {
+        uint32_t value = 0;
+        if (!Require(4)) return 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            value |= (uint32_t)m_data[m_offset++] << (i * 8);
+        }
+        return value;
+    }
+
+    uint64_t ReadUInt64()
+    {
+        uint64_t value = 0;
+        if (!Require(8)) return 0;
+        for (int i = 0; i < 8; ++i)
+        {
+            value |= (uint64_t)m_data[m_offset++] << (i * 8);
+        }
+        return value;
+    }
+
+    uint8_t const* ReadBytes(size_t const count)
+    {
+        if (!Require(count)) return nullptr;
+        uint8_t const* bytes = m_data + m_offset;
+        m_offset += count;
+        return bytes;
+    }
+
+    bool   IsValid() const { return m_isValid; }
+    size_t GetRemaining() const { return m_size - m_offset; }
+
+private:
+    bool Require(size_t const count)
+    {
+        if (!m_isValid || count > m_size - m_offset)
+        {
+            m_isValid = false;
+            return false;
+        }
+        return true;
+    }
+
+    uint8_t const* m_data    = nullptr;
+    size_t         m_size    = 0;
+    size_t         m_offset  = 0;
+    bool           m_isValid = true;
+};
+
+//----------------------------------------------------------------------------------------------------
+static FILE* OpenFile(std::string const& path, char const* mode)
+{
+#ifdef _MSC_VER
+    FILE* file = nullptr;
+    return fopen_s(&file, path.c_str(), mode) == 0 ? file : nullptr;
+#else
+    return fopen(path.c_str(), mode);
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------
+static bool ReadWholeFile(std::string const& path, std::vector<uint8_t>& out)
+{
+    FILE* file = OpenFile(path, "rb");
+    if (!file) return false;
+
+    out.clear();
+    uint8_t buffer[16384];
+    size_t  count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        out.insert(out.end(), buffer, buffer + count);
+    }
+
+    bool const isOk = ferror(file) == 0;
+    fclose(file);
+    return isOk;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 先寫入暫存檔再改名，避免其他行程或當機後讀到寫了一半的檔案
+static bool WriteWholeFile(std::string const& path, std::vector<uint8_t> const& data)
+{
+    std::string const temporaryPath = path + ".tmp";
+
+    FILE* file = OpenFile(temporaryPath, "wb");
+    if (!file) return false;
+
+    bool isOk = data.empty() || fwrite(data.data(), 1, data.size(), file) == data.size();
+    isOk      = fclose(file) == 0 && isOk;
+
+    if (isOk)
+    {
+        remove(path.c_str());   // Windows 上 rename 不會覆寫既有檔案
+        isOk = rename(temporaryPath.c_str(), path.c_str()) == 0;
+    }
+    if (!isOk)
+    {
+        remove(temporaryPath.c_str());
+    }
+    return isOk;
+}
+
+//----------------------------------------------------------------------------------------------------
+uint64_t HashShaderSource(sShaderSource const& source)
+{
+    // 欄位之間以 0 分隔，避免 ("ab", "c") 與 ("a", "bc") 碰撞
+    uint8_t const separator = 0;
+
+    uint64_t hash = HashUInt32(SHADER_CACHE_VERSION, FNV_OFFSET_BASIS);
+    hash          = HashBytes(source.source.data(), source.source.size(), hash);
+    hash          = HashBytes(&separator, 1, hash);
+    hash          = HashBytes(source.entryPoint.data(), source.entryPoint.size(), hash);
+    hash          = HashBytes(&separator, 1, hash);
+    hash          = HashBytes(source.target.data(), source.target.size(), hash);
+    hash          = HashBytes(&separator, 1, hash);
+    return HashUInt32(source.flags, hash);
+}
+
+//----------------------------------------------------------------------------------------------------
+// [magic][version][count] { [key][nameLength][name][size][bytecode] } ... [checksum]
+bool WriteShaderPack(std::string const& path, std::vector<sShaderPackEntry> const& entries)
+{
+    std::vector<uint8_t> data;
+    AppendUInt32(data, SHADER_PACK_MAGIC);
+    AppendUInt32(data, SHADER_CACHE_VERSION);
+    AppendUInt32(data, (uint32_t)entries.size());
+
+    for (sShaderPackEntry const& entry : entries)
+    {
+        AppendUInt64(data, entry.key);
+        AppendUInt32(data, (uint32_t)entry.name.size());
+        data.insert(data.end(), entry.name.begin(), entry.name.end());
+        AppendUInt32(data, (uint32_t)entry.bytecode.size());
+        data.insert(data.end(), entry.bytecode.begin(), entry.bytecode.end());
+    }
+
+    AppendUInt64(data, HashBytes(data.data(), data.size()));
+    return WriteWholeFile(path, data);
+}
+
+//----------------------------------------------------------------------------------------------------
+bool ReadShaderPack(std::string const& path, std::vector<sShaderPackEntry>& entries)
+{
+    std::vector<uint8_t> data;
+    if (!ReadWholeFile(path, data)) return false;
+    if (data.size() < 20) return false;
+
+    // 先驗證整個檔案的校驗碼，截斷或損毀的 pack 一律不採用
+    ByteReader     checksumReader(data.data() + data.size() - 8, 8);
+    uint64_t const checksum = checksumReader.ReadUInt64();
+    if (checksum != HashBytes(data.data(), data.size() - 8)) return false;
+
+    ByteReader reader(data.data(), data.size() - 8);
+    if (reader.ReadUInt32() != SHADER_PACK_MAGIC) return false;
+    if (reader.ReadUInt32() != SHADER_CACHE_VERSION) return false;
+
+    uint32_t const count = reader.ReadUInt32();
+
+    std::vector<sShaderPackEntry> loaded;
+    for (uint32_t i = 0; i < count && reader.IsValid(); ++i)
+    {
+        sShaderPackEntry entry;
+        entry.key = reader.ReadUInt64();
+
+        uint32_t const nameLength = reader.ReadUInt32();
+        uint8_t const* name       = reader.ReadBytes(nameLength);
+        uint32_t const size       = reader.ReadUInt32();
+        uint8_t const* bytecode   = reader.ReadBytes(size);
+        if (!reader.IsValid()) break;
+
+        entry.name.assign(reinterpret_cast<char const*>(name), nameLength);
+        entry.bytecode.assign(bytecode, bytecode + size);
+        loaded.push_back(std::move(entry));
+    }
+
+    if (!reader.IsValid() || reader.GetRemaining() != 0) return false;
+
+    entries = std::move(loaded);
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+ShaderCache::ShaderCache(std::string const& cacheDirectory, ShaderCompileFunction compiler)
+    : m_cacheDirectory(cacheDirectory),
+      m_compiler(std::move(compiler))
+{
+}
+
+//----------------------------------------------------------------------------------------------------
+bool ShaderCache::LoadPack(std::string const& path)
+{
+    std::vector<sShaderPackEntry> entries;
+    if (!ReadShaderPack(path, entries)) return false;
+
+    for (sShaderPackEntry const& entry : entries)
+    {
+        m_precompiled[entry.key] = entry.bytecode;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+void ShaderCache::AddPrecompiled(uint64_t const key, std::vector<uint8_t> const& bytecode)
+{
+    m_precompiled[key] = bytecode;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool ShaderCache::GetBytecode(sShaderSource const& source, std::vector<uint8_t>& bytecode, std::string* errors)
+{
+    uint64_t const key = HashShaderSource(source);
+
+    // 1. 建置時預先編譯的 pack
+    auto const found = m_precompiled.find(key);
+    if (found != m_precompiled.end())
+    {
+        bytecode = found->second;
+        ++m_stats.packHits;
+        return true;
+    }
+
+    // 2. 上次執行時留下的磁碟快取
+    if (ReadCacheFile(key, bytecode))
+    {
+        ++m_stats.diskHits;
+        return true;
+    }
+
+    // 3. 原始碼已改變或第一次執行，即時編譯並寫回快取
+    if (!m_compiler)
+    {
+        if (errors) *errors = "No shader compiler available for " + source.name;
+        ++m_stats.compileFailures;
+        return false;
+    }
+
+    std::string compileErrors;
+    bytecode.clear();
+    ++m_stats.compiles;
+    if (!m_compiler(source, bytecode, compileErrors) || bytecode.empty())
+    {
+        if (errors) *errors = compileErrors;
+        ++m_stats.compileFailures;
+        return false;
+    }
+
+    if (WriteCacheFile(key, bytecode))
+    {
+        ++m_stats.diskWrites;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+std::string ShaderCache::GetCacheFilePath(uint64_t const key) const
+{
+    if (m_cacheDirectory.empty()) return std::string();
+
+    char fileName[32];
+    snprintf(fileName, sizeof(fileName), "%016llx.cso", (unsigned long long)key);
+
+    std::string path = m_cacheDirectory;
+    if (path.back() != '/' && path.back() != '\\') path += '/';
+    return path + fileName;
+}
+
+//----------------------------------------------------------------------------------------------------
+// [magic][version][key][size][payload checksum][bytecode]
+bool ShaderCache::ReadCacheFile(uint64_t const key, std::vector<uint8_t>& bytecode) const
+{
+    std::string const path = GetCacheFilePath(key);
+    if (path.empty()) return false;
+
+    std::vector<uint8_t> data;
+    if (!ReadWholeFile(path, data)) return false;
+
+    ByteReader     reader(data.data(), data.size());
+    uint32_t const magic    = reader.ReadUInt32();
+    uint32_t const version  = reader.ReadUInt32();
+    uint64_t const fileKey  = reader.ReadUInt64();
+    uint32_t const size     = reader.ReadUInt32();
+    uint64_t const checksum = reader.ReadUInt64();
+    uint8_t const* payload  = reader.ReadBytes(size);
+
+    if (!reader.IsValid() || reader.GetRemaining() != 0) return false;
+    if (magic != SHADER_CACHE_MAGIC || version != SHADER_CACHE_VERSION || fileKey != key) return false;
+    if (checksum != HashBytes(payload, size)) return false;
+
+    bytecode.assign(payload, payload + size);
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool ShaderCache::WriteCacheFile(uint64_t const key, std::vector<uint8_t> const& bytecode) const
+{
+    std::string const path = GetCacheFilePath(key);
+    if (path.empty()) return false;
+
+    std::vector<uint8_t> data;
+    data.reserve(bytecode.size() + 28);
+    AppendUInt32(data, SHADER_CACHE_MAGIC);
+    AppendUInt32(data, SHADER_CACHE_VERSION);
+    AppendUInt64(data, key);
+    AppendUInt32(data, (uint32_t)bytecode.size());
+    AppendUInt64(data, HashBytes(bytecode.data(), bytecode.size()));
+    data.insert(data.end(), bytecode.begin(), bytecode.end());
+
+    return WriteWholeFile(path, data);
+}
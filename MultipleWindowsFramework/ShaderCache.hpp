@@ -0,0 +1,76 @@
+﻿//----------------------------------------------------------------------------------------------------
+// ShaderCache.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+// 一次編譯的完整輸入；任何欄位改變都會得到不同的快取鍵
+struct sShaderSource
+{
+    std::string  name;                      // 僅用於錯誤訊息與 pack 內的標示
+    std::string  source;
+    std::string  entryPoint = "main";
+    std::string  target;                    // vs_4_0、ps_4_0 ...
+    unsigned int flags      = 0;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 回傳 false 表示編譯失敗，errors 為編譯器輸出
+using ShaderCompileFunction = std::function<bool(sShaderSource const& source, std::vector<uint8_t>& bytecode, std::string& errors)>;
+
+//----------------------------------------------------------------------------------------------------
+struct sShaderPackEntry
+{
+    uint64_t             key = 0;
+    std::string          name;
+    std::vector<uint8_t> bytecode;
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sShaderCacheStats
+{
+    unsigned int packHits        = 0;
+    unsigned int diskHits        = 0;
+    unsigned int compiles        = 0;
+    unsigned int compileFailures = 0;
+    unsigned int diskWrites      = 0;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 以原始碼內容雜湊為鍵的 bytecode 快取：建置時產生的 pack -> 磁碟快取 -> 即時編譯
+class ShaderCache
+{
+public:
+    explicit ShaderCache(std::string const& cacheDirectory = std::string(), ShaderCompileFunction compiler = nullptr);
+
+    // pack 不存在或損毀時回傳 false，已載入的內容不受影響
+    bool LoadPack(std::string const& path);
+    void AddPrecompiled(uint64_t key, std::vector<uint8_t> const& bytecode);
+
+    bool GetBytecode(sShaderSource const& source, std::vector<uint8_t>& bytecode, std::string* errors = nullptr);
+
+    std::string              GetCacheFilePath(uint64_t key) const;
+    sShaderCacheStats const& GetStats() const { return m_stats; }
+
+private:
+    bool ReadCacheFile(uint64_t key, std::vector<uint8_t>& bytecode) const;
+    bool WriteCacheFile(uint64_t key, std::vector<uint8_t> const& bytecode) const;
+
+    std::string                                        m_cacheDirectory;    // 空字串表示不使用磁碟快取
+    ShaderCompileFunction                              m_compiler;
+    std::unordered_map<uint64_t, std::vector<uint8_t>> m_precompiled;
+    sShaderCacheStats                                  m_stats;
+};
+
+//----------------------------------------------------------------------------------------------------
+uint64_t HashShaderSource(sShaderSource const& source);
+
+bool WriteShaderPack(std::string const& path, std::vector<sShaderPackEntry> const& entries);
+bool ReadShaderPack(std::string const& path, std::vector<sShaderPackEntry>& entries);
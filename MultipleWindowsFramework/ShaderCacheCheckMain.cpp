@@ -0,0 +1,409 @@
+﻿//----------------------------------------------------------------------------------------------------
+// ShaderCacheCheckMain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// shader 快取、註冊表與 pack 的檢查 (不屬於 Windows 專案，在 Linux 上單獨編譯)：
+//
+//   g++ -std=c++14 -O2 ShaderCacheCheckMain.cpp ShaderCache.cpp ShaderRegistry.cpp BuiltInShaders.cpp -o shader_cache_check
+//   ./shader_cache_check
+//
+// 以假的編譯器 (bytecode 由原始碼決定，含 "#error" 時失敗) 取代 D3DCompile，檢查快取鍵對每個欄位敏感、
+// 磁碟快取與 pack 的來回、損毀或截斷的快取檔與 pack 一律不採用，以及不採用時退回即時編譯
+// 快取檔與 pack 寫在目前的目錄 (*.cso、shader_check.pack)，檢查後刪除
+// 結束碼：0 = 全部通過，1 = 失敗
+//----------------------------------------------------------------------------------------------------
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "BuiltInShaders.hpp"
+#include "CheckMain.hpp"
+#include "ShaderCache.hpp"
+#include "ShaderRegistry.hpp"
+
+//----------------------------------------------------------------------------------------------------
+static char const* const PACK_PATH       = "shader_check.pack";
+static char const* const CACHE_DIRECTORY = ".";
+
+//----------------------------------------------------------------------------------------------------
+// 與 ShaderCache.cpp 相同的 FNV-1a，用來製作校驗碼正確但內容錯誤的 pack
+static uint64_t HashBytes(uint8_t const* bytes, size_t const size)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+static std::vector<uint8_t> ReadFile(std::string const& path)
+{
+    std::vector<uint8_t> data;
+    FILE*                file = fopen(path.c_str(), "rb");
+    if (!file) return data;
+
+    int value;
+    while ((value = fgetc(file)) != EOF)
+    {
+        data.push_back((uint8_t)value);
+    }
+    fclose(file);
+    return data;
+}
+
+static void WriteFile(std::string const& path, std::vector<uint8_t> const& data)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return;
+    if (!data.empty()) fwrite(data.data(), 1, data.size(), file);
+    fclose(file);
+}
+
+// 修改內容後重新計算結尾的校驗碼
+static void WriteResealedPack(std::string const& path, std::vector<uint8_t> data)
+{
+    data.resize(data.size() - 8);
+    uint64_t const checksum = HashBytes(data.data(), data.size());
+    for (int i = 0; i < 8; ++i)
+    {
+        data.push_back((uint8_t)(checksum >> (i * 8)));
+    }
+    WriteFile(path, data);
+}
+
+//----------------------------------------------------------------------------------------------------
+// 假的編譯器：bytecode 為 target、進入點與原始碼的雜湊，可以驗證取回的內容來自哪一份原始碼
+class StubCompiler
+{
+public:
+    static std::vector<uint8_t> Expected(sShaderSource const& source)
+    {
+        std::string const    text = source.target + "|" + source.entryPoint + "|" + source.source;
+        uint64_t const       hash = HashBytes(reinterpret_cast<uint8_t const*>(text.data()), text.size());
+        std::vector<uint8_t> bytecode(source.target.begin(), source.target.end());
+        for (int i = 0; i < 8; ++i)
+        {
+            bytecode.push_back((uint8_t)(hash >> (i * 8)));
+        }
+        return bytecode;
+    }
+
+    ShaderCompileFunction GetFunction()
+    {
+        return [this](sShaderSource const& source, std::vector<uint8_t>& bytecode, std::string& errors)
+        {
+            ++m_calls;
+            if (source.source.find("#error") != std::string::npos)
+            {
+                errors = source.name + ": #error";
+                return false;
+            }
+            bytecode = Expected(source);
+            return true;
+        };
+    }
+
+    unsigned int GetCalls() const { return m_calls; }
+
+private:
+    unsigned int m_calls = 0;
+};
+
+//----------------------------------------------------------------------------------------------------
+static sShaderSource MakeSource(char const* text)
+{
+    sShaderSource source;
+    source.name   = "test";
+    source.source = text;
+    source.target = "ps_4_0";
+    return source;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 每個影響編譯結果的欄位都改變鍵；名稱只用於訊息，不影響鍵；欄位邊界不會互相滑動
+static bool CheckKeys()
+{
+    sShaderSource const base = MakeSource("float4 main() : SV_TARGET { return 1; }");
+
+    sShaderSource renamed  = base;
+    renamed.name           = "other";
+    sShaderSource edited   = base;
+    edited.source         += " ";
+    sShaderSource entry    = base;
+    entry.entryPoint       = "main2";
+    sShaderSource target   = base;
+    target.target          = "ps_5_0";
+    sShaderSource flags    = base;
+    flags.flags            = 1;
+
+    sShaderSource left  = base;
+    left.source         = "ab";
+    left.entryPoint     = "c";
+    sShaderSource right = base;
+    right.source        = "a";
+    right.entryPoint    = "bc";
+
+    uint64_t const key = HashShaderSource(base);
+
+    bool isPassing = true;
+    isPassing &= Check(HashShaderSource(base) == key && HashShaderSource(renamed) == key, "key_stable");
+    isPassing &= Check(HashShaderSource(edited) != key && HashShaderSource(entry) != key &&
+                       HashShaderSource(target) != key && HashShaderSource(flags) != key, "key_field_sensitive");
+    isPassing &= Check(HashShaderSource(left) != HashShaderSource(right), "key_field_boundaries");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 第一次編譯並寫入磁碟快取；下一個行程 (新的 ShaderCache) 直接讀回；損毀或截斷的快取檔重新編譯
+static bool CheckDiskCache()
+{
+    sShaderSource const  source   = MakeSource("disk cache");
+    std::vector<uint8_t> expected = StubCompiler::Expected(source);
+
+    StubCompiler         firstCompiler;
+    ShaderCache          first(CACHE_DIRECTORY, firstCompiler.GetFunction());
+    std::string const    path = first.GetCacheFilePath(HashShaderSource(source));
+    std::vector<uint8_t> bytecode;
+    remove(path.c_str());
+
+    bool const isCompiled = first.GetBytecode(source, bytecode) && bytecode == expected &&
+                            first.GetStats().compiles == 1 && first.GetStats().diskWrites == 1;
+
+    StubCompiler secondCompiler;
+    ShaderCache  second(CACHE_DIRECTORY, secondCompiler.GetFunction());
+    bytecode.clear();
+    bool const isDiskHit = second.GetBytecode(source, bytecode) && bytecode == expected &&
+                           second.GetStats().diskHits == 1 && secondCompiler.GetCalls() == 0;
+
+    // 翻轉 bytecode 的最後一個位元組：校驗碼不符
+    std::vector<uint8_t> data = ReadFile(path);
+    if (!data.empty()) data.back() ^= 0x01;
+    WriteFile(path, data);
+
+    StubCompiler corruptCompiler;
+    ShaderCache  corrupt(CACHE_DIRECTORY, corruptCompiler.GetFunction());
+    bytecode.clear();
+    bool const isCorruptRecompiled = corrupt.GetBytecode(source, bytecode) && bytecode == expected &&
+                                     corrupt.GetStats().diskHits == 0 && corruptCompiler.GetCalls() == 1;
+
+    // 截斷：少了最後一個位元組
+    data = ReadFile(path);
+    if (!data.empty()) data.pop_back();
+    WriteFile(path, data);
+
+    StubCompiler truncatedCompiler;
+    ShaderCache  truncated(CACHE_DIRECTORY, truncatedCompiler.GetFunction());
+    bytecode.clear();
+    bool const isTruncatedRecompiled = truncated.GetBytecode(source, bytecode) && bytecode == expected &&
+                                       truncated.GetStats().diskHits == 0 && truncatedCompiler.GetCalls() == 1;
+
+    // 重新編譯後寫回的檔案再次可用
+    ShaderCache rewritten(CACHE_DIRECTORY, nullptr);
+    bytecode.clear();
+    bool const isRewritten = rewritten.GetBytecode(source, bytecode) && bytecode == expected && rewritten.GetStats().diskHits == 1;
+
+    remove(path.c_str());
+
+    bool isPassing = true;
+    isPassing &= Check(isCompiled, "disk_first_compile");
+    isPassing &= Check(isDiskHit, "disk_round_trip");
+    isPassing &= Check(isCorruptRecompiled, "disk_corrupt_recompiles");
+    isPassing &= Check(isTruncatedRecompiled, "disk_truncated_recompiles");
+    isPassing &= Check(isRewritten, "disk_rewritten");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 編譯失敗不寫入快取；沒有編譯器又沒有快取時回報錯誤
+static bool CheckCompileFailures()
+{
+    sShaderSource const source = MakeSource("#error broken");
+
+    StubCompiler         compiler;
+    ShaderCache          cache(CACHE_DIRECTORY, compiler.GetFunction());
+    std::vector<uint8_t> bytecode;
+    std::string          errors;
+    bool const           isFailed = !cache.GetBytecode(source, bytecode, &errors) && errors == "test: #error" &&
+                                    cache.GetStats().compileFailures == 1 && cache.GetStats().diskWrites == 0 &&
+                                    ReadFile(cache.GetCacheFilePath(HashShaderSource(source))).empty();
+
+    ShaderCache noCompiler;
+    errors.clear();
+    bool const isMissing = !noCompiler.GetBytecode(MakeSource("anything"), bytecode, &errors) && !errors.empty() &&
+                           noCompiler.GetStats().compileFailures == 1 && noCompiler.GetStats().compiles == 0;
+
+    bool isPassing = true;
+    isPassing &= Check(isFailed, "compile_failure_not_cached");
+    isPassing &= Check(isMissing, "no_compiler_reports_error");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 每個程式的 bytecode 都是假編譯器對它原始碼的輸出
+static bool IsRegistryCompiled(ShaderRegistry const& registry, std::vector<char const*> const& names)
+{
+    for (char const* name : names)
+    {
+        sShaderProgram const* program = registry.Find(name);
+        if (!program || !program->isCompiled) return false;
+        if (program->vertexBytecode != StubCompiler::Expected(GetVertexShaderSource(program->desc))) return false;
+        if (program->pixelBytecode != StubCompiler::Expected(GetPixelShaderSource(program->desc))) return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 內建 shader 的註冊表：編譯、寫成 pack、由 pack 載入後完全不需要編譯器
+static bool CheckRegistryAndPack()
+{
+    std::vector<char const*> const names = {SHADER_FULLSCREEN_TEXTURE, SHADER_SPRITE, SHADER_TILE_CHECKSUM};
+
+    // 建置時：即時編譯所有內建 shader (不使用磁碟快取)
+    StubCompiler   buildCompiler;
+    ShaderCache    buildCache(std::string(), buildCompiler.GetFunction());
+    ShaderRegistry buildRegistry;
+    RegisterBuiltInShaders(buildRegistry);
+
+    size_t const programs   = buildRegistry.GetProgramCount();
+    bool const   isBuilt    = buildRegistry.Compile(buildCache) && IsRegistryCompiled(buildRegistry, names) &&
+                              buildCompiler.GetCalls() == programs * 2 && !buildRegistry.Find("Missing");
+    bool const   isIdempotent = buildRegistry.Compile(buildCache) && buildCompiler.GetCalls() == programs * 2;
+
+    std::vector<sShaderPackEntry> const entries = buildRegistry.CollectPackEntries();
+    bool const                          isWritten = entries.size() == programs * 2 && WriteShaderPack(PACK_PATH, entries);
+
+    // pack 的內容原樣讀回
+    std::vector<sShaderPackEntry> loaded;
+    bool isRoundTrip = ReadShaderPack(PACK_PATH, loaded) && loaded.size() == entries.size();
+    for (size_t i = 0; isRoundTrip && i < entries.size(); ++i)
+    {
+        isRoundTrip &= loaded[i].key == entries[i].key && loaded[i].name == entries[i].name && loaded[i].bytecode == entries[i].bytecode;
+    }
+
+    // 執行時：只有 pack，沒有編譯器也沒有磁碟快取
+    ShaderCache    runtimeCache;
+    ShaderRegistry runtimeRegistry;
+    RegisterBuiltInShaders(runtimeRegistry);
+    bool const isPackOnly = runtimeCache.LoadPack(PACK_PATH) && runtimeRegistry.Compile(runtimeCache) &&
+                            IsRegistryCompiled(runtimeRegistry, names) &&
+                            runtimeCache.GetStats().packHits == programs * 2 && runtimeCache.GetStats().compiles == 0;
+
+    // 修改一個程式的 pixel shader：同名取代並重新編譯，vertex shader 仍命中 pack，只有 pixel shader 即時編譯
+    StubCompiler   editCompiler;
+    ShaderCache    editCache(std::string(), editCompiler.GetFunction());
+    ShaderRegistry editRegistry;
+    RegisterBuiltInShaders(editRegistry);
+
+    sShaderProgramDesc edited = editRegistry.Find(SHADER_SPRITE)->desc;
+    edited.pixelSource       += "\n// edited\n";
+    editRegistry.Register(edited);
+
+    bool const isReplaced = editRegistry.GetProgramCount() == programs && !editRegistry.Find(SHADER_SPRITE)->isCompiled;
+    bool const isEdited   = editCache.LoadPack(PACK_PATH) && editRegistry.Compile(editCache) &&
+                            IsRegistryCompiled(editRegistry, names) &&
+                            editCache.GetStats().packHits == programs * 2 - 1 && editCompiler.GetCalls() == 1;
+
+    bool isPassing = true;
+    isPassing &= Check(isBuilt, "registry_compile");
+    isPassing &= Check(isIdempotent, "registry_compile_once");
+    isPassing &= Check(isWritten && isRoundTrip, "pack_round_trip");
+    isPassing &= Check(isPackOnly, "pack_replaces_compiler");
+    isPassing &= Check(isReplaced, "registry_replace_by_name");
+    isPassing &= Check(isEdited, "pack_stale_entry_recompiles");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 任何截斷、任何一個位元組的損毀、校驗碼正確但格式錯誤的 pack 都不採用；失敗時已載入的內容不變，並退回即時編譯
+static bool CheckCorruptPacks()
+{
+    std::vector<uint8_t> const good       = ReadFile(PACK_PATH);
+    std::string const          badPath    = std::string(PACK_PATH) + ".bad";
+    std::vector<uint8_t>       discarded;
+
+    bool isTruncationRejected = !good.empty();
+    for (size_t size = 0; size < good.size() && isTruncationRejected; ++size)
+    {
+        WriteFile(badPath, std::vector<uint8_t>(good.begin(), good.begin() + size));
+        std::vector<sShaderPackEntry> entries;
+        isTruncationRejected &= !ReadShaderPack(badPath, entries);
+    }
+
+    bool isCorruptionRejected = !good.empty();
+    for (size_t offset = 0; offset < good.size() && isCorruptionRejected; ++offset)
+    {
+        std::vector<uint8_t> data = good;
+        data[offset] ^= 0x40;
+        WriteFile(badPath, data);
+        std::vector<sShaderPackEntry> entries;
+        isCorruptionRejected &= !ReadShaderPack(badPath, entries);
+    }
+
+    // 校驗碼正確：錯誤的 magic、錯誤的版本、項目數多於內容、結尾多出位元組
+    std::vector<uint8_t> wrongMagic   = good;
+    wrongMagic[0]                    ^= 0x01;
+    std::vector<uint8_t> wrongVersion = good;
+    wrongVersion[4]                  += 1;
+    std::vector<uint8_t> extraCount   = good;
+    extraCount[8]                    += 1;
+    std::vector<uint8_t> trailing     = good;
+    trailing.insert(trailing.end() - 8, 0);
+
+    bool isMalformedRejected = true;
+    for (std::vector<uint8_t> const* data : {&wrongMagic, &wrongVersion, &extraCount, &trailing})
+    {
+        WriteResealedPack(badPath, *data);
+        std::vector<sShaderPackEntry> entries;
+        isMalformedRejected &= !ReadShaderPack(badPath, entries);
+    }
+    WriteResealedPack(badPath, good);
+    std::vector<sShaderPackEntry> resealed;
+    bool const isResealAccepted = ReadShaderPack(badPath, resealed);
+
+    // 損毀的 pack 不影響已載入的 pack
+    ShaderCache    kept;
+    ShaderRegistry keptRegistry;
+    RegisterBuiltInShaders(keptRegistry);
+    WriteFile(badPath, std::vector<uint8_t>(good.begin(), good.end() - 1));
+    bool const isKept = kept.LoadPack(PACK_PATH) && !kept.LoadPack(badPath) && keptRegistry.Compile(kept) &&
+                        kept.GetStats().packHits == keptRegistry.GetProgramCount() * 2;
+
+    // 只有損毀的 pack：全部退回即時編譯，結果與 pack 中的相同
+    StubCompiler   fallbackCompiler;
+    ShaderCache    fallback(std::string(), fallbackCompiler.GetFunction());
+    ShaderRegistry fallbackRegistry;
+    RegisterBuiltInShaders(fallbackRegistry);
+    bool const isFallback = !fallback.LoadPack(badPath) && !fallback.LoadPack("shader_check_missing.pack") &&
+                            fallbackRegistry.Compile(fallback) &&
+                            IsRegistryCompiled(fallbackRegistry, {SHADER_FULLSCREEN_TEXTURE, SHADER_SPRITE, SHADER_TILE_CHECKSUM}) &&
+                            fallback.GetStats().packHits == 0 && fallbackCompiler.GetCalls() == fallbackRegistry.GetProgramCount() * 2;
+
+    remove(badPath.c_str());
+
+    printf("pack_bytes %zu\n", good.size());
+
+    bool isPassing = true;
+    isPassing &= Check(isTruncationRejected, "pack_truncation_rejected");
+    isPassing &= Check(isCorruptionRejected, "pack_corruption_rejected");
+    isPassing &= Check(isMalformedRejected && isResealAccepted, "pack_malformed_rejected");
+    isPassing &= Check(isKept, "pack_failed_load_keeps_entries");
+    isPassing &= Check(isFallback, "pack_fallback_compiles");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+int main()
+{
+    bool isPassing = true;
+    isPassing &= CheckKeys();
+    isPassing &= CheckDiskCache();
+    isPassing &= CheckCompileFailures();
+    isPassing &= CheckRegistryAndPack();
+    isPassing &= CheckCorruptPacks();
+
+    remove(PACK_PATH);
+    return isPassing ? 0 : 1;
+}
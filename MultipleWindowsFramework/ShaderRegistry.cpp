@@ -0,0 +1,95 @@
+﻿//----------------------------------------------------------------------------------------------------
+// ShaderRegistry.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "ShaderRegistry.hpp"
+
+//----------------------------------------------------------------------------------------------------
+sShaderSource GetVertexShaderSource(sShaderProgramDesc const& desc)
+{
+    sShaderSource source;
+    source.name   = desc.name + ".vs";
+    source.source = desc.vertexSource;
+    source.target = "vs_4_0";
+    return source;
+}
+
+//----------------------------------------------------------------------------------------------------
+sShaderSource GetPixelShaderSource(sShaderProgramDesc const& desc)
+{
+    sShaderSource source;
+    source.name   = desc.name + ".ps";
+    source.source = desc.pixelSource;
+    source.target = "ps_4_0";
+    return source;
+}
+
+//----------------------------------------------------------------------------------------------------
+void ShaderRegistry::Register(sShaderProgramDesc const& desc)
+{
+    sShaderProgram program;
+    program.desc = desc;
+
+    for (sShaderProgram& existing : m_programs)
+    {
+        if (existing.desc.name == desc.name)
+        {
+            existing = program;
+            return;
+        }
+    }
+    m_programs.push_back(program);
+}
+
+//----------------------------------------------------------------------------------------------------
+bool ShaderRegistry::Compile(ShaderCache& cache, std::string* errors)
+{
+    bool isAllCompiled = true;
+
+    for (sShaderProgram& program : m_programs)
+    {
+        if (program.isCompiled) continue;
+
+        std::string stageErrors;
+        bool const  isVertexOk = cache.GetBytecode(GetVertexShaderSource(program.desc), program.vertexBytecode, &stageErrors);
+        if (!isVertexOk && errors) *errors += program.desc.name + " (vs): " + stageErrors + "\n";
+
+        stageErrors.clear();
+        bool const isPixelOk = cache.GetBytecode(GetPixelShaderSource(program.desc), program.pixelBytecode, &stageErrors);
+        if (!isPixelOk && errors) *errors += program.desc.name + " (ps): " + stageErrors + "\n";
+
+        program.isCompiled = isVertexOk && isPixelOk;
+        isAllCompiled      = isAllCompiled && program.isCompiled;
+    }
+
+    return isAllCompiled;
+}
+
+//----------------------------------------------------------------------------------------------------
+sShaderProgram const* ShaderRegistry::Find(std::string const& name) const
+{
+    for (sShaderProgram const& program : m_programs)
+    {
+        if (program.desc.name == name) return &program;
+    }
+    return nullptr;
+}
+
+//----------------------------------------------------------------------------------------------------
+std::vector<sShaderPackEntry> ShaderRegistry::CollectPackEntries() const
+{
+    std::vector<sShaderPackEntry> entries;
+
+    for (sShaderProgram const& program : m_programs)
+    {
+        if (!program.isCompiled) continue;
+
+        sShaderSource const vertexSource = GetVertexShaderSource(program.desc);
+        sShaderSource const pixelSource  = GetPixelShaderSource(program.desc);
+
+        entries.push_back({HashShaderSource(vertexSource), vertexSource.name, program.vertexBytecode});
+        entries.push_back({HashShaderSource(pixelSource), pixelSource.name, program.pixelBytecode});
+    }
+    return entries;
+}
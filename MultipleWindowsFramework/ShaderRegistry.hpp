@@ -0,0 +1,73 @@
+﻿//----------------------------------------------------------------------------------------------------
+// ShaderRegistry.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <string>
+#include <vector>
+
+#include "ShaderCache.hpp"
+
+//----------------------------------------------------------------------------------------------------
+// 與平台無關的頂點格式，Renderer 轉換為 DXGI_FORMAT
+enum class eShaderInputFormat
+{
+    R32_FLOAT,
+    R32G32_FLOAT,
+    R32G32B32_FLOAT,
+    R32G32B32A32_FLOAT,
+    R8G8B8A8_UNORM
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sShaderInputElement
+{
+    char const*        semantic      = nullptr;
+    unsigned int       semanticIndex = 0;
+    eShaderInputFormat format        = eShaderInputFormat::R32G32B32A32_FLOAT;
+    unsigned int       slot          = 0;
+    unsigned int       offset        = 0;
+    bool               isPerInstance = false;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 一組 vertex / pixel shader 與其 input layout，進入點固定為 main
+struct sShaderProgramDesc
+{
+    std::string                      name;
+    std::string                      vertexSource;
+    std::string                      pixelSource;
+    std::vector<sShaderInputElement> inputLayout;
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sShaderProgram
+{
+    sShaderProgramDesc   desc;
+    std::vector<uint8_t> vertexBytecode;
+    std::vector<uint8_t> pixelBytecode;
+    bool                 isCompiled = false;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 以名稱查詢 shader：註冊原始碼與 input layout，經由 ShaderCache 取得 bytecode
+class ShaderRegistry
+{
+public:
+    void Register(sShaderProgramDesc const& desc);     // 同名時取代並需要重新編譯
+
+    // 編譯所有尚未編譯的程式；任一失敗時回傳 false，其餘仍會嘗試
+    bool Compile(ShaderCache& cache, std::string* errors = nullptr);
+
+    sShaderProgram const*         Find(std::string const& name) const;
+    size_t                        GetProgramCount() const { return m_programs.size(); }
+    std::vector<sShaderPackEntry> CollectPackEntries() const;  // 已編譯的 bytecode，供建置時寫成 pack
+
+private:
+    std::vector<sShaderProgram> m_programs;
+};
+
+//----------------------------------------------------------------------------------------------------
+sShaderSource GetVertexShaderSource(sShaderProgramDesc const& desc);
+sShaderSource GetPixelShaderSource(sShaderProgramDesc const& desc);
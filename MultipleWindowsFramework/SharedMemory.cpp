@@ -0,0 +1,165 @@
+﻿//----------------------------------------------------------------------------------------------------
+// SharedMemory.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "SharedMemory.hpp"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//----------------------------------------------------------------------------------------------------
+SharedMemory::~SharedMemory()
+{
+    Close();
+}
+
+#if defined(_WIN32)
+//----------------------------------------------------------------------------------------------------
+bool SharedMemory::Create(char const* name, size_t const size)
+{
+    Close();
+    if (!name || size == 0) return false;
+
+    unsigned long long const size64 = size;
+    HANDLE const             mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                                          (DWORD)(size64 >> 32), (DWORD)(size64 & 0xFFFFFFFF), name);
+    if (!mapping) return false;
+    if (GetLastError() == ERROR_ALREADY_EXISTS)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    void* const view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    m_mapping = mapping;
+    m_data    = static_cast<uint8_t*>(view);
+    m_size    = size;
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool SharedMemory::Open(char const* name, bool const isReadOnly)
+{
+    Close();
+    if (!name) return false;
+
+    DWORD const  access  = isReadOnly ? FILE_MAP_READ : FILE_MAP_ALL_ACCESS;
+    HANDLE const mapping = OpenFileMappingA(access, FALSE, name);
+    if (!mapping) return false;
+
+    void* const view = MapViewOfFile(mapping, access, 0, 0, 0);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    // 對應整個區塊時大小由系統決定 (以頁為單位)
+    MEMORY_BASIC_INFORMATION info = {};
+    VirtualQuery(view, &info, sizeof(info));
+
+    m_mapping = mapping;
+    m_data    = static_cast<uint8_t*>(view);
+    m_size    = info.RegionSize;
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+void SharedMemory::Close()
+{
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_mapping) CloseHandle((HANDLE)m_mapping);
+
+    m_data    = nullptr;
+    m_size    = 0;
+    m_mapping = nullptr;
+}
+#else
+//----------------------------------------------------------------------------------------------------
+static std::string GetShmName(char const* name)
+{
+    return std::string("/") + name;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool SharedMemory::Create(char const* name, size_t const size)
+{
+    Close();
+    if (!name || size == 0) return false;
+
+    std::string const shmName = GetShmName(name);
+    int const         fd      = shm_open(shmName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) return false;
+
+    if (ftruncate(fd, (off_t)size) != 0)
+    {
+        close(fd);
+        shm_unlink(shmName.c_str());
+        return false;
+    }
+
+    void* const view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);      // 對應建立後不再需要檔案描述子
+    if (view == MAP_FAILED)
+    {
+        shm_unlink(shmName.c_str());
+        return false;
+    }
+
+    m_data       = static_cast<uint8_t*>(view);
+    m_size       = size;
+    m_unlinkName = shmName;
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool SharedMemory::Open(char const* name, bool const isReadOnly)
+{
+    Close();
+    if (!name) return false;
+
+    std::string const shmName = GetShmName(name);
+    int const         fd      = shm_open(shmName.c_str(), isReadOnly ? O_RDONLY : O_RDWR, 0);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    size_t const size = (size_t)info.st_size;
+    void* const  view = mmap(nullptr, size, isReadOnly ? PROT_READ : (PROT_READ | PROT_WRITE), MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) return false;
+
+    m_data = static_cast<uint8_t*>(view);
+    m_size = size;
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+void SharedMemory::Close()
+{
+    if (m_data) munmap(m_data, m_size);
+    if (!m_unlinkName.empty()) shm_unlink(m_unlinkName.c_str());
+
+    m_data = nullptr;
+    m_size = 0;
+    m_unlinkName.clear();
+}
+#endif
@@ -0,0 +1,41 @@
+﻿//----------------------------------------------------------------------------------------------------
+// SharedMemory.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//----------------------------------------------------------------------------------------------------
+// 具名的跨行程共享記憶體：Windows 為分頁檔支援的 file mapping，其他平台為 POSIX shm
+// 名稱不需要平台前綴 (內部會補上 "/")
+class SharedMemory
+{
+public:
+    SharedMemory() = default;
+    ~SharedMemory();
+
+    SharedMemory(SharedMemory const&)            = delete;
+    SharedMemory& operator=(SharedMemory const&) = delete;
+
+    // 建立者擁有這塊記憶體；同名的區塊已存在 (另一個行程正在使用) 時失敗
+    bool Create(char const* name, size_t size);
+    bool Open(char const* name, bool isReadOnly = true);
+    void Close();
+
+    bool     IsOpen() const { return m_data != nullptr; }
+    uint8_t* GetData() const { return m_data; }
+    size_t   GetSize() const { return m_size; }
+
+private:
+    uint8_t* m_data = nullptr;
+    size_t   m_size = 0;
+
+#if defined(_WIN32)
+    void* m_mapping = nullptr;              // HANDLE
+#else
+    std::string m_unlinkName;               // 建立者關閉時移除名稱
+#endif
+};
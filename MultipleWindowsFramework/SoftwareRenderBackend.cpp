@@ -0,0 +1,385 @@
+﻿//----------------------------------------------------------------------------------------------------
+// SoftwareRenderBackend.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "SoftwareRenderBackend.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "ThreadPool.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define SOFTWARE_RENDER_USE_SSE2 1
+#include <emmintrin.h>
+#else
+#define SOFTWARE_RENDER_USE_SSE2 0
+#endif
+
+//----------------------------------------------------------------------------------------------------
+static int WrapTexel(int const value, int const size)
+{
+    int const wrapped = value % size;
+    return wrapped < 0 ? wrapped + size : wrapped;
+}
+
+//----------------------------------------------------------------------------------------------------
+static uint32_t PackClearColor(float const color[4])
+{
+    uint32_t packed = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        float const clamped = (std::min)(1.f, (std::max)(0.f, color[i]));
+        packed |= (uint32_t)(clamped * 255.f + 0.5f) << (i * 8);
+    }
+    return packed;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 8 位元定點權重 (0-256) 的雙線性混合，四個通道同時計算
+static inline uint32_t BlendBilinear(uint32_t const c00,
+                                     uint32_t const c10,
+                                     uint32_t const c01,
+                                     uint32_t const c11,
+                                     int const      weightX,
+                                     int const      weightY)
+{
+#if SOFTWARE_RENDER_USE_SSE2
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const half = _mm_set1_epi16(128);
+
+    // 低 4 個 16 位元通道為左側 texel，高 4 個為右側 texel
+    __m128i top    = _mm_unpacklo_epi8(_mm_set_epi32(0, 0, (int)c10, (int)c00), zero);
+    __m128i bottom = _mm_unpacklo_epi8(_mm_set_epi32(0, 0, (int)c11, (int)c01), zero);
+
+    short const   inverseX = (short)(256 - weightX);
+    short const   forwardX = (short)weightX;
+    __m128i const weightsX = _mm_set_epi16(forwardX, forwardX, forwardX, forwardX, inverseX, inverseX, inverseX, inverseX);
+
+    top    = _mm_mullo_epi16(top, weightsX);
+    bottom = _mm_mullo_epi16(bottom, weightsX);
+    top    = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(top, _mm_srli_si128(top, 8)), half), 8);
+    bottom = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(bottom, _mm_srli_si128(bottom, 8)), half), 8);
+
+    __m128i result = _mm_add_epi16(_mm_mullo_epi16(top, _mm_set1_epi16((short)(256 - weightY))),
+                                   _mm_mullo_epi16(bottom, _mm_set1_epi16((short)weightY)));
+    result = _mm_srli_epi16(_mm_add_epi16(result, half), 8);
+
+    return (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(result, zero));
+#else
+    uint32_t result = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        uint32_t const top    = (((c00 >> shift) & 0xFF) * (256 - weightX) + ((c10 >> shift) & 0xFF) * weightX + 128) >> 8;
+        uint32_t const bottom = (((c01 >> shift) & 0xFF) * (256 - weightX) + ((c11 >> shift) & 0xFF) * weightX + 128) >> 8;
+        uint32_t const value  = (top * (256 - weightY) + bottom * weightY + 128) >> 8;
+        result |= value << shift;
+    }
+    return result;
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------
+// 將目的像素中心 (0.5 起算) 對應到紋理上的兩個相鄰 texel 與權重，與 GPU 的線性環繞取樣相同
+static void ComputeLinearTap(int const  index,
+                             int const  targetSize,
+                             int const  textureSize,
+                             int&       texel0,
+                             int&       texel1,
+                             int&       weight)
+{
+    float const coordinate = ((float)index + 0.5f) / (float)targetSize * (float)textureSize - 0.5f;
+    float const base       = std::floor(coordinate);
+
+    texel0 = WrapTexel((int)base, textureSize);
+    texel1 = WrapTexel(texel0 + 1, textureSize);
+    weight = (std::min)(256, (int)((coordinate - base) * 256.f + 0.5f));
+}
+
+//----------------------------------------------------------------------------------------------------
+SoftwareRenderBackend::SoftwareRenderBackend(ThreadPool& threadPool)
+    : m_threadPool(threadPool)
+{
+}
+
+//----------------------------------------------------------------------------------------------------
+unsigned int SoftwareRenderBackend::CreateSceneTexture(uint32_t const* pixels,
+                                                      unsigned int const width,
+                                                      unsigned int const height)
+{
+    if (!pixels || width == 0 || height == 0) return INVALID_SCENE_TEXTURE_ID;
+
+    sTexture texture;
+    texture.width  = width;
+    texture.height = height;
+    texture.pixels.assign(pixels, pixels + (size_t)width * height);
+    m_textures.push_back(std::move(texture));
+
+    // 新增紋理可能使 vector 重新配置，重建所有檢視
+    m_spriteTextures.clear();
+    for (sTexture const& current : m_textures)
+    {
+        m_spriteTextures.push_back({current.pixels.data(), (int)current.width, (int)current.height});
+    }
+
+    return (unsigned int)m_textures.size() - 1;
+}
+
+//----------------------------------------------------------------------------------------------------
+unsigned int SoftwareRenderBackend::CreateDynamicSceneTexture(unsigned int const width, unsigned int const height)
+{
+    if (width == 0 || height == 0) return INVALID_SCENE_TEXTURE_ID;
+
+    std::vector<uint32_t> const pixels((size_t)width * height, 0);
+    return CreateSceneTexture(pixels.data(), width, height);
+}
+
+//----------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::UpdateSceneTexture(unsigned int const textureId,
+                                               sRect const&       rect,
+                                               uint32_t const*    pixels,
+                                               unsigned int const pitch)
+{
+    if (textureId >= m_textures.size() || !pixels) return;
+
+    sTexture&   texture = m_textures[textureId];
+    sRect const clipped = rect.Intersect({0, 0, (int)texture.width, (int)texture.height});
+    if (clipped.IsEmpty()) return;
+
+    // 紋理緩衝區的位址不變，精靈檢視不需要重建
+    for (int y = clipped.top; y < clipped.bottom; ++y)
+    {
+        memcpy(texture.pixels.data() + (size_t)y * texture.width + clipped.left,
+               pixels + (size_t)y * pitch + clipped.left,
+               (size_t)clipped.GetWidth() * 4);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+int SoftwareRenderBackend::GetBandCount() const
+{
+    // 每個執行緒分到數個帶狀區域，讓負載不均時仍能平衡
+    int const participants = (int)m_threadPool.GetWorkerCount() + 1;
+    return (std::max)(1, (std::min)((int)m_target.height, participants * 4));
+}
+
+//----------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::ClearTarget(uint32_t const color)
+{
+    int const bandCount = GetBandCount();
+    m_threadPool.ParallelFor(bandCount, [this, color, bandCount](int const band)
+    {
+        unsigned int const rowBegin = m_target.height * band / bandCount;
+        unsigned int const rowEnd   = m_target.height * (band + 1) / bandCount;
+
+        for (unsigned int y = rowBegin; y < rowEnd; ++y)
+        {
+            uint32_t*    row = reinterpret_cast<uint32_t*>(m_target.pixels + (size_t)y * m_target.pitch);
+            unsigned int x   = 0;
+#if SOFTWARE_RENDER_USE_SSE2
+            __m128i const color4 = _mm_set1_epi32((int)color);
+            for (; x + 4 <= m_target.width; x += 4)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(row + x), color4);
+            }
+#endif
+            for (; x < m_target.width; ++x)
+            {
+                row[x] = color;
+            }
+        }
+    });
+}
+
+//----------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::BeginScene(sSceneTarget const& target, float const clearColor[4])
+{
+    m_target      = target;
+    m_sceneTarget = target;
+    if (!m_target.pixels || m_target.width == 0 || m_target.height == 0) return;
+
+    if (clearColor)
+    {
+        ClearTarget(PackClearColor(clearColor));
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::DrawFullscreenTexture(unsigned int const textureId)
+{
+    if (!m_target.pixels || textureId >= m_textures.size()) return;
+
+    sTexture const& texture = m_textures[textureId];
+    if (texture.width == 0 || texture.height == 0) return;
+
+    // 同一幀內每一列的水平取樣位置都相同，先算好整欄的表
+    m_columnTexel0.resize(m_target.width);
+    m_columnTexel1.resize(m_target.width);
+    m_columnWeight.resize(m_target.width);
+
+    for (unsigned int x = 0; x < m_target.width; ++x)
+    {
+        int texel0, texel1, weight;
+        ComputeLinearTap((int)x, (int)m_target.width, (int)texture.width, texel0, texel1, weight);
+        m_columnTexel0[x] = texel0;
+        m_columnTexel1[x] = texel1;
+        m_columnWeight[x] = (uint16_t)weight;
+    }
+
+    int const bandCount = GetBandCount();
+    m_threadPool.ParallelFor(bandCount, [this, &texture, bandCount](int const band)
+    {
+        unsigned int const rowBegin = m_target.height * band / bandCount;
+        unsigned int const rowEnd   = m_target.height * (band + 1) / bandCount;
+
+        for (unsigned int y = rowBegin; y < rowEnd; ++y)
+        {
+            int row0, row1, weightY;
+            ComputeLinearTap((int)y, (int)m_target.height, (int)texture.height, row0, row1, weightY);
+
+            uint32_t const* source0     = texture.pixels.data() + (size_t)row0 * texture.width;
+            uint32_t const* source1     = texture.pixels.data() + (size_t)row1 * texture.width;
+            uint32_t*       destination = reinterpret_cast<uint32_t*>(m_target.pixels + (size_t)y * m_target.pitch);
+
+            for (unsigned int x = 0; x < m_target.width; ++x)
+            {
+                int const texel0 = m_columnTexel0[x];
+                int const texel1 = m_columnTexel1[x];
+                destination[x]   = BlendBilinear(source0[texel0], source0[texel1],
+                                                 source1[texel0], source1[texel1],
+                                                 m_columnWeight[x], weightY);
+            }
+        }
+    });
+}
+
+//----------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::DrawSprites(SpriteBatcher const& batcher)
+{
+    if (!m_target.pixels || batcher.GetInstances().empty()) return;
+
+    // 每個帶狀區域各自處理所有精靈，只寫入自己的列，不需要同步
+    int const bandCount = GetBandCount();
+    m_threadPool.ParallelFor(bandCount, [this, &batcher, bandCount](int const band)
+    {
+        int const rowBegin = (int)(m_target.height * band / bandCount);
+        int const rowEnd   = (int)(m_target.height * (band + 1) / bandCount);
+
+        RasterizeSpriteBatches(batcher, m_spriteTextures,
+                               reinterpret_cast<uint32_t*>(m_target.pixels),
+                               (int)m_target.width, (int)m_target.height, (int)(m_target.pitch / 4),
+                               rowBegin, rowEnd);
+    });
+}
+
+//----------------------------------------------------------------------------------------------------
+bool SoftwareRenderBackend::EndScene()
+{
+    // 已直接寫入目的緩衝區，不需要回讀
+    bool const hasTarget = m_sceneTarget.pixels != nullptr;
+    m_target             = sSceneTarget();
+    m_sceneTarget        = sSceneTarget();
+    return hasTarget;
+}
+
+//----------------------------------------------------------------------------------------------------
+size_t SoftwareRenderBackend::GetMemoryBytes() const
+{
+    size_t bytes = m_textures.capacity() * sizeof(sTexture) + m_spriteTextures.capacity() * sizeof(sSpriteTexture);
+    for (sTexture const& texture : m_textures)
+    {
+        bytes += texture.pixels.capacity() * sizeof(uint32_t);
+    }
+    for (std::vector<uint32_t> const& layer : m_layers)
+    {
+        bytes += layer.capacity() * sizeof(uint32_t);
+    }
+    bytes += (m_columnTexel0.capacity() + m_columnTexel1.capacity()) * sizeof(int) + m_columnWeight.capacity() * sizeof(uint16_t);
+    return bytes;
+}
+
+//----------------------------------------------------------------------------------------------------
+unsigned int SoftwareRenderBackend::CreateLayer()
+{
+    m_layers.emplace_back();
+    return (unsigned int)m_layers.size() - 1;
+}
+
+//----------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::BeginLayer(unsigned int const layerId, float const clearColor[4])
+{
+    if (!m_sceneTarget.pixels || layerId >= m_layers.size()) return;
+
+    // 容量只增不減，動態解析度來回切換時不重新配置
+    std::vector<uint32_t>& layer = m_layers[layerId];
+    layer.resize((size_t)m_sceneTarget.width * m_sceneTarget.height);
+
+    m_target.pixels = reinterpret_cast<uint8_t*>(layer.data());
+    m_target.width  = m_sceneTarget.width;
+    m_target.height = m_sceneTarget.height;
+    m_target.pitch  = m_sceneTarget.width * 4;
+
+    if (clearColor)
+    {
+        ClearTarget(PackClearColor(clearColor));
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::EndLayer()
+{
+    m_target = m_sceneTarget;
+}
+
+//----------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::CompositeLayer(unsigned int const layerId, bool const isOpaque)
+{
+    if (!m_target.pixels || layerId >= m_layers.size()) return;
+
+    std::vector<uint32_t> const& layer = m_layers[layerId];
+    if (layer.size() != (size_t)m_target.width * m_target.height) return;
+
+    int const bandCount = GetBandCount();
+    m_threadPool.ParallelFor(bandCount, [this, &layer, isOpaque, bandCount](int const band)
+    {
+        unsigned int const rowBegin = m_target.height * band / bandCount;
+        unsigned int const rowEnd   = m_target.height * (band + 1) / bandCount;
+
+        for (unsigned int y = rowBegin; y < rowEnd; ++y)
+        {
+            uint32_t const* source      = layer.data() + (size_t)y * m_target.width;
+            uint32_t*       destination = reinterpret_cast<uint32_t*>(m_target.pixels + (size_t)y * m_target.pitch);
+
+            if (isOpaque)
+            {
+                memcpy(destination, source, (size_t)m_target.width * 4);
+                continue;
+            }
+
+            // premultiplied over：dst = src + dst * (1 - srcAlpha)，全透明與全不透明的像素不必計算
+            for (unsigned int x = 0; x < m_target.width; ++x)
+            {
+                uint32_t const color = source[x];
+                uint32_t const alpha = color >> 24;
+                if (alpha == 0) continue;
+                if (alpha == 255)
+                {
+                    destination[x] = color;
+                    continue;
+                }
+
+                uint32_t const inverse = 255 - alpha;
+                uint32_t       result  = 0;
+                for (int shift = 0; shift < 32; shift += 8)
+                {
+                    uint32_t const scaled = ((destination[x] >> shift) & 0xFF) * inverse + 128;
+                    uint32_t const value  = ((color >> shift) & 0xFF) + ((scaled + (scaled >> 8)) >> 8);
+                    result |= (std::min)(value, 255u) << shift;
+                }
+                destination[x] = result;
+            }
+        }
+    });
+}
@@ -0,0 +1,63 @@
+﻿//----------------------------------------------------------------------------------------------------
+// SoftwareRenderBackend.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "RenderBackend.hpp"
+#include "SpriteBatch.hpp"
+
+//-Forward-Declaration--------------------------------------------------------------------------------
+class ThreadPool;
+
+//----------------------------------------------------------------------------------------------------
+// 不需要 GPU 的場景渲染：多執行緒、SIMD 的清除與線性環繞取樣，直接寫入 CPU 場景緩衝區
+class SoftwareRenderBackend : public RenderBackend
+{
+public:
+    explicit SoftwareRenderBackend(ThreadPool& threadPool);
+
+    unsigned int CreateSceneTexture(uint32_t const* pixels, unsigned int width, unsigned int height) override;
+    unsigned int CreateDynamicSceneTexture(unsigned int width, unsigned int height) override;
+    void         UpdateSceneTexture(unsigned int textureId, sRect const& rect, uint32_t const* pixels, unsigned int pitch) override;
+
+    void BeginScene(sSceneTarget const& target, float const clearColor[4]) override;
+    void DrawFullscreenTexture(unsigned int textureId) override;
+    void DrawSprites(SpriteBatcher const& batcher) override;
+    bool EndScene() override;
+
+    unsigned int CreateLayer() override;
+    void         BeginLayer(unsigned int layerId, float const clearColor[4]) override;
+    void         EndLayer() override;
+    void         CompositeLayer(unsigned int layerId, bool isOpaque) override;
+
+    size_t GetMemoryBytes() const;          // 紋理與圖層緩衝區 (不含 BeginScene 傳入的場景)
+
+private:
+    struct sTexture
+    {
+        std::vector<uint32_t> pixels;
+        unsigned int          width  = 0;
+        unsigned int          height = 0;
+    };
+
+    int  GetBandCount() const;
+    void ClearTarget(uint32_t color);
+
+    ThreadPool&                 m_threadPool;
+    std::vector<sTexture>       m_textures;
+    std::vector<sSpriteTexture> m_spriteTextures;       // 指向 m_textures 的檢視，供精靈光柵化使用
+    sSceneTarget                m_target;               // 目前的繪製目標：場景或 BeginLayer 指定的圖層
+    sSceneTarget                m_sceneTarget;
+
+    // 圖層為場景尺寸的 CPU 緩衝區 (緊密排列)
+    std::vector<std::vector<uint32_t>> m_layers;
+
+    // 全螢幕繪製時每一欄的取樣位置 (每幀依目標寬度重建)
+    std::vector<int>      m_columnTexel0;
+    std::vector<int>      m_columnTexel1;
+    std::vector<uint16_t> m_columnWeight;
+};
@@ -0,0 +1,250 @@
+﻿//----------------------------------------------------------------------------------------------------
+// SpriteBatch.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "SpriteBatch.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+//----------------------------------------------------------------------------------------------------
+void SpriteBatcher::Begin()
+{
+    m_sprites.clear();
+    m_order.clear();
+    m_instances.clear();
+    m_batches.clear();
+    m_stats = sSpriteBatchStats();
+}
+
+//----------------------------------------------------------------------------------------------------
+void SpriteBatcher::Draw(sSprite const& sprite)
+{
+    m_sprites.push_back(sprite);
+}
+
+//----------------------------------------------------------------------------------------------------
+void SpriteBatcher::End()
+{
+    m_instances.clear();
+    m_batches.clear();
+
+    // 依圖層再依紋理排序；穩定排序保留同一紋理內的提交順序
+    m_order.resize(m_sprites.size());
+    for (uint32_t i = 0; i < (uint32_t)m_order.size(); ++i)
+    {
+        m_order[i] = i;
+    }
+
+    std::stable_sort(m_order.begin(), m_order.end(), [this](uint32_t const a, uint32_t const b)
+    {
+        sSprite const& spriteA = m_sprites[a];
+        sSprite const& spriteB = m_sprites[b];
+        if (spriteA.layer != spriteB.layer) return spriteA.layer < spriteB.layer;
+        return spriteA.textureId < spriteB.textureId;
+    });
+
+    m_instances.reserve(m_order.size());
+
+    for (uint32_t const index : m_order)
+    {
+        sSprite const&  sprite   = m_sprites[index];
+        sSpriteInstance instance = {};
+        instance.position[0]     = sprite.x;
+        instance.position[1]     = sprite.y;
+        instance.size[0]         = sprite.width;
+        instance.size[1]         = sprite.height;
+        instance.uvRect[0]       = sprite.uvLeft;
+        instance.uvRect[1]       = sprite.uvTop;
+        instance.uvRect[2]       = sprite.uvRight;
+        instance.uvRect[3]       = sprite.uvBottom;
+        instance.rotation        = sprite.rotation;
+        instance.tint            = sprite.tint;
+
+        // 紋理相同就延續上一個批次
+        if (m_batches.empty() || m_batches.back().textureId != sprite.textureId)
+        {
+            sSpriteDrawBatch batch;
+            batch.textureId     = sprite.textureId;
+            batch.firstInstance = (unsigned int)m_instances.size();
+            m_batches.push_back(batch);
+        }
+
+        ++m_batches.back().instanceCount;
+        m_instances.push_back(instance);
+    }
+
+    m_stats.sprites = (unsigned int)m_instances.size();
+    m_stats.batches = (unsigned int)m_batches.size();
+}
+
+//----------------------------------------------------------------------------------------------------
+static void UnpackColor(uint32_t const color, float out[4])
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        out[i] = (float)((color >> (i * 8)) & 0xFF) / 255.f;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+static uint32_t PackColor(float const color[4])
+{
+    uint32_t packed = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        float const clamped = (std::min)(1.f, (std::max)(0.f, color[i]));
+        packed |= (uint32_t)(clamped * 255.f + 0.5f) << (i * 8);
+    }
+    return packed;
+}
+
+//----------------------------------------------------------------------------------------------------
+static int WrapCoordinate(int const value, int const size)
+{
+    int const wrapped = value % size;
+    return wrapped < 0 ? wrapped + size : wrapped;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 與 D3D11_FILTER_MIN_MAG_MIP_LINEAR + WRAP 相同的雙線性取樣
+static void SampleBilinearWrap(sSpriteTexture const& texture, float const u, float const v, float out[4])
+{
+    float const texelX = u * (float)texture.width - 0.5f;
+    float const texelY = v * (float)texture.height - 0.5f;
+    float const floorX = std::floor(texelX);
+    float const floorY = std::floor(texelY);
+    float const fracX  = texelX - floorX;
+    float const fracY  = texelY - floorY;
+
+    int const x0 = WrapCoordinate((int)floorX, texture.width);
+    int const y0 = WrapCoordinate((int)floorY, texture.height);
+    int const x1 = WrapCoordinate(x0 + 1, texture.width);
+    int const y1 = WrapCoordinate(y0 + 1, texture.height);
+
+    float c00[4], c10[4], c01[4], c11[4];
+    UnpackColor(texture.pixels[y0 * texture.width + x0], c00);
+    UnpackColor(texture.pixels[y0 * texture.width + x1], c10);
+    UnpackColor(texture.pixels[y1 * texture.width + x0], c01);
+    UnpackColor(texture.pixels[y1 * texture.width + x1], c11);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        float const top    = c00[i] + (c10[i] - c00[i]) * fracX;
+        float const bottom = c01[i] + (c11[i] - c01[i]) * fracX;
+        out[i]             = top + (bottom - top) * fracY;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+static void RasterizeInstance(sSpriteInstance const& instance,
+                              sSpriteTexture const&  texture,
+                              uint32_t*              target,
+                              int const              targetWidth,
+                              int const              targetStride,
+                              int const              clipTop,
+                              int const              clipBottom)
+{
+    float const halfWidth  = instance.size[0] * 0.5f;
+    float const halfHeight = instance.size[1] * 0.5f;
+    if (halfWidth <= 0.f || halfHeight <= 0.f) return;
+
+    float const cosR = std::cos(instance.rotation);
+    float const sinR = std::sin(instance.rotation);
+
+    // 旋轉後的包圍盒
+    float const extentX = std::fabs(cosR) * halfWidth + std::fabs(sinR) * halfHeight;
+    float const extentY = std::fabs(sinR) * halfWidth + std::fabs(cosR) * halfHeight;
+
+    int const minX = (std::max)(0, (int)std::floor(instance.position[0] - extentX));
+    int const minY = (std::max)(clipTop, (int)std::floor(instance.position[1] - extentY));
+    int const maxX = (std::min)(targetWidth - 1, (int)std::ceil(instance.position[0] + extentX));
+    int const maxY = (std::min)(clipBottom - 1, (int)std::ceil(instance.position[1] + extentY));
+    if (minX > maxX || minY > maxY) return;
+
+    float tint[4];
+    UnpackColor(instance.tint, tint);
+
+    float const uvWidth  = instance.uvRect[2] - instance.uvRect[0];
+    float const uvHeight = instance.uvRect[3] - instance.uvRect[1];
+
+    for (int y = minY; y <= maxY; ++y)
+    {
+        for (int x = minX; x <= maxX; ++x)
+        {
+            // 像素中心轉回精靈的本地座標
+            float const dx     = (float)x + 0.5f - instance.position[0];
+            float const dy     = (float)y + 0.5f - instance.position[1];
+            float const localX = cosR * dx + sinR * dy;
+            float const localY = -sinR * dx + cosR * dy;
+
+            if (localX < -halfWidth || localX >= halfWidth || localY < -halfHeight || localY >= halfHeight) continue;
+
+            float const u = instance.uvRect[0] + (localX / instance.size[0] + 0.5f) * uvWidth;
+            float const v = instance.uvRect[1] + (localY / instance.size[1] + 0.5f) * uvHeight;
+
+            float source[4];
+            SampleBilinearWrap(texture, u, v, source);
+            for (int i = 0; i < 4; ++i)
+            {
+                source[i] *= tint[i];
+            }
+
+            // SrcAlpha / InvSrcAlpha 混合，alpha 通道為 One / InvSrcAlpha
+            uint32_t& destination = target[y * targetStride + x];
+            float     dest[4];
+            UnpackColor(destination, dest);
+
+            float const alpha = source[3];
+            float       blended[4];
+            for (int i = 0; i < 3; ++i)
+            {
+                blended[i] = source[i] * alpha + dest[i] * (1.f - alpha);
+            }
+            blended[3] = alpha + dest[3] * (1.f - alpha);
+
+            destination = PackColor(blended);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+void RasterizeSpriteBatches(SpriteBatcher const&               batcher,
+                            std::vector<sSpriteTexture> const& textures,
+                            uint32_t*                          target,
+                            int const                          targetWidth,
+                            int const                          targetHeight)
+{
+    RasterizeSpriteBatches(batcher, textures, target, targetWidth, targetHeight, targetWidth, 0, targetHeight);
+}
+
+//----------------------------------------------------------------------------------------------------
+void RasterizeSpriteBatches(SpriteBatcher const&               batcher,
+                            std::vector<sSpriteTexture> const& textures,
+                            uint32_t*                          target,
+                            int const                          targetWidth,
+                            int const                          targetHeight,
+                            int const                          targetStride,
+                            int const                          clipTop,
+                            int const                          clipBottom)
+{
+    int const rowBegin = (std::max)(0, clipTop);
+    int const rowEnd   = (std::min)(targetHeight, clipBottom);
+    if (rowBegin >= rowEnd) return;
+
+    std::vector<sSpriteInstance> const& instances = batcher.GetInstances();
+
+    for (sSpriteDrawBatch const& batch : batcher.GetBatches())
+    {
+        if (batch.textureId >= textures.size()) continue;
+
+        sSpriteTexture const& texture = textures[batch.textureId];
+        if (!texture.pixels || texture.width <= 0 || texture.height <= 0) continue;
+
+        for (unsigned int i = 0; i < batch.instanceCount; ++i)
+        {
+            RasterizeInstance(instances[batch.firstInstance + i], texture, target, targetWidth, targetStride, rowBegin, rowEnd);
+        }
+    }
+}
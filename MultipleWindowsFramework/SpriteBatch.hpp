@@ -0,0 +1,104 @@
+﻿//----------------------------------------------------------------------------------------------------
+// SpriteBatch.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <cstdint>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+// 使用者提交的精靈 (場景像素座標，原點在左上角)
+struct sSprite
+{
+    float        x         = 0.f;           // 中心位置
+    float        y         = 0.f;
+    float        width     = 1.f;           // 縮放後的大小 (像素)
+    float        height    = 1.f;
+    float        rotation  = 0.f;           // 弧度，順時針
+    float        uvLeft    = 0.f;           // 圖集中的 UV 範圍
+    float        uvTop     = 0.f;
+    float        uvRight   = 1.f;
+    float        uvBottom  = 1.f;
+    uint32_t     tint      = 0xFFFFFFFF;    // RGBA8 (R 在最低位元組)
+    unsigned int textureId = 0;             // 紋理或圖集編號
+    int          layer     = 0;             // 繪製順序，數值小的先畫
+};
+
+//----------------------------------------------------------------------------------------------------
+// 上傳到 GPU 的每實例資料，欄位順序與 Renderer 的 instance input layout 一致
+struct sSpriteInstance
+{
+    float    position[2];                   // POSITION1      R32G32_FLOAT
+    float    size[2];                       // SIZE           R32G32_FLOAT
+    float    uvRect[4];                     // UVRECT         R32G32B32A32_FLOAT
+    float    rotation;                      // ROTATION       R32_FLOAT
+    uint32_t tint;                          // COLOR          R8G8B8A8_UNORM
+};
+
+static_assert(sizeof(sSpriteInstance) == 40, "sSpriteInstance must match the GPU instance layout");
+
+//----------------------------------------------------------------------------------------------------
+// 一次 instanced draw：同一紋理、連續的實例範圍
+struct sSpriteDrawBatch
+{
+    unsigned int textureId     = 0;
+    unsigned int firstInstance = 0;
+    unsigned int instanceCount = 0;
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sSpriteBatchStats
+{
+    unsigned int sprites = 0;
+    unsigned int batches = 0;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 收集一幀的精靈，依 (layer, textureId) 穩定排序後打包成實例陣列與批次
+class SpriteBatcher
+{
+public:
+    void Begin();
+    void Draw(sSprite const& sprite);
+    void End();
+
+    bool                                 IsEmpty() const { return m_sprites.empty(); }
+    std::vector<sSpriteInstance> const&  GetInstances() const { return m_instances; }
+    std::vector<sSpriteDrawBatch> const& GetBatches() const { return m_batches; }
+    sSpriteBatchStats const&             GetStats() const { return m_stats; }
+
+private:
+    std::vector<sSprite>          m_sprites;
+    std::vector<uint32_t>         m_order;
+    std::vector<sSpriteInstance>  m_instances;
+    std::vector<sSpriteDrawBatch> m_batches;
+    sSpriteBatchStats             m_stats;
+};
+
+//----------------------------------------------------------------------------------------------------
+// CPU 參考光柵化使用的紋理 (RGBA8，逐列緊密排列)
+struct sSpriteTexture
+{
+    uint32_t const* pixels = nullptr;
+    int             width  = 0;
+    int             height = 0;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 以與 GPU 相同的規則 (線性過濾、環繞取樣、SrcAlpha 混合) 繪製批次結果，用於驗證與效能比較
+void RasterizeSpriteBatches(SpriteBatcher const&               batcher,
+                            std::vector<sSpriteTexture> const& textures,
+                            uint32_t*                          target,
+                            int                                targetWidth,
+                            int                                targetHeight);
+
+// 只寫入 [clipTop, clipBottom) 列，供多執行緒依帶狀區域分工；targetStride 為每列像素數
+void RasterizeSpriteBatches(SpriteBatcher const&               batcher,
+                            std::vector<sSpriteTexture> const& textures,
+                            uint32_t*                          target,
+                            int                                targetWidth,
+                            int                                targetHeight,
+                            int                                targetStride,
+                            int                                clipTop,
+                            int                                clipBottom);
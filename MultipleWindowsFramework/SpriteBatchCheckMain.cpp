@@ -0,0 +1,411 @@
+﻿//----------------------------------------------------------------------------------------------------
+// SpriteBatchCheckMain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// 精靈批次與 CPU 參考光柵化的檢查 (不屬於 Windows 專案，在 Linux 上單獨編譯)：
+//
+//   g++ -std=c++14 -O2 SpriteBatchCheckMain.cpp SpriteBatch.cpp -o sprite_batch_check
+//   ./sprite_batch_check [精靈數]
+//
+// 檢查 SpriteBatcher 依 (layer, textureId) 的穩定排序、批次數與實例欄位；RasterizeSpriteBatches 對可以手算的
+// 情況 (不透明、色調、半透明、圖層順序、旋轉 90 度、UV 子範圍、無效紋理) 逐像素比對，並確認帶狀分工的
+// 多載與整張繪製的結果相同。最後量測在 1920x1080 上批次與單執行緒光柵化的時間 (-software -sprites <精靈數> 每幀的工作量)
+// 結束碼：0 = 全部通過，1 = 失敗
+//----------------------------------------------------------------------------------------------------
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "CheckMain.hpp"
+#include "SpriteBatch.hpp"
+
+//----------------------------------------------------------------------------------------------------
+static uint32_t const BLACK = 0xFF000000;
+static uint32_t const RED   = 0xFF0000FF;
+static uint32_t const GREEN = 0xFF00FF00;
+static uint32_t const BLUE  = 0xFFFF0000;
+static uint32_t const WHITE = 0xFFFFFFFF;
+
+//----------------------------------------------------------------------------------------------------
+// 中心在 (x, y)、大小 width x height 的軸對齊精靈
+static sSprite MakeSprite(float const x, float const y, float const width, float const height, unsigned int const textureId, int const layer)
+{
+    sSprite sprite;
+    sprite.x         = x;
+    sprite.y         = y;
+    sprite.width     = width;
+    sprite.height    = height;
+    sprite.textureId = textureId;
+    sprite.layer     = layer;
+    return sprite;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 固定大小的目標，預設填滿不透明黑色
+class Target
+{
+public:
+    Target(int const width, int const height) : m_width(width), m_height(height), m_pixels((size_t)width * height, BLACK) {}
+
+    void Rasterize(SpriteBatcher const& batcher, std::vector<sSpriteTexture> const& textures)
+    {
+        RasterizeSpriteBatches(batcher, textures, m_pixels.data(), m_width, m_height);
+    }
+
+    // [left, right) x [top, bottom) 內都是 inside，其餘都是 outside
+    bool Matches(int const left, int const top, int const right, int const bottom, uint32_t const inside, uint32_t const outside) const
+    {
+        for (int y = 0; y < m_height; ++y)
+        {
+            for (int x = 0; x < m_width; ++x)
+            {
+                bool const isInside = x >= left && x < right && y >= top && y < bottom;
+                if (At(x, y) != (isInside ? inside : outside)) return false;
+            }
+        }
+        return true;
+    }
+
+    uint32_t At(int const x, int const y) const { return m_pixels[(size_t)y * m_width + x]; }
+
+private:
+    int                   m_width;
+    int                   m_height;
+    std::vector<uint32_t> m_pixels;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 圖層優先，同一圖層內依紋理，同一 (圖層, 紋理) 內保留提交順序；紋理改變才開新批次
+static bool CheckBatching()
+{
+    // 以 x 記錄提交順序
+    struct sCase { int layer; unsigned int textureId; };
+    sCase const cases[] = {{1, 0}, {0, 1}, {0, 0}, {0, 1}, {1, 0}, {0, 0}, {2, 1}};
+
+    SpriteBatcher batcher;
+    batcher.Begin();
+    for (int i = 0; i < (int)(sizeof(cases) / sizeof(cases[0])); ++i)
+    {
+        sSprite sprite   = MakeSprite((float)i, 0.f, 1.f, 1.f, cases[i].textureId, cases[i].layer);
+        sprite.rotation  = 0.25f * (float)i;
+        sprite.uvLeft    = 0.1f;
+        sprite.uvTop     = 0.2f;
+        sprite.uvRight   = 0.3f;
+        sprite.uvBottom  = 0.4f;
+        sprite.tint      = 0x01020304u * (uint32_t)(i + 1);
+        batcher.Draw(sprite);
+    }
+    batcher.End();
+
+    std::vector<int> order;
+    bool             isPacked = true;
+    for (sSpriteInstance const& instance : batcher.GetInstances())
+    {
+        int const index = (int)instance.position[0];
+        order.push_back(index);
+        isPacked &= instance.size[0] == 1.f && instance.size[1] == 1.f && instance.rotation == 0.25f * (float)index;
+        isPacked &= instance.uvRect[0] == 0.1f && instance.uvRect[1] == 0.2f && instance.uvRect[2] == 0.3f && instance.uvRect[3] == 0.4f;
+        isPacked &= instance.tint == 0x01020304u * (uint32_t)(index + 1);
+    }
+
+    std::vector<sSpriteDrawBatch> const& batches = batcher.GetBatches();
+    bool const isBatched = batches.size() == 4 &&
+                           batches[0].textureId == 0 && batches[0].firstInstance == 0 && batches[0].instanceCount == 2 &&
+                           batches[1].textureId == 1 && batches[1].firstInstance == 2 && batches[1].instanceCount == 2 &&
+                           batches[2].textureId == 0 && batches[2].firstInstance == 4 && batches[2].instanceCount == 2 &&
+                           batches[3].textureId == 1 && batches[3].firstInstance == 6 && batches[3].instanceCount == 1;
+
+    sSpriteBatchStats const stats = batcher.GetStats();
+
+    // Begin 清掉上一幀；沒有精靈時沒有批次
+    batcher.Begin();
+    batcher.End();
+    bool const isReset = batcher.IsEmpty() && batcher.GetInstances().empty() && batcher.GetBatches().empty() && batcher.GetStats().sprites == 0;
+
+    bool isPassing = true;
+    isPassing &= Check(order == std::vector<int>{2, 5, 1, 3, 0, 4, 6}, "batch_sort_order");
+    isPassing &= Check(isBatched && stats.sprites == 7 && stats.batches == 4, "batch_ranges");
+    isPassing &= Check(isPacked, "instance_fields");
+    isPassing &= Check(isReset, "begin_resets");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 隨機的圖層與紋理：批次數等於依 (layer, textureId) 排序後紋理改變的次數，且所有批次剛好涵蓋所有實例
+static bool CheckRandomBatchCounts()
+{
+    uint32_t      seed      = 0x2545F491u;
+    bool          isMatched = true;
+    SpriteBatcher batcher;
+    for (int iteration = 0; iteration < 1000 && isMatched; ++iteration)
+    {
+        int const count = (int)(NextRandom(seed) % 64);
+
+        std::vector<std::pair<int, unsigned int>> keys;
+        batcher.Begin();
+        for (int i = 0; i < count; ++i)
+        {
+            int const          layer     = (int)(NextRandom(seed) % 4) - 1;
+            unsigned int const textureId = NextRandom(seed) % 5;
+            keys.emplace_back(layer, textureId);
+            batcher.Draw(MakeSprite((float)i, 0.f, 1.f, 1.f, textureId, layer));
+        }
+        batcher.End();
+
+        std::sort(keys.begin(), keys.end());
+        unsigned int expected = 0;
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            if (i == 0 || keys[i].second != keys[i - 1].second) ++expected;
+        }
+
+        unsigned int next = 0;
+        for (sSpriteDrawBatch const& batch : batcher.GetBatches())
+        {
+            isMatched &= batch.firstInstance == next && batch.instanceCount > 0;
+            next += batch.instanceCount;
+        }
+        isMatched &= batcher.GetStats().batches == expected && next == (unsigned int)count;
+    }
+    return Check(isMatched, "random_batch_counts");
+}
+
+//----------------------------------------------------------------------------------------------------
+// 可以手算結果的光柵化情況
+static bool CheckRasterization()
+{
+    uint32_t const                    white[4]    = {WHITE, WHITE, WHITE, WHITE};
+    uint32_t const                    red[4]      = {RED, RED, RED, RED};
+    uint32_t const                    blue[4]     = {BLUE, BLUE, BLUE, BLUE};
+    uint32_t const                    redGreen[2] = {RED, GREEN};
+    std::vector<sSpriteTexture> const textures    = {{white, 2, 2}, {red, 2, 2}, {blue, 2, 2}, {redGreen, 2, 1}};
+
+    SpriteBatcher batcher;
+
+    // 不透明：像素中心落在 [6, 14) 的剛好被覆蓋，其餘不變
+    Target opaque(32, 32);
+    batcher.Begin();
+    batcher.Draw(MakeSprite(10.f, 10.f, 8.f, 8.f, 1, 0));
+    batcher.End();
+    opaque.Rasterize(batcher, textures);
+
+    // 色調與紋理相乘
+    Target tinted(32, 32);
+    batcher.Begin();
+    sSprite tint = MakeSprite(16.f, 16.f, 4.f, 6.f, 0, 0);
+    tint.tint    = GREEN;
+    batcher.Draw(tint);
+    batcher.End();
+    tinted.Rasterize(batcher, textures);
+
+    // 半透明白色疊在黑色上：顏色為 alpha，alpha 通道為 One / InvSrcAlpha
+    Target blended(32, 32);
+    batcher.Begin();
+    sSprite half = MakeSprite(16.f, 16.f, 4.f, 4.f, 0, 0);
+    half.tint    = 0x80FFFFFF;
+    batcher.Draw(half);
+    batcher.End();
+    blended.Rasterize(batcher, textures);
+
+    // 圖層 1 的紅色先提交，仍畫在圖層 0 的藍色上方
+    Target layered(32, 32);
+    batcher.Begin();
+    batcher.Draw(MakeSprite(12.f, 12.f, 8.f, 8.f, 1, 1));
+    batcher.Draw(MakeSprite(12.f, 12.f, 8.f, 8.f, 2, 0));
+    batcher.End();
+    layered.Rasterize(batcher, textures);
+
+    // 8x2 旋轉 90 度後是 2x8
+    Target rotated(32, 32);
+    batcher.Begin();
+    sSprite turned  = MakeSprite(10.f, 10.f, 8.f, 2.f, 1, 0);
+    turned.rotation = 1.57079633f;
+    batcher.Draw(turned);
+    batcher.End();
+    rotated.Rasterize(batcher, textures);
+
+    // 1x1 的精靈只取樣一個像素中心：UV 左半是紅色，右半是綠色
+    Target uvRect(4, 1);
+    batcher.Begin();
+    sSprite left  = MakeSprite(0.5f, 0.5f, 1.f, 1.f, 3, 0);
+    left.uvRight  = 0.5f;
+    sSprite right = MakeSprite(1.5f, 0.5f, 1.f, 1.f, 3, 0);
+    right.uvLeft  = 0.5f;
+    batcher.Draw(left);
+    batcher.Draw(right);
+    batcher.End();
+    uvRect.Rasterize(batcher, textures);
+
+    // 沒有對應紋理的批次被略過
+    Target missing(32, 32);
+    batcher.Begin();
+    batcher.Draw(MakeSprite(16.f, 16.f, 8.f, 8.f, 7, 0));
+    batcher.End();
+    missing.Rasterize(batcher, textures);
+
+    bool isPassing = true;
+    isPassing &= Check(opaque.Matches(6, 6, 14, 14, RED, BLACK), "raster_opaque");
+    isPassing &= Check(tinted.Matches(14, 13, 18, 19, GREEN, BLACK), "raster_tint");
+    isPassing &= Check(blended.Matches(14, 14, 18, 18, 0xFF808080, BLACK), "raster_alpha_blend");
+    isPassing &= Check(layered.Matches(8, 8, 16, 16, RED, BLACK), "raster_layer_order");
+    isPassing &= Check(rotated.Matches(9, 6, 11, 14, RED, BLACK), "raster_rotation");
+    isPassing &= Check(uvRect.At(0, 0) == RED && uvRect.At(1, 0) == GREEN && uvRect.At(2, 0) == BLACK, "raster_uv_rect");
+    isPassing &= Check(missing.Matches(0, 0, 0, 0, BLACK, BLACK), "raster_missing_texture");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 隨機填充的紋理
+static std::vector<uint32_t> MakeNoiseTexture(int const width, int const height, uint32_t& seed)
+{
+    std::vector<uint32_t> pixels((size_t)width * height);
+    for (uint32_t& pixel : pixels)
+    {
+        pixel = NextRandom(seed);
+    }
+    return pixels;
+}
+
+// 隨機位置、大小、旋轉、UV 與色調的精靈，部分超出目標邊界
+static void DrawRandomSprites(SpriteBatcher& batcher, int const count, int const width, int const height, unsigned int const textureCount, uint32_t& seed)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        float const size = 4.f + (float)(NextRandom(seed) % 60);
+
+        sSprite sprite = MakeSprite((float)((int)(NextRandom(seed) % (width + 40)) - 20),
+                                    (float)((int)(NextRandom(seed) % (height + 40)) - 20),
+                                    size, size * (0.5f + (float)(NextRandom(seed) % 100) / 100.f),
+                                    NextRandom(seed) % textureCount, (int)(NextRandom(seed) % 3));
+        sprite.rotation = (float)(NextRandom(seed) % 628) / 100.f;
+        sprite.uvLeft   = (float)(NextRandom(seed) % 50) / 100.f;
+        sprite.uvRight  = sprite.uvLeft + 0.5f;
+        sprite.tint     = NextRandom(seed) | 0x40000000;
+        batcher.Draw(sprite);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+// 帶狀分工 (與 SoftwareRenderBackend::DrawSprites 相同) 與整張繪製逐像素相同；目標有額外的列間距
+static bool CheckBands()
+{
+    int const width  = 256;
+    int const height = 192;
+    int const stride = width + 13;
+
+    uint32_t                           seed = 0x9E3779B9u;
+    std::vector<std::vector<uint32_t>> storage;
+    std::vector<sSpriteTexture>        textures;
+    for (int i = 0; i < 3; ++i)
+    {
+        storage.push_back(MakeNoiseTexture(16 << i, 8 << i, seed));
+        textures.push_back({storage.back().data(), 16 << i, 8 << i});
+    }
+
+    SpriteBatcher batcher;
+    batcher.Begin();
+    DrawRandomSprites(batcher, 300, width, height, 3, seed);
+    batcher.End();
+
+    std::vector<uint32_t> full((size_t)width * height, BLACK);
+    RasterizeSpriteBatches(batcher, textures, full.data(), width, height);
+
+    uint32_t const        padding = 0x12345678;
+    std::vector<uint32_t> banded((size_t)stride * height, BLACK);
+    for (int y = 0; y < height; ++y)
+    {
+        std::fill(banded.begin() + (size_t)y * stride + width, banded.begin() + (size_t)(y + 1) * stride, padding);
+    }
+
+    int const bandCount = 7;
+    for (int band = 0; band < bandCount; ++band)
+    {
+        RasterizeSpriteBatches(batcher, textures, banded.data(), width, height, stride,
+                               height * band / bandCount, height * (band + 1) / bandCount);
+    }
+
+    bool isSame     = true;
+    bool isPadded   = true;
+    int  differents = 0;
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < stride; ++x)
+        {
+            uint32_t const value = banded[(size_t)y * stride + x];
+            if (x >= width)
+            {
+                isPadded &= value == padding;
+            }
+            else if (value != full[(size_t)y * width + x])
+            {
+                isSame = false;
+                ++differents;
+            }
+        }
+    }
+
+    // 超出目標的裁切範圍不寫入任何像素
+    std::vector<uint32_t> outside((size_t)width * height, BLACK);
+    RasterizeSpriteBatches(batcher, textures, outside.data(), width, height, width, height, height + 10);
+    RasterizeSpriteBatches(batcher, textures, outside.data(), width, height, width, -10, 0);
+    bool const isClipped = std::all_of(outside.begin(), outside.end(), [](uint32_t const value) { return value == BLACK; });
+
+    printf("bands_pixel_differences %d\n", differents);
+
+    bool isPassing = true;
+    isPassing &= Check(isSame, "bands_match_full");
+    isPassing &= Check(isPadded, "bands_respect_stride");
+    isPassing &= Check(isClipped, "bands_clip_outside");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+int main(int const argc, char** argv)
+{
+    using Clock = std::chrono::steady_clock;
+
+    int const spriteCount = argc > 1 ? atoi(argv[1]) : 2000;
+
+    bool isPassing = true;
+    isPassing &= CheckBatching();
+    isPassing &= CheckRandomBatchCounts();
+    isPassing &= CheckRasterization();
+    isPassing &= CheckBands();
+
+    // 基準：1920x1080 上 spriteCount 個 4~64 像素、兩張 64x64 紋理的精靈
+    int const                          width   = 1920;
+    int const                          height  = 1080;
+    int const                          repeats = 10;
+    uint32_t                           seed    = 12345;
+    std::vector<std::vector<uint32_t>> storage = {MakeNoiseTexture(64, 64, seed), MakeNoiseTexture(64, 64, seed)};
+    std::vector<sSpriteTexture> const  textures = {{storage[0].data(), 64, 64}, {storage[1].data(), 64, 64}};
+    std::vector<uint32_t>              target((size_t)width * height, BLACK);
+
+    SpriteBatcher batcher;
+    double        batchUs  = 0.0;
+    double        rasterUs = 0.0;
+    for (int repeat = 0; repeat < repeats; ++repeat)
+    {
+        uint32_t frameSeed = seed;
+        batcher.Begin();
+        DrawRandomSprites(batcher, spriteCount, width, height, 2, frameSeed);
+
+        Clock::time_point const start = Clock::now();
+        batcher.End();
+        Clock::time_point const batched = Clock::now();
+        RasterizeSpriteBatches(batcher, textures, target.data(), width, height);
+        Clock::time_point const end = Clock::now();
+
+        batchUs  += std::chrono::duration<double, std::micro>(batched - start).count();
+        rasterUs += std::chrono::duration<double, std::micro>(end - batched).count();
+    }
+
+    printf("benchmark_sprites %d\n", spriteCount);
+    printf("benchmark_batches %u\n", batcher.GetStats().batches);
+    printf("benchmark_batch_us %.1f\n", batchUs / repeats);
+    printf("benchmark_raster_ms %.2f\n", rasterUs / repeats / 1000.0);
+    return isPassing ? 0 : 1;
+}
@@ -0,0 +1,243 @@
+﻿//----------------------------------------------------------------------------------------------------
+// TextureGenerator.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "TextureGenerator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "ThreadPool.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define TEXTURE_GENERATOR_USE_SSE2 1
+#include <emmintrin.h>
+#else
+#define TEXTURE_GENERATOR_USE_SSE2 0
+#endif
+
+//----------------------------------------------------------------------------------------------------
+static int const   TEST_PATTERN_TILE_SIZE     = 64;
+static int const   TEST_PATTERN_CIRCLE_COUNT  = 5;
+static float const TEST_PATTERN_CIRCLE_RADIUS = 30.f;
+
+//----------------------------------------------------------------------------------------------------
+// 圓心與顏色只跟紋理大小有關，先算好給所有像素共用
+struct sTestPatternLayout
+{
+    float    width;
+    float    height;
+    float    centerX[TEST_PATTERN_CIRCLE_COUNT];
+    float    centerY[TEST_PATTERN_CIRCLE_COUNT];
+    uint32_t circleR[TEST_PATTERN_CIRCLE_COUNT];
+    uint32_t circleG[TEST_PATTERN_CIRCLE_COUNT];
+    uint32_t circleB[TEST_PATTERN_CIRCLE_COUNT];
+};
+
+//----------------------------------------------------------------------------------------------------
+static sTestPatternLayout MakeTestPatternLayout(unsigned int const width, unsigned int const height)
+{
+    sTestPatternLayout layout;
+    layout.width  = (float)width;
+    layout.height = (float)height;
+
+    for (int i = 0; i < TEST_PATTERN_CIRCLE_COUNT; ++i)
+    {
+        layout.centerX[i] = (float)((i % 3) * width) / 3.0f + (float)width / 6.0f;
+        layout.centerY[i] = (float)((i / 3) * height) / 3.0f + (float)height / 6.0f;
+        layout.circleR[i] = (uint32_t)((i * 50) % 256);
+        layout.circleG[i] = (uint32_t)((i * 80) % 256);
+        layout.circleB[i] = (uint32_t)((i * 120) % 256);
+    }
+    return layout;
+}
+
+//----------------------------------------------------------------------------------------------------
+static uint32_t ComputeTestPatternPixel(sTestPatternLayout const& layout, unsigned int const x, unsigned int const y)
+{
+    float const fx = (float)x / layout.width;
+    float const fy = (float)y / layout.height;
+
+    uint32_t r = (uint32_t)(fx * 255);
+    uint32_t g = (uint32_t)(fy * 255);
+    uint32_t b = (uint32_t)((1.0f - fx) * 255);
+
+    if (((x / 32) + (y / 32)) % 2 == 0)
+    {
+        r = (std::min)(255u, r + 50);
+        g = (std::min)(255u, g + 50);
+        b = (std::min)(255u, b + 50);
+    }
+
+    // 後面的圓點覆蓋前面的
+    for (int i = 0; i < TEST_PATTERN_CIRCLE_COUNT; ++i)
+    {
+        float const dx       = (float)x - layout.centerX[i];
+        float const dy       = (float)y - layout.centerY[i];
+        float const distance = std::sqrt(dx * dx + dy * dy);
+
+        if (distance < TEST_PATTERN_CIRCLE_RADIUS)
+        {
+            r = layout.circleR[i];
+            g = layout.circleG[i];
+            b = layout.circleB[i];
+        }
+    }
+
+    return 0xFF000000 | (b << 16) | (g << 8) | r;
+}
+
+//----------------------------------------------------------------------------------------------------
+void GenerateTestPatternReference(uint32_t* pixels, unsigned int const width, unsigned int const height)
+{
+    if (!pixels || width == 0 || height == 0) return;
+
+    sTestPatternLayout const layout = MakeTestPatternLayout(width, height);
+
+    for (unsigned int y = 0; y < height; ++y)
+    {
+        for (unsigned int x = 0; x < width; ++x)
+        {
+            pixels[y * width + x] = ComputeTestPatternPixel(layout, x, y);
+        }
+    }
+}
+
+#if TEXTURE_GENERATOR_USE_SSE2
+//----------------------------------------------------------------------------------------------------
+static inline __m128i SelectInt(__m128i const mask, __m128i const ifTrue, __m128i const ifFalse)
+{
+    return _mm_or_si128(_mm_and_si128(mask, ifTrue), _mm_andnot_si128(mask, ifFalse));
+}
+
+//----------------------------------------------------------------------------------------------------
+// 與 ComputeTestPatternPixel 相同的運算順序，結果逐位元一致
+static void GenerateTestPatternRow(sTestPatternLayout const& layout,
+                                   uint32_t*                 row,
+                                   unsigned int const        y,
+                                   unsigned int const        xBegin,
+                                   unsigned int const        xEnd)
+{
+    __m128 const  widthVector = _mm_set1_ps(layout.width);
+    __m128 const  scale       = _mm_set1_ps(255.f);
+    __m128 const  one         = _mm_set1_ps(1.f);
+    __m128i const highlight   = _mm_set1_epi32(50);
+    __m128i const maxValue    = _mm_set1_epi32(255);
+    __m128i const alpha       = _mm_set1_epi32((int)0xFF000000);
+
+    float const        fy         = (float)y / layout.height;
+    __m128i const      rowGreen   = _mm_set1_epi32((int)(uint32_t)(fy * 255));
+    unsigned int const rowChecker = y / 32;
+
+    // 與這一列距離不到半徑的圓才需要逐像素測試
+    int   activeCircles[TEST_PATTERN_CIRCLE_COUNT];
+    float activeDySquared[TEST_PATTERN_CIRCLE_COUNT];
+    int   activeCount = 0;
+    for (int i = 0; i < TEST_PATTERN_CIRCLE_COUNT; ++i)
+    {
+        float const dy = (float)y - layout.centerY[i];
+        if (std::sqrt(dy * dy) < TEST_PATTERN_CIRCLE_RADIUS)
+        {
+            activeCircles[activeCount]   = i;
+            activeDySquared[activeCount] = dy * dy;
+            ++activeCount;
+        }
+    }
+
+    unsigned int x = xBegin;
+    for (; x + 4 <= xEnd; x += 4)
+    {
+        __m128i const xs = _mm_setr_epi32((int)x, (int)x + 1, (int)x + 2, (int)x + 3);
+        __m128 const  xf = _mm_cvtepi32_ps(xs);
+        __m128 const  fx = _mm_div_ps(xf, widthVector);
+
+        __m128i r = _mm_cvttps_epi32(_mm_mul_ps(fx, scale));
+        __m128i g = rowGreen;
+        __m128i b = _mm_cvttps_epi32(_mm_mul_ps(_mm_sub_ps(one, fx), scale));
+
+        // 棋盤格：((x / 32) + (y / 32)) 為偶數時提亮
+        __m128i const checker = _mm_add_epi32(_mm_srli_epi32(xs, 5), _mm_set1_epi32((int)rowChecker));
+        __m128i const isEven  = _mm_cmpeq_epi32(_mm_and_si128(checker, _mm_set1_epi32(1)), _mm_setzero_si128());
+        __m128i const add     = _mm_and_si128(isEven, highlight);
+
+        r = _mm_add_epi32(r, add);
+        g = _mm_add_epi32(g, add);
+        b = _mm_add_epi32(b, add);
+        r = SelectInt(_mm_cmpgt_epi32(r, maxValue), maxValue, r);
+        g = SelectInt(_mm_cmpgt_epi32(g, maxValue), maxValue, g);
+        b = SelectInt(_mm_cmpgt_epi32(b, maxValue), maxValue, b);
+
+        for (int c = 0; c < activeCount; ++c)
+        {
+            int const     i        = activeCircles[c];
+            __m128 const  dx       = _mm_sub_ps(xf, _mm_set1_ps(layout.centerX[i]));
+            __m128 const  distance = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_set1_ps(activeDySquared[c])));
+            __m128i const inside   = _mm_castps_si128(_mm_cmplt_ps(distance, _mm_set1_ps(TEST_PATTERN_CIRCLE_RADIUS)));
+
+            r = SelectInt(inside, _mm_set1_epi32((int)layout.circleR[i]), r);
+            g = SelectInt(inside, _mm_set1_epi32((int)layout.circleG[i]), g);
+            b = SelectInt(inside, _mm_set1_epi32((int)layout.circleB[i]), b);
+        }
+
+        __m128i const packed = _mm_or_si128(_mm_or_si128(alpha, _mm_slli_epi32(b, 16)),
+                                            _mm_or_si128(_mm_slli_epi32(g, 8), r));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + x), packed);
+    }
+
+    for (; x < xEnd; ++x)
+    {
+        row[x] = ComputeTestPatternPixel(layout, x, y);
+    }
+}
+#else
+//----------------------------------------------------------------------------------------------------
+static void GenerateTestPatternRow(sTestPatternLayout const& layout,
+                                   uint32_t*                 row,
+                                   unsigned int const        y,
+                                   unsigned int const        xBegin,
+                                   unsigned int const        xEnd)
+{
+    for (unsigned int x = xBegin; x < xEnd; ++x)
+    {
+        row[x] = ComputeTestPatternPixel(layout, x, y);
+    }
+}
+#endif
+
+//----------------------------------------------------------------------------------------------------
+void GenerateTestPattern(uint32_t* pixels, unsigned int const width, unsigned int const height, ThreadPool* threadPool)
+{
+    if (!pixels || width == 0 || height == 0) return;
+
+    sTestPatternLayout const layout = MakeTestPatternLayout(width, height);
+
+    int const tilesX    = (int)((width + TEST_PATTERN_TILE_SIZE - 1) / TEST_PATTERN_TILE_SIZE);
+    int const tilesY    = (int)((height + TEST_PATTERN_TILE_SIZE - 1) / TEST_PATTERN_TILE_SIZE);
+    int const tileCount = tilesX * tilesY;
+
+    auto const generateTile = [&](int const tile)
+    {
+        unsigned int const x0 = (unsigned int)(tile % tilesX) * TEST_PATTERN_TILE_SIZE;
+        unsigned int const y0 = (unsigned int)(tile / tilesX) * TEST_PATTERN_TILE_SIZE;
+        unsigned int const x1 = (std::min)(width, x0 + TEST_PATTERN_TILE_SIZE);
+        unsigned int const y1 = (std::min)(height, y0 + TEST_PATTERN_TILE_SIZE);
+
+        for (unsigned int y = y0; y < y1; ++y)
+        {
+            GenerateTestPatternRow(layout, pixels + (size_t)y * width, y, x0, x1);
+        }
+    };
+
+    if (threadPool)
+    {
+        threadPool->ParallelFor(tileCount, generateTile);
+    }
+    else
+    {
+        for (int tile = 0; tile < tileCount; ++tile)
+        {
+            generateTile(tile);
+        }
+    }
+}
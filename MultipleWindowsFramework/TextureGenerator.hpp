@@ -0,0 +1,18 @@
+﻿//----------------------------------------------------------------------------------------------------
+// TextureGenerator.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <cstdint>
+
+//-Forward-Declaration--------------------------------------------------------------------------------
+class ThreadPool;
+
+//----------------------------------------------------------------------------------------------------
+// 找不到圖片時使用的測試圖樣：水平/垂直漸層、32 像素棋盤格與五個圓點 (RGBA8，R 在最低位元組)
+// 以 64x64 區塊分配到執行緒池，每列以 SSE2 一次計算四個像素；threadPool 為 nullptr 時在呼叫端執行
+void GenerateTestPattern(uint32_t* pixels, unsigned int width, unsigned int height, ThreadPool* threadPool = nullptr);
+
+// 逐像素的純量版本，作為 SIMD 版本的比對基準
+void GenerateTestPatternReference(uint32_t* pixels, unsigned int width, unsigned int height);
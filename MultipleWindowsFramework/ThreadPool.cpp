@@ -0,0 +1,138 @@
+﻿//----------------------------------------------------------------------------------------------------
+// ThreadPool.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "ThreadPool.hpp"
+
+#include <memory>
+
+//----------------------------------------------------------------------------------------------------
+ThreadPool::ThreadPool(unsigned int workerCount)
+{
+    if (workerCount == 0)
+    {
+        unsigned int const hardwareThreads = std::thread::hardware_concurrency();
+        workerCount                        = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    m_workers.reserve(workerCount);
+    for (unsigned int i = 0; i < workerCount; ++i)
+    {
+        m_workers.emplace_back(&ThreadPool::WorkerMain, this);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopping = true;
+    }
+    m_taskAvailable.notify_all();
+
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+void ThreadPool::Submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+        ++m_activeTasks;
+    }
+    m_taskAvailable.notify_one();
+}
+
+//----------------------------------------------------------------------------------------------------
+void ThreadPool::WaitIdle()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this] { return m_activeTasks == 0; });
+}
+
+//----------------------------------------------------------------------------------------------------
+void ThreadPool::ParallelFor(int const count, std::function<void(int index)> const& body)
+{
+    if (count <= 0) return;
+    if (count == 1 || m_workers.empty())
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            body(i);
+        }
+        return;
+    }
+
+    // 共用的索引計數器：每個參與者不斷領取下一個索引，直到領完
+    struct sParallelJob
+    {
+        std::atomic<int>        nextIndex{0};
+        std::atomic<int>        finished{0};
+        std::mutex              mutex;
+        std::condition_variable done;
+    };
+
+    std::shared_ptr<sParallelJob> job = std::make_shared<sParallelJob>();
+
+    auto const runIndices = [job, count, &body]
+    {
+        int completed = 0;
+        for (int index = job->nextIndex.fetch_add(1); index < count; index = job->nextIndex.fetch_add(1))
+        {
+            body(index);
+            ++completed;
+        }
+
+        if (completed > 0 && job->finished.fetch_add(completed) + completed == count)
+        {
+            std::lock_guard<std::mutex> lock(job->mutex);
+            job->done.notify_all();
+        }
+    };
+
+    unsigned int const helperCount = (unsigned int)(std::min)((size_t)count - 1, m_workers.size());
+    for (unsigned int i = 0; i < helperCount; ++i)
+    {
+        Submit(runIndices);
+    }
+
+    runIndices();
+
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->done.wait(lock, [&job, count] { return job->finished.load() == count; });
+}
+
+//----------------------------------------------------------------------------------------------------
+void ThreadPool::WorkerMain()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_taskAvailable.wait(lock, [this] { return m_isStopping || !m_tasks.empty(); });
+
+            if (m_tasks.empty()) return;       // 只有在停止且沒有剩餘工作時才離開
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_activeTasks;
+            if (m_activeTasks == 0)
+            {
+                m_idle.notify_all();
+            }
+        }
+    }
+}
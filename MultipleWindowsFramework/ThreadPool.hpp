@@ -0,0 +1,44 @@
+﻿//----------------------------------------------------------------------------------------------------
+// ThreadPool.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+// 固定數量的工作執行緒，提供非同步工作與阻塞式的平行迴圈
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned int workerCount = 0);      // 0 = 硬體執行緒數 - 1
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const&)            = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    unsigned int GetWorkerCount() const { return (unsigned int)m_workers.size(); }
+
+    void Submit(std::function<void()> task);
+    void WaitIdle();
+
+    // 將 [0, count) 交給工作執行緒與呼叫端共同處理，全部完成後才返回
+    void ParallelFor(int count, std::function<void(int index)> const& body);
+
+private:
+    void WorkerMain();
+
+    std::vector<std::thread>          m_workers;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex                        m_mutex;
+    std::condition_variable           m_taskAvailable;
+    std::condition_variable           m_idle;
+    int                               m_activeTasks = 0;
+    bool                              m_isStopping  = false;
+};
@@ -0,0 +1,219 @@
+﻿//----------------------------------------------------------------------------------------------------
+// TileReadback.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "TileReadback.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+//----------------------------------------------------------------------------------------------------
+// MurmurHash3 的 fmix32，shader 中的 MixTileHash 必須保持一致
+static uint32_t MixTileHash(uint32_t hash)
+{
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+//----------------------------------------------------------------------------------------------------
+uint64_t ComputeTileChecksum(uint8_t const* pixels, unsigned int const pitch, sRect const& tile)
+{
+    uint32_t sum  = 0;
+    uint32_t bits = 0;
+    for (int y = tile.top; y < tile.bottom; ++y)
+    {
+        uint8_t const* row = pixels + (size_t)y * pitch;
+        for (int x = tile.left; x < tile.right; ++x)
+        {
+            // 以位元組組合，結果與 GPU 上 r | g << 8 | b << 16 | a << 24 相同 (不依賴主機位元組順序)
+            uint8_t const* texel = row + (size_t)x * 4;
+            uint32_t const pixel = texel[0] | (uint32_t)texel[1] << 8 | (uint32_t)texel[2] << 16 | (uint32_t)texel[3] << 24;
+            uint32_t const hash  = MixTileHash(pixel ^ MixTileHash((uint32_t)x | (uint32_t)y << 16));
+
+            sum  += hash;
+            bits ^= hash;
+        }
+    }
+    return sum | (uint64_t)bits << 32;
+}
+
+//----------------------------------------------------------------------------------------------------
+void ComputeTileChecksums(uint8_t const*     pixels,
+                          unsigned int const width,
+                          unsigned int const height,
+                          unsigned int const pitch,
+                          uint64_t*          checksums)
+{
+    for (unsigned int top = 0; top < height; top += READBACK_TILE_SIZE)
+    {
+        for (unsigned int left = 0; left < width; left += READBACK_TILE_SIZE)
+        {
+            sRect tile;
+            tile.left   = (int)left;
+            tile.top    = (int)top;
+            tile.right  = (int)(std::min)(left + READBACK_TILE_SIZE, width);
+            tile.bottom = (int)(std::min)(top + READBACK_TILE_SIZE, height);
+            *checksums++ = ComputeTileChecksum(pixels, pitch, tile);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+void PatchTiles(uint8_t*           destination,
+                unsigned int const destinationPitch,
+                uint8_t const*     source,
+                unsigned int const sourcePitch,
+                sRect const*       rects,
+                size_t const       count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        sRect const& rect  = rects[i];
+        size_t const bytes = (size_t)rect.GetWidth() * 4;
+        for (int y = rect.top; y < rect.bottom; ++y)
+        {
+            memcpy(destination + (size_t)y * destinationPitch + (size_t)rect.left * 4,
+                   source + (size_t)y * sourcePitch + (size_t)rect.left * 4,
+                   bytes);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+void TileChangeTracker::Resize(unsigned int const width, unsigned int const height)
+{
+    m_width      = width;
+    m_height     = height;
+    m_tileCountX = (width + READBACK_TILE_SIZE - 1) / READBACK_TILE_SIZE;
+    m_tileCountY = (height + READBACK_TILE_SIZE - 1) / READBACK_TILE_SIZE;
+    m_tiles.assign((size_t)m_tileCountX * m_tileCountY, sTile());
+    m_changedSpans.clear();
+}
+
+//----------------------------------------------------------------------------------------------------
+void TileChangeTracker::Reset()
+{
+    for (sTile& tile : m_tiles)
+    {
+        tile.isMirrorValid = false;
+        tile.isChanged     = false;
+    }
+    m_changedSpans.clear();
+}
+
+//----------------------------------------------------------------------------------------------------
+void TileChangeTracker::ClearCoverage()
+{
+    for (sTile& tile : m_tiles)
+    {
+        tile.isCovered = false;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+void TileChangeTracker::AddCoverage(sRect const& rect)
+{
+    sRect const clipped = rect.Intersect({0, 0, (int)m_width, (int)m_height});
+    if (clipped.IsEmpty()) return;
+
+    unsigned int const firstX = (unsigned int)clipped.left / READBACK_TILE_SIZE;
+    unsigned int const firstY = (unsigned int)clipped.top / READBACK_TILE_SIZE;
+    unsigned int const lastX  = (unsigned int)(clipped.right - 1) / READBACK_TILE_SIZE;
+    unsigned int const lastY  = (unsigned int)(clipped.bottom - 1) / READBACK_TILE_SIZE;
+    for (unsigned int y = firstY; y <= lastY; ++y)
+    {
+        for (unsigned int x = firstX; x <= lastX; ++x)
+        {
+            m_tiles[(size_t)y * m_tileCountX + x].isCovered = true;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+void TileChangeTracker::CoverAll()
+{
+    for (sTile& tile : m_tiles)
+    {
+        tile.isCovered = true;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+bool TileChangeTracker::HasStaleCoverage() const
+{
+    for (sTile const& tile : m_tiles)
+    {
+        if (tile.isCovered && IsStale(tile)) return true;
+    }
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------
+std::vector<sRect> const& TileChangeTracker::SetChecksums(uint64_t const* checksums)
+{
+    ++m_stats.readbacks;
+    m_changedSpans.clear();
+
+    for (unsigned int y = 0; y < m_tileCountY; ++y)
+    {
+        sRect span;
+        for (unsigned int x = 0; x < m_tileCountX; ++x)
+        {
+            size_t const index = (size_t)y * m_tileCountX + x;
+            sTile&       tile  = m_tiles[index];
+            tile.latest        = checksums[index];
+            tile.isChanged     = tile.isCovered && IsStale(tile);
+
+            if (!tile.isChanged)
+            {
+                if (tile.isCovered) ++m_stats.tilesUnchanged;
+                else if (IsStale(tile)) ++m_stats.tilesDeferred;
+
+                if (!span.IsEmpty()) m_changedSpans.push_back(span);
+                span = sRect();
+                continue;
+            }
+
+            // 同一列相鄰的區塊延伸目前的區間
+            ++m_stats.tilesCopied;
+            int const left  = (int)(x * READBACK_TILE_SIZE);
+            int const right = (int)(std::min)((x + 1) * READBACK_TILE_SIZE, m_width);
+            if (span.IsEmpty())
+            {
+                span.left   = left;
+                span.top    = (int)(y * READBACK_TILE_SIZE);
+                span.bottom = (int)(std::min)((y + 1) * READBACK_TILE_SIZE, m_height);
+            }
+            span.right = right;
+        }
+        if (!span.IsEmpty()) m_changedSpans.push_back(span);
+    }
+
+    m_stats.spansCopied += m_changedSpans.size();
+    return m_changedSpans;
+}
+
+//----------------------------------------------------------------------------------------------------
+void TileChangeTracker::CommitChangedTiles()
+{
+    for (sTile& tile : m_tiles)
+    {
+        if (!tile.isChanged) continue;
+
+        tile.mirror        = tile.latest;
+        tile.isMirrorValid = true;
+        tile.isChanged     = false;
+    }
+    m_changedSpans.clear();
+}
+
+//----------------------------------------------------------------------------------------------------
+size_t TileChangeTracker::GetMemoryBytes() const
+{
+    return m_tiles.capacity() * sizeof(sTile) + m_changedSpans.capacity() * sizeof(sRect);
+}
@@ -0,0 +1,89 @@
+﻿//----------------------------------------------------------------------------------------------------
+// TileReadback.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Region.hpp"
+
+//----------------------------------------------------------------------------------------------------
+unsigned int const READBACK_TILE_SIZE = 64;         // 與 TileChecksum shader 中的區塊大小相同
+
+//----------------------------------------------------------------------------------------------------
+// 區塊校驗碼 (RGBA8，pitch 以位元組計)：每個像素與其場景座標混合後的雜湊，低 32 位元為總和、高 32 位元為 XOR
+// 與 TileChecksum shader 的結果逐位元相同；任一像素改變 (包含兩個像素互換) 都會改變 XOR
+uint64_t ComputeTileChecksum(uint8_t const* pixels, unsigned int pitch, sRect const& tile);
+
+// 整個場景，依區塊的列優先順序寫入 checksums (ceil(width / 64) * ceil(height / 64) 個)
+void ComputeTileChecksums(uint8_t const* pixels, unsigned int width, unsigned int height, unsigned int pitch, uint64_t* checksums);
+
+// 把 source 中的矩形複製到 destination 的相同位置 (兩者都以場景原點為起點)
+void PatchTiles(uint8_t*       destination,
+                unsigned int   destinationPitch,
+                uint8_t const* source,
+                unsigned int   sourcePitch,
+                sRect const*   rects,
+                size_t         count);
+
+//----------------------------------------------------------------------------------------------------
+struct sTileReadbackStats
+{
+    unsigned long long readbacks      = 0;
+    unsigned long long tilesCopied    = 0;
+    unsigned long long tilesUnchanged = 0;      // 在窗口下但與鏡像相同
+    unsigned long long tilesDeferred  = 0;      // 有變化但不在任何窗口下，等到被看見時再讀回
+    unsigned long long spansCopied    = 0;      // 同一列相鄰的區塊合併為一次複製
+};
+
+//----------------------------------------------------------------------------------------------------
+// 記錄 CPU 鏡像中每個區塊對應的校驗碼，找出需要讀回的區塊：校驗碼改變，且在某個窗口下
+// 不在窗口下的區塊不讀回，鏡像中的內容因此過期；之後被窗口露出時 HasStaleCoverage 為 true，必須重新產生場景
+// 一次回讀：SetCoverage (AddCoverage / CoverAll) -> SetChecksums -> 複製 GetChangedTiles -> CommitChangedTiles
+class TileChangeTracker
+{
+public:
+    void Resize(unsigned int width, unsigned int height);      // 場景尺寸改變，整個鏡像失效
+    void Reset();                                               // 鏡像內容不再可信 (整幀回讀、緩衝區交換...)
+
+    unsigned int GetTileCountX() const { return m_tileCountX; }
+    unsigned int GetTileCountY() const { return m_tileCountY; }
+    size_t       GetTileCount() const { return m_tiles.size(); }
+
+    // 窗口看得到的場景區域 (場景座標)
+    void ClearCoverage();
+    void AddCoverage(sRect const& rect);
+    void CoverAll();
+    bool HasStaleCoverage() const;
+
+    // checksums 為 GetTileCount 個最新的校驗碼；回傳需要從場景複製到鏡像的區域 (已裁切到場景內)
+    std::vector<sRect> const& SetChecksums(uint64_t const* checksums);
+    std::vector<sRect> const& GetChangedTiles() const { return m_changedSpans; }
+    void                      CommitChangedTiles();        // 複製完成後呼叫；失敗時不呼叫，下一次回讀再試
+
+    sTileReadbackStats const& GetStats() const { return m_stats; }
+    size_t                    GetMemoryBytes() const;
+
+private:
+    struct sTile
+    {
+        uint64_t latest        = 0;                // 場景目前的內容
+        uint64_t mirror        = 0;                // 鏡像中的內容 (isMirrorValid 時)
+        bool     isMirrorValid = false;
+        bool     isCovered     = false;
+        bool     isChanged     = false;            // 本次回讀要複製
+    };
+
+    bool IsStale(sTile const& tile) const { return !tile.isMirrorValid || tile.mirror != tile.latest; }
+
+    unsigned int       m_width      = 0;
+    unsigned int       m_height     = 0;
+    unsigned int       m_tileCountX = 0;
+    unsigned int       m_tileCountY = 0;
+    std::vector<sTile> m_tiles;
+    std::vector<sRect> m_changedSpans;
+    sTileReadbackStats m_stats;
+};
@@ -0,0 +1,334 @@
+﻿//----------------------------------------------------------------------------------------------------
+// TileReadbackBenchmarkMain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// 區塊校驗碼與局部回讀的無頭檢查與基準 (不屬於 Windows 專案，在 Linux 上單獨編譯)：
+//
+//   g++ -std=c++14 -O2 TileReadbackBenchmarkMain.cpp TileReadback.cpp Region.cpp -o tile_readback_benchmark
+//   ./tile_readback_benchmark [frames]
+//
+// 先以小場景檢查校驗碼與區塊選擇的規則，再模擬 1080p 場景 (靜態背景上移動的精靈，部分區域被窗口覆蓋)：
+// 每幀只把選出的區塊修補到鏡像，並確認窗口下的鏡像與場景完全相同；比較與整幀回讀的複製量與 CPU 成本
+// 結束碼：0 = 全部通過，1 = 失敗
+//----------------------------------------------------------------------------------------------------
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "CheckMain.hpp"
+#include "TileReadback.hpp"
+
+//----------------------------------------------------------------------------------------------------
+static unsigned int const SCENE_WIDTH  = 1920;
+static unsigned int const SCENE_HEIGHT = 1080;
+static unsigned int const SPRITE_COUNT = 24;
+static int const          SPRITE_SIZE  = 48;
+static unsigned int const WINDOW_COUNT = 12;
+
+//----------------------------------------------------------------------------------------------------
+// RGBA8 場景緩衝區 (緊密排列)
+struct sImage
+{
+    unsigned int         width  = 0;
+    unsigned int         height = 0;
+    std::vector<uint8_t> pixels;
+
+    sImage(unsigned int const w, unsigned int const h) : width(w), height(h), pixels((size_t)w * h * 4) {}
+
+    unsigned int GetPitch() const { return width * 4; }
+    uint8_t*     GetPixel(int const x, int const y) { return pixels.data() + ((size_t)y * width + x) * 4; }
+};
+
+static void FillBackground(sImage& image)
+{
+    for (unsigned int y = 0; y < image.height; ++y)
+    {
+        for (unsigned int x = 0; x < image.width; ++x)
+        {
+            uint8_t* pixel = image.GetPixel((int)x, (int)y);
+            pixel[0]       = (uint8_t)(x * 255 / image.width);
+            pixel[1]       = (uint8_t)(y * 255 / image.height);
+            pixel[2]       = (uint8_t)((x ^ y) & 0x3F);
+            pixel[3]       = 255;
+        }
+    }
+}
+
+static void FillRect(sImage& image, sRect const& rect, uint32_t const color)
+{
+    sRect const clipped = rect.Intersect({0, 0, (int)image.width, (int)image.height});
+    for (int y = clipped.top; y < clipped.bottom; ++y)
+    {
+        for (int x = clipped.left; x < clipped.right; ++x)
+        {
+            memcpy(image.GetPixel(x, y), &color, 4);
+        }
+    }
+}
+
+static bool IsRegionEqual(sImage const& a, sImage const& b, sRect const& rect)
+{
+    sRect const clipped = rect.Intersect({0, 0, (int)a.width, (int)a.height});
+    for (int y = clipped.top; y < clipped.bottom; ++y)
+    {
+        size_t const offset = ((size_t)y * a.width + clipped.left) * 4;
+        if (memcmp(a.pixels.data() + offset, b.pixels.data() + offset, (size_t)clipped.GetWidth() * 4) != 0) return false;
+    }
+    return true;
+}
+
+// 精靈 i 在第 t 幀的位置 (各自不同的速度，碰到邊界時繞回)
+static sRect GetSpriteRect(unsigned int const i, unsigned int const t)
+{
+    int const x = (int)((i * 151 + t * (3 + i % 5)) % (SCENE_WIDTH - SPRITE_SIZE));
+    int const y = (int)((i * 89 + t * (2 + i % 3)) % (SCENE_HEIGHT - SPRITE_SIZE));
+    return {x, y, x + SPRITE_SIZE, y + SPRITE_SIZE};
+}
+
+// 一次完整的回讀：計算校驗碼 (GPU 上的 shader)、選出區塊、修補鏡像；回傳複製的區域 (提交後 tracker 中的會清除)
+static std::vector<sRect> ReadBackTiles(TileChangeTracker& tracker, sImage const& scene, sImage& mirror, std::vector<uint64_t>& checksums)
+{
+    checksums.resize(tracker.GetTileCount());
+    ComputeTileChecksums(scene.pixels.data(), scene.width, scene.height, scene.GetPitch(), checksums.data());
+
+    std::vector<sRect> const spans = tracker.SetChecksums(checksums.data());
+    PatchTiles(mirror.pixels.data(), mirror.GetPitch(), scene.pixels.data(), scene.GetPitch(), spans.data(), spans.size());
+    tracker.CommitChangedTiles();
+    return spans;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 校驗碼：任一像素改變、兩個像素互換、邊緣不足 64 的區塊都要偵測到；相同內容結果相同
+static bool CheckChecksums()
+{
+    sImage image(150, 70);
+    FillBackground(image);
+
+    sRect const    tile     = {64, 0, 128, 64};
+    sRect const    edgeTile = {128, 64, 150, 70};
+    uint64_t const base     = ComputeTileChecksum(image.pixels.data(), image.GetPitch(), tile);
+    uint64_t const edgeBase = ComputeTileChecksum(image.pixels.data(), image.GetPitch(), edgeTile);
+
+    bool isEveryPixelDetected = true;
+    for (int y = tile.top; y < tile.bottom; ++y)
+    {
+        for (int x = tile.left; x < tile.right; ++x)
+        {
+            uint8_t* pixel = image.GetPixel(x, y);
+            pixel[3] ^= 1;
+            isEveryPixelDetected &= ComputeTileChecksum(image.pixels.data(), image.GetPitch(), tile) != base;
+            pixel[3] ^= 1;
+        }
+    }
+
+    // 互換兩個不同的像素：總和與 XOR 都與位置無關的雜湊會漏掉，這裡必須偵測到
+    uint8_t saved[4];
+    memcpy(saved, image.GetPixel(70, 10), 4);
+    memcpy(image.GetPixel(70, 10), image.GetPixel(100, 40), 4);
+    memcpy(image.GetPixel(100, 40), saved, 4);
+    bool const isSwapDetected = ComputeTileChecksum(image.pixels.data(), image.GetPitch(), tile) != base;
+    memcpy(image.GetPixel(100, 40), image.GetPixel(70, 10), 4);
+    memcpy(image.GetPixel(70, 10), saved, 4);
+
+    image.GetPixel(149, 69)[0] ^= 0x80;
+    bool const isEdgeDetected = ComputeTileChecksum(image.pixels.data(), image.GetPitch(), edgeTile) != edgeBase;
+    image.GetPixel(149, 69)[0] ^= 0x80;
+
+    // 整個場景的版本與逐一呼叫相同，且依列優先順序排列
+    std::vector<uint64_t> checksums(3 * 2);
+    ComputeTileChecksums(image.pixels.data(), image.width, image.height, image.GetPitch(), checksums.data());
+
+    bool isPassing = true;
+    isPassing &= Check(isEveryPixelDetected, "checksum_every_pixel");
+    isPassing &= Check(isSwapDetected, "checksum_swap");
+    isPassing &= Check(isEdgeDetected, "checksum_edge_tile");
+    isPassing &= Check(checksums[1] == base && checksums[5] == edgeBase, "checksum_tile_order");
+    isPassing &= Check(ComputeTileChecksum(image.pixels.data(), image.GetPitch(), tile) == base, "checksum_stable");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 區塊選擇：只有窗口下且改變的區塊；窗口外的改變延後，被窗口露出時回報過期
+static bool CheckTracker()
+{
+    sImage scene(300, 200);          // 5 x 4 個區塊，最右欄與最下列不足 64
+    sImage mirror(300, 200);
+    FillBackground(scene);
+
+    TileChangeTracker     tracker;
+    std::vector<uint64_t> checksums;
+    tracker.Resize(scene.width, scene.height);
+
+    sRect const window = {10, 10, 150, 100};     // 區塊 (0..2, 0..1)
+    tracker.AddCoverage(window);
+    bool const isInitiallyStale = tracker.HasStaleCoverage();
+
+    std::vector<sRect> const first      = ReadBackTiles(tracker, scene, mirror, checksums);
+    bool const               isFirstRow = first.size() == 2 && first[0].left == 0 && first[0].right == 192 && first[1].top == 64;
+
+    bool isPassing = true;
+    isPassing &= Check(tracker.GetTileCountX() == 5 && tracker.GetTileCountY() == 4, "tracker_tile_count");
+    isPassing &= Check(isInitiallyStale && isFirstRow, "tracker_first_readback_spans");
+    isPassing &= Check(IsRegionEqual(scene, mirror, window) && !tracker.HasStaleCoverage(), "tracker_first_readback_mirror");
+
+    // 沒有變化：什麼都不複製
+    isPassing &= Check(ReadBackTiles(tracker, scene, mirror, checksums).empty(), "tracker_unchanged");
+
+    // 窗口下一個像素改變：只複製那個區塊
+    scene.GetPixel(140, 70)[1] ^= 0xFF;
+    std::vector<sRect> const single = ReadBackTiles(tracker, scene, mirror, checksums);
+    isPassing &= Check(single.size() == 1 && single[0].left == 128 && single[0].top == 64 && single[0].right == 192, "tracker_single_tile");
+    isPassing &= Check(IsRegionEqual(scene, mirror, window), "tracker_single_tile_mirror");
+
+    // 窗口外改變：不複製，窗口移過去之後回報過期，下一次回讀補上
+    FillRect(scene, {260, 150, 300, 200}, 0xFF0000FF);
+    unsigned long long const deferredBefore = tracker.GetStats().tilesDeferred;
+    isPassing &= Check(ReadBackTiles(tracker, scene, mirror, checksums).empty() && tracker.GetStats().tilesDeferred > deferredBefore, "tracker_uncovered_deferred");
+
+    sRect const movedWindow = {200, 120, 300, 200};
+    tracker.ClearCoverage();
+    tracker.AddCoverage(movedWindow);
+    isPassing &= Check(tracker.HasStaleCoverage(), "tracker_exposed_stale");
+    ReadBackTiles(tracker, scene, mirror, checksums);
+    isPassing &= Check(IsRegionEqual(scene, mirror, movedWindow) && !tracker.HasStaleCoverage(), "tracker_exposed_patched");
+
+    // 改變後回讀失敗 (沒有提交)，之後又改回鏡像中的內容：校驗碼相同，不需要複製
+    sImage const          before = scene;
+    std::vector<uint64_t> changed(tracker.GetTileCount());
+    FillRect(scene, {200, 120, 210, 130}, 0xFFFFFFFF);
+    ComputeTileChecksums(scene.pixels.data(), scene.width, scene.height, scene.GetPitch(), changed.data());
+    bool const isChangeSelected = !tracker.SetChecksums(changed.data()).empty();
+    scene                       = before;
+    isPassing &= Check(isChangeSelected && ReadBackTiles(tracker, scene, mirror, checksums).empty(), "tracker_reverted_content");
+
+    // 重設與改變尺寸後全部重新讀回
+    tracker.Reset();
+    isPassing &= Check(tracker.HasStaleCoverage(), "tracker_reset");
+    tracker.Resize(100, 100);
+    tracker.CoverAll();
+    isPassing &= Check(tracker.GetTileCount() == 4 && tracker.HasStaleCoverage(), "tracker_resize");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+int main(int const argc, char** argv)
+{
+    using Clock = std::chrono::steady_clock;
+
+    unsigned int const frameCount = argc > 1 ? (unsigned int)strtoul(argv[1], nullptr, 0) : 300u;
+
+    bool isPassing = true;
+    isPassing &= CheckChecksums();
+    isPassing &= CheckTracker();
+
+    // 1080p：固定的背景與窗口，精靈每幀移動；每 60 幀移動一個窗口
+    sImage background(SCENE_WIDTH, SCENE_HEIGHT);
+    FillBackground(background);
+    sImage scene = background;
+    sImage mirror(SCENE_WIDTH, SCENE_HEIGHT);
+    sImage full(SCENE_WIDTH, SCENE_HEIGHT);
+
+    sRect windows[WINDOW_COUNT];
+    for (unsigned int i = 0; i < WINDOW_COUNT; ++i)
+    {
+        int const left = (int)((i * 397) % (SCENE_WIDTH - 320));
+        int const top  = (int)((i * 211) % (SCENE_HEIGHT - 240));
+        windows[i]     = {left, top, left + 320, top + 240};
+    }
+
+    TileChangeTracker     tracker;
+    std::vector<uint64_t> checksums;
+    tracker.Resize(SCENE_WIDTH, SCENE_HEIGHT);
+    checksums.resize(tracker.GetTileCount());
+
+    double             checksumMs   = 0;
+    double             selectMs     = 0;
+    double             patchMs      = 0;
+    double             fullCopyMs   = 0;
+    unsigned long long tileBytes    = 0;
+    unsigned long long fullBytes    = 0;
+    unsigned int       staleFrames  = 0;
+    bool               isMirrorSame = true;
+
+    for (unsigned int frame = 0; frame < frameCount; ++frame)
+    {
+        if (frame % 60 == 59)
+        {
+            int const dx    = 37 - (int)((frame * 13) % 75);
+            int const dy    = 23 - (int)((frame * 7) % 47);
+            sRect&    moved = windows[(frame / 60) % WINDOW_COUNT];
+            moved           = {moved.left + dx, moved.top + dy, moved.right + dx, moved.bottom + dy};
+        }
+
+        // 場景：背景加上移動中的精靈 (只重畫上一幀與這一幀的精靈區域)
+        for (unsigned int i = 0; i < SPRITE_COUNT; ++i)
+        {
+            sRect const previous = GetSpriteRect(i, frame);
+            PatchTiles(scene.pixels.data(), scene.GetPitch(), background.pixels.data(), background.GetPitch(), &previous, 1);
+        }
+        for (unsigned int i = 0; i < SPRITE_COUNT; ++i)
+        {
+            FillRect(scene, GetSpriteRect(i, frame + 1), 0xFF000000u | (i * 0x00102030u));
+        }
+
+        tracker.ClearCoverage();
+        for (sRect const& window : windows)
+        {
+            tracker.AddCoverage(window);
+        }
+        if (tracker.HasStaleCoverage()) ++staleFrames;
+
+        Clock::time_point const checksumStart = Clock::now();
+        ComputeTileChecksums(scene.pixels.data(), scene.width, scene.height, scene.GetPitch(), checksums.data());
+        Clock::time_point const selectStart = Clock::now();
+        std::vector<sRect> const& spans = tracker.SetChecksums(checksums.data());
+        Clock::time_point const patchStart = Clock::now();
+        PatchTiles(mirror.pixels.data(), mirror.GetPitch(), scene.pixels.data(), scene.GetPitch(), spans.data(), spans.size());
+        Clock::time_point const patchEnd = Clock::now();
+
+        for (sRect const& span : spans)
+        {
+            tileBytes += (unsigned long long)span.GetArea() * 4;
+        }
+        tracker.CommitChangedTiles();
+
+        // 對照：改寫之前每幀複製整個場景
+        Clock::time_point const fullStart = Clock::now();
+        memcpy(full.pixels.data(), scene.pixels.data(), scene.pixels.size());
+        Clock::time_point const fullEnd = Clock::now();
+        fullBytes += scene.pixels.size();
+
+        checksumMs += std::chrono::duration<double, std::milli>(selectStart - checksumStart).count();
+        selectMs   += std::chrono::duration<double, std::milli>(patchStart - selectStart).count();
+        patchMs    += std::chrono::duration<double, std::milli>(patchEnd - patchStart).count();
+        fullCopyMs += std::chrono::duration<double, std::milli>(fullEnd - fullStart).count();
+
+        for (sRect const& window : windows)
+        {
+            isMirrorSame &= IsRegionEqual(scene, mirror, window);
+        }
+    }
+
+    sTileReadbackStats const& stats = tracker.GetStats();
+    printf("frames %u\n", frameCount);
+    printf("tiles %zu\n", tracker.GetTileCount());
+    printf("tiles_copied %llu\n", stats.tilesCopied);
+    printf("tiles_unchanged %llu\n", stats.tilesUnchanged);
+    printf("tiles_deferred %llu\n", stats.tilesDeferred);
+    printf("spans_copied %llu\n", stats.spansCopied);
+    printf("stale_frames %u\n", staleFrames);
+    printf("full_readback_bytes %llu\n", fullBytes);
+    printf("tile_readback_bytes %llu\n", tileBytes);
+    printf("readback_ratio %.4f\n", fullBytes ? (double)tileBytes / (double)fullBytes : 0.0);
+    printf("cpu_checksum_ms_per_frame %.3f\n", checksumMs / frameCount);
+    printf("select_ms_per_frame %.4f\n", selectMs / frameCount);
+    printf("patch_ms_per_frame %.4f\n", patchMs / frameCount);
+    printf("full_copy_ms_per_frame %.4f\n", fullCopyMs / frameCount);
+
+    isPassing &= Check(isMirrorSame, "simulation_mirror");
+    isPassing &= Check(tileBytes < fullBytes, "simulation_fewer_bytes");
+    return isPassing ? 0 : 1;
+}
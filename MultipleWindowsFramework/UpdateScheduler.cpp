@@ -0,0 +1,141 @@
+﻿//----------------------------------------------------------------------------------------------------
+// UpdateScheduler.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "UpdateScheduler.hpp"
+
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------
+static int constexpr MAX_FRAMES_SINCE_UPDATE = 1 << 20;
+
+//----------------------------------------------------------------------------------------------------
+static int GetTierIndex(int const rateDivisor)
+{
+    switch (rateDivisor)
+    {
+    case 1: return 0;
+    case 2: return 1;
+    case 4: return 2;
+    default: return 3;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+static void AccumulateStats(sUpdateSchedulerStats& total, sUpdateSchedulerStats const& frame)
+{
+    total.frames        += frame.frames;
+    total.considered    += frame.considered;
+    total.updated       += frame.updated;
+    total.skippedHidden += frame.skippedHidden;
+    total.skippedRate   += frame.skippedRate;
+    total.skippedBudget += frame.skippedBudget;
+    total.pixelsUpdated += frame.pixelsUpdated;
+
+    for (int i = 0; i < UPDATE_RATE_TIER_COUNT; ++i)
+    {
+        total.tierCount[i] += frame.tierCount[i];
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+UpdateScheduler::UpdateScheduler(sUpdateSchedulerConfig const& config)
+    : m_config(config)
+{
+}
+
+//----------------------------------------------------------------------------------------------------
+int UpdateScheduler::ClassifyRateDivisor(sUpdateState const& state) const
+{
+    if (state.visibleArea <= 0) return 0;   // 完全看不到，不需要更新
+    if (state.isFocused) return 1;          // 使用者正在操作的窗口永遠全速
+
+    if (state.speed >= m_config.fastSpeed || state.visibleArea >= m_config.largeArea)
+    {
+        return 1;
+    }
+
+    bool const isStill = state.speed < m_config.slowSpeed;
+    bool const isSmall = state.visibleArea < m_config.smallArea;
+
+    if (isStill && isSmall) return 8;
+    if (isStill || isSmall) return 4;
+    return 2;
+}
+
+//----------------------------------------------------------------------------------------------------
+void UpdateScheduler::Schedule(std::vector<sUpdateState*> const& states)
+{
+    sUpdateSchedulerStats frameStats;
+    frameStats.frames = 1;
+
+    m_dueStates.clear();
+
+    for (sUpdateState* state : states)
+    {
+        state->shouldUpdate = false;
+        state->rateDivisor  = ClassifyRateDivisor(*state);
+
+        if (!state->isDirty) continue;
+        ++frameStats.considered;
+
+        if (state->rateDivisor == 0)
+        {
+            ++frameStats.skippedHidden;
+            continue;
+        }
+
+        ++frameStats.tierCount[GetTierIndex(state->rateDivisor)];
+
+        // 依相位錯開，讓同等級的窗口平均分散到不同幀；錯過自己相位的窗口則立即補上
+        unsigned int const divisor = (unsigned int)state->rateDivisor;
+        bool const         onPhase = (m_frameIndex + state->phase) % divisor == 0;
+        bool const         isLate  = state->framesSinceUpdate > state->rateDivisor;
+
+        if (!onPhase && !isLate)
+        {
+            ++frameStats.skippedRate;
+            continue;
+        }
+
+        m_dueStates.push_back(state);
+    }
+
+    // 優先順序：前景窗口、相對於自身頻率等待最久 (避免預算不足時低頻窗口永遠輪不到)、更新頻率高
+    std::stable_sort(m_dueStates.begin(), m_dueStates.end(), [](sUpdateState const* a, sUpdateState const* b)
+    {
+        if (a->isFocused != b->isFocused) return a->isFocused;
+
+        long long const latenessA = (long long)a->framesSinceUpdate * b->rateDivisor;
+        long long const latenessB = (long long)b->framesSinceUpdate * a->rateDivisor;
+        if (latenessA != latenessB) return latenessA > latenessB;
+
+        return a->rateDivisor < b->rateDivisor;
+    });
+
+    long long const budget = m_config.pixelBudgetPerFrame;
+    for (sUpdateState* state : m_dueStates)
+    {
+        // 每幀至少更新一個窗口，避免單一大窗口永遠超出預算
+        if (budget > 0 && frameStats.pixelsUpdated > 0 &&
+            frameStats.pixelsUpdated + state->visibleArea > budget)
+        {
+            ++frameStats.skippedBudget;
+            continue;
+        }
+
+        state->shouldUpdate = true;
+        frameStats.pixelsUpdated += state->visibleArea;
+        ++frameStats.updated;
+    }
+
+    for (sUpdateState* state : states)
+    {
+        state->framesSinceUpdate = state->shouldUpdate ? 0 : (std::min)(state->framesSinceUpdate + 1, MAX_FRAMES_SINCE_UPDATE);
+    }
+
+    ++m_frameIndex;
+    m_lastFrameStats = frameStats;
+    AccumulateStats(m_totalStats, frameStats);
+}
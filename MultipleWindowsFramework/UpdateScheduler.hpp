@@ -0,0 +1,77 @@
+﻿//----------------------------------------------------------------------------------------------------
+// UpdateScheduler.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+// 更新頻率等級：每 1/2/4/8 幀更新一次
+int constexpr UPDATE_RATE_TIER_COUNT = 4;
+
+//----------------------------------------------------------------------------------------------------
+struct sUpdateSchedulerConfig
+{
+    long long pixelBudgetPerFrame = 0;          // 每幀最多更新的像素數 (0 = 不限制)
+    float     fastSpeed           = 60.f;       // 超過此速度 (像素/秒) 以全速更新
+    float     slowSpeed           = 10.f;       // 低於此速度視為靜止
+    long long largeArea           = 300 * 200;  // 可見面積大於此值以全速更新
+    long long smallArea           = 120 * 90;   // 可見面積小於此值視為小窗口
+};
+
+//----------------------------------------------------------------------------------------------------
+// 每個窗口的排程狀態，由呼叫端填入輸入欄位後交給 UpdateScheduler
+struct sUpdateState
+{
+    // 輸入
+    long long    visibleArea = 0;               // 可見像素數 (0 = 完全被遮擋)
+    float        speed       = 0.f;             // 移動速度 (像素/秒)
+    bool         isFocused   = false;           // 是否為前景窗口
+    bool         isDirty     = false;           // 是否有待更新的內容
+    unsigned int phase       = 0;               // 錯開更新的相位，通常為窗口索引
+
+    // 輸出
+    int  rateDivisor       = 1;                 // 0 = 不可見, 1/2/4/8 = 每 N 幀更新一次
+    bool shouldUpdate      = false;             // 本幀是否更新
+    int  framesSinceUpdate = 0;                 // 距離上次更新的幀數
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sUpdateSchedulerStats
+{
+    long long frames          = 0;
+    long long considered      = 0;              // 有待更新內容的窗口
+    long long updated         = 0;
+    long long skippedHidden   = 0;              // 完全被遮擋
+    long long skippedRate     = 0;              // 不在本幀的更新相位
+    long long skippedBudget   = 0;              // 超出像素預算而延後
+    long long pixelsUpdated   = 0;
+    long long tierCount[UPDATE_RATE_TIER_COUNT] = {};   // 各等級 (1/2/4/8) 被分配的次數
+
+    void Reset() { *this = sUpdateSchedulerStats(); }
+};
+
+//----------------------------------------------------------------------------------------------------
+class UpdateScheduler
+{
+public:
+    explicit UpdateScheduler(sUpdateSchedulerConfig const& config = sUpdateSchedulerConfig());
+
+    void                          SetConfig(sUpdateSchedulerConfig const& config) { m_config = config; }
+    sUpdateSchedulerConfig const& GetConfig() const { return m_config; }
+
+    int  ClassifyRateDivisor(sUpdateState const& state) const;
+    void Schedule(std::vector<sUpdateState*> const& states);
+
+    sUpdateSchedulerStats const& GetLastFrameStats() const { return m_lastFrameStats; }
+    sUpdateSchedulerStats const& GetTotalStats() const { return m_totalStats; }
+    unsigned int                 GetFrameIndex() const { return m_frameIndex; }
+
+private:
+    sUpdateSchedulerConfig     m_config;
+    sUpdateSchedulerStats      m_lastFrameStats;
+    sUpdateSchedulerStats      m_totalStats;
+    unsigned int               m_frameIndex = 0;
+    std::vector<sUpdateState*> m_dueStates;
+};
@@ -0,0 +1,301 @@
+﻿//----------------------------------------------------------------------------------------------------
+// UpdateSchedulerCheckMain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// 更新排程的無介面模擬 (不屬於 Windows 專案，在 Linux 上單獨編譯)：
+//
+//   g++ -std=c++14 -O2 UpdateSchedulerCheckMain.cpp UpdateScheduler.cpp -o update_scheduler_check
+//   ./update_scheduler_check [windows]
+//
+// 以數千個合成窗口檢查：等級分配、同等級窗口依相位平均分散到各幀、像素預算不足時等待最久的窗口
+// 優先 (isLate 的補更新，沒有窗口永遠輪不到)、前景與超出預算的大窗口仍會更新，以及統計數字的一致性；
+// 最後量測每幀 Schedule 的時間
+// 結束碼：0 = 全部通過，1 = 失敗
+//----------------------------------------------------------------------------------------------------
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "CheckMain.hpp"
+#include "UpdateScheduler.hpp"
+
+//----------------------------------------------------------------------------------------------------
+// 合成窗口：狀態本身與交給 Schedule 的指標
+struct sSimulatedWindows
+{
+    std::vector<sUpdateState>  states;
+    std::vector<sUpdateState*> pointers;
+
+    explicit sSimulatedWindows(size_t const count, sUpdateState const& state = sUpdateState())
+        : states(count, state)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            states[i].phase = (unsigned int)i;
+            pointers.push_back(&states[i]);
+        }
+    }
+};
+
+static sUpdateState MakeState(long long const visibleArea, float const speed, bool const isDirty = true)
+{
+    sUpdateState state;
+    state.visibleArea = visibleArea;
+    state.speed       = speed;
+    state.isDirty     = isDirty;
+    return state;
+}
+
+// 每幀的統計必須能互相對上：每個待更新的窗口恰好落在一個結果
+static bool IsFrameConsistent(sUpdateSchedulerStats const& stats)
+{
+    long long tiers = 0;
+    for (int i = 0; i < UPDATE_RATE_TIER_COUNT; ++i)
+    {
+        tiers += stats.tierCount[i];
+    }
+    return stats.frames == 1 &&
+           stats.considered == stats.updated + stats.skippedHidden + stats.skippedRate + stats.skippedBudget &&
+           tiers == stats.considered - stats.skippedHidden;
+}
+
+//----------------------------------------------------------------------------------------------------
+static bool CheckTierAssignment()
+{
+    UpdateScheduler const         scheduler;
+    sUpdateSchedulerConfig const& config = scheduler.GetConfig();
+
+    sUpdateState focused = MakeState(1000, 0.f);
+    focused.isFocused    = true;
+
+    struct sCase
+    {
+        sUpdateState state;
+        int          rateDivisor;
+    };
+    sCase const cases[] = {
+        {MakeState(0, 500.f), 0},                                        // 完全被遮擋
+        {focused, 1},                                                    // 前景
+        {MakeState(1000, config.fastSpeed), 1},                          // 快速移動
+        {MakeState(config.largeArea, 0.f), 1},                           // 大窗口
+        {MakeState(config.smallArea - 1, config.slowSpeed - 1.f), 8},    // 靜止的小窗口
+        {MakeState(config.smallArea, config.slowSpeed - 1.f), 4},        // 靜止
+        {MakeState(config.smallArea - 1, config.slowSpeed), 4},          // 小窗口
+        {MakeState(config.smallArea, config.slowSpeed), 2},              // 其他
+    };
+
+    bool isMatched = true;
+    for (sCase const& test : cases)
+    {
+        isMatched &= scheduler.ClassifyRateDivisor(test.state) == test.rateDivisor;
+    }
+    return Check(isMatched, "tier_assignment");
+}
+
+//----------------------------------------------------------------------------------------------------
+// 沒有預算限制時，每個等級的窗口剛好每 N 幀更新一次，每幀更新的數量相同
+static bool CheckPhaseStagger(size_t const windowCount)
+{
+    UpdateScheduler   scheduler;
+    sSimulatedWindows windows(windowCount);
+    long long const   smallArea = scheduler.GetConfig().smallArea;
+    for (size_t i = 0; i < windowCount; ++i)
+    {
+        // 依序為 1/2/4/8 四個等級
+        switch (i % 4)
+        {
+        case 0:  windows.states[i] = MakeState(scheduler.GetConfig().largeArea, 0.f); break;
+        case 1:  windows.states[i] = MakeState(smallArea, scheduler.GetConfig().slowSpeed); break;
+        case 2:  windows.states[i] = MakeState(smallArea, 0.f); break;
+        default: windows.states[i] = MakeState(smallArea - 1, 0.f); break;
+        }
+        windows.states[i].phase = (unsigned int)(i / 4);
+    }
+
+    int const        frames       = 64;
+    long long        minPerFrame  = -1;
+    long long        maxPerFrame  = 0;
+    bool             isOnSchedule = true;
+    bool             isConsistent = true;
+    std::vector<int> updates(windowCount, 0);
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        scheduler.Schedule(windows.pointers);
+        sUpdateSchedulerStats const& stats = scheduler.GetLastFrameStats();
+        isConsistent &= IsFrameConsistent(stats) && stats.skippedBudget == 0;
+
+        long long const updated = stats.updated;
+        minPerFrame             = minPerFrame < 0 ? updated : (std::min)(minPerFrame, updated);
+        maxPerFrame             = (std::max)(maxPerFrame, updated);
+
+        for (size_t i = 0; i < windowCount; ++i)
+        {
+            sUpdateState const& state = windows.states[i];
+            if (state.shouldUpdate) ++updates[i];
+            isOnSchedule &= state.framesSinceUpdate < state.rateDivisor;
+        }
+    }
+
+    bool isEvenlyUpdated = true;
+    for (size_t i = 0; i < windowCount; ++i)
+    {
+        isEvenlyUpdated &= updates[i] == frames / windows.states[i].rateDivisor;
+    }
+
+    // 每幀：1 級全部，2/4/8 級各自的 1/N (四個等級的窗口數相同)
+    size_t const    perTier  = windowCount / 4;
+    long long const expected = (long long)(perTier + perTier / 2 + perTier / 4 + perTier / 8);
+
+    printf("stagger_windows %zu\n", windowCount);
+    printf("stagger_updates_per_frame_min %lld\n", minPerFrame);
+    printf("stagger_updates_per_frame_max %lld\n", maxPerFrame);
+
+    bool isPassing = true;
+    isPassing &= Check(isEvenlyUpdated && isOnSchedule, "stagger_rate");
+    isPassing &= Check(maxPerFrame - minPerFrame <= 4 && minPerFrame <= expected && maxPerFrame >= expected, "stagger_spread");
+    isPassing &= Check(isConsistent, "stagger_stats");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 預算只夠每幀更新一小部分窗口：每幀不超出預算，等待最久的窗口優先，沒有窗口被餓死
+static bool CheckBudgetStarvation(size_t const windowCount)
+{
+    long long const windowArea    = 20000;
+    size_t const    perFrame      = 50;
+    size_t const    focusedWindow = windowCount / 2;
+
+    sUpdateSchedulerConfig config;
+    config.pixelBudgetPerFrame = windowArea * (long long)perFrame;
+
+    UpdateScheduler   scheduler(config);
+    sSimulatedWindows windows(windowCount, MakeState(windowArea, 30.f));
+    windows.states[focusedWindow].isFocused = true;
+
+    int const        frames        = (int)(windowCount / perFrame) * 4;
+    int              maxGap        = 0;
+    bool             isInBudget    = true;
+    bool             isConsistent  = true;
+    bool             isFocusedKept = true;
+    long long        lateUpdates   = 0;
+    std::vector<int> lastUpdate(windowCount, -1);
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        // 依相位本幀不該更新，卻因為等太久而更新的窗口 (isLate)
+        std::vector<bool> wasLate(windowCount);
+        for (size_t i = 0; i < windowCount; ++i)
+        {
+            sUpdateState const& state = windows.states[i];
+            wasLate[i] = (scheduler.GetFrameIndex() + state.phase) % 2 != 0 && state.framesSinceUpdate > 2;
+        }
+
+        scheduler.Schedule(windows.pointers);
+        sUpdateSchedulerStats const& stats = scheduler.GetLastFrameStats();
+        isInBudget &= stats.pixelsUpdated <= config.pixelBudgetPerFrame && stats.updated == (long long)perFrame;
+        isConsistent &= IsFrameConsistent(stats);
+        isFocusedKept &= windows.states[focusedWindow].shouldUpdate;
+
+        for (size_t i = 0; i < windowCount; ++i)
+        {
+            if (!windows.states[i].shouldUpdate) continue;
+            if (wasLate[i]) ++lateUpdates;
+            maxGap        = (std::max)(maxGap, frame - lastUpdate[i]);
+            lastUpdate[i] = frame;
+        }
+    }
+
+    // 最後兩圈內每個窗口都更新過，最長的間隔 (包含第一次更新前的等待) 不超過輪兩圈的幀數
+    bool isEveryWindowUpdated = true;
+    for (size_t i = 0; i < windowCount; ++i)
+    {
+        isEveryWindowUpdated &= lastUpdate[i] >= frames - (int)(windowCount / perFrame) * 2;
+    }
+    int const roundFrames = (int)((windowCount + perFrame - 1) / perFrame);
+
+    sUpdateSchedulerStats const& total = scheduler.GetTotalStats();
+    printf("budget_windows %zu\n", windowCount);
+    printf("budget_frames %d\n", frames);
+    printf("budget_round_frames %d\n", roundFrames);
+    printf("budget_max_gap_frames %d\n", maxGap);
+    printf("budget_late_updates %lld\n", lateUpdates);
+    printf("budget_skipped_total %lld\n", total.skippedBudget);
+
+    bool isPassing = true;
+    isPassing &= Check(isInBudget, "budget_limit");
+    isPassing &= Check(isEveryWindowUpdated && maxGap <= roundFrames * 2 + 2 && lateUpdates > 0, "budget_no_starvation");
+    isPassing &= Check(isFocusedKept, "budget_focused_first");
+    isPassing &= Check(isConsistent && total.frames == frames && total.skippedBudget > 0, "budget_stats");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 比預算還大的窗口每幀仍至少更新一個；沒有待更新內容或看不到的窗口不更新
+static bool CheckEdgeCases()
+{
+    sUpdateSchedulerConfig config;
+    config.pixelBudgetPerFrame = 1000;
+
+    UpdateScheduler   scheduler(config);
+    sSimulatedWindows windows(3);
+    windows.states[0] = MakeState(5000, 100.f);
+    windows.states[1] = MakeState(5000, 100.f, false);
+    windows.states[2] = MakeState(0, 100.f);
+
+    bool isLargeUpdated = true;
+    bool isIdleSkipped  = true;
+    for (int frame = 0; frame < 8; ++frame)
+    {
+        scheduler.Schedule(windows.pointers);
+        isLargeUpdated &= windows.states[0].shouldUpdate;
+        isIdleSkipped &= !windows.states[1].shouldUpdate && !windows.states[2].shouldUpdate && windows.states[2].rateDivisor == 0;
+    }
+
+    sUpdateSchedulerStats const& total = scheduler.GetTotalStats();
+
+    bool isPassing = true;
+    isPassing &= Check(isLargeUpdated, "oversized_window_updates");
+    isPassing &= Check(isIdleSkipped && total.considered == 16 && total.skippedHidden == 8 && total.updated == 8, "idle_windows_skipped");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+int main(int const argc, char** argv)
+{
+    using Clock = std::chrono::steady_clock;
+
+    size_t const windowCount = argc > 1 ? (size_t)strtoul(argv[1], nullptr, 0) : 4000;
+
+    bool isPassing = true;
+    isPassing &= CheckTierAssignment();
+    isPassing &= CheckPhaseStagger(windowCount);
+    isPassing &= CheckBudgetStarvation(windowCount);
+    isPassing &= CheckEdgeCases();
+
+    // 基準：各種等級混合的窗口，有預算限制
+    sUpdateSchedulerConfig config;
+    config.pixelBudgetPerFrame = 1920 * 1080;
+
+    UpdateScheduler   scheduler(config);
+    sSimulatedWindows windows(windowCount);
+    for (size_t i = 0; i < windowCount; ++i)
+    {
+        windows.states[i]       = MakeState(2000 + (long long)(i * 7919 % 80000), (float)(i * 31 % 120));
+        windows.states[i].phase = (unsigned int)i;
+    }
+
+    int const               frames = 1000;
+    Clock::time_point const start  = Clock::now();
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        scheduler.Schedule(windows.pointers);
+    }
+    Clock::time_point const end = Clock::now();
+
+    printf("benchmark_windows %zu\n", windowCount);
+    printf("benchmark_updates_per_frame %.1f\n", (double)scheduler.GetTotalStats().updated / frames);
+    printf("benchmark_schedule_us %.2f\n", std::chrono::duration<double, std::micro>(end - start).count() / frames);
+    return isPassing ? 0 : 1;
+}
@@ -0,0 +1,356 @@
+﻿//----------------------------------------------------------------------------------------------------
+// VirtualTexture.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "VirtualTexture.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "ThreadPool.hpp"
+
+//----------------------------------------------------------------------------------------------------
+static void FillRect(uint32_t* target, unsigned int const targetPitch, sRect const& rect, uint32_t const color)
+{
+    for (int y = rect.top; y < rect.bottom; ++y)
+    {
+        uint32_t* row = target + (size_t)y * targetPitch;
+        std::fill(row + rect.left, row + rect.right, color);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+VirtualTexture::VirtualTexture(std::unique_ptr<TileSource> source, sVirtualTextureDesc const& desc, ThreadPool* threadPool)
+    : m_source(std::move(source))
+    , m_desc(desc)
+    , m_threadPool(threadPool)
+{
+    m_desc.tileSize         = (std::max)(1u, m_desc.tileSize);
+    m_desc.maxPendingDecode = (std::max)(1u, m_desc.maxPendingDecode);
+
+    if (m_source)
+    {
+        m_width  = m_source->GetWidth();
+        m_height = m_source->GetHeight();
+    }
+    m_tilesX         = (m_width + m_desc.tileSize - 1) / m_desc.tileSize;
+    m_tilesY         = (m_height + m_desc.tileSize - 1) / m_desc.tileSize;
+    m_tilePixelCount = (size_t)m_desc.tileSize * m_desc.tileSize;
+
+    // 快取不需要比整張圖還大
+    unsigned int const tileCount = m_tilesX * m_tilesY;
+    m_desc.cacheCapacity         = (std::max)(1u, (std::min)(m_desc.cacheCapacity, tileCount));
+
+    m_pageTable.resize(tileCount);
+    m_slots.resize(m_desc.cacheCapacity);
+    m_slotPixels.resize((size_t)m_desc.cacheCapacity * m_tilePixelCount);
+    m_completed.reserve(m_desc.maxPendingDecode);
+    m_installing.reserve(m_desc.maxPendingDecode);
+}
+
+//----------------------------------------------------------------------------------------------------
+VirtualTexture::~VirtualTexture()
+{
+    // 工作執行緒仍持有 this，等待所有解碼結束
+    std::unique_lock<std::mutex> lock(m_completedMutex);
+    m_allDecodesDone.wait(lock, [this] { return m_inFlight == 0; });
+}
+
+//----------------------------------------------------------------------------------------------------
+void VirtualTexture::BeginFrame()
+{
+    ++m_frame;
+    m_missingTiles.clear();
+}
+
+//----------------------------------------------------------------------------------------------------
+void VirtualTexture::RequestRegion(sRect const& imageRect)
+{
+    sRect const rect = imageRect.Intersect({0, 0, (int)m_width, (int)m_height});
+    if (rect.IsEmpty()) return;
+
+    int const tileSize = (int)m_desc.tileSize;
+    int const tileX0   = rect.left / tileSize;
+    int const tileY0   = rect.top / tileSize;
+    int const tileX1   = (rect.right - 1) / tileSize;
+    int const tileY1   = (rect.bottom - 1) / tileSize;
+
+    for (int tileY = tileY0; tileY <= tileY1; ++tileY)
+    {
+        for (int tileX = tileX0; tileX <= tileX1; ++tileX)
+        {
+            int const   tile  = tileY * (int)m_tilesX + tileX;
+            sPageEntry& entry = m_pageTable[tile];
+
+            // 多個窗口重疊同一區塊時只算一次
+            if (entry.lastRequestFrame == m_frame) continue;
+            entry.lastRequestFrame = m_frame;
+            ++m_stats.requests;
+
+            if (entry.slot != INVALID_SLOT)
+            {
+                ++m_stats.cacheHits;
+                TouchSlot(entry.slot);
+                continue;
+            }
+
+            ++m_stats.cacheMisses;
+            if (!entry.isPending)
+            {
+                m_missingTiles.push_back(tile);
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+unsigned int VirtualTexture::Update()
+{
+    unsigned int inFlight = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_completedMutex);
+        inFlight = m_inFlight;
+    }
+
+    // 依請求順序送出解碼；快取已被本幀用滿時解碼了也放不進去
+    for (int const tile : m_missingTiles)
+    {
+        if (inFlight >= m_desc.maxPendingDecode) break;
+        if (m_usedSlotCount == (int)m_desc.cacheCapacity && m_slots[m_lruTail].lastUseFrame == m_frame) break;
+
+        m_pageTable[tile].isPending = true;
+        ++m_stats.decodes;
+        ++inFlight;
+
+        if (m_threadPool)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_completedMutex);
+                ++m_inFlight;
+            }
+            m_threadPool->Submit([this, tile]
+            {
+                sDecodedTile decoded;
+                DecodeTile(tile, decoded);
+
+                std::lock_guard<std::mutex> lock(m_completedMutex);
+                m_completed.push_back(std::move(decoded));
+                if (--m_inFlight == 0)
+                {
+                    m_allDecodesDone.notify_all();
+                }
+            });
+        }
+        else
+        {
+            sDecodedTile decoded;
+            DecodeTile(tile, decoded);
+
+            std::lock_guard<std::mutex> lock(m_completedMutex);
+            m_completed.push_back(std::move(decoded));
+        }
+    }
+    m_missingTiles.clear();
+
+    {
+        std::lock_guard<std::mutex> lock(m_completedMutex);
+        m_installing.swap(m_completed);
+        m_stats.pendingTiles = m_inFlight;
+    }
+
+    unsigned int installed = 0;
+    for (sDecodedTile& decoded : m_installing)
+    {
+        if (InstallTile(decoded)) ++installed;
+    }
+    m_installing.clear();     // 緩衝區歸還給 m_tileBuffers
+
+    m_stats.residentTiles = (unsigned int)m_usedSlotCount;
+    return installed;
+}
+
+//----------------------------------------------------------------------------------------------------
+bool VirtualTexture::CopyRegion(sRect const&       imageRect,
+                                uint32_t*          target,
+                                unsigned int const targetPitch,
+                                uint32_t const     fallbackColor) const
+{
+    if (!target || imageRect.IsEmpty()) return true;
+
+    sRect const rect = imageRect.Intersect({0, 0, (int)m_width, (int)m_height});
+
+    // 圖片範圍以外 (最多四塊) 直接填色
+    if (rect != imageRect)
+    {
+        sRect     outside[4];
+        int const outsideCount = SubtractFromRect(imageRect, rect, outside);
+        for (int i = 0; i < outsideCount; ++i)
+        {
+            sRect const& outsideRect = outside[i];
+            sRect const  local       = {outsideRect.left - imageRect.left, outsideRect.top - imageRect.top,
+                                        outsideRect.right - imageRect.left, outsideRect.bottom - imageRect.top};
+            FillRect(target, targetPitch, local, fallbackColor);
+        }
+    }
+    if (rect.IsEmpty()) return true;
+
+    int const tileSize   = (int)m_desc.tileSize;
+    bool      isComplete = true;
+
+    for (int tileY = rect.top / tileSize; tileY <= (rect.bottom - 1) / tileSize; ++tileY)
+    {
+        for (int tileX = rect.left / tileSize; tileX <= (rect.right - 1) / tileSize; ++tileX)
+        {
+            sRect const tileRect = {tileX * tileSize, tileY * tileSize, (tileX + 1) * tileSize, (tileY + 1) * tileSize};
+            sRect const part     = tileRect.Intersect(rect);
+            sRect const local    = {part.left - imageRect.left, part.top - imageRect.top,
+                                    part.right - imageRect.left, part.bottom - imageRect.top};
+
+            uint32_t const* tilePixels = FindTile((unsigned int)tileX, (unsigned int)tileY);
+            if (!tilePixels)
+            {
+                FillRect(target, targetPitch, local, fallbackColor);
+                isComplete = false;
+                continue;
+            }
+
+            size_t const rowBytes = (size_t)part.GetWidth() * 4;
+            for (int y = part.top; y < part.bottom; ++y)
+            {
+                uint32_t const* source = tilePixels + (size_t)(y - tileRect.top) * tileSize + (part.left - tileRect.left);
+                memcpy(target + (size_t)(y - imageRect.top) * targetPitch + local.left, source, rowBytes);
+            }
+        }
+    }
+    return isComplete;
+}
+
+//----------------------------------------------------------------------------------------------------
+uint32_t const* VirtualTexture::FindTile(unsigned int const tileX, unsigned int const tileY) const
+{
+    if (tileX >= m_tilesX || tileY >= m_tilesY) return nullptr;
+
+    int const slot = m_pageTable[tileY * m_tilesX + tileX].slot;
+    if (slot == INVALID_SLOT) return nullptr;
+    return m_slotPixels.data() + (size_t)slot * m_tilePixelCount;
+}
+
+//----------------------------------------------------------------------------------------------------
+size_t VirtualTexture::GetMemoryBytes() const
+{
+    sBufferPoolStats const tileBuffers = m_tileBuffers.GetStats();
+    return m_slotPixels.capacity() * sizeof(uint32_t) +
+           m_pageTable.capacity() * sizeof(sPageEntry) +
+           m_slots.capacity() * sizeof(sSlot) +
+           tileBuffers.cachedBytes + tileBuffers.outstandingBytes;
+}
+
+//----------------------------------------------------------------------------------------------------
+sRect VirtualTexture::GetTileRect(int const tile) const
+{
+    int const tileSize = (int)m_desc.tileSize;
+    int const left     = (tile % (int)m_tilesX) * tileSize;
+    int const top      = (tile / (int)m_tilesX) * tileSize;
+    return {left, top, (std::min)(left + tileSize, (int)m_width), (std::min)(top + tileSize, (int)m_height)};
+}
+
+//----------------------------------------------------------------------------------------------------
+// 在工作執行緒執行，只讀取建構後不再改變的成員
+void VirtualTexture::DecodeTile(int const tile, sDecodedTile& result) const
+{
+    sRect const rect = GetTileRect(tile);
+
+    // 邊緣區塊只有部分有效，其餘保持為 0
+    result.tile   = tile;
+    result.pixels = m_tileBuffers.Acquire(m_tilePixelCount * 4);
+    memset(result.pixels.GetData(), 0, m_tilePixelCount * 4);
+    result.isOk = m_source->DecodeRegion((unsigned int)rect.left, (unsigned int)rect.top,
+                                         (unsigned int)rect.GetWidth(), (unsigned int)rect.GetHeight(),
+                                         result.pixels.As<uint32_t>(), m_desc.tileSize);
+}
+
+//----------------------------------------------------------------------------------------------------
+bool VirtualTexture::InstallTile(sDecodedTile& decoded)
+{
+    sPageEntry& entry = m_pageTable[decoded.tile];
+    entry.isPending   = false;
+
+    if (!decoded.isOk)
+    {
+        ++m_stats.decodeErrors;
+        return false;
+    }
+    if (entry.slot != INVALID_SLOT) return false;
+
+    int const slot = AcquireSlot();
+    if (slot == INVALID_SLOT)
+    {
+        ++m_stats.dropped;
+        return false;
+    }
+
+    memcpy(GetSlotPixels(slot), decoded.pixels.GetData(), m_tilePixelCount * 4);
+    m_slots[slot].tile = decoded.tile;
+    entry.slot         = slot;
+    LinkSlotAtHead(slot);
+    m_slots[slot].lastUseFrame = m_frame;
+    ++m_stats.installs;
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 回傳一個未連結的空槽位；全部槽位都在本幀使用中時回傳 INVALID_SLOT
+int VirtualTexture::AcquireSlot()
+{
+    if (m_usedSlotCount < (int)m_desc.cacheCapacity)
+    {
+        return m_usedSlotCount++;
+    }
+
+    int const slot = m_lruTail;
+    if (m_slots[slot].lastUseFrame == m_frame) return INVALID_SLOT;
+
+    m_pageTable[m_slots[slot].tile].slot = INVALID_SLOT;
+    m_slots[slot].tile                   = -1;
+    UnlinkSlot(slot);
+    ++m_stats.evictions;
+    return slot;
+}
+
+//----------------------------------------------------------------------------------------------------
+void VirtualTexture::TouchSlot(int const slot)
+{
+    m_slots[slot].lastUseFrame = m_frame;
+    if (m_lruHead == slot) return;
+
+    UnlinkSlot(slot);
+    LinkSlotAtHead(slot);
+}
+
+//----------------------------------------------------------------------------------------------------
+void VirtualTexture::UnlinkSlot(int const slot)
+{
+    sSlot& current = m_slots[slot];
+
+    if (current.previous != INVALID_SLOT) m_slots[current.previous].next = current.next;
+    else m_lruHead = current.next;
+
+    if (current.next != INVALID_SLOT) m_slots[current.next].previous = current.previous;
+    else m_lruTail = current.previous;
+
+    current.previous = INVALID_SLOT;
+    current.next     = INVALID_SLOT;
+}
+
+//----------------------------------------------------------------------------------------------------
+void VirtualTexture::LinkSlotAtHead(int const slot)
+{
+    sSlot& current   = m_slots[slot];
+    current.previous = INVALID_SLOT;
+    current.next     = m_lruHead;
+
+    if (m_lruHead != INVALID_SLOT) m_slots[m_lruHead].previous = slot;
+    m_lruHead = slot;
+    if (m_lruTail == INVALID_SLOT) m_lruTail = slot;
+}
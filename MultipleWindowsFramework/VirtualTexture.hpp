@@ -0,0 +1,160 @@
+﻿//----------------------------------------------------------------------------------------------------
+// VirtualTexture.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "FrameArena.hpp"
+#include "Region.hpp"
+
+//-Forward-Declaration--------------------------------------------------------------------------------
+class ThreadPool;
+
+//----------------------------------------------------------------------------------------------------
+// 可依區塊解碼的圖片來源；DecodeTile 會在背景執行緒被同時呼叫，實作需自行保證執行緒安全
+class TileSource
+{
+public:
+    virtual ~TileSource() = default;
+
+    virtual unsigned int GetWidth() const  = 0;
+    virtual unsigned int GetHeight() const = 0;
+
+    // 解碼 [x, x + width) x [y, y + height) 到 pixels (RGBA8，每列 pitch 個像素)
+    virtual bool DecodeRegion(unsigned int x, unsigned int y, unsigned int width, unsigned int height,
+                              uint32_t* pixels, unsigned int pitch) = 0;
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sVirtualTextureDesc
+{
+    unsigned int tileSize         = 256;    // 區塊邊長 (像素)
+    unsigned int cacheCapacity    = 256;    // 實體快取可容納的區塊數
+    unsigned int maxPendingDecode = 16;     // 同時在背景解碼的區塊上限
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sVirtualTextureStats
+{
+    unsigned long long requests     = 0;    // RequestRegion 觸及的區塊數 (每幀去重後)
+    unsigned long long cacheHits    = 0;
+    unsigned long long cacheMisses  = 0;
+    unsigned long long decodes      = 0;    // 送出的解碼工作
+    unsigned long long decodeErrors = 0;
+    unsigned long long installs     = 0;    // 放入實體快取的區塊
+    unsigned long long evictions    = 0;
+    unsigned long long dropped      = 0;    // 快取已被本幀用滿，解碼結果只能丟棄
+    unsigned int       residentTiles = 0;
+    unsigned int       pendingTiles  = 0;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 超大圖片的虛擬紋理：圖片切成固定大小的區塊，只解碼被請求 (窗口看得到) 的區塊
+// 常駐區塊放在固定數量的實體槽位中，由頁表 (虛擬區塊 -> 槽位) 查詢，槽位不足時淘汰最久未使用者
+//
+// 每幀的順序：BeginFrame -> RequestRegion (可多次) -> Update -> CopyRegion
+// 解碼工作交給執行緒池；threadPool 為 nullptr 時在 Update 內同步解碼，方便無視窗環境下驗證
+class VirtualTexture
+{
+public:
+    VirtualTexture(std::unique_ptr<TileSource> source, sVirtualTextureDesc const& desc, ThreadPool* threadPool = nullptr);
+    ~VirtualTexture();
+
+    VirtualTexture(VirtualTexture const&)            = delete;
+    VirtualTexture& operator=(VirtualTexture const&) = delete;
+
+    unsigned int GetWidth() const { return m_width; }
+    unsigned int GetHeight() const { return m_height; }
+    unsigned int GetTileSize() const { return m_desc.tileSize; }
+    unsigned int GetTileCountX() const { return m_tilesX; }
+    unsigned int GetTileCountY() const { return m_tilesY; }
+
+    void BeginFrame();
+    void RequestRegion(sRect const& imageRect);
+
+    // 送出缺少區塊的解碼並放入已完成的區塊，回傳本次新放入的區塊數
+    unsigned int Update();
+
+    // 將圖片中的 imageRect 複製到 target (target 原點對應 imageRect 左上角)
+    // 不在快取中或超出圖片範圍的像素填入 fallbackColor；回傳是否所有區塊都已常駐
+    bool CopyRegion(sRect const& imageRect, uint32_t* target, unsigned int targetPitch, uint32_t fallbackColor) const;
+
+    // 常駐區塊的像素 (每列 tileSize 個像素)，不在快取中時回傳 nullptr
+    uint32_t const* FindTile(unsigned int tileX, unsigned int tileY) const;
+
+    sVirtualTextureStats const& GetStats() const { return m_stats; }
+    size_t                      GetMemoryBytes() const;     // 快取槽位、頁表與解碼緩衝區
+
+private:
+    static int const INVALID_SLOT = -1;
+
+    struct sPageEntry
+    {
+        int          slot             = INVALID_SLOT;
+        unsigned int lastRequestFrame = 0;
+        bool         isPending        = false;
+    };
+
+    // 實體槽位以雙向串列維護使用順序，頭為最近使用
+    struct sSlot
+    {
+        int          tile         = -1;     // 目前存放的虛擬區塊，-1 = 空
+        unsigned int lastUseFrame = 0;
+        int          previous     = INVALID_SLOT;
+        int          next         = INVALID_SLOT;
+    };
+
+    struct sDecodedTile
+    {
+        int                tile = -1;
+        bool               isOk = false;
+        BufferPool::Buffer pixels;              // 來自 m_tileBuffers，安裝後歸還
+    };
+
+    sRect     GetTileRect(int tile) const;
+    uint32_t* GetSlotPixels(int slot) { return m_slotPixels.data() + (size_t)slot * m_tilePixelCount; }
+
+    void DecodeTile(int tile, sDecodedTile& result) const;
+    bool InstallTile(sDecodedTile& decoded);
+    int  AcquireSlot();
+    void TouchSlot(int slot);
+    void UnlinkSlot(int slot);
+    void LinkSlotAtHead(int slot);
+
+    std::unique_ptr<TileSource> m_source;
+    sVirtualTextureDesc         m_desc;
+    ThreadPool*                 m_threadPool;
+    unsigned int                m_width          = 0;
+    unsigned int                m_height         = 0;
+    unsigned int                m_tilesX         = 0;
+    unsigned int                m_tilesY         = 0;
+    size_t                      m_tilePixelCount = 0;
+    unsigned int                m_frame          = 1;    // 頁表的 lastRequestFrame 初始為 0
+
+    std::vector<sPageEntry> m_pageTable;
+    std::vector<sSlot>      m_slots;
+    std::vector<uint32_t>   m_slotPixels;
+    int                     m_lruHead       = INVALID_SLOT;
+    int                     m_lruTail       = INVALID_SLOT;
+    int                     m_usedSlotCount = 0;
+
+    std::vector<int> m_missingTiles;        // 本幀請求但未常駐的區塊 (依請求順序)
+
+    // 解碼用的區塊緩衝區，穩定後不再向系統配置；必須比 m_completed / m_installing 晚釋放
+    mutable BufferPool m_tileBuffers;
+
+    // 背景解碼的結果，由工作執行緒放入、Update 取出
+    std::mutex                m_completedMutex;
+    std::condition_variable   m_allDecodesDone;
+    std::vector<sDecodedTile> m_completed;
+    std::vector<sDecodedTile> m_installing;
+    unsigned int              m_inFlight = 0;
+
+    sVirtualTextureStats m_stats;
+};
@@ -0,0 +1,485 @@
+﻿//----------------------------------------------------------------------------------------------------
+// VirtualTextureCheckMain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// 虛擬紋理的頁表與淘汰檢查 (不屬於 Windows 專案，在 Linux 上單獨編譯)：
+//
+//   g++ -std=c++14 -O2 -pthread VirtualTextureCheckMain.cpp VirtualTexture.cpp Region.cpp FrameArena.cpp ThreadPool.cpp -o virtual_texture_check
+//   ./virtual_texture_check [frames]
+//
+// 以假的 TileSource (像素值由座標決定，可指定解碼失敗的區塊) 驅動 VirtualTexture：
+//   - 固定情況：LRU 的淘汰順序、CopyRegion 的內容與圖片外的填色、解碼失敗的區塊下一幀重試
+//   - 同步解碼的隨機負載：每幀的常駐集合 (頁表) 與淘汰、丟棄數都和參考的 LRU 模型相同
+//   - 執行緒池的隨機負載：本幀請求且已常駐的區塊在 Update 後仍常駐，常駐區塊的內容正確，停止移動後全部常駐
+// 結束碼：0 = 全部通過，1 = 失敗
+//----------------------------------------------------------------------------------------------------
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "CheckMain.hpp"
+#include "ThreadPool.hpp"
+#include "VirtualTexture.hpp"
+
+//----------------------------------------------------------------------------------------------------
+static uint32_t GetSourcePixel(unsigned int const x, unsigned int const y)
+{
+    return (y << 16) ^ x ^ 0x80000000u;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 像素值由座標決定；FailAt 指定左上角為 (x, y) 的區塊，接下來 count 次解碼失敗
+class FakeTileSource : public TileSource
+{
+public:
+    FakeTileSource(unsigned int const width, unsigned int const height) : m_width(width), m_height(height) {}
+
+    unsigned int GetWidth() const override { return m_width; }
+    unsigned int GetHeight() const override { return m_height; }
+
+    bool DecodeRegion(unsigned int const x, unsigned int const y, unsigned int const width, unsigned int const height,
+                      uint32_t* pixels, unsigned int const pitch) override
+    {
+        ++m_decodes;
+        if (x + width > m_width || y + height > m_height) m_isOutOfBounds = true;
+        if (x == m_failX && y == m_failY && m_failCount > 0)
+        {
+            --m_failCount;
+            return false;
+        }
+
+        for (unsigned int row = 0; row < height; ++row)
+        {
+            for (unsigned int column = 0; column < width; ++column)
+            {
+                pixels[(size_t)row * pitch + column] = GetSourcePixel(x + column, y + row);
+            }
+        }
+        return true;
+    }
+
+    void FailAt(unsigned int const x, unsigned int const y, int const count)
+    {
+        m_failX     = x;
+        m_failY     = y;
+        m_failCount = count;
+    }
+
+    int  GetDecodes() const { return m_decodes; }
+    bool IsOutOfBounds() const { return m_isOutOfBounds; }
+
+private:
+    unsigned int      m_width;
+    unsigned int      m_height;
+    unsigned int      m_failX         = ~0u;
+    unsigned int      m_failY         = ~0u;
+    std::atomic<int>  m_failCount{0};
+    std::atomic<int>  m_decodes{0};
+    std::atomic<bool> m_isOutOfBounds{false};
+};
+
+//----------------------------------------------------------------------------------------------------
+// 常駐區塊的內容 (含邊緣區塊的有效部分) 與來源相同
+static bool IsTileContentValid(VirtualTexture const& texture, unsigned int const tileX, unsigned int const tileY)
+{
+    uint32_t const* pixels = texture.FindTile(tileX, tileY);
+    if (!pixels) return true;
+
+    unsigned int const tileSize = texture.GetTileSize();
+    unsigned int const left     = tileX * tileSize;
+    unsigned int const top      = tileY * tileSize;
+    for (unsigned int y = 0; y < tileSize && top + y < texture.GetHeight(); ++y)
+    {
+        for (unsigned int x = 0; x < tileSize && left + x < texture.GetWidth(); ++x)
+        {
+            if (pixels[(size_t)y * tileSize + x] != GetSourcePixel(left + x, top + y)) return false;
+        }
+    }
+    return true;
+}
+
+static std::set<int> GetResidentTiles(VirtualTexture const& texture)
+{
+    std::set<int> resident;
+    for (unsigned int tileY = 0; tileY < texture.GetTileCountY(); ++tileY)
+    {
+        for (unsigned int tileX = 0; tileX < texture.GetTileCountX(); ++tileX)
+        {
+            if (texture.FindTile(tileX, tileY)) resident.insert((int)(tileY * texture.GetTileCountX() + tileX));
+        }
+    }
+    return resident;
+}
+
+// 單一區塊的請求
+static sRect GetTileRect(VirtualTexture const& texture, int const tile)
+{
+    int const tileSize = (int)texture.GetTileSize();
+    int const left     = tile % (int)texture.GetTileCountX() * tileSize;
+    int const top      = tile / (int)texture.GetTileCountX() * tileSize;
+    return {left, top, left + tileSize, top + tileSize};
+}
+
+//----------------------------------------------------------------------------------------------------
+// 一列 8 個區塊、容量 4：最久未使用的先被淘汰，請求會更新使用順序
+static bool CheckLruOrder()
+{
+    sVirtualTextureDesc desc;
+    desc.tileSize      = 16;
+    desc.cacheCapacity = 4;
+
+    VirtualTexture texture(std::unique_ptr<TileSource>(new FakeTileSource(128, 16)), desc);
+
+    auto requestFrame = [&texture](std::vector<int> const& tiles)
+    {
+        texture.BeginFrame();
+        for (int const tile : tiles)
+        {
+            texture.RequestRegion(GetTileRect(texture, tile));
+        }
+        texture.Update();
+        return GetResidentTiles(texture);
+    };
+
+    // 依序安裝 0..3；之後使用 1、2，最久未使用的順序為 0、3、1、2
+    bool isOrdered = requestFrame({0, 1, 2, 3}) == std::set<int>{0, 1, 2, 3};
+    requestFrame({1});
+    requestFrame({2});
+    isOrdered &= requestFrame({4}) == std::set<int>{1, 2, 3, 4};
+    isOrdered &= requestFrame({5}) == std::set<int>{1, 2, 4, 5};
+    isOrdered &= requestFrame({6}) == std::set<int>{2, 4, 5, 6};
+    isOrdered &= requestFrame({7}) == std::set<int>{4, 5, 6, 7};
+
+    // 同一幀命中的區塊不會被同一幀的新區塊淘汰：5 個請求中只能放入 4 個，最後一個丟棄
+    std::set<int> const full        = requestFrame({4, 5, 6, 0, 1});
+    bool const          isProtected = full == std::set<int>{4, 5, 6, 0} && texture.GetStats().evictions == 5 && texture.GetStats().dropped == 1;
+
+    printf("lru_evictions %llu\n", texture.GetStats().evictions);
+
+    bool isPassing = true;
+    isPassing &= Check(isOrdered, "lru_eviction_order");
+    isPassing &= Check(isProtected, "lru_requested_not_evicted");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 頁表與內容：請求的區塊常駐且內容正確，圖片外填色，不常駐的區塊填色並回報不完整；解碼失敗的區塊下一幀重試
+static bool CheckResidency()
+{
+    sVirtualTextureDesc desc;
+    desc.tileSize         = 64;
+    desc.cacheCapacity    = 20;
+    desc.maxPendingDecode = 100;
+
+    FakeTileSource* source = new FakeTileSource(1000, 700);
+    source->FailAt(64, 0, 1);
+    VirtualTexture texture(std::unique_ptr<TileSource>(source), desc);
+
+    texture.BeginFrame();
+    texture.RequestRegion({-10, -10, 100, 100});
+    unsigned int const firstInstalls = texture.Update();
+
+    // (1, 0) 失敗一次，其餘三塊常駐
+    bool const isFirstFrame = firstInstalls == 3 && texture.FindTile(0, 0) && !texture.FindTile(1, 0) &&
+                              texture.FindTile(0, 1) && texture.FindTile(1, 1) && !texture.FindTile(2, 0) &&
+                              texture.GetStats().decodeErrors == 1 && texture.GetStats().residentTiles == 3;
+
+    std::vector<uint32_t> copy((size_t)110 * 110);
+    bool const            isIncomplete = !texture.CopyRegion({-10, -10, 100, 100}, copy.data(), 110, 0xDEADBEEF);
+
+    texture.BeginFrame();
+    texture.RequestRegion({-10, -10, 100, 100});
+    unsigned int const retryInstalls = texture.Update();
+    bool const         isComplete    = texture.CopyRegion({-10, -10, 100, 100}, copy.data(), 110, 0xDEADBEEF);
+
+    bool isCopied = true;
+    for (int y = 0; y < 110; ++y)
+    {
+        for (int x = 0; x < 110; ++x)
+        {
+            int const      imageX   = x - 10;
+            int const      imageY   = y - 10;
+            uint32_t const expected = imageX < 0 || imageY < 0 ? 0xDEADBEEF : GetSourcePixel(imageX, imageY);
+            isCopied &= copy[(size_t)y * 110 + x] == expected;
+        }
+    }
+
+    // 命中時不再解碼；重疊的請求在同一幀只算一次
+    int const                decodes = source->GetDecodes();
+    unsigned long long const hits    = texture.GetStats().cacheHits;
+    texture.BeginFrame();
+    texture.RequestRegion({0, 0, 100, 100});
+    texture.RequestRegion({0, 0, 100, 100});
+    bool const isHit = texture.Update() == 0 && source->GetDecodes() == decodes && texture.GetStats().cacheHits == hits + 4;
+
+    // 邊緣區塊只解碼圖片內的部分
+    texture.BeginFrame();
+    texture.RequestRegion({990, 690, 1000, 700});
+    texture.Update();
+    bool const isEdgeValid = texture.FindTile(15, 10) && IsTileContentValid(texture, 15, 10) && !source->IsOutOfBounds();
+
+    bool isPassing = true;
+    isPassing &= Check(isFirstFrame && isIncomplete, "residency_first_frame");
+    isPassing &= Check(retryInstalls == 1 && isComplete && isCopied, "residency_retry_and_copy");
+    isPassing &= Check(isHit, "residency_cache_hits");
+    isPassing &= Check(isEdgeValid, "residency_edge_tile");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 同步解碼時的參考模型：與 VirtualTexture 相同的請求順序、解碼上限與 LRU 淘汰規則，只用 std::list 實作
+class ReferenceCache
+{
+public:
+    ReferenceCache(unsigned int const capacity, unsigned int const maxPendingDecode, size_t const tileCount)
+        : m_capacity(capacity), m_maxPendingDecode(maxPendingDecode), m_lastUse(tileCount, 0), m_lastRequest(tileCount, 0) {}
+
+    void BeginFrame()
+    {
+        ++m_frame;
+        m_missing.clear();
+    }
+
+    void Request(int const tile)
+    {
+        if (m_lastRequest[tile] == m_frame) return;
+        m_lastRequest[tile] = m_frame;
+
+        auto const found = std::find(m_lru.begin(), m_lru.end(), tile);
+        if (found != m_lru.end())
+        {
+            m_lru.splice(m_lru.begin(), m_lru, found);
+            m_lastUse[tile] = m_frame;
+        }
+        else
+        {
+            m_missing.push_back(tile);
+        }
+    }
+
+    void Update(int const failingTile)
+    {
+        std::vector<int> decoded;
+        for (int const tile : m_missing)
+        {
+            if (decoded.size() >= m_maxPendingDecode) break;
+            if (m_lru.size() == m_capacity && m_lastUse[m_lru.back()] == m_frame) break;
+            decoded.push_back(tile);
+        }
+
+        for (int const tile : decoded)
+        {
+            if (tile == failingTile) continue;
+            if (m_lru.size() == m_capacity)
+            {
+                if (m_lastUse[m_lru.back()] == m_frame)
+                {
+                    ++dropped;
+                    continue;
+                }
+                m_lru.pop_back();
+                ++evictions;
+            }
+            m_lru.push_front(tile);
+            m_lastUse[tile] = m_frame;
+        }
+    }
+
+    std::set<int> GetResident() const { return std::set<int>(m_lru.begin(), m_lru.end()); }
+
+    unsigned long long evictions = 0;
+    unsigned long long dropped   = 0;
+
+private:
+    size_t                    m_capacity;
+    size_t                    m_maxPendingDecode;
+    unsigned int              m_frame = 1;
+    std::list<int>            m_lru;                // 頭為最近使用
+    std::vector<unsigned int> m_lastUse;
+    std::vector<unsigned int> m_lastRequest;
+    std::vector<int>          m_missing;
+};
+
+//----------------------------------------------------------------------------------------------------
+// 隨機的多個請求矩形 (部分超出圖片)：每幀的常駐集合與參考模型相同，本幀請求且已常駐的區塊不被淘汰
+static bool CheckAgainstModel(unsigned int const frames)
+{
+    sVirtualTextureDesc desc;
+    desc.tileSize         = 8;
+    desc.cacheCapacity    = 12;
+    desc.maxPendingDecode = 5;
+
+    // 10x8 個區塊，最右與最下一排只有部分有效；(3, 2) 的區塊永遠解碼失敗
+    FakeTileSource* source = new FakeTileSource(76, 60);
+    source->FailAt(24, 16, 1 << 30);
+    VirtualTexture texture(std::unique_ptr<TileSource>(source), desc);
+    ReferenceCache reference(desc.cacheCapacity, desc.maxPendingDecode, (size_t)texture.GetTileCountX() * texture.GetTileCountY());
+    int const      failingTile = 2 * (int)texture.GetTileCountX() + 3;
+
+    uint32_t seed            = 0x9E3779B9u;
+    bool     isMatched       = true;
+    bool     isProtected     = true;
+    bool     isContentValid  = true;
+    bool     isWithinLimits  = true;
+    for (unsigned int frame = 0; frame < frames && isMatched; ++frame)
+    {
+        texture.BeginFrame();
+        reference.BeginFrame();
+
+        std::set<int>      requested;
+        unsigned int const rectCount = 1 + NextRandom(seed) % 3;
+        for (unsigned int i = 0; i < rectCount; ++i)
+        {
+            int const   left = (int)(NextRandom(seed) % 90) - 8;
+            int const   top  = (int)(NextRandom(seed) % 70) - 8;
+            sRect const rect = {left, top, left + 1 + (int)(NextRandom(seed) % 24), top + 1 + (int)(NextRandom(seed) % 24)};
+            texture.RequestRegion(rect);
+
+            // 與 RequestRegion 相同的順序：先裁切到圖片內，再逐列逐區塊
+            sRect const clipped = rect.Intersect({0, 0, (int)texture.GetWidth(), (int)texture.GetHeight()});
+            if (clipped.IsEmpty()) continue;
+            for (int tileY = clipped.top / 8; tileY <= (clipped.bottom - 1) / 8; ++tileY)
+            {
+                for (int tileX = clipped.left / 8; tileX <= (clipped.right - 1) / 8; ++tileX)
+                {
+                    int const tile = tileY * (int)texture.GetTileCountX() + tileX;
+                    reference.Request(tile);
+                    requested.insert(tile);
+                }
+            }
+        }
+
+        std::set<int> const before = GetResidentTiles(texture);
+        texture.Update();
+        reference.Update(failingTile);
+        std::set<int> const after = GetResidentTiles(texture);
+
+        isMatched &= after == reference.GetResident();
+        isWithinLimits &= after.size() <= desc.cacheCapacity && after.count(failingTile) == 0;
+        for (int const tile : before)
+        {
+            isProtected &= !requested.count(tile) || after.count(tile);
+        }
+        for (int const tile : after)
+        {
+            isContentValid &= IsTileContentValid(texture, tile % texture.GetTileCountX(), tile / texture.GetTileCountX());
+        }
+    }
+
+    sVirtualTextureStats const& stats = texture.GetStats();
+    bool const isCounted = stats.evictions == reference.evictions && stats.dropped == reference.dropped &&
+                           stats.requests == stats.cacheHits + stats.cacheMisses &&
+                           stats.installs - stats.evictions == stats.residentTiles;
+
+    printf("model_frames %u\n", frames);
+    printf("model_installs %llu\n", stats.installs);
+    printf("model_evictions %llu\n", stats.evictions);
+    printf("model_dropped %llu\n", stats.dropped);
+    printf("model_decode_errors %llu\n", stats.decodeErrors);
+
+    bool isPassing = true;
+    isPassing &= Check(isMatched, "model_resident_tiles");
+    isPassing &= Check(isProtected, "model_requested_not_evicted");
+    isPassing &= Check(isWithinLimits, "model_capacity");
+    isPassing &= Check(isContentValid, "model_tile_content");
+    isPassing &= Check(isCounted, "model_stats");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 背景解碼：窗口在大圖上移動，每幀檢查保護規則與內容；停止移動後所有區塊在有限幀內常駐
+static bool CheckThreadPool(unsigned int const frames)
+{
+    ThreadPool threadPool(3);
+
+    sVirtualTextureDesc desc;
+    desc.tileSize         = 128;
+    desc.cacheCapacity    = 64;
+    desc.maxPendingDecode = 8;
+
+    FakeTileSource* source = new FakeTileSource(5000, 5000);
+    VirtualTexture  texture(std::unique_ptr<TileSource>(source), desc, &threadPool);
+
+    bool                  isProtected = true;
+    bool                  isCopied    = true;
+    std::vector<uint32_t> copy((size_t)600 * 400);
+    sRect                 window;
+    for (unsigned int frame = 0; frame < frames; ++frame)
+    {
+        int const offset = (int)(frame * 37) % 4000;
+        window           = {offset, offset / 2, offset + 600, offset / 2 + 400};
+
+        texture.BeginFrame();
+        texture.RequestRegion(window);
+
+        std::vector<std::pair<unsigned int, unsigned int>> requestedResident;
+        for (int tileY = window.top / 128; tileY <= (window.bottom - 1) / 128; ++tileY)
+        {
+            for (int tileX = window.left / 128; tileX <= (window.right - 1) / 128; ++tileX)
+            {
+                if (texture.FindTile(tileX, tileY)) requestedResident.emplace_back(tileX, tileY);
+            }
+        }
+
+        texture.Update();
+        for (auto const& tile : requestedResident)
+        {
+            isProtected &= texture.FindTile(tile.first, tile.second) != nullptr;
+        }
+
+        texture.CopyRegion(window, copy.data(), 600, 7);
+        for (int y = 0; y < 400; y += 13)
+        {
+            for (int x = 0; x < 600; x += 7)
+            {
+                uint32_t const value = copy[(size_t)y * 600 + x];
+                isCopied &= value == 7 || value == GetSourcePixel(window.left + x, window.top + y);
+            }
+        }
+    }
+
+    // 停在最後的位置：最多 6x5 個區塊，少於容量，必須全部常駐
+    bool isComplete = false;
+    for (int frame = 0; frame < 2000 && !isComplete; ++frame)
+    {
+        texture.BeginFrame();
+        texture.RequestRegion(window);
+        texture.Update();
+        isComplete = texture.CopyRegion(window, copy.data(), 600, 7);
+        if (!isComplete) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    sVirtualTextureStats const& stats = texture.GetStats();
+    printf("pool_requests %llu\n", stats.requests);
+    printf("pool_cache_hits %llu\n", stats.cacheHits);
+    printf("pool_decodes %llu\n", stats.decodes);
+    printf("pool_evictions %llu\n", stats.evictions);
+    printf("pool_dropped %llu\n", stats.dropped);
+
+    bool isPassing = true;
+    isPassing &= Check(isProtected, "pool_requested_not_evicted");
+    isPassing &= Check(isCopied, "pool_copy_content");
+    isPassing &= Check(isComplete, "pool_converges");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+int main(int const argc, char** argv)
+{
+    unsigned int const frames = argc > 1 ? (unsigned int)strtoul(argv[1], nullptr, 0) : 5000u;
+
+    bool isPassing = true;
+    isPassing &= CheckLruOrder();
+    isPassing &= CheckResidency();
+    isPassing &= CheckAgainstModel(frames);
+    isPassing &= CheckThreadPool(400);
+    return isPassing ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+﻿//----------------------------------------------------------------------------------------------------
+// WicTileSource.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "WicTileSource.hpp"
+
+#include <wincodec.h>
+
+//----------------------------------------------------------------------------------------------------
+WicTileSource::~WicTileSource()
+{
+    Release();
+}
+
+//----------------------------------------------------------------------------------------------------
+HRESULT WicTileSource::Open(IWICImagingFactory* factory, wchar_t const* filename)
+{
+    Release();
+    if (!factory || !filename) return E_INVALIDARG;
+
+    HRESULT hr = factory->CreateDecoderFromFilename(
+        filename, nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand, &m_decoder);
+    if (FAILED(hr)) return hr;
+
+    hr = m_decoder->GetFrame(0, &m_frame);
+    if (FAILED(hr))
+    {
+        Release();
+        return hr;
+    }
+
+    hr = factory->CreateFormatConverter(&m_converter);
+    if (FAILED(hr))
+    {
+        Release();
+        return hr;
+    }
+
+    // 與 Renderer::LoadImageFromFile 相同的像素格式 (RGBA8，R 在最低位元組)
+    hr = m_converter->Initialize(m_frame, GUID_WICPixelFormat32bppRGBA,
+                                 WICBitmapDitherTypeNone, nullptr, 0.0,
+                                 WICBitmapPaletteTypeCustom);
+    if (FAILED(hr))
+    {
+        Release();
+        return hr;
+    }
+
+    return m_converter->GetSize(&m_width, &m_height);
+}
+
+//----------------------------------------------------------------------------------------------------
+bool WicTileSource::DecodeRegion(unsigned int const x,
+                                 unsigned int const y,
+                                 unsigned int const width,
+                                 unsigned int const height,
+                                 uint32_t*          pixels,
+                                 unsigned int const pitch)
+{
+    if (!m_converter || !pixels || width == 0 || height == 0) return false;
+    if (x + width > m_width || y + height > m_height || width > pitch) return false;
+
+    WICRect const rect   = {(INT)x, (INT)y, (INT)width, (INT)height};
+    UINT const    stride = pitch * 4;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return SUCCEEDED(m_converter->CopyPixels(&rect, stride, stride * height, reinterpret_cast<BYTE*>(pixels)));
+}
+
+//----------------------------------------------------------------------------------------------------
+void WicTileSource::Release()
+{
+    if (m_converter)
+    {
+        m_converter->Release();
+        m_converter = nullptr;
+    }
+    if (m_frame)
+    {
+        m_frame->Release();
+        m_frame = nullptr;
+    }
+    if (m_decoder)
+    {
+        m_decoder->Release();
+        m_decoder = nullptr;
+    }
+    m_width  = 0;
+    m_height = 0;
+}
@@ -0,0 +1,47 @@
+﻿//----------------------------------------------------------------------------------------------------
+// WicTileSource.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <mutex>
+#include <windows.h>
+
+#include "VirtualTexture.hpp"
+
+//-Forward-Declaration--------------------------------------------------------------------------------
+struct IWICImagingFactory;
+struct IWICBitmapDecoder;
+struct IWICBitmapFrameDecode;
+struct IWICFormatConverter;
+
+//----------------------------------------------------------------------------------------------------
+// 以 WIC 逐區塊解碼圖片檔：CopyPixels 只要求區塊範圍，不會把整張圖展開到記憶體
+// WIC 解碼器物件不保證可同時被多個執行緒使用，DecodeRegion 以互斥鎖序列化
+class WicTileSource : public TileSource
+{
+public:
+    WicTileSource() = default;
+    ~WicTileSource() override;
+
+    WicTileSource(WicTileSource const&)            = delete;
+    WicTileSource& operator=(WicTileSource const&) = delete;
+
+    HRESULT Open(IWICImagingFactory* factory, wchar_t const* filename);
+
+    unsigned int GetWidth() const override { return m_width; }
+    unsigned int GetHeight() const override { return m_height; }
+
+    bool DecodeRegion(unsigned int x, unsigned int y, unsigned int width, unsigned int height,
+                      uint32_t* pixels, unsigned int pitch) override;
+
+private:
+    void Release();
+
+    IWICBitmapDecoder*     m_decoder   = nullptr;
+    IWICBitmapFrameDecode* m_frame     = nullptr;
+    IWICFormatConverter*   m_converter = nullptr;
+    UINT                   m_width     = 0;
+    UINT                   m_height    = 0;
+    std::mutex             m_mutex;
+};
@@ -1,18 +1,22 @@
 ﻿#include <windows.h>
 #include "Window.hpp"
 
+#include <chrono>
+
 #include "GameCommon.hpp"
+#include "Renderer.hpp"
 
 Window::Window()
 {
-    // 初始化隨機數生成器
-    rng.seed(std::chrono::steady_clock::now().time_since_epoch().count());
-    lastUpdateTime = std::chrono::steady_clock::now();
+    // 初始化隨機數生成器與隨機初始速度；決定性模式下由 Renderer::AddWindow 以固定種子重設
+    SeedDriftBody(body, (uint32_t)std::chrono::steady_clock::now().time_since_epoch().count());
+}
 
-    // 隨機初始速度
-    std::uniform_real_distribution<float> velDist(-50.0f, 50.0f);
-    drift.velocityX = velDist(rng);
-    drift.velocityY = velDist(rng);
+// 目前訊息發生時的滑鼠螢幕座標 (多螢幕時可能為負)
+static POINT GetMessageScreenPosition()
+{
+    POINTS const position = MAKEPOINTS(GetMessagePos());
+    return POINT{position.x, position.y};
 }
 
 // 窗口程序
@@ -39,6 +43,35 @@ LRESULT CALLBACK WindowsMessageHandlingProcedure(HWND const   hwnd,
             // 在下一次渲染時會自動檢測位置變化
         }
         break;
+    // 拖拽：按下時捕捉滑鼠，之後的移動即使離開窗口也會送到這裡
+    // 只把事件送進渲染器的佇列，合併與移動窗口都在下一幀由渲染執行緒處理
+    case WM_LBUTTONDOWN:
+        if (g_renderer)
+        {
+            SetCapture(hwnd);
+            g_renderer->PostStartDragging(hwnd, GetMessageScreenPosition());
+        }
+        return 0;
+    case WM_MOUSEMOVE:
+        if (g_renderer && GetCapture() == hwnd)
+        {
+            g_renderer->PostUpdateDragging(hwnd, GetMessageScreenPosition());
+        }
+        return 0;
+    case WM_LBUTTONUP:
+        // 放開由 ReleaseCapture 觸發的 WM_CAPTURECHANGED 送出
+        if (GetCapture() == hwnd)
+        {
+            ReleaseCapture();
+        }
+        return 0;
+    case WM_CAPTURECHANGED:
+        // 放開按鍵或捕捉被其他窗口搶走 (例如 Alt+Tab) 都結束拖拽
+        if (g_renderer)
+        {
+            g_renderer->PostStopDragging(hwnd);
+        }
+        return 0;
     case WM_DESTROY:
         PostQuitMessage(0);
         return 0;
@@ -4,22 +4,12 @@
 
 //----------------------------------------------------------------------------------------------------
 #pragma once
-#include <chrono>
-#include <random>
+#include <unordered_map>
+#include <vector>
 
-//----------------------------------------------------------------------------------------------------
-struct sDriftParams
-{
-    float velocityX      = 0;               // X方向速度 (像素/秒)
-    float velocityY      = 0;               // Y方向速度 (像素/秒)
-    float acceleration   = 50.f;            // 加速度係數
-    float drag           = 0.98f;           // 阻力係數 (0.95-0.99)
-    float bounceEnergy   = 0.8f;            // 反彈能量保留係數 (0.7-0.9)
-    float wanderStrength = 2000.f;          // 隨機漂移強度
-    float targetVelocity = 100.f;           // 目標速度
-    bool  enableGravity  = true;            // 是否啟用重力
-    bool  enableWander   = true;            // 是否啟用隨機漂移
-};
+#include "DriftSimulation.hpp"
+#include "Region.hpp"
+#include "UpdateScheduler.hpp"
 
 //----------------------------------------------------------------------------------------------------
 class Window
@@ -39,13 +29,37 @@ public:
     RECT  lastRect{};
     bool  needsUpdate = true;
 
-    // 漂移相關
-    sDriftParams                          drift;
-    std::mt19937                          rng;
-    std::uniform_real_distribution<float> wanderDist{-1.f, 1.f};
-    std::chrono::steady_clock::time_point lastUpdateTime;
-    bool                                  isDragging = false;          // 是否正在被拖拽
-    POINT                                 dragOffset{};         // 拖拽偏移
+    // 可見性相關 (螢幕座標)
+    sRect  clientScreenRect;                // 客戶區在螢幕上的位置
+    Region visibleRegion;                   // 未被其他窗口遮擋的部分
+
+    // 更新頻率排程
+    sUpdateState updateState;
+
+    // 漂移相關 (速度、亂數與模擬中的位置)；x/y 為最後一次設定到系統的位置
+    sDriftBody body;
+    sDriftDrag drag;
 };
 
+// 四條快取線；MSVC 的 Debug 組建 (vector 多一個指標) 時剛好等於預算
+size_t const WINDOW_SIZE_BUDGET = 256;
+static_assert(sizeof(Window) <= WINDOW_SIZE_BUDGET, "Window must stay within four cache lines");
+
+// 記憶體報告的窗口類別：清單本身、可見區域、HWND 查詢表 (每個節點估計為鍵值加兩個指標)、排程用的指標與遮擋的暫存
+inline size_t GetWindowMemoryBytes(std::vector<Window> const& windows, std::unordered_map<HWND, unsigned int> const& windowIndices,
+                                   std::vector<sUpdateState*> const& updateStates, std::vector<sRect> const& occluders,
+                                   std::vector<size_t> const& occludersAbove)
+{
+    size_t bytes = windows.capacity() * sizeof(Window);
+    for (Window const& window : windows)
+    {
+        bytes += window.visibleRegion.GetMemoryBytes();
+    }
+    bytes += windowIndices.bucket_count() * sizeof(void*) +
+             windowIndices.size() * (sizeof(std::pair<HWND const, unsigned int>) + 2 * sizeof(void*));
+    bytes += updateStates.capacity() * sizeof(sUpdateState*);
+    bytes += occluders.capacity() * sizeof(sRect) + occludersAbove.capacity() * sizeof(size_t);
+    return bytes;
+}
+
 LRESULT CALLBACK WindowsMessageHandlingProcedure(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
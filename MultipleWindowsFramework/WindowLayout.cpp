@@ -0,0 +1,64 @@
+﻿//----------------------------------------------------------------------------------------------------
+// WindowLayout.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#include "WindowLayout.hpp"
+
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------
+void ComputeWindowLayout(sWindowLayoutDesc const& desc, std::vector<sWindowPlacement>& placements)
+{
+    int const count = (std::max)(0, desc.windowCount);
+    placements.clear();
+    placements.reserve(count);
+
+    int const spacingX = (std::max)(1, desc.spacingX);
+    int const spacingY = (std::max)(1, desc.spacingY);
+
+    // 一列幾個：指定值優先，否則依可用寬度；至少 1 個
+    int columns = desc.columns;
+    if (columns <= 0)
+    {
+        columns = desc.boundsWidth > 0 ? (desc.boundsWidth - desc.startX - desc.width) / spacingX + 1 : count;
+    }
+    columns = (std::max)(1, columns);
+
+    // 一頁幾列：沒有高度限制時全部放在同一頁
+    int rows = count;
+    if (desc.boundsHeight > 0)
+    {
+        rows = (desc.boundsHeight - desc.startY - desc.height) / spacingY + 1;
+    }
+    rows = (std::max)(1, rows);
+
+    // 錯開的範圍：不超過間距，有邊界時也不超出邊界
+    int offsetRangeX = spacingX;
+    int offsetRangeY = spacingY;
+    if (desc.boundsWidth > 0)
+    {
+        offsetRangeX = (std::min)(offsetRangeX, desc.boundsWidth - desc.startX - (columns - 1) * spacingX - desc.width + 1);
+    }
+    if (desc.boundsHeight > 0)
+    {
+        offsetRangeY = (std::min)(offsetRangeY, desc.boundsHeight - desc.startY - (rows - 1) * spacingY - desc.height + 1);
+    }
+    offsetRangeX = (std::max)(1, offsetRangeX);
+    offsetRangeY = (std::max)(1, offsetRangeY);
+
+    int const perPage = columns * rows;
+    for (int i = 0; i < count; ++i)
+    {
+        int const page   = i / perPage;
+        int const slot   = i % perPage;
+        int const offset = page * desc.pageOffset;
+
+        sWindowPlacement placement;
+        placement.x      = desc.startX + (slot % columns) * spacingX + offset % offsetRangeX;
+        placement.y      = desc.startY + (slot / columns) * spacingY + offset % offsetRangeY;
+        placement.width  = desc.width;
+        placement.height = desc.height;
+        placements.push_back(placement);
+    }
+}
@@ -0,0 +1,36 @@
+﻿//----------------------------------------------------------------------------------------------------
+// WindowLayout.hpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+#pragma once
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------
+// 格狀排列：每列 columns 個，放不下時從下一頁重新開始並錯開 pageOffset，窗口數量很多時也不會跑出螢幕
+struct sWindowLayoutDesc
+{
+    int windowCount  = 10;
+    int width        = 400;
+    int height       = 300;
+    int startX       = 100;
+    int startY       = 100;
+    int spacingX     = 450;                 // 相鄰窗口左上角的距離
+    int spacingY     = 350;
+    int columns      = 5;                   // 0 = 依 boundsWidth 放得下的數量
+    int boundsWidth  = 0;                   // 0 = 不限制 (只排成一頁)
+    int boundsHeight = 0;
+    int pageOffset   = 24;                  // 每一頁往右下錯開的像素
+};
+
+//----------------------------------------------------------------------------------------------------
+struct sWindowPlacement
+{
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+//----------------------------------------------------------------------------------------------------
+void ComputeWindowLayout(sWindowLayoutDesc const& desc, std::vector<sWindowPlacement>& placements);
@@ -0,0 +1,241 @@
+﻿//----------------------------------------------------------------------------------------------------
+// WindowLayoutCheckMain.cpp
+//----------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------
+// 啟動流程中不需要 Windows 的部分：窗口排列與階段計時 (不屬於 Windows 專案，在 Linux 上單獨編譯)：
+//
+//   g++ -std=c++14 -O2 WindowLayoutCheckMain.cpp WindowLayout.cpp PhaseTimer.cpp -o window_layout_check
+//   ./window_layout_check [隨機排列的次數]
+//
+// ComputeWindowLayout：預設值 (有無螢幕邊界) 與原本寫死的 5 欄排列相同；隨機的尺寸、間距與邊界下，
+// 自動欄數的排列不超出邊界、同一頁不重疊位置、下一頁錯開 pageOffset；0 個或負數個窗口、放不下的邊界不會出錯
+// PhaseTimer：階段依序記錄、Mark 的時間相加等於總時間、AddPhase 不影響總時間、報告的格式、Start 重設
+// 最後量測 100000 個窗口的排列時間
+// 結束碼：0 = 全部通過，1 = 失敗
+//----------------------------------------------------------------------------------------------------
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "CheckMain.hpp"
+#include "PhaseTimer.hpp"
+#include "WindowLayout.hpp"
+
+//----------------------------------------------------------------------------------------------------
+// 原本 CreateAndRegisterMultipleWindows 寫死的排列：每列 5 個，400x300，間距 450x350
+static bool IsOriginalLayout(std::vector<sWindowPlacement> const& placements, int const count)
+{
+    if ((int)placements.size() != count) return false;
+
+    for (int i = 0; i < count; ++i)
+    {
+        sWindowPlacement const& placement = placements[i];
+        if (placement.x != 100 + (i % 5) * 450 || placement.y != 100 + (i / 5) * 350) return false;
+        if (placement.width != 400 || placement.height != 300) return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------
+static bool CheckLayout(unsigned int const iterations)
+{
+    std::vector<sWindowPlacement> placements;
+
+    // 預設值；加上 1920x1080 的邊界 (GameCommon 傳入螢幕大小) 時 10 個窗口仍在同一頁
+    sWindowLayoutDesc desc;
+    ComputeWindowLayout(desc, placements);
+    bool isOriginal = IsOriginalLayout(placements, 10);
+
+    desc.boundsWidth  = 1920;
+    desc.boundsHeight = 1080;
+    ComputeWindowLayout(desc, placements);
+    isOriginal &= IsOriginalLayout(placements, 10);
+
+    // 隨機的尺寸與邊界，邊界至少放得下一個窗口
+    uint32_t seed          = 0x1234567u;
+    bool     isInBounds    = true;
+    bool     isPageUnique  = true;
+    bool     isPageShifted = true;
+    for (unsigned int iteration = 0; iteration < iterations; ++iteration)
+    {
+        sWindowLayoutDesc random;
+        random.windowCount  = (int)(NextRandom(seed) % 2000);
+        random.width        = 16 + (int)(NextRandom(seed) % 400);
+        random.height       = 16 + (int)(NextRandom(seed) % 300);
+        random.startX       = (int)(NextRandom(seed) % 200);
+        random.startY       = (int)(NextRandom(seed) % 200);
+        random.spacingX     = random.width + (int)(NextRandom(seed) % 50);
+        random.spacingY     = random.height + (int)(NextRandom(seed) % 50);
+        random.columns      = 0;
+        random.boundsWidth  = random.startX + random.width + (int)(NextRandom(seed) % 3000);
+        random.boundsHeight = random.startY + random.height + (int)(NextRandom(seed) % 2000);
+        random.pageOffset   = (int)(NextRandom(seed) % 64);
+        ComputeWindowLayout(random, placements);
+
+        isInBounds &= (int)placements.size() == random.windowCount;
+
+        int const columns = (random.boundsWidth - random.startX - random.width) / random.spacingX + 1;
+        int const rows    = (random.boundsHeight - random.startY - random.height) / random.spacingY + 1;
+        int const perPage = columns * rows;
+
+        std::set<std::pair<int, int>> pagePositions;
+        for (int i = 0; i < (int)placements.size(); ++i)
+        {
+            sWindowPlacement const& placement = placements[i];
+            isInBounds &= placement.x >= random.startX && placement.y >= random.startY &&
+                          placement.x + placement.width <= random.boundsWidth &&
+                          placement.y + placement.height <= random.boundsHeight &&
+                          placement.width == random.width && placement.height == random.height;
+
+            if (i % perPage == 0) pagePositions.clear();
+            isPageUnique &= pagePositions.insert(std::make_pair(placement.x, placement.y)).second;
+
+            // 第二頁的第一個窗口：錯開量在範圍內時正好是 pageOffset
+            if (i == perPage)
+            {
+                int const rangeX = (std::min)(random.spacingX, random.boundsWidth - random.startX - (columns - 1) * random.spacingX - random.width + 1);
+                int const rangeY = (std::min)(random.spacingY, random.boundsHeight - random.startY - (rows - 1) * random.spacingY - random.height + 1);
+                isPageShifted &= placement.x == placements[0].x + random.pageOffset % (std::max)(1, rangeX) &&
+                                 placement.y == placements[0].y + random.pageOffset % (std::max)(1, rangeY);
+            }
+        }
+    }
+
+    // 沒有邊界、自動欄數：全部排成一列
+    sWindowLayoutDesc row;
+    row.windowCount = 50;
+    row.columns     = 0;
+    ComputeWindowLayout(row, placements);
+    bool isSingleRow = placements.size() == 50;
+    for (int i = 0; i < (int)placements.size(); ++i)
+    {
+        isSingleRow &= placements[i].y == row.startY && placements[i].x == row.startX + i * row.spacingX;
+    }
+
+    // 0 個、負數個窗口；邊界比一個窗口還小時每頁至少一個，所有窗口疊在錯開的位置上
+    sWindowLayoutDesc degenerate;
+    degenerate.windowCount = 0;
+    ComputeWindowLayout(degenerate, placements);
+    bool isDegenerateHandled = placements.empty();
+
+    degenerate.windowCount = -5;
+    ComputeWindowLayout(degenerate, placements);
+    isDegenerateHandled &= placements.empty();
+
+    degenerate.windowCount  = 5;
+    degenerate.columns      = 0;
+    degenerate.boundsWidth  = 10;
+    degenerate.boundsHeight = 10;
+    degenerate.spacingX     = 0;
+    ComputeWindowLayout(degenerate, placements);
+    isDegenerateHandled &= placements.size() == 5;
+    for (sWindowPlacement const& placement : placements)
+    {
+        isDegenerateHandled &= placement.x == degenerate.startX && placement.y == degenerate.startY;
+    }
+
+    printf("layout_iterations %u\n", iterations);
+
+    bool isPassing = true;
+    isPassing &= Check(isOriginal, "layout_default_matches_original");
+    isPassing &= Check(isInBounds, "layout_within_bounds");
+    isPassing &= Check(isPageUnique, "layout_page_positions_unique");
+    isPassing &= Check(isPageShifted, "layout_next_page_offset");
+    isPassing &= Check(isSingleRow, "layout_unbounded_single_row");
+    isPassing &= Check(isDegenerateHandled, "layout_degenerate");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+static bool CheckPhaseTimer()
+{
+    PhaseTimer timer;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    timer.Mark("first");
+    timer.AddPhase("ui_thread_0", 1000.0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    timer.Mark("second");
+
+    std::vector<sPhaseTiming> const& phases = timer.GetPhases();
+
+    bool const isOrdered = phases.size() == 3 && phases[0].name == "first" && phases[1].name == "ui_thread_0" &&
+                           phases[2].name == "second";
+
+    // Mark 的階段首尾相接，相加等於總時間；其他執行緒的時間不算在內
+    bool const isDurationValid = isOrdered && phases[0].milliseconds >= 20.0 && phases[2].milliseconds >= 5.0 &&
+                                 phases[1].milliseconds == 1000.0 &&
+                                 std::fabs(phases[0].milliseconds + phases[2].milliseconds - timer.GetTotalMilliseconds()) < 1e-3 &&
+                                 timer.GetTotalMilliseconds() < 1000.0;
+
+    // 一行一個階段，名稱加 _ms，最後一行為總時間
+    FILE* const report        = tmpfile();
+    bool        isReportValid = report != nullptr;
+    if (report)
+    {
+        timer.WriteReport(report);
+        rewind(report);
+
+        char const* const expectedNames[] = {"first_ms", "ui_thread_0_ms", "second_ms", "total_ms"};
+        char              name[64];
+        double            value;
+        int               line = 0;
+        while (fscanf(report, "%63s %lf", name, &value) == 2)
+        {
+            isReportValid &= line < 4 && strcmp(name, expectedNames[line]) == 0;
+            if (line == 1) isReportValid &= value == 1000.0;
+            ++line;
+        }
+        isReportValid &= line == 4;
+        fclose(report);
+    }
+
+    // Start 清除階段，重新從 0 開始
+    timer.Start();
+    bool const isRestarted = timer.GetPhases().empty() && timer.GetTotalMilliseconds() == 0.0;
+
+    bool isPassing = true;
+    isPassing &= Check(isOrdered, "phase_order");
+    isPassing &= Check(isDurationValid, "phase_durations");
+    isPassing &= Check(isReportValid, "phase_report_format");
+    isPassing &= Check(isRestarted, "phase_restart");
+    return isPassing;
+}
+
+//----------------------------------------------------------------------------------------------------
+int main(int const argc, char** argv)
+{
+    unsigned int const iterations = argc > 1 ? (unsigned int)strtoul(argv[1], nullptr, 0) : 2000u;
+
+    bool isPassing = true;
+    isPassing &= CheckLayout(iterations);
+    isPassing &= CheckPhaseTimer();
+
+    // 基準：100000 個窗口的排列 (與 -windows 的大量建立相比可以忽略)
+    sWindowLayoutDesc desc;
+    desc.windowCount  = 100000;
+    desc.columns      = 0;
+    desc.width        = 64;
+    desc.height       = 48;
+    desc.spacingX     = 70;
+    desc.spacingY     = 55;
+    desc.boundsWidth  = 1920;
+    desc.boundsHeight = 1080;
+
+    std::vector<sWindowPlacement> placements;
+    PhaseTimer                    timer;
+    for (int i = 0; i < 10; ++i)
+    {
+        ComputeWindowLayout(desc, placements);
+    }
+    timer.Mark("layout");
+    printf("benchmark_layout_100000_ms %.3f\n", timer.GetTotalMilliseconds() / 10);
+    return isPassing ? 0 : 1;
+}
@@ -3,8 +3,126 @@
 //----------------------------------------------------------------------------------------------------
 
 //----------------------------------------------------------------------------------------------------
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
 #include "GameCommon.hpp"
+#include "InputReplay.hpp"
+#include "PhaseTimer.hpp"
 #include "Renderer.hpp"
+#include "TextureGenerator.hpp"
+
+//----------------------------------------------------------------------------------------------------
+// 取出命令列參數後的路徑 (可用雙引號包住含空白的路徑)
+static std::string ParseCommandLinePath(char const* text)
+{
+    while (*text == ' ') ++text;
+
+    char const terminator = (*text == '"') ? '"' : ' ';
+    if (terminator == '"') ++text;
+
+    char const* const end = strchr(text, terminator);
+    return end ? std::string(text, end) : std::string(text);
+}
+
+//----------------------------------------------------------------------------------------------------
+static std::wstring ToWideString(std::string const& text)
+{
+    if (text.empty()) return std::wstring();
+
+    std::wstring wide(text.size(), L'\0');
+    int const    converted = MultiByteToWideChar(CP_ACP, 0, text.data(), (int)text.size(), &wide[0], (int)wide.size());
+    wide.resize(converted > 0 ? converted : 0);
+    return wide;
+}
+
+//----------------------------------------------------------------------------------------------------
+// 獨立場景的示範：所有場景共用同一張測試圖 (只上傳一次)，解析度依序為主場景的 1/2、1/3...，每個場景兩個窗口排在螢幕下方
+static void CreateExtraScenes(HINSTANCE const hInstance, unsigned int const sceneCount)
+{
+    unsigned int const    contentSize = 512;
+    std::vector<uint32_t> content((size_t)contentSize * contentSize);
+    GenerateTestPattern(content.data(), contentSize, contentSize);
+
+    unsigned int const contentTexture = g_renderer->CreateSceneContent(content.data(), contentSize, contentSize);
+    int const          screenHeight   = GetSystemMetrics(SM_CYSCREEN);
+
+    for (unsigned int i = 0; i < sceneCount; ++i)
+    {
+        sSceneDesc desc;
+        desc.width          = 1920 / (i + 2);
+        desc.height         = 1080 / (i + 2);
+        desc.contentTexture = contentTexture;
+
+        unsigned int const sceneId = g_renderer->CreateScene(desc);
+        for (int k = 0; k < 2; ++k)
+        {
+            HWND const hwnd = CreateGameWindow(hInstance, L"Scene", 40 + (int)(i * 2 + k) * 340, screenHeight - 320, 320, 240);
+            if (hwnd) g_renderer->AddSceneWindow(sceneId, hwnd);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------
+// 精靈的示範負載：兩張紋理 (測試圖與半透明圓點) 交錯在三個圖層，每幀提交一次，讓 instanced 繪製 (或軟體渲染的
+// 帶狀光柵化) 每幀都有工作
+struct sSpriteDemo
+{
+    unsigned int count       = 0;
+    unsigned int textures[2] = {INVALID_SCENE_TEXTURE_ID, INVALID_SCENE_TEXTURE_ID};
+    unsigned int frame       = 0;
+};
+
+static void CreateSpriteDemo(sSpriteDemo& demo, unsigned int const count)
+{
+    unsigned int const    size = 64;
+    std::vector<uint32_t> pixels((size_t)size * size);
+
+    GenerateTestPattern(pixels.data(), size, size);
+    demo.textures[0] = g_renderer->CreateSceneContent(pixels.data(), size, size);
+
+    // 中心不透明、往外線性淡出的白色圓點
+    for (unsigned int y = 0; y < size; ++y)
+    {
+        for (unsigned int x = 0; x < size; ++x)
+        {
+            float const dx    = ((float)x + 0.5f) / size - 0.5f;
+            float const dy    = ((float)y + 0.5f) / size - 0.5f;
+            float const alpha = (std::max)(0.f, 1.f - sqrtf(dx * dx + dy * dy) * 2.f);
+            pixels[(size_t)y * size + x] = ((uint32_t)(alpha * 255.f + 0.5f) << 24) | 0x00FFFFFF;
+        }
+    }
+    demo.textures[1] = g_renderer->CreateSceneContent(pixels.data(), size, size);
+    demo.count       = count;
+}
+
+// 精靈排成幾圈繞場景中心旋轉，座標以全解析度的場景為準
+static void SubmitSpriteDemo(sSpriteDemo& demo)
+{
+    if (demo.textures[0] == INVALID_SCENE_TEXTURE_ID || demo.textures[1] == INVALID_SCENE_TEXTURE_ID) return;
+
+    float const time = (float)demo.frame++ / 60.f;
+    for (unsigned int i = 0; i < demo.count; ++i)
+    {
+        float const ring  = (float)(i % 8);
+        float const angle = (float)i * 2.39996f + time * (0.2f + ring * 0.05f);
+
+        sSprite sprite;
+        sprite.x         = 960.f + cosf(angle) * (120.f + ring * 50.f);
+        sprite.y         = 540.f + sinf(angle) * (80.f + ring * 50.f);
+        sprite.width     = 24.f + (float)(i % 5) * 8.f;
+        sprite.height    = sprite.width;
+        sprite.rotation  = angle;
+        sprite.tint      = (i & 1) ? 0xC0FFC080 : 0xFFFFFFFF;
+        sprite.textureId = demo.textures[i & 1];
+        sprite.layer     = (int)(i % 3);
+        g_renderer->DrawSprite(sprite);
+    }
+}
 
 //----------------------------------------------------------------------------------------------------
 int WINAPI WinMain(HINSTANCE const hInstance,
@@ -12,6 +130,39 @@ int WINAPI WinMain(HINSTANCE const hInstance,
                    LPSTR           lpCmdLine,
                    int const       nShowCmd)
 {
+    // 建置後步驟：預先編譯所有 shader，啟動時不需要再呼叫 D3DCompile
+    if (lpCmdLine && strstr(lpCmdLine, "-buildShaderPack") != nullptr)
+    {
+        return Renderer::BuildShaderPack() ? 0 : 1;
+    }
+
+    // -replay <輸入記錄>：無頭回放，不建立任何窗口；結果寫到 <輸入記錄>.txt
+    char const* const replayArgument = lpCmdLine ? strstr(lpCmdLine, "-replay ") : nullptr;
+    if (replayArgument)
+    {
+        std::string const path = ParseCommandLinePath(replayArgument + strlen("-replay "));
+
+        sReplayResult result;
+        if (path.empty() || !ReplayInputLog(path.c_str(), result)) return 2;
+
+        FILE* report = nullptr;
+        if (fopen_s(&report, (path + ".txt").c_str(), "w") == 0)
+        {
+            WriteReplayReport(report, result, true);
+            fclose(report);
+        }
+        return result.mismatchCount == 0 && !result.isLogCorrupt ? 0 : 1;
+    }
+
+    // -startupBenchmark <窗口數>：量測啟動各階段 (含第一幀) 後寫入 StartupBenchmark.txt 並結束
+    // -uiThreads <數量>：窗口分散在多個 UI 執行緒建立，各自執行訊息循環
+    char const* const benchmarkArgument = lpCmdLine ? strstr(lpCmdLine, "-startupBenchmark ") : nullptr;
+    char const* const uiThreadsArgument = lpCmdLine ? strstr(lpCmdLine, "-uiThreads ") : nullptr;
+    int const          windowCount   = benchmarkArgument ? atoi(benchmarkArgument + strlen("-startupBenchmark ")) : 10;
+    unsigned int const uiThreadCount = uiThreadsArgument ? (unsigned int)strtoul(uiThreadsArgument + strlen("-uiThreads "), nullptr, 0) : 1;
+
+    PhaseTimer startupTimer;
+
     HWND const hiddenWindow = CreateWindowEx(
         NULL,
         L"STATIC",
@@ -24,14 +175,154 @@ int WINAPI WinMain(HINSTANCE const hInstance,
         nullptr
     );
 
+    // -software：不使用 GPU，場景完全由 CPU 渲染
+    bool const useSoftwareRenderer = lpCmdLine && strstr(lpCmdLine, "-software") != nullptr;
+
     g_renderer = new Renderer();
-    if (FAILED(g_renderer->Initialize(hiddenWindow)))
+    if (FAILED(g_renderer->Initialize(hiddenWindow, useSoftwareRenderer)))
     {
         MessageBox(nullptr, L"Failed to initialize renderer", L"Error", MB_OK);
         return -1;
     }
+    startupTimer.Mark("renderer_init");
+
+    // -compactMemory：不保留場景的 CPU 鏡像 (只有 D3D11 有效，且不能與 -record 同時使用)
+    if (lpCmdLine && strstr(lpCmdLine, "-compactMemory") != nullptr && !g_renderer->EnableCompactMemory())
+    {
+        MessageBox(nullptr, L"Compact memory mode is not available", L"Error", MB_OK);
+    }
+
+    // -fullReadback：每幀讀回整個場景 (關閉區塊校驗碼的局部回讀，比較用)
+    if (lpCmdLine && strstr(lpCmdLine, "-fullReadback") != nullptr)
+    {
+        g_renderer->SetTileReadbackEnabled(false);
+    }
 
-    CreateAndRegisterMultipleWindows(hInstance, 10);
+    // -dynamicResolution [毫秒]：場景的繪製與回讀超出預算時降低場景解析度 (預設關閉，預算預設 8 毫秒)
+    char const* const dynamicResolutionArgument = lpCmdLine ? strstr(lpCmdLine, "-dynamicResolution") : nullptr;
+    if (dynamicResolutionArgument)
+    {
+        g_renderer->SetDynamicResolutionEnabled(true, (float)atof(dynamicResolutionArgument + strlen("-dynamicResolution")));
+    }
+
+    // -seed <數值>：決定性模式，固定種子與每幀 1/60 秒；-recordInput <檔案> 另外記錄輸入供 -replay 使用
+    char const* const seedArgument        = lpCmdLine ? strstr(lpCmdLine, "-seed ") : nullptr;
+    char const* const recordInputArgument = lpCmdLine ? strstr(lpCmdLine, "-recordInput ") : nullptr;
+    if (seedArgument || recordInputArgument)
+    {
+        uint32_t const    seed      = seedArgument ? (uint32_t)strtoul(seedArgument + strlen("-seed "), nullptr, 0) : 1;
+        std::string const inputPath = recordInputArgument ? ParseCommandLinePath(recordInputArgument + strlen("-recordInput ")) : std::string();
+
+        if (!g_renderer->EnableDeterministicMode(seed, 1.f / 60.f, inputPath.empty() ? nullptr : inputPath.c_str()))
+        {
+            MessageBox(nullptr, L"Failed to open input log", L"Error", MB_OK);
+        }
+    }
+
+    // -exportFrames：每幀場景發布到共享記憶體；-exportDirty 只發布要更新到窗口的區域
+    bool const exportDirtyRegions = lpCmdLine && strstr(lpCmdLine, "-exportDirty") != nullptr;
+    if (exportDirtyRegions || (lpCmdLine && strstr(lpCmdLine, "-exportFrames") != nullptr))
+    {
+        if (!g_renderer->EnableFrameExport("MultipleWindowsFramework.Frames", 3, exportDirtyRegions))
+        {
+            MessageBox(nullptr, L"Failed to create frame export", L"Error", MB_OK);
+        }
+    }
+
+    // -record <檔案>：錄下每一幀，副檔名為 .y4m 時輸出 YUV4MPEG2，否則為附帶窗口區域的壓縮格式
+    char const* const recordArgument = lpCmdLine ? strstr(lpCmdLine, "-record ") : nullptr;
+    if (recordArgument)
+    {
+        sFrameRecorderDesc desc;
+        desc.path = ParseCommandLinePath(recordArgument + strlen("-record "));
+
+        size_t const extension = desc.path.rfind(".y4m");
+        if (extension != std::string::npos && extension + 4 == desc.path.size())
+        {
+            desc.format = eRecordFormat::Y4M;
+        }
+
+        if (desc.path.empty() || !g_renderer->StartRecording(desc))
+        {
+            MessageBox(nullptr, L"Failed to start recording", L"Error", MB_OK);
+        }
+    }
+
+    // -background <圖片>：超大背景圖，只串流窗口看得到的區塊
+    char const* const backgroundArgument = lpCmdLine ? strstr(lpCmdLine, "-background ") : nullptr;
+    if (backgroundArgument)
+    {
+        std::wstring const path = ToWideString(ParseCommandLinePath(backgroundArgument + strlen("-background ")));
+        if (path.empty() || FAILED(g_renderer->SetBackgroundImage(path.c_str())))
+        {
+            MessageBox(nullptr, L"Failed to open background image", L"Error", MB_OK);
+        }
+    }
+
+    // -hitchThreshold <毫秒>：訊息處理加上一幀的 Render 超過時，飛行記錄器把前後幾秒寫到 Hitch_<幀>.txt (預設 50，0 為關閉)
+    char const* const hitchArgument = lpCmdLine ? strstr(lpCmdLine, "-hitchThreshold ") : nullptr;
+    if (hitchArgument)
+    {
+        sFlightRecorderDesc desc;
+        desc.thresholdMilliseconds = (float)atof(hitchArgument + strlen("-hitchThreshold "));
+        g_renderer->ConfigureFlightRecorder(desc);
+    }
+
+    // -metricsPort <port>：指標以 Prometheus 文字格式開放在 http://127.0.0.1:<port>/metrics
+    char const* const metricsArgument = lpCmdLine ? strstr(lpCmdLine, "-metricsPort ") : nullptr;
+    if (metricsArgument)
+    {
+        uint16_t const port = (uint16_t)strtoul(metricsArgument + strlen("-metricsPort "), nullptr, 0);
+        if (!g_renderer->StartMetricsEndpoint(port))
+        {
+            MessageBox(nullptr, L"Failed to start metrics endpoint", L"Error", MB_OK);
+        }
+    }
+
+    startupTimer.Mark("options");
+    CreateAndRegisterMultipleWindows(hInstance, windowCount, uiThreadCount, &startupTimer);
+
+    // -scenes <數量>：另外建立獨立的場景，與主場景共用裝置與回讀，窗口在執行緒池上呈現
+    char const* const scenesArgument = lpCmdLine ? strstr(lpCmdLine, "-scenes ") : nullptr;
+    if (scenesArgument)
+    {
+        CreateExtraScenes(hInstance, (unsigned int)strtoul(scenesArgument + strlen("-scenes "), nullptr, 0));
+    }
+
+    // -sprites <數量>：每幀提交精靈 (見 SubmitSpriteDemo)，沒有這個參數時精靈圖層一直是隱藏的
+    sSpriteDemo       spriteDemo;
+    char const* const spritesArgument = lpCmdLine ? strstr(lpCmdLine, "-sprites ") : nullptr;
+    if (spritesArgument)
+    {
+        CreateSpriteDemo(spriteDemo, (unsigned int)strtoul(spritesArgument + strlen("-sprites "), nullptr, 0));
+    }
+
+    if (benchmarkArgument)
+    {
+        g_renderer->Render();
+        startupTimer.Mark("first_frame");
+
+        sMemoryReport memoryReport;
+        g_renderer->GetMemoryReport(memoryReport);
+        bool const isWithinBudget = memoryReport.GetBytesPerWindow() <= WINDOW_MEMORY_BUDGET_BYTES;
+
+        FILE* report = nullptr;
+        if (fopen_s(&report, "StartupBenchmark.txt", "w") == 0)
+        {
+            fprintf(report, "windows %d\n", windowCount);
+            fprintf(report, "ui_threads %u\n", uiThreadCount);
+            fprintf(report, "compact_memory %d\n", g_renderer->IsCompactMemory() ? 1 : 0);
+            startupTimer.WriteReport(report);
+            memoryReport.WriteReport(report);
+            fprintf(report, "check_window_memory %s\n", isWithinBudget ? "ok" : "FAILED");
+            fclose(report);
+        }
+
+        delete g_renderer;
+        DestroyWindow(hiddenWindow);
+        CoUninitialize();
+        return isWithinBudget ? 0 : 1;
+    }
 
     // 主訊息循環
     MSG  msg     = {};
@@ -39,6 +330,12 @@ int WINAPI WinMain(HINSTANCE const hInstance,
 
     while (running)
     {
+        // 訊息處理的時間由下一次 Render 記入飛行記錄器
+        if (g_renderer)
+        {
+            g_renderer->BeginMessagePump();
+        }
+
         while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
         {
             if (msg.message == WM_QUIT)
@@ -54,6 +351,7 @@ int WINAPI WinMain(HINSTANCE const hInstance,
         {
             if (g_renderer)
             {
+                SubmitSpriteDemo(spriteDemo);
                 g_renderer->Render();
             }
             Sleep(16); // ~60 FPS